@@ -275,6 +275,10 @@ static void panic_goto_cli(void)
 
 static void show_register(excep_regs_t *regs, uint32_t victim, int32_t type)
 {
+#ifdef CONFIG_RT_USING_DEFERRED_LOG
+    void rt_klog_panic(void);
+    rt_klog_panic();
+#endif
 #ifdef CONFIG_RTTKERNEL
     rt_kprintf("thread: %s, entry: 0x%p, stack_base: 0x%p,stack_size: 0x%08x.\n", \
                rt_thread_self()->name, \
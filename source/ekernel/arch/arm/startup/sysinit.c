@@ -134,6 +134,11 @@ noinline static void app_init(void)
 __s32 ksrv_init(void);
 static void awos_init_thread(void *para)
 {
+#ifdef CONFIG_RT_USING_DEFERRED_LOG
+    int rt_klog_init(void);
+    rt_klog_init();
+#endif
+
 #ifdef CONFIG_PTHREAD
     int pthread_system_init(void);
     pthread_system_init();
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     melis        first version
+ */
+#ifndef KLOG_H__
+#define KLOG_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deferred console log, see klog.c. The layout below is also read by
+ * utility/host-tool/klog_decode from RAM dumps, keep it 32-bit and in
+ * step with the tool.
+ */
+#define RT_KLOG_MAGIC           0x474f4c4b      /* "KLOG" */
+
+#ifndef RT_KLOG_BUF_SIZE
+#ifdef CONFIG_RT_DEFERRED_LOG_BUF_SIZE
+#define RT_KLOG_BUF_SIZE        CONFIG_RT_DEFERRED_LOG_BUF_SIZE
+#else
+#define RT_KLOG_BUF_SIZE        16384
+#endif
+#endif
+
+/* longest %s argument kept, the rest is cut */
+#define RT_KLOG_STR_MAX         128
+
+/* rt_klog_vprintf() flags */
+#define RT_KLOG_LEVEL           0x01            /* text starts with a printk "<n>" level */
+
+/* rt_klog_entry flags */
+#define RT_KLOG_ENTRY_PAD       0x80            /* filler up to the end of the ring */
+#define RT_KLOG_ENTRY_FMT       0x40            /* format copied in before the arguments */
+
+/* pos word of a complete entry: never 0, the value of a drained entry */
+#define RT_KLOG_POS_DONE(pos)   (~(rt_uint32_t)(pos))
+
+struct rt_klog_entry
+{
+    rt_uint32_t pos;            /* RT_KLOG_POS_DONE(ring position), stored last */
+    rt_uint16_t size;           /* bytes with this header, multiple of 4 */
+    rt_uint8_t  flags;
+    rt_uint8_t  reserved;
+    rt_uint32_t tick;
+    rt_uint32_t fmt;            /* address of the format string, 0 with RT_KLOG_ENTRY_FMT */
+    /* with RT_KLOG_ENTRY_FMT the format with its NUL, word aligned, then
+     * the argument words in format order, %s copied inline with its NUL */
+};
+
+struct rt_klog_ring
+{
+    rt_uint32_t magic;
+    rt_uint32_t size;           /* bytes in data[], power of two */
+    rt_uint32_t head;           /* claimed up to, free running */
+    rt_uint32_t tail;           /* written out up to, free running */
+    rt_uint32_t dropped;        /* messages lost to a full ring */
+    rt_uint32_t reserved[3];
+    rt_uint8_t  data[RT_KLOG_BUF_SIZE];
+};
+
+int rt_klog_init(void);
+int rt_klog_vprintf(int flags, const char *fmt, va_list args);
+void rt_klog_panic(void);
+rt_size_t rt_klog_format(const char *fmt, const struct rt_klog_entry *entry,
+                         char *buf, rt_size_t size);
+
+/* console write of rt_kprintf(), in kservice.c */
+void rt_klog_output(const char *str, rt_size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,7 +26,21 @@ struct rt_module_symtab
 #elif defined(__MINGW32__)
 #define RTM_EXPORT(symbol)
 
+#elif defined(__GNUC__) && !defined(__CC_ARM)
+/*
+ * one section per symbol, "RTMSymTab.<symbol>": the kernel link script sorts
+ * them by name so dlmodule_symbol_find() can binary search the table.
+ */
+#define RTM_EXPORT(symbol)                                            \
+    const char __rtmsym_##symbol##_name[] SECTION(".rodata.name") = #symbol;     \
+    const struct rt_module_symtab __rtmsym_##symbol SECTION("RTMSymTab." #symbol)= \
+            {                                                                     \
+                                                                                  (void *)&symbol,                                                  \
+                                                                                  __rtmsym_##symbol##_name                                          \
+            };
+
 #else
+/* armcc and IAR find the table by the "RTMSymTab" section name, see dlsymtab.c */
 #define RTM_EXPORT(symbol)                                            \
     const char __rtmsym_##symbol##_name[] SECTION(".rodata.name") = #symbol;     \
     const struct rt_module_symtab __rtmsym_##symbol SECTION("RTMSymTab")= \
@@ -5,6 +5,8 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2026-10-19     melis        worker pools, one delayed-work timer per queue,
+ *                             work execution time
  */
 #ifndef WORKQUEUE_H__
 #define WORKQUEUE_H__
@@ -25,14 +27,67 @@ enum
     RT_WORK_TYPE_DELAYED     = 0x0001,
 };
 
-/* workqueue implementation */
-struct rt_workqueue
+#ifdef CONFIG_RT_SYSTEM_WORKQUEUE_THREADS
+#define RT_SYSTEM_WORKQUEUE_THREADS     CONFIG_RT_SYSTEM_WORKQUEUE_THREADS
+#else
+#define RT_SYSTEM_WORKQUEUE_THREADS     1
+#endif
+
+#ifdef CONFIG_RT_WORKQUEUE_SLOW_WORK_MS
+#define RT_WORKQUEUE_SLOW_WORK_MS       CONFIG_RT_WORKQUEUE_SLOW_WORK_MS
+#else
+#define RT_WORKQUEUE_SLOW_WORK_MS       0
+#endif
+
+#define RT_WORKQUEUE_WORKERS_MAX        8
+#define RT_WORKQUEUE_STAT_FUNCS         8
+
+struct rt_work;
+
+/* execution time of the works with one work_func, in ktime_get() ns */
+struct rt_work_stat
+{
+    void (*work_func)(struct rt_work *work, void *work_data);
+    rt_uint32_t run_count;
+    rt_uint32_t max_ns;
+    rt_uint64_t total_ns;
+};
+
+/* one thread of a workqueue, with its own list of works */
+struct rt_workqueue_worker
 {
     rt_list_t      work_list;
     struct rt_work *work_current; /* current work */
 
-    struct rt_semaphore sem;
+    struct rt_semaphore wakeup;
+    rt_uint8_t     idle;          /* waiting on wakeup */
     rt_thread_t    work_thread;
+    struct rt_workqueue *queue;
+
+    rt_uint32_t    run_count;
+    rt_uint32_t    steal_count;   /* works taken from the other workers */
+    rt_uint64_t    busy_ns;
+};
+
+/* workqueue implementation */
+struct rt_workqueue
+{
+    struct rt_semaphore sem;      /* work completion */
+    rt_uint16_t    sync_waiters;  /* threads in cancel_work_sync on sem */
+
+    /* delayed works by timeout tick, one timer for the earliest */
+    rt_list_t      delayed_list;
+    struct rt_timer timer;
+    rt_tick_t      timer_tick;
+    rt_uint8_t     timer_armed;
+
+    rt_uint8_t     worker_count;
+    rt_uint8_t     worker_next;
+    struct rt_workqueue_worker *worker;
+
+    rt_list_t      list;          /* all workqueues, for list_workqueue */
+    char           name[RT_NAME_MAX];
+    struct rt_work_stat stat[RT_WORKQUEUE_STAT_FUNCS]; /* last one: all others */
 };
 
 struct rt_work
@@ -43,7 +98,7 @@ struct rt_work
     void *work_data;
     rt_uint16_t flags;
     rt_uint16_t type;
-    struct rt_timer timer;
+    rt_tick_t timeout_tick;
     struct rt_workqueue *workqueue;
 };
 
@@ -57,6 +112,15 @@ struct rt_delayed_work
  * WorkQueue for DeviceDriver
  */
 struct rt_workqueue *rt_workqueue_create(const char *name, rt_uint16_t stack_size, rt_uint8_t priority);
+/**
+ * A workqueue run by "threads" threads of the same priority. A worker that
+ * runs out of work takes it from the others, so one slow work holds up only
+ * the works queued behind it on its own thread, which may in turn be taken
+ * over. Different works may run at the same time and out of submission
+ * order; one work never runs twice at once.
+ */
+struct rt_workqueue *rt_workqueue_create_pool(const char *name, rt_uint16_t stack_size,
+        rt_uint8_t priority, rt_uint8_t threads);
 rt_err_t rt_workqueue_destroy(struct rt_workqueue *queue);
 rt_err_t rt_workqueue_dowork(struct rt_workqueue *queue, struct rt_work *work);
 rt_err_t rt_workqueue_submit_work(struct rt_workqueue *queue, struct rt_work *work, rt_tick_t time);
@@ -77,6 +141,7 @@ rt_inline void rt_work_init(struct rt_work *work, void (*work_func)(struct rt_wo
     work->workqueue = RT_NULL;
     work->flags = 0;
     work->type = 0;
+    work->timeout_tick = 0;
 }
 
 void rt_delayed_work_init(struct rt_delayed_work *work, void (*work_func)(struct rt_work *work,
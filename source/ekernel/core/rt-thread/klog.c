@@ -0,0 +1,743 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     melis        first version
+ */
+
+/*
+ * Deferred console log.
+ *
+ * printk(), and rt_kprintf() with CONFIG_RT_DEFERRED_LOG_KPRINTF, no longer
+ * format on the caller's stack and wait for the uart: the caller stores the
+ * address of the format string and the raw arguments in a ring, the "klog"
+ * thread formats and writes them out at low priority. %s arguments are
+ * copied, the string may be gone by then, and so is a format that is not
+ * in the kernel image, e.g. one of a module.
+ *
+ * Space is claimed with a compare-and-swap on head, so threads and interrupt
+ * handlers log without a lock and with interrupts on. An entry is complete
+ * once its pos word holds RT_KLOG_POS_DONE() of its own ring position; the
+ * thread stops at the first one that is not and zeroes what it has written
+ * out, so no word of an earlier lap passes for a complete entry. A full
+ * ring drops and counts the message.
+ * Before the thread runs and after rt_klog_panic() everything goes out
+ * synchronously as before.
+ *
+ * The ring has a magic and a fixed 32-bit layout (klog.h), so
+ * utility/host-tool/klog_decode formats it from a RAM dump or from a
+ * "klog dump" file, given the kernel ELF for the format strings.
+ */
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <string.h>
+
+#include <klog.h>
+
+#ifdef RT_USING_FINSH
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#ifndef CONFIG_RT_DEFERRED_LOG_THREAD_PRIORITY
+#define CONFIG_RT_DEFERRED_LOG_THREAD_PRIORITY  (RT_THREAD_PRIORITY_MAX - 2)
+#endif
+#ifndef CONFIG_RT_DEFERRED_LOG_PERIOD
+#define CONFIG_RT_DEFERRED_LOG_PERIOD           20
+#endif
+
+/* rt_vsnprintf() in kservice.c parses precisions */
+#define RT_PRINTF_PRECISION
+
+#define KLOG_STACK_SIZE     0x1000
+#define KLOG_ENTRY_HDR      sizeof(struct rt_klog_entry)
+#define KLOG_SPEC_MAX       32
+
+/* formats in the read-only part of the kernel image stay there, see kernel.lds */
+#ifndef KLOG_IN_IMAGE
+extern const char __readonly_area_start[];
+extern const char __readonly_area_end[];
+#define KLOG_IN_IMAGE(p)    ((const char *)(p) >= __readonly_area_start && \
+                             (const char *)(p) < __readonly_area_end)
+#endif
+
+#if (RT_KLOG_BUF_SIZE & (RT_KLOG_BUF_SIZE - 1)) != 0
+#error "CONFIG_RT_DEFERRED_LOG_BUF_SIZE must be a power of two"
+#endif
+
+struct rt_klog_ring rt_klog_ring =
+{
+    RT_KLOG_MAGIC,
+    RT_KLOG_BUF_SIZE,
+};
+
+static rt_thread_t _klog_thread = RT_NULL;
+static volatile int _klog_sync = 1;
+static rt_uint32_t _klog_draining = 0;
+static rt_uint32_t _klog_dropped_seen = 0;
+static char _klog_line[RT_CONSOLEBUF_SIZE];
+
+/* one conversion, parsed the way rt_vsnprintf() parses it */
+struct klog_spec
+{
+    const char *start;          /* the '%' */
+    const char *end;            /* past the conversion character */
+    rt_uint8_t  stars;          /* '*' width and precision arguments */
+    char        qualifier;      /* 0, 'h', 'l' or 'L' */
+    char        conv;
+};
+
+static const char *klog_next_spec(const char *fmt, struct klog_spec *spec)
+{
+    for (; *fmt; fmt ++)
+    {
+        if (*fmt != '%')
+        {
+            continue;
+        }
+
+        spec->start = fmt ++;
+        spec->stars = 0;
+        while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0')
+        {
+            fmt ++;
+        }
+
+        if (*fmt == '*')
+        {
+            spec->stars ++;
+            fmt ++;
+        }
+        while (*fmt >= '0' && *fmt <= '9')
+        {
+            fmt ++;
+        }
+
+#ifdef RT_PRINTF_PRECISION
+        if (*fmt == '.')
+        {
+            fmt ++;
+            if (*fmt == '*')
+            {
+                spec->stars ++;
+                fmt ++;
+            }
+            while (*fmt >= '0' && *fmt <= '9')
+            {
+                fmt ++;
+            }
+        }
+#endif
+
+        spec->qualifier = 0;
+#ifdef RT_PRINTF_LONGLONG
+        if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L')
+#else
+        if (*fmt == 'h' || *fmt == 'l')
+#endif
+        {
+            spec->qualifier = *fmt ++;
+#ifdef RT_PRINTF_LONGLONG
+            if (spec->qualifier == 'l' && *fmt == 'l')
+            {
+                spec->qualifier = 'L';
+                fmt ++;
+            }
+#endif
+        }
+
+        spec->conv = *fmt;
+        if (*fmt)
+        {
+            fmt ++;
+        }
+        spec->end = fmt;
+        return spec->start;
+    }
+
+    return RT_NULL;
+}
+
+/*
+ * Store the arguments of fmt as words at out, at most max of them, or only
+ * count them when out is RT_NULL. Returns the number of words. A %s that
+ * grew since it was counted is cut at max, the arguments after it are lost.
+ */
+static rt_uint32_t klog_capture(const char *fmt, va_list args, rt_uint32_t *out,
+                                rt_uint32_t max)
+{
+    struct klog_spec spec;
+    const char *s;
+    rt_uint32_t words = 0;
+    rt_uint32_t len, i, v;
+
+    while (klog_next_spec(fmt, &spec) != RT_NULL)
+    {
+        fmt = spec.end;
+
+        for (i = 0; i < spec.stars; i ++)
+        {
+            v = (rt_uint32_t)va_arg(args, int);
+            if (out && words < max)
+            {
+                out[words] = v;
+            }
+            words ++;
+        }
+
+        switch (spec.conv)
+        {
+        case 'c':
+            v = (rt_uint32_t)va_arg(args, int);
+            if (out && words < max)
+            {
+                out[words] = v;
+            }
+            words ++;
+            break;
+
+        case 'p':
+            v = (rt_uint32_t)(rt_ubase_t)va_arg(args, void *);
+            if (out && words < max)
+            {
+                out[words] = v;
+            }
+            words ++;
+            break;
+
+        case 's':
+            s = va_arg(args, const char *);
+            if (!s)
+            {
+                s = "(NULL)";
+            }
+            for (len = 0; len < RT_KLOG_STR_MAX && s[len]; len ++)
+            {
+            }
+            if (out)
+            {
+                if (words >= max)
+                {
+                    break;
+                }
+                if (len > (max - words) * 4 - 1)
+                {
+                    len = (max - words) * 4 - 1;
+                }
+                /* NUL and zero padding up to the word */
+                out[words + len / 4] = 0;
+                rt_memcpy(&out[words], s, len);
+            }
+            words += len / 4 + 1;
+            break;
+
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'd':
+        case 'i':
+        case 'u':
+#ifdef RT_PRINTF_LONGLONG
+            if (spec.qualifier == 'L')
+            {
+                rt_uint64_t v64 = va_arg(args, long long);
+
+                if (out && words + 2 <= max)
+                {
+                    out[words] = (rt_uint32_t)v64;
+                    out[words + 1] = (rt_uint32_t)(v64 >> 32);
+                }
+                words += 2;
+                break;
+            }
+#endif
+            v = va_arg(args, rt_uint32_t);
+            if (out && words < max)
+            {
+                out[words] = v;
+            }
+            words ++;
+            break;
+
+        default:
+            /* "%%" and what rt_vsnprintf() prints as is */
+            break;
+        }
+    }
+
+    return words;
+}
+
+/* compare-and-swap, ldrex/strex where the core has them */
+static int klog_cas(rt_uint32_t *ptr, rt_uint32_t old, rt_uint32_t val)
+{
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+    return __atomic_compare_exchange_n(ptr, &old, val, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+#else
+    /* armv5: a few instructions with interrupts masked instead */
+    register rt_base_t level;
+    int ok;
+
+    level = rt_hw_interrupt_disable();
+    ok = *ptr == old;
+    if (ok)
+    {
+        *ptr = val;
+    }
+    rt_hw_interrupt_enable(level);
+    return ok;
+#endif
+}
+
+static void klog_dropped(struct rt_klog_ring *ring)
+{
+    rt_uint32_t dropped;
+
+    do
+    {
+        dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    } while (!klog_cas(&ring->dropped, dropped, dropped + 1));
+}
+
+/* claim size bytes, padding to the start of the ring when they do not fit */
+static struct rt_klog_entry *klog_claim(struct rt_klog_ring *ring, rt_uint32_t size,
+                                        rt_uint32_t *pos)
+{
+    struct rt_klog_entry *pad;
+    rt_uint32_t head, tail, off, skip;
+
+    do
+    {
+        head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        off = head & (ring->size - 1);
+        skip = off + size > ring->size ? ring->size - off : 0;
+        if (head + skip + size - tail > ring->size)
+        {
+            klog_dropped(ring);
+            return RT_NULL;
+        }
+    } while (!klog_cas(&ring->head, head, head + skip + size));
+
+    /* a tail shorter than a header is skipped by position alone */
+    if (skip >= KLOG_ENTRY_HDR)
+    {
+        pad = (struct rt_klog_entry *)&ring->data[off];
+        pad->size = skip;
+        pad->flags = RT_KLOG_ENTRY_PAD;
+        __atomic_store_n(&pad->pos, RT_KLOG_POS_DONE(head), __ATOMIC_RELEASE);
+    }
+
+    *pos = head + skip;
+    return (struct rt_klog_entry *)&ring->data[*pos & (ring->size - 1)];
+}
+
+/**
+ * Queue a message for the klog thread.
+ *
+ * @param flags RT_KLOG_LEVEL when the text starts with a printk "<n>" level
+ * @param fmt the format, kept by address when it is in the kernel image and
+ *        copied into the entry otherwise, e.g. from a module that may be
+ *        unloaded before the message is written out
+ * @param args the arguments, left untouched
+ *
+ * @return 0 when queued or dropped, -1 when the caller has to print it now
+ */
+int rt_klog_vprintf(int flags, const char *fmt, va_list args)
+{
+    struct rt_klog_ring *ring = &rt_klog_ring;
+    struct rt_klog_entry *entry;
+    rt_uint32_t size, pos, words, fmt_words = 0, fmt_len = 0;
+    rt_uint32_t *out;
+    const char *parse = fmt;
+    va_list ap;
+
+    if (_klog_sync || rt_thread_self() == _klog_thread)
+    {
+        return -1;
+    }
+
+    if (!KLOG_IN_IMAGE(fmt))
+    {
+        fmt_len = rt_strlen(fmt);
+        fmt_words = fmt_len / 4 + 1;
+        flags |= RT_KLOG_ENTRY_FMT;
+    }
+
+    va_copy(ap, args);
+    words = klog_capture(fmt, ap, RT_NULL, 0);
+    va_end(ap);
+    size = KLOG_ENTRY_HDR + (fmt_words + words) * 4;
+    if (size > ring->size / 4)
+    {
+        klog_dropped(ring);
+        return 0;
+    }
+
+    entry = klog_claim(ring, size, &pos);
+    if (entry == RT_NULL)
+    {
+        return 0;
+    }
+
+    entry->size = size;
+    entry->flags = flags;
+    entry->tick = rt_tick_get();
+    out = (rt_uint32_t *)(entry + 1);
+    if (flags & RT_KLOG_ENTRY_FMT)
+    {
+        entry->fmt = 0;
+        out[fmt_words - 1] = 0;
+        rt_memcpy(out, fmt, fmt_len);
+        parse = (const char *)out;
+        out += fmt_words;
+    }
+    else
+    {
+        entry->fmt = (rt_uint32_t)(rt_ubase_t)fmt;
+    }
+    /* only the words claimed above, whatever changed since they were counted */
+    va_copy(ap, args);
+    klog_capture(parse, ap, out, words);
+    va_end(ap);
+    __atomic_store_n(&entry->pos, RT_KLOG_POS_DONE(pos), __ATOMIC_RELEASE);
+
+    return 0;
+}
+RTM_EXPORT(rt_klog_vprintf);
+
+/* argument words a conversion takes, %s at least one */
+static rt_uint32_t klog_spec_words(const struct klog_spec *spec)
+{
+    switch (spec->conv)
+    {
+    case 'o':
+    case 'x':
+    case 'X':
+    case 'd':
+    case 'i':
+    case 'u':
+        return spec->stars + (spec->qualifier == 'L' ? 2 : 1);
+    case 'c':
+    case 'p':
+    case 's':
+        return spec->stars + 1;
+    default:
+        return spec->stars;
+    }
+}
+
+static rt_size_t klog_append(char *buf, rt_size_t size, rt_size_t n, rt_int32_t len)
+{
+    if (len < 0)
+    {
+        return n;
+    }
+    return n + len < size ? n + len : size - 1;
+}
+
+/**
+ * Format a queued entry, as rt_vsnprintf() would have formatted the call.
+ *
+ * @param fmt the format string the entry was logged with, unused when the
+ *        entry carries its own (RT_KLOG_ENTRY_FMT)
+ * @param entry the entry
+ * @param buf the output, NUL terminated
+ * @param size the size of buf
+ *
+ * @return the length of the text in buf
+ */
+rt_size_t rt_klog_format(const char *fmt, const struct rt_klog_entry *entry,
+                         char *buf, rt_size_t size)
+{
+    const rt_uint32_t *arg = (const rt_uint32_t *)(entry + 1);
+    const rt_uint32_t *end = (const rt_uint32_t *)((const rt_uint8_t *)entry + entry->size);
+    struct klog_spec spec;
+    char spec_buf[KLOG_SPEC_MAX];
+    const char *p;
+    const char *s;
+    rt_size_t n = 0, len, i;
+    rt_uint32_t stars;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    if (entry->flags & RT_KLOG_ENTRY_FMT)
+    {
+        fmt = (const char *)arg;
+        for (len = 0; fmt + len < (const char *)end && fmt[len]; len ++)
+        {
+        }
+        if (fmt + len >= (const char *)end)
+        {
+            buf[0] = '\0';
+            return 0;
+        }
+        arg += len / 4 + 1;
+    }
+
+    while (n < size - 1 && *fmt)
+    {
+        p = klog_next_spec(fmt, &spec);
+        len = (p ? p : fmt + rt_strlen(fmt)) - fmt;
+        if (len > size - 1 - n)
+        {
+            len = size - 1 - n;
+        }
+        rt_memcpy(buf + n, fmt, len);
+        n += len;
+        if (p == RT_NULL || n >= size - 1)
+        {
+            break;
+        }
+        fmt = spec.end;
+
+        if (klog_spec_words(&spec) > (rt_size_t)(end - arg))
+        {
+            /* arguments run out: a damaged entry, keep the rest literal */
+            fmt = spec.start;
+            len = rt_strlen(fmt) < size - 1 - n ? rt_strlen(fmt) : size - 1 - n;
+            rt_memcpy(buf + n, fmt, len);
+            n += len;
+            break;
+        }
+
+        /* rebuild the conversion with the '*' values filled in */
+        i = 0;
+        stars = 0;
+        for (p = spec.start; p < spec.end - 1 && i < KLOG_SPEC_MAX - 16; p ++)
+        {
+            if (*p == '*')
+            {
+                i += rt_snprintf(spec_buf + i, KLOG_SPEC_MAX - i, "%d", (int)arg[stars ++]);
+            }
+            else if (*p != 'l' && *p != 'L')
+            {
+                spec_buf[i ++] = *p;
+            }
+        }
+        arg += stars;
+        if (spec.qualifier == 'L')
+        {
+            spec_buf[i ++] = 'l';
+            spec_buf[i ++] = 'l';
+        }
+
+        switch (spec.conv)
+        {
+        case 'c':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'd':
+        case 'i':
+        case 'u':
+            spec_buf[i ++] = spec.conv;
+            spec_buf[i] = '\0';
+            if (spec.qualifier == 'L')
+            {
+                n = klog_append(buf, size, n, rt_snprintf(buf + n, size - n, spec_buf,
+                                (long long)((rt_uint64_t)arg[1] << 32 | arg[0])));
+                arg += 2;
+            }
+            else
+            {
+                n = klog_append(buf, size, n, rt_snprintf(buf + n, size - n, spec_buf, *arg ++));
+            }
+            break;
+
+        case 'p':
+            /* rt_vsnprintf: zero padded to the pointer width by default */
+            if (spec_buf[i - 1] == '%')
+            {
+                spec_buf[i ++] = '0';
+                spec_buf[i ++] = '8';
+            }
+            spec_buf[i ++] = 'x';
+            spec_buf[i] = '\0';
+            n = klog_append(buf, size, n, rt_snprintf(buf + n, size - n, spec_buf, *arg ++));
+            break;
+
+        case 's':
+            s = (const char *)arg;
+            for (len = 0; (const char *)arg + len < (const char *)end && s[len]; len ++)
+            {
+            }
+            if ((const char *)arg + len >= (const char *)end)
+            {
+                break;
+            }
+            spec_buf[i ++] = 's';
+            spec_buf[i] = '\0';
+            n = klog_append(buf, size, n, rt_snprintf(buf + n, size - n, spec_buf, s));
+            arg += len / 4 + 1;
+            break;
+
+        case '%':
+            buf[n ++] = '%';
+            break;
+
+        default:
+            /* rt_vsnprintf() prints '%' and the character */
+            buf[n ++] = '%';
+            if (spec.conv && n < size - 1)
+            {
+                buf[n ++] = spec.conv;
+            }
+            break;
+        }
+    }
+
+    buf[n] = '\0';
+    return n;
+}
+RTM_EXPORT(rt_klog_format);
+
+/* write out what is complete, from the klog thread or a panic */
+static void klog_drain(void)
+{
+    struct rt_klog_ring *ring = &rt_klog_ring;
+    struct rt_klog_entry *entry;
+    rt_uint32_t tail, off, size, dropped;
+    const char *text;
+
+    if (!klog_cas(&_klog_draining, 0, 1))
+    {
+        return;
+    }
+
+    tail = ring->tail;
+    while (tail != __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+    {
+        off = tail & (ring->size - 1);
+        if (ring->size - off < KLOG_ENTRY_HDR)
+        {
+            tail += ring->size - off;
+            __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        entry = (struct rt_klog_entry *)&ring->data[off];
+        if (__atomic_load_n(&entry->pos, __ATOMIC_ACQUIRE) != RT_KLOG_POS_DONE(tail))
+        {
+            /* claimed, the writer has not finished it yet */
+            break;
+        }
+
+        if (!(entry->flags & RT_KLOG_ENTRY_PAD))
+        {
+            rt_klog_format((const char *)(rt_ubase_t)entry->fmt, entry,
+                           _klog_line, sizeof(_klog_line));
+            text = _klog_line;
+            if ((entry->flags & RT_KLOG_LEVEL) && text[0] == '<' &&
+                    text[1] >= '0' && text[1] <= '7' && text[2] == '>')
+            {
+                text += 3;
+            }
+            rt_klog_output(text, rt_strlen(text));
+        }
+
+        /* before the space is given back to the writers */
+        size = entry->size;
+        rt_memset(entry, 0, size);
+        tail += size;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    if (dropped != _klog_dropped_seen)
+    {
+        rt_snprintf(_klog_line, sizeof(_klog_line), "klog: %d messages dropped\n",
+                    dropped - _klog_dropped_seen);
+        rt_klog_output(_klog_line, rt_strlen(_klog_line));
+        _klog_dropped_seen = dropped;
+    }
+
+    __atomic_store_n(&_klog_draining, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Write out the queued messages and print synchronously from now on, for
+ * the exception and assertion dumps that never return to the scheduler.
+ */
+void rt_klog_panic(void)
+{
+    _klog_sync = 1;
+    klog_drain();
+}
+RTM_EXPORT(rt_klog_panic);
+
+static void klog_thread_entry(void *parameter)
+{
+    while (1)
+    {
+        klog_drain();
+        rt_thread_delay(rt_tick_from_millisecond(CONFIG_RT_DEFERRED_LOG_PERIOD));
+    }
+}
+
+/**
+ * Start the klog thread, messages are deferred from here on.
+ */
+int rt_klog_init(void)
+{
+    _klog_thread = rt_thread_create("klog", klog_thread_entry, RT_NULL, KLOG_STACK_SIZE,
+                                    CONFIG_RT_DEFERRED_LOG_THREAD_PRIORITY, 10);
+    if (_klog_thread == RT_NULL)
+    {
+        rt_kprintf("klog: no thread, logging synchronously\n");
+        return -RT_ENOMEM;
+    }
+
+    _klog_sync = 0;
+    rt_thread_startup(_klog_thread);
+    return RT_EOK;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int cmd_klog(int argc, const char **argv)
+{
+    struct rt_klog_ring *ring = &rt_klog_ring;
+    int fd;
+
+    if (argc == 1)
+    {
+        rt_kprintf("ring %d bytes at 0x%p, %d queued, %d dropped, %s\n",
+                   ring->size, ring, ring->head - ring->tail, ring->dropped,
+                   _klog_sync ? "synchronous" : "deferred");
+        return 0;
+    }
+
+    if (!rt_strcmp(argv[1], "flush"))
+    {
+        klog_drain();
+        return 0;
+    }
+
+    if (!rt_strcmp(argv[1], "dump") && argc == 3)
+    {
+        /* raw ring for utility/host-tool/klog_decode, e.g. over adb pull */
+        fd = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC);
+        if (fd < 0)
+        {
+            rt_kprintf("klog: cannot open %s\n", argv[2]);
+            return -1;
+        }
+        write(fd, ring, sizeof(*ring));
+        close(fd);
+        return 0;
+    }
+
+    rt_kprintf("Usage: klog [flush | dump <file>]\n");
+    return -1;
+}
+FINSH_FUNCTION_EXPORT_ALIAS(cmd_klog, __cmd_klog, deferred log state flush and dump);
+#endif
@@ -17,6 +17,8 @@
  * 2013-06-24     Bernard      remove rt_kprintf if RT_USING_CONSOLE is not defined.
  * 2013-09-24     aozima       make sure the device is in STREAM mode when used by rt_kprintf.
  * 2015-07-06     Bernard      Add rt_assert_handler routine.
+ * 2026-10-19     melis        move rt_memset/rt_memcpy/rt_memmove to memops.c
+ * 2026-10-19     melis        rt_kprintf() through the deferred log.
  */
 
 #include <rtthread.h>
@@ -31,6 +33,10 @@
 #include <dlmodule.h>
 #endif
 
+#ifdef CONFIG_RT_USING_DEFERRED_LOG
+#include <klog.h>
+#endif
+
 /* use precision */
 #define RT_PRINTF_PRECISION
 
@@ -125,217 +131,12 @@ int *_rt_errno(void)
 }
 RTM_EXPORT(_rt_errno);
 
-/**
- * This function will set the content of memory to specified value
- *
- * @param s the address of source memory
- * @param c the value shall be set in content
- * @param count the copied length
- *
- * @return the address of source memory
- */
-void *rt_memset(void *s, int c, rt_ubase_t count)
-{
-#ifdef RT_USING_TINY_SIZE
-    char *xs = (char *)s;
-
-    while (count--)
-    {
-        *xs++ = c;
-    }
-
-    return s;
-#else
-#define LBLOCKSIZE      (sizeof(long))
-#define UNALIGNED(X)    ((long)X & (LBLOCKSIZE - 1))
-#define TOO_SMALL(LEN)  ((LEN) < LBLOCKSIZE)
-
-    unsigned int i;
-    char *m = (char *)s;
-    unsigned long buffer;
-    unsigned long *aligned_addr;
-    unsigned int d = c & 0xff;  /* To avoid sign extension, copy C to an
-                                unsigned variable.  */
-
-    if (!TOO_SMALL(count) && !UNALIGNED(s))
-    {
-        /* If we get this far, we know that n is large and m is word-aligned. */
-        aligned_addr = (unsigned long *)s;
-
-        /* Store D into each char sized location in BUFFER so that
-         * we can set large blocks quickly.
-         */
-        if (LBLOCKSIZE == 4)
-        {
-            buffer = (d << 8) | d;
-            buffer |= (buffer << 16);
-        }
-        else
-        {
-            buffer = 0;
-            for (i = 0; i < LBLOCKSIZE; i ++)
-            {
-                buffer = (buffer << 8) | d;
-            }
-        }
-
-        while (count >= LBLOCKSIZE * 4)
-        {
-            *aligned_addr++ = buffer;
-            *aligned_addr++ = buffer;
-            *aligned_addr++ = buffer;
-            *aligned_addr++ = buffer;
-            count -= 4 * LBLOCKSIZE;
-        }
-
-        while (count >= LBLOCKSIZE)
-        {
-            *aligned_addr++ = buffer;
-            count -= LBLOCKSIZE;
-        }
-
-        /* Pick up the remainder with a bytewise loop. */
-        m = (char *)aligned_addr;
-    }
-
-    while (count--)
-    {
-        *m++ = (char)d;
-    }
-
-    return s;
-
-#undef LBLOCKSIZE
-#undef UNALIGNED
-#undef TOO_SMALL
-#endif
-}
+#ifdef CONFIG_ARCH_OPTIMIZED_MEMOPS
+/* rt_memset/rt_memcpy/rt_memmove come from the arch, see memops.c */
 RTM_EXPORT(rt_memset);
-
-/**
- * This function will copy memory content from source address to destination
- * address.
- *
- * @param dst the address of destination memory
- * @param src  the address of source memory
- * @param count the copied length
- *
- * @return the address of destination memory
- */
-void *rt_memcpy(void *dst, const void *src, rt_ubase_t count)
-{
-#ifdef RT_USING_TINY_SIZE
-    char *tmp = (char *)dst, *s = (char *)src;
-    rt_ubase_t len;
-
-    if (tmp <= s || tmp > (s + count))
-    {
-        while (count--)
-        {
-            *tmp ++ = *s ++;
-        }
-    }
-    else
-    {
-        for (len = count; len > 0; len --)
-        {
-            tmp[len - 1] = s[len - 1];
-        }
-    }
-
-    return dst;
-#else
-
-#define UNALIGNED(X, Y) \
-    (((long)X & (sizeof (long) - 1)) | ((long)Y & (sizeof (long) - 1)))
-#define BIGBLOCKSIZE    (sizeof (long) << 2)
-#define LITTLEBLOCKSIZE (sizeof (long))
-#define TOO_SMALL(LEN)  ((LEN) < BIGBLOCKSIZE)
-
-    char *dst_ptr = (char *)dst;
-    char *src_ptr = (char *)src;
-    long *aligned_dst;
-    long *aligned_src;
-    int len = count;
-
-    /* If the size is small, or either SRC or DST is unaligned,
-    then punt into the byte copy loop.  This should be rare. */
-    if (!TOO_SMALL(len) && !UNALIGNED(src_ptr, dst_ptr))
-    {
-        aligned_dst = (long *)dst_ptr;
-        aligned_src = (long *)src_ptr;
-
-        /* Copy 4X long words at a time if possible. */
-        while (len >= BIGBLOCKSIZE)
-        {
-            *aligned_dst++ = *aligned_src++;
-            *aligned_dst++ = *aligned_src++;
-            *aligned_dst++ = *aligned_src++;
-            *aligned_dst++ = *aligned_src++;
-            len -= BIGBLOCKSIZE;
-        }
-
-        /* Copy one long word at a time if possible. */
-        while (len >= LITTLEBLOCKSIZE)
-        {
-            *aligned_dst++ = *aligned_src++;
-            len -= LITTLEBLOCKSIZE;
-        }
-
-        /* Pick up any residual with a byte copier. */
-        dst_ptr = (char *)aligned_dst;
-        src_ptr = (char *)aligned_src;
-    }
-
-    while (len--)
-    {
-        *dst_ptr++ = *src_ptr++;
-    }
-
-    return dst;
-#undef UNALIGNED
-#undef BIGBLOCKSIZE
-#undef LITTLEBLOCKSIZE
-#undef TOO_SMALL
-#endif
-}
 RTM_EXPORT(rt_memcpy);
-
-/**
- * This function will move memory content from source address to destination
- * address.
- *
- * @param dest the address of destination memory
- * @param src  the address of source memory
- * @param n the copied length
- *
- * @return the address of destination memory
- */
-void *rt_memmove(void *dest, const void *src, rt_ubase_t n)
-{
-    char *tmp = (char *)dest, *s = (char *)src;
-
-    if (s < tmp && tmp < s + n)
-    {
-        tmp += n;
-        s += n;
-
-        while (n--)
-        {
-            *(--tmp) = *(--s);
-        }
-    }
-    else
-    {
-        while (n--)
-        {
-            *tmp++ = *s++;
-        }
-    }
-
-    return dest;
-}
 RTM_EXPORT(rt_memmove);
+#endif
 
 /**
  * This function will compare two areas of memory
@@ -1332,6 +1133,49 @@ void rt_kputs(const char *str)
 #endif
 }
 
+/* write length bytes of str to the console, interrupts masked by the caller */
+static void _kprintf_output(const char *str, rt_size_t length)
+{
+#ifdef RT_USING_DEVICE
+    if (_console_device == RT_NULL)
+    {
+        rt_hw_console_output(str);
+    }
+    else
+    {
+        rt_uint16_t old_flag = _console_device->open_flag;
+
+        _console_device->open_flag |= RT_DEVICE_FLAG_STREAM;
+#ifdef CONFIG_COMPONENTS_MULTI_CONSOLE
+        cli_console_write(get_clitask_console(), str, length);
+#else
+        rt_device_write(_console_device, 0, str, length);
+#endif
+        _console_device->open_flag = old_flag;
+    }
+#else
+    rt_hw_console_output(str);
+#endif
+}
+
+#ifdef CONFIG_RT_USING_DEFERRED_LOG
+/**
+ * This function writes a message formatted by the klog thread to the
+ * console, the way rt_kprintf() does.
+ *
+ * @param str the text, NUL terminated
+ * @param length the length of str
+ */
+void rt_klog_output(const char *str, rt_size_t length)
+{
+    register rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    _kprintf_output(str, length);
+    rt_hw_interrupt_enable(level);
+}
+#endif
+
 /**
  * This function will print a formatted string on system console
  *
@@ -1345,6 +1189,14 @@ int rt_kprintf(const char *fmt, ...)
     static char rt_log_buf[RT_CONSOLEBUF_SIZE];
 
     va_start(args, fmt);
+#ifdef CONFIG_RT_DEFERRED_LOG_KPRINTF
+    /* queued for the klog thread, formatted there */
+    if (rt_klog_vprintf(0, fmt, args) == 0)
+    {
+        va_end(args);
+        return 0;
+    }
+#endif
     /* the return value of vsnprintf is the number of bytes that would be
      * written to buffer had if the size of the buffer been sufficiently
      * large excluding the terminating null byte. If the output string
@@ -1356,26 +1208,7 @@ int rt_kprintf(const char *fmt, ...)
     {
         length = RT_CONSOLEBUF_SIZE - 1;
     }
-#ifdef RT_USING_DEVICE
-    if (_console_device == RT_NULL)
-    {
-        rt_hw_console_output(rt_log_buf);
-    }
-    else
-    {
-        rt_uint16_t old_flag = _console_device->open_flag;
-
-        _console_device->open_flag |= RT_DEVICE_FLAG_STREAM;
-#ifdef CONFIG_COMPONENTS_MULTI_CONSOLE
-        cli_console_write(get_clitask_console(), rt_log_buf, length);
-#else
-        rt_device_write(_console_device, 0, rt_log_buf, length);
-#endif
-        _console_device->open_flag = old_flag;
-    }
-#else
-    rt_hw_console_output(rt_log_buf);
-#endif
+    _kprintf_output(rt_log_buf, length);
     rt_hw_interrupt_enable(level);
     va_end(args);
 
@@ -1550,6 +1383,10 @@ void rt_assert_handler(const char *ex_string, const char *func, rt_size_t line)
     asm volatile("cpsid i" : : : "memory", "cc");
     asm volatile("mov %0, r13\n":"=r"(sp));
 
+#ifdef CONFIG_RT_USING_DEFERRED_LOG
+    rt_klog_panic();
+#endif
+
     if (rt_assert_hook == RT_NULL)
     {
 #ifdef RT_USING_MODULE
@@ -1579,9 +1416,6 @@ int *__errno(void) __attribute__((alias("_rt_errno")));
 
 #if !defined (RT_USING_NEWLIB) && defined (RT_USING_MINILIBC) && defined (__GNUC__)
 #include <sys/types.h>
-void *memcpy(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memcpy")));
-void *memset(void *s, int c, size_t n) __attribute__((weak, alias("rt_memset")));
-void *memmove(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memmove")));
 int   memcmp(const void *s1, const void *s2, size_t n) __attribute__((weak, alias("rt_memcmp")));
 
 size_t strlen(const char *s) __attribute__((weak, alias("rt_strlen")));
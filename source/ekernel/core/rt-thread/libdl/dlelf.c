@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author      Notes
  * 2018/08/29     Bernard     first version
+ * 2026-10-19     melis       resolve each kernel import once per load
  */
 
 #include "dlmodule.h"
@@ -15,12 +16,59 @@
 #define DBG_LVL    DBG_INFO
 #include <rtdbg.h>          // must after of DEBUG_ENABLE or some other options
 
+/*
+ * Kernel addresses already resolved for this module, by index into its
+ * symbol table. A module imports each kernel symbol once but relocates it
+ * at every call site (and again in .rel.plt), so the kernel symbol table
+ * is searched once per import instead of once per relocation.
+ */
+struct dlmodule_symcache
+{
+    Elf32_Sym  *symtab;
+    rt_uint32_t nsym;
+    Elf32_Addr *addr;
+};
+
+static Elf32_Addr dlmodule_symbol_import(struct rt_dlmodule *module, struct dlmodule_symcache *cache,
+                                         Elf32_Sym *symtab, rt_uint32_t nsym,
+                                         rt_uint32_t symndx, const char *name)
+{
+    Elf32_Addr addr;
+
+    if (cache->symtab != symtab)
+    {
+        rt_free(cache->addr);
+        cache->symtab = symtab;
+        cache->nsym   = nsym;
+        cache->addr   = rt_calloc(nsym, sizeof(Elf32_Addr));
+    }
+
+    module->nreloc ++;
+    if (cache->addr && symndx < cache->nsym && cache->addr[symndx] != 0)
+    {
+        return cache->addr[symndx];
+    }
+
+    addr = dlmodule_symbol_find(name);
+    if (addr != 0)
+    {
+        module->nimport ++;
+        if (cache->addr && symndx < cache->nsym)
+        {
+            cache->addr[symndx] = addr;
+        }
+    }
+
+    return addr;
+}
+
 rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_ptr)
 {
     rt_bool_t linked   = RT_FALSE;
     rt_uint32_t index, module_size = 0;
     Elf32_Addr vstart_addr, vend_addr;
     rt_bool_t has_vstart;
+    struct dlmodule_symcache cache = { RT_NULL, 0, RT_NULL };
 
     RT_ASSERT(module_ptr != RT_NULL);
 
@@ -121,7 +169,7 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
     /* handle relocation section */
     for (index = 0; index < elf_module->e_shnum; index ++)
     {
-        rt_uint32_t i, nr_reloc;
+        rt_uint32_t i, nr_reloc, nr_sym;
         Elf32_Sym *symtab;
         Elf32_Rel *rel;
         rt_uint8_t *strtab;
@@ -141,6 +189,7 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
         strtab = (rt_uint8_t *)module_ptr +
                  shdr[shdr[shdr[index].sh_link].sh_link].sh_offset;
         nr_reloc = (rt_uint32_t)(shdr[index].sh_size / sizeof(Elf32_Rel));
+        nr_sym = (rt_uint32_t)(shdr[shdr[index].sh_link].sh_size / sizeof(Elf32_Sym));
 
         /* relocate every items */
         for (i = 0; i < nr_reloc; i ++)
@@ -162,7 +211,9 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
 
                 LOG_D("relocate symbol: %s", strtab + sym->st_name);
                 /* need to resolve symbol in kernel symbol table */
-                addr = dlmodule_symbol_find((const char *)(strtab + sym->st_name));
+                addr = dlmodule_symbol_import(module, &cache, symtab, nr_sym,
+                                              ELF32_R_SYM(rel->r_info),
+                                              (const char *)(strtab + sym->st_name));
                 if (addr == 0)
                 {
                     LOG_E("Module: can't find %s in kernel symbol table", strtab + sym->st_name);
@@ -178,9 +229,11 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule *module, void *module_pt
 
         if (unsolved)
         {
+            rt_free(cache.addr);
             return -RT_ERROR;
         }
     }
+    rt_free(cache.addr);
 
     /* construct module symbol table */
     for (index = 0; index < elf_module->e_shnum; index ++)
@@ -248,6 +301,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule *module, void *module
     rt_uint32_t index, rodata_addr = 0, bss_addr = 0, data_addr = 0;
     rt_uint32_t module_addr = 0, module_size = 0;
     rt_uint8_t *ptr, *strtab, *shstrab;
+    struct dlmodule_symcache cache = { RT_NULL, 0, RT_NULL };
 
     /* get the ELF image size */
     for (index = 0; index < elf_module->e_shnum; index ++)
@@ -348,7 +402,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule *module, void *module
     /* handle relocation section */
     for (index = 0; index < elf_module->e_shnum; index ++)
     {
-        rt_uint32_t i, nr_reloc;
+        rt_uint32_t i, nr_reloc, nr_sym;
         Elf32_Sym *symtab;
         Elf32_Rel *rel;
 
@@ -368,6 +422,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule *module, void *module
         shstrab  = (rt_uint8_t *)module_ptr +
                    shdr[elf_module->e_shstrndx].sh_offset;
         nr_reloc = (rt_uint32_t)(shdr[index].sh_size / sizeof(Elf32_Rel));
+        nr_sym   = (rt_uint32_t)(shdr[shdr[index].sh_link].sh_size / sizeof(Elf32_Sym));
 
         /* relocate every items */
         for (i = 0; i < nr_reloc; i ++)
@@ -436,7 +491,9 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule *module, void *module
                     LOG_D("relocate symbol: %s", strtab + sym->st_name);
 
                     /* need to resolve symbol in kernel symbol table */
-                    addr = dlmodule_symbol_find((const char *)(strtab + sym->st_name));
+                    addr = dlmodule_symbol_import(module, &cache, symtab, nr_sym,
+                                                  ELF32_R_SYM(rel->r_info),
+                                                  (const char *)(strtab + sym->st_name));
                     if (addr != (Elf32_Addr)RT_NULL)
                     {
                         dlmodule_relocate(module, rel, addr);
@@ -457,5 +514,7 @@ rt_err_t dlmodule_load_relocated_object(struct rt_dlmodule *module, void *module
         }
     }
 
+    rt_free(cache.addr);
+
     return RT_EOK;
 }
@@ -20,13 +20,6 @@
 #define DBG_LVL    DBG_INFO
 #include <rtdbg.h>          // must after of DEBUG_ENABLE or some other options
 
-static struct rt_module_symtab *_rt_module_symtab_begin = RT_NULL;
-static struct rt_module_symtab *_rt_module_symtab_end   = RT_NULL;
-
-#if defined(__IAR_SYSTEMS_ICC__) /* for IAR compiler */
-#pragma section="RTMSymTab"
-#endif
-
 /* set the name of module */
 static void _dlmodule_set_name(struct rt_dlmodule *module, const char *path)
 {
@@ -465,6 +458,7 @@ struct rt_dlmodule *dlmodule_load(const char *filename)
     rt_err_t ret = RT_EOK;
     rt_uint8_t *module_ptr = RT_NULL;
     struct rt_dlmodule *module = RT_NULL;
+    rt_tick_t start = rt_tick_get();
 
     fd = open(filename, O_RDONLY, 0);
     if (fd >= 0)
@@ -546,6 +540,11 @@ struct rt_dlmodule *dlmodule_load(const char *filename)
     /* release module data */
     rt_free(module_ptr);
 
+    LOG_I("%.*s loaded: %d bytes in %d ms, %d imports, %d relocations",
+          RT_NAME_MAX, module->parent.name, module->mem_size,
+          (rt_tick_get() - start) * 1000 / RT_TICK_PER_SECOND,
+          module->nimport, module->nreloc);
+
     /* increase module reference count */
     module->nref ++;
 
@@ -674,45 +673,6 @@ void dlmodule_exit(int ret_code)
     rt_exit_critical();
 }
 
-rt_uint32_t dlmodule_symbol_find(const char *sym_str)
-{
-    /* find in kernel symbol table */
-    struct rt_module_symtab *index;
-
-    for (index = _rt_module_symtab_begin; index != _rt_module_symtab_end; index ++)
-    {
-        if (rt_strcmp(index->name, sym_str) == 0)
-        {
-            return (rt_uint32_t)index->addr;
-        }
-    }
-
-    return 0;
-}
-
-int rt_system_dlmodule_init(void)
-{
-#if defined(__GNUC__) && !defined(__CC_ARM)
-    extern int __rtmsymtab_start;
-    extern int __rtmsymtab_end;
-
-    _rt_module_symtab_begin = (struct rt_module_symtab *)&__rtmsymtab_start;
-    _rt_module_symtab_end   = (struct rt_module_symtab *)&__rtmsymtab_end;
-#elif defined (__CC_ARM)
-    extern int RTMSymTab$$Base;
-    extern int RTMSymTab$$Limit;
-
-    _rt_module_symtab_begin = (struct rt_module_symtab *)&RTMSymTab$$Base;
-    _rt_module_symtab_end   = (struct rt_module_symtab *)&RTMSymTab$$Limit;
-#elif defined (__IAR_SYSTEMS_ICC__)
-    _rt_module_symtab_begin = __section_begin("RTMSymTab");
-    _rt_module_symtab_end   = __section_end("RTMSymTab");
-#endif
-
-    return 0;
-}
-INIT_COMPONENT_EXPORT(rt_system_dlmodule_init);
-
 /**
  * This function will find the specified module.
  *
@@ -735,25 +695,6 @@ struct rt_dlmodule *dlmodule_find(const char *name)
 }
 RTM_EXPORT(dlmodule_find);
 
-int list_symbols(int argc, const char **argv)
-{
-    extern int __rtmsymtab_start;
-    extern int __rtmsymtab_end;
-
-    /* find in kernel symbol table */
-    struct rt_module_symtab *index;
-
-    for (index = _rt_module_symtab_begin;
-         index != _rt_module_symtab_end;
-         index ++)
-    {
-        rt_kprintf("%s => 0x%08x\n", index->name, index->addr);
-    }
-
-    return 0;
-}
-MSH_CMD_EXPORT(list_symbols, list symbols information);
-
 int list_module(int argc, const char **argv)
 {
     struct rt_dlmodule *module;
@@ -57,6 +57,9 @@ struct rt_dlmodule
 
     rt_uint16_t nsym;       /* number of symbols in the module */
     struct rt_module_symtab *symtab;    /* module symbol table */
+
+    rt_uint32_t nimport;    /* kernel symbols resolved at load */
+    rt_uint32_t nreloc;     /* relocations against them */
 };
 
 struct rt_dlmodule *dlmodule_create(void);
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author      Notes
+ * 2018/08/29     Bernard     first version
+ * 2026-10-19     melis       split from dlmodule.c; binary search over the
+ *                            link-time sorted RTMSymTab.
+ */
+
+/*
+ * The kernel symbol table the module loader resolves imports against.
+ *
+ * With GCC, RTM_EXPORT() puts every entry in its own "RTMSymTab.<symbol>"
+ * section and kernel.lds collects them with SORT_BY_NAME, so the table comes
+ * out ordered by name and a lookup is a binary search instead of a strcmp
+ * over every exported symbol. armcc and IAR keep the single "RTMSymTab"
+ * section their $$Base/$$Limit and __section_begin() symbols name; the
+ * table is then found unsorted at init and searched linearly.
+ */
+
+#include <rtthread.h>
+#include <rtm.h>
+
+#include "dlmodule.h"
+
+#define DBG_TAG    "DLMD"
+#define DBG_LVL    DBG_INFO
+#include <rtdbg.h>          // must after of DEBUG_ENABLE or some other options
+
+static struct rt_module_symtab *_rt_module_symtab_begin = RT_NULL;
+static struct rt_module_symtab *_rt_module_symtab_end   = RT_NULL;
+static rt_bool_t _rt_module_symtab_sorted = RT_FALSE;
+
+#if defined(__IAR_SYSTEMS_ICC__) /* for IAR compiler */
+#pragma section="RTMSymTab"
+#endif
+
+static void _dlmodule_symtab_setup(struct rt_module_symtab *begin,
+                                   struct rt_module_symtab *end)
+{
+    struct rt_module_symtab *index;
+
+    _rt_module_symtab_begin = begin;
+    _rt_module_symtab_end   = end;
+    _rt_module_symtab_sorted = RT_TRUE;
+
+    for (index = begin; index + 1 < end; index ++)
+    {
+        if (rt_strcmp(index->name, (index + 1)->name) >= 0)
+        {
+            LOG_W("kernel symbol table not sorted at %s, linear lookup", (index + 1)->name);
+            _rt_module_symtab_sorted = RT_FALSE;
+            break;
+        }
+    }
+}
+
+rt_uint32_t dlmodule_symbol_find(const char *sym_str)
+{
+    /* find in kernel symbol table */
+    struct rt_module_symtab *index;
+    rt_int32_t low, high, mid, cmp;
+
+    if (_rt_module_symtab_sorted)
+    {
+        low  = 0;
+        high = _rt_module_symtab_end - _rt_module_symtab_begin - 1;
+        while (low <= high)
+        {
+            mid = low + (high - low) / 2;
+            index = &_rt_module_symtab_begin[mid];
+            cmp = rt_strcmp(index->name, sym_str);
+            if (cmp == 0)
+            {
+                return (rt_uint32_t)(rt_ubase_t)index->addr;
+            }
+            if (cmp < 0)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid - 1;
+            }
+        }
+
+        return 0;
+    }
+
+    for (index = _rt_module_symtab_begin; index != _rt_module_symtab_end; index ++)
+    {
+        if (rt_strcmp(index->name, sym_str) == 0)
+        {
+            return (rt_uint32_t)(rt_ubase_t)index->addr;
+        }
+    }
+
+    return 0;
+}
+
+int rt_system_dlmodule_init(void)
+{
+#if defined(__GNUC__) && !defined(__CC_ARM)
+    extern int __rtmsymtab_start;
+    extern int __rtmsymtab_end;
+
+    _dlmodule_symtab_setup((struct rt_module_symtab *)&__rtmsymtab_start,
+                           (struct rt_module_symtab *)&__rtmsymtab_end);
+#elif defined (__CC_ARM)
+    extern int RTMSymTab$$Base;
+    extern int RTMSymTab$$Limit;
+
+    _dlmodule_symtab_setup((struct rt_module_symtab *)&RTMSymTab$$Base,
+                           (struct rt_module_symtab *)&RTMSymTab$$Limit);
+#elif defined (__IAR_SYSTEMS_ICC__)
+    _dlmodule_symtab_setup(__section_begin("RTMSymTab"),
+                           __section_end("RTMSymTab"));
+#endif
+
+    return 0;
+}
+INIT_COMPONENT_EXPORT(rt_system_dlmodule_init);
+
+int list_symbols(int argc, const char **argv)
+{
+    /* find in kernel symbol table */
+    struct rt_module_symtab *index;
+
+    for (index = _rt_module_symtab_begin;
+         index != _rt_module_symtab_end;
+         index ++)
+    {
+        rt_kprintf("%s => 0x%08x\n", index->name, index->addr);
+    }
+
+    rt_kprintf("%d symbols, %s\n", (int)(_rt_module_symtab_end - _rt_module_symtab_begin),
+               _rt_module_symtab_sorted ? "sorted" : "unsorted");
+
+    return 0;
+}
+MSH_CMD_EXPORT(list_symbols, list symbols information);
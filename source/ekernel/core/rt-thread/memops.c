@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     melis        split from kservice.c; word copies for
+ *                             mutually misaligned buffers, prefetch.
+ */
+
+/*
+ * Generic rt_memset/rt_memcpy/rt_memmove. Architectures with their own
+ * (CONFIG_ARCH_OPTIMIZED_MEMOPS) do not build this file, everything else,
+ * riscv included, gets these. The copies always store whole aligned words
+ * to dst; when src has a different alignment the words are built from two
+ * aligned loads by shifting, instead of falling back to bytes.
+ *
+ * Both loops read the aligned word around the first and the last source
+ * byte, so up to sizeof(long) - 1 bytes outside the buffer, never outside
+ * its page.
+ */
+
+#include <rtthread.h>
+
+#define OPSIZ           (sizeof(unsigned long))
+#define OPMASK          (OPSIZ - 1)
+#define UNALIGNED(X)    ((rt_ubase_t)(X) & OPMASK)
+
+/* below this the setup costs more than the word loop saves */
+#define SMALL_COPY      (OPSIZ * 4)
+/* copies this large stream through the cache, fetch ahead */
+#define PREFETCH_MIN    256
+#define PREFETCH_AHEAD  128
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define MERGE(w0, sh0, w1, sh1) (((w0) << (sh0)) | ((w1) >> (sh1)))
+#else
+#define MERGE(w0, sh0, w1, sh1) (((w0) >> (sh0)) | ((w1) << (sh1)))
+#endif
+
+#if defined(__GNUC__)
+#define PREFETCH(p)     __builtin_prefetch((p), 0, 0)
+#else
+#define PREFETCH(p)     do { } while (0)
+#endif
+
+/**
+ * This function will set the content of memory to specified value
+ *
+ * @param s the address of source memory
+ * @param c the value shall be set in content
+ * @param count the copied length
+ *
+ * @return the address of source memory
+ */
+void *rt_memset(void *s, int c, rt_ubase_t count)
+{
+#ifdef RT_USING_TINY_SIZE
+    char *xs = (char *)s;
+
+    while (count--)
+    {
+        *xs++ = c;
+    }
+
+    return s;
+#else
+    unsigned char *m = (unsigned char *)s;
+    unsigned long buffer;
+    unsigned long *aligned_addr;
+
+    if (count >= SMALL_COPY)
+    {
+        while (UNALIGNED(m))
+        {
+            *m++ = (unsigned char)c;
+            count--;
+        }
+
+        /* Store c into each char sized location in buffer. */
+        buffer = (unsigned char)c;
+        buffer |= buffer << 8;
+        buffer |= buffer << 16;
+        if (OPSIZ > 4)
+        {
+            buffer |= (buffer << 16) << 16;
+        }
+
+        aligned_addr = (unsigned long *)m;
+        while (count >= OPSIZ * 8)
+        {
+            aligned_addr[0] = buffer;
+            aligned_addr[1] = buffer;
+            aligned_addr[2] = buffer;
+            aligned_addr[3] = buffer;
+            aligned_addr[4] = buffer;
+            aligned_addr[5] = buffer;
+            aligned_addr[6] = buffer;
+            aligned_addr[7] = buffer;
+            aligned_addr += 8;
+            count -= OPSIZ * 8;
+        }
+
+        while (count >= OPSIZ)
+        {
+            *aligned_addr++ = buffer;
+            count -= OPSIZ;
+        }
+
+        m = (unsigned char *)aligned_addr;
+    }
+
+    while (count--)
+    {
+        *m++ = (unsigned char)c;
+    }
+
+    return s;
+#endif
+}
+RTM_EXPORT(rt_memset);
+
+/*
+ * Forward copy of words * sizeof(long) bytes to a word aligned dst. Also
+ * serves rt_memmove for dst below src: every source word is loaded before
+ * the store that could overlap it.
+ */
+static void copy_words_fwd(unsigned long *d, const unsigned char *src, rt_ubase_t words)
+{
+    const unsigned long *s;
+    unsigned long w0, w1;
+    unsigned int sh0, sh1;
+
+    if (!UNALIGNED(src))
+    {
+        s = (const unsigned long *)src;
+        while (words >= 8)
+        {
+            if (words >= PREFETCH_MIN / OPSIZ)
+            {
+                PREFETCH((const unsigned char *)s + PREFETCH_AHEAD);
+            }
+            w0 = s[0];
+            w1 = s[1];
+            d[0] = w0;
+            d[1] = w1;
+            w0 = s[2];
+            w1 = s[3];
+            d[2] = w0;
+            d[3] = w1;
+            w0 = s[4];
+            w1 = s[5];
+            d[4] = w0;
+            d[5] = w1;
+            w0 = s[6];
+            w1 = s[7];
+            d[6] = w0;
+            d[7] = w1;
+            s += 8;
+            d += 8;
+            words -= 8;
+        }
+        while (words--)
+        {
+            *d++ = *s++;
+        }
+        return;
+    }
+
+    /* shift-merge: each dst word is the tail of one aligned source word
+     * and the head of the next */
+    sh0 = UNALIGNED(src) * 8;
+    sh1 = OPSIZ * 8 - sh0;
+    s = (const unsigned long *)(src - UNALIGNED(src));
+    w0 = *s++;
+    while (words >= 4)
+    {
+        if (words >= PREFETCH_MIN / OPSIZ)
+        {
+            PREFETCH((const unsigned char *)s + PREFETCH_AHEAD);
+        }
+        w1 = s[0];
+        d[0] = MERGE(w0, sh0, w1, sh1);
+        w0 = s[1];
+        d[1] = MERGE(w1, sh0, w0, sh1);
+        w1 = s[2];
+        d[2] = MERGE(w0, sh0, w1, sh1);
+        w0 = s[3];
+        d[3] = MERGE(w1, sh0, w0, sh1);
+        s += 4;
+        d += 4;
+        words -= 4;
+    }
+    while (words--)
+    {
+        w1 = *s++;
+        *d++ = MERGE(w0, sh0, w1, sh1);
+        w0 = w1;
+    }
+}
+
+/**
+ * This function will copy memory content from source address to destination
+ * address.
+ *
+ * @param dst the address of destination memory
+ * @param src  the address of source memory
+ * @param count the copied length
+ *
+ * @return the address of destination memory
+ */
+void *rt_memcpy(void *dst, const void *src, rt_ubase_t count)
+{
+#ifdef RT_USING_TINY_SIZE
+    char *tmp = (char *)dst, *s = (char *)src;
+    rt_ubase_t len;
+
+    if (tmp <= s || tmp > (s + count))
+    {
+        while (count--)
+        {
+            *tmp ++ = *s ++;
+        }
+    }
+    else
+    {
+        for (len = count; len > 0; len --)
+        {
+            tmp[len - 1] = s[len - 1];
+        }
+    }
+
+    return dst;
+#else
+    unsigned char *d = (unsigned char *)dst;
+    const unsigned char *s = (const unsigned char *)src;
+    rt_ubase_t words;
+
+    if (count >= SMALL_COPY)
+    {
+        while (UNALIGNED(d))
+        {
+            *d++ = *s++;
+            count--;
+        }
+
+        words = count / OPSIZ;
+        copy_words_fwd((unsigned long *)d, s, words);
+        d += words * OPSIZ;
+        s += words * OPSIZ;
+        count &= OPMASK;
+    }
+
+    while (count--)
+    {
+        *d++ = *s++;
+    }
+
+    return dst;
+#endif
+}
+RTM_EXPORT(rt_memcpy);
+
+/**
+ * This function will move memory content from source address to destination
+ * address.
+ *
+ * @param dest the address of destination memory
+ * @param src  the address of source memory
+ * @param n the copied length
+ *
+ * @return the address of destination memory
+ */
+void *rt_memmove(void *dest, const void *src, rt_ubase_t n)
+{
+    unsigned char *d = (unsigned char *)dest;
+    const unsigned char *s = (const unsigned char *)src;
+
+    /* dst below src or no overlap: the forward copy is safe */
+    if ((rt_ubase_t)d - (rt_ubase_t)s >= n)
+    {
+        return rt_memcpy(dest, src, n);
+    }
+
+    d += n;
+    s += n;
+
+    if (n >= SMALL_COPY && UNALIGNED(d) == UNALIGNED(s))
+    {
+        unsigned long *ad;
+        const unsigned long *as;
+
+        while (UNALIGNED(d))
+        {
+            *(--d) = *(--s);
+            n--;
+        }
+
+        ad = (unsigned long *)d;
+        as = (const unsigned long *)s;
+        while (n >= OPSIZ * 4)
+        {
+            ad[-1] = as[-1];
+            ad[-2] = as[-2];
+            ad[-3] = as[-3];
+            ad[-4] = as[-4];
+            ad -= 4;
+            as -= 4;
+            n -= OPSIZ * 4;
+        }
+        while (n >= OPSIZ)
+        {
+            *(--ad) = *(--as);
+            n -= OPSIZ;
+        }
+        d = (unsigned char *)ad;
+        s = (const unsigned char *)as;
+    }
+
+    while (n--)
+    {
+        *(--d) = *(--s);
+    }
+
+    return dest;
+}
+RTM_EXPORT(rt_memmove);
+
+#if !defined (RT_USING_NEWLIB) && defined (RT_USING_MINILIBC) && defined (__GNUC__)
+#include <sys/types.h>
+void *memcpy(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memcpy")));
+void *memset(void *s, int c, size_t n) __attribute__((weak, alias("rt_memset")));
+void *memmove(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memmove")));
+#endif
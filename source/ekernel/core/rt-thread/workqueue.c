@@ -6,46 +6,229 @@
  * Change Logs:
  * Date           Author       Notes
  * 2017-02-27     bernard      fix the re-work issue.
+ * 2026-10-19     melis        worker pools with work stealing, one timer per
+ *                             queue for the delayed works, work timing.
+ */
+
+/*
+ * A workqueue has one or more workers, each a thread with its own list of
+ * works. A work goes to an idle worker, else to the submitting worker when
+ * a work queues another one, else to the worker with the fewest works. A
+ * worker whose list runs empty takes the oldest work of the worker with the
+ * most, so a slow work holds up nothing that another worker could run. On
+ * this single core the pool does not add throughput; it keeps short works
+ * from waiting for a long one that sleeps on the bus.
+ *
+ * Delayed works wait on the queue's delayed_list, sorted by timeout tick,
+ * and a single soft timer is armed for the first of them; it moves every
+ * work that is due to the workers at once. Works used to carry a timer
+ * each, initialised and detached on every submit. The timer is periodic:
+ * its handler only sets the period to the next work due and the timer
+ * code restarts it, or stops it when no work is left, since starting a
+ * timer from its own handler leaves it in the timer list as deactivated.
+ *
+ * The time each work_func takes is measured with ktime_get() and kept per
+ * work_func, not in the rt_work, which the work may have freed by then.
+ * "list_workqueue" prints it.
  */
 
 #include <rthw.h>
 #include <rtthread.h>
 #include <rtdevice.h>
 #include <workqueue.h>
+#include <ktimer.h>
 
 #ifdef RT_USING_HEAP
 
-static void _delayed_work_timeout_handler(void *parameter);
+static rt_list_t _workqueue_list = RT_LIST_OBJECT_INIT(_workqueue_list);
 
-rt_inline rt_err_t _workqueue_work_completion(struct rt_workqueue *queue)
+rt_inline int _workqueue_tick_due(rt_tick_t tick, rt_tick_t now)
 {
-    rt_err_t result;
+    return (rt_int32_t)(now - tick) >= 0;
+}
 
-    rt_enter_critical();
-    while (1)
+rt_inline void _workqueue_work_completion(struct rt_workqueue *queue)
+{
+    rt_base_t level;
+    rt_uint16_t waiters;
+
+    /* one release per waiter, taken even if the waiter is not asleep yet */
+    level = rt_hw_interrupt_disable();
+    waiters = queue->sync_waiters;
+    queue->sync_waiters = 0;
+    rt_hw_interrupt_enable(level);
+
+    while (waiters--)
+    {
+        rt_sem_release(&(queue->sem));
+    }
+}
+
+/* the worker running work, with interrupts disabled */
+static struct rt_workqueue_worker *_workqueue_running(struct rt_workqueue *queue, struct rt_work *work)
+{
+    int i;
+
+    for (i = 0; i < queue->worker_count; i++)
     {
-        /* try to take condition semaphore */
-        result = rt_sem_trytake(&(queue->sem));
-        if (result == -RT_ETIMEOUT)
+        if (queue->worker[i].work_current == work)
         {
-            /* it's timeout, release this semaphore */
-            rt_sem_release(&(queue->sem));
+            return &(queue->worker[i]);
         }
-        else if (result == RT_EOK)
+    }
+
+    return RT_NULL;
+}
+
+static int _workqueue_load(struct rt_workqueue_worker *worker)
+{
+    return rt_list_len(&(worker->work_list)) + (worker->work_current != RT_NULL);
+}
+
+/* queue work on a worker, with interrupts disabled; returns the workers to wake */
+static rt_uint32_t _workqueue_queue(struct rt_workqueue *queue, struct rt_work *work)
+{
+    struct rt_workqueue_worker *worker = RT_NULL;
+    struct rt_workqueue_worker *least = RT_NULL;
+    rt_thread_t self;
+    int i, n, load, least_load = 0;
+
+    if (queue->worker_count == 1)
+    {
+        worker = queue->worker;
+    }
+    else
+    {
+        self = rt_interrupt_get_nest() ? RT_NULL : rt_thread_self();
+        for (i = 0; i < queue->worker_count && worker == RT_NULL; i++)
         {
-            /* keep the sem value = 0 */
-            result = RT_EOK;
-            break;
+            n = (queue->worker_next + i) % queue->worker_count;
+            if (queue->worker[n].idle)
+            {
+                worker = &(queue->worker[n]);
+            }
+            else if (queue->worker[n].work_thread == self)
+            {
+                least = &(queue->worker[n]);
+                least_load = -1;
+            }
+            else if ((load = _workqueue_load(&(queue->worker[n]))) < least_load || least == RT_NULL)
+            {
+                least = &(queue->worker[n]);
+                least_load = load;
+            }
         }
-        else
+        if (worker == RT_NULL)
+        {
+            worker = least;
+        }
+        queue->worker_next = (worker - queue->worker + 1) % queue->worker_count;
+    }
+
+    rt_list_insert_before(&(worker->work_list), &(work->list));
+    work->flags |= RT_WORK_STATE_PENDING;
+
+    if (worker->idle)
+    {
+        worker->idle = 0;
+        return 1 << (worker - queue->worker);
+    }
+
+    return 0;
+}
+
+static void _workqueue_wake(struct rt_workqueue *queue, rt_uint32_t wake)
+{
+    int i;
+
+    for (i = 0; wake; i++, wake >>= 1)
+    {
+        if (wake & 1)
+        {
+            rt_sem_release(&(queue->worker[i].wakeup));
+        }
+    }
+}
+
+/* the next work for worker, its own or the oldest of the busiest other one */
+static struct rt_work *_workqueue_take(struct rt_workqueue_worker *worker)
+{
+    struct rt_workqueue *queue = worker->queue;
+    struct rt_workqueue_worker *victim = RT_NULL;
+    rt_list_t *list = &(worker->work_list);
+    unsigned int i, len, most = 0;
+    struct rt_work *work;
+
+    if (rt_list_isempty(list))
+    {
+        for (i = 0; i < queue->worker_count; i++)
+        {
+            len = rt_list_len(&(queue->worker[i].work_list));
+            if (len > most)
+            {
+                victim = &(queue->worker[i]);
+                most = len;
+            }
+        }
+        if (victim == RT_NULL)
+        {
+            return RT_NULL;
+        }
+        list = &(victim->work_list);
+        worker->steal_count++;
+    }
+
+    work = rt_list_entry(list->next, struct rt_work, list);
+    rt_list_remove(&(work->list));
+
+    return work;
+}
+
+static void _workqueue_account(struct rt_workqueue_worker *worker,
+                               void (*work_func)(struct rt_work *work, void *work_data), rt_int64_t ns)
+{
+    struct rt_workqueue *queue = worker->queue;
+    struct rt_work_stat *stat;
+    rt_base_t level;
+    int i;
+
+    if (ns < 0)
+    {
+        ns = 0;
+    }
+
+    level = rt_hw_interrupt_disable();
+    worker->run_count++;
+    worker->busy_ns += ns;
+
+    for (i = 0; i < RT_WORKQUEUE_STAT_FUNCS - 1; i++)
+    {
+        stat = &(queue->stat[i]);
+        if (stat->work_func == work_func || stat->work_func == RT_NULL)
         {
-            result = -RT_ERROR;
             break;
         }
     }
-    rt_exit_critical();
+    stat = &(queue->stat[i]);
+    if (i < RT_WORKQUEUE_STAT_FUNCS - 1)
+    {
+        stat->work_func = work_func;
+    }
+    stat->run_count++;
+    stat->total_ns += ns;
+    if (ns > stat->max_ns)
+    {
+        stat->max_ns = ns > 0xffffffff ? 0xffffffff : ns;
+    }
+    rt_hw_interrupt_enable(level);
 
-    return result;
+#if RT_WORKQUEUE_SLOW_WORK_MS > 0
+    if (ns > (rt_int64_t)RT_WORKQUEUE_SLOW_WORK_MS * 1000000)
+    {
+        rt_kprintf("workqueue %s: work %p ran %d ms\n", queue->name, work_func,
+                   (int)(ns / 1000000));
+    }
+#endif
 }
 
 static void _workqueue_thread_entry(void *parameter)
@@ -53,43 +236,134 @@ static void _workqueue_thread_entry(void *parameter)
     rt_base_t level;
     struct rt_work *work;
     struct rt_workqueue *queue;
+    struct rt_workqueue_worker *worker;
+    void (*work_func)(struct rt_work *work, void *work_data);
+    rt_int64_t start;
 
-    queue = (struct rt_workqueue *) parameter;
-    RT_ASSERT(queue != RT_NULL);
+    worker = (struct rt_workqueue_worker *) parameter;
+    RT_ASSERT(worker != RT_NULL);
+    queue = worker->queue;
 
     while (1)
     {
-        if (rt_list_isempty(&(queue->work_list)))
+        level = rt_hw_interrupt_disable();
+        work = _workqueue_take(worker);
+        if (work == RT_NULL)
         {
-            /* no software timer exist, suspend self. */
-            rt_thread_suspend(rt_thread_self());
-            rt_schedule();
+            /* nothing here or elsewhere, sleep until a work is queued on us */
+            worker->idle = 1;
+            rt_hw_interrupt_enable(level);
+            rt_sem_take(&(worker->wakeup), RT_WAITING_FOREVER);
+            continue;
         }
 
         /* we have work to do with. */
-        level = rt_hw_interrupt_disable();
-        work = rt_list_entry(queue->work_list.next, struct rt_work, list);
-        rt_list_remove(&(work->list));
-        queue->work_current = work;
+        worker->work_current = work;
         work->flags &= ~RT_WORK_STATE_PENDING;
         work->workqueue = RT_NULL;
+        work_func = work->work_func;
         rt_hw_interrupt_enable(level);
 
         /* do work */
-        work->work_func(work, work->work_data);
+        start = ktime_get();
+        work_func(work, work->work_data);
+        start = ktime_get() - start;
+
         level = rt_hw_interrupt_disable();
         /* clean current work */
-        queue->work_current = RT_NULL;
+        worker->work_current = RT_NULL;
         rt_hw_interrupt_enable(level);
 
+        _workqueue_account(worker, work_func, start);
+
         /* ack work completion */
         _workqueue_work_completion(queue);
     }
 }
 
+/* set the timer period to the first delayed work, with interrupts disabled */
+static void _workqueue_set_timer(struct rt_workqueue *queue, struct rt_work *first)
+{
+    rt_tick_t now, ticks;
+
+    now = rt_tick_get();
+    ticks = _workqueue_tick_due(first->timeout_tick, now) ? 1 : first->timeout_tick - now;
+    rt_timer_control(&(queue->timer), RT_TIMER_CTRL_SET_TIME, &ticks);
+    queue->timer_tick = first->timeout_tick;
+    queue->timer_armed = 1;
+}
+
+/* (re)arm the queue timer for the first delayed work, with interrupts disabled */
+static void _workqueue_arm_timer(struct rt_workqueue *queue)
+{
+    struct rt_work *first;
+
+    if (rt_list_isempty(&(queue->delayed_list)))
+    {
+        /* a timer left running finds nothing due and stops */
+        return;
+    }
+
+    first = rt_list_entry(queue->delayed_list.next, struct rt_work, list);
+    if (queue->timer_armed && _workqueue_tick_due(queue->timer_tick, first->timeout_tick))
+    {
+        return;
+    }
+
+    _workqueue_set_timer(queue, first);
+    rt_timer_start(&(queue->timer));
+}
+
+static void _workqueue_timeout_handler(void *parameter)
+{
+    struct rt_workqueue *queue;
+    struct rt_work *work;
+    rt_uint32_t wake = 0;
+    rt_base_t level;
+    rt_tick_t now;
+
+    queue = (struct rt_workqueue *)parameter;
+    level = rt_hw_interrupt_disable();
+    now = rt_tick_get();
+
+    while (!rt_list_isempty(&(queue->delayed_list)))
+    {
+        work = rt_list_entry(queue->delayed_list.next, struct rt_work, list);
+        if (!_workqueue_tick_due(work->timeout_tick, now))
+        {
+            break;
+        }
+
+        rt_list_remove(&(work->list));
+        work->flags &= ~RT_WORK_STATE_SUBMITTING;
+        work->type &= ~RT_WORK_TYPE_DELAYED;
+
+        /* a work still running from its last submit is dropped, as before */
+        if (_workqueue_running(queue, work) == RT_NULL)
+        {
+            wake |= _workqueue_queue(queue, work);
+        }
+    }
+
+    /* the timer code restarts the timer with the new period when we return */
+    if (rt_list_isempty(&(queue->delayed_list)))
+    {
+        queue->timer_armed = 0;
+        rt_timer_stop(&(queue->timer));
+    }
+    else
+    {
+        _workqueue_set_timer(queue, rt_list_entry(queue->delayed_list.next, struct rt_work, list));
+    }
+    rt_hw_interrupt_enable(level);
+
+    _workqueue_wake(queue, wake);
+}
+
 static rt_err_t _workqueue_submit_work(struct rt_workqueue *queue, struct rt_work *work)
 {
     rt_base_t level;
+    rt_uint32_t wake;
 
     level = rt_hw_interrupt_disable();
     if (work->flags & RT_WORK_STATE_PENDING)
@@ -98,7 +372,7 @@ static rt_err_t _workqueue_submit_work(struct rt_workqueue *queue, struct rt_wor
         return -RT_EBUSY;
     }
 
-    if (queue->work_current == work)
+    if (_workqueue_running(queue, work))
     {
         rt_hw_interrupt_enable(level);
         return -RT_EBUSY;
@@ -106,23 +380,12 @@ static rt_err_t _workqueue_submit_work(struct rt_workqueue *queue, struct rt_wor
 
     /* NOTE: the work MUST be initialized firstly */
     rt_list_remove(&(work->list));
+    work->flags &= ~RT_WORK_STATE_SUBMITTING;
 
-    rt_list_insert_after(queue->work_list.prev, &(work->list));
-    work->flags |= RT_WORK_STATE_PENDING;
+    wake = _workqueue_queue(queue, work);
+    rt_hw_interrupt_enable(level);
 
-    /* whether the workqueue is doing work */
-    if (queue->work_current == RT_NULL)
-    {
-        /* resume work thread */
-        rt_thread_resume(queue->work_thread);
-        rt_hw_interrupt_enable(level);
-
-        rt_schedule();
-    }
-    else
-    {
-        rt_hw_interrupt_enable(level);
-    }
+    _workqueue_wake(queue, wake);
 
     return RT_EOK;
 }
@@ -132,7 +395,7 @@ static rt_err_t _workqueue_cancel_work(struct rt_workqueue *queue, struct rt_wor
     rt_base_t level;
 
     level = rt_hw_interrupt_disable();
-    if (queue->work_current == work)
+    if (_workqueue_running(queue, work))
     {
         rt_hw_interrupt_enable(level);
         return -RT_EBUSY;
@@ -147,43 +410,39 @@ static rt_err_t _workqueue_cancel_work(struct rt_workqueue *queue, struct rt_wor
 static rt_err_t _workqueue_cancel_delayed_work(struct rt_work *work)
 {
     rt_base_t level;
-    int ret = RT_EOK;
 
+    level = rt_hw_interrupt_disable();
     if (!work->workqueue)
     {
-        ret = -RT_EINVAL;
-        goto __exit;
+        rt_hw_interrupt_enable(level);
+        return -RT_EINVAL;
     }
 
-    if (work->flags & RT_WORK_STATE_PENDING)
-    {
-        /* Remove from the queue if already submitted */
-        ret = _workqueue_cancel_work(work->workqueue, work);
-        if (ret)
-        {
-            goto __exit;
-        }
-    }
-    else
-    {
-        if (work->flags & RT_WORK_STATE_SUBMITTING)
-        {
-            level = rt_hw_interrupt_disable();
-            rt_timer_stop(&(work->timer));
-            rt_timer_detach(&(work->timer));
-            work->flags &= ~RT_WORK_STATE_SUBMITTING;
-            rt_hw_interrupt_enable(level);
-        }
-    }
+    /* pending on a worker or waiting on the delayed list, never running */
+    rt_list_remove(&(work->list));
 
-    level = rt_hw_interrupt_disable();
     /* Detach from workqueue */
     work->workqueue = RT_NULL;
-    work->flags &= ~(RT_WORK_STATE_PENDING);
+    work->flags &= ~(RT_WORK_STATE_PENDING | RT_WORK_STATE_SUBMITTING);
     rt_hw_interrupt_enable(level);
 
-__exit:
-    return ret;
+    return RT_EOK;
+}
+
+static void _workqueue_insert_delayed(struct rt_workqueue *queue, struct rt_work *work)
+{
+    rt_list_t *node;
+
+    /* after the last one due no later, new works are mostly the latest */
+    for (node = queue->delayed_list.prev; node != &(queue->delayed_list); node = node->prev)
+    {
+        if (_workqueue_tick_due(rt_list_entry(node, struct rt_work, list)->timeout_tick,
+                                work->timeout_tick))
+        {
+            break;
+        }
+    }
+    rt_list_insert_after(node, &(work->list));
 }
 
 static rt_err_t _workqueue_submit_delayed_work(struct rt_workqueue *queue,
@@ -209,77 +468,137 @@ static rt_err_t _workqueue_submit_delayed_work(struct rt_workqueue *queue,
         }
     }
 
-    level = rt_hw_interrupt_disable();
-    /* Attach workqueue so the timeout callback can submit it */
-    work->workqueue = queue;
-    rt_hw_interrupt_enable(level);
-
     if (!ticks)
     {
         /* Submit work if no ticks is 0 */
-        ret = _workqueue_submit_work(work->workqueue, work);
+        level = rt_hw_interrupt_disable();
+        work->workqueue = queue;
+        rt_hw_interrupt_enable(level);
+        ret = _workqueue_submit_work(queue, work);
     }
     else
     {
+        RT_ASSERT(ticks < RT_TICK_MAX / 2);
+
         level = rt_hw_interrupt_disable();
-        /* Add timeout */
+        work->workqueue = queue;
+        work->timeout_tick = rt_tick_get() + ticks;
+        /* a work pending on a worker waits for the new time instead */
+        rt_list_remove(&(work->list));
+        work->flags &= ~RT_WORK_STATE_PENDING;
         work->flags |= RT_WORK_STATE_SUBMITTING;
-        rt_timer_init(&(work->timer), "work", _delayed_work_timeout_handler, work, ticks,
-                      RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
+        _workqueue_insert_delayed(queue, work);
+        _workqueue_arm_timer(queue);
         rt_hw_interrupt_enable(level);
-        rt_timer_start(&(work->timer));
     }
 
 __exit:
     return ret;
 }
 
-static void _delayed_work_timeout_handler(void *parameter)
+struct rt_workqueue *rt_workqueue_create_pool(const char *name, rt_uint16_t stack_size,
+        rt_uint8_t priority, rt_uint8_t threads)
 {
-    struct rt_work *delayed_work;
+    struct rt_workqueue *queue = RT_NULL;
+    struct rt_workqueue_worker *worker;
+    char thread_name[RT_NAME_MAX];
     rt_base_t level;
+    int i;
 
-    delayed_work = (struct rt_work *)parameter;
-    level = rt_hw_interrupt_disable();
-    rt_timer_stop(&(delayed_work->timer));
-    rt_timer_detach(&(delayed_work->timer));
-    delayed_work->flags &= ~RT_WORK_STATE_SUBMITTING;
-    delayed_work->type &= ~RT_WORK_TYPE_DELAYED;
-    rt_hw_interrupt_enable(level);
-    _workqueue_submit_work(delayed_work->workqueue, delayed_work);
-}
+    RT_ASSERT(threads >= 1 && threads <= RT_WORKQUEUE_WORKERS_MAX);
 
-struct rt_workqueue *rt_workqueue_create(const char *name, rt_uint16_t stack_size, rt_uint8_t priority)
-{
-    struct rt_workqueue *queue = RT_NULL;
+    queue = (struct rt_workqueue *)RT_KERNEL_MALLOC(sizeof(struct rt_workqueue) +
+            threads * sizeof(struct rt_workqueue_worker));
+    if (queue == RT_NULL)
+    {
+        return RT_NULL;
+    }
+
+    rt_memset(queue, 0, sizeof(struct rt_workqueue) + threads * sizeof(struct rt_workqueue_worker));
+    rt_strncpy(queue->name, name, RT_NAME_MAX - 1);
+    rt_sem_init(&(queue->sem), "wqueue", 0, RT_IPC_FLAG_FIFO);
+    rt_list_init(&(queue->delayed_list));
+    rt_timer_init(&(queue->timer), "wqueue", _workqueue_timeout_handler, queue, 1,
+                  RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_SOFT_TIMER);
+    queue->worker = (struct rt_workqueue_worker *)(queue + 1);
+    queue->worker_count = threads;
 
-    queue = (struct rt_workqueue *)RT_KERNEL_MALLOC(sizeof(struct rt_workqueue));
-    if (queue != RT_NULL)
+    for (i = 0; i < threads; i++)
     {
-        /* initialize work list */
-        rt_list_init(&(queue->work_list));
-        queue->work_current = RT_NULL;
-        rt_sem_init(&(queue->sem), "wqueue", 0, RT_IPC_FLAG_FIFO);
+        worker = &(queue->worker[i]);
+        rt_list_init(&(worker->work_list));
+        rt_sem_init(&(worker->wakeup), "wqwake", 0, RT_IPC_FLAG_FIFO);
+        worker->queue = queue;
 
-        /* create the work thread */
-        queue->work_thread = rt_thread_create(name, _workqueue_thread_entry, queue, stack_size, priority, 10);
-        if (queue->work_thread == RT_NULL)
+        /* create the work thread, numbered in a pool */
+        if (threads > 1)
         {
+            rt_snprintf(thread_name, sizeof(thread_name), "%.*s%d", RT_NAME_MAX - 3, name, i);
+        }
+        else
+        {
+            rt_snprintf(thread_name, sizeof(thread_name), "%s", name);
+        }
+        worker->work_thread = rt_thread_create(thread_name, _workqueue_thread_entry, worker,
+                                               stack_size, priority, 10);
+        if (worker->work_thread == RT_NULL)
+        {
+            while (i >= 0)
+            {
+                if (queue->worker[i].work_thread)
+                {
+                    rt_thread_delete(queue->worker[i].work_thread);
+                }
+                rt_sem_detach(&(queue->worker[i].wakeup));
+                i--;
+            }
+            rt_timer_detach(&(queue->timer));
+            rt_sem_detach(&(queue->sem));
             RT_KERNEL_FREE(queue);
             return RT_NULL;
         }
+    }
 
-        rt_thread_startup(queue->work_thread);
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&_workqueue_list, &(queue->list));
+    rt_hw_interrupt_enable(level);
+
+    for (i = 0; i < threads; i++)
+    {
+        rt_thread_startup(queue->worker[i].work_thread);
     }
 
     return queue;
 }
 
+struct rt_workqueue *rt_workqueue_create(const char *name, rt_uint16_t stack_size, rt_uint8_t priority)
+{
+    return rt_workqueue_create_pool(name, stack_size, priority, 1);
+}
+
 rt_err_t rt_workqueue_destroy(struct rt_workqueue *queue)
 {
+    rt_base_t level;
+    int i;
+
     RT_ASSERT(queue != RT_NULL);
 
-    rt_thread_delete(queue->work_thread);
+    level = rt_hw_interrupt_disable();
+    rt_list_remove(&(queue->list));
+    rt_hw_interrupt_enable(level);
+
+    rt_timer_detach(&(queue->timer));
+
+    /* off the semaphore lists before the threads go to the defunct list */
+    rt_enter_critical();
+    for (i = 0; i < queue->worker_count; i++)
+    {
+        rt_sem_detach(&(queue->worker[i].wakeup));
+        rt_thread_delete(queue->worker[i].work_thread);
+    }
+    rt_exit_critical();
+
+    rt_sem_detach(&(queue->sem));
     RT_KERNEL_FREE(queue);
 
     return RT_EOK;
@@ -316,11 +635,13 @@ rt_err_t rt_workqueue_submit_work(struct rt_workqueue *queue, struct rt_work *wo
 rt_err_t rt_workqueue_critical_work(struct rt_workqueue *queue, struct rt_work *work)
 {
     rt_base_t level;
+    rt_uint32_t wake;
+
     RT_ASSERT(queue != RT_NULL);
     RT_ASSERT(work != RT_NULL);
 
     level = rt_hw_interrupt_disable();
-    if (queue->work_current == work)
+    if (_workqueue_running(queue, work))
     {
         rt_hw_interrupt_enable(level);
         return -RT_EBUSY;
@@ -328,19 +649,12 @@ rt_err_t rt_workqueue_critical_work(struct rt_workqueue *queue, struct rt_work *
 
     /* NOTE: the work MUST be initialized firstly */
     rt_list_remove(&(work->list));
+    work->flags &= ~RT_WORK_STATE_SUBMITTING;
 
-    rt_list_insert_after(queue->work_list.prev, &(work->list));
-    if (queue->work_current == RT_NULL)
-    {
-        rt_hw_interrupt_enable(level);
-        /* resume work thread */
-        rt_thread_resume(queue->work_thread);
-        rt_schedule();
-    }
-    else
-    {
-        rt_hw_interrupt_enable(level);
-    }
+    wake = _workqueue_queue(queue, work);
+    rt_hw_interrupt_enable(level);
+
+    _workqueue_wake(queue, wake);
 
     return RT_EOK;
 }
@@ -368,16 +682,20 @@ rt_err_t rt_workqueue_cancel_work_sync(struct rt_workqueue *queue, struct rt_wor
     RT_ASSERT(work != RT_NULL);
 
     level = rt_hw_interrupt_disable();
-    if (queue->work_current == work) /* it's current work in the queue */
+    while (_workqueue_running(queue, work)) /* it's current work of a worker */
     {
-        /* wait for work completion */
+        /* wait for a work completion and look again */
+        queue->sync_waiters++;
+        rt_hw_interrupt_enable(level);
         rt_sem_take(&(queue->sem), RT_WAITING_FOREVER);
+        level = rt_hw_interrupt_disable();
     }
-    else
+    rt_list_remove(&(work->list));
+    if (work->flags & RT_WORK_STATE_SUBMITTING)
     {
-        rt_list_remove(&(work->list));
+        work->workqueue = RT_NULL;
     }
-    work->flags &= ~RT_WORK_STATE_PENDING;
+    work->flags &= ~(RT_WORK_STATE_PENDING | RT_WORK_STATE_SUBMITTING);
     rt_hw_interrupt_enable(level);
 
     return RT_EOK;
@@ -386,15 +704,27 @@ rt_err_t rt_workqueue_cancel_work_sync(struct rt_workqueue *queue, struct rt_wor
 rt_err_t rt_workqueue_cancel_all_work(struct rt_workqueue *queue)
 {
     struct rt_list_node *node, *next;
+    struct rt_work *work;
+    rt_list_t *list;
+    rt_base_t level;
+    int i;
+
     RT_ASSERT(queue != RT_NULL);
 
-    rt_enter_critical();
-    for (node = queue->work_list.next; node != &(queue->work_list); node = next)
+    level = rt_hw_interrupt_disable();
+    for (i = 0; i <= queue->worker_count; i++)
     {
-        next = node->next;
-        rt_list_remove(node);
+        list = i < queue->worker_count ? &(queue->worker[i].work_list) : &(queue->delayed_list);
+        for (node = list->next; node != list; node = next)
+        {
+            next = node->next;
+            work = rt_list_entry(node, struct rt_work, list);
+            rt_list_remove(node);
+            work->workqueue = RT_NULL;
+            work->flags &= ~(RT_WORK_STATE_PENDING | RT_WORK_STATE_SUBMITTING);
+        }
     }
-    rt_exit_critical();
+    rt_hw_interrupt_enable(level);
 
     return RT_EOK;
 }
@@ -425,12 +755,74 @@ int rt_work_sys_workqueue_init(void)
         return 0;
     }
 
-    sys_workq = rt_workqueue_create("sys_work", RT_SYSTEM_WORKQUEUE_STACKSIZE,
-                                    RT_SYSTEM_WORKQUEUE_PRIORITY);
+    sys_workq = rt_workqueue_create_pool("sys_work", RT_SYSTEM_WORKQUEUE_STACKSIZE,
+                                         RT_SYSTEM_WORKQUEUE_PRIORITY,
+                                         RT_SYSTEM_WORKQUEUE_THREADS);
 
     return RT_EOK;
 }
 
 INIT_DEVICE_EXPORT(rt_work_sys_workqueue_init);
 #endif
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int list_workqueue(int argc, const char **argv)
+{
+    struct rt_workqueue_worker worker[RT_WORKQUEUE_WORKERS_MAX];
+    struct rt_work_stat stat[RT_WORKQUEUE_STAT_FUNCS];
+    int queued[RT_WORKQUEUE_WORKERS_MAX];
+    struct rt_workqueue *queue;
+    rt_list_t *node;
+    rt_base_t level;
+    int count, delayed, i;
+
+    /* workqueues are not destroyed while the scheduler is locked */
+    rt_enter_critical();
+    for (node = _workqueue_list.next; node != &_workqueue_list; node = node->next)
+    {
+        queue = rt_list_entry(node, struct rt_workqueue, list);
+
+        level = rt_hw_interrupt_disable();
+        count = queue->worker_count;
+        rt_memcpy(worker, queue->worker, count * sizeof(worker[0]));
+        rt_memcpy(stat, queue->stat, sizeof(stat));
+        for (i = 0; i < count; i++)
+        {
+            queued[i] = rt_list_len(&(queue->worker[i].work_list));
+        }
+        delayed = rt_list_len(&(queue->delayed_list));
+        rt_hw_interrupt_enable(level);
+
+        rt_kprintf("%s: %d thread%s, %d delayed\n", queue->name, count, count > 1 ? "s" : "", delayed);
+        for (i = 0; i < count; i++)
+        {
+            rt_kprintf("  %-*.*s %s queued %d run %u stolen %u busy %u ms\n",
+                       RT_NAME_MAX, RT_NAME_MAX, worker[i].work_thread->name,
+                       worker[i].work_current ? "running" : "idle   ",
+                       queued[i], worker[i].run_count,
+                       worker[i].steal_count, (rt_uint32_t)(worker[i].busy_ns / 1000000));
+        }
+        for (i = 0; i < RT_WORKQUEUE_STAT_FUNCS && stat[i].run_count; i++)
+        {
+            if (stat[i].work_func)
+            {
+                rt_kprintf("  work %p", stat[i].work_func);
+            }
+            else
+            {
+                rt_kprintf("  other works");
+            }
+            rt_kprintf(" run %u avg %u us max %u us\n", stat[i].run_count,
+                       (rt_uint32_t)(stat[i].total_ns / stat[i].run_count / 1000),
+                       stat[i].max_ns / 1000);
+        }
+    }
+    rt_exit_critical();
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(list_workqueue, list workqueue threads and work times)
+#endif
 #endif
@@ -25,6 +25,10 @@
 #include <backtrace.h>
 #endif
 
+#ifdef CONFIG_RT_USING_DEFERRED_LOG
+#include <klog.h>
+#endif
+
 static __cache_way_t LockICacheWays[MAX_ICACHE_LOCKED_WAY];
 static __cache_way_t LockDCacheWays[MAX_DCACHE_LOCKED_WAY];
 //static __u32 sram_stack[64];
@@ -2644,6 +2648,36 @@ __u8 esKRNL_MboxPostOpt(__hdle pevent, __u32 msg, __u8 opt)
     return 0;
 }
 
+#ifdef CONFIG_RT_USING_DEFERRED_LOG
+/*
+ * Queue printk() for the klog thread. The level filter below runs on the
+ * format string instead of the text: a literal "<n>" is checked here, the
+ * log macros checked their "<%d>" before calling.
+ */
+static int printk_defer(const char *fmt, va_list args)
+{
+#ifdef CONFIG_DYNAMIC_LOG_LEVEL_SUPPORT
+    if (fmt[0] == '<' && fmt[1] >= '0' && fmt[1] <= '7' && fmt[2] == '>')
+    {
+        if (get_log_level() < (fmt[1] - '0'))
+        {
+            return 0;
+        }
+    }
+    else if (fmt[0] != '<' || fmt[1] != '%')
+    {
+        if (get_log_level() <= (OPTION_LOG_LEVEL_CLOSE))
+        {
+            return 0;
+        }
+    }
+    return rt_klog_vprintf(RT_KLOG_LEVEL, fmt, args);
+#else
+    return rt_klog_vprintf(0, fmt, args);
+#endif
+}
+#endif
+
 int printk(const char *fmt, ...)
 {
     va_list args;
@@ -2654,6 +2688,13 @@ int printk(const char *fmt, ...)
     register rt_base_t level;
 
     va_start(args, fmt);
+#ifdef CONFIG_RT_USING_DEFERRED_LOG
+    if (printk_defer(fmt, args) == 0)
+    {
+        va_end(args);
+        return 0;
+    }
+#endif
     level = rt_hw_interrupt_disable();
     rt_enter_critical();
 
@@ -14,6 +14,7 @@
 * Descript: elf file loader handing functions.
 * Update  : date                auther      ver     notes
 *           2011-4-8 13:24:52   Sunny       1.0     Create this file.
+*           2026-10-19          Melis       1.1     read the section header table once at open.
 *********************************************************************************************************
 */
 #include "loader.h"
@@ -38,16 +39,14 @@ open_elf_t *LDR_LoadELFFile(__hdle hFile)
 {
     open_elf_t       *pOPENELF;
     __elf32_head_t    ELFHdr;       //52 byte
-    __elf32_shead_t   SecHdr;       //40 byte
+    __elf32_shead_t  *pSecHdr;      //section header table
     __magic_common_t  Magic;        //64 byte
     rt_uint32_t       MagicIdx;
-    rt_uint32_t       Offset;
     rt_uint32_t       FileType;
     rt_uint32_t       Idx;
     char             *shstrtbl;
 
     rt_memset(&ELFHdr, 0x00, sizeof(__elf32_head_t));
-    rt_memset(&SecHdr, 0x00, sizeof(__elf32_shead_t));
     rt_memset(&Magic,  0x00, sizeof(__magic_common_t));
 
     //seek to file begin
@@ -61,33 +60,50 @@ open_elf_t *LDR_LoadELFFile(__hdle hFile)
         __err("invalid elf file to loader!");
         return NULL;
     }
+    if (ELFHdr.shentsize != sizeof(__elf32_shead_t) ||
+        ELFHdr.shnum == 0 || ELFHdr.shstrndx >= ELFHdr.shnum)
+    {
+        __err("invalid elf section header table");
+        return NULL;
+    }
+
+    //load the whole section header table with one read,
+    //every later section header access is served from it.
+    pSecHdr = rt_malloc(ELFHdr.shnum * sizeof(__elf32_shead_t));
+    if (pSecHdr == NULL)
+    {
+        __err("allocate buffer for elf section header table failed");
+        return NULL;
+    }
+    esFSYS_fseek(hFile, ELFHdr.shoff, FSYS_SEEK_SET);
+    if (esFSYS_fread(pSecHdr, sizeof(__elf32_shead_t), ELFHdr.shnum, hFile) != ELFHdr.shnum)
+    {
+        __err("read elf section header table failed");
+        rt_free(pSecHdr);
+        return NULL;
+    }
 
     //load string table section
-    Offset = ELFHdr.shoff + ELFHdr.shentsize * ELFHdr.shstrndx;
-    esFSYS_fseek(hFile, Offset, FSYS_SEEK_SET);
-    esFSYS_fread(&SecHdr, ELFHdr.shentsize, 1, hFile);
-    shstrtbl = rt_malloc(SecHdr.size);
+    shstrtbl = rt_malloc(pSecHdr[ELFHdr.shstrndx].size);
     if (shstrtbl == NULL)
     {
         __err("allocate buffer for elf file string table failed");
+        rt_free(pSecHdr);
         return NULL;
     }
 
     //load string table
-    esFSYS_fseek(hFile, SecHdr.offset, FSYS_SEEK_SET);
-    esFSYS_fread((void *)shstrtbl, SecHdr.size, 1, hFile);
+    esFSYS_fseek(hFile, pSecHdr[ELFHdr.shstrndx].offset, FSYS_SEEK_SET);
+    esFSYS_fread((void *)shstrtbl, pSecHdr[ELFHdr.shstrndx].size, 1, hFile);
 
     //find magic section
     MagicIdx = LDR_INVALID_INDEX;
     FileType = LDR_INVALID_FILE;
     for (Idx = 0; Idx < ELFHdr.shnum; Idx++)
     {
-        Offset = ELFHdr.shoff + ELFHdr.shentsize * Idx;
-        esFSYS_fseek(hFile, Offset, FSYS_SEEK_SET);
-        esFSYS_fread(&SecHdr, ELFHdr.shentsize, 1, hFile);
-        if (rt_strncmp(&shstrtbl[SecHdr.name], "MAGIC", 5) == 0)
+        if (rt_strncmp(&shstrtbl[pSecHdr[Idx].name], "MAGIC", 5) == 0)
         {
-            esFSYS_fseek(hFile, SecHdr.offset, FSYS_SEEK_SET);
+            esFSYS_fseek(hFile, pSecHdr[Idx].offset, FSYS_SEEK_SET);
             esFSYS_fread(&Magic, sizeof(Magic), 1, hFile);
             if (rt_strncmp(Magic.magic, "ePDK.mod", 8) == 0)
             {
@@ -110,6 +126,7 @@ open_elf_t *LDR_LoadELFFile(__hdle hFile)
     if (MagicIdx == LDR_INVALID_INDEX || FileType == LDR_INVALID_FILE)
     {
         __err("invalid elf file to loader");
+        rt_free(pSecHdr);
         return NULL;
     }
 
@@ -118,6 +135,7 @@ open_elf_t *LDR_LoadELFFile(__hdle hFile)
     if (pOPENELF == NULL)
     {
         __err("allocate memory for open elf file failed");
+        rt_free(pSecHdr);
         return NULL;
     }
 
@@ -128,6 +146,7 @@ open_elf_t *LDR_LoadELFFile(__hdle hFile)
     pOPENELF->shoff       = ELFHdr.shoff;
     pOPENELF->MagicIdx    = MagicIdx;
     pOPENELF->SecNum      = ELFHdr.shnum;
+    pOPENELF->pSecHdr     = pSecHdr;
 
     //load stardard elf file succeeded
     return pOPENELF;
@@ -151,19 +170,13 @@ open_elf_t *LDR_LoadELFFile(__hdle hFile)
 rt_int32_t LDR_GetELFFileSecROMHdr(open_elf_t *pOPENELF, rt_uint32_t Index,
                                    __section_rom_hdr_t *pROMHdr)
 {
-    __elf32_shead_t   SecHdr;   //40 byte
-    rt_uint32_t             Offset;
-
-    //load section header
-    Offset = pOPENELF->shoff + Index * sizeof(__elf32_shead_t);
-    esFSYS_fseek(pOPENELF->hFile, Offset, FSYS_SEEK_SET);
-    esFSYS_fread(&SecHdr, sizeof(__elf32_shead_t), 1, pOPENELF->hFile);
+    __elf32_shead_t  *pSecHdr = &pOPENELF->pSecHdr[Index];
 
     //initialize section rom header
-    pROMHdr->Size  = SecHdr.size;
-    pROMHdr->VAddr = SecHdr.addr;
-    pROMHdr->Type  = SecHdr.type;
-    pROMHdr->Flags = SecHdr.flags;
+    pROMHdr->Size  = pSecHdr->size;
+    pROMHdr->VAddr = pSecHdr->addr;
+    pROMHdr->Type  = pSecHdr->type;
+    pROMHdr->Flags = pSecHdr->flags;
 
     return EPDK_OK;
 }
@@ -185,17 +198,11 @@ rt_int32_t LDR_GetELFFileSecROMHdr(open_elf_t *pOPENELF, rt_uint32_t Index,
 */
 rt_int32_t LDR_GetELFFileSecData(open_elf_t *pOPENELF, rt_uint32_t Index, void *pData)
 {
-    __elf32_shead_t   SecHdr;   //40 byte
-    rt_uint32_t             Offset;
-
-    //load section header
-    Offset = pOPENELF->shoff + Index * sizeof(__elf32_shead_t);
-    esFSYS_fseek(pOPENELF->hFile, Offset, FSYS_SEEK_SET);
-    esFSYS_fread(&SecHdr, sizeof(__elf32_shead_t), 1, pOPENELF->hFile);
+    __elf32_shead_t  *pSecHdr = &pOPENELF->pSecHdr[Index];
 
     //load section data
-    esFSYS_fseek(pOPENELF->hFile, SecHdr.offset, FSYS_SEEK_SET);
-    if (esFSYS_fread(pData, 1, SecHdr.size, pOPENELF->hFile) != SecHdr.size)
+    esFSYS_fseek(pOPENELF->hFile, pSecHdr->offset, FSYS_SEEK_SET);
+    if (esFSYS_fread(pData, 1, pSecHdr->size, pOPENELF->hFile) != pSecHdr->size)
     {
         __wrn("read section data failed");
         return EPDK_FAIL;
@@ -328,6 +335,10 @@ rt_int32_t LDR_UnloadFile(__hdle hLDR)
     esFSYS_fclose(pOPENELF->hFile);
 
     //release open elf structure
+    if (pOPENELF->pSecHdr)
+    {
+        rt_free(pOPENELF->pSecHdr);
+    }
     rt_free(pOPENELF);
 
     return EPDK_OK;
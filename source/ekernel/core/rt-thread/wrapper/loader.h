@@ -33,6 +33,7 @@ typedef struct __OPEN_ELF
     rt_uint32_t   shoff;          //section header offset
     rt_uint32_t   MagicIdx;       //index of magic section
     rt_uint32_t   SecNum;         //the number of sectiions
+    struct __ELF32SHEAD *pSecHdr; //section header table read at open, standard elf only
 } open_elf_t;
 
 //common magic section structure,
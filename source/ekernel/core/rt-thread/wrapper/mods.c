@@ -14,6 +14,7 @@
 * Descript: module loader handing functions.
 * Update  : date                auther      ver     notes
 *           2011-3-30 11:14:57  Sunny       1.0     Create this file.
+*           2026-10-19          Melis       1.1     install timing.
 *********************************************************************************************************
 */
 #include "mods.h"
@@ -24,6 +25,7 @@
 #include <sys_mems.h>
 #include <kconfig.h>
 #include <log.h>
+#include <ktimer.h>
 
 __krnl_xcb_t            *esXCBTbl[EPOS_id_mumber];
 #define  esMCBTbl       ((__module_mcb_t **)esXCBTbl)
@@ -483,6 +485,7 @@ __u32 esMODS_MInstall(const char *mfile, __u8 mode)
     __u32            flag;
     __u8             mid = 0;
     __s8             tmpfile[256] = {0};
+    int64_t          start = ktime_get();
 
     static __u8 b_boot_cfg = 0x00;
 
@@ -583,6 +586,16 @@ __u32 esMODS_MInstall(const char *mfile, __u8 mode)
         goto error;
     }
 
+    //allocate memory for module control block,
+    //before the id so the slot is claimed in the same critical section.
+    mcb = (__module_mcb_t *)rt_malloc(sizeof(__module_mcb_t));
+    if (mcb == (__module_mcb_t *)0)
+    {
+        __err("allocate memory for module control block failed");
+        goto error;
+    }
+    rt_memset(mcb, 0, sizeof(__module_mcb_t));
+
     //get module id, this process can't been interrupt.
     cpu_sr = rt_hw_interrupt_disable();
     mid = MODS_GetModuleID(&ModMagic);
@@ -598,20 +611,13 @@ __u32 esMODS_MInstall(const char *mfile, __u8 mode)
     {
         __log("check, module %s already installed.", mfile);
         rt_hw_interrupt_enable(cpu_sr);
+        rt_free((void *)mcb);
+        LDR_UnloadFile(hLDR);
         return mid;
     }
+    esMCBTbl[mid] = (__module_mcb_t *)mcb;
     rt_hw_interrupt_enable(cpu_sr);
 
-    //allocate memory for module control block
-    mcb = (__module_mcb_t *)rt_malloc(sizeof(__module_mcb_t));
-    if (mcb == (__module_mcb_t *)0)
-    {
-        __err("allocate memory for module control block failed");
-        goto error;
-    }
-    rt_memset(mcb, 0, sizeof(__module_mcb_t));
-
-    esMCBTbl[mid] = (__module_mcb_t *)mcb;
     //initialize module control block,
     //the module local heap have no any use,
     //all module use system heap to save a little memory.
@@ -640,18 +646,23 @@ __u32 esMODS_MInstall(const char *mfile, __u8 mode)
         goto error;
     }
 
+    mcb->LoadUs = (__u32)((ktime_get() - start) / 1000);
+
     //flush i-cache
     awos_arch_flush_icache();
 
     //notify module is been installed
+    start = ktime_get();
     if (MODS_NotifyInstall(mcb) != EPDK_OK)
     {
         __err("notify module [%s] been install failed", tmpfile);
         goto error;
     }
+    mcb->InitUs = (__u32)((ktime_get() - start) / 1000);
 
     //module install succeeded
     __log("module [%s] install succeeded", tmpfile);
+    __inf("module [%s]: load %d us, init %d us", tmpfile, mcb->LoadUs, mcb->InitUs);
     LDR_UnloadFile(hLDR);
     return mid;
 
@@ -999,3 +1010,21 @@ __s32 MODS_Exit(void)
 {
     return EPDK_OK;
 }
+
+static int cmd_lsmod(int argc, char **argv)
+{
+    __module_mcb_t *mcb;
+    __u32           mid;
+
+    rt_kprintf("mid  load(us)  init(us)  file\n");
+    for (mid = EPOS_smid_min; mid <= EPOS_smid_max; mid++)
+    {
+        mcb = esMCBTbl[mid];
+        if (mcb)
+        {
+            rt_kprintf("%-4d %-9d %-9d %s\n", mid, mcb->LoadUs, mcb->InitUs, mcb->xcb.xfile);
+        }
+    }
+    return 0;
+}
+FINSH_FUNCTION_EXPORT_ALIAS(cmd_lsmod, __cmd_lsmod, list melis modules and their install time);
@@ -30,6 +30,8 @@ typedef struct __MODS_MCB               //进程控制块
     __u8            type;               //系统模块或用户模块
     __mif_t         mif;                //模块入口，模块的标准函数入口地址存放在此处
     __u32           vmbitmap;           //模块虚拟内存空间占用情况，用于卸载模块时的虚拟内存时间释放
+    __u32           LoadUs;             //file open and section load time
+    __u32           InitUs;             //MInit time
 } __module_mcb_t;
 
 #endif //__MODS_I_H__
@@ -271,6 +271,8 @@ int aw_hw_crypto_device_init(void)
 		pr_err("sunxi_ce_init fail\n");
 		return -1;
 	}
+	if (crypto_aes_queue_init() != RT_EOK)
+		pr_err("crypto_aes_queue_init fail\n");
     /*rt_mutex_init(&_crypto_dev.mutex, RT_HWCRYPTO_DEFAULT_NAME, RT_IPC_FLAG_FIFO);*/
     return 0;
 }
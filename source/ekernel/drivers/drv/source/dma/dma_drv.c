@@ -45,6 +45,9 @@ int drv_dma_init(void)
 {
 
     hal_dma_init();
+#ifdef CONFIG_DMA_ASYNC_MEMCPY
+    hal_dma_async_init();
+#endif
 
     return 0;
 }
@@ -0,0 +1,395 @@
+/* Copyright (c) 2019-2025 Allwinner Technology Co., Ltd. ALL rights reserved.
+
+ * Allwinner is a trademark of Allwinner Technology Co.,Ltd., registered in
+ * the the People's Republic of China and other countries.
+ * All Allwinner Technology Co.,Ltd. trademarks are used with permission.
+
+ * DISCLAIMER
+ * THIRD PARTY LICENCES MAY BE REQUIRED TO IMPLEMENT THE SOLUTION/PRODUCT.
+ * IF YOU NEED TO INTEGRATE THIRD PARTY’S TECHNOLOGY (SONY, DTS, DOLBY, AVS OR MPEGLA, ETC.)
+ * IN ALLWINNERS’SDK OR PRODUCTS, YOU SHALL BE SOLELY RESPONSIBLE TO OBTAIN
+ * ALL APPROPRIATELY REQUIRED THIRD PARTY LICENCES.
+ * ALLWINNER SHALL HAVE NO WARRANTY, INDEMNITY OR OTHER OBLIGATIONS WITH RESPECT TO MATTERS
+ * COVERED UNDER ANY REQUIRED THIRD PARTY LICENSE.
+ * YOU ARE SOLELY RESPONSIBLE FOR YOUR USAGE OF THIRD PARTY’S TECHNOLOGY.
+
+
+ * THIS SOFTWARE IS PROVIDED BY ALLWINNER"AS IS" AND TO THE MAXIMUM EXTENT
+ * PERMITTED BY LAW, ALLWINNER EXPRESSLY DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING WITHOUT LIMITATION REGARDING
+ * THE TITLE, NON-INFRINGEMENT, ACCURACY, CONDITION, COMPLETENESS, PERFORMANCE
+ * OR MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ * IN NO EVENT SHALL ALLWINNER BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS, OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Software AES (FIPS-197) with the same job interface as the CE, used as
+ * the reference on the host and for requests too small to be worth a CE
+ * round trip. Round function and key schedule follow the usual 32-bit
+ * table formulation; one forward and one reverse table are generated at
+ * first use and rotated per column, 2KB instead of 8KB.
+ */
+#include <rtthread.h>
+#include <rthw.h>
+#include <string.h>
+#include <sunxi_drv_crypto.h>
+
+#define ROTL8(x)	(((x) << 8) | ((x) >> 24))
+#define XTIME(x)	(((x) << 1) ^ (((x) & 0x80) ? 0x1B : 0x00))
+
+#define GET_U32_LE(b, i)				\
+	(((rt_uint32_t)(b)[(i)])			\
+	 | ((rt_uint32_t)(b)[(i) + 1] << 8)		\
+	 | ((rt_uint32_t)(b)[(i) + 2] << 16)		\
+	 | ((rt_uint32_t)(b)[(i) + 3] << 24))
+
+#define PUT_U32_LE(n, b, i)				\
+	do {						\
+		(b)[(i)] = (rt_uint8_t)(n);		\
+		(b)[(i) + 1] = (rt_uint8_t)((n) >> 8);	\
+		(b)[(i) + 2] = (rt_uint8_t)((n) >> 16);	\
+		(b)[(i) + 3] = (rt_uint8_t)((n) >> 24);	\
+	} while (0)
+
+static rt_uint8_t FSb[256];
+static rt_uint8_t RSb[256];
+static rt_uint32_t FT[256];
+static rt_uint32_t RT[256];
+static rt_uint32_t RCON[10];
+static volatile int aes_tables_done;
+
+#define FT0(x)	FT[x]
+#define FT1(x)	ROTL8(FT[x])
+#define FT2(x)	ROTL8(ROTL8(FT[x]))
+#define FT3(x)	ROTL8(ROTL8(ROTL8(FT[x])))
+#define RT0(x)	RT[x]
+#define RT1(x)	ROTL8(RT[x])
+#define RT2(x)	ROTL8(ROTL8(RT[x]))
+#define RT3(x)	ROTL8(ROTL8(ROTL8(RT[x])))
+
+static void aes_gen_tables(void)
+{
+	int pow[256], log[256];
+	int i, x, y, z;
+
+#define MUL(a, b) (((a) && (b)) ? pow[(log[(a)] + log[(b)]) % 255] : 0)
+
+	for (i = 0, x = 1; i < 256; i++) {
+		pow[i] = x;
+		log[x] = i;
+		x = (x ^ XTIME(x)) & 0xFF;
+	}
+
+	for (i = 0, x = 1; i < 10; i++) {
+		RCON[i] = (rt_uint32_t)x;
+		x = XTIME(x) & 0xFF;
+	}
+
+	/* s-box: multiplicative inverse followed by the affine transform */
+	FSb[0x00] = 0x63;
+	RSb[0x63] = 0x00;
+	for (i = 1; i < 256; i++) {
+		x = pow[255 - log[i]];
+		y = x;
+		y = ((y << 1) | (y >> 7)) & 0xFF;
+		x ^= y;
+		y = ((y << 1) | (y >> 7)) & 0xFF;
+		x ^= y;
+		y = ((y << 1) | (y >> 7)) & 0xFF;
+		x ^= y;
+		y = ((y << 1) | (y >> 7)) & 0xFF;
+		x ^= y ^ 0x63;
+		FSb[i] = (rt_uint8_t)x;
+		RSb[x] = (rt_uint8_t)i;
+	}
+
+	for (i = 0; i < 256; i++) {
+		x = FSb[i];
+		y = XTIME(x) & 0xFF;
+		z = (y ^ x) & 0xFF;
+		FT[i] = ((rt_uint32_t)y) ^ ((rt_uint32_t)x << 8)
+			^ ((rt_uint32_t)x << 16) ^ ((rt_uint32_t)z << 24);
+
+		x = RSb[i];
+		RT[i] = ((rt_uint32_t)MUL(0x0E, x)) ^ ((rt_uint32_t)MUL(0x09, x) << 8)
+			^ ((rt_uint32_t)MUL(0x0D, x) << 16) ^ ((rt_uint32_t)MUL(0x0B, x) << 24);
+	}
+#undef MUL
+
+	aes_tables_done = 1;
+}
+
+#define SUB_WORD(w)					\
+	(((rt_uint32_t)FSb[(w) & 0xFF])			\
+	 ^ ((rt_uint32_t)FSb[((w) >> 8) & 0xFF] << 8)	\
+	 ^ ((rt_uint32_t)FSb[((w) >> 16) & 0xFF] << 16)	\
+	 ^ ((rt_uint32_t)FSb[((w) >> 24) & 0xFF] << 24))
+
+static void aes_expand_key(crypto_aes_soft_ctx_t *ctx, const rt_uint8_t *key, rt_uint32_t key_length)
+{
+	rt_uint32_t *rk = ctx->rk;
+	rt_uint32_t i;
+
+	for (i = 0; i < key_length / 4; i++)
+		rk[i] = GET_U32_LE(key, i * 4);
+
+	switch (ctx->nr) {
+	case 10:
+		for (i = 0; i < 10; i++, rk += 4) {
+			rk[4] = rk[0] ^ RCON[i] ^ SUB_WORD((rk[3] >> 8) | (rk[3] << 24));
+			rk[5] = rk[1] ^ rk[4];
+			rk[6] = rk[2] ^ rk[5];
+			rk[7] = rk[3] ^ rk[6];
+		}
+		break;
+	case 12:
+		for (i = 0; i < 8; i++, rk += 6) {
+			rk[6] = rk[0] ^ RCON[i] ^ SUB_WORD((rk[5] >> 8) | (rk[5] << 24));
+			rk[7] = rk[1] ^ rk[6];
+			rk[8] = rk[2] ^ rk[7];
+			rk[9] = rk[3] ^ rk[8];
+			rk[10] = rk[4] ^ rk[9];
+			rk[11] = rk[5] ^ rk[10];
+		}
+		break;
+	default:
+		for (i = 0; i < 7; i++, rk += 8) {
+			rk[8] = rk[0] ^ RCON[i] ^ SUB_WORD((rk[7] >> 8) | (rk[7] << 24));
+			rk[9] = rk[1] ^ rk[8];
+			rk[10] = rk[2] ^ rk[9];
+			rk[11] = rk[3] ^ rk[10];
+			rk[12] = rk[4] ^ SUB_WORD(rk[11]);
+			rk[13] = rk[5] ^ rk[12];
+			rk[14] = rk[6] ^ rk[13];
+			rk[15] = rk[7] ^ rk[14];
+		}
+		break;
+	}
+}
+
+/*
+ * Key schedule for dir (CRYPTO_DIR_ENCRYPT or CRYPTO_DIR_DECRYPT). The
+ * decryption schedule is the reversed one with InvMixColumns applied to
+ * the inner round keys (equivalent inverse cipher).
+ */
+int crypto_aes_soft_setkey(crypto_aes_soft_ctx_t *ctx, const rt_uint8_t *key, rt_uint32_t key_length, rt_uint32_t dir)
+{
+	crypto_aes_soft_ctx_t enc;
+	rt_uint32_t *rk, *sk;
+	int i, j;
+
+	if (ctx == NULL || key == NULL)
+		return -RT_EINVAL;
+
+	switch (key_length) {
+	case 16:
+		ctx->nr = 10;
+		break;
+	case 24:
+		ctx->nr = 12;
+		break;
+	case 32:
+		ctx->nr = 14;
+		break;
+	default:
+		return -RT_EINVAL;
+	}
+
+	if (!aes_tables_done)
+		aes_gen_tables();
+
+	if (dir == CRYPTO_DIR_ENCRYPT) {
+		aes_expand_key(ctx, key, key_length);
+		return RT_EOK;
+	}
+
+	enc.nr = ctx->nr;
+	aes_expand_key(&enc, key, key_length);
+
+	rk = ctx->rk;
+	sk = enc.rk + enc.nr * 4;
+	for (j = 0; j < 4; j++)
+		*rk++ = sk[j];
+	for (i = ctx->nr - 1, sk -= 4; i > 0; i--, sk -= 4) {
+		for (j = 0; j < 4; j++) {
+			*rk++ = RT0(FSb[sk[j] & 0xFF]) ^ RT1(FSb[(sk[j] >> 8) & 0xFF])
+				^ RT2(FSb[(sk[j] >> 16) & 0xFF]) ^ RT3(FSb[(sk[j] >> 24) & 0xFF]);
+		}
+	}
+	for (j = 0; j < 4; j++)
+		*rk++ = sk[j];
+
+	/* remember the direction through the sign of nr */
+	ctx->nr = -ctx->nr;
+	memset(&enc, 0, sizeof(enc));
+	return RT_EOK;
+}
+
+#define AES_FROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3)				\
+	do {									\
+		X0 = *rk++ ^ FT0((Y0) & 0xFF) ^ FT1(((Y1) >> 8) & 0xFF)		\
+			^ FT2(((Y2) >> 16) & 0xFF) ^ FT3(((Y3) >> 24) & 0xFF);	\
+		X1 = *rk++ ^ FT0((Y1) & 0xFF) ^ FT1(((Y2) >> 8) & 0xFF)		\
+			^ FT2(((Y3) >> 16) & 0xFF) ^ FT3(((Y0) >> 24) & 0xFF);	\
+		X2 = *rk++ ^ FT0((Y2) & 0xFF) ^ FT1(((Y3) >> 8) & 0xFF)		\
+			^ FT2(((Y0) >> 16) & 0xFF) ^ FT3(((Y1) >> 24) & 0xFF);	\
+		X3 = *rk++ ^ FT0((Y3) & 0xFF) ^ FT1(((Y0) >> 8) & 0xFF)		\
+			^ FT2(((Y1) >> 16) & 0xFF) ^ FT3(((Y2) >> 24) & 0xFF);	\
+	} while (0)
+
+#define AES_RROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3)				\
+	do {									\
+		X0 = *rk++ ^ RT0((Y0) & 0xFF) ^ RT1(((Y3) >> 8) & 0xFF)		\
+			^ RT2(((Y2) >> 16) & 0xFF) ^ RT3(((Y1) >> 24) & 0xFF);	\
+		X1 = *rk++ ^ RT0((Y1) & 0xFF) ^ RT1(((Y0) >> 8) & 0xFF)		\
+			^ RT2(((Y3) >> 16) & 0xFF) ^ RT3(((Y2) >> 24) & 0xFF);	\
+		X2 = *rk++ ^ RT0((Y2) & 0xFF) ^ RT1(((Y1) >> 8) & 0xFF)		\
+			^ RT2(((Y0) >> 16) & 0xFF) ^ RT3(((Y3) >> 24) & 0xFF);	\
+		X3 = *rk++ ^ RT0((Y3) & 0xFF) ^ RT1(((Y2) >> 8) & 0xFF)		\
+			^ RT2(((Y1) >> 16) & 0xFF) ^ RT3(((Y0) >> 24) & 0xFF);	\
+	} while (0)
+
+#define AES_LAST(S, A, B, C, D)							\
+	(*rk++ ^ ((rt_uint32_t)S[(A) & 0xFF]) ^ ((rt_uint32_t)S[((B) >> 8) & 0xFF] << 8)	\
+	 ^ ((rt_uint32_t)S[((C) >> 16) & 0xFF] << 16) ^ ((rt_uint32_t)S[((D) >> 24) & 0xFF] << 24))
+
+/* One block in the direction the key schedule was made for. */
+void crypto_aes_soft_block(const crypto_aes_soft_ctx_t *ctx, const rt_uint8_t in[16], rt_uint8_t out[16])
+{
+	const rt_uint32_t *rk = ctx->rk;
+	rt_uint32_t X0, X1, X2, X3, Y0, Y1, Y2, Y3;
+	int nr = ctx->nr < 0 ? -ctx->nr : ctx->nr;
+	int i;
+
+	X0 = GET_U32_LE(in, 0) ^ *rk++;
+	X1 = GET_U32_LE(in, 4) ^ *rk++;
+	X2 = GET_U32_LE(in, 8) ^ *rk++;
+	X3 = GET_U32_LE(in, 12) ^ *rk++;
+
+	if (ctx->nr > 0) {
+		for (i = (nr >> 1) - 1; i > 0; i--) {
+			AES_FROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+			AES_FROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3);
+		}
+		AES_FROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+		X0 = AES_LAST(FSb, Y0, Y1, Y2, Y3);
+		X1 = AES_LAST(FSb, Y1, Y2, Y3, Y0);
+		X2 = AES_LAST(FSb, Y2, Y3, Y0, Y1);
+		X3 = AES_LAST(FSb, Y3, Y0, Y1, Y2);
+	} else {
+		for (i = (nr >> 1) - 1; i > 0; i--) {
+			AES_RROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+			AES_RROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3);
+		}
+		AES_RROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+		X0 = AES_LAST(RSb, Y0, Y3, Y2, Y1);
+		X1 = AES_LAST(RSb, Y1, Y0, Y3, Y2);
+		X2 = AES_LAST(RSb, Y2, Y1, Y0, Y3);
+		X3 = AES_LAST(RSb, Y3, Y2, Y1, Y0);
+	}
+
+	PUT_U32_LE(X0, out, 0);
+	PUT_U32_LE(X1, out, 4);
+	PUT_U32_LE(X2, out, 8);
+	PUT_U32_LE(X3, out, 12);
+}
+
+/* Run one job synchronously, same semantics as on the CE. */
+int crypto_aes_soft_crypt(crypto_aes_job_t *job)
+{
+	crypto_aes_soft_ctx_t ctx;
+	const rt_uint8_t *src = job->src;
+	rt_uint8_t *dst = job->dst;
+	rt_uint8_t tmp[AES_BLOCK_SIZE];
+	rt_uint32_t n, i;
+
+	if (crypto_aes_soft_setkey(&ctx, job->key, job->key_length, job->dir) != RT_EOK)
+		return -RT_EINVAL;
+
+	for (n = 0; n < job->length; n += AES_BLOCK_SIZE) {
+		if (job->mode == AES_MODE_CBC && job->dir == CRYPTO_DIR_ENCRYPT) {
+			for (i = 0; i < AES_BLOCK_SIZE; i++)
+				tmp[i] = src[n + i] ^ job->iv[i];
+			crypto_aes_soft_block(&ctx, tmp, dst + n);
+			memcpy(job->iv, dst + n, AES_BLOCK_SIZE);
+		} else if (job->mode == AES_MODE_CBC) {
+			/* src and dst may be the same buffer */
+			memcpy(tmp, src + n, AES_BLOCK_SIZE);
+			crypto_aes_soft_block(&ctx, tmp, dst + n);
+			for (i = 0; i < AES_BLOCK_SIZE; i++)
+				dst[n + i] ^= job->iv[i];
+			memcpy(job->iv, tmp, AES_BLOCK_SIZE);
+		} else {
+			crypto_aes_soft_block(&ctx, src + n, dst + n);
+		}
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	return RT_EOK;
+}
+
+static struct {
+	int deferred;
+	crypto_aes_job_t *batch[CE_JOB_BATCH_MAX];
+	int num;
+} ce_soft;
+
+static int ce_soft_run(crypto_aes_job_t **jobs, int num)
+{
+	int i, ret = RT_EOK;
+
+	for (i = 0; i < num && ret == RT_EOK; i++)
+		ret = crypto_aes_soft_crypt(jobs[i]);
+	return ret;
+}
+
+static int ce_soft_submit(crypto_aes_job_t **jobs, int num)
+{
+	if (ce_soft.deferred) {
+		/* worked off by crypto_aes_soft_poll(), like an interrupt */
+		memcpy(ce_soft.batch, jobs, num * sizeof(jobs[0]));
+		ce_soft.num = num;
+		return RT_EOK;
+	}
+
+	crypto_aes_engine_done(ce_soft_run(jobs, num));
+	return RT_EOK;
+}
+
+static const crypto_aes_engine_t ce_soft_engine = {
+	.name = "soft",
+	.max_batch = CE_JOB_BATCH_MAX,
+	.submit = ce_soft_submit,
+};
+
+int crypto_aes_soft_init(int deferred)
+{
+	int ret;
+
+	ret = crypto_aes_engine_register(&ce_soft_engine);
+	if (ret == RT_EOK) {
+		ce_soft.deferred = deferred;
+		ce_soft.num = 0;
+	}
+	return ret;
+}
+
+/* Finish the batch in flight on the deferred software engine. */
+int crypto_aes_soft_poll(void)
+{
+	int num = ce_soft.num;
+
+	if (num == 0)
+		return 0;
+
+	ce_soft.num = 0;
+	crypto_aes_engine_done(ce_soft_run(ce_soft.batch, num));
+	return num;
+}
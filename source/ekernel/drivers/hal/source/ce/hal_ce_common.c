@@ -46,9 +46,39 @@
 #define CE_WAIT_TIME	(50000)
 
 extern void udelay(rt_uint32_t us);
+extern void dma_map_area(rt_uint32_t start, rt_uint32_t size, rt_int32_t dir);
+extern void dma_unmap_area(rt_uint32_t start, rt_uint32_t size, rt_int32_t dir);
 
 static rt_uint32_t irq_done;
 static rt_wqueue_t ce_wqueue;
+/* one user of the CE at a time: do_aes_crypto() or a job queue batch */
+static struct rt_semaphore ce_hw_sem;
+
+/*
+ * Job queue backend. A batch becomes one chain of task descriptors linked
+ * through ->next; only the last one raises the interrupt, so a whole batch
+ * costs one start and one interrupt. Key and iv are copied next to the
+ * descriptor as the CE reads them while the chain runs.
+ */
+#define CE_QUEUE_FLOW		1
+#define CE_QUEUE_THREAD_PRIO	12
+
+typedef struct {
+	ce_task_desc_t task;
+	rt_uint8_t key[AES_MAX_KEY_SIZE];
+	rt_uint8_t iv[AES_BLOCK_SIZE];
+	/* next CBC chaining value of a decrypt job, src may be overwritten */
+	rt_uint8_t next_iv[AES_BLOCK_SIZE];
+} ce_job_slot_t;
+
+static struct {
+	ce_job_slot_t slot[CE_JOB_BATCH_MAX] __attribute__((aligned(64)));
+	crypto_aes_job_t *batch[CE_JOB_BATCH_MAX];
+	int num;
+	volatile int busy;
+	struct rt_semaphore done_sem;
+	rt_thread_t thread;
+} ce_queue_hw;
 
 void ce_print_hex(char *_data, int _len, void *_addr)
 {
@@ -109,7 +139,12 @@ static irqreturn_t ce_irq_handler(int irq, void *dev_id)
 		if (pending & (CE_CHAN_PENDING << i)) {
 			CE_DBG("Chan %d completed. pending: %#x\n", i, pending);
 			ce_pending_clear(i);
-			printf("%s line %d, irq done.\n", __func__, __LINE__);
+			if (ce_queue_hw.busy) {
+				/* finished in ce_queue_thread(), callbacks may sleep */
+				rt_sem_release(&ce_queue_hw.done_sem);
+				continue;
+			}
+			CE_DBG("%s line %d, irq done.\n", __func__, __LINE__);
 			irq_done = IRQ_DONE;
 			rt_wqueue_wakeup(&ce_wqueue, NULL);
 		}
@@ -145,6 +180,7 @@ int sunxi_ce_init(void)
 
 	irq_done = 0x0;
 	rt_wqueue_init(&ce_wqueue);
+	rt_sem_init(&ce_hw_sem, "ce_hw", 1, RT_IPC_FLAG_FIFO);
 
 	return 0;
 }
@@ -185,8 +221,6 @@ static int aes_crypto_start(rt_uint8_t *src_buf,
 	cpu_dcache_clean((rt_uint32_t)task, sizeof(ce_task_desc_t));
 	cpu_dcache_clean((rt_uint32_t)src_buf, src_length);
 	cpu_dcache_clean((rt_uint32_t)dest_buf, src_length);
-	void dma_map_area(rt_uint32_t start, rt_uint32_t size, rt_int32_t dir);
-	void dma_unmap_area(rt_uint32_t start, rt_uint32_t size, rt_int32_t dir);
 	/*ce_print_task_info(task);*/
 	dma_map_area((rt_uint32_t)dest_buf, src_length, DMA_FROM_DEVICE);
 	ce_set_tsk((rt_uint32_t)task);
@@ -244,7 +278,7 @@ static ce_task_desc_t *ce_aes_config(rt_uint8_t dir, rt_uint8_t type, rt_uint8_t
 	return task;
 }
 
-int do_aes_crypto(crypto_aes_req_ctx_t *req_ctx)
+static int do_aes_crypto_locked(crypto_aes_req_ctx_t *req_ctx)
 {
 	rt_uint32_t last_block_size = 0;
 	rt_uint32_t block_num = 0;
@@ -341,3 +375,131 @@ int do_aes_crypto(crypto_aes_req_ctx_t *req_ctx)
 		return AES_STATUS_OK;
 	}
 }
+
+int do_aes_crypto(crypto_aes_req_ctx_t *req_ctx)
+{
+	int ret;
+
+	rt_sem_take(&ce_hw_sem, RT_WAITING_FOREVER);
+	ret = do_aes_crypto_locked(req_ctx);
+	rt_sem_release(&ce_hw_sem);
+
+	return ret;
+}
+
+static void ce_queue_task_build(ce_job_slot_t *slot, crypto_aes_job_t *job, ce_job_slot_t *next)
+{
+	ce_task_desc_t *task = &slot->task;
+	rt_uint32_t word_len = job->length >> 2;
+
+	ce_task_desc_init(task, CE_QUEUE_FLOW);
+	if (next)
+		task->comm_ctl &= ~CE_COMM_CTL_TASK_INT_MASK;
+	ce_method_set(job->dir, CE_METHOD_AES, task);
+	ce_aes_mode_set(job->mode, task);
+
+	memcpy(slot->key, job->key, job->key_length);
+	ce_key_set((char *)slot->key, job->key_length, task);
+	if (job->mode == AES_MODE_CBC) {
+		memcpy(slot->iv, job->iv, AES_BLOCK_SIZE);
+		ce_iv_set((char *)slot->iv, AES_BLOCK_SIZE, task);
+		if (job->dir == CRYPTO_DIR_DECRYPT)
+			memcpy(slot->next_iv, job->src + job->length - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+	}
+
+#ifdef SS_SUPPORT_CE_V3_1
+	ce_data_len_set(word_len, task);
+#else
+	ce_data_len_set(job->length, task);
+#endif
+	task->src[0].addr = (rt_uint32_t)__va_to_pa((rt_uint32_t)job->src);
+	task->src[0].len = word_len;
+	task->dst[0].addr = (rt_uint32_t)__va_to_pa((rt_uint32_t)job->dst);
+	task->dst[0].len = word_len;
+	task->next = next ? (ce_task_desc_t *)__va_to_pa((rt_uint32_t)&next->task) : NULL;
+}
+
+static int ce_queue_submit(crypto_aes_job_t **jobs, int num)
+{
+	crypto_aes_job_t *job;
+	int i;
+
+	rt_sem_take(&ce_hw_sem, RT_WAITING_FOREVER);
+
+	for (i = 0; i < num; i++) {
+		job = jobs[i];
+		ce_queue_task_build(&ce_queue_hw.slot[i], job,
+				    i + 1 < num ? &ce_queue_hw.slot[i + 1] : NULL);
+		cpu_dcache_clean((rt_uint32_t)job->src, job->length);
+		cpu_dcache_clean((rt_uint32_t)job->dst, job->length);
+		dma_map_area((rt_uint32_t)job->dst, job->length, DMA_FROM_DEVICE);
+		ce_queue_hw.batch[i] = job;
+	}
+	cpu_dcache_clean((rt_uint32_t)ce_queue_hw.slot, num * sizeof(ce_job_slot_t));
+	ce_queue_hw.num = num;
+	ce_queue_hw.busy = 1;
+
+	ce_pending_clear(CE_QUEUE_FLOW);
+	ce_set_tsk((rt_uint32_t)&ce_queue_hw.slot[0].task);
+	ce_irq_enable(CE_QUEUE_FLOW);
+	ce_ctrl_start();
+
+	return RT_EOK;
+}
+
+static void ce_queue_thread(void *arg)
+{
+	crypto_aes_job_t *job;
+	int i, status;
+
+	for (;;) {
+		rt_sem_take(&ce_queue_hw.done_sem, RT_WAITING_FOREVER);
+
+		ce_irq_disable(CE_QUEUE_FLOW);
+		status = RT_EOK;
+		if (ce_get_erro() > 0) {
+			ce_reg_printf();
+			status = -RT_EIO;
+		}
+
+		for (i = 0; i < ce_queue_hw.num; i++) {
+			job = ce_queue_hw.batch[i];
+			dma_unmap_area((rt_uint32_t)job->dst, job->length, DMA_FROM_DEVICE);
+			if (job->mode != AES_MODE_CBC)
+				continue;
+			if (job->dir == CRYPTO_DIR_ENCRYPT)
+				memcpy(job->iv, job->dst + job->length - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+			else
+				memcpy(job->iv, ce_queue_hw.slot[i].next_iv, AES_BLOCK_SIZE);
+		}
+		ce_queue_hw.num = 0;
+		ce_queue_hw.busy = 0;
+		rt_sem_release(&ce_hw_sem);
+
+		crypto_aes_engine_done(status);
+	}
+}
+
+static const crypto_aes_engine_t ce_queue_engine = {
+	.name = "ce",
+	.max_batch = CE_JOB_BATCH_MAX,
+	.submit = ce_queue_submit,
+};
+
+int crypto_aes_queue_init(void)
+{
+	if (ce_queue_hw.thread)
+		return RT_EOK;
+
+	rt_sem_init(&ce_queue_hw.done_sem, "ce_done", 0, RT_IPC_FLAG_FIFO);
+	ce_queue_hw.thread = rt_thread_create("ce-queue", ce_queue_thread, NULL,
+					      4096, CE_QUEUE_THREAD_PRIO, 10);
+	if (ce_queue_hw.thread == RT_NULL) {
+		CE_ERR("ce-queue thread create fail\n");
+		rt_sem_detach(&ce_queue_hw.done_sem);
+		return -RT_ENOMEM;
+	}
+	rt_thread_startup(ce_queue_hw.thread);
+
+	return crypto_aes_engine_register(&ce_queue_engine);
+}
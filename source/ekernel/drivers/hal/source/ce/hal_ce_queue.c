@@ -0,0 +1,137 @@
+/* Copyright (c) 2019-2025 Allwinner Technology Co., Ltd. ALL rights reserved.
+
+ * Allwinner is a trademark of Allwinner Technology Co.,Ltd., registered in
+ * the the People's Republic of China and other countries.
+ * All Allwinner Technology Co.,Ltd. trademarks are used with permission.
+
+ * DISCLAIMER
+ * THIRD PARTY LICENCES MAY BE REQUIRED TO IMPLEMENT THE SOLUTION/PRODUCT.
+ * IF YOU NEED TO INTEGRATE THIRD PARTY’S TECHNOLOGY (SONY, DTS, DOLBY, AVS OR MPEGLA, ETC.)
+ * IN ALLWINNERS’SDK OR PRODUCTS, YOU SHALL BE SOLELY RESPONSIBLE TO OBTAIN
+ * ALL APPROPRIATELY REQUIRED THIRD PARTY LICENCES.
+ * ALLWINNER SHALL HAVE NO WARRANTY, INDEMNITY OR OTHER OBLIGATIONS WITH RESPECT TO MATTERS
+ * COVERED UNDER ANY REQUIRED THIRD PARTY LICENSE.
+ * YOU ARE SOLELY RESPONSIBLE FOR YOUR USAGE OF THIRD PARTY’S TECHNOLOGY.
+
+
+ * THIS SOFTWARE IS PROVIDED BY ALLWINNER"AS IS" AND TO THE MAXIMUM EXTENT
+ * PERMITTED BY LAW, ALLWINNER EXPRESSLY DISCLAIMS ALL WARRANTIES OF ANY KIND,
+ * WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING WITHOUT LIMITATION REGARDING
+ * THE TITLE, NON-INFRINGEMENT, ACCURACY, CONDITION, COMPLETENESS, PERFORMANCE
+ * OR MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ * IN NO EVENT SHALL ALLWINNER BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS, OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Engine independent part of the AES job queue, batches of up to
+ * max_batch jobs on the shared hal job queue. Everything hardware
+ * specific sits behind crypto_aes_engine_t, so this file also builds on
+ * the host (utility/host-tool/ce_queue_test).
+ */
+#include <rtthread.h>
+#include <hal_job_queue.h>
+#include <sunxi_drv_crypto.h>
+
+static int ce_queue_submit(void *backend, struct hal_job **jobs, int num)
+{
+	const crypto_aes_engine_t *engine = backend;
+	crypto_aes_job_t *batch[CE_JOB_BATCH_MAX];
+	int i;
+
+	for (i = 0; i < num; i++)
+		batch[i] = hal_job_entry(jobs[i], crypto_aes_job_t, job);
+
+	return engine->submit(batch, num);
+}
+
+static void ce_queue_done(struct hal_job *job, int status)
+{
+	crypto_aes_job_t *aes_job = hal_job_entry(job, crypto_aes_job_t, job);
+
+	if (aes_job->done)
+		aes_job->done(aes_job, status);
+}
+
+static struct hal_job_queue ce_queue = {
+	.submit = ce_queue_submit,
+	.done = ce_queue_done,
+};
+
+void crypto_aes_engine_done(int status)
+{
+	hal_job_queue_complete(&ce_queue, status);
+}
+
+int crypto_aes_engine_register(const crypto_aes_engine_t *engine)
+{
+	if (engine && !engine->submit)
+		return -RT_EINVAL;
+
+	if (hal_job_queue_attach(&ce_queue, (void *)engine, engine ? engine->max_batch : 0))
+		return -RT_EBUSY;
+
+	return RT_EOK;
+}
+
+int crypto_aes_job_submit(crypto_aes_job_t *job)
+{
+	if (job == NULL || job->src == NULL || job->dst == NULL || job->key == NULL)
+		return -RT_EINVAL;
+	if (job->length == 0 || (job->length % AES_BLOCK_SIZE) != 0)
+		return -RT_EINVAL;
+	if (((rt_ubase_t)job->src | (rt_ubase_t)job->dst) % ADDR_ALIGN_SIZE)
+		return -RT_EINVAL;
+	if (job->key_length != 16 && job->key_length != 24 && job->key_length != 32)
+		return -RT_EINVAL;
+	if (job->mode != AES_MODE_ECB && (job->mode != AES_MODE_CBC || job->iv == NULL))
+		return -RT_EINVAL;
+
+	if (hal_job_queue_push(&ce_queue, &job->job))
+		return -RT_ERROR;
+
+	return RT_EOK;
+}
+
+struct ce_job_wait {
+	struct rt_semaphore sem;
+	int status;
+};
+
+static void ce_job_wake(crypto_aes_job_t *job, int status)
+{
+	struct ce_job_wait *wait = job->priv;
+
+	wait->status = status;
+	rt_sem_release(&wait->sem);
+}
+
+/* Blocking helper: submit one job and sleep until it is done. */
+int crypto_aes_job_run(crypto_aes_job_t *job)
+{
+	struct ce_job_wait wait;
+	int ret;
+
+	if (job == NULL)
+		return -RT_EINVAL;
+
+	rt_sem_init(&wait.sem, "aesjob", 0, RT_IPC_FLAG_FIFO);
+	wait.status = -RT_ERROR;
+	job->done = ce_job_wake;
+	job->priv = &wait;
+
+	ret = crypto_aes_job_submit(job);
+	if (ret == RT_EOK) {
+		rt_sem_take(&wait.sem, RT_WAITING_FOREVER);
+		ret = wait.status;
+	}
+	rt_sem_detach(&wait.sem);
+
+	return ret;
+}
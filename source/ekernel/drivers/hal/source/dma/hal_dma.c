@@ -32,6 +32,9 @@
 #include "sunxi_dma_core.h"
 #include <sunxi_hal_dma.h>
 #include <hal_mem.h>
+#include <hal_cache.h>
+#include <hal_sem.h>
+#include <hal_osal.h>
 
 void dma_free_coherent(void *addr)
 {
@@ -123,6 +126,62 @@ hal_dma_status_t hal_dma_prep_device(unsigned long *hdma, uint32_t dest, uint32_
     return HAL_DMA_STATUS_OK;
 }
 
+hal_dma_status_t hal_dma_prep_memcpy_sg(unsigned long *hdma, const struct dma_sg_entry *sg, uint32_t nents)
+{
+    struct sunxi_dma_chan *chan = NULL;
+    uint32_t i;
+
+    if (hdma == NULL || sg == NULL || nents == 0)
+    {
+        return HAL_DMA_STATUS_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < nents; i++)
+    {
+        if (sg[i].dst == 0 || sg[i].src == 0)
+        {
+            return HAL_DMA_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    chan = (struct sunxi_dma_chan *)hdma;
+
+    if (sunxi_prep_dma_sg(chan, sg, nents, DMA_MEM_TO_MEM) < 0)
+    {
+        return HAL_DMA_STATUS_ERROR;
+    }
+
+    return HAL_DMA_STATUS_OK;
+}
+
+hal_dma_status_t hal_dma_prep_device_sg(unsigned long *hdma, const struct dma_sg_entry *sg, uint32_t nents, enum dma_transfer_direction dir)
+{
+    struct sunxi_dma_chan *chan = NULL;
+    uint32_t i;
+
+    if (hdma == NULL || sg == NULL || nents == 0 || dir == DMA_MEM_TO_MEM || dir >= DMA_TRANS_NONE)
+    {
+        return HAL_DMA_STATUS_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < nents; i++)
+    {
+        if (sg[i].dst == 0 || sg[i].src == 0)
+        {
+            return HAL_DMA_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    chan = (struct sunxi_dma_chan *)hdma;
+
+    if (sunxi_prep_dma_sg(chan, sg, nents, dir) < 0)
+    {
+        return HAL_DMA_STATUS_ERROR;
+    }
+
+    return HAL_DMA_STATUS_OK;
+}
+
 hal_dma_status_t hal_dma_prep_cyclic(unsigned long *hdma, uint32_t buf_addr, uint32_t buf_len, uint32_t period_len, enum dma_transfer_direction dir)
 {
     struct sunxi_dma_chan *chan = NULL;
@@ -273,3 +332,126 @@ void hal_dma_init(void)//only need to be executed once
     sunxi_dma_init();
 }
 
+
+/*
+ * Hardware backend of the asynchronous memcpy service (hal_dma_async.c).
+ * The queue-end interrupt only posts a semaphore; the service thread stops
+ * the channel, invalidates the destination and reports the completion, so
+ * descriptor allocation and user callbacks stay out of interrupt context.
+ */
+static struct
+{
+    unsigned long *hdma;
+    hal_sem_t irq_sem;
+    void *thread;
+    const struct dma_sg_entry *sg;
+    uint32_t nents;
+} dma_async_hw;
+
+static void hal_dma_async_irq(void *param)
+{
+    hal_sem_post(dma_async_hw.irq_sem);
+}
+
+static void hal_dma_async_thread(void *data)
+{
+    uint32_t i;
+
+    while (1)
+    {
+        hal_sem_wait(dma_async_hw.irq_sem);
+        hal_dma_stop(dma_async_hw.hdma);
+        for (i = 0; i < dma_async_hw.nents; i++)
+        {
+            /* drop lines the cpu may have prefetched during the transfer */
+            cpu_dcache_invalidate(dma_async_hw.sg[i].dst, dma_async_hw.sg[i].len);
+        }
+        hal_dma_async_complete(HAL_DMA_STATUS_OK);
+    }
+}
+
+static hal_dma_status_t hal_dma_async_hw_submit(void *priv, const struct dma_sg_entry *sg, uint32_t nents)
+{
+    uint32_t i;
+
+    for (i = 0; i < nents; i++)
+    {
+        if ((sg[i].src | sg[i].len) & 0x3
+            || (sg[i].dst | sg[i].len) & (HAL_DMA_ASYNC_ALIGN - 1))
+        {
+            return HAL_DMA_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    if (hal_dma_prep_memcpy_sg(dma_async_hw.hdma, sg, nents) != HAL_DMA_STATUS_OK)
+    {
+        return HAL_DMA_STATUS_ERROR;
+    }
+
+    for (i = 0; i < nents; i++)
+    {
+        cpu_dcache_clean(sg[i].src, sg[i].len);
+        cpu_dcache_clean_invalidate(sg[i].dst, sg[i].len);
+    }
+
+    dma_async_hw.sg = sg;
+    dma_async_hw.nents = nents;
+    return hal_dma_start(dma_async_hw.hdma);
+}
+
+static const struct hal_dma_async_ops dma_async_hw_ops =
+{
+    .name = "dma",
+    .submit = hal_dma_async_hw_submit,
+};
+
+hal_dma_status_t hal_dma_async_init(void)
+{
+    struct dma_slave_config config = {0};
+
+    if (dma_async_hw.hdma)
+    {
+        return HAL_DMA_STATUS_OK;
+    }
+
+    if (hal_dma_chan_request(&dma_async_hw.hdma) == HAL_DMA_CHAN_STATUS_BUSY)
+    {
+        return HAL_DMA_STATUS_ERROR;
+    }
+
+    config.direction = DMA_MEM_TO_MEM;
+    config.src_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+    config.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+    config.src_maxburst = DMA_SLAVE_BURST_16;
+    config.dst_maxburst = DMA_SLAVE_BURST_16;
+    config.slave_id = sunxi_slave_id(DRQDST_SDRAM, DRQSRC_SDRAM);
+    hal_dma_slave_config(dma_async_hw.hdma, &config);
+
+    if (hal_sem_create(&dma_async_hw.irq_sem, 0) != 0)
+    {
+        goto err_chan;
+    }
+
+    hal_dma_cyclic_callback_install(dma_async_hw.hdma, hal_dma_async_irq, &dma_async_hw);
+
+    dma_async_hw.thread = kthread_run(hal_dma_async_thread, NULL, "dma-async");
+    if (dma_async_hw.thread == NULL)
+    {
+        goto err_sem;
+    }
+
+    if (hal_dma_async_register(&dma_async_hw_ops) != HAL_DMA_STATUS_OK)
+    {
+        /* another backend is busy, keep the thread parked on its semaphore */
+        return HAL_DMA_STATUS_ERROR;
+    }
+
+    return HAL_DMA_STATUS_OK;
+
+err_sem:
+    hal_sem_delete(dma_async_hw.irq_sem);
+err_chan:
+    hal_dma_chan_free(dma_async_hw.hdma);
+    dma_async_hw.hdma = NULL;
+    return HAL_DMA_STATUS_ERROR;
+}
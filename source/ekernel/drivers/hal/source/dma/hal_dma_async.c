@@ -0,0 +1,235 @@
+/*
+* Copyright (c) 2019-2025 Allwinner Technology Co., Ltd. ALL rights reserved.
+*
+* Allwinner is a trademark of Allwinner Technology Co.,Ltd., registered in
+* the the people's Republic of China and other countries.
+* All Allwinner Technology Co.,Ltd. trademarks are used with permission.
+*
+* DISCLAIMER
+* THIRD PARTY LICENCES MAY BE REQUIRED TO IMPLEMENT THE SOLUTION/PRODUCT.
+* IF YOU NEED TO INTEGRATE THIRD PARTYS TECHNOLOGY (SONY, DTS, DOLBY, AVS OR MPEGLA, ETC.)
+* IN ALLWINNERSSDK OR PRODUCTS, YOU SHALL BE SOLELY RESPONSIBLE TO OBTAIN
+* ALL APPROPRIATELY REQUIRED THIRD PARTY LICENCES.
+* ALLWINNER SHALL HAVE NO WARRANTY, INDEMNITY OR OTHER OBLIGATIONS WITH RESPECT TO MATTERS
+* COVERED UNDER ANY REQUIRED THIRD PARTY LICENSE.
+* YOU ARE SOLELY RESPONSIBLE FOR YOUR USAGE OF THIRD PARTYS TECHNOLOGY.
+*
+*
+* THIS SOFTWARE IS PROVIDED BY ALLWINNER"AS IS" AND TO THE MAXIMUM EXTENT
+* PERMITTED BY LAW, ALLWINNER EXPRESSLY DISCLAIMS ALL WARRANTIES OF ANY KIND,
+* WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING WITHOUT LIMITATION REGARDING
+* THE TITLE, NON-INFRINGEMENT, ACCURACY, CONDITION, COMPLETENESS, PERFORMANCE
+* OR MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* IN NO EVENT SHALL ALLWINNER BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS, OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+* OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*
+ * Queueing side of the asynchronous memcpy service, one request at a time
+ * on the shared hal job queue. It only talks to the backend through struct
+ * hal_dma_async_ops, so it builds unchanged on the host against the
+ * software backend below (utility/host-tool/dma_async_test).
+ */
+#include <string.h>
+#include <stdint.h>
+#include <sunxi_hal_dma.h>
+#include <hal_job_queue.h>
+#include <hal_sem.h>
+
+static struct
+{
+    bool deferred;
+    const struct dma_sg_entry *sg;
+    uint32_t nents;
+} dma_async_sw;
+
+static int dma_async_submit(void *backend, struct hal_job **jobs, int num)
+{
+    const struct hal_dma_async_ops *ops = backend;
+    struct hal_dma_async_req *req = hal_job_entry(jobs[0], struct hal_dma_async_req, job);
+
+    return ops->submit(ops->priv, req->sg, req->nents);
+}
+
+static void dma_async_done(struct hal_job *job, int status)
+{
+    struct hal_dma_async_req *req = hal_job_entry(job, struct hal_dma_async_req, job);
+
+    if (req->done)
+    {
+        req->done(req->arg, (hal_dma_status_t)status);
+    }
+}
+
+static struct hal_job_queue dma_async_queue =
+{
+    .submit = dma_async_submit,
+    .done = dma_async_done,
+};
+
+void hal_dma_async_complete(hal_dma_status_t status)
+{
+    hal_job_queue_complete(&dma_async_queue, status);
+}
+
+hal_dma_status_t hal_dma_async_register(const struct hal_dma_async_ops *ops)
+{
+    if (ops && !ops->submit)
+    {
+        return HAL_DMA_STATUS_INVALID_PARAMETER;
+    }
+
+    if (hal_job_queue_attach(&dma_async_queue, (void *)ops, 1) != 0)
+    {
+        return HAL_DMA_STATUS_ERROR;
+    }
+    return HAL_DMA_STATUS_OK;
+}
+
+hal_dma_status_t hal_dma_memcpy_sg_async(struct hal_dma_async_req *req, const struct dma_sg_entry *sg, uint32_t nents, hal_dma_async_cb done, void *arg)
+{
+    if (req == NULL || sg == NULL || nents == 0)
+    {
+        return HAL_DMA_STATUS_INVALID_PARAMETER;
+    }
+
+    req->sg = sg;
+    req->nents = nents;
+    req->done = done;
+    req->arg = arg;
+
+    if (hal_job_queue_push(&dma_async_queue, &req->job) != 0)
+    {
+        return HAL_DMA_STATUS_ERROR;
+    }
+    return HAL_DMA_STATUS_OK;
+}
+
+hal_dma_status_t hal_dma_memcpy_async(struct hal_dma_async_req *req, void *dst, const void *src, uint32_t len, hal_dma_async_cb done, void *arg)
+{
+    if (req == NULL || dst == NULL || src == NULL || len == 0)
+    {
+        return HAL_DMA_STATUS_INVALID_PARAMETER;
+    }
+
+    req->single.dst = (uint32_t)(unsigned long)dst;
+    req->single.src = (uint32_t)(unsigned long)src;
+    req->single.len = len;
+
+    return hal_dma_memcpy_sg_async(req, &req->single, 1, done, arg);
+}
+
+struct dma_async_wait
+{
+    hal_sem_t sem;
+    hal_dma_status_t status;
+};
+
+static void dma_async_wake(void *arg, hal_dma_status_t status)
+{
+    struct dma_async_wait *wait = arg;
+
+    wait->status = status;
+    hal_sem_post(wait->sem);
+}
+
+/*
+ * Blocking copy for large buffers: the cpu sleeps instead of copying. Small,
+ * misaligned or refused copies are done by memcpy, so this always succeeds.
+ */
+hal_dma_status_t hal_dma_memcpy(void *dst, const void *src, uint32_t len)
+{
+    struct hal_dma_async_req req;
+    struct dma_async_wait wait;
+
+    if (dst == NULL || src == NULL)
+    {
+        return HAL_DMA_STATUS_INVALID_PARAMETER;
+    }
+
+    wait.status = HAL_DMA_STATUS_ERROR;
+    if (dma_async_queue.backend && len >= HAL_DMA_ASYNC_MIN_LEN
+        && hal_sem_create(&wait.sem, 0) == 0)
+    {
+        if (hal_dma_memcpy_async(&req, dst, src, len, dma_async_wake, &wait) == HAL_DMA_STATUS_OK)
+        {
+            hal_sem_wait(wait.sem);
+        }
+        hal_sem_delete(wait.sem);
+    }
+
+    if (wait.status != HAL_DMA_STATUS_OK)
+    {
+        memcpy(dst, src, len);
+    }
+    return HAL_DMA_STATUS_OK;
+}
+
+static void dma_async_sw_copy(const struct dma_sg_entry *sg, uint32_t nents)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < nents; i++)
+    {
+        memcpy((void *)(unsigned long)sg[i].dst, (const void *)(unsigned long)sg[i].src, sg[i].len);
+    }
+}
+
+static hal_dma_status_t dma_async_sw_submit(void *priv, const struct dma_sg_entry *sg, uint32_t nents)
+{
+    if (dma_async_sw.deferred)
+    {
+        /* copied by the next hal_dma_async_sw_poll(), like a real engine */
+        dma_async_sw.sg = sg;
+        dma_async_sw.nents = nents;
+        return HAL_DMA_STATUS_OK;
+    }
+
+    dma_async_sw_copy(sg, nents);
+    hal_dma_async_complete(HAL_DMA_STATUS_OK);
+    return HAL_DMA_STATUS_OK;
+}
+
+static const struct hal_dma_async_ops dma_async_sw_ops =
+{
+    .name = "memcpy",
+    .submit = dma_async_sw_submit,
+};
+
+/*
+ * Software backend with the same contract as the dma one. Without deferred
+ * the copy and the callback happen inside the submitting call.
+ */
+hal_dma_status_t hal_dma_async_init_sw(bool deferred)
+{
+    hal_dma_status_t ret;
+
+    ret = hal_dma_async_register(&dma_async_sw_ops);
+    if (ret == HAL_DMA_STATUS_OK)
+    {
+        dma_async_sw.deferred = deferred;
+        dma_async_sw.sg = NULL;
+    }
+    return ret;
+}
+
+/* Finish the request in flight on the deferred software backend. */
+int hal_dma_async_sw_poll(void)
+{
+    const struct dma_sg_entry *sg = dma_async_sw.sg;
+
+    if (sg == NULL)
+    {
+        return 0;
+    }
+
+    dma_async_sw.sg = NULL;
+    dma_async_sw_copy(sg, dma_async_sw.nents);
+    hal_dma_async_complete(HAL_DMA_STATUS_OK);
+    return 1;
+}
@@ -345,23 +345,40 @@ unsigned long sunxi_dma_chan_request(void)
     return 0;
 }
 
-void sunxi_dma_free_ill(struct sunxi_dma_chan *chan)
+static void sunxi_dma_free_lli_list(struct sunxi_dma_lli *li_adr)
 {
-    struct sunxi_dma_lli *li_adr = NULL, *next = NULL;
-
-    if (NULL == chan)
-    {
-        return;
-    }
-
-    li_adr = chan->desc;
+    struct sunxi_dma_lli *next = NULL;
 
+    /* cyclic lists loop through p_lln only, vlln of the last item is NULL */
     while (li_adr)
     {
         next = li_adr->vlln;
         hal_free(li_adr);
         li_adr = next;
     }
+}
+
+/*
+ * Detach the descriptor list of a previous non-cyclic transfer so that a new
+ * prep does not leak it. The caller frees the returned list after dropping
+ * the lock.
+ */
+static struct sunxi_dma_lli *sunxi_dma_detach_desc(struct sunxi_dma_chan *chan)
+{
+    struct sunxi_dma_lli *old = chan->desc;
+
+    chan->desc = NULL;
+    return old;
+}
+
+void sunxi_dma_free_ill(struct sunxi_dma_chan *chan)
+{
+    if (NULL == chan)
+    {
+        return;
+    }
+
+    sunxi_dma_free_lli_list(sunxi_dma_detach_desc(chan));
 
     chan->callback = NULL;
     chan->callback_param = NULL;
@@ -419,7 +436,7 @@ int dma_slave_config(struct sunxi_dma_chan *chan, struct dma_slave_config *confi
 
 int sunxi_prep_dma_memcpy(struct sunxi_dma_chan *chan, uint32_t dest, uint32_t src, uint32_t len)
 {
-    struct sunxi_dma_lli *l_item = NULL;
+    struct sunxi_dma_lli *l_item = NULL, *old = NULL;
     struct dma_slave_config *config = NULL;
 
     uint32_t __cpsr;
@@ -446,18 +463,20 @@ int sunxi_prep_dma_memcpy(struct sunxi_dma_chan *chan, uint32_t dest, uint32_t s
                    | DST_DRQ(DRQDST_SDRAM) \
                    | DST_LINEAR_MODE \
                    | SRC_LINEAR_MODE;
+    old = sunxi_dma_detach_desc(chan);
     sunxi_lli_list(NULL, l_item, chan);
 
     sunxi_dump_lli(chan, l_item);
 
     hal_spin_unlock_irqrestore(__cpsr);
 
+    sunxi_dma_free_lli_list(old);
     return 0;
 }
 
 int sunxi_prep_dma_device(struct sunxi_dma_chan *chan, uint32_t dest, uint32_t src, uint32_t len, enum dma_transfer_direction dir)
 {
-    struct sunxi_dma_lli *l_item = NULL;
+    struct sunxi_dma_lli *l_item = NULL, *old = NULL;
     struct dma_slave_config *config = NULL;
     uint32_t __cpsr;
     if (NULL == chan)
@@ -503,12 +522,107 @@ int sunxi_prep_dma_device(struct sunxi_dma_chan *chan, uint32_t dest, uint32_t s
                        | GET_DST_DRQ(config->slave_id);
     }
 
+    old = sunxi_dma_detach_desc(chan);
     sunxi_lli_list(NULL, l_item, chan);
 
     sunxi_dump_lli(chan, l_item);
 
     hal_spin_unlock_irqrestore(__cpsr);
 
+    sunxi_dma_free_lli_list(old);
+    return 0;
+}
+
+static void sunxi_cfg_lli_mode(struct sunxi_dma_lli *lli, struct dma_slave_config *config, enum dma_transfer_direction dir)
+{
+    switch (dir)
+    {
+        case DMA_MEM_TO_DEV:
+            lli->cfg |= GET_DST_DRQ(config->slave_id) \
+                        | SRC_LINEAR_MODE \
+                        | DST_IO_MODE \
+                        | SRC_DRQ(DRQSRC_SDRAM);
+            break;
+        case DMA_DEV_TO_MEM:
+            lli->cfg |= GET_SRC_DRQ(config->slave_id) \
+                        | DST_LINEAR_MODE \
+                        | SRC_IO_MODE \
+                        | DST_DRQ(DRQSRC_SDRAM);
+            break;
+        case DMA_DEV_TO_DEV:
+            lli->cfg |= GET_SRC_DRQ(config->slave_id) \
+                        | DST_IO_MODE \
+                        | SRC_IO_MODE \
+                        | GET_DST_DRQ(config->slave_id);
+            break;
+        default:
+            lli->cfg |= SRC_DRQ(DRQSRC_SDRAM) \
+                        | DST_DRQ(DRQDST_SDRAM) \
+                        | DST_LINEAR_MODE \
+                        | SRC_LINEAR_MODE;
+            break;
+    }
+}
+
+/*
+ * Build one descriptor chain out of nents segments so that the controller
+ * walks the whole list on its own and raises a single queue-end interrupt.
+ * Memory side addresses are virtual, device side addresses are physical as
+ * for sunxi_prep_dma_device().
+ */
+int sunxi_prep_dma_sg(struct sunxi_dma_chan *chan, const struct dma_sg_entry *sg, uint32_t nents, enum dma_transfer_direction dir)
+{
+    struct sunxi_dma_lli *head = NULL, *prev = NULL, *l_item = NULL, *next = NULL, *old = NULL;
+    struct dma_slave_config *config = NULL;
+    uint32_t src = 0, dst = 0;
+    uint32_t i = 0;
+    uint32_t __cpsr;
+
+    if (NULL == chan || NULL == sg || 0 == nents)
+    {
+        return -1;
+    }
+
+    /* allocate up front, hal_malloc must not be called under the lock */
+    for (i = 0; i < nents; i++)
+    {
+        l_item = (struct sunxi_dma_lli *)hal_malloc(sizeof(struct sunxi_dma_lli));
+        if (!l_item)
+        {
+            sunxi_dma_free_lli_list(head);
+            return -1;
+        }
+        memset(l_item, 0, sizeof(struct sunxi_dma_lli));
+        if (prev)
+        {
+            prev->vlln = l_item;
+        }
+        else
+        {
+            head = l_item;
+        }
+        prev = l_item;
+    }
+
+    __cpsr = hal_spin_lock_irqsave();
+
+    config = &chan->cfg;
+    old = sunxi_dma_detach_desc(chan);
+    prev = NULL;
+    for (i = 0, l_item = head; i < nents; i++, l_item = next)
+    {
+        next = l_item->vlln;
+        src = (dir == DMA_MEM_TO_MEM || dir == DMA_MEM_TO_DEV) ? __va_to_pa(sg[i].src) : sg[i].src;
+        dst = (dir == DMA_MEM_TO_MEM || dir == DMA_DEV_TO_MEM) ? __va_to_pa(sg[i].dst) : sg[i].dst;
+        sunxi_cfg_lli(l_item, src, dst, sg[i].len, config);
+        sunxi_cfg_lli_mode(l_item, config, dir);
+        prev = sunxi_lli_list(prev, l_item, chan);
+        sunxi_dump_lli(chan, l_item);
+    }
+
+    hal_spin_unlock_irqrestore(__cpsr);
+
+    sunxi_dma_free_lli_list(old);
     return 0;
 }
 
@@ -643,8 +757,27 @@ enum dma_status sunxi_tx_status(struct sunxi_dma_chan *chan, uint32_t *left_size
     }
     else
     {
+        uint32_t pos = hal_readl(DMA_LLI_ADDR(chan->chan_count));
+        bool count = false;
+
         *left_size = hal_readl(DMA_CNT(chan->chan_count));
 
+        /* scatter-gather chain: add the items behind the current one */
+        if (chan->desc && chan->desc->vlln && pos != LINK_END)
+        {
+            for (l_item = chan->desc; l_item != NULL; l_item = l_item->vlln)
+            {
+                if (count)
+                {
+                    *left_size += l_item->len;
+                }
+                else if (l_item->p_lln == pos)
+                {
+                    count = true;
+                }
+            }
+        }
+
         if (*left_size == 0)
         {
             status = DMA_COMPLETE;
@@ -144,6 +144,7 @@ int sunxi_dma_chan_free(struct sunxi_dma_chan *chan);
 int dma_slave_config(struct sunxi_dma_chan *chan, struct dma_slave_config*config);
 int sunxi_prep_dma_memcpy(struct sunxi_dma_chan * chan, uint32_t dest, uint32_t src, uint32_t len);
 int sunxi_prep_dma_device(struct sunxi_dma_chan * chan, uint32_t dest, uint32_t src, uint32_t len, enum dma_transfer_direction dir);
+int sunxi_prep_dma_sg(struct sunxi_dma_chan *chan, const struct dma_sg_entry *sg, uint32_t nents, enum dma_transfer_direction dir);
 int sunxi_prep_dma_cyclic(struct sunxi_dma_chan * chan, uint32_t buf_addr, uint32_t buf_len, uint32_t period_len, enum dma_transfer_direction dir);
 int sunxi_dma_start_desc(struct sunxi_dma_chan *chan);
 int sunxi_dma_stop_desc(struct sunxi_dma_chan *chan);
@@ -0,0 +1,70 @@
+/*
+ * ===========================================================================================
+ *
+ *       Filename:  hal_job_queue.h
+ *
+ *    Description:  submit/complete queue shared by the asynchronous hal services.
+ *
+ *        Version:  Melis3.0
+ *         Create:  2026-10-19 10:00:00
+ *       Revision:  none
+ *
+ * ===========================================================================================
+ */
+
+#ifndef SUNXI_HAL_JOB_QUEUE_H
+#define SUNXI_HAL_JOB_QUEUE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+/*
+ * A FIFO of jobs in front of one engine (a dma channel, the CE, or a
+ * software stand-in). Up to max_batch jobs are handed to the backend at
+ * once; it reports the end of the whole batch with hal_job_queue_complete(),
+ * possibly before its submit returns. Jobs are finished in order through
+ * the queue's done(), from the completing context, and the next batch is
+ * started from there. A batch the backend refuses is finished at once with
+ * the error it returned.
+ *
+ * The job is embedded in the caller's request, hal_job_entry() gets back
+ * to it.
+ */
+#define HAL_JOB_BATCH_MAX   8
+
+#define hal_job_entry(job, type, member) \
+    ((type *)((char *)(job) - offsetof(type, member)))
+
+struct hal_job
+{
+    struct hal_job *next;
+};
+
+struct hal_job_queue
+{
+    /* start jobs[0..num-1] on backend: 0, or an error that finishes them */
+    int (*submit)(void *backend, struct hal_job **jobs, int num);
+    void (*done)(struct hal_job *job, int status);
+
+    void *backend;
+    int max_batch;
+    struct hal_job *head;
+    struct hal_job *tail;
+    struct hal_job *active[HAL_JOB_BATCH_MAX];
+    int active_num;
+    /* a submit is in progress, its completion may arrive before it returns */
+    int kicking;
+};
+
+int hal_job_queue_attach(struct hal_job_queue *queue, void *backend, int max_batch);
+int hal_job_queue_push(struct hal_job_queue *queue, struct hal_job *job);
+void hal_job_queue_complete(struct hal_job_queue *queue, int status);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,149 @@
+/*
+ * ===========================================================================================
+ *
+ *       Filename:  hal_job_queue.c
+ *
+ *    Description:  submit/complete queue shared by the asynchronous hal services,
+ *                  the dma memcpy service and the CE job queue. Only talks to the
+ *                  backend through the queue's submit(), so it also builds on the
+ *                  host (utility/host-tool/dma_async_test, ce_queue_test).
+ *
+ *        Version:  Melis3.0
+ *         Create:  2026-10-19 10:00:00
+ *       Revision:  none
+ *
+ * ===========================================================================================
+ */
+
+#include <hal_job_queue.h>
+#include <hal_atomic.h>
+
+/* Start queued batches until one is in flight or the queue is empty. */
+static void hal_job_queue_kick(struct hal_job_queue *queue)
+{
+    struct hal_job *batch[HAL_JOB_BATCH_MAX];
+    uint32_t __cpsr;
+    int i, num, ret;
+
+    for (;;)
+    {
+        __cpsr = hal_spin_lock_irqsave();
+        if (queue->active_num || queue->kicking || !queue->head)
+        {
+            hal_spin_unlock_irqrestore(__cpsr);
+            return;
+        }
+        for (num = 0; num < queue->max_batch && queue->head; num++)
+        {
+            batch[num] = queue->head;
+            queue->head = queue->head->next;
+            queue->active[num] = batch[num];
+        }
+        if (!queue->head)
+        {
+            queue->tail = NULL;
+        }
+        queue->active_num = num;
+        queue->kicking = 1;
+        hal_spin_unlock_irqrestore(__cpsr);
+
+        ret = queue->submit(queue->backend, batch, num);
+
+        __cpsr = hal_spin_lock_irqsave();
+        queue->kicking = 0;
+        if (ret != 0)
+        {
+            queue->active_num = 0;
+        }
+        hal_spin_unlock_irqrestore(__cpsr);
+
+        if (ret != 0)
+        {
+            for (i = 0; i < num; i++)
+            {
+                queue->done(batch[i], ret);
+            }
+        }
+        /* loop: the batch may already have completed inside submit */
+    }
+}
+
+/* The backend finished the batch in flight. */
+void hal_job_queue_complete(struct hal_job_queue *queue, int status)
+{
+    struct hal_job *batch[HAL_JOB_BATCH_MAX];
+    uint32_t __cpsr;
+    int i, num;
+
+    __cpsr = hal_spin_lock_irqsave();
+    num = queue->active_num;
+    for (i = 0; i < num; i++)
+    {
+        batch[i] = queue->active[i];
+    }
+    queue->active_num = 0;
+    hal_spin_unlock_irqrestore(__cpsr);
+
+    for (i = 0; i < num; i++)
+    {
+        queue->done(batch[i], status);
+    }
+    hal_job_queue_kick(queue);
+}
+
+/*
+ * Set the backend the jobs go to, NULL to refuse new jobs. Fails with -1
+ * while jobs are queued or in flight.
+ */
+int hal_job_queue_attach(struct hal_job_queue *queue, void *backend, int max_batch)
+{
+    uint32_t __cpsr;
+    int ret = 0;
+
+    if (max_batch <= 0 || max_batch > HAL_JOB_BATCH_MAX)
+    {
+        max_batch = HAL_JOB_BATCH_MAX;
+    }
+
+    __cpsr = hal_spin_lock_irqsave();
+    if (queue->active_num || queue->head)
+    {
+        ret = -1;
+    }
+    else
+    {
+        queue->backend = backend;
+        queue->max_batch = max_batch;
+    }
+    hal_spin_unlock_irqrestore(__cpsr);
+
+    return ret;
+}
+
+/* Queue a job and start it if the backend is idle. -1 without a backend. */
+int hal_job_queue_push(struct hal_job_queue *queue, struct hal_job *job)
+{
+    uint32_t __cpsr;
+
+    job->next = NULL;
+
+    __cpsr = hal_spin_lock_irqsave();
+    if (!queue->backend)
+    {
+        hal_spin_unlock_irqrestore(__cpsr);
+        return -1;
+    }
+    if (queue->tail)
+    {
+        queue->tail->next = job;
+    }
+    else
+    {
+        queue->head = job;
+    }
+    queue->tail = job;
+    hal_spin_unlock_irqrestore(__cpsr);
+
+    hal_job_queue_kick(queue);
+    return 0;
+}
@@ -56,6 +56,7 @@
 #include "_core.h"
 #include "osal/os/RT-Thread/os_util.h"
 #include "interrupt.h"
+#include <sunxi_hal_dma.h>
 
 //#include "k_arch.h"
 extern uint32_t sdmmc_pinctrl_init(struct mmc_host *host);
@@ -1641,7 +1642,8 @@ int32_t rom_HAL_SDC_Request(struct mmc_host *host, struct mmc_request *mrq)
 					for (i = 0; i < sg_len; i++) {
 						addr = (uint32_t) sg[i].buffer;
 						len = sg[i].len;
-						HAL_Memcpy((char *)(host->align_dma_buf + total_len), (char *)addr, len);
+						/* offloaded to the dma memcpy service once it is up */
+						hal_dma_memcpy((char *)(host->align_dma_buf + total_len), (char *)addr, len);
 						total_len += len;
 					}
 				}
@@ -1665,7 +1667,7 @@ int32_t rom_HAL_SDC_Request(struct mmc_host *host, struct mmc_request *mrq)
 			for (i = 0; i < sg_len; i++) {
 				addr = (uint32_t) sg[i].buffer;
 				len = sg[i].len;
-				HAL_Memcpy((char *)addr, (char *)(host->align_dma_buf + total_len), len);
+				hal_dma_memcpy((char *)addr, (char *)(host->align_dma_buf + total_len), len);
 				total_len += len;
 			}
 			SDC_LOGD("copy back to dst buffer%ld\n", byte_cnt);
@@ -0,0 +1,457 @@
+/*
+* Copyright (c) 2019-2025 Allwinner Technology Co., Ltd. ALL rights reserved.
+*
+* Allwinner is a trademark of Allwinner Technology Co.,Ltd., registered in
+* the the people's Republic of China and other countries.
+* All Allwinner Technology Co.,Ltd. trademarks are used with permission.
+*
+* DISCLAIMER
+* THIRD PARTY LICENCES MAY BE REQUIRED TO IMPLEMENT THE SOLUTION/PRODUCT.
+* IF YOU NEED TO INTEGRATE THIRD PARTY’S TECHNOLOGY (SONY, DTS, DOLBY, AVS OR MPEGLA, ETC.)
+* IN ALLWINNERS’SDK OR PRODUCTS, YOU SHALL BE SOLELY RESPONSIBLE TO OBTAIN
+* ALL APPROPRIATELY REQUIRED THIRD PARTY LICENCES.
+* ALLWINNER SHALL HAVE NO WARRANTY, INDEMNITY OR OTHER OBLIGATIONS WITH RESPECT TO MATTERS
+* COVERED UNDER ANY REQUIRED THIRD PARTY LICENSE.
+* YOU ARE SOLELY RESPONSIBLE FOR YOUR USAGE OF THIRD PARTY’S TECHNOLOGY.
+*
+*
+* THIS SOFTWARE IS PROVIDED BY ALLWINNER"AS IS" AND TO THE MAXIMUM EXTENT
+* PERMITTED BY LAW, ALLWINNER EXPRESSLY DISCLAIMS ALL WARRANTIES OF ANY KIND,
+* WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING WITHOUT LIMITATION REGARDING
+* THE TITLE, NON-INFRINGEMENT, ACCURACY, CONDITION, COMPLETENESS, PERFORMANCE
+* OR MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* IN NO EVENT SHALL ALLWINNER BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS, OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+* OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <string.h>
+#include "pcm_conv.h"
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * Plain loops over restrict pointers, built with -ftree-vectorize (see the
+ * Makefile). Gains go through NEON by hand: the 64 bit products of the 32
+ * bit case are beyond what the vectorizer makes of them on armv7.
+ */
+
+static inline int32_t sat16(int32_t v)
+{
+	return v > 0x7fff ? 0x7fff : v < -0x8000 ? -0x8000 : v;
+}
+
+static inline int32_t sat32(int64_t v)
+{
+	return v > 0x7fffffffLL ? 0x7fffffff : v < -0x80000000LL ? (int32_t)0x80000000 : (int32_t)v;
+}
+
+/*
+ * Format conversion, the same bits as the conv_* labels of plugin_ops.h.
+ * S24 is S24_LE, 24 bits in the low bytes of 32.
+ */
+static void conv_s16_s24(void *dst, const void *src, unsigned int n)
+{
+	int32_t *__restrict d = dst;
+	const int16_t *__restrict s = src;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		d[i] = (int32_t)((uint32_t)s[i] << 8);
+}
+
+static void conv_s16_s32(void *dst, const void *src, unsigned int n)
+{
+	int32_t *__restrict d = dst;
+	const int16_t *__restrict s = src;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		d[i] = (int32_t)((uint32_t)s[i] << 16);
+}
+
+static void conv_s24_s16(void *dst, const void *src, unsigned int n)
+{
+	int16_t *__restrict d = dst;
+	const int32_t *__restrict s = src;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		d[i] = (int16_t)(s[i] >> 8);
+}
+
+static void conv_s24_s24(void *dst, const void *src, unsigned int n)
+{
+	int32_t *__restrict d = dst;
+	const int32_t *__restrict s = src;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		d[i] = (int32_t)((uint32_t)s[i] << 8) >> 8;
+}
+
+static void conv_s24_s32(void *dst, const void *src, unsigned int n)
+{
+	int32_t *__restrict d = dst;
+	const int32_t *__restrict s = src;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		d[i] = (int32_t)((uint32_t)s[i] << 8);
+}
+
+static void conv_s32_s16(void *dst, const void *src, unsigned int n)
+{
+	int16_t *__restrict d = dst;
+	const int32_t *__restrict s = src;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		d[i] = (int16_t)(s[i] >> 16);
+}
+
+static void conv_s32_s24(void *dst, const void *src, unsigned int n)
+{
+	int32_t *__restrict d = dst;
+	const int32_t *__restrict s = src;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		d[i] = s[i] >> 8;
+}
+
+static void conv_copy16(void *dst, const void *src, unsigned int n)
+{
+	memcpy(dst, src, n * sizeof(int16_t));
+}
+
+static void conv_copy32(void *dst, const void *src, unsigned int n)
+{
+	memcpy(dst, src, n * sizeof(int32_t));
+}
+
+static int conv_format_index(snd_pcm_format_t format)
+{
+	switch (format) {
+	case SND_PCM_FORMAT_S16_LE:
+		return 0;
+	case SND_PCM_FORMAT_S24_LE:
+		return 1;
+	case SND_PCM_FORMAT_S32_LE:
+		return 2;
+	default:
+		return -1;
+	}
+}
+
+snd_pcm_conv_func_t snd_pcm_conv_find(snd_pcm_format_t src_format,
+				      snd_pcm_format_t dst_format)
+{
+	static const snd_pcm_conv_func_t funcs[3][3] = {
+		{ conv_copy16, conv_s16_s24, conv_s16_s32 },
+		{ conv_s24_s16, conv_s24_s24, conv_s24_s32 },
+		{ conv_s32_s16, conv_s32_s24, conv_copy32 },
+	};
+	int s = conv_format_index(src_format), d = conv_format_index(dst_format);
+
+	if (s < 0 || d < 0)
+		return NULL;
+	return funcs[s][d];
+}
+
+/*
+ * Gains. MULTI_DIV_short/int of pcm_softvol.c come down to the product
+ * shifted right by 16 and saturated. The loops run over whole frames;
+ * when the channel count divides 8 the gains of 8 samples in a row are
+ * always the same, which is what the blocks of 8 below are for.
+ */
+static unsigned int gain_pattern(unsigned int channels, const unsigned int *gain,
+				 int32_t *pattern)
+{
+	unsigned int i, max = 0;
+
+	for (i = 0; i < 8; i++) {
+		pattern[i] = gain[i % channels];
+		if (gain[i % channels] > max)
+			max = gain[i % channels];
+	}
+	return max;
+}
+
+static void scale_frames_s16(int16_t *__restrict dst, const int16_t *__restrict src,
+			     unsigned int frames, unsigned int channels,
+			     const unsigned int *gain)
+{
+	unsigned int f, c;
+
+	for (f = 0; f < frames; f++, src += channels, dst += channels)
+		for (c = 0; c < channels; c++)
+			dst[c] = sat16(((int64_t)src[c] * gain[c]) >> 16);
+}
+
+static void scale_frames_s32(int32_t *__restrict dst, const int32_t *__restrict src,
+			     unsigned int frames, unsigned int channels,
+			     const unsigned int *gain)
+{
+	unsigned int f, c;
+
+	for (f = 0; f < frames; f++, src += channels, dst += channels)
+		for (c = 0; c < channels; c++)
+			dst[c] = sat32(((int64_t)src[c] * gain[c]) >> 16);
+}
+
+void snd_pcm_conv_scale_s16(int16_t *dst, const int16_t *src,
+			    unsigned int frames, unsigned int channels,
+			    const unsigned int *gain)
+{
+	int32_t g[8];
+	unsigned int i = 0, k, n = frames * channels;
+
+	if (8 % channels) {
+		scale_frames_s16(dst, src, frames, channels, gain);
+		return;
+	}
+	if (gain_pattern(channels, gain, g) > SND_PCM_CONV_UNITY) {
+		/* boost, the products need 64 bits */
+		scale_frames_s16(dst, src, frames, channels, gain);
+		return;
+	}
+
+	/* at most unity: the product fits 32 bits and the result 16 */
+#ifdef __ARM_NEON
+	{
+		int32x4_t g_lo = vld1q_s32(g), g_hi = vld1q_s32(g + 4);
+
+		for (; i + 8 <= n; i += 8) {
+			int16x8_t s = vld1q_s16(src + i);
+			int32x4_t lo = vmulq_s32(vmovl_s16(vget_low_s16(s)), g_lo);
+			int32x4_t hi = vmulq_s32(vmovl_s16(vget_high_s16(s)), g_hi);
+
+			vst1q_s16(dst + i, vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16)));
+		}
+	}
+#endif
+	for (; i + 8 <= n; i += 8)
+		for (k = 0; k < 8; k++)
+			dst[i + k] = (src[i + k] * g[k]) >> 16;
+	for (k = 0; i < n; i++, k++)
+		dst[i] = (src[i] * g[k]) >> 16;
+}
+
+void snd_pcm_conv_scale_s32(int32_t *dst, const int32_t *src,
+			    unsigned int frames, unsigned int channels,
+			    const unsigned int *gain)
+{
+	int32_t g[8];
+	unsigned int i = 0, k, n = frames * channels;
+	int boost;
+
+	if (8 % channels) {
+		scale_frames_s32(dst, src, frames, channels, gain);
+		return;
+	}
+	boost = gain_pattern(channels, gain, g) > SND_PCM_CONV_UNITY;
+
+#ifdef __ARM_NEON
+	{
+		int32x4_t g_lo = vld1q_s32(g), g_hi = vld1q_s32(g + 4);
+
+		for (; i + 8 <= n; i += 8) {
+			int32x4_t a = vld1q_s32(src + i), b = vld1q_s32(src + i + 4);
+
+			/* saturating narrow of the 64 bit product >> 16 */
+			vst1q_s32(dst + i, vcombine_s32(
+				vqshrn_n_s64(vmull_s32(vget_low_s32(a), vget_low_s32(g_lo)), 16),
+				vqshrn_n_s64(vmull_s32(vget_high_s32(a), vget_high_s32(g_lo)), 16)));
+			vst1q_s32(dst + i + 4, vcombine_s32(
+				vqshrn_n_s64(vmull_s32(vget_low_s32(b), vget_low_s32(g_hi)), 16),
+				vqshrn_n_s64(vmull_s32(vget_high_s32(b), vget_high_s32(g_hi)), 16)));
+		}
+	}
+#endif
+	if (!boost) {
+		/* at most unity, nothing to clamp */
+		for (; i + 8 <= n; i += 8)
+			for (k = 0; k < 8; k++)
+				dst[i + k] = ((int64_t)src[i + k] * g[k]) >> 16;
+	}
+	for (; i + 8 <= n; i += 8)
+		for (k = 0; k < 8; k++)
+			dst[i + k] = sat32(((int64_t)src[i + k] * g[k]) >> 16);
+	for (k = 0; i < n; i++, k++)
+		dst[i] = sat32(((int64_t)src[i] * g[k]) >> 16);
+}
+
+/*
+ * Ramps step every frame, in Q16 of the gain, and land on the new gains on
+ * the last frame of the call.
+ */
+#define RAMP_FRAMES(TYPE, sat)							\
+	do {									\
+		int64_t step[SND_PCM_CONV_MAX_CHANNELS], pos[SND_PCM_CONV_MAX_CHANNELS]; \
+		unsigned int f, c;						\
+										\
+		if (!frames)							\
+			return;							\
+		for (c = 0; c < channels; c++) {				\
+			step[c] = ((int64_t)to[c] - from[c]) * 65536 / frames;	\
+			pos[c] = 0;						\
+		}								\
+		for (f = 0; f + 1 < frames; f++, src += channels, dst += channels) { \
+			for (c = 0; c < channels; c++) {			\
+				int64_t g;					\
+										\
+				pos[c] += step[c];				\
+				g = from[c] + (pos[c] >> 16);			\
+				dst[c] = (TYPE)sat(((int64_t)src[c] * g) >> 16); \
+			}							\
+		}								\
+		for (c = 0; c < channels; c++)					\
+			dst[c] = (TYPE)sat(((int64_t)src[c] * to[c]) >> 16);	\
+	} while (0)
+
+void snd_pcm_conv_ramp_s16(int16_t *dst, const int16_t *src,
+			   unsigned int frames, unsigned int channels,
+			   const unsigned int *from, const unsigned int *to)
+{
+	RAMP_FRAMES(int16_t, sat16);
+}
+
+void snd_pcm_conv_ramp_s32(int32_t *dst, const int32_t *src,
+			   unsigned int frames, unsigned int channels,
+			   const unsigned int *from, const unsigned int *to)
+{
+	RAMP_FRAMES(int32_t, sat32);
+}
+
+/*
+ * Routing, the integer version of snd_pcm_route_convert1_many(): with S16
+ * sources (sample << 16) times weight / 16 is exact in the float version
+ * of the plugin as well, so both give these samples.
+ */
+enum { ROUTE_ZERO, ROUTE_ONE, ROUTE_MIX };
+
+struct route_op {
+	int kind;
+	unsigned int src;	/* ROUTE_ONE */
+};
+
+static int route_ops(const snd_pcm_conv_route_t *route, struct route_op *ops)
+{
+	unsigned int d, s, n;
+	int full = 1;
+
+	for (d = 0; d < route->dst_channels; d++) {
+		n = 0;
+		for (s = 0; s < route->src_channels; s++) {
+			if (route->weight[d][s] > 16)
+				return -1;
+			if (route->weight[d][s]) {
+				ops[d].src = s;
+				full = route->weight[d][s] == 16;
+				n++;
+			}
+		}
+		ops[d].kind = !n ? ROUTE_ZERO : n == 1 && full ? ROUTE_ONE : ROUTE_MIX;
+	}
+	return 0;
+}
+
+int snd_pcm_conv_route_supported(const snd_pcm_conv_route_t *route)
+{
+	struct route_op ops[SND_PCM_CONV_MAX_CHANNELS];
+	unsigned int d;
+
+	if (route->src_channels > SND_PCM_CONV_MAX_CHANNELS ||
+	    route->dst_channels > SND_PCM_CONV_MAX_CHANNELS ||
+	    !route->src_channels || !route->dst_channels)
+		return 0;
+	if ((route->src_format != SND_PCM_FORMAT_S16_LE &&
+	     route->src_format != SND_PCM_FORMAT_S32_LE) ||
+	    (route->dst_format != SND_PCM_FORMAT_S16_LE &&
+	     route->dst_format != SND_PCM_FORMAT_S32_LE))
+		return 0;
+	if (route_ops(route, ops))
+		return 0;
+	for (d = 0; d < route->dst_channels; d++)
+		if (ops[d].kind == ROUTE_MIX && route->src_format != SND_PCM_FORMAT_S16_LE)
+			return 0;
+	return 1;
+}
+
+/* the common mono and stereo cases, loops the vectorizer can take */
+static int route_s16_fast(int16_t *__restrict dst, const int16_t *__restrict src,
+			  unsigned int frames, const snd_pcm_conv_route_t *route,
+			  const struct route_op *ops)
+{
+	unsigned int f;
+
+	if (route->src_channels == 1 && route->dst_channels == 2 &&
+	    ops[0].kind == ROUTE_ONE && ops[1].kind == ROUTE_ONE) {
+		for (f = 0; f < frames; f++) {
+			dst[2 * f] = src[f];
+			dst[2 * f + 1] = src[f];
+		}
+		return 1;
+	}
+	if (route->src_channels == 2 && route->dst_channels == 1 &&
+	    ops[0].kind == ROUTE_MIX) {
+		int32_t w0 = route->weight[0][0], w1 = route->weight[0][1];
+
+		for (f = 0; f < frames; f++)
+			dst[f] = sat16((src[2 * f] * w0 + src[2 * f + 1] * w1) >> 4);
+		return 1;
+	}
+	return 0;
+}
+
+void snd_pcm_conv_route(void *dst, const void *src, unsigned int frames,
+			const snd_pcm_conv_route_t *route)
+{
+	struct route_op ops[SND_PCM_CONV_MAX_CHANNELS];
+	unsigned int sch = route->src_channels, dch = route->dst_channels;
+	int src16 = route->src_format == SND_PCM_FORMAT_S16_LE;
+	int dst16 = route->dst_format == SND_PCM_FORMAT_S16_LE;
+	const int16_t *s16 = src;
+	const int32_t *s32 = src;
+	int16_t *d16 = dst;
+	int32_t *d32 = dst;
+	unsigned int f, d, s;
+
+	route_ops(route, ops);
+	if (src16 && dst16 && route_s16_fast(dst, src, frames, route, ops))
+		return;
+
+	for (f = 0; f < frames; f++) {
+		for (d = 0; d < dch; d++) {
+			int32_t v;
+
+			/* in the S32 domain of the plugin's get32/put32 */
+			if (ops[d].kind == ROUTE_ONE) {
+				v = src16 ? (int32_t)((uint32_t)s16[ops[d].src] << 16) : s32[ops[d].src];
+			} else if (ops[d].kind == ROUTE_MIX) {
+				int32_t acc = 0;
+
+				for (s = 0; s < sch; s++)
+					acc += s16[s] * route->weight[d][s];
+				v = sat32((int64_t)acc << 12);
+			} else {
+				v = 0;
+			}
+			if (dst16)
+				d16[d] = v >> 16;
+			else
+				d32[d] = v;
+		}
+		s16 += sch;
+		s32 += sch;
+		d16 += dch;
+		d32 += dch;
+	}
+}
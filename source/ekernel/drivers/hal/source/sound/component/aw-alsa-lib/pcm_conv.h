@@ -0,0 +1,89 @@
+/*
+* Copyright (c) 2019-2025 Allwinner Technology Co., Ltd. ALL rights reserved.
+*
+* Allwinner is a trademark of Allwinner Technology Co.,Ltd., registered in
+* the the people's Republic of China and other countries.
+* All Allwinner Technology Co.,Ltd. trademarks are used with permission.
+*
+* DISCLAIMER
+* THIRD PARTY LICENCES MAY BE REQUIRED TO IMPLEMENT THE SOLUTION/PRODUCT.
+* IF YOU NEED TO INTEGRATE THIRD PARTY’S TECHNOLOGY (SONY, DTS, DOLBY, AVS OR MPEGLA, ETC.)
+* IN ALLWINNERS’SDK OR PRODUCTS, YOU SHALL BE SOLELY RESPONSIBLE TO OBTAIN
+* ALL APPROPRIATELY REQUIRED THIRD PARTY LICENCES.
+* ALLWINNER SHALL HAVE NO WARRANTY, INDEMNITY OR OTHER OBLIGATIONS WITH RESPECT TO MATTERS
+* COVERED UNDER ANY REQUIRED THIRD PARTY LICENSE.
+* YOU ARE SOLELY RESPONSIBLE FOR YOUR USAGE OF THIRD PARTY’S TECHNOLOGY.
+*
+*
+* THIS SOFTWARE IS PROVIDED BY ALLWINNER"AS IS" AND TO THE MAXIMUM EXTENT
+* PERMITTED BY LAW, ALLWINNER EXPRESSLY DISCLAIMS ALL WARRANTIES OF ANY KIND,
+* WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING WITHOUT LIMITATION REGARDING
+* THE TITLE, NON-INFRINGEMENT, ACCURACY, CONDITION, COMPLETENESS, PERFORMANCE
+* OR MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* IN NO EVENT SHALL ALLWINNER BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS, OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+* OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __AW_ALSA_PCM_CONV_H
+#define __AW_ALSA_PCM_CONV_H
+
+#include <stdint.h>
+#include <sound/pcm_common.h>
+
+/*
+ * Packed loops for the plugins: whole periods of interleaved, native
+ * endian samples in one pass, instead of a call or a jump per sample.
+ * Each gives the same samples as the generic path it stands in for.
+ */
+
+#define SND_PCM_CONV_MAX_CHANNELS	8
+
+/* gains are Q16, 0 is silence */
+#define SND_PCM_CONV_UNITY		(1 << 16)
+
+/* n samples from one linear format to another */
+typedef void (*snd_pcm_conv_func_t)(void *dst, const void *src, unsigned int n);
+
+snd_pcm_conv_func_t snd_pcm_conv_find(snd_pcm_format_t src_format,
+				      snd_pcm_format_t dst_format);
+
+/* frames times a gain per channel, saturated, as softvol's MULTI_DIV */
+void snd_pcm_conv_scale_s16(int16_t *dst, const int16_t *src,
+			    unsigned int frames, unsigned int channels,
+			    const unsigned int *gain);
+void snd_pcm_conv_scale_s32(int32_t *dst, const int32_t *src,
+			    unsigned int frames, unsigned int channels,
+			    const unsigned int *gain);
+
+/* the same with the gains moving linearly from one set to the other */
+void snd_pcm_conv_ramp_s16(int16_t *dst, const int16_t *src,
+			   unsigned int frames, unsigned int channels,
+			   const unsigned int *from, const unsigned int *to);
+void snd_pcm_conv_ramp_s32(int32_t *dst, const int32_t *src,
+			   unsigned int frames, unsigned int channels,
+			   const unsigned int *from, const unsigned int *to);
+
+/*
+ * A route table in 1/16 steps, as the integer route plugin: each dst
+ * channel is the sum of its sources times weight / 16. A dst channel with
+ * a single full weight source is a plain conversion of it, any other mix
+ * needs S16 sources.
+ */
+typedef struct {
+	snd_pcm_format_t src_format;
+	snd_pcm_format_t dst_format;
+	unsigned int src_channels;
+	unsigned int dst_channels;
+	unsigned char weight[SND_PCM_CONV_MAX_CHANNELS][SND_PCM_CONV_MAX_CHANNELS];
+} snd_pcm_conv_route_t;
+
+int snd_pcm_conv_route_supported(const snd_pcm_conv_route_t *route);
+void snd_pcm_conv_route(void *dst, const void *src, unsigned int frames,
+			const snd_pcm_conv_route_t *route);
+
+#endif /* __AW_ALSA_PCM_CONV_H */
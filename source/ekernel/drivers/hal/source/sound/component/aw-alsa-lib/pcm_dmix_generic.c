@@ -293,17 +293,366 @@ static void generic_remix_areas_u8(unsigned int size,
 }
 
 
+/*
+ * Packed versions, for interleaved streams where mix_areas() passes the
+ * whole transfer in one call: samples back to back, one sum per sample.
+ * They are branch free and bit exact with the loops above: a silent dst
+ * sample means "first writer", which here zeroes the old sum instead of
+ * taking a branch. NEON does 8 (4 for 32 bit) samples per step, the C
+ * loops do the rest, and the whole stream on cores without NEON, where
+ * the compiler can vectorize them.
+ */
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+
+/* sign extend the halves of a 16 bit lane mask to 32 bits */
+#define neon_mask_lo(m)	vreinterpretq_u32_s32(vmovl_s16(vreinterpret_s16_u16(vget_low_u16(m))))
+#define neon_mask_hi(m)	vreinterpretq_u32_s32(vmovl_s16(vreinterpret_s16_u16(vget_high_u16(m))))
+#endif
+
+static inline signed int sat16(signed int sample)
+{
+	return sample > 0x7fff ? 0x7fff : sample < -0x8000 ? -0x8000 : sample;
+}
+
+static inline signed int sat24(signed int sample)
+{
+	return sample > 0x7fffff ? 0x7fffff : sample < -0x800000 ? -0x800000 : sample;
+}
+
+/* sum in 24 bits to a 32 bit sample, as generic_mix_areas_32_native() */
+static inline signed int sat24_to_32(signed int sample)
+{
+	return sample > 0x7fffff ? 0x7fffffff :
+		sample < -0x800000 ? (signed int)0x80000000 : sample * 256;
+}
+
+static void mix_packed_16(unsigned int size, signed short *__restrict dst,
+			  const signed short *__restrict src, signed int *__restrict sum)
+{
+	unsigned int i = 0;
+	signed int t;
+
+#ifdef __ARM_NEON
+	for (; i + 8 <= size; i += 8) {
+		int16x8_t s = vld1q_s16(src + i);
+		uint16x8_t z = vceqq_s16(vld1q_s16(dst + i), vdupq_n_s16(0));
+		int32x4_t lo = vld1q_s32(sum + i), hi = vld1q_s32(sum + i + 4);
+
+		lo = vaddq_s32(vbicq_s32(lo, vreinterpretq_s32_u32(neon_mask_lo(z))),
+			       vmovl_s16(vget_low_s16(s)));
+		hi = vaddq_s32(vbicq_s32(hi, vreinterpretq_s32_u32(neon_mask_hi(z))),
+			       vmovl_s16(vget_high_s16(s)));
+		vst1q_s32(sum + i, lo);
+		vst1q_s32(sum + i + 4, hi);
+		vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+	}
+#endif
+	for (; i < size; i++) {
+		t = (dst[i] ? sum[i] : 0) + src[i];
+		sum[i] = t;
+		dst[i] = sat16(t);
+	}
+}
+
+static void remix_packed_16(unsigned int size, signed short *__restrict dst,
+			    const signed short *__restrict src, signed int *__restrict sum)
+{
+	unsigned int i = 0;
+	signed int t;
+
+#ifdef __ARM_NEON
+	for (; i + 8 <= size; i += 8) {
+		int16x8_t s = vld1q_s16(src + i);
+		uint16x8_t z = vceqq_s16(vld1q_s16(dst + i), vdupq_n_s16(0));
+		int32x4_t lo = vld1q_s32(sum + i), hi = vld1q_s32(sum + i + 4);
+
+		lo = vsubq_s32(vbicq_s32(lo, vreinterpretq_s32_u32(neon_mask_lo(z))),
+			       vmovl_s16(vget_low_s16(s)));
+		hi = vsubq_s32(vbicq_s32(hi, vreinterpretq_s32_u32(neon_mask_hi(z))),
+			       vmovl_s16(vget_high_s16(s)));
+		vst1q_s32(sum + i, lo);
+		vst1q_s32(sum + i + 4, hi);
+		/* a first writer stores -src unsaturated */
+		vst1q_s16(dst + i, vbslq_s16(z, vnegq_s16(s),
+					     vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi))));
+	}
+#endif
+	for (; i < size; i++) {
+		t = (dst[i] ? sum[i] : 0) - src[i];
+		sum[i] = t;
+		dst[i] = dst[i] ? sat16(t) : (signed short)t;
+	}
+}
+
+static void mix_packed_32(unsigned int size, signed int *__restrict dst,
+			  const signed int *__restrict src, signed int *__restrict sum)
+{
+	unsigned int i = 0;
+	signed int t;
+
+#ifdef __ARM_NEON
+	for (; i + 4 <= size; i += 4) {
+		int32x4_t s = vld1q_s32(src + i);
+		uint32x4_t z = vceqq_s32(vld1q_s32(dst + i), vdupq_n_s32(0));
+		int32x4_t v = vld1q_s32(sum + i);
+
+		v = vaddq_s32(vbicq_s32(v, vreinterpretq_s32_u32(z)), vshrq_n_s32(s, 8));
+		vst1q_s32(sum + i, v);
+		/* a saturating shift is the clamp of sat24_to_32() */
+		vst1q_s32(dst + i, vbslq_s32(z, s, vqshlq_n_s32(v, 8)));
+	}
+#endif
+	for (; i < size; i++) {
+		t = (dst[i] ? sum[i] : 0) + (src[i] >> 8);
+		sum[i] = t;
+		dst[i] = dst[i] ? sat24_to_32(t) : src[i];
+	}
+}
+
+static void remix_packed_32(unsigned int size, signed int *__restrict dst,
+			    const signed int *__restrict src, signed int *__restrict sum)
+{
+	unsigned int i = 0;
+	signed int t;
+
+#ifdef __ARM_NEON
+	for (; i + 4 <= size; i += 4) {
+		int32x4_t s = vld1q_s32(src + i);
+		uint32x4_t z = vceqq_s32(vld1q_s32(dst + i), vdupq_n_s32(0));
+		int32x4_t v = vld1q_s32(sum + i);
+
+		v = vsubq_s32(vbicq_s32(v, vreinterpretq_s32_u32(z)), vshrq_n_s32(s, 8));
+		vst1q_s32(sum + i, v);
+		vst1q_s32(dst + i, vbslq_s32(z, vnegq_s32(s), vqshlq_n_s32(v, 8)));
+	}
+#endif
+	for (; i < size; i++) {
+		t = (dst[i] ? sum[i] : 0) - (src[i] >> 8);
+		sum[i] = t;
+		dst[i] = dst[i] ? sat24_to_32(t) : (signed int)(0u - (unsigned int)src[i]);
+	}
+}
+
+/* S24_LE, 24 bits in the low bytes of 32, the top byte of dst is kept */
+static void mix_packed_24(unsigned int size, unsigned int *__restrict dst,
+			  const unsigned int *__restrict src, signed int *__restrict sum)
+{
+	unsigned int i = 0;
+	signed int t;
+
+#ifdef __ARM_NEON
+	const uint32x4_t low = vdupq_n_u32(0xffffff);
+
+	for (; i + 4 <= size; i += 4) {
+		uint32x4_t d = vld1q_u32(dst + i);
+		int32x4_t s = vshrq_n_s32(vshlq_n_s32(vreinterpretq_s32_u32(vld1q_u32(src + i)), 8), 8);
+		uint32x4_t nz = vtstq_u32(d, low);
+		int32x4_t v = vld1q_s32(sum + i);
+
+		v = vaddq_s32(vandq_s32(v, vreinterpretq_s32_u32(nz)), s);
+		vst1q_s32(sum + i, v);
+		v = vminq_s32(vmaxq_s32(v, vdupq_n_s32(-0x800000)), vdupq_n_s32(0x7fffff));
+		vst1q_u32(dst + i, vbslq_u32(low, vreinterpretq_u32_s32(v), d));
+	}
+#endif
+	for (; i < size; i++) {
+		t = ((dst[i] & 0xffffff) ? sum[i] : 0) + ((signed int)(src[i] << 8) >> 8);
+		sum[i] = t;
+		dst[i] = (dst[i] & 0xff000000) | (sat24(t) & 0xffffff);
+	}
+}
+
+static void remix_packed_24(unsigned int size, unsigned int *__restrict dst,
+			    const unsigned int *__restrict src, signed int *__restrict sum)
+{
+	unsigned int i = 0;
+	signed int t;
+
+#ifdef __ARM_NEON
+	const uint32x4_t low = vdupq_n_u32(0xffffff);
+
+	for (; i + 4 <= size; i += 4) {
+		uint32x4_t d = vld1q_u32(dst + i);
+		int32x4_t s = vshrq_n_s32(vshlq_n_s32(vreinterpretq_s32_u32(vld1q_u32(src + i)), 8), 8);
+		uint32x4_t nz = vtstq_u32(d, low);
+		int32x4_t v = vld1q_s32(sum + i);
+
+		v = vsubq_s32(vandq_s32(v, vreinterpretq_s32_u32(nz)), s);
+		vst1q_s32(sum + i, v);
+		/* a first writer stores -src unsaturated */
+		v = vbslq_s32(nz, vminq_s32(vmaxq_s32(v, vdupq_n_s32(-0x800000)),
+					    vdupq_n_s32(0x7fffff)), v);
+		vst1q_u32(dst + i, vbslq_u32(low, vreinterpretq_u32_s32(v), d));
+	}
+#endif
+	for (; i < size; i++) {
+		t = ((dst[i] & 0xffffff) ? sum[i] : 0) - ((signed int)(src[i] << 8) >> 8);
+		sum[i] = t;
+		dst[i] = (dst[i] & 0xff000000) |
+			 (((dst[i] & 0xffffff) ? sat24(t) : t) & 0xffffff);
+	}
+}
+
+static void mix_packed_u8(unsigned int size, unsigned char *__restrict dst,
+			  const unsigned char *__restrict src, signed int *__restrict sum)
+{
+	unsigned int i;
+	signed int t;
+
+	for (i = 0; i < size; i++) {
+		t = (dst[i] != 0x80 ? sum[i] : 0) + src[i] - 0x80;
+		sum[i] = t;
+		dst[i] = (t > 0x7f ? 0x7f : t < -0x80 ? -0x80 : t) + 0x80;
+	}
+}
+
+static void remix_packed_u8(unsigned int size, unsigned char *__restrict dst,
+			    const unsigned char *__restrict src, signed int *__restrict sum)
+{
+	unsigned int i;
+	signed int t;
+
+	for (i = 0; i < size; i++) {
+		t = (dst[i] != 0x80 ? sum[i] : 0) - (src[i] - 0x80);
+		sum[i] = t;
+		if (dst[i] != 0x80)
+			t = t > 0x7f ? 0x7f : t < -0x80 ? -0x80 : t;
+		dst[i] = t + 0x80;
+	}
+}
+
+/* the packed layout, aligned for the casts of the 24 bit version */
+#define dmix_packed(dst, src, sum, dst_step, src_step, sum_step, width)		\
+	((dst_step) == (width) && (src_step) == (width) &&			\
+	 (sum_step) == sizeof(signed int) &&					\
+	 !(((unsigned long)(dst) | (unsigned long)(src)) & ((width) - 1)) &&	\
+	 !((unsigned long)(sum) & (sizeof(signed int) - 1)))
+
+static void packed_mix_areas_16(unsigned int size,
+				volatile signed short *dst,
+				signed short *src,
+				volatile signed int *sum,
+				size_t dst_step,
+				size_t src_step,
+				size_t sum_step)
+{
+	if (dmix_packed(dst, src, sum, dst_step, src_step, sum_step, 2))
+		mix_packed_16(size, (signed short *)dst, src, (signed int *)sum);
+	else
+		generic_mix_areas_16_native(size, dst, src, sum, dst_step, src_step, sum_step);
+}
+
+static void packed_remix_areas_16(unsigned int size,
+				  volatile signed short *dst,
+				  signed short *src,
+				  volatile signed int *sum,
+				  size_t dst_step,
+				  size_t src_step,
+				  size_t sum_step)
+{
+	if (dmix_packed(dst, src, sum, dst_step, src_step, sum_step, 2))
+		remix_packed_16(size, (signed short *)dst, src, (signed int *)sum);
+	else
+		generic_remix_areas_16_native(size, dst, src, sum, dst_step, src_step, sum_step);
+}
+
+static void packed_mix_areas_32(unsigned int size,
+				volatile signed int *dst,
+				signed int *src,
+				volatile signed int *sum,
+				size_t dst_step,
+				size_t src_step,
+				size_t sum_step)
+{
+	if (dmix_packed(dst, src, sum, dst_step, src_step, sum_step, 4))
+		mix_packed_32(size, (signed int *)dst, src, (signed int *)sum);
+	else
+		generic_mix_areas_32_native(size, dst, src, sum, dst_step, src_step, sum_step);
+}
+
+static void packed_remix_areas_32(unsigned int size,
+				  volatile signed int *dst,
+				  signed int *src,
+				  volatile signed int *sum,
+				  size_t dst_step,
+				  size_t src_step,
+				  size_t sum_step)
+{
+	if (dmix_packed(dst, src, sum, dst_step, src_step, sum_step, 4))
+		remix_packed_32(size, (signed int *)dst, src, (signed int *)sum);
+	else
+		generic_remix_areas_32_native(size, dst, src, sum, dst_step, src_step, sum_step);
+}
+
+static void packed_mix_areas_24(unsigned int size,
+				volatile unsigned char *dst,
+				unsigned char *src,
+				volatile signed int *sum,
+				size_t dst_step,
+				size_t src_step,
+				size_t sum_step)
+{
+	if (dmix_packed(dst, src, sum, dst_step, src_step, sum_step, 4))
+		mix_packed_24(size, (unsigned int *)dst, (unsigned int *)src, (signed int *)sum);
+	else
+		generic_mix_areas_24(size, dst, src, sum, dst_step, src_step, sum_step);
+}
+
+static void packed_remix_areas_24(unsigned int size,
+				  volatile unsigned char *dst,
+				  unsigned char *src,
+				  volatile signed int *sum,
+				  size_t dst_step,
+				  size_t src_step,
+				  size_t sum_step)
+{
+	if (dmix_packed(dst, src, sum, dst_step, src_step, sum_step, 4))
+		remix_packed_24(size, (unsigned int *)dst, (unsigned int *)src, (signed int *)sum);
+	else
+		generic_remix_areas_24(size, dst, src, sum, dst_step, src_step, sum_step);
+}
+
+static void packed_mix_areas_u8(unsigned int size,
+				volatile unsigned char *dst,
+				unsigned char *src,
+				volatile signed int *sum,
+				size_t dst_step,
+				size_t src_step,
+				size_t sum_step)
+{
+	if (dmix_packed(dst, src, sum, dst_step, src_step, sum_step, 1))
+		mix_packed_u8(size, (unsigned char *)dst, src, (signed int *)sum);
+	else
+		generic_mix_areas_u8(size, dst, src, sum, dst_step, src_step, sum_step);
+}
+
+static void packed_remix_areas_u8(unsigned int size,
+				  volatile unsigned char *dst,
+				  unsigned char *src,
+				  volatile signed int *sum,
+				  size_t dst_step,
+				  size_t src_step,
+				  size_t sum_step)
+{
+	if (dmix_packed(dst, src, sum, dst_step, src_step, sum_step, 1))
+		remix_packed_u8(size, (unsigned char *)dst, src, (signed int *)sum);
+	else
+		generic_remix_areas_u8(size, dst, src, sum, dst_step, src_step, sum_step);
+}
+
+
 static void generic_mix_select_callbacks(snd_pcm_direct_t *dmix)
 {
 	/* only support native version, not support swap version */
 
-	dmix->u.dmix.mix_areas_16 = generic_mix_areas_16_native;
-	dmix->u.dmix.mix_areas_32 = generic_mix_areas_32_native;
-	dmix->u.dmix.remix_areas_16 = generic_remix_areas_16_native;
-	dmix->u.dmix.remix_areas_32 = generic_remix_areas_32_native;
+	dmix->u.dmix.mix_areas_16 = packed_mix_areas_16;
+	dmix->u.dmix.mix_areas_32 = packed_mix_areas_32;
+	dmix->u.dmix.remix_areas_16 = packed_remix_areas_16;
+	dmix->u.dmix.remix_areas_32 = packed_remix_areas_32;
 
-	dmix->u.dmix.mix_areas_24 = generic_mix_areas_24;
-	dmix->u.dmix.mix_areas_u8 = generic_mix_areas_u8;
-	dmix->u.dmix.remix_areas_24 = generic_remix_areas_24;
-	dmix->u.dmix.remix_areas_u8 = generic_remix_areas_u8;
+	dmix->u.dmix.mix_areas_24 = packed_mix_areas_24;
+	dmix->u.dmix.mix_areas_u8 = packed_mix_areas_u8;
+	dmix->u.dmix.remix_areas_24 = packed_remix_areas_24;
+	dmix->u.dmix.remix_areas_u8 = packed_remix_areas_u8;
 }
@@ -35,6 +35,7 @@
 #include "pcm_plugin_generic.h"
 
 #include "plugin_ops.h"
+#include "pcm_conv.h"
 
 typedef struct {
         /* This field need to be the first */
@@ -43,6 +44,8 @@ typedef struct {
         unsigned int conv_idx;
         unsigned int get_idx, put_idx;
         snd_pcm_format_t sformat;
+        snd_pcm_conv_func_t packed;	/* interleaved areas, see pcm_conv.c */
+        unsigned int cbits, sbits;
 } snd_pcm_linear_t;
 
 int snd_pcm_linear_convert_index(snd_pcm_format_t src_format,
@@ -195,6 +198,25 @@ void snd_pcm_linear_getput(const snd_pcm_channel_area_t *dst_areas, snd_pcm_ufra
 	}
 }
 
+static int snd_pcm_linear_packed(snd_pcm_linear_t *linear,
+				 const snd_pcm_channel_area_t *dst_areas, snd_pcm_uframes_t dst_offset,
+				 unsigned int dst_bits,
+				 const snd_pcm_channel_area_t *src_areas, snd_pcm_uframes_t src_offset,
+				 unsigned int src_bits,
+				 unsigned int channels, snd_pcm_uframes_t frames)
+{
+	void *dst, *src;
+
+	if (!linear->packed)
+		return 0;
+	dst = snd_pcm_areas_interleaved(dst_areas, dst_offset, channels, dst_bits);
+	src = snd_pcm_areas_interleaved(src_areas, src_offset, channels, src_bits);
+	if (!dst || !src)
+		return 0;
+	linear->packed(dst, src, frames * channels);
+	return 1;
+}
+
 static snd_pcm_uframes_t
 snd_pcm_linear_write_areas(snd_pcm_t *pcm,
 			   const snd_pcm_channel_area_t *areas,
@@ -207,6 +229,11 @@ snd_pcm_linear_write_areas(snd_pcm_t *pcm,
 	snd_pcm_linear_t *linear = pcm->private_data;
 	if (size > *slave_sizep)
 		size = *slave_sizep;
+	if (snd_pcm_linear_packed(linear, slave_areas, slave_offset, linear->sbits,
+				  areas, offset, linear->cbits, pcm->channels, size)) {
+		*slave_sizep = size;
+		return size;
+	}
 	if (linear->use_getput)
 		snd_pcm_linear_getput(slave_areas, slave_offset,
 				      areas, offset,
@@ -232,6 +259,11 @@ snd_pcm_linear_read_areas(snd_pcm_t *pcm,
 	snd_pcm_linear_t *linear = pcm->private_data;
 	if (size > *slave_sizep)
 		size = *slave_sizep;
+	if (snd_pcm_linear_packed(linear, areas, offset, linear->cbits,
+				  slave_areas, slave_offset, linear->sbits, pcm->channels, size)) {
+		*slave_sizep = size;
+		return size;
+	}
 	if (linear->use_getput)
 		snd_pcm_linear_getput(areas, offset,
 				      slave_areas, slave_offset,
@@ -297,6 +329,12 @@ static int snd_pcm_linear_hw_params(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
 			linear->conv_idx = snd_pcm_linear_convert_index(linear->sformat , format);
 		/*awalsa_info("conv_idx=%u\n", linear->conv_idx);*/
 	}
+	if (pcm->stream == SND_PCM_STREAM_PLAYBACK)
+		linear->packed = snd_pcm_conv_find(format, linear->sformat);
+	else
+		linear->packed = snd_pcm_conv_find(linear->sformat, format);
+	linear->cbits = snd_pcm_format_physical_width(format);
+	linear->sbits = snd_pcm_format_physical_width(linear->sformat);
 
 	/*TODO*/
 	memcpy(params, slave_params, sizeof(snd_pcm_hw_params_t));
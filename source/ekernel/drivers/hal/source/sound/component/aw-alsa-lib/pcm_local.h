@@ -328,6 +328,27 @@ static inline unsigned int snd_pcm_channel_area_step(const snd_pcm_channel_area_
 	return area->step / 8;
 }
 
+/*
+ * The address of frame offset when the areas are one interleaved buffer,
+ * channels in order, for the packed loops of pcm_conv.c, NULL otherwise.
+ */
+static inline void *snd_pcm_areas_interleaved(const snd_pcm_channel_area_t *areas,
+					      snd_pcm_uframes_t offset,
+					      unsigned int channels, unsigned int bits)
+{
+	unsigned int chn;
+
+	if (bits % 8 || areas[0].first % 8)
+		return NULL;
+	for (chn = 0; chn < channels; chn++) {
+		if (areas[chn].addr != areas[0].addr ||
+		    areas[chn].first != areas[0].first + chn * bits ||
+		    areas[chn].step != channels * bits)
+			return NULL;
+	}
+	return snd_pcm_channel_area_addr(&areas[0], offset);
+}
+
 static inline snd_pcm_sframes_t _snd_pcm_writei(snd_pcm_t *pcm, const void *buffer, snd_pcm_uframes_t size)
 {
 	/* lock handled in the callback */
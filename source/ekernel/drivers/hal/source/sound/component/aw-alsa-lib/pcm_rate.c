@@ -1191,6 +1191,9 @@ int snd_pcm_rate_open(snd_pcm_t **pcmp, const char *name,
 	snd_pcm_rate_open_func_t open_func;
 	extern int SND_PCM_RATE_PLUGIN_ENTRY(linear) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
 	extern int SND_PCM_RATE_PLUGIN_ENTRY(speexrate) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
+	extern int SND_PCM_RATE_PLUGIN_ENTRY(polyphase_low) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
+	extern int SND_PCM_RATE_PLUGIN_ENTRY(polyphase) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
+	extern int SND_PCM_RATE_PLUGIN_ENTRY(polyphase_best) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
 	extern int SND_PCM_RATE_PLUGIN_ENTRY(awrate) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
 #endif
 
@@ -1276,6 +1279,12 @@ int snd_pcm_rate_open(snd_pcm_t **pcmp, const char *name,
 		open_func = SND_PCM_RATE_PLUGIN_ENTRY(linear);
 	else if ( 0 == strcmp(converter, "speexrate"))
 		open_func = SND_PCM_RATE_PLUGIN_ENTRY(speexrate);
+	else if ( 0 == strcmp(converter, "polyphase_low"))
+		open_func = SND_PCM_RATE_PLUGIN_ENTRY(polyphase_low);
+	else if ( 0 == strcmp(converter, "polyphase"))
+		open_func = SND_PCM_RATE_PLUGIN_ENTRY(polyphase);
+	else if ( 0 == strcmp(converter, "polyphase_best"))
+		open_func = SND_PCM_RATE_PLUGIN_ENTRY(polyphase_best);
 #if 0
 	else if ( 0 == strcmp(converter, "awrate") )
 		open_func = SND_PCM_RATE_PLUGIN_ENTRY(awrate);
@@ -0,0 +1,580 @@
+/*
+* Copyright (c) 2019-2025 Allwinner Technology Co., Ltd. ALL rights reserved.
+*
+* Allwinner is a trademark of Allwinner Technology Co.,Ltd., registered in
+* the the people's Republic of China and other countries.
+* All Allwinner Technology Co.,Ltd. trademarks are used with permission.
+*
+* DISCLAIMER
+* THIRD PARTY LICENCES MAY BE REQUIRED TO IMPLEMENT THE SOLUTION/PRODUCT.
+* IF YOU NEED TO INTEGRATE THIRD PARTY’S TECHNOLOGY (SONY, DTS, DOLBY, AVS OR MPEGLA, ETC.)
+* IN ALLWINNERS’SDK OR PRODUCTS, YOU SHALL BE SOLELY RESPONSIBLE TO OBTAIN
+* ALL APPROPRIATELY REQUIRED THIRD PARTY LICENCES.
+* ALLWINNER SHALL HAVE NO WARRANTY, INDEMNITY OR OTHER OBLIGATIONS WITH RESPECT TO MATTERS
+* COVERED UNDER ANY REQUIRED THIRD PARTY LICENSE.
+* YOU ARE SOLELY RESPONSIBLE FOR YOUR USAGE OF THIRD PARTY’S TECHNOLOGY.
+*
+*
+* THIS SOFTWARE IS PROVIDED BY ALLWINNER"AS IS" AND TO THE MAXIMUM EXTENT
+* PERMITTED BY LAW, ALLWINNER EXPRESSLY DISCLAIMS ALL WARRANTIES OF ANY KIND,
+* WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING WITHOUT LIMITATION REGARDING
+* THE TITLE, NON-INFRINGEMENT, ACCURACY, CONDITION, COMPLETENESS, PERFORMANCE
+* OR MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* IN NO EVENT SHALL ALLWINNER BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+* SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS, OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+* OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <aw-alsa-lib/plugin/pcm_rate.h>
+#include <aw-alsa-lib/pcm_config.h>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * Fixed-point polyphase resampler.
+ *
+ * With L/M the period ratio out/in in lowest terms, output frame j sits at
+ * input position j * M / L. It is the dot product of the last taps input
+ * samples with one phase of a Kaiser windowed sinc, in Q14; the best
+ * quality adds a second dot product with the next 8 bits of the
+ * coefficients, which Q14 alone caps near 75 dB SNR. When L fits
+ * in the bank every position has its own phase (8k and 16k to 48k, 48k to
+ * 44.1k with 940 frame periods); beyond, the bank has max_phases phases
+ * and the two around the position are interpolated once per frame for
+ * all channels.
+ *
+ * Banks are built with the FPU at hw_params and shared by the streams
+ * that need the same one. Downsampling lowers the cutoff and stretches
+ * the filter to keep its transition band, up to POLY_MAX_TAPS.
+ */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define POLY_COEF_SHIFT		14
+#define POLY_COEF_ONE		(1 << POLY_COEF_SHIFT)
+#define POLY_LO_SHIFT		8	/* low part, small enough not to overflow its sum */
+#define POLY_FINE_SHIFT		(POLY_COEF_SHIFT + POLY_LO_SHIFT)
+#define POLY_FINE_ONE		(1 << POLY_FINE_SHIFT)
+#define POLY_MAX_TAPS		256
+
+enum {
+	POLY_QUALITY_LOW,
+	POLY_QUALITY_MEDIUM,
+	POLY_QUALITY_BEST,
+};
+
+static const struct poly_quality {
+	unsigned int taps;		/* at or above unity ratio, multiple of 8 */
+	unsigned int max_phases;
+	double rolloff;			/* cutoff over the lower Nyquist */
+	double beta;			/* Kaiser window */
+	int fine;			/* Q22 coefficients, two dot products */
+} poly_quality[] = {
+	[POLY_QUALITY_LOW]	= { 16,  64, 0.80, 5.0, 0 },
+	[POLY_QUALITY_MEDIUM]	= { 32, 128, 0.88, 7.5, 0 },
+	[POLY_QUALITY_BEST]	= { 64, 256, 0.92, 9.5, 1 },
+};
+
+struct poly_bank {
+	struct poly_bank *next;
+	int refs;
+	int quality;
+	unsigned int in_rate, out_rate;	/* set the cutoff */
+	unsigned int phases;
+	unsigned int taps;
+	int interp;			/* one more row, phase 1.0 */
+	int16_t *lo;			/* low parts, after coef, for fine */
+	int16_t coef[];			/* (phases + interp) rows of taps */
+};
+
+struct rate_poly {
+	int quality;
+	unsigned int channels;
+	unsigned int num, den;		/* L, M: output and input frames */
+	unsigned int step, step_frac;	/* M / L and M % L */
+	unsigned int pos, frac;		/* next output at pos + frac / L */
+	struct poly_bank *bank;
+	unsigned int taps;
+	int16_t *work;			/* per channel, taps - 1 of history then input */
+	unsigned int work_frames;	/* input frames a channel holds */
+	int16_t *row;			/* interpolated phase */
+	int16_t *row_lo;
+};
+
+static struct poly_bank *poly_banks;
+static pthread_mutex_t poly_banks_lock;
+
+__attribute__((constructor)) static void poly_banks_lock_init(void)
+{
+	pthread_mutex_init(&poly_banks_lock, NULL);
+}
+
+__attribute__((destructor)) static void poly_banks_lock_destroy(void)
+{
+	pthread_mutex_destroy(&poly_banks_lock);
+}
+
+static unsigned int gcd(unsigned int a, unsigned int b)
+{
+	while (b) {
+		unsigned int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 40; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/* c in Q22, split into Q14 and the 8 bits below, -128 <= lo < 128 */
+static inline void poly_split(int32_t c, int16_t *hi, int16_t *lo)
+{
+	int32_t h = (c + (1 << (POLY_LO_SHIFT - 1))) >> POLY_LO_SHIFT;
+
+	*hi = h;
+	*lo = c - h * (1 << POLY_LO_SHIFT);
+}
+
+/*
+ * Row p holds the coefficients for a position p / phases past the input
+ * sample taps / 2 before the newest one of the window, every row summing
+ * to one so that DC goes through unchanged.
+ */
+static void poly_fill_bank(struct poly_bank *bank, double cutoff, double beta)
+{
+	unsigned int rows = bank->phases + bank->interp, taps = bank->taps;
+	double half = taps / 2, h[POLY_MAX_TAPS], sum, x, u;
+	int32_t fine[POLY_MAX_TAPS], total;
+	unsigned int p, k, center;
+	int16_t *c, *lo, unused;
+
+	for (p = 0; p < rows; p++) {
+		c = bank->coef + p * taps;
+		lo = bank->lo ? bank->lo + p * taps : NULL;
+		sum = 0.0;
+		for (k = 0; k < taps; k++) {
+			x = half - 1 - k + (double)p / bank->phases;
+			u = x / half;
+			if (u <= -1.0 || u >= 1.0) {
+				h[k] = 0.0;
+				continue;
+			}
+			h[k] = x == 0.0 ? cutoff : sin(M_PI * cutoff * x) / (M_PI * x);
+			h[k] *= bessel_i0(beta * sqrt(1.0 - u * u)) / bessel_i0(beta);
+			sum += h[k];
+		}
+
+		/* rounding leftovers on the largest tap, at either precision */
+		total = 0;
+		center = 0;
+		for (k = 0; k < taps; k++) {
+			fine[k] = lrint(h[k] / sum * POLY_FINE_ONE);
+			total += fine[k];
+			if (fine[k] > fine[center])
+				center = k;
+		}
+		fine[center] += POLY_FINE_ONE - total;
+
+		total = 0;
+		for (k = 0; k < taps; k++) {
+			poly_split(fine[k], &c[k], lo ? &lo[k] : &unused);
+			total += c[k];
+		}
+		if (!lo)
+			c[center] += POLY_COEF_ONE - total;
+	}
+}
+
+static struct poly_bank *poly_bank_get(int quality, unsigned int in_rate,
+				       unsigned int out_rate, unsigned int num)
+{
+	const struct poly_quality *q = &poly_quality[quality];
+	unsigned int phases, taps, rows;
+	struct poly_bank *bank;
+	double cutoff;
+	int interp;
+
+	cutoff = q->rolloff;
+	taps = q->taps;
+	if (out_rate < in_rate) {
+		cutoff = q->rolloff * out_rate / in_rate;
+		taps = (unsigned int)((double)q->taps * in_rate / out_rate + 7) & ~7;
+		if (taps > POLY_MAX_TAPS)
+			taps = POLY_MAX_TAPS;
+	}
+	interp = num > q->max_phases;
+	phases = interp ? q->max_phases : num;
+	rows = phases + interp;
+
+	pthread_mutex_lock(&poly_banks_lock);
+	for (bank = poly_banks; bank; bank = bank->next) {
+		if (bank->quality == quality && bank->in_rate == in_rate &&
+		    bank->out_rate == out_rate && bank->phases == phases &&
+		    bank->interp == interp) {
+			bank->refs++;
+			pthread_mutex_unlock(&poly_banks_lock);
+			return bank;
+		}
+	}
+
+	bank = malloc(sizeof(*bank) + (q->fine ? 2 : 1) * rows * taps * sizeof(int16_t));
+	if (bank) {
+		bank->refs = 1;
+		bank->quality = quality;
+		bank->in_rate = in_rate;
+		bank->out_rate = out_rate;
+		bank->phases = phases;
+		bank->taps = taps;
+		bank->interp = interp;
+		bank->lo = q->fine ? bank->coef + rows * taps : NULL;
+		poly_fill_bank(bank, cutoff, q->beta);
+		bank->next = poly_banks;
+		poly_banks = bank;
+	}
+	pthread_mutex_unlock(&poly_banks_lock);
+	return bank;
+}
+
+static void poly_bank_put(struct poly_bank *bank)
+{
+	struct poly_bank **pp;
+
+	pthread_mutex_lock(&poly_banks_lock);
+	if (--bank->refs == 0) {
+		for (pp = &poly_banks; *pp; pp = &(*pp)->next) {
+			if (*pp == bank) {
+				*pp = bank->next;
+				break;
+			}
+		}
+		free(bank);
+	}
+	pthread_mutex_unlock(&poly_banks_lock);
+}
+
+static inline int16_t sat16(int32_t v)
+{
+	return v > 0x7fff ? 0x7fff : v < -0x8000 ? -0x8000 : v;
+}
+
+/* taps is a multiple of 8 */
+static inline int32_t poly_dot(const int16_t *x, const int16_t *c, unsigned int taps)
+{
+#ifdef __ARM_NEON
+	int32x4_t acc = vdupq_n_s32(0);
+	int32x2_t sum;
+	unsigned int k;
+
+	for (k = 0; k < taps; k += 8) {
+		int16x8_t a = vld1q_s16(x + k), b = vld1q_s16(c + k);
+
+		acc = vmlal_s16(acc, vget_low_s16(a), vget_low_s16(b));
+		acc = vmlal_s16(acc, vget_high_s16(a), vget_high_s16(b));
+	}
+	sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+	return vget_lane_s32(vpadd_s32(sum, sum), 0);
+#else
+	int32_t acc = 0;
+	unsigned int k;
+
+	for (k = 0; k < taps; k++)
+		acc += x[k] * c[k];
+	return acc;
+#endif
+}
+
+/* w in Q15 from row a to the next one, summing to one like them */
+static void poly_interp_row(int16_t *__restrict row, const int16_t *__restrict a,
+			    unsigned int taps, int32_t w)
+{
+	const int16_t *b = a + taps;
+	unsigned int k;
+	int32_t total = 0;
+
+	for (k = 0; k < taps; k++) {
+		row[k] = a[k] + (((b[k] - a[k]) * w + (1 << 14)) >> 15);
+		total += row[k];
+	}
+	row[taps / 2 - 1 + (w >= (1 << 14))] += POLY_COEF_ONE - total;
+}
+
+static void poly_interp_row_fine(int16_t *__restrict row, int16_t *__restrict row_lo,
+				 const int16_t *__restrict a, const int16_t *__restrict a_lo,
+				 unsigned int taps, int32_t w)
+{
+	const int16_t *b = a + taps, *b_lo = a_lo + taps;
+	unsigned int k, center = taps / 2 - 1 + (w >= (1 << 14));
+	int32_t ca, cb, c, total = 0;
+
+	for (k = 0; k < taps; k++) {
+		ca = a[k] * (1 << POLY_LO_SHIFT) + a_lo[k];
+		cb = b[k] * (1 << POLY_LO_SHIFT) + b_lo[k];
+		c = ca + (int32_t)(((int64_t)(cb - ca) * w + (1 << 14)) >> 15);
+		poly_split(c, &row[k], &row_lo[k]);
+		total += c;
+	}
+	c = row[center] * (1 << POLY_LO_SHIFT) + row_lo[center] + POLY_FINE_ONE - total;
+	poly_split(c, &row[center], &row_lo[center]);
+}
+
+static void poly_convert_s16(void *obj, int16_t *dst, unsigned int dst_frames,
+			     const int16_t *src, unsigned int src_frames)
+{
+	struct rate_poly *rate = obj;
+	struct poly_bank *bank = rate->bank;
+	unsigned int channels = rate->channels, taps = rate->taps;
+	unsigned int stride = taps - 1 + rate->work_frames;
+	unsigned int pos = rate->pos, frac = rate->frac;
+	unsigned int ch, i, j, x;
+	const int16_t *c, *lo;
+	int16_t *w;
+
+	if (src_frames > rate->work_frames) {
+		/* never more than a period, drop what does not fit */
+		src_frames = rate->work_frames;
+	}
+
+	for (ch = 0; ch < channels; ch++) {
+		w = rate->work + ch * stride + taps - 1;
+		for (i = 0; i < src_frames; i++)
+			w[i] = src[i * channels + ch];
+	}
+
+	for (j = 0; j < dst_frames; j++) {
+		/* short of input, the last one again; the ratio catches up */
+		if (pos >= src_frames)
+			pos = src_frames ? src_frames - 1 : 0;
+
+		if (!bank->interp) {
+			c = bank->coef + frac * taps;
+			lo = bank->lo ? bank->lo + frac * taps : NULL;
+		} else {
+			int32_t wt;
+
+			x = frac * bank->phases;
+			wt = ((unsigned long long)(x % rate->num) << 15) / rate->num;
+			x = (x / rate->num) * taps;
+			if (!bank->lo) {
+				poly_interp_row(rate->row, bank->coef + x, taps, wt);
+				lo = NULL;
+			} else {
+				poly_interp_row_fine(rate->row, rate->row_lo, bank->coef + x,
+						     bank->lo + x, taps, wt);
+				lo = rate->row_lo;
+			}
+			c = rate->row;
+		}
+		for (ch = 0; ch < channels; ch++) {
+			const int16_t *in = rate->work + ch * stride + pos;
+			int32_t acc = poly_dot(in, c, taps);
+
+			if (!lo) {
+				dst[ch] = sat16((acc + (1 << (POLY_COEF_SHIFT - 1))) >> POLY_COEF_SHIFT);
+			} else {
+				int64_t v = (int64_t)acc * (1 << POLY_LO_SHIFT) + poly_dot(in, lo, taps);
+
+				dst[ch] = sat16((v + (1 << (POLY_FINE_SHIFT - 1))) >> POLY_FINE_SHIFT);
+			}
+		}
+		dst += channels;
+
+		pos += rate->step;
+		frac += rate->step_frac;
+		if (frac >= rate->num) {
+			frac -= rate->num;
+			pos++;
+		}
+	}
+
+	rate->pos = pos >= src_frames ? pos - src_frames : 0;
+	rate->frac = frac;
+	for (ch = 0; ch < channels; ch++) {
+		w = rate->work + ch * stride;
+		memmove(w, w + src_frames, (taps - 1) * sizeof(*w));
+	}
+}
+
+static snd_pcm_uframes_t input_frames(void *obj, snd_pcm_uframes_t frames)
+{
+	struct rate_poly *rate = obj;
+
+	if (frames == 0)
+		return 0;
+	return ((unsigned long long)frames * rate->den + rate->num / 2) / rate->num;
+}
+
+static snd_pcm_uframes_t output_frames(void *obj, snd_pcm_uframes_t frames)
+{
+	struct rate_poly *rate = obj;
+
+	if (frames == 0)
+		return 0;
+	return ((unsigned long long)frames * rate->num + rate->den / 2) / rate->den;
+}
+
+static void poly_free(void *obj)
+{
+	struct rate_poly *rate = obj;
+
+	if (rate->bank) {
+		poly_bank_put(rate->bank);
+		rate->bank = NULL;
+	}
+	free(rate->work);
+	rate->work = NULL;
+	free(rate->row);
+	rate->row = NULL;
+	free(rate->row_lo);
+	rate->row_lo = NULL;
+}
+
+static void poly_reset(void *obj)
+{
+	struct rate_poly *rate = obj;
+
+	rate->pos = 0;
+	rate->frac = 0;
+	if (rate->work)
+		memset(rate->work, 0, rate->channels * (rate->taps - 1 + rate->work_frames) *
+		       sizeof(*rate->work));
+}
+
+/* the frames exchanged are a period each side, their ratio is the one to keep */
+static int poly_setup(struct rate_poly *rate, snd_pcm_rate_info_t *info)
+{
+	unsigned int in = info->in.period_size, out = info->out.period_size;
+	unsigned int g;
+	struct poly_bank *bank;
+
+	if (!in || !out) {
+		in = info->in.rate;
+		out = info->out.rate;
+	}
+	g = gcd(out, in);
+	rate->num = out / g;
+	rate->den = in / g;
+	rate->step = rate->den / rate->num;
+	rate->step_frac = rate->den % rate->num;
+
+	bank = poly_bank_get(rate->quality, info->in.rate, info->out.rate, rate->num);
+	if (!bank)
+		return -ENOMEM;
+	poly_free(rate);
+	rate->bank = bank;
+	rate->taps = bank->taps;
+	rate->channels = info->channels;
+	rate->work_frames = info->in.period_size;
+	rate->work = malloc(rate->channels * (rate->taps - 1 + rate->work_frames) *
+			    sizeof(*rate->work));
+	rate->row = malloc(rate->taps * sizeof(*rate->row));
+	rate->row_lo = malloc(rate->taps * sizeof(*rate->row_lo));
+	if (!rate->work || !rate->row || !rate->row_lo) {
+		poly_free(rate);
+		return -ENOMEM;
+	}
+	poly_reset(rate);
+	return 0;
+}
+
+static int poly_init(void *obj, snd_pcm_rate_info_t *info)
+{
+	return poly_setup(obj, info);
+}
+
+static int poly_adjust_pitch(void *obj, snd_pcm_rate_info_t *info)
+{
+	struct rate_poly *rate = obj;
+	unsigned int g = gcd(info->out.period_size, info->in.period_size);
+
+	if (g && rate->bank && rate->num == info->out.period_size / g &&
+	    rate->den == info->in.period_size / g &&
+	    rate->work_frames == info->in.period_size)
+		return 0;
+	return poly_setup(rate, info);
+}
+
+static void poly_close(void *obj)
+{
+	free(obj);
+}
+
+static int get_supported_rates(void *obj, unsigned int *rate_min,
+			       unsigned int *rate_max)
+{
+	*rate_min = SND_PCM_PLUGIN_RATE_MIN;
+	*rate_max = SND_PCM_PLUGIN_RATE_MAX;
+	return 0;
+}
+
+static const snd_pcm_rate_ops_t poly_ops = {
+	.close = poly_close,
+	.init = poly_init,
+	.free = poly_free,
+	.reset = poly_reset,
+	.adjust_pitch = poly_adjust_pitch,
+	.convert_s16 = poly_convert_s16,
+	.input_frames = input_frames,
+	.output_frames = output_frames,
+	.version = SND_PCM_RATE_PLUGIN_VERSION,
+	.get_supported_rates = get_supported_rates,
+};
+
+static int poly_open(void **objp, snd_pcm_rate_ops_t *ops, int quality)
+{
+	struct rate_poly *rate;
+
+	rate = calloc(1, sizeof(*rate));
+	if (!rate)
+		return -ENOMEM;
+	rate->quality = quality;
+	rate->num = rate->den = 1;
+
+	*objp = rate;
+	*ops = poly_ops;
+	return 0;
+}
+
+int SND_PCM_RATE_PLUGIN_ENTRY(polyphase_low) (unsigned int version, void **objp,
+					      snd_pcm_rate_ops_t *ops)
+{
+	return poly_open(objp, ops, POLY_QUALITY_LOW);
+}
+
+int SND_PCM_RATE_PLUGIN_ENTRY(polyphase) (unsigned int version, void **objp,
+					  snd_pcm_rate_ops_t *ops)
+{
+	return poly_open(objp, ops, POLY_QUALITY_MEDIUM);
+}
+
+int SND_PCM_RATE_PLUGIN_ENTRY(polyphase_best) (unsigned int version, void **objp,
+					       snd_pcm_rate_ops_t *ops)
+{
+	return poly_open(objp, ops, POLY_QUALITY_BEST);
+}
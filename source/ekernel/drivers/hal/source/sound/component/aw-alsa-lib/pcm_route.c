@@ -40,6 +40,7 @@
 #include "pcm_plugin_generic.h"
 
 #include "plugin_ops.h"
+#include "pcm_conv.h"
 
 /* The best possible hack to support missing optimization in gcc 2.7.2.3 */
 #if SND_PCM_PLUGIN_ROUTE_RESOLUTION & (SND_PCM_PLUGIN_ROUTE_RESOLUTION - 1) != 0
@@ -104,6 +105,9 @@ typedef struct {
 	int schannels;
 	snd_pcm_route_params_t params;
 	snd_pcm_chmap_t *chmap;
+	/* the table for interleaved areas, see pcm_conv.c */
+	snd_pcm_conv_route_t packed;
+	int use_packed;
 } snd_pcm_route_t;
 
 
@@ -424,6 +428,72 @@ static void snd_pcm_route_convert(const snd_pcm_channel_area_t *dst_areas,
 	}
 }
 
+/* the whole period in one pass when the table and formats allow it */
+static int snd_pcm_route_packed(snd_pcm_route_t *route,
+				const snd_pcm_channel_area_t *dst_areas,
+				snd_pcm_uframes_t dst_offset,
+				const snd_pcm_channel_area_t *src_areas,
+				snd_pcm_uframes_t src_offset,
+				snd_pcm_uframes_t frames)
+{
+	const snd_pcm_conv_route_t *packed = &route->packed;
+	void *dst, *src;
+
+	if (!route->use_packed)
+		return 0;
+	dst = snd_pcm_areas_interleaved(dst_areas, dst_offset, packed->dst_channels,
+					snd_pcm_format_physical_width(packed->dst_format));
+	src = snd_pcm_areas_interleaved(src_areas, src_offset, packed->src_channels,
+					snd_pcm_format_physical_width(packed->src_format));
+	if (!dst || !src)
+		return 0;
+	snd_pcm_conv_route(dst, src, frames, packed);
+	return 1;
+}
+
+static void snd_pcm_route_packed_init(snd_pcm_route_t *route,
+				      snd_pcm_format_t src_format,
+				      snd_pcm_format_t dst_format,
+				      unsigned int src_channels,
+				      unsigned int dst_channels)
+{
+	snd_pcm_route_params_t *params = &route->params;
+	snd_pcm_conv_route_t *packed = &route->packed;
+	unsigned int dst, src;
+
+	route->use_packed = 0;
+	if (src_channels > SND_PCM_CONV_MAX_CHANNELS ||
+	    dst_channels > SND_PCM_CONV_MAX_CHANNELS)
+		return;
+	memset(packed, 0, sizeof(*packed));
+	packed->src_format = src_format;
+	packed->dst_format = dst_format;
+	packed->src_channels = src_channels;
+	packed->dst_channels = dst_channels;
+	for (dst = 0; dst < dst_channels && dst < params->ndsts; dst++) {
+		const snd_pcm_route_ttable_dst_t *d = &params->dsts[dst];
+
+		for (src = 0; src < d->nsrcs; src++) {
+			int channel = d->srcs[src].channel;
+#if SND_PCM_PLUGIN_ROUTE_FLOAT
+			float w = d->srcs[src].as_float * SND_PCM_PLUGIN_ROUTE_RESOLUTION;
+
+			/* only weights in 1/16 steps stay exact in integers */
+			if (w != (int)w)
+				return;
+#else
+			int w = d->srcs[src].as_int;
+#endif
+			if (channel >= (int)src_channels)
+				continue;
+			if (w < 0 || w > SND_PCM_PLUGIN_ROUTE_RESOLUTION)
+				return;
+			packed->weight[dst][channel] = (int)w;
+		}
+	}
+	route->use_packed = snd_pcm_conv_route_supported(packed);
+}
+
 static snd_pcm_uframes_t
 snd_pcm_route_write_areas(snd_pcm_t *pcm,
 			  const snd_pcm_channel_area_t *areas,
@@ -437,6 +507,11 @@ snd_pcm_route_write_areas(snd_pcm_t *pcm,
 	snd_pcm_t *slave = route->plug.gen.slave;
 	if (size > *slave_sizep)
 		size = *slave_sizep;
+	if (snd_pcm_route_packed(route, slave_areas, slave_offset,
+				 areas, offset, size)) {
+		*slave_sizep = size;
+		return size;
+	}
 	snd_pcm_route_convert(slave_areas, slave_offset,
 			      areas, offset,
 			      pcm->channels,
@@ -459,6 +534,11 @@ snd_pcm_route_read_areas(snd_pcm_t *pcm,
 	snd_pcm_t *slave = route->plug.gen.slave;
 	if (size > *slave_sizep)
 		size = *slave_sizep;
+	if (snd_pcm_route_packed(route, areas, offset,
+				 slave_areas, slave_offset, size)) {
+		*slave_sizep = size;
+		return size;
+	}
 	snd_pcm_route_convert(areas, offset,
 			      slave_areas, slave_offset,
 			      slave->channels,
@@ -676,6 +756,12 @@ static int snd_pcm_route_hw_params(snd_pcm_t *pcm, snd_pcm_hw_params_t * params)
 #else
 	route->params.sum_idx = UINT64;
 #endif
+	if (pcm->stream == SND_PCM_STREAM_PLAYBACK)
+		snd_pcm_route_packed_init(route, src_format, dst_format,
+					  cchannels, route->schannels);
+	else
+		snd_pcm_route_packed_init(route, src_format, dst_format,
+					  route->schannels, cchannels);
 	return 0;
 }
 
@@ -37,6 +37,7 @@
 #include <aw-alsa-lib/pcm_config.h>
 #include <aw-alsa-lib/control.h>
 #include "pcm_plugin_generic.h"
+#include "pcm_conv.h"
 #include <math.h>
 
 typedef struct {
@@ -52,6 +53,9 @@ typedef struct {
 	double max_dB;
 	unsigned int *dB_value;
 	const snd_pcm_softvol_control_t *control;
+	/* gains of the last packed period, a change ramps from them */
+	unsigned int ramp_gain[SND_PCM_CONV_MAX_CHANNELS];
+	int ramp_valid;
 } snd_pcm_softvol_t;
 
 #define VOL_SCALE_SHIFT         16
@@ -204,6 +208,96 @@ static inline short MULTI_DIV_short(short a, unsigned int b, int swap)
 		break; \
 	}
 
+/*
+ * Interleaved S16/S32 in one pass over the period, with the gains the
+ * CONVERT_AREA loops would use (0xffff copies, so it is unity here).
+ * When the volume changed since the last period the gains ramp to the new
+ * ones over this one, instead of stepping.
+ */
+static int softvol_convert_packed(snd_pcm_softvol_t *svol,
+				  const snd_pcm_channel_area_t *dst_areas,
+				  snd_pcm_uframes_t dst_offset,
+				  const snd_pcm_channel_area_t *src_areas,
+				  snd_pcm_uframes_t src_offset,
+				  unsigned int channels,
+				  snd_pcm_uframes_t frames)
+{
+	unsigned int gain[SND_PCM_CONV_MAX_CHANNELS];
+	unsigned int vol_scale, vol[2], vol_c, ch, bits;
+	int mute = 1, unity = 1;
+	void *dst, *src;
+
+	if ((svol->sformat != SND_PCM_FORMAT_S16_LE &&
+	     svol->sformat != SND_PCM_FORMAT_S32_LE) ||
+	    channels > SND_PCM_CONV_MAX_CHANNELS)
+		goto generic;
+	bits = snd_pcm_format_physical_width(svol->sformat);
+	dst = snd_pcm_areas_interleaved(dst_areas, dst_offset, channels, bits);
+	src = snd_pcm_areas_interleaved(src_areas, src_offset, channels, bits);
+	if (!dst || !src)
+		goto generic;
+
+	if (svol->cchannels == 1) {
+		if (svol->cur_vol[0] == 0)
+			vol_c = 0;
+		else if (svol->zero_dB_val && svol->cur_vol[0] == svol->zero_dB_val)
+			vol_c = 0xffff;
+		else if (svol->max_val == 1)
+			vol_c = 0xffff;
+		else
+			vol_c = svol->dB_value[svol->cur_vol[0]];
+		vol[0] = vol[1] = vol_c;
+	} else if (svol->cur_vol[0] == 0 && svol->cur_vol[1] == 0) {
+		vol[0] = vol[1] = vol_c = 0;
+	} else if (svol->zero_dB_val && svol->cur_vol[0] == svol->zero_dB_val &&
+		   svol->cur_vol[1] == svol->zero_dB_val) {
+		vol[0] = vol[1] = vol_c = 0xffff;
+	} else if (svol->max_val == 1) {
+		vol[0] = svol->cur_vol[0] ? 0xffff : 0;
+		vol[1] = svol->cur_vol[1] ? 0xffff : 0;
+		vol_c = vol[0] | vol[1];
+	} else {
+		vol[0] = svol->dB_value[svol->cur_vol[0]];
+		vol[1] = svol->dB_value[svol->cur_vol[1]];
+		vol_c = svol->dB_value[(svol->cur_vol[0] + svol->cur_vol[1]) / 2];
+	}
+	for (ch = 0; ch < channels; ch++) {
+		if (svol->cchannels == 1) {
+			vol_scale = vol_c;
+		} else {
+			GET_VOL_SCALE;
+		}
+		gain[ch] = vol_scale == 0xffff ? SND_PCM_CONV_UNITY : vol_scale;
+		mute &= !gain[ch];
+		unity &= gain[ch] == SND_PCM_CONV_UNITY;
+	}
+
+	if (svol->ramp_valid &&
+	    memcmp(svol->ramp_gain, gain, channels * sizeof(gain[0]))) {
+		if (bits == 16)
+			snd_pcm_conv_ramp_s16(dst, src, frames, channels,
+					      svol->ramp_gain, gain);
+		else
+			snd_pcm_conv_ramp_s32(dst, src, frames, channels,
+					      svol->ramp_gain, gain);
+	} else if (mute) {
+		memset(dst, 0, frames * channels * bits / 8);
+	} else if (unity) {
+		memcpy(dst, src, frames * channels * bits / 8);
+	} else if (bits == 16) {
+		snd_pcm_conv_scale_s16(dst, src, frames, channels, gain);
+	} else {
+		snd_pcm_conv_scale_s32(dst, src, frames, channels, gain);
+	}
+	memcpy(svol->ramp_gain, gain, channels * sizeof(gain[0]));
+	svol->ramp_valid = 1;
+	return 1;
+
+generic:
+	svol->ramp_valid = 0;
+	return 0;
+}
+
 static void softvol_convert_stereo_vol(snd_pcm_softvol_t *svol,
 				       const snd_pcm_channel_area_t *dst_areas,
 				       snd_pcm_uframes_t dst_offset,
@@ -222,6 +316,9 @@ static void softvol_convert_stereo_vol(snd_pcm_softvol_t *svol,
 			   channels, frames, svol->sformat);
 	return;
 #endif
+	if (softvol_convert_packed(svol, dst_areas, dst_offset, src_areas,
+				   src_offset, channels, frames))
+		return;
 	if (svol->cur_vol[0] == 0 && svol->cur_vol[1] == 0) {
 		snd_pcm_areas_silence(dst_areas, dst_offset, channels, frames,
 				      svol->sformat);
@@ -279,6 +376,9 @@ static void softvol_convert_mono_vol(snd_pcm_softvol_t *svol,
 	unsigned int src_step, dst_step;
 	unsigned int vol_scale;
 
+	if (softvol_convert_packed(svol, dst_areas, dst_offset, src_areas,
+				   src_offset, channels, frames))
+		return;
 	if (svol->cur_vol[0] == 0) {
 		snd_pcm_areas_silence(dst_areas, dst_offset, channels, frames,
 				      svol->sformat);
@@ -333,7 +433,7 @@ static void get_current_volume(snd_pcm_softvol_t *svol)
 		return;
 	}
 #endif
-	for (i = 0; svol->cchannels; i++) {
+	for (i = 0; i < svol->cchannels; i++) {
 		svol->cur_vol[i] = info.value;
 	}
 }
@@ -457,6 +557,7 @@ static int snd_pcm_softvol_hw_params(snd_pcm_t *pcm, snd_pcm_hw_params_t * param
 		return -EINVAL;
 	}
 	svol->sformat = slave->format;
+	svol->ramp_valid = 0;
 	return 0;
 }
 
@@ -1,6 +1,8 @@
 #ifndef __DRV_CRYPTO_H__
 #define __DRV_CRYPTO_H__
 
+#include <hal_job_queue.h>
+
 //#define HWCRYPTO_LOCK
 
 #define AES_BLOCK_SIZE		16
@@ -36,4 +38,62 @@ extern void ce_print_hex(char *_data, int _len, void *_addr);
 extern int sunxi_ce_init(void);
 int aw_hw_crypto_device_init(void);
 
+/*
+ * Asynchronous AES job queue.
+ *
+ * Pending jobs are handed to the engine up to CE_JOB_BATCH_MAX at a time;
+ * the CE runs such a batch as one chained task list with one interrupt, so
+ * many small records share the setup and interrupt cost. done() is called
+ * with RT_EOK or a negative rt error from the CE service thread, or from
+ * the submitting call / crypto_aes_soft_poll() on the software engine.
+ * Buffers, key and iv belong to the queue until then; for CBC the iv is
+ * updated to the next chaining value, as mbedtls expects. src and dst
+ * must be ADDR_ALIGN_SIZE aligned.
+ */
+#define CE_JOB_BATCH_MAX	HAL_JOB_BATCH_MAX
+
+typedef struct crypto_aes_job crypto_aes_job_t;
+typedef void (*crypto_aes_job_cb)(crypto_aes_job_t *job, int status);
+
+struct crypto_aes_job {
+	struct hal_job job;
+	const rt_uint8_t *src;
+	rt_uint8_t *dst;
+	rt_uint32_t length;		/* multiple of AES_BLOCK_SIZE */
+	const rt_uint8_t *key;
+	rt_uint32_t key_length;		/* in bytes */
+	rt_uint8_t *iv;			/* CBC only */
+	rt_uint32_t dir;		/* CRYPTO_DIR_* */
+	rt_uint32_t mode;		/* AES_MODE_* */
+	crypto_aes_job_cb done;
+	void *priv;
+};
+
+typedef struct crypto_aes_engine {
+	const char *name;
+	int max_batch;
+	/* start jobs[0..num-1], the end is reported by crypto_aes_engine_done() */
+	int (*submit)(crypto_aes_job_t **jobs, int num);
+} crypto_aes_engine_t;
+
+int crypto_aes_engine_register(const crypto_aes_engine_t *engine);
+void crypto_aes_engine_done(int status);
+int crypto_aes_job_submit(crypto_aes_job_t *job);
+int crypto_aes_job_run(crypto_aes_job_t *job);
+
+/* CE engine with its service thread, needs sunxi_ce_init() first */
+int crypto_aes_queue_init(void);
+
+/* software reference engine, see ce_aes_soft.c */
+typedef struct {
+	int nr;
+	rt_uint32_t rk[68];
+} crypto_aes_soft_ctx_t;
+
+int crypto_aes_soft_setkey(crypto_aes_soft_ctx_t *ctx, const rt_uint8_t *key, rt_uint32_t key_length, rt_uint32_t dir);
+void crypto_aes_soft_block(const crypto_aes_soft_ctx_t *ctx, const rt_uint8_t in[16], rt_uint8_t out[16]);
+int crypto_aes_soft_crypt(crypto_aes_job_t *job);
+int crypto_aes_soft_init(int deferred);
+int crypto_aes_soft_poll(void);
+
 #endif /* __DRV_CRYPTO_H__ */
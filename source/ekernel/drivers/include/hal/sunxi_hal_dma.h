@@ -34,6 +34,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <hal_job_queue.h>
 
 /* #ifdef  CONFIG_ARCH_SUN8IW19P1 */
 #include "sun8i/dma-sun8iw19.h"
@@ -169,6 +170,18 @@ struct sunxi_dma_chan {
 	volatile int lock;
 };
 
+/**
+ * struct dma_sg_entry - one segment of a scatter-gather transfer
+ * @dst: destination, virtual for memory, physical for a device fifo
+ * @src: source, virtual for memory, physical for a device fifo
+ * @len: length in bytes
+ */
+struct dma_sg_entry {
+	uint32_t dst;
+	uint32_t src;
+	uint32_t len;
+};
+
 /** This enum defines the DMA CHANNEL status. */
 typedef enum {
 	HAL_DMA_CHAN_STATUS_BUSY  = 0,              /* DMA channel status busy */
@@ -188,6 +201,8 @@ hal_dma_status_t hal_dma_prep_cyclic(unsigned long *hdma, uint32_t buf_addr, uin
 hal_dma_status_t hal_dma_cyclic_callback_install(unsigned long *hdma, dma_callback callback, void *callback_param);
 hal_dma_status_t hal_dma_prep_memcpy(unsigned long *hdma, uint32_t dest, uint32_t src, uint32_t len);
 hal_dma_status_t hal_dma_prep_device(unsigned long *hdma, uint32_t dest, uint32_t src, uint32_t len, enum dma_transfer_direction dir);
+hal_dma_status_t hal_dma_prep_memcpy_sg(unsigned long *hdma, const struct dma_sg_entry *sg, uint32_t nents);
+hal_dma_status_t hal_dma_prep_device_sg(unsigned long *hdma, const struct dma_sg_entry *sg, uint32_t nents, enum dma_transfer_direction dir);
 hal_dma_status_t hal_dma_slave_config(unsigned long *hdma, struct dma_slave_config*config);
 enum dma_status hal_dma_tx_status(unsigned long *hdma, uint32_t *left_size);
 hal_dma_status_t hal_dma_start(unsigned long *hdma);
@@ -200,6 +215,53 @@ void hal_dma_init(void);
 void dma_free_coherent(void *addr);
 void *dma_alloc_coherent(size_t size);
 
+/*
+ * Asynchronous memcpy service.
+ *
+ * Requests are queued FIFO on one channel and the done callback runs once
+ * the data has landed, from the service thread (hardware backend) or from
+ * hal_dma_async_sw_poll() (software backend), never from interrupt context.
+ * The request, the segment list and the buffers belong to the service until
+ * the callback; the callback may resubmit or free the request.
+ *
+ * The hardware backend needs 4 byte aligned addresses and lengths, and a
+ * destination covering whole cache lines (HAL_DMA_ASYNC_ALIGN), since it is
+ * invalidated once the transfer is over. Other requests complete with
+ * HAL_DMA_STATUS_INVALID_PARAMETER; hal_dma_memcpy() copies those by cpu.
+ */
+#define HAL_DMA_ASYNC_ALIGN	64
+/* below this size hal_dma_memcpy() does not bother the dma */
+#define HAL_DMA_ASYNC_MIN_LEN	4096
+
+typedef void (*hal_dma_async_cb)(void *arg, hal_dma_status_t status);
+
+struct hal_dma_async_req {
+	struct hal_job job;
+	const struct dma_sg_entry *sg;
+	uint32_t nents;
+	struct dma_sg_entry single;
+	hal_dma_async_cb done;
+	void *arg;
+};
+
+struct hal_dma_async_ops {
+	const char *name;
+	/* start one request, the end is reported with hal_dma_async_complete() */
+	hal_dma_status_t (*submit)(void *priv, const struct dma_sg_entry *sg, uint32_t nents);
+	void *priv;
+};
+
+hal_dma_status_t hal_dma_async_register(const struct hal_dma_async_ops *ops);
+void hal_dma_async_complete(hal_dma_status_t status);
+hal_dma_status_t hal_dma_memcpy_async(struct hal_dma_async_req *req, void *dst, const void *src, uint32_t len, hal_dma_async_cb done, void *arg);
+hal_dma_status_t hal_dma_memcpy_sg_async(struct hal_dma_async_req *req, const struct dma_sg_entry *sg, uint32_t nents, hal_dma_async_cb done, void *arg);
+hal_dma_status_t hal_dma_memcpy(void *dst, const void *src, uint32_t len);
+
+/* backends: a dma channel with a service thread, or plain memcpy */
+hal_dma_status_t hal_dma_async_init(void);
+hal_dma_status_t hal_dma_async_init_sw(bool deferred);
+int hal_dma_async_sw_poll(void);
+
 #ifdef __cplusplus
 }
 #endif
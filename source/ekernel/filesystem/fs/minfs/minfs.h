@@ -71,6 +71,7 @@ typedef struct __MINFS_DENTRY
 #define MINFS_ATTR_DIR          1       //directory
 #define MINFS_ATTR_MODULE       2       //valid module file of melis system
 #define MINFS_ATTR_COMPRESS     4       //file data been compessed
+#define MINFS_ATTR_BLOCKED      8       //compressed data is block-indexed
 //...
 //module of melis system : driver,module,plugs
 
@@ -94,6 +95,28 @@ typedef struct __MINFS_SECTION_HDR
 //attributes of minfs elf section header
 #define MINFS_SECTION_ATTR_MAGIC        1   //melis system magic section
 #define MINFS_SECTION_ATTR_COMPRESS     2   //section data been compessed
+#define MINFS_SECTION_ATTR_BLOCKED      4   //compressed data is block-indexed
 //...
 
+//block-indexed compressed data,
+//used for files and sections with the BLOCKED attribute bit set.
+//the data is split into BlockSize byte chunks which are compressed
+//independently, so any range can be decoded without the chunks before it.
+//layout : |header||Offsets[BlockNum + 1]||block 0|...|block n|,
+//Offsets are relative to the header, block i takes
+//Offsets[i + 1] - Offsets[i] bytes : lzma props + lzma stream,
+//or raw data when that equals the uncompressed chunk length.
+typedef struct __MINFS_BLK_HDR
+{
+    __u32   Magic;                      //MINFS_BLK_MAGIC
+    __u32   BlockSize;                  //uncompressed byte size of one block
+    __u32   BlockNum;                   //the number of blocks
+    __u32   UnPackSize;                 //uncompressed byte size of all blocks
+} __minfs_blk_hdr_t;
+
+#define MINFS_BLK_MAGIC         0x4b4c424d  //"MBLK"
+#define MINFS_BLK_HDR_LEN       (sizeof(__minfs_blk_hdr_t))
+#define MINFS_BLK_MIN_SIZE      (4 * 1024)
+#define MINFS_BLK_MAX_SIZE      (256 * 1024)
+
 #endif  // __MIN_FS_H__
@@ -0,0 +1,525 @@
+/*
+*********************************************************************************************************
+*                                                    MELIS
+*                                    the Easy Portable/Player Develop Kits
+*                                        Mini ROM Image File System
+*
+*                                    (c) Copyright 2011-2014, Sunny China
+*                                             All Rights Reserved
+*
+* File    : minfs_block.c
+* By      : Melis
+* Version : v1.0
+* Date    : 2026-10-19
+* Descript: minfs block-indexed compressed data access.
+*           only the blocks covering the requested range are loaded,
+*           missing blocks are decompressed in parallel by a small pool of
+*           worker threads, and partially used blocks are kept in a small
+*           per super block LRU cache so sequential small reads hit it.
+* Update  : date                auther      ver     notes
+*           2026-10-19          Melis       1.0     Create this file.
+*********************************************************************************************************
+*/
+#include "minfs_i.h"
+#include "lzma/LzmaLib.h"
+#include <port.h>
+#include <kapi.h>
+
+#define MINFS_BLK_WORKER_STACK  (0x2000)
+
+typedef struct __MINFS_BLK_JOB
+{
+    struct super_block         *sb;
+    __u32                       SrcOffset;  //image byte offset of block data
+    __u32                       SrcLen;     //byte size of block data in image
+    __u8                       *pDst;       //decompressed data buffer
+    __u32                       DstLen;     //decompressed byte size of block
+    __minfs_blk_cache_item_t   *pItem;      //cache item, NULL when decoded to user buffer
+    __u32                       CopyPos;    //user buffer offset of the used range
+    __u32                       CopyOff;    //block offset of the used range
+    __u32                       CopyLen;    //byte size of the used range
+    __s32                       Result;
+    __hdle                      DoneSem;    //posted when the job finished
+    struct __MINFS_BLK_JOB     *pNext;
+} __minfs_blk_job_t;
+
+//decompress worker pool, shared by all minfs super blocks
+static __hdle             minfs_blk_queue_sem;
+static __hdle             minfs_blk_job_sem;
+static __minfs_blk_job_t *minfs_blk_job_head;
+static __minfs_blk_job_t *minfs_blk_job_tail;
+static __u32              minfs_blk_workers;
+
+static __s32 minfs_block_decode(__minfs_blk_job_t *pjob)
+{
+    struct super_block *sb = pjob->sb;
+    __u8               *ptmpdata;
+    __u32               uncompresslen;
+    __u32               compresslen;
+    __s32               ret = 0;
+
+    if (pjob->SrcLen == pjob->DstLen)
+    {
+        //stored block, read to destination directly
+        if (minfs_pread(sb, pjob->pDst, pjob->SrcOffset, pjob->SrcLen) != pjob->SrcLen)
+        {
+            return -EIO;
+        }
+        return 0;
+    }
+    if (pjob->SrcLen <= LZMA_PROPS_SIZE)
+    {
+        fs_log_error("invalid minfs block length %d\n", pjob->SrcLen);
+        return -EIO;
+    }
+
+    compresslen = pjob->SrcLen;
+    ptmpdata = minfs_allocate_temp_buffer(sb, compresslen);
+    if (ptmpdata == NULL)
+    {
+        fs_log_error("allocate temp buffer for block data failed\n");
+        return -ENOMEM;
+    }
+    if (minfs_pread(sb, ptmpdata, pjob->SrcOffset, compresslen) != compresslen)
+    {
+        fs_log_error("read minfs block data failed\n");
+        ret = -EIO;
+        goto out;
+    }
+    uncompresslen = pjob->DstLen;
+    if (minfs_uncompress(pjob->pDst, &uncompresslen, ptmpdata, &compresslen) != EPDK_OK ||
+        uncompresslen != pjob->DstLen)
+    {
+        fs_log_error("uncompress minfs block failed\n");
+        ret = -EIO;
+    }
+
+out:
+    minfs_free_temp_buffer(sb, ptmpdata, pjob->SrcLen);
+    return ret;
+}
+
+static __minfs_blk_job_t *minfs_block_get_job(void)
+{
+    __minfs_blk_job_t *pjob;
+    __u8               err = 0;
+
+    esKRNL_SemPend(minfs_blk_queue_sem, 0, &err);
+    pjob = minfs_blk_job_head;
+    if (pjob)
+    {
+        minfs_blk_job_head = pjob->pNext;
+        if (minfs_blk_job_head == NULL)
+        {
+            minfs_blk_job_tail = NULL;
+        }
+    }
+    esKRNL_SemPost(minfs_blk_queue_sem);
+    return pjob;
+}
+
+static void minfs_block_put_job(__minfs_blk_job_t *pjob)
+{
+    __u8 err = 0;
+
+    pjob->pNext = NULL;
+    esKRNL_SemPend(minfs_blk_queue_sem, 0, &err);
+    if (minfs_blk_job_tail)
+    {
+        minfs_blk_job_tail->pNext = pjob;
+    }
+    else
+    {
+        minfs_blk_job_head = pjob;
+    }
+    minfs_blk_job_tail = pjob;
+    esKRNL_SemPost(minfs_blk_queue_sem);
+    esKRNL_SemPost(minfs_blk_job_sem);
+}
+
+static void minfs_block_run_job(__minfs_blk_job_t *pjob)
+{
+    pjob->Result = minfs_block_decode(pjob);
+    esKRNL_SemPost(pjob->DoneSem);
+}
+
+static void minfs_block_worker(void *p_arg)
+{
+    __minfs_blk_job_t *pjob;
+    __u8               err;
+
+    while (1)
+    {
+        err = 0;
+        esKRNL_SemPend(minfs_blk_job_sem, 0, &err);
+        if (err)
+        {
+            continue;
+        }
+        //the requester may have taken the job itself already
+        pjob = minfs_block_get_job();
+        if (pjob)
+        {
+            minfs_block_run_job(pjob);
+        }
+    }
+}
+
+static void minfs_block_pool_init(void)
+{
+    //mount is serialized by the vfs, so the pool is created only once.
+    if (minfs_blk_job_sem || MINFS_BLK_WORKERS == 0)
+    {
+        return;
+    }
+    minfs_blk_queue_sem = esKRNL_SemCreate(1);
+    minfs_blk_job_sem   = esKRNL_SemCreate(0);
+    if (minfs_blk_queue_sem == NULL || minfs_blk_job_sem == NULL)
+    {
+        fs_log_error("allocate semaphore for minfs block workers failed\n");
+        if (minfs_blk_queue_sem)
+        {
+            esKRNL_SemDel(minfs_blk_queue_sem, 0, NULL);
+            minfs_blk_queue_sem = NULL;
+        }
+        if (minfs_blk_job_sem)
+        {
+            esKRNL_SemDel(minfs_blk_job_sem, 0, NULL);
+            minfs_blk_job_sem = NULL;
+        }
+        return;
+    }
+    while (minfs_blk_workers < MINFS_BLK_WORKERS)
+    {
+        if (esKRNL_TCreate(minfs_block_worker, NULL,
+                           MINFS_BLK_WORKER_STACK, KRNL_priolevel3) == 0)
+        {
+            //fewer workers only cost speed, the requester decodes as well
+            fs_log_warning("create minfs block worker failed\n");
+            break;
+        }
+        minfs_blk_workers++;
+    }
+}
+
+//decode all jobs, the calling thread helps the workers until the queue
+//is drained and then waits for the jobs still running elsewhere.
+static void minfs_block_run_jobs(__minfs_blk_job_t *pjobs, __u32 num, __hdle done)
+{
+    __minfs_blk_job_t *pjob;
+    __u32              i;
+    __u8               err;
+
+    if (minfs_blk_workers == 0 || num == 1)
+    {
+        for (i = 0; i < num; i++)
+        {
+            pjobs[i].Result = minfs_block_decode(&pjobs[i]);
+        }
+        return;
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        pjobs[i].DoneSem = done;
+        minfs_block_put_job(&pjobs[i]);
+    }
+    while ((pjob = minfs_block_get_job()) != NULL)
+    {
+        minfs_block_run_job(pjob);
+    }
+    for (i = 0; i < num; i++)
+    {
+        err = 0;
+        esKRNL_SemPend(done, 0, &err);
+    }
+}
+
+int minfs_block_cache_init(struct super_block *sb)
+{
+    struct minfs_sb_info *sbi = MINFS_SB(sb);
+
+    memset(&sbi->BlkCache, 0, sizeof(sbi->BlkCache));
+    sbi->BlkCache.Sem = esKRNL_SemCreate(1);
+    if (sbi->BlkCache.Sem == NULL)
+    {
+        fs_log_error("allocate semaphore for minfs block cache failed\n");
+        return -EINVAL;
+    }
+    minfs_block_pool_init();
+    return 0;
+}
+
+int minfs_block_cache_exit(struct super_block *sb)
+{
+    struct minfs_sb_info *sbi = MINFS_SB(sb);
+    __u32                 i;
+
+    for (i = 0; i < MINFS_BLK_CACHE_NUM; i++)
+    {
+        if (sbi->BlkCache.Items[i].pData)
+        {
+            free(sbi->BlkCache.Items[i].pData);
+            sbi->BlkCache.Items[i].pData = NULL;
+        }
+    }
+    if (sbi->BlkCache.Sem)
+    {
+        esKRNL_SemDel(sbi->BlkCache.Sem, 0, NULL);
+        sbi->BlkCache.Sem = NULL;
+    }
+    return 0;
+}
+
+static __minfs_blk_cache_item_t *minfs_block_cache_find(struct minfs_sb_info *sbi,
+        __u32 offset, __u32 index)
+{
+    __minfs_blk_cache_item_t *pitem;
+    __u32                     i;
+
+    for (i = 0; i < MINFS_BLK_CACHE_NUM; i++)
+    {
+        pitem = &(sbi->BlkCache.Items[i]);
+        if (pitem->DataOffset == offset && pitem->Index == index)
+        {
+            pitem->Age = ++(sbi->BlkCache.Age);
+            return pitem;
+        }
+    }
+    return NULL;
+}
+
+static __minfs_blk_cache_item_t *minfs_block_cache_alloc(struct minfs_sb_info *sbi,
+        __u32 offset, __u32 index, __u32 len, __minfs_blk_cache_item_t *pbusy)
+{
+    __minfs_blk_cache_item_t *pitem = NULL;
+    __u32                     i;
+
+    //least recently used item, pbusy is still waiting to be decoded.
+    for (i = 0; i < MINFS_BLK_CACHE_NUM; i++)
+    {
+        if (&(sbi->BlkCache.Items[i]) == pbusy)
+        {
+            continue;
+        }
+        if (pitem == NULL || sbi->BlkCache.Items[i].Age < pitem->Age)
+        {
+            pitem = &(sbi->BlkCache.Items[i]);
+        }
+    }
+    if (pitem->BufLen < len)
+    {
+        if (pitem->pData)
+        {
+            free(pitem->pData);
+        }
+        pitem->BufLen = 0;
+        pitem->pData  = malloc(len);
+        if (pitem->pData == NULL)
+        {
+            pitem->DataOffset = 0;
+            return NULL;
+        }
+        pitem->BufLen = len;
+    }
+    pitem->DataOffset = offset;
+    pitem->Index      = index;
+    pitem->Len        = len;
+    pitem->Age        = ++(sbi->BlkCache.Age);
+    return pitem;
+}
+
+__s32 minfs_block_index_load(struct super_block *sb, __u32 offset,
+                             __u32 len, __minfs_blk_index_t *pindex)
+{
+    __minfs_blk_hdr_t hdr;
+    __u32             tablelen;
+    __u32             i;
+
+    if (len < MINFS_BLK_HDR_LEN ||
+        minfs_pread(sb, &hdr, offset, MINFS_BLK_HDR_LEN) != MINFS_BLK_HDR_LEN)
+    {
+        fs_log_error("read minfs block header failed\n");
+        return -EIO;
+    }
+    if (hdr.Magic != MINFS_BLK_MAGIC ||
+        hdr.BlockSize < MINFS_BLK_MIN_SIZE || hdr.BlockSize > MINFS_BLK_MAX_SIZE ||
+        hdr.BlockNum != (hdr.UnPackSize + hdr.BlockSize - 1) / hdr.BlockSize ||
+        hdr.BlockNum > (len - MINFS_BLK_HDR_LEN) / 4 - 1)
+    {
+        fs_log_error("invalid minfs block header\n");
+        return -EINVAL;
+    }
+
+    tablelen = (hdr.BlockNum + 1) * 4;
+    pindex->pOffsets = malloc(tablelen);
+    if (pindex->pOffsets == NULL)
+    {
+        fs_log_error("allocate minfs block index failed\n");
+        return -ENOMEM;
+    }
+    if (minfs_pread(sb, pindex->pOffsets, offset + MINFS_BLK_HDR_LEN, tablelen) != tablelen)
+    {
+        fs_log_error("read minfs block index failed\n");
+        minfs_block_index_release(pindex);
+        return -EIO;
+    }
+    //offsets must be ascending and stay inside the stream
+    if (pindex->pOffsets[0] < MINFS_BLK_HDR_LEN + tablelen ||
+        pindex->pOffsets[hdr.BlockNum] > len)
+    {
+        fs_log_error("invalid minfs block index\n");
+        minfs_block_index_release(pindex);
+        return -EINVAL;
+    }
+    for (i = 0; i < hdr.BlockNum; i++)
+    {
+        if (pindex->pOffsets[i + 1] < pindex->pOffsets[i])
+        {
+            fs_log_error("invalid minfs block index\n");
+            minfs_block_index_release(pindex);
+            return -EINVAL;
+        }
+    }
+
+    pindex->DataOffset = offset;
+    pindex->BlockSize  = hdr.BlockSize;
+    pindex->BlockNum   = hdr.BlockNum;
+    pindex->UnPackSize = hdr.UnPackSize;
+    return 0;
+}
+
+void minfs_block_index_release(__minfs_blk_index_t *pindex)
+{
+    if (pindex->pOffsets)
+    {
+        free(pindex->pOffsets);
+        pindex->pOffsets = NULL;
+    }
+}
+
+__s32 minfs_block_read(struct super_block *sb, __minfs_blk_index_t *pindex,
+                       void *buffer, __u32 pos, __u32 count)
+{
+    struct minfs_sb_info     *sbi = MINFS_SB(sb);
+    __minfs_blk_job_t        *pjobs;
+    __minfs_blk_cache_item_t *pitem;
+    __hdle                    done = NULL;
+    __u8                     *pbuf = (__u8 *)buffer;
+    __u32                     index, last;
+    __u32                     blkpos, blklen;
+    __u32                     start, end;
+    __u32                     num, i;
+    __u8                      err = 0;
+    __s32                     ret = 0;
+
+    if (pos >= pindex->UnPackSize || count == 0)
+    {
+        return 0;
+    }
+    if (count > pindex->UnPackSize - pos)
+    {
+        count = pindex->UnPackSize - pos;
+    }
+
+    pjobs = malloc(sizeof(__minfs_blk_job_t) * MINFS_BLK_MAX_JOBS);
+    if (pjobs == NULL)
+    {
+        return -ENOMEM;
+    }
+    if (minfs_blk_workers)
+    {
+        done = esKRNL_SemCreate(0);
+        if (done == NULL)
+        {
+            free(pjobs);
+            return -ENOMEM;
+        }
+    }
+
+    esKRNL_SemPend(sbi->BlkCache.Sem, 0, &err);
+    index = pos / pindex->BlockSize;
+    last  = (pos + count - 1) / pindex->BlockSize;
+    while (index <= last && ret == 0)
+    {
+        //collect a batch of blocks which are not in the cache
+        num = 0;
+        while (index <= last && num < MINFS_BLK_MAX_JOBS)
+        {
+            blkpos = index * pindex->BlockSize;
+            blklen = pindex->UnPackSize - blkpos;
+            if (blklen > pindex->BlockSize)
+            {
+                blklen = pindex->BlockSize;
+            }
+            start = pos > blkpos ? pos : blkpos;
+            end   = (pos + count) < (blkpos + blklen) ? (pos + count) : (blkpos + blklen);
+
+            pitem = minfs_block_cache_find(sbi, pindex->DataOffset, index);
+            if (pitem)
+            {
+                memcpy(pbuf + start - pos, pitem->pData + start - blkpos, end - start);
+                index++;
+                continue;
+            }
+
+            pjobs[num].sb        = sb;
+            pjobs[num].SrcOffset = pindex->DataOffset + pindex->pOffsets[index];
+            pjobs[num].SrcLen    = pindex->pOffsets[index + 1] - pindex->pOffsets[index];
+            pjobs[num].DstLen    = blklen;
+            pjobs[num].CopyPos   = start - pos;
+            pjobs[num].CopyOff   = start - blkpos;
+            pjobs[num].CopyLen   = end - start;
+            pjobs[num].pItem     = NULL;
+            if (start == blkpos && end == blkpos + blklen)
+            {
+                //whole block wanted, decode to user buffer directly
+                pjobs[num].pDst = pbuf + start - pos;
+            }
+            else
+            {
+                //partial block, keep it for the following reads,
+                //only the first and the last block can be partial.
+                pitem = minfs_block_cache_alloc(sbi, pindex->DataOffset, index, blklen,
+                                                num ? pjobs[0].pItem : NULL);
+                if (pitem == NULL)
+                {
+                    ret = -ENOMEM;
+                    break;
+                }
+                pjobs[num].pItem = pitem;
+                pjobs[num].pDst  = pitem->pData;
+            }
+            num++;
+            index++;
+        }
+
+        minfs_block_run_jobs(pjobs, num, done);
+
+        for (i = 0; i < num; i++)
+        {
+            pitem = pjobs[i].pItem;
+            if (pjobs[i].Result)
+            {
+                ret = pjobs[i].Result;
+                if (pitem)
+                {
+                    pitem->DataOffset = 0;
+                }
+            }
+            else if (pitem)
+            {
+                memcpy(pbuf + pjobs[i].CopyPos, pitem->pData + pjobs[i].CopyOff,
+                       pjobs[i].CopyLen);
+            }
+        }
+    }
+    esKRNL_SemPost(sbi->BlkCache.Sem);
+
+    if (done)
+    {
+        esKRNL_SemDel(done, 0, NULL);
+    }
+    free(pjobs);
+    return ret ? ret : (__s32)count;
+}
@@ -19,6 +19,20 @@
 
 #include "minfs_i.h"
 
+//load the block index of a block-indexed file on first use,
+//the caller must hold the super block lock.
+static __s32 minfs_file_block_index(struct inode *inode)
+{
+    struct minfs_inode_info *exi = MINFS_I(inode);
+
+    if (exi->BlkIndex.pOffsets)
+    {
+        return 0;
+    }
+    return minfs_block_index_load(inode->i_sb, exi->DataOffset,
+                                  exi->DataLen, &(exi->BlkIndex));
+}
+
 static __s32 minfs_romldr_ioctl(struct inode *inode, __u32 cmd,
                                 __u32 aux, void *buffer)
 {
@@ -100,6 +114,35 @@ static __s32 minfs_romldr_ioctl(struct inode *inode, __u32 cmd,
                 fs_log_error("section data have no any data record failed\n");
                 return -EINVAL;
             }
+            if (psectionhdr->Attribute & MINFS_SECTION_ATTR_BLOCKED)
+            {
+                __minfs_blk_index_t index;
+                __s32               ret;
+
+                //block-indexed section, blocks are decoded in parallel
+                //to the user buffer directly.
+                index.pOffsets = NULL;
+                ret = minfs_block_index_load(sb, exi->DataOffset + psectionhdr->Offset,
+                                             psectionhdr->RecSize, &index);
+                if (ret)
+                {
+                    return ret;
+                }
+                if (index.UnPackSize != psectionhdr->RecUnPackSize)
+                {
+                    minfs_block_index_release(&index);
+                    fs_log_error("section block index size mismatch\n");
+                    return -EINVAL;
+                }
+                ret = minfs_block_read(sb, &index, buffer, 0, index.UnPackSize);
+                minfs_block_index_release(&index);
+                if (ret != (__s32)psectionhdr->RecUnPackSize)
+                {
+                    fs_log_error("load block-indexed section data failed\n");
+                    return -EIO;
+                }
+                return 0;
+            }
             if (psectionhdr->Attribute & MINFS_SECTION_ATTR_COMPRESS)
             {
                 __u8    *ptmpdata;
@@ -213,6 +256,19 @@ static __s32 minfs_file_ioctl(struct inode *inode, struct file *filp,
             ret = -EINVAL;
             goto out;
         }
+        if (exi->Attribute & MINFS_ATTR_BLOCKED)
+        {
+            //only the index and the blocks are read, no temp buffer needed
+            ret = minfs_file_block_index(inode);
+            if (ret == 0 &&
+                minfs_block_read(sb, &(exi->BlkIndex), buffer, 0,
+                                 pdentry->UnPackSize) != (__s32)pdentry->UnPackSize)
+            {
+                fs_log_error("uncompress block-indexed file failed\n");
+                ret = -EIO;
+            }
+            goto out;
+        }
         //allocate a temp buffer
         compresslen = pdentry->Size;
         ptmpdata = minfs_allocate_temp_buffer(sb, compresslen);
@@ -245,6 +301,7 @@ static __s32 minfs_file_ioctl(struct inode *inode, struct file *filp,
             goto out;
         }
         //section data load succeeded
+        minfs_free_temp_buffer(sb, ptmpdata, pdentry->Size);
         ret = 0;
         goto out;
     }
@@ -272,6 +329,24 @@ static __s32 minfs_file_read(struct file *filp, char *buffer, __u32 len, __s64 *
     //you can't read beyond file end, adjust read length
     read_number = *pos + len < inode->i_size ? len : inode->i_size - *pos;
 
+    if (exi->Attribute & MINFS_ATTR_BLOCKED)
+    {
+        //decompress only the blocks covering the read range
+        minfs_lock(inode->i_sb);
+        count = minfs_file_block_index(inode);
+        minfs_unlock(inode->i_sb);
+        if (count == 0)
+        {
+            count = minfs_block_read(inode->i_sb, &(exi->BlkIndex),
+                                     buffer, (__u32)(*pos), read_number);
+        }
+        if (count > 0)
+        {
+            (*pos) += count;
+        }
+        return count;
+    }
+
     //read low lelvel device directly
     count = minfs_pread(filp->f_dentry->d_sb, \
                         buffer, \
@@ -38,6 +38,18 @@
 
 #define MINFS_ALIGN(val, align) (((val) + ((align) - 1)) & ~((align) - 1))
 
+#ifdef CONFIG_MINFS_BLOCK_CACHE_NUM
+#define MINFS_BLK_CACHE_NUM     CONFIG_MINFS_BLOCK_CACHE_NUM
+#else
+#define MINFS_BLK_CACHE_NUM     (4)             //decompressed block cache number
+#endif
+#ifdef CONFIG_MINFS_BLOCK_WORKERS
+#define MINFS_BLK_WORKERS       CONFIG_MINFS_BLOCK_WORKERS
+#else
+#define MINFS_BLK_WORKERS       (2)             //block decompress worker threads
+#endif
+#define MINFS_BLK_MAX_JOBS      (32)            //max blocks decoded by one request
+
 typedef struct __MINFS_CACHE_ITEM
 {
     __u32    Sector;
@@ -54,6 +66,33 @@ typedef struct __MINFS_CACHE
     __minfs_cache_item_t CacheItems[MINFS_CACHE_MAXNUM];//cache
 } __minfs_cache_t;
 
+//index of one block-indexed data stream
+typedef struct __MINFS_BLK_INDEX
+{
+    __u32    DataOffset;                        //image byte offset of block header
+    __u32    BlockSize;                         //uncompressed byte size of one block
+    __u32    BlockNum;                          //the number of blocks
+    __u32    UnPackSize;                        //uncompressed byte size of stream
+    __u32   *pOffsets;                          //block offsets, BlockNum + 1 items
+} __minfs_blk_index_t;
+
+typedef struct __MINFS_BLK_CACHE_ITEM
+{
+    __u32    DataOffset;                        //owner stream, 0 means free item
+    __u32    Index;                             //block index within the stream
+    __u32    Len;                               //valid decompressed bytes
+    __u32    BufLen;                            //allocated byte size of pData
+    __u32    Age;                               //last access stamp for LRU
+    __u8    *pData;                             //decompressed block data
+} __minfs_blk_cache_item_t;
+
+typedef struct __MINFS_BLK_CACHE
+{
+    __hdle                   Sem;               //semaphore controlling the lock
+    __u32                    Age;               //access stamp counter
+    __minfs_blk_cache_item_t Items[MINFS_BLK_CACHE_NUM];
+} __minfs_blk_cache_t;
+
 /*
  * minfs super-block data in memory
  */
@@ -69,6 +108,7 @@ struct minfs_sb_info
     __u32           DEntryLen;      //dentry data area size
     __u8           *pDEntryData;    //buffer to store all dentrys data
     __minfs_cache_t Cache;          //device cache
+    __minfs_blk_cache_t BlkCache;   //decompressed block cache
 };
 
 
@@ -81,6 +121,7 @@ struct minfs_inode_info
     __u32           DEntryOffset;
     __u32           DataOffset;
     __u32           DataLen;
+    __minfs_blk_index_t BlkIndex;   //valid when BlkIndex.pOffsets loaded
     struct inode    vfs_inode;
 };
 
@@ -128,5 +169,14 @@ int   minfs_cache_unlock(struct super_block *sb);
 __s32 minfs_uncompress(__u8 *pdst, __u32 *dstLen,
                        __u8 *psrcdata, __u32 *srclen);
 
+//minfs_block.c
+int   minfs_block_cache_init(struct super_block *sb);
+int   minfs_block_cache_exit(struct super_block *sb);
+__s32 minfs_block_index_load(struct super_block *sb, __u32 offset,
+                             __u32 len, __minfs_blk_index_t *pindex);
+void  minfs_block_index_release(__minfs_blk_index_t *pindex);
+__s32 minfs_block_read(struct super_block *sb, __minfs_blk_index_t *pindex,
+                       void *buffer, __u32 pos, __u32 count);
+
 
 #endif  //__MINFS_I_H__
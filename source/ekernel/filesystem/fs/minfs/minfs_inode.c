@@ -29,11 +29,13 @@ struct inode *minfs_alloc_inode(struct super_block *sb)
     {
         return NULL;
     }
+    ei->BlkIndex.pOffsets = NULL;
     return &ei->vfs_inode;
 }
 
 void minfs_destroy_inode(struct inode *inode)
 {
+    minfs_block_index_release(&(MINFS_I(inode)->BlkIndex));
     kmem_cache_free(minfs_inode_cachep, MINFS_I(inode));
 }
 
@@ -106,6 +108,11 @@ static int minfs_fill_inode(struct inode *inode,
 
     //inode basic informations
     inode->i_size   = pdentry->Size;
+    if (pdentry->Attribute & MINFS_ATTR_BLOCKED)
+    {
+        //block-indexed file is read decompressed
+        inode->i_size = pdentry->UnPackSize;
+    }
     inode->i_blocks = (inode->i_size + sbi->SectorSize - 1) >> (sbi->SectorBits);
     inode->i_ino    = dentry_offset;
     if ((pdentry->Attribute & MINFS_ATTR_DIR))
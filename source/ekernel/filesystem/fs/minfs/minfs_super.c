@@ -74,6 +74,7 @@ int minfs_init_sb_info(struct super_block *sb)
     //all cache will cost-down access performance.
     //by sunny at 2011-3-31.
     minfs_cache_init(sb);
+    minfs_block_cache_init(sb);
 
     //load detry data to buffer
     minfs_pread(sb, sbi->pDEntryData,
@@ -88,6 +89,7 @@ void minfs_exit_sb_info(struct super_block *sb)
     struct minfs_sb_info *sbi = MINFS_SB(sb);
 
     //exit minfs cache
+    minfs_block_cache_exit(sb);
     minfs_cache_exit(sb);
 
     if (sbi->Sem)
@@ -126,9 +126,6 @@ struct extent_position
     struct kernel_lb_addr block;
 };
 
-/* udf_crc.c */
-extern u16 crc_itu_t(u16 crc, const u8 *buffer, size_t len);
-
 /* udf_namei.c */
 extern int udf_write_fi(struct inode *inode, struct fileIdentDesc *,
                         struct fileIdentDesc *, struct udf_fileident_bh *,
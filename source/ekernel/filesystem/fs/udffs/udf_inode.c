@@ -24,6 +24,7 @@
 #include "udf_fs_i.h"
 #include "udf_sb.h"
 #include "udf_fs.h"
+#include <libs/checksum.h>
 
 #define EXTENT_MERGE_SIZE 5
 
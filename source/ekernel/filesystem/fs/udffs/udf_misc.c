@@ -23,6 +23,7 @@
 #include "udf_fs.h"
 #include "udf_fs_i.h"
 #include "udf_sb.h"
+#include <libs/checksum.h>
 
 struct buffer_head *udf_tgetblk(struct super_block *sb, int block)
 {
@@ -24,6 +24,7 @@
 #include "buffer_head.h"
 #include "page_pool.h"
 #include "udf_fs.h"
+#include <libs/checksum.h>
 
 extern int memcmp(const void * /*s1*/, const void * /*s2*/, size_t /*n*/);
 
@@ -25,6 +25,7 @@
 #include "udf_fs.h"
 #include "udf_sb.h"
 #include "udf_fs_i.h"
+#include <libs/checksum.h>
 
 #define VDS_POS_PRIMARY_VOL_DESC    0
 #define VDS_POS_UNALLOC_SPACE_DESC  1
@@ -25,6 +25,7 @@
 #include "slab.h"
 #include "page_pool.h"
 #include "udf_sb.h"
+#include <libs/checksum.h>
 
 static int udf_translate_to_linux(uint8_t *, uint8_t *, int, uint8_t *, int);
 
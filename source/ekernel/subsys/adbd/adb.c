@@ -99,9 +99,9 @@ static void send_connect(atransport *t)
 	adbd_debug("");
 	p = get_apacket();
 	p->msg.command = A_CNXN;
-        p->msg.arg0 = A_VERSION;
-        p->msg.arg1 = MAX_PAYLOAD;
-        p->msg.data_length = fill_connect_data((char *)p->data, sizeof(p->data));
+        p->msg.arg0 = t->protocol_version;
+        p->msg.arg1 = t->max_payload;
+        p->msg.data_length = fill_connect_data((char *)p->data, sizeof(p->payload));
 
 	adbd_debug("data length:%u\n", p->msg.data_length);
         send_apacket(p, t);
@@ -112,6 +112,19 @@ static void handle_online(atransport *t)
 	t->online = 1;
 }
 
+/* the host offers its version and payload size, both sides use the smaller */
+static void update_version(atransport *t, unsigned int version, unsigned int payload)
+{
+	if (version < A_VERSION_MIN)
+		version = A_VERSION_MIN;
+	if (payload < MAX_PAYLOAD_V1)
+		payload = MAX_PAYLOAD_V1;
+	t->protocol_version = version < A_VERSION ? version : A_VERSION;
+	t->max_payload = payload < MAX_PAYLOAD ? payload : MAX_PAYLOAD;
+	adbd_info("protocol version 0x%08x, max payload %u",
+		t->protocol_version, t->max_payload);
+}
+
 #if 0
 void print_apacket(const char *label, apacket *p)
 {
@@ -208,6 +221,7 @@ void handle_packet(apacket *p, atransport *t)
                 break;
         case A_CNXN:
                 /*parse_banner((char *)p->data);*/
+		update_version(t, p->msg.arg0, p->msg.arg1);
 		handle_online(t);
 		send_connect(t);
                 break;
@@ -287,6 +301,8 @@ void handle_packet(apacket *p, atransport *t)
 
 void put_apacket(apacket *p)
 {
+	if (p->release)
+		p->release(p);
 	adb_free(p);
 }
 
@@ -297,9 +313,31 @@ apacket *get_apacket(void)
 		fatal("no memory");
 	/*memset(p, 0, sizeof(apacket) - MAX_PAYLOAD);*/
 	memset(p, 0, sizeof(amessage));
+	p->data = p->payload;
+	p->release = NULL;
+	p->priv = NULL;
 	return p;
 }
 
+static void release_data(apacket *p)
+{
+	adb_free(p->data);
+}
+
+/* make p->data of a new packet hold size bytes, over MAX_PAYLOAD_V1 on the heap */
+int apacket_reserve(apacket *p, unsigned int size)
+{
+	if (size <= sizeof(p->payload))
+		return 0;
+	p->data = adb_malloc(size);
+	if (!p->data) {
+		p->data = p->payload;
+		return -1;
+	}
+	p->release = release_data;
+	return 0;
+}
+
 static inline void adbd_version(void)
 {
 	printf("adbd version:%s, compiled on: %s %s\n", ADBD_VERSION, __DATE__, __TIME__);
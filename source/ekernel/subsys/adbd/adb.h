@@ -81,7 +81,16 @@ extern int g_adbd_debug_mask;
 #define USB_ADB_IN  (1)
 #define USB_ADB_OUT (2)
 
-#define MAX_PAYLOAD (4096)
+/*
+ * Largest WRTE payload: MAX_PAYLOAD_V1 until the host's CNXN, then the
+ * smaller of MAX_PAYLOAD and what the host offers (t->max_payload).
+ */
+#define MAX_PAYLOAD_V1 (4*1024)
+#ifdef CONFIG_ADBD_MAX_PAYLOAD
+#define MAX_PAYLOAD (CONFIG_ADBD_MAX_PAYLOAD)
+#else
+#define MAX_PAYLOAD (256*1024)
+#endif
 
 #define A_SYNC 0x434e5953
 #define A_CNXN 0x4e584e43
@@ -92,7 +101,9 @@ extern int g_adbd_debug_mask;
 #define A_AUTH 0x48545541
 
 
-#define A_VERSION 0x01000000        // ADB protocol version
+#define A_VERSION_MIN 0x01000000            // ADB protocol version
+#define A_VERSION_SKIP_CHECKSUM 0x01000001  // no data_check from this version on
+#define A_VERSION 0x01000001                // ADB protocol version
 
 #define ADB_VERSION_MAJOR 1         // Used for help/version information
 #define ADB_VERSION_MINOR 0         // Used for help/version information
@@ -123,7 +134,11 @@ struct amessage
 struct apacket
 {
     amessage msg;
-    unsigned char data[MAX_PAYLOAD];
+    /* payload[] below, or a buffer that release() gives back */
+    unsigned char *data;
+    void (*release)(apacket *p);
+    void *priv;
+    unsigned char payload[MAX_PAYLOAD_V1];
 };
 
 typedef enum transport_type
@@ -149,6 +164,10 @@ struct atransport
     int connection_state;
     int online;
 
+    /* negotiated by CNXN */
+    unsigned int protocol_version;
+    unsigned int max_payload;
+
     adb_queue to_remote;
 };
 
@@ -231,9 +250,12 @@ struct aservice
 void print_apacket(const char *label, apacket *p);
 void handle_packet(apacket *p, atransport *t);
 apacket *get_apacket(void);
+int apacket_reserve(apacket *p, unsigned int size);
 void put_apacket(apacket *p);
 void send_apacket(apacket *p, atransport *t);
 void send_write(const char *buf, int size, unsigned int local, unsigned int remote, atransport *t);
+void send_write_buffer(char *buf, int size, unsigned int local, unsigned int remote, atransport *t,
+                       void (*release)(apacket *p), void *priv);
 void send_write_combine(const char *buf1, int size1,
                         const char *buf2, int size2,
                         unsigned int local, unsigned int remote, atransport *t);
@@ -241,10 +263,11 @@ void send_close(unsigned int local, unsigned int remote, atransport *t);
 void send_ready(unsigned int local, unsigned int remote, atransport *t);
 
 int check_header(apacket *p);
-int check_data(apacket *p);
+int check_data(apacket *p, atransport *t);
 
 
 int init_usb_transport(atransport *t, usb_handle *h, int state);
+void register_local_transport(atransport *t);
 
 
 aservice *adb_service_create(const char *name, unsigned int remoteid, atransport *t);
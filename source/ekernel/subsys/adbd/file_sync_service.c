@@ -156,7 +156,7 @@ static int mkdirs(const char *path)
 static int handle_send_file(char *path, mode_t mode, aservice *ser)
 {
 	int fd;
-	int total_size;
+	unsigned int total_size;
 	int drain_packet = 0;
 	char *buffer = adb_malloc(SYNC_DATA_MAX);
 
@@ -190,7 +190,7 @@ static int handle_send_file(char *path, mode_t mode, aservice *ser)
 		}
 		total_size = msg.data.size;
 		adbd_info("msg data return size=%d, data size:0x%x\n", size, total_size);
-		if (size > SYNC_DATA_MAX) {
+		if (total_size > SYNC_DATA_MAX) {
 			fail_message("oversize data message", ser);
 			drain_packet = 1;
 			continue;
@@ -284,13 +284,112 @@ static int do_send(char *path, aservice *ser)
 
 
 
+/*
+ * Read buffers for do_recv(), handed to the transport without a copy. While
+ * the transport writes one to usb, the next is read from disk. A buffer
+ * still out when do_recv() returns is freed by its release, the last one
+ * frees the pool.
+ */
+#define SYNC_RECV_BUFFERS	(2)
+
+struct recv_pool {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	char *free[SYNC_RECV_BUFFERS];
+	int nfree;
+	int count;	/* allocated */
+	int busy;	/* out with the transport */
+	int closed;
+	unsigned int size;
+};
+
+static struct recv_pool *recv_pool_create(unsigned int size)
+{
+	struct recv_pool *pool = adb_calloc(1, sizeof(struct recv_pool));
+
+	if (!pool)
+		return NULL;
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+	pool->size = size;
+	return pool;
+}
+
+static void recv_pool_free(struct recv_pool *pool)
+{
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->mutex);
+	adb_free(pool);
+}
+
+static char *recv_buffer_get(struct recv_pool *pool)
+{
+	char *buf = NULL;
+
+	pthread_mutex_lock(&pool->mutex);
+	if (!pool->nfree && pool->count < SYNC_RECV_BUFFERS) {
+		buf = adb_malloc(pool->size);
+		if (buf)
+			pool->count++;
+	}
+	while (!buf && !pool->nfree && pool->busy)
+		pthread_cond_wait(&pool->cond, &pool->mutex);
+	if (!buf && pool->nfree)
+		buf = pool->free[--pool->nfree];
+	if (buf)
+		pool->busy++;
+	pthread_mutex_unlock(&pool->mutex);
+	return buf;
+}
+
+static void recv_buffer_put(struct recv_pool *pool, char *buf)
+{
+	int last = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->busy--;
+	if (pool->closed) {
+		adb_free(buf);
+		last = !pool->busy;
+	} else {
+		pool->free[pool->nfree++] = buf;
+		pthread_cond_signal(&pool->cond);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+	if (last)
+		recv_pool_free(pool);
+}
+
+/* apacket release, called by the transport once the data is written */
+static void recv_buffer_release(apacket *p)
+{
+	recv_buffer_put(p->priv, (char *)p->data);
+}
+
+static void recv_pool_close(struct recv_pool *pool)
+{
+	int last;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->closed = 1;
+	while (pool->nfree)
+		adb_free(pool->free[--pool->nfree]);
+	last = !pool->busy;
+	pthread_mutex_unlock(&pool->mutex);
+	if (last)
+		recv_pool_free(pool);
+}
+
 static int do_recv(char *path, aservice *ser)
 {
 	syncmsg msg;
-	int fd, r;
-	char *buffer = adb_malloc(SYNC_DATA_MAX);
+	int fd, r, eof = 0, done = 0;
+	unsigned int size = ser->transport->max_payload;
+	unsigned int len, chunk;
+	struct recv_pool *pool = recv_pool_create(size);
+	char *buffer;
 
-	if (!buffer)
+	if (!pool)
 		fatal("no memory");
 
 	fd = open(path, O_RDONLY);
@@ -299,57 +398,70 @@ static int do_recv(char *path, aservice *ser)
 		goto err;
 	}
 
-	msg.data.id = ID_DATA;
-	for (;;) {
-		int i;
-		char *data = buffer;
-
-		adbd_debug("read data...");
-		r = read(fd, buffer, SYNC_DATA_MAX);
-		if (r <= 0) {
-			adbd_info("read return %d", r);
-			if (r == 0) break;
-			if (errno == EINTR) continue;
-			r = fail_errno(ser);
+	while (!eof) {
+		buffer = recv_buffer_get(pool);
+		if (!buffer) {
+			errno = ENOMEM;
+			fail_errno(ser);
 			goto err;
 		}
-		msg.data.size = r;
-		if (sync_wait_ready_and_error(ser) < 0)
-			goto err;
-		send_write((const char *)&msg.data, sizeof(msg.data),
-			ser->localid, ser->remoteid, ser->transport);
-		for (i = 0; i < r/MAX_PAYLOAD; i++) {
-			if (sync_wait_ready_and_error(ser) < 0)
+
+		/* as many DATA messages as fit one packet, read in place */
+		len = 0;
+		while (len + sizeof(msg.data) < size) {
+			chunk = size - len - sizeof(msg.data);
+			if (chunk > SYNC_DATA_MAX)
+				chunk = SYNC_DATA_MAX;
+			adbd_debug("read data...");
+			r = read(fd, buffer + len + sizeof(msg.data), chunk);
+			if (r <= 0) {
+				adbd_info("read return %d", r);
+				if (r == 0) {
+					eof = 1;
+					break;
+				}
+				if (errno == EINTR) continue;
+				recv_buffer_put(pool, buffer);
+				fail_errno(ser);
 				goto err;
-			send_write((const char *)data, MAX_PAYLOAD, ser->localid,
-				ser->remoteid, ser->transport);
-			data += MAX_PAYLOAD;
+			}
+			msg.data.id = ID_DATA;
+			msg.data.size = r;
+			memcpy(buffer + len, &msg.data, sizeof(msg.data));
+			len += sizeof(msg.data) + r;
 		}
-		r = r%MAX_PAYLOAD;
-		if (r != 0) {
-			if (sync_wait_ready_and_error(ser) < 0)
-				goto err;
-			send_write((const char *)data, r, ser->localid,
-				ser->remoteid, ser->transport);
+		if (eof && len + sizeof(msg.data) <= size) {
+			msg.data.id = ID_DONE;
+			msg.data.size = 0;
+			memcpy(buffer + len, &msg.data, sizeof(msg.data));
+			len += sizeof(msg.data);
+			done = 1;
 		}
+
+		if (sync_wait_ready_and_error(ser) < 0) {
+			recv_buffer_put(pool, buffer);
+			goto err;
+		}
+		send_write_buffer(buffer, len, ser->localid, ser->remoteid,
+			ser->transport, recv_buffer_release, pool);
 		adbd_debug("do recv loop");
 	}
 	close(fd);
 	fd = -1;
 
-	msg.data.id = ID_DONE;
-	msg.data.size = 0;
-	if (sync_wait_ready_and_error(ser) < 0)
-		goto err;
-	send_write((const char *)&msg.data, sizeof(msg.data), ser->localid, ser->remoteid, ser->transport);
-	if (buffer)
-		adb_free(buffer);
+	if (!done) {
+		msg.data.id = ID_DONE;
+		msg.data.size = 0;
+		if (sync_wait_ready_and_error(ser) < 0)
+			goto err;
+		send_write((const char *)&msg.data, sizeof(msg.data), ser->localid, ser->remoteid, ser->transport);
+	}
+	recv_pool_close(pool);
 	return 0;
 err:
 	if (fd > 0)
 		close(fd);
-	if (buffer)
-		adb_free(buffer);
+	recv_pool_close(pool);
 	return -1;
 }
 
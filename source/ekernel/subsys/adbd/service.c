@@ -113,7 +113,7 @@ static void *shell_event_handle(void *arg)
 			apacket *p = get_apacket();
 			while (1) {
 				size = adb_ringbuffer_get(xfer->rb_write_by_shell,
-						p->data + current, sizeof(p->data) - current, -1);
+						p->data + current, sizeof(p->payload) - current, -1);
 				/*adbd_err("size=%d", size);*/
 				if (!size) {
 					if (count-- < 0)
@@ -141,7 +141,7 @@ static void *shell_event_handle(void *arg)
 				apacket *p = get_apacket();
 				adbd_err("");
 				size = adb_ringbuffer_get(xfer->rb_write_by_shell,
-						p->data, sizeof(p->data), -1);
+						p->data, sizeof(p->payload), -1);
 				adbd_err("size=%d", size);
 				if (!size) {
 					put_apacket(p);
@@ -162,8 +162,9 @@ void socket_recv_service(void *xfer_handle, void *cookie)
             break;
         }
         adbd_debug("");
-        memset(buffer, 0, MAX_PAYLOAD);
-        size = lwip_recv(xfer->s, buffer, MAX_PAYLOAD, MSG_DONTWAIT);
+        memset(buffer, 0, ser->transport->max_payload);
+        /* one WRTE each, no more than the host takes */
+        size = lwip_recv(xfer->s, buffer, ser->transport->max_payload, MSG_DONTWAIT);
         adbd_debug("size=%d\n", size);
         if (xfer->recv_close)
         {
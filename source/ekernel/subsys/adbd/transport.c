@@ -34,6 +34,7 @@
 #include <string.h>
 #include "adb.h"
 #include "misc.h"
+#include <libs/checksum.h>
 
 
 static int read_packet(apacket **ppacket, atransport *t)
@@ -104,17 +105,12 @@ static int write_packet(apacket *p, atransport *t)
 
 void send_apacket(apacket *p, atransport *t)
 {
-	unsigned char *x;
-        unsigned int sum;
-        int count;
-
 	p->msg.magic = p->msg.command ^ 0xffffffff;
-        count = p->msg.data_length;
-        x = (unsigned char *)p->data;
-        sum = 0;
-        while (count-- > 0)
-                sum += *x++;
-        p->msg.data_check = sum;
+	/* the host checks its CNXN reply before it knows the version */
+	if (t->protocol_version < A_VERSION_SKIP_CHECKSUM || p->msg.command == A_CNXN)
+		p->msg.data_check = csum_bytes(0, p->data, p->msg.data_length);
+	else
+		p->msg.data_check = 0;
 
         print_apacket("send", p);
 
@@ -131,6 +127,8 @@ void send_write_combine(const char *buf1, int size1,
 	adbd_debug("");
 
 	apacket *p = get_apacket();
+	if (apacket_reserve(p, size1 + size2))
+		fatal("no memory");
 	p->msg.command = A_WRTE;
 	p->msg.arg0 = local;
 	p->msg.arg1 = remote;
@@ -146,6 +144,8 @@ void send_write(const char *buf, int size, unsigned int local, unsigned int remo
 	adbd_debug("");
 
 	apacket *p = get_apacket();
+	if (apacket_reserve(p, size))
+		fatal("no memory");
 	p->msg.command = A_WRTE;
 	p->msg.arg0 = local;
 	p->msg.arg1 = remote;
@@ -155,6 +155,27 @@ void send_write(const char *buf, int size, unsigned int local, unsigned int remo
 	send_apacket(p, t);
 }
 
+/*
+ * Like send_write(), without the copy: the transport writes straight from
+ * buf and calls release(p) when done with it, p->priv set to priv.
+ */
+void send_write_buffer(char *buf, int size, unsigned int local, unsigned int remote, atransport *t,
+			void (*release)(apacket *p), void *priv)
+{
+	adbd_debug("");
+
+	apacket *p = get_apacket();
+	p->msg.command = A_WRTE;
+	p->msg.arg0 = local;
+	p->msg.arg1 = remote;
+	p->msg.data_length = size;
+	p->data = (unsigned char *)buf;
+	p->release = release;
+	p->priv = priv;
+
+	send_apacket(p, t);
+}
+
 
 int check_header(apacket *p)
 {
@@ -169,18 +190,11 @@ int check_header(apacket *p)
 	return 0;
 }
 
-int check_data(apacket *p)
+int check_data(apacket *p, atransport *t)
 {
-	unsigned int count, sum;
-	unsigned char *x;
-
-	count = p->msg.data_length;
-	x = p->data;
-	sum = 0;
-	while (count-- > 0) {
-		sum += *x++;
-	}
-	if (sum != p->msg.data_check)
+	if (t->protocol_version >= A_VERSION_SKIP_CHECKSUM)
+		return 0;
+	if (csum_bytes(0, p->data, p->msg.data_length) != p->msg.data_check)
 		return -1;
 	return 0;
 }
@@ -241,6 +255,9 @@ static void register_transport(atransport *t)
 	adb_thread_t output_thread_ptr; /* */
 	adb_thread_t input_thread_ptr;
 
+	t->protocol_version = A_VERSION_MIN;
+	t->max_payload = MAX_PAYLOAD_V1;
+
 	if (adb_thread_create(&input_thread_ptr, input_thread, "adbd-input", t, ADB_THREAD_HIGH_PRIORITY)) {
 		fatal("cannot create input thread");
 	}
@@ -265,3 +282,14 @@ void register_usb_transport(usb_handle *usb, const char *serial, const char *dev
 	/* TODO: serial, devpath */
 	register_transport(t);
 }
+
+/* a transport with read_from_remote/write_to_remote set up by the caller */
+void register_local_transport(atransport *t)
+{
+	adbd_debug("");
+
+	t->type = kTransportLocal;
+	t->sync_token = 1;
+	t->to_remote = adb_queue_init();
+	register_transport(t);
+}
@@ -48,20 +48,21 @@ static int remote_read(apacket *p, atransport *t)
 		return -1;
 	}
 	if (p->msg.data_length > 0) {
-		int residue = p->msg.data_length;
-		unsigned char *data = p->data;
 		int aw_hexdump(const char *buf, int bytes);
 		/*aw_hexdump(&p->msg, sizeof(p->msg));*/
 		adbd_debug("command:0x%x, data_length:%u\n", p->msg.command, p->msg.data_length);
-		while (residue > 0) {
-			size = residue > 512 ? 512 : residue;
-			size = usb_read(t->usb, data, size);
-			residue -= size;
-			data += size;
-			adbd_debug("size:%d, residue:%d\n", size, residue);
+		if (apacket_reserve(p, p->msg.data_length)) {
+			adbd_err("no memory for %u bytes", p->msg.data_length);
+			return -1;
+		}
+		/* usb_read() loops until the whole payload is in */
+		size = usb_read(t->usb, p->data, p->msg.data_length);
+		if (size != p->msg.data_length) {
+			adbd_err("remote usb: read terminated(data)");
+			return -1;
 		}
 	}
-	if (check_data(p)) {
+	if (check_data(p, t)) {
 		adbd_err("check data failed");
 		return -1;
 	}
@@ -109,6 +109,7 @@ aa:      85.1% -- replaced with aa.gz
 #include "glibbb.h"
 #include "bb_archive.h"
 #include <stdio.h>
+#include <libs/checksum.h>
 #include <rtthread.h>
 /* ===========================================================================
  */
@@ -526,7 +527,7 @@ static void put_32bit(ulg n)
  */
 static void updcrc(uch *s, unsigned n)
 {
-    G1.crc = crc32_block_endian0(G1.crc, s, n, global_crc32_table /*G1.crc_32_tab*/);
+    G1.crc = crc32_le(G1.crc, s, n);
 }
 
 
@@ -2473,9 +2474,6 @@ int gzip_main(int argc, char **argv)
     ALLOC(uch, G1.window, 2L * WSIZE);
     ALLOC(ush, G1.prev, 1L << BITS);
 
-    /* Initialize the CRC32 table */
-    global_crc32_table = crc32_filltable(NULL, 0);
-
     argv += optind;
     return bbunpack(argv, pack_gzip, append_ext, "gz");
 }
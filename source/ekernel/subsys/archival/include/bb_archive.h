@@ -250,6 +250,7 @@ ssize_t xtransformer_write(transformer_state_t *xstate, const void *buf, size_t
 int check_signature16(transformer_state_t *xstate, unsigned magic16);
 
 int inflate_unzip(transformer_state_t *xstate);
+extern int gunzip_fast_inflate;
 int unpack_Z_stream(transformer_state_t *xstate);
 int unpack_gz_stream(transformer_state_t *xstate);
 int unpack_bz2_stream(transformer_state_t *xstate);
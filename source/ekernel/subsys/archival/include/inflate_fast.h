@@ -0,0 +1,55 @@
+/* vi: set sw=4 ts=4: */
+/*
+ * Table driven deflate decoder with a zlib style fast loop, used by
+ * decompress_gunzip.c when CONFIG_ARCHIVAL_FAST_INFLATE is enabled.
+ *
+ * Licensed under GPLv2 or later, see file LICENSE in this source tree.
+ */
+#ifndef __INFLATE_FAST_H__
+#define __INFLATE_FAST_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct fast_inflate_io
+{
+    void *ctx;
+    /* Hand out the next chunk of compressed input. Returns its length,
+     * 0 at end of input or < 0 on read error. The chunk must stay valid
+     * until the next call. */
+    int (*fill)(void *ctx, const unsigned char **buf);
+    /* Consume decompressed output. Returns < 0 to abort. NULL selects
+     * memory mode, where output goes straight to the buffer passed to
+     * fast_inflate_run() and must fit in it. */
+    int (*flush)(void *ctx, const unsigned char *buf, unsigned len);
+} fast_inflate_io_t;
+
+typedef struct fast_inflate_result
+{
+    uint64_t bytes_out;
+    /* First byte after the deflate stream inside the last chunk. */
+    const unsigned char *next_in;
+    /* Bytes after the deflate stream that were already read ahead from a
+     * previous chunk; logically they precede next_in. Usually 0. */
+    unsigned unget_len;
+    unsigned char unget[8];
+} fast_inflate_result_t;
+
+/*
+ * Decode one raw deflate stream (RFC 1951).
+ * out/out_len is the destination in memory mode and ignored otherwise.
+ * Returns 0 on success, -1 on corrupted or truncated data, -2 on I/O error
+ * or when the output does not fit.
+ */
+int fast_inflate_run(const fast_inflate_io_t *io, void *out, size_t out_len,
+                     fast_inflate_result_t *res);
+
+/* Raw deflate, memory to memory. */
+int fast_inflate_mem(void *dst, size_t dst_len, const void *src, size_t src_len,
+                     size_t *out_len, size_t *in_used);
+
+/* Single member .gz image, memory to memory, crc and size verified. */
+int fast_gunzip_mem(void *dst, size_t dst_len, const void *src, size_t src_len,
+                    size_t *out_len);
+
+#endif /* __INFLATE_FAST_H__ */
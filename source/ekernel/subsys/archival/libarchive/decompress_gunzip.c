@@ -41,6 +41,10 @@
 #include "glibbb.h"
 #include "platform.h"
 #include "bb_archive.h"
+#include <libs/checksum.h>
+#ifdef CONFIG_ARCHIVAL_FAST_INFLATE
+#include "inflate_fast.h"
+#endif
 
 typedef struct huft_t
 {
@@ -85,8 +89,6 @@ typedef struct state_t
 
     unsigned char *gunzip_window;
 
-    uint32_t *gunzip_crc_table;
-
     /* bitbuffer */
     unsigned gunzip_bb; /* bit buffer */
     unsigned char gunzip_bk; /* bits in bit buffer */
@@ -132,7 +134,6 @@ typedef struct state_t
 #define gunzip_src_fd       (S()gunzip_src_fd      )
 #define gunzip_outbuf_count (S()gunzip_outbuf_count)
 #define gunzip_window       (S()gunzip_window      )
-#define gunzip_crc_table    (S()gunzip_crc_table   )
 #define gunzip_bb           (S()gunzip_bb          )
 #define gunzip_bk           (S()gunzip_bk          )
 #define to_read             (S()to_read            )
@@ -1045,7 +1046,7 @@ static int inflate_block(STATE_PARAM smallint *e)
 /* Two callsites, both in inflate_get_next_window */
 static void calculate_gunzip_crc(STATE_PARAM_ONLY)
 {
-    gunzip_crc = crc32_block_endian0(gunzip_crc, gunzip_window, gunzip_outbuf_count, gunzip_crc_table);
+    gunzip_crc = crc32_le(gunzip_crc, gunzip_window, gunzip_outbuf_count);
     gunzip_bytes_out += gunzip_outbuf_count;
 }
 
@@ -1094,6 +1095,106 @@ static int inflate_get_next_window(STATE_PARAM_ONLY)
 }
 
 
+#ifdef CONFIG_ARCHIVAL_FAST_INFLATE
+/* Clear to fall back to the original decoder below, e.g. for comparison */
+int gunzip_fast_inflate = 1;
+
+struct fast_inflate_ctx
+{
+    state_t *state;
+    transformer_state_t *xstate;
+};
+
+/* Input for inflate_fast.c: first what is left in bytebuffer, then reads.
+ * Like fill_bitbuffer(), keep the head of bytebuffer free (8 bytes here,
+ * the read-ahead of a 64bit bit buffer) so it can be unwound in place. */
+static int fast_inflate_fill(void *ctx, const unsigned char **buf)
+{
+    state_t *state = ((struct fast_inflate_ctx *)ctx)->state;
+    int n;
+
+    if (bytebuffer_offset < bytebuffer_size)
+    {
+        *buf = &bytebuffer[bytebuffer_offset];
+        n = bytebuffer_size - bytebuffer_offset;
+        bytebuffer_offset = bytebuffer_size;
+        return n;
+    }
+
+    n = bytebuffer_max - 8;
+    if (to_read >= 0 && to_read < n) /* unzip only */
+    {
+        n = to_read;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+    n = read(gunzip_src_fd, &bytebuffer[8], n);
+    if (n < 0)
+    {
+        return -1;
+    }
+    if (to_read >= 0) /* unzip only */
+    {
+        to_read -= n;
+    }
+    bytebuffer_offset = 8 + n;
+    bytebuffer_size = 8 + n;
+    *buf = &bytebuffer[8];
+    return n;
+}
+
+static int fast_inflate_flush(void *ctx, const unsigned char *buf, unsigned len)
+{
+    struct fast_inflate_ctx *fctx = ctx;
+    state_t *state = fctx->state;
+
+    gunzip_crc = crc32_le(gunzip_crc, buf, len);
+    gunzip_bytes_out += len;
+    if (transformer_write(fctx->xstate, buf, len) == (ssize_t) -1)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+static IF_DESKTOP(long long) int
+inflate_unzip_internal_fast(STATE_PARAM transformer_state_t *xstate)
+{
+    struct fast_inflate_ctx fctx;
+    fast_inflate_io_t io;
+    fast_inflate_result_t res;
+
+    gunzip_bytes_out = 0;
+    gunzip_src_fd = xstate->src_fd;
+    gunzip_crc = ~0;
+    gunzip_bk = 0;
+    gunzip_bb = 0;
+
+    fctx.state = state;
+    fctx.xstate = xstate;
+    io.ctx = &fctx;
+    io.fill = fast_inflate_fill;
+    io.flush = fast_inflate_flush;
+
+    if (fast_inflate_run(&io, NULL, 0, &res) != 0)
+    {
+        printf("bb_error_msg: corrupted data\n");
+        return -1;
+    }
+
+    /* Unwind the read-ahead so the gzip trailer is read from the right place */
+    bytebuffer_offset = res.next_in - bytebuffer;
+    if (res.unget_len)
+    {
+        bytebuffer_offset -= res.unget_len;
+        memcpy(&bytebuffer[bytebuffer_offset], res.unget, res.unget_len);
+    }
+    return IF_DESKTOP(gunzip_bytes_out +) 0;
+}
+#endif
+
 /* Called from unpack_gz_stream() and inflate_unzip() */
 static IF_DESKTOP(long long) int
 inflate_unzip_internal(STATE_PARAM transformer_state_t *xstate)
@@ -1101,6 +1202,13 @@ inflate_unzip_internal(STATE_PARAM transformer_state_t *xstate)
     IF_DESKTOP(long long) int n = 0;
     ssize_t nwrote;
 
+#ifdef CONFIG_ARCHIVAL_FAST_INFLATE
+    if (gunzip_fast_inflate)
+    {
+        return inflate_unzip_internal_fast(PASS_STATE xstate);
+    }
+#endif
+
     /* Allocate all global buffers (for DYN_ALLOC option) */
     gunzip_window = xmalloc(GUNZIP_WSIZE);
     gunzip_outbuf_count = 0;
@@ -1114,8 +1222,6 @@ inflate_unzip_internal(STATE_PARAM transformer_state_t *xstate)
     gunzip_bk = 0;
     gunzip_bb = 0;
 
-    /* Create the crc table */
-    gunzip_crc_table = crc32_filltable(NULL, 0);
     gunzip_crc = ~0;
 
     error_msg = "corrupted data";
@@ -1157,7 +1263,6 @@ inflate_unzip_internal(STATE_PARAM transformer_state_t *xstate)
 ret:
     /* Cleanup */
     free(gunzip_window);
-    free(gunzip_crc_table);
     return n;
 }
 
@@ -0,0 +1,1205 @@
+/* vi: set sw=4 ts=4: */
+/*
+ * Fast deflate decoder for gunzip.
+ *
+ * Compared to inflate_codes()/huft_build() in decompress_gunzip.c, which
+ * pull one byte at a time through fill_bitbuffer() and walk linked huft
+ * tables per symbol:
+ *  - a 64bit bit buffer is refilled with one unaligned 8 byte load, which
+ *    covers the worst case length/distance symbol pair (48 bits);
+ *  - decode tables are flat arrays with a 9 bit (lengths) / 6 bit
+ *    (distances) root and one level of sub tables, whose entries already
+ *    carry the base value and extra bit count of the symbol;
+ *  - matches with distance >= 8 are copied 8 bytes at a time.
+ * The fast loop runs while at least 8 input bytes and 266 output bytes are
+ * available; the remainder goes through a checked one symbol path.
+ *
+ * Table construction follows inflate_table() of zlib by Mark Adler.
+ *
+ * Licensed under GPLv2 or later, see file LICENSE in this source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <libs/checksum.h>
+#include "inflate_fast.h"
+
+enum
+{
+    FI_WSIZE      = 0x8000,       /* deflate history window */
+    FI_OUTBUF     = 0x18000,      /* stream mode output buffer, window + 64K */
+    FI_MAXBITS    = 15,
+    FI_MAXMATCH   = 258,
+    FI_SLACK      = FI_MAXMATCH + 8,  /* match length + word copy overrun */
+    FI_LROOT      = 9,
+    FI_DROOT      = 6,
+    FI_CROOT      = 7,
+    FI_ENOUGH_L   = 852,          /* see zlib's enough.c for these bounds */
+    FI_ENOUGH_D   = 592,
+    FI_NSYMS      = 288 + 32,
+};
+
+/* table entry op */
+#define FI_LIT      0x00        /* literal / plain value in val */
+#define FI_BASE     0x10        /* val is a length or distance base, low nibble extra bits */
+#define FI_EOB      0x20        /* end of block */
+#define FI_LINK     0x40        /* sub table at val, low nibble its index bits */
+#define FI_BAD      0x80        /* invalid code */
+
+enum
+{
+    FI_CODES,
+    FI_LENS,
+    FI_DISTS,
+};
+
+typedef struct fi_code
+{
+    uint8_t  op;
+    uint8_t  bits;
+    uint16_t val;
+} fi_code;
+
+typedef struct fi_state
+{
+    const fast_inflate_io_t *io;
+
+    const uint8_t *in_start;    /* current input chunk */
+    const uint8_t *in;
+    const uint8_t *in_end;
+
+    uint64_t hold;              /* bit buffer, LSB first */
+    unsigned bits;              /* valid bits in hold, the rest is zero */
+
+    uint8_t *out_base;          /* history starts here */
+    uint8_t *out;
+    uint8_t *out_end;
+    uint8_t *out_flushed;       /* stream mode: first byte not yet flushed */
+    uint64_t total_out;
+
+    const fi_code *lcode;
+    const fi_code *dcode;
+    unsigned lbits;
+    unsigned dbits;
+
+    int fixed_built;
+    unsigned fixed_lbits;
+    unsigned fixed_dbits;
+    fi_code fixed_l[512];
+    fi_code fixed_d[32];
+    fi_code dyn_l[FI_ENOUGH_L];
+    fi_code dyn_d[FI_ENOUGH_D];
+    uint16_t lens[FI_NSYMS];
+} fi_state;
+
+static const uint16_t fi_len_base[29] =
+{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+    67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t fi_len_extra[29] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5,
+    5, 5, 5, 0
+};
+
+static const uint16_t fi_dist_base[30] =
+{
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+    769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t fi_dist_extra[30] =
+{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+    11, 11, 12, 12, 13, 13
+};
+
+static const uint8_t fi_order[19] =
+{
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static inline uint64_t fi_load64(const uint8_t *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static void fi_entry(int type, unsigned sym, fi_code *here)
+{
+    here->val = 0;
+    if (type == FI_CODES)
+    {
+        here->op = FI_LIT;
+        here->val = sym;
+    }
+    else if (type == FI_LENS)
+    {
+        if (sym < 256)
+        {
+            here->op = FI_LIT;
+            here->val = sym;
+        }
+        else if (sym == 256)
+        {
+            here->op = FI_EOB;
+        }
+        else if (sym < 286)
+        {
+            here->op = FI_BASE | fi_len_extra[sym - 257];
+            here->val = fi_len_base[sym - 257];
+        }
+        else
+        {
+            here->op = FI_BAD;
+        }
+    }
+    else
+    {
+        if (sym < 30)
+        {
+            here->op = FI_BASE | fi_dist_extra[sym];
+            here->val = fi_dist_base[sym];
+        }
+        else
+        {
+            here->op = FI_BAD;
+        }
+    }
+}
+
+/*
+ * Build a two level decode table for the code lengths lens[0..codes-1].
+ * *bits is the requested root size on entry and the one used on return.
+ * Returns 0 on success, -1 for an over-subscribed or (except for a single
+ * one bit code) incomplete set of lengths.
+ */
+static int fi_build(int type, const uint16_t *lens, unsigned codes,
+                    fi_code *table, unsigned *bits, unsigned enough)
+{
+    uint16_t count[FI_MAXBITS + 1];
+    uint16_t offs[FI_MAXBITS + 1];
+    uint16_t work[FI_NSYMS];
+    unsigned len, sym, min, max, root, curr, drop, used, huff, incr, fill, low, mask;
+    int left;
+    fi_code here, *next;
+
+    memset(count, 0, sizeof(count));
+    for (sym = 0; sym < codes; sym++)
+    {
+        count[lens[sym]]++;
+    }
+
+    root = *bits;
+    for (max = FI_MAXBITS; max >= 1; max--)
+    {
+        if (count[max] != 0)
+        {
+            break;
+        }
+    }
+    if (root > max)
+    {
+        root = max;
+    }
+    if (max == 0)
+    {
+        /* no codes at all: any lookup is an error */
+        here.op = FI_BAD;
+        here.bits = 1;
+        here.val = 0;
+        table[0] = here;
+        table[1] = here;
+        *bits = 1;
+        return 0;
+    }
+    for (min = 1; min < max; min++)
+    {
+        if (count[min] != 0)
+        {
+            break;
+        }
+    }
+    if (root < min)
+    {
+        root = min;
+    }
+
+    left = 1;
+    for (len = 1; len <= FI_MAXBITS; len++)
+    {
+        left <<= 1;
+        left -= count[len];
+        if (left < 0)
+        {
+            return -1;
+        }
+    }
+    if (left > 0 && (type == FI_CODES || max != 1))
+    {
+        return -1;
+    }
+
+    offs[1] = 0;
+    for (len = 1; len < FI_MAXBITS; len++)
+    {
+        offs[len + 1] = offs[len] + count[len];
+    }
+    for (sym = 0; sym < codes; sym++)
+    {
+        if (lens[sym] != 0)
+        {
+            work[offs[lens[sym]]++] = sym;
+        }
+    }
+
+    huff = 0;
+    sym = 0;
+    len = min;
+    next = table;
+    curr = root;
+    drop = 0;
+    low = (unsigned)(-1);
+    used = 1U << root;
+    mask = used - 1;
+    if (used > enough)
+    {
+        return -1;
+    }
+
+    for (;;)
+    {
+        here.bits = (uint8_t)(len - drop);
+        fi_entry(type, work[sym], &here);
+
+        /* replicate for all indices whose low len bits equal huff */
+        incr = 1U << (len - drop);
+        fill = 1U << curr;
+        min = fill;
+        do
+        {
+            fill -= incr;
+            next[(huff >> drop) + fill] = here;
+        } while (fill != 0);
+
+        /* backwards increment the len bit code huff */
+        incr = 1U << (len - 1);
+        while (huff & incr)
+        {
+            incr >>= 1;
+        }
+        if (incr != 0)
+        {
+            huff &= incr - 1;
+            huff += incr;
+        }
+        else
+        {
+            huff = 0;
+        }
+
+        sym++;
+        if (--(count[len]) == 0)
+        {
+            if (len == max)
+            {
+                break;
+            }
+            len = lens[work[sym]];
+        }
+
+        if (len > root && (huff & mask) != low)
+        {
+            if (drop == 0)
+            {
+                drop = root;
+            }
+            next += min;
+
+            /* smallest sub table that holds all codes with this prefix */
+            curr = len - drop;
+            left = (int)(1 << curr);
+            while (curr + drop < max)
+            {
+                left -= count[curr + drop];
+                if (left <= 0)
+                {
+                    break;
+                }
+                curr++;
+                left <<= 1;
+            }
+
+            used += 1U << curr;
+            if (used > enough)
+            {
+                return -1;
+            }
+
+            low = huff & mask;
+            table[low].op = (uint8_t)(FI_LINK | curr);
+            table[low].bits = (uint8_t)root;
+            table[low].val = (uint16_t)(next - table);
+        }
+    }
+
+    if (huff != 0)
+    {
+        /* the only incomplete code allowed is a single one bit code */
+        here.op = FI_BAD;
+        here.bits = (uint8_t)(len - drop);
+        here.val = 0;
+        next[huff] = here;
+    }
+
+    *bits = root;
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* checked bit and byte access, used outside the fast loop                    */
+/* ------------------------------------------------------------------------- */
+
+static int fi_next_chunk(fi_state *s)
+{
+    const unsigned char *buf;
+    int n;
+
+    n = s->io->fill(s->io->ctx, &buf);
+    if (n < 0)
+    {
+        return -2;
+    }
+    if (n == 0)
+    {
+        return -1;
+    }
+    s->in_start = buf;
+    s->in = buf;
+    s->in_end = buf + n;
+    return 0;
+}
+
+static int fi_pull(fi_state *s)
+{
+    int ret;
+
+    if (s->in == s->in_end)
+    {
+        ret = fi_next_chunk(s);
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    s->hold |= (uint64_t)(*s->in++) << s->bits;
+    s->bits += 8;
+    return 0;
+}
+
+/* make sure n bits are in the bit buffer */
+static int fi_need(fi_state *s, unsigned n)
+{
+    int ret;
+
+    while (s->bits < n)
+    {
+        ret = fi_pull(s);
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    return 0;
+}
+
+static inline unsigned fi_take(fi_state *s, unsigned n)
+{
+    unsigned v = (unsigned)(s->hold & ((1U << n) - 1));
+
+    s->hold >>= n;
+    s->bits -= n;
+    return v;
+}
+
+static int fi_getbits(fi_state *s, unsigned n, unsigned *v)
+{
+    int ret = fi_need(s, n);
+
+    if (ret)
+    {
+        return ret;
+    }
+    *v = fi_take(s, n);
+    return 0;
+}
+
+static int fi_decode(fi_state *s, const fi_code *table, unsigned root, fi_code *e)
+{
+    fi_code here;
+    int ret;
+
+    /* a symbol is at most 15 bits; near the end of the input there may be
+     * fewer, which is fine as long as the code found is not longer */
+    while (s->bits < FI_MAXBITS)
+    {
+        ret = fi_pull(s);
+        if (ret == -1)
+        {
+            break;
+        }
+        if (ret)
+        {
+            return ret;
+        }
+    }
+
+    here = table[s->hold & ((1U << root) - 1)];
+    if (here.op & FI_LINK)
+    {
+        if (here.bits > s->bits)
+        {
+            return -1;
+        }
+        fi_take(s, here.bits);
+        here = table[here.val + (s->hold & ((1U << (here.op & 15)) - 1))];
+    }
+    if (here.bits > s->bits)
+    {
+        return -1;
+    }
+    fi_take(s, here.bits);
+    *e = here;
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* output                                                                    */
+/* ------------------------------------------------------------------------- */
+
+static int fi_flush(fi_state *s, int final)
+{
+    unsigned n = s->out - s->out_flushed;
+    unsigned keep;
+
+    if (n)
+    {
+        if (s->io->flush(s->io->ctx, s->out_flushed, n) < 0)
+        {
+            return -2;
+        }
+        s->total_out += n;
+    }
+    if (!final)
+    {
+        keep = s->out - s->out_base;
+        if (keep > FI_WSIZE)
+        {
+            keep = FI_WSIZE;
+        }
+        memmove(s->out_base, s->out - keep, keep);
+        s->out = s->out_base + keep;
+    }
+    s->out_flushed = s->out;
+    return 0;
+}
+
+/* make room for n more output bytes, n <= FI_SLACK */
+static int fi_room(fi_state *s, unsigned n)
+{
+    if ((unsigned)(s->out_end - s->out) >= n)
+    {
+        return 0;
+    }
+    if (s->io->flush == NULL)
+    {
+        return -2;
+    }
+    return fi_flush(s, 0);
+}
+
+static inline void fi_copy_match(uint8_t *out, unsigned dist, unsigned len)
+{
+    const uint8_t *from = out - dist;
+    uint64_t w;
+
+    if (dist >= 8)
+    {
+        /* may write up to 7 bytes past out + len, covered by FI_SLACK */
+        for (;;)
+        {
+            memcpy(&w, from, 8);
+            memcpy(out, &w, 8);
+            if (len <= 8)
+            {
+                break;
+            }
+            out += 8;
+            from += 8;
+            len -= 8;
+        }
+    }
+    else if (dist == 1)
+    {
+        memset(out, *from, len);
+    }
+    else
+    {
+        while (len--)
+        {
+            *out++ = *from++;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+/* block decoding                                                            */
+/* ------------------------------------------------------------------------- */
+
+/*
+ * Decode symbols while 8 input and FI_SLACK output bytes are guaranteed.
+ * Returns 1 at end of block, 0 when a limit is reached, -1 on bad data.
+ */
+static int fi_codes_fast(fi_state *s)
+{
+    const fi_code *lcode = s->lcode;
+    const fi_code *dcode = s->dcode;
+    const uint64_t lmask = (1U << s->lbits) - 1;
+    const uint64_t dmask = (1U << s->dbits) - 1;
+    const uint8_t *in = s->in;
+    const uint8_t *in_last = s->in_end - 8;
+    uint8_t *out = s->out;
+    uint8_t *out_last = s->out_end - FI_SLACK;
+    uint8_t *beg = s->out_base;
+    uint64_t hold = s->hold;
+    unsigned bits = s->bits;
+    unsigned op, len, dist, extra;
+    fi_code here;
+    int ret = 0;
+
+    while (in <= in_last && out <= out_last)
+    {
+        /* top up to 56..63 bits; bytes only partly loaded stay in input */
+        hold |= fi_load64(in) << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+
+        here = lcode[hold & lmask];
+dolen:
+        hold >>= here.bits;
+        bits -= here.bits;
+        op = here.op;
+        if (op == FI_LIT)
+        {
+            *out++ = (uint8_t)here.val;
+            continue;
+        }
+        if (op & FI_BASE)
+        {
+            extra = op & 15;
+            len = here.val + (unsigned)(hold & ((1U << extra) - 1));
+            hold >>= extra;
+            bits -= extra;
+
+            here = dcode[hold & dmask];
+dodist:
+            hold >>= here.bits;
+            bits -= here.bits;
+            op = here.op;
+            if (op & FI_BASE)
+            {
+                extra = op & 15;
+                dist = here.val + (unsigned)(hold & ((1U << extra) - 1));
+                hold >>= extra;
+                bits -= extra;
+                if (dist > (unsigned)(out - beg))
+                {
+                    ret = -1;
+                    break;
+                }
+                fi_copy_match(out, dist, len);
+                out += len;
+            }
+            else if (op & FI_LINK)
+            {
+                here = dcode[here.val + (hold & ((1U << (op & 15)) - 1))];
+                goto dodist;
+            }
+            else
+            {
+                ret = -1;
+                break;
+            }
+        }
+        else if (op & FI_LINK)
+        {
+            here = lcode[here.val + (hold & ((1U << (op & 15)) - 1))];
+            goto dolen;
+        }
+        else if (op & FI_EOB)
+        {
+            ret = 1;
+            break;
+        }
+        else
+        {
+            ret = -1;
+            break;
+        }
+    }
+
+    /* drop the read-ahead garbage above the valid bits */
+    s->hold = hold & ((((uint64_t)1) << bits) - 1);
+    s->bits = bits;
+    s->in = in;
+    s->out = out;
+    return ret;
+}
+
+static int fi_codes(fi_state *s)
+{
+    fi_code here;
+    unsigned len, dist, extra;
+    int ret;
+
+    for (;;)
+    {
+        if (s->io->flush && (unsigned)(s->out_end - s->out) < FI_SLACK)
+        {
+            ret = fi_flush(s, 0);
+            if (ret)
+            {
+                return ret;
+            }
+        }
+        if (s->in_end - s->in >= 8 && s->out_end - s->out >= FI_SLACK)
+        {
+            ret = fi_codes_fast(s);
+            if (ret)
+            {
+                return ret > 0 ? 0 : ret;
+            }
+        }
+
+        /* one symbol the careful way */
+        ret = fi_decode(s, s->lcode, s->lbits, &here);
+        if (ret)
+        {
+            return ret;
+        }
+        if (here.op & FI_LINK)
+        {
+            return -1;
+        }
+        if (here.op == FI_LIT)
+        {
+            ret = fi_room(s, 1);
+            if (ret)
+            {
+                return ret;
+            }
+            *s->out++ = (uint8_t)here.val;
+            continue;
+        }
+        if (here.op & FI_EOB)
+        {
+            return 0;
+        }
+        if (!(here.op & FI_BASE))
+        {
+            return -1;
+        }
+
+        extra = here.op & 15;
+        ret = fi_getbits(s, extra, &len);
+        if (ret)
+        {
+            return ret;
+        }
+        len += here.val;
+
+        ret = fi_decode(s, s->dcode, s->dbits, &here);
+        if (ret)
+        {
+            return ret;
+        }
+        if (!(here.op & FI_BASE))
+        {
+            return -1;
+        }
+        extra = here.op & 15;
+        ret = fi_getbits(s, extra, &dist);
+        if (ret)
+        {
+            return ret;
+        }
+        dist += here.val;
+
+        ret = fi_room(s, len);
+        if (ret)
+        {
+            return ret;
+        }
+        if (dist > (unsigned)(s->out - s->out_base))
+        {
+            return -1;
+        }
+        /* byte copy, the word copy may overrun the end of a memory buffer */
+        {
+            uint8_t *out = s->out;
+            const uint8_t *from = out - dist;
+
+            s->out += len;
+            while (len--)
+            {
+                *out++ = *from++;
+            }
+        }
+    }
+}
+
+static int fi_stored(fi_state *s)
+{
+    unsigned len, nlen, n;
+    int ret;
+
+    fi_take(s, s->bits & 7);
+    ret = fi_getbits(s, 16, &len);
+    if (ret == 0)
+    {
+        ret = fi_getbits(s, 16, &nlen);
+    }
+    if (ret)
+    {
+        return ret;
+    }
+    if (len != (~nlen & 0xffff))
+    {
+        return -1;
+    }
+
+    /* whole bytes still sitting in the bit buffer come first */
+    while (len && s->bits >= 8)
+    {
+        ret = fi_room(s, 1);
+        if (ret)
+        {
+            return ret;
+        }
+        *s->out++ = (uint8_t)fi_take(s, 8);
+        len--;
+    }
+
+    while (len)
+    {
+        if (s->in == s->in_end)
+        {
+            ret = fi_next_chunk(s);
+            if (ret)
+            {
+                return ret;
+            }
+        }
+        if (s->out == s->out_end)
+        {
+            ret = fi_room(s, 1);
+            if (ret)
+            {
+                return ret;
+            }
+        }
+        n = len;
+        if (n > (unsigned)(s->in_end - s->in))
+        {
+            n = s->in_end - s->in;
+        }
+        if (n > (unsigned)(s->out_end - s->out))
+        {
+            n = s->out_end - s->out;
+        }
+        memcpy(s->out, s->in, n);
+        s->out += n;
+        s->in += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static void fi_fixed(fi_state *s)
+{
+    unsigned sym;
+
+    if (!s->fixed_built)
+    {
+        for (sym = 0; sym < 144; sym++)
+        {
+            s->lens[sym] = 8;
+        }
+        for (; sym < 256; sym++)
+        {
+            s->lens[sym] = 9;
+        }
+        for (; sym < 280; sym++)
+        {
+            s->lens[sym] = 7;
+        }
+        for (; sym < 288; sym++)
+        {
+            s->lens[sym] = 8;
+        }
+        s->fixed_lbits = 9;
+        fi_build(FI_LENS, s->lens, 288, s->fixed_l, &s->fixed_lbits, 512);
+
+        for (sym = 0; sym < 32; sym++)
+        {
+            s->lens[sym] = 5;
+        }
+        s->fixed_dbits = 5;
+        fi_build(FI_DISTS, s->lens, 32, s->fixed_d, &s->fixed_dbits, 32);
+        s->fixed_built = 1;
+    }
+    s->lcode = s->fixed_l;
+    s->lbits = s->fixed_lbits;
+    s->dcode = s->fixed_d;
+    s->dbits = s->fixed_dbits;
+}
+
+static int fi_dynamic(fi_state *s)
+{
+    unsigned nlen, ndist, ncode, i, rep, v;
+    uint16_t prev;
+    fi_code here;
+    int ret;
+
+    ret = fi_getbits(s, 5, &nlen);
+    if (ret == 0)
+    {
+        ret = fi_getbits(s, 5, &ndist);
+    }
+    if (ret == 0)
+    {
+        ret = fi_getbits(s, 4, &ncode);
+    }
+    if (ret)
+    {
+        return ret;
+    }
+    nlen += 257;
+    ndist += 1;
+    ncode += 4;
+    if (nlen > 286 || ndist > 30)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < 19; i++)
+    {
+        s->lens[fi_order[i]] = 0;
+    }
+    for (i = 0; i < ncode; i++)
+    {
+        ret = fi_getbits(s, 3, &v);
+        if (ret)
+        {
+            return ret;
+        }
+        s->lens[fi_order[i]] = v;
+    }
+    /* the code length code is decoded through the (unused yet) dist table */
+    s->dbits = FI_CROOT;
+    if (fi_build(FI_CODES, s->lens, 19, s->dyn_d, &s->dbits, FI_ENOUGH_D))
+    {
+        return -1;
+    }
+
+    i = 0;
+    while (i < nlen + ndist)
+    {
+        ret = fi_decode(s, s->dyn_d, s->dbits, &here);
+        if (ret)
+        {
+            return ret;
+        }
+        if (here.op != FI_LIT)
+        {
+            return -1;
+        }
+        if (here.val < 16)
+        {
+            s->lens[i++] = here.val;
+            continue;
+        }
+        if (here.val == 16)
+        {
+            if (i == 0)
+            {
+                return -1;
+            }
+            prev = s->lens[i - 1];
+            ret = fi_getbits(s, 2, &rep);
+            rep += 3;
+        }
+        else if (here.val == 17)
+        {
+            prev = 0;
+            ret = fi_getbits(s, 3, &rep);
+            rep += 3;
+        }
+        else
+        {
+            prev = 0;
+            ret = fi_getbits(s, 7, &rep);
+            rep += 11;
+        }
+        if (ret)
+        {
+            return ret;
+        }
+        if (i + rep > nlen + ndist)
+        {
+            return -1;
+        }
+        while (rep--)
+        {
+            s->lens[i++] = prev;
+        }
+    }
+
+    if (s->lens[256] == 0)
+    {
+        return -1;
+    }
+
+    s->lbits = FI_LROOT;
+    if (fi_build(FI_LENS, s->lens, nlen, s->dyn_l, &s->lbits, FI_ENOUGH_L))
+    {
+        return -1;
+    }
+    s->dbits = FI_DROOT;
+    if (fi_build(FI_DISTS, s->lens + nlen, ndist, s->dyn_d, &s->dbits, FI_ENOUGH_D))
+    {
+        return -1;
+    }
+    s->lcode = s->dyn_l;
+    s->dcode = s->dyn_d;
+    return 0;
+}
+
+int fast_inflate_run(const fast_inflate_io_t *io, void *out, size_t out_len,
+                     fast_inflate_result_t *res)
+{
+    fi_state *s;
+    unsigned last, type, n, i;
+    int ret;
+
+    s = malloc(sizeof(*s) + (io->flush ? FI_OUTBUF : 0));
+    if (s == NULL)
+    {
+        return -2;
+    }
+    memset(s, 0, sizeof(*s));
+    s->io = io;
+    if (io->flush)
+    {
+        s->out_base = (uint8_t *)(s + 1);
+        s->out_end = s->out_base + FI_OUTBUF;
+    }
+    else
+    {
+        s->out_base = out;
+        s->out_end = s->out_base + out_len;
+    }
+    s->out = s->out_base;
+    s->out_flushed = s->out_base;
+
+    do
+    {
+        ret = fi_getbits(s, 1, &last);
+        if (ret == 0)
+        {
+            ret = fi_getbits(s, 2, &type);
+        }
+        if (ret)
+        {
+            break;
+        }
+        switch (type)
+        {
+            case 0:
+                ret = fi_stored(s);
+                break;
+            case 1:
+                fi_fixed(s);
+                ret = fi_codes(s);
+                break;
+            case 2:
+                ret = fi_dynamic(s);
+                if (ret == 0)
+                {
+                    ret = fi_codes(s);
+                }
+                break;
+            default:
+                ret = -1;
+                break;
+        }
+    } while (ret == 0 && !last);
+
+    if (ret == 0 && io->flush)
+    {
+        ret = fi_flush(s, 1);
+    }
+
+    if (res)
+    {
+        res->bytes_out = io->flush ? s->total_out : (uint64_t)(s->out - s->out_base);
+
+        /* give back whole bytes read ahead past the end of the stream */
+        fi_take(s, s->bits & 7);
+        n = s->bits >> 3;
+        res->unget_len = 0;
+        if ((unsigned)(s->in - s->in_start) >= n)
+        {
+            res->next_in = s->in - n;
+        }
+        else
+        {
+            res->next_in = s->in;
+            res->unget_len = n;
+            for (i = 0; i < n; i++)
+            {
+                res->unget[i] = (uint8_t)(s->hold >> (8 * i));
+            }
+        }
+    }
+
+    free(s);
+    return ret;
+}
+
+typedef struct fi_mem_src
+{
+    const unsigned char *buf;
+    size_t len;
+} fi_mem_src;
+
+/* the whole source is one chunk, handed out once */
+static int fi_mem_fill(void *ctx, const unsigned char **buf)
+{
+    fi_mem_src *src = ctx;
+    int n = (int)src->len;
+
+    *buf = src->buf;
+    src->len = 0;
+    return n;
+}
+
+int fast_inflate_mem(void *dst, size_t dst_len, const void *src, size_t src_len,
+                     size_t *out_len, size_t *in_used)
+{
+    fast_inflate_io_t io;
+    fast_inflate_result_t res;
+    fi_mem_src msrc;
+    int ret;
+
+    if (src_len > 0x7fffffff)
+    {
+        return -2;
+    }
+    msrc.buf = src;
+    msrc.len = src_len;
+    io.ctx = &msrc;
+    io.fill = fi_mem_fill;
+    io.flush = NULL;
+
+    memset(&res, 0, sizeof(res));
+    res.next_in = src;
+    ret = fast_inflate_run(&io, dst, dst_len, &res);
+    if (out_len)
+    {
+        *out_len = (size_t)res.bytes_out;
+    }
+    if (in_used)
+    {
+        /* a single chunk never needs unget */
+        *in_used = res.next_in - (const unsigned char *)src;
+    }
+    return ret;
+}
+
+int fast_gunzip_mem(void *dst, size_t dst_len, const void *src, size_t src_len,
+                    size_t *out_len)
+{
+    const unsigned char *p = src;
+    const unsigned char *end = p + src_len;
+    size_t used, n;
+    uint32_t crc, isize;
+    unsigned flags;
+    int ret;
+
+    if (src_len < 18 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8)
+    {
+        return -1;
+    }
+    flags = p[3];
+    p += 10;
+    if (flags & 0x04)
+    {
+        /* extra field */
+        n = p[0] | (p[1] << 8);
+        if ((size_t)(end - p) < n + 2)
+        {
+            return -1;
+        }
+        p += n + 2;
+    }
+    if (flags & 0x08)
+    {
+        /* original name */
+        while (p < end && *p++ != 0);
+    }
+    if (flags & 0x10)
+    {
+        /* comment */
+        while (p < end && *p++ != 0);
+    }
+    if (flags & 0x02)
+    {
+        /* header crc */
+        p += 2;
+    }
+    if (p >= end)
+    {
+        return -1;
+    }
+
+    ret = fast_inflate_mem(dst, dst_len, p, end - p, &n, &used);
+    if (ret)
+    {
+        return ret;
+    }
+    p += used;
+    if (end - p < 8)
+    {
+        return -1;
+    }
+    crc = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    isize = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t)p[7] << 24);
+    if (~crc32_le(~0u, dst, n) != crc || (uint32_t)n != isize)
+    {
+        return -1;
+    }
+    if (out_len)
+    {
+        *out_len = n;
+    }
+    return 0;
+}
@@ -20,6 +20,7 @@
 #include "glibbb.h"
 #include <stdint.h>
 #include <stdlib.h>
+#include <libs/checksum.h>
 //uint32_t *global_crc32_table;
 
 uint32_t *global_crc32_table;
@@ -55,26 +56,19 @@ uint32_t *crc32_filltable(uint32_t *crc_table, int endian)
     return crc_table - 256;
 }
 
+/*
+ * The block routines are kept for busybox compatibility; the table argument
+ * is ignored and the work is done by the kernel checksum library, which
+ * uses slicing-by-8 tables (or the ARMv8 crc instructions) instead.
+ */
 uint32_t crc32_block_endian1(uint32_t val, const void *buf, unsigned len, uint32_t *crc_table)
 {
-    const void *end = (uint8_t *)buf + len;
-
-    while (buf != end)
-    {
-        val = (val << 8) ^ crc_table[(val >> 24) ^ * (uint8_t *)buf];
-        buf = (uint8_t *)buf + 1;
-    }
-    return val;
+    (void)crc_table;
+    return crc32_be(val, buf, len);
 }
 
 uint32_t crc32_block_endian0(uint32_t val, const void *buf, unsigned len, uint32_t *crc_table)
 {
-    const void *end = (uint8_t *)buf + len;
-
-    while (buf != end)
-    {
-        val = crc_table[(uint8_t)val ^ * (uint8_t *)buf] ^ (val >> 8);
-        buf = (uint8_t *)buf + 1;
-    }
-    return val;
+    (void)crc_table;
+    return crc32_le(val, buf, len);
 }
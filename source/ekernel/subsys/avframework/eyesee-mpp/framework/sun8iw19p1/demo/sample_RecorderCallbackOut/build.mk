@@ -37,6 +37,7 @@ TARGET_INC := \
     $(TARGET_TOP)/middleware/media/LIBRARY/libcedarc/include \
     $(TARGET_TOP)/middleware/media/LIBRARY/libcedarx/libcore/common/iniparser \
     $(TARGET_TOP)/middleware/sample/configfileparser \
+    $(TARGET_TOP)/middleware/net/rtsp \
     $(TARGET_TOP)/framework/include/media/camera \
     $(TARGET_TOP)/framework/include/utils \
     $(TARGET_TOP)/framework/include \
@@ -71,6 +72,9 @@ endif
 ifeq ($(MPPCFG_VLPR),Y)
 TARGET_SHARED_LIB += libai_VLPR
 endif
+ifeq ($(MPPCFG_RTSP_SERVER),Y)
+TARGET_SHARED_LIB += librtsp_server
+endif
 
 TARGET_STATIC_LIB := \
     libcamera \
@@ -36,7 +36,8 @@ TARGET_INC := \
     $(TARGET_TOP)/middleware/media/LIBRARY/include_muxer \
     $(TARGET_TOP)/middleware/media/LIBRARY/libcedarc/include \
     $(TARGET_TOP)/middleware/media/LIBRARY/libcedarx/libcore/common/iniparser \
-    $(TARGET_TOP)/middleware/sample/configfileparser
+    $(TARGET_TOP)/middleware/sample/configfileparser \
+    $(TARGET_TOP)/middleware/net/rtsp
 
 TARGET_STATIC_LIB := \
     libcamera \
@@ -123,6 +124,9 @@ endif
 ifeq ($(MPPCFG_VLPR),Y)
 TARGET_SHARED_LIB += libai_VLPR
 endif
+ifeq ($(MPPCFG_RTSP_SERVER),Y)
+TARGET_STATIC_LIB += librtsp_server
+endif
 
 TARGET_CPPFLAGS += $(CEDARX_EXT_CFLAGS)
 TARGET_CFLAGS += $(CEDARX_EXT_CFLAGS)
@@ -116,6 +116,22 @@ void EyeseeRecorderListener::onData(EyeseeRecorder *pMr, int what, int extra)
                 }
                 mpOwner->mLastCallbackPts = frame->pts;
             }
+#ifdef MPPCFG_RTSP_SERVER
+            if(mpOwner->mpRtspStream)
+            {
+                RTSP_FRAME_S stFrame;
+                RTSP_STREAM_STAT_S stStat;
+                memset(&stFrame, 0, sizeof(stFrame));
+                stFrame.mBuf.mpData[0] = (const uint8_t*)frame->data;
+                stFrame.mBuf.mLen[0] = frame->data_size;
+                stFrame.mPts = frame->pts;
+                stFrame.mbKeyFrame = 0 == frame->nFrameIndex;
+                RtspStreamSendFrame(mpOwner->mpRtspStream, &stFrame);
+                //the send backlog of the slowest client lowers the bitrate before packets are lost
+                RtspStreamGetStat(mpOwner->mpRtspStream, &stStat, NULL, NULL);
+                pMr->setNetworkSinkState(stStat.mBacklogBytes, stStat.mBacklogCapacity);
+            }
+#endif
             //alogd("pts[%lld]us?", frame->pts);
             if(mpOwner->mRawFile)
             {
@@ -125,6 +141,12 @@ void EyeseeRecorderListener::onData(EyeseeRecorder *pMr, int what, int extra)
         else if(frame->stream_type == RawPacketTypeVideoExtra)
         {
             alogd("stream type is video extra(spspps), size[%d]", frame->data_size);
+#ifdef MPPCFG_RTSP_SERVER
+            if(mpOwner->mpRtspStream)
+            {
+                RtspStreamSetParameterSets(mpOwner->mpRtspStream, (const uint8_t*)frame->data, frame->data_size);
+            }
+#endif
             if(mpOwner->mRawFile)
             {
                 fwrite(frame->data, 1, frame->data_size, mpOwner->mRawFile);
@@ -152,6 +174,10 @@ SampleRecorderCallbackOutContext::SampleRecorderCallbackOutContext()
     mpRecorder = NULL;
     mRawFile = NULL;
     mLastCallbackPts = -1;
+#ifdef MPPCFG_RTSP_SERVER
+    mpRtspServer = NULL;
+    mpRtspStream = NULL;
+#endif
 }
 
 SampleRecorderCallbackOutContext::~SampleRecorderCallbackOutContext()
@@ -235,6 +261,7 @@ status_t SampleRecorderCallbackOutContext::loadConfig()
         mConfigPara.mEncodeBitrate = 6*1024*1024;
         mConfigPara.mFilePath = "CallbackOut.raw";
         mConfigPara.mFilePath2 = "";
+        mConfigPara.mRtspPort = 0;
         return SUCCESS;
     }
     CONFPARSER_S stConfParser;
@@ -334,6 +361,7 @@ status_t SampleRecorderCallbackOutContext::loadConfig()
     mConfigPara.mEncodeBitrate = GetConfParaInt(&stConfParser, SAMPLE_RECORDERCALLBACKOUT_KEY_ENCODE_BITRATE, 0)*1024*1024;
     mConfigPara.mFilePath = GetConfParaString(&stConfParser, SAMPLE_RECORDERCALLBACKOUT_KEY_FILE_PATH, NULL);
     mConfigPara.mFilePath2 = GetConfParaString(&stConfParser, SAMPLE_RECORDERCALLBACKOUT_KEY_FILE_PATH2, NULL);
+    mConfigPara.mRtspPort = GetConfParaInt(&stConfParser, SAMPLE_RECORDERCALLBACKOUT_KEY_RTSP_PORT, 0);
     alogd("path[%s], path2[%s]", mConfigPara.mFilePath.c_str(), mConfigPara.mFilePath2.c_str());
     destroyConfParser(&stConfParser);
     return SUCCESS;
@@ -560,6 +588,37 @@ int main(int argc, char *argv[])
             }
         }
         stContext.mpRecorder->setVEncBitRateControlAttr(stRcAttr);
+#ifdef MPPCFG_RTSP_SERVER
+        if(stContext.mConfigPara.mRtspPort > 0
+            && (PT_H264 == stContext.mConfigPara.mEncodeType || PT_H265 == stContext.mConfigPara.mEncodeType))
+        {
+            RTSP_SERVER_ATTR_S stServerAttr;
+            RTSP_STREAM_ATTR_S stStreamAttr;
+            memset(&stServerAttr, 0, sizeof(stServerAttr));
+            stServerAttr.mPort = stContext.mConfigPara.mRtspPort;
+            stContext.mpRtspServer = RtspServerCreate(&stServerAttr);
+            if(stContext.mpRtspServer)
+            {
+                memset(&stStreamAttr, 0, sizeof(stStreamAttr));
+                strcpy(stStreamAttr.mName, "ch0");
+                stStreamAttr.meCodec = PT_H264 == stContext.mConfigPara.mEncodeType ? RTP_CODEC_H264 : RTP_CODEC_H265;
+                stStreamAttr.mPaceBitRate = stContext.mConfigPara.mEncodeBitrate * 2;
+                stContext.mpRtspStream = RtspServerCreateStream(stContext.mpRtspServer, &stStreamAttr);
+            }
+            if(stContext.mpRtspStream)
+            {
+                char url[64];
+                RtspStreamGetUrl(stContext.mpRtspStream, url, sizeof(url));
+                alogd("rtsp url: %s", url);
+                //DBRC takes the rtsp backlog from setNetworkSinkState()
+                stContext.mpRecorder->enableDBRC(true);
+            }
+            else
+            {
+                aloge("fatal error! create rtsp server fail");
+            }
+        }
+#endif
         alogd("prepare()!");
         stContext.mpRecorder->prepare();
         alogd("start()!");
@@ -584,6 +643,14 @@ int main(int argc, char *argv[])
         delete stContext.mpRecorder;
         stContext.mpRecorder = NULL;
     }
+#ifdef MPPCFG_RTSP_SERVER
+    if(stContext.mpRtspServer)
+    {
+        RtspServerDestroy(stContext.mpRtspServer);
+        stContext.mpRtspServer = NULL;
+        stContext.mpRtspStream = NULL;
+    }
+#endif
 
     //close camera
     alogd("HerbCamera::release()");
@@ -11,6 +11,9 @@
 #include <string>
 
 #include <Errors.h>
+#ifdef MPPCFG_RTSP_SERVER
+#include <rtsp_server.h>
+#endif
 
 typedef struct SampleRecorderCallbackOutCmdLineParam
 {
@@ -40,6 +43,7 @@ typedef struct SampleRecorderCallbackOutConfig
     int mEncodeBitrate;
     std::string mFilePath;
     std::string mFilePath2;
+    int mRtspPort;  //0: no rtsp
 }SampleRecorderCallbackOutConfig;
 
 class SampleRecorderCallbackOutContext;
@@ -81,6 +85,10 @@ public:
 
     FILE *mRawFile;
     int64_t mLastCallbackPts;
+#ifdef MPPCFG_RTSP_SERVER
+    RTSP_SERVER_S *mpRtspServer;
+    RTSP_STREAM_S *mpRtspStream;
+#endif
 };
 
 #endif  /* _SAMPLE_RECORDERCALLBACKOUT_H_ */
@@ -25,6 +25,7 @@
 #define SAMPLE_RECORDERCALLBACKOUT_KEY_ENCODE_BITRATE   "encode_bitrate"
 #define SAMPLE_RECORDERCALLBACKOUT_KEY_FILE_PATH        "file_path"
 #define SAMPLE_RECORDERCALLBACKOUT_KEY_FILE_PATH2       "file_path2"
+#define SAMPLE_RECORDERCALLBACKOUT_KEY_RTSP_PORT        "rtsp_port"
 
 #endif  /* _SAMPLE_RECORDERCALLBACKOUT_CONFIG_H_ */
 
@@ -587,6 +587,24 @@ public:
          * @param camera the Camera service object
          */
         virtual void onPictureTaken(int chnId, const void *data, int size, EyeseeCamera* pCamera) = 0;
+        /**
+         * Called before onPictureTaken(), with the picture as packs which are not copied,
+         * e.g. jpeg in the encoder's buffer. Override it to read them by getPack(), or to keep
+         * the picture after return; the default gathers them and calls onPictureTaken().
+         * A kept picture holds the encoder's buffer, release it soon: the camera waits for it
+         * only a short time when the encoder is reset or destroyed, then leaves the encoder to be
+         * destroyed by the last kept picture, and takes later pictures with a new one.
+         *
+         * @param spPicture the same data as in onPictureTaken().
+         */
+        virtual void onPictureData(int chnId, const std::shared_ptr<const CMediaMemory>& spPicture, EyeseeCamera* pCamera)
+        {
+            const void *pData = spPicture->getPointer();
+            if(pData != NULL)
+            {
+                onPictureTaken(chnId, pData, spPicture->getSize(), pCamera);
+            }
+        }
     };
 
     /**
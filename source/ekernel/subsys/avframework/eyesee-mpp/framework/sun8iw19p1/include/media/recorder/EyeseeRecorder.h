@@ -1339,6 +1339,12 @@ public:
     status_t enableDynamicBitRateControl(bool bEnable);
     status_t enableAttachAACHeader(bool enable); /* attach header for every frame, effect only when audio codec is AAC */
     status_t GetBufferState(BufferState &state);
+    /**
+     * report the backlog of a network stream fed by this recorder, e.g. the send
+     * buffer of a rtsp session, so that DBRC also lowers the bitrate for it.
+     * Call it periodically while recording, capacityBytes 0 when the stream stops.
+     */
+    status_t setNetworkSinkState(unsigned int backlogBytes, unsigned int capacityBytes);
     void notify(MPP_CHN_S *pChn, MPP_EVENT_TYPE event, void *pEventData); //process internal component callback.
 private:
     void                    doCleanUp();
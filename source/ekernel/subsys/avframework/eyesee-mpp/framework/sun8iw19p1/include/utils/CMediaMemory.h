@@ -13,13 +13,35 @@
 #ifndef _CMEDIAMEMORY_H_
 #define _CMEDIAMEMORY_H_
 
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <utils/Mutex.h>
+
 namespace EyeseeLinux {
 
+/**
+ * A memory block, or a view on memory owned by somebody else.
+ *
+ * A view is made of packs, e.g. the wrapped parts of an encoder's vbv
+ * buffer, which are not copied. Its release callback gives the memory back
+ * to the owner when the last shared_ptr to the view is gone. getPointer()
+ * gathers the packs into one block at its first call, so only a user who
+ * needs contiguous data pays for the copy; getPack() reads them in place.
+ */
 class CMediaMemory
 {
 public:
+    typedef std::function<void()> ReleaseCallback;
+    enum { MAX_PACK_NUM = 4 };
+
     CMediaMemory();
     CMediaMemory(int size);
+    /**
+     * borrow pBorrowed, onRelease is called instead of free() at destruction.
+     */
+    CMediaMemory(void *pBorrowed, int size, const ReleaseCallback& onRelease);
     //copy constructor
     CMediaMemory(const CMediaMemory& ref);
     //copy assignment
@@ -30,12 +52,60 @@ public:
     CMediaMemory& operator=(CMediaMemory&& rRef);
     ~CMediaMemory();    
 
+    /**
+     * append a pack to a view, the memory must stay valid until onRelease.
+     * addPackCopy() copies a small one, e.g. a header or trailer.
+     */
+    int addPack(const void *pData, int size);
+    int addPackCopy(const void *pData, int size);
+    void setReleaseCallback(const ReleaseCallback& onRelease);
+    int getPackCount() const;
+    const void* getPack(int index, int *pSize) const;
+    int copyTo(void *pDst, int size) const;
+
     void* getPointer() const;
     int getSize() const;
 
 private:
+    void release();
+    void moveFrom(CMediaMemory& rRef);
+
     void    *pMem;
     int     mSize;
+    ReleaseCallback mOnRelease;     //null: pMem is malloced by this object
+    mutable void *mpGather;         //the packs of a view in one block, made by getPointer()
+    const void *mpPacks[MAX_PACK_NUM];
+    int     mPackSizes[MAX_PACK_NUM];
+    int     mPackNum;
+    std::vector<void*> mPackCopies;
+};
+
+/**
+ * Recycles blocks of about the same size, e.g. the raw pictures of a burst.
+ * A block goes back to the pool when the last shared_ptr to it is gone;
+ * the pool keeps at most maxIdleNum of them. Create it with make_shared,
+ * blocks may outlive it.
+ */
+class CMediaMemoryPool : public std::enable_shared_from_this<CMediaMemoryPool>
+{
+public:
+    CMediaMemoryPool(int maxIdleNum);
+    ~CMediaMemoryPool();
+
+    std::shared_ptr<CMediaMemory> obtain(int size);
+    void trim();
+
+private:
+    struct IdleBlock
+    {
+        void *mpMem;
+        int mCapacity;
+    };
+    void recycle(void *pMem, int capacity);
+
+    const int mMaxIdleNum;
+    std::vector<IdleBlock> mIdleBlocks;
+    Mutex mLock;
 };
 
 }; /* namespace EyeseeLinux */
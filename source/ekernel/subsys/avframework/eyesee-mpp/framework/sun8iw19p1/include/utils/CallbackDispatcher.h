@@ -107,6 +107,8 @@ private:
     bool mbDone;
     Condition mQueueChanged;
     std::list<CallbackMessage> mQueue;
+    std::list<CallbackMessage> mIdleQueue;  //nodes of dispatched messages, reused by post(), at most IdleNum_MAX.
+    static const size_t IdleNum_MAX = 8;    //a burst of messages is not kept after it is dispatched.
     CallbackDispatcherThread *mpDispatcherThread;
 
     void dispatch(const CallbackMessage &msg);
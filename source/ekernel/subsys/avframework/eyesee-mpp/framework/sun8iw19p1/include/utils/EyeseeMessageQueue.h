@@ -15,7 +15,7 @@
 #ifndef _EYESEEMESSAGEQUEUE_H_
 #define _EYESEEMESSAGEQUEUE_H_
 
-#include <list>
+#include <stdint.h>
 #include <utils/Errors.h>
 //#include <utils/RefBase.h>
 #include <utils/Mutex.h>
@@ -24,6 +24,13 @@
 
 namespace EyeseeLinux {
 
+/**
+ * A message is move-only: queueing and dequeueing move it in and out of the
+ * slots of the queue. Payloads up to EYESEE_MESSAGE_INLINE_DATA_SIZE bytes
+ * are kept inside the message, only bigger ones are malloced.
+ */
+#define EYESEE_MESSAGE_INLINE_DATA_SIZE     (64)
+
 class EyeseeMessage
 {
 public:
@@ -32,39 +39,61 @@ public:
 	int 				mPara0;
 	int 				mPara1;
 private:
-    void*               mpData;
+    void*               mpData;     //point to mInlineData or a malloced buffer.
     int                 mDataSize;
+    union
+    {
+        char            mInlineData[EYESEE_MESSAGE_INLINE_DATA_SIZE];
+        int64_t         mInlineAlign;
+    };
 public:
     status_t    setData(char* pData, int nDataSize);
     void*       getData(int* pDataSize = NULL);
     status_t    reset();
-    EyeseeMessage(const EyeseeMessage& rhs);
-    EyeseeMessage& operator= (const EyeseeMessage& rhs);
+    EyeseeMessage(const EyeseeMessage& rhs) = delete;
+    EyeseeMessage& operator= (const EyeseeMessage& rhs) = delete;
     //move constructor, move assignment, param rRef can't be const, because we will change rRef's member.
+    //rRef is left empty.
     EyeseeMessage(EyeseeMessage&& rRef);
     EyeseeMessage& operator=(EyeseeMessage&& rRef);
     EyeseeMessage();
     ~EyeseeMessage();
+private:
+    friend class EyeseeMessageQueue;
+    status_t    copyFrom(const EyeseeMessage& rhs);
+    void        moveFrom(EyeseeMessage& rRef);
+    bool        isInlineData() const { return mpData == (const void*)mInlineData; }
 };
 
+/**
+ * FIFO of messages kept in a ring of preallocated slots, so queueing and
+ * dequeueing allocate nothing unless a payload is too big to be inline.
+ * The ring doubles when it is full, messages are never dropped.
+ */
+#define EYESEE_MESSAGE_QUEUE_DEFAULT_CAPACITY   (8)
+
 class EyeseeMessageQueue
 {
 public:
-    EyeseeMessageQueue();
-    ~EyeseeMessageQueue(){}
-    status_t queueMessage(EyeseeMessage *pMsgIn);
+    EyeseeMessageQueue(int nCapacity = EYESEE_MESSAGE_QUEUE_DEFAULT_CAPACITY);
+    ~EyeseeMessageQueue();
+    status_t queueMessage(EyeseeMessage *pMsgIn);  //copy *pMsgIn.
     status_t queueMessage(EyeseeMessage&& rRefMsgIn);
     status_t dequeueMessage(EyeseeMessage *pMsgOut);   //return value is NOT_ENOUGH_DATA, UNKNOWN_ERROR, NO_ERROR
+    int dequeueMessages(EyeseeMessage *pMsgOut, int nMaxNum); //return value is the number of dequeued messages.
     status_t flushMessage();
     int waitMessage(unsigned int timeout = 0);  //return value is the message number.
     int getMessageCount();
 private:
+    EyeseeMessage* getTailSlot_l();
+    status_t grow_l();
     Mutex       mLock;
     Condition   mCondMessageQueueChanged;
     bool        mWaitMessageFlag;
-    int         mCount; //message count.
-    std::list<EyeseeMessage>  mValidMessageList;
-    std::list<EyeseeMessage>  mIdleMessageList;
+    EyeseeMessage *mpSlots;
+    int         mCapacity;  //slot number.
+    int         mHead;      //index of the first valid message.
+    int         mCount;     //valid message count.
 };
 
 };
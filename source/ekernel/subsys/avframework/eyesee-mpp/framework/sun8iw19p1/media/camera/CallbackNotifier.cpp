@@ -33,49 +33,12 @@
 //#include <ion_memmanager.h>
 
 #define PictureThumbQuality_DEFAULT 60
+#define PicturePoolIdleNum_DEFAULT 2
 
 using namespace std;
 
 namespace EyeseeLinux {
 
-static int getMeminfo(const char* pattern)
-{
-  FILE* fp = fopen("/proc/meminfo", "r");
-  if (fp == NULL) {
-    return -1;
-  }
-
-  int result = -1;
-  char buf[256];
-  while (fgets(buf, sizeof(buf), fp) != NULL) {
-    if (sscanf(buf, pattern, &result) == 1) {
-      break;
-    }
-  }
-  fclose(fp);
-  return result;
-}
-
-static int getTotalMemory(void)
-{
-  return getMeminfo("MemTotal: %d kB");
-}
-
-static int getFreeMemory(void)
-{
-  return getMeminfo("MemFree: %d kB");
-}
-
-static int getCachedMemory(void)
-{
-  return getMeminfo("Cached: %d kB");
-}
-
-static int getBuffersMemory(void)
-{
-  return getMeminfo("Buffers: %d kB");
-}
-
 CallbackNotifier::DoSavePictureThread::DoSavePictureThread(CallbackNotifier *pCallbackNotifier)
     : mpCallbackNotifier(pCallbackNotifier)
 {
@@ -167,6 +130,7 @@ CallbackNotifier::CallbackNotifier(int chnId, CameraBufferReference *pCbr)
     mPictureNum = 1;
     mpJpegenc = NULL;
     mbWaitPicBufListEmpty = false;
+    mspPicturePool = std::make_shared<CMediaMemoryPool>(PicturePoolIdleNum_DEFAULT);
     mpSavePicThread = new DoSavePictureThread(this);
     mpSavePicThread->startThread();
 }
@@ -211,15 +175,16 @@ CallbackNotifier::~CallbackNotifier()
 //            delete[] it->mpData;
 //        }
     }
+    //views app doesn't keep return their frames here, before the jpeg encoder is released.
+    mPicBufList.clear();
+    mWaitReleasePicBufList.clear();
     mPicBufLock.unlock();
 
     if(mpJpegenc)
     {
         alogw("jpeg encoder is exist, maybe user sets keeping picture encoder? destroy now!");
         destoryPictureRegion();
-        mpJpegenc->destroy();
-        delete mpJpegenc;
-        mpJpegenc = NULL;
+        releaseJpegEncoder();
     }
 }
 
@@ -488,10 +453,15 @@ bool CallbackNotifier::takePicture(const void *frame,
         buf.mbSharedMemPrepared = true;
         buf.mMsgType      = msgType;
         buf.mIsContinuous = true;
-        buf.mPicBuf       = std::make_shared<CMediaMemory>(bufsize);
+        buf.mPicBuf       = mspPicturePool->obtain(bufsize);
         buf.mDataSize     = bufsize;
 
         char *p = (char*)buf.mPicBuf->getPointer();
+        if(NULL == p)
+        {
+            aloge("fatal error! no memory for raw picture!");
+            return false;
+        }
         for (int i=0; i<3; i++)
         {
             if(pbuf->mFrameBuf.VFrame.mpVirAddr[i] != NULL)
@@ -569,8 +539,14 @@ bool CallbackNotifier::takePicture(const void *frame,
         buf.mbSharedMemPrepared = true;
         buf.mMsgType = msgType;
         buf.mIsContinuous = isContinuous;
-        buf.mPicBuf = std::make_shared<CMediaMemory>(bufsize);
+        buf.mPicBuf = mspPicturePool->obtain(bufsize);
         buf.mDataSize = bufsize;
+        if(NULL == buf.mPicBuf->getPointer())
+        {
+            aloge("fatal error! no memory for compressed picture!");
+            releaseJpegEncoder();
+            return false;
+        }
         memcpy(buf.mPicBuf->getPointer(), pbuf->mFrameBuf.VFrame.mpVirAddr[0], jpegsize);
         char *p = (char*)buf.mPicBuf->getPointer() + jpegsize;
         memcpy(p, &thumboffset, sizeof(off_t));
@@ -583,7 +559,8 @@ bool CallbackNotifier::takePicture(const void *frame,
         mPicBufList.push_back(buf);
         mpSavePicThread->notifyNewPictureCome();
         mPicBufLock.unlock();
-        goto JPEG_INIT_ERR;
+        releaseJpegEncoder();
+        return bRet;
     }
     if(mpJpegenc)
     {
@@ -593,9 +570,7 @@ bool CallbackNotifier::takePicture(const void *frame,
             alogd("srcSize-dstSize change [%dx%d,%dx%d]->[%dx%d,%dx%d], need reset encoder", 
                 mJpegEncConfig.mSourceWidth, mJpegEncConfig.mSourceHeight, mJpegEncConfig.mPicWidth, mJpegEncConfig.mPicHeight,
                 src_width, src_height, picWidth, picHeight);
-            mpJpegenc->destroy();
-            delete mpJpegenc;
-            mpJpegenc = NULL;
+            releaseJpegEncoder();
         }
     }
     if(NULL == mpJpegenc)
@@ -705,6 +680,8 @@ bool CallbackNotifier::takePicture(const void *frame,
     buf.mThumbOffset = thumboffset;
     buf.mThumbLen = thumblen;
     buf.mDataSize = buf.mLen0+buf.mLen1+buf.mLen2;
+    //no copy: app reads the venclibBuffer, which is returned when app releases the view.
+    buf.mPicBuf = makePictureView(buf);
     
     mPicBufLock.lock();
     mPicBufList.push_back(buf);
@@ -721,7 +698,7 @@ bool CallbackNotifier::takePicture(const void *frame,
 
 JPEG_GET_FRAME_ERR:
 JPEG_ENCODE_ERR:
-    mpJpegenc->destroy();
+    releaseJpegEncoder();
 JPEG_INIT_ERR:
     if(mpJpegenc)
     {
@@ -749,9 +726,7 @@ void CallbackNotifier::takePictureEnd()
     mPicBufLock.unlock();
     if(mpJpegenc)
     {
-        mpJpegenc->destroy();
-        delete mpJpegenc;
-        mpJpegenc = NULL;
+        releaseJpegEncoder();
     }
     alogv("take picture end.");
 }
@@ -977,6 +952,130 @@ status_t CallbackNotifier::notifyPictureRelease()
     return NO_ERROR;
 }
 
+/**
+ * jpeg + thumbOffset + thumbLen + jpegSize, as app sees it in onPictureTaken().
+ * The jpeg packs stay in the venclibBuffer, only the trailer is copied.
+ */
+std::shared_ptr<CMediaMemory> CallbackNotifier::makePictureView(const PictureBuffer& buf)
+{
+    std::shared_ptr<CMediaMemory> spView = std::make_shared<CMediaMemory>();
+    char trailer[sizeof(off_t) + sizeof(size_t) + sizeof(size_t)];
+    off_t thumboffset = buf.mThumbOffset;
+    size_t thumblen = buf.mThumbLen;
+    size_t jpegsize = buf.mDataSize;
+    char *p = trailer;
+    memcpy(p, &thumboffset, sizeof(off_t));
+    p += sizeof(off_t);
+    memcpy(p, &thumblen, sizeof(size_t));
+    p += sizeof(size_t);
+    memcpy(p, &jpegsize, sizeof(size_t));
+
+    spView->addPack(buf.mpData0, buf.mLen0);
+    spView->addPack(buf.mpData1, buf.mLen1);
+    spView->addPack(buf.mpData2, buf.mLen2);
+    spView->addPackCopy(trailer, sizeof(trailer));
+
+    if(mspPictureViewOwner == nullptr || mspPictureViewOwner->mpJpegenc != mpJpegenc)
+    {
+        mspPictureViewOwner = std::make_shared<PictureViewOwner>();
+        mspPictureViewOwner->mpJpegenc = mpJpegenc;
+        mspPictureViewOwner->mViewNum = 0;
+        mspPictureViewOwner->mbDetached = false;
+    }
+    std::shared_ptr<PictureViewOwner> spOwner = mspPictureViewOwner;
+    unsigned char *pData0 = buf.mpData0, *pData1 = buf.mpData1, *pData2 = buf.mpData2;
+    unsigned int nLen0 = buf.mLen0, nLen1 = buf.mLen1, nLen2 = buf.mLen2;
+    spOwner->mLock.lock();
+    spOwner->mViewNum++;
+    spOwner->mLock.unlock();
+    spView->setReleaseCallback([spOwner, pData0, nLen0, pData1, nLen1, pData2, nLen2]()
+        {
+            returnPictureView(spOwner, pData0, nLen0, pData1, nLen1, pData2, nLen2);
+        });
+    return spView;
+}
+
+/**
+ * called by the last user of a view, maybe in app's thread, maybe after notifier is gone.
+ */
+void CallbackNotifier::returnPictureView(const std::shared_ptr<PictureViewOwner>& spOwner,
+    unsigned char *pData0, unsigned int nLen0, unsigned char *pData1, unsigned int nLen1,
+    unsigned char *pData2, unsigned int nLen2)
+{
+    VENC_STREAM_S tmpVencStream;
+    VENC_PACK_S tmpVencPack;
+    memset(&tmpVencStream, 0, sizeof(VENC_STREAM_S));
+    memset(&tmpVencPack, 0, sizeof(VENC_PACK_S));
+    tmpVencStream.mpPack = &tmpVencPack;
+    tmpVencStream.mPackCount = 1;
+    tmpVencStream.mpPack[0].mpAddr0 = pData0;
+    tmpVencStream.mpPack[0].mpAddr1 = pData1;
+    tmpVencStream.mpPack[0].mpAddr2 = pData2;
+    tmpVencStream.mpPack[0].mLen0 = nLen0;
+    tmpVencStream.mpPack[0].mLen1 = nLen1;
+    tmpVencStream.mpPack[0].mLen2 = nLen2;
+
+    AutoMutex lock(spOwner->mLock);
+    spOwner->mpJpegenc->returnFrame(&tmpVencStream);
+    spOwner->mViewNum--;
+    if(spOwner->mViewNum > 0)
+    {
+        return;
+    }
+    if(spOwner->mbDetached)
+    {
+        alogd("app returns the last picture of detached jpeg encoder, destroy it now.");
+        spOwner->mpJpegenc->destroy();
+        delete spOwner->mpJpegenc;
+        spOwner->mpJpegenc = NULL;
+    }
+    else
+    {
+        spOwner->mCondReturned.broadcast();
+    }
+}
+
+/**
+ * destroy the jpeg encoder, which must live until app releases all views on its venclibBuffer.
+ * App is given a bounded time to release them; if it still holds some, the encoder is detached and
+ * destroyed by the last view, so the caller never blocks on app.
+ */
+void CallbackNotifier::releaseJpegEncoder()
+{
+    int64_t nWaitInterval = 200;   //unit:ms
+    int nWaitTimes = 5;
+    status_t ret;
+    CameraJpegEncoder *pJpegenc = mpJpegenc;
+    mpJpegenc = NULL;
+    if(NULL == pJpegenc)
+    {
+        return;
+    }
+    std::shared_ptr<PictureViewOwner> spOwner = mspPictureViewOwner;
+    mspPictureViewOwner = nullptr;
+    if(spOwner != nullptr && spOwner->mpJpegenc == pJpegenc)
+    {
+        AutoMutex lock(spOwner->mLock);
+        while(spOwner->mViewNum > 0 && nWaitTimes-- > 0)
+        {
+            ret = spOwner->mCondReturned.waitRelative(spOwner->mLock, nWaitInterval*1000*1000);
+            if(ret != NO_ERROR)
+            {
+                alogw("wait ret[0x%x], app still holds [%d] pictures of jpeg encoder!", ret, spOwner->mViewNum);
+            }
+        }
+        if(spOwner->mViewNum > 0)
+        {
+            alogw("Be careful! app holds [%d] pictures too long, detach jpeg encoder, the last picture destroys it.", spOwner->mViewNum);
+            spOwner->mbDetached = true;
+            return;
+        }
+        spOwner->mpJpegenc = NULL;
+    }
+    pJpegenc->destroy();
+    delete pJpegenc;
+}
+
 bool CallbackNotifier::savePictureThread()
 {
     bool bRunningFlag = true;
@@ -998,25 +1097,8 @@ bool CallbackNotifier::savePictureThread()
             bRunningFlag = false; 
             alogw("save_pic_thrd_force_rls_when_exit:%d",mPicBufList.size());
             mPicBufLock.lock();
-            while(!mPicBufList.empty())
-            { 
-                VENC_STREAM_S tmpVencStream;
-                VENC_PACK_S tmpVencPack;
-                memset(&tmpVencStream, 0, sizeof(VENC_STREAM_S));
-                memset(&tmpVencPack, 0, sizeof(VENC_PACK_S));
-                
-                PictureBuffer pbuf = mPicBufList.front();
-                mPicBufList.pop_front();
-                tmpVencStream.mpPack = &tmpVencPack;
-                tmpVencStream.mPackCount = 1;
-                tmpVencStream.mpPack[0].mpAddr0 = pbuf.mpData0;
-                tmpVencStream.mpPack[0].mpAddr1 = pbuf.mpData1;
-                tmpVencStream.mpPack[0].mpAddr2 = pbuf.mpData2;
-                tmpVencStream.mpPack[0].mLen0 = pbuf.mLen0;
-                tmpVencStream.mpPack[0].mLen1 = pbuf.mLen1;
-                tmpVencStream.mpPack[0].mLen2 = pbuf.mLen2;
-                mpJpegenc->returnFrame(&tmpVencStream);
-            }
+            //dropping an unsent view returns its frame to the jpeg encoder.
+            mPicBufList.clear();
             mPicBufLock.unlock();
             goto _exit0;
         }
@@ -1061,56 +1143,7 @@ bool CallbackNotifier::savePictureThread()
         size_t bufsize = pbuf->mDataSize;
         if(false == pbuf->mbSharedMemPrepared)
         {
-            size_t jpegsize = pbuf->mDataSize;
-            bufsize = jpegsize + sizeof(off_t) + sizeof(size_t) + sizeof(size_t);
-
-            int freeMemKb = getFreeMemory();
-            int buffersMemKb = getBuffersMemory();
-            int cachedMemKb = getCachedMemory();
-            if ((unsigned int)(freeMemKb/*+buffersMemKb+cachedMemKb*/) < (bufsize+2*1024*1024)>>10) 
-            {
-                alogw("Be careful! Free memory too small! bufsize=%dKB, MemTotal=%dKB, MemFree=%dKB, Buffers=%dKB, Cached=%dKB",
-                    bufsize/1024, getTotalMemory(), freeMemKb, buffersMemKb, cachedMemKb);
-                //goto ALLOC_MEM_ERR;
-            }
-            pbuf->mPicBuf = std::make_shared<CMediaMemory>(bufsize);
-            char *p = (char*)pbuf->mPicBuf->getPointer();
-            if(pbuf->mLen0 > 0)
-            {
-                memcpy(p, pbuf->mpData0, pbuf->mLen0);
-                p += pbuf->mLen0;
-            }
-            if(pbuf->mLen1 > 0)
-            {
-                memcpy(p, pbuf->mpData1, pbuf->mLen1);
-                p += pbuf->mLen1;
-            }
-            if(pbuf->mLen2 > 0)
-            {
-                memcpy(p, pbuf->mpData2, pbuf->mLen2);
-                p += pbuf->mLen2;
-            }
-            off_t thumboffset = pbuf->mThumbOffset;
-            size_t thumblen = pbuf->mThumbLen;
-            memcpy(p, &thumboffset, sizeof(off_t));
-            p += sizeof(off_t);
-            memcpy(p, &thumblen, sizeof(size_t));
-            p += sizeof(size_t);
-            memcpy(p, &jpegsize, sizeof(size_t));
-            //after finish sharedMem, return venc frame now.
-            VENC_STREAM_S tmpVencStream;
-            VENC_PACK_S tmpVencPack;
-            memset(&tmpVencStream, 0, sizeof(VENC_STREAM_S));
-            memset(&tmpVencPack, 0, sizeof(VENC_PACK_S));
-            tmpVencStream.mpPack = &tmpVencPack;
-            tmpVencStream.mPackCount = 1;
-            tmpVencStream.mpPack[0].mpAddr0 = pbuf->mpData0;
-            tmpVencStream.mpPack[0].mpAddr1 = pbuf->mpData1;
-            tmpVencStream.mpPack[0].mpAddr2 = pbuf->mpData2;
-            tmpVencStream.mpPack[0].mLen0 = pbuf->mLen0;
-            tmpVencStream.mpPack[0].mLen1 = pbuf->mLen1;
-            tmpVencStream.mpPack[0].mLen2 = pbuf->mLen2;
-            mpJpegenc->returnFrame(&tmpVencStream);
+            bufsize = pbuf->mPicBuf->getSize();
         }
         mPicBufLock.unlock();
         //mpDataCallback->postData(pbuf->mMsgType, mMppChnInfo.mChnId, pbuf->mpData, pbuf->mDataSize);
@@ -46,7 +46,7 @@ typedef struct RecordingProxyListener
 
 struct PictureBuffer
 {
-    bool mbSharedMemPrepared;   //true:mPicBuf is prepared, mpData0... are not used; false:mPicBuf is null, mpData0... are used to store venclibBuffer address.
+    bool mbSharedMemPrepared;   //true:mPicBuf is prepared, mpData0... are not used; false:mPicBuf is a view on the venclibBuffer at mpData0..., made when it is encoded.
     unsigned char *mpData0;
     unsigned char *mpData1;
     unsigned char *mpData2;
@@ -193,6 +193,24 @@ public:
     status_t notifyPictureRelease();
 
 protected:
+    std::shared_ptr<CMediaMemory> makePictureView(const PictureBuffer& buf);
+    /**
+     * views on the jpeg encoder's venclibBuffer, held by app. Each view keeps the owner alive, so
+     * an encoder detached from the notifier is destroyed by the last view app releases.
+     */
+    struct PictureViewOwner
+    {
+        Mutex mLock;
+        Condition mCondReturned;
+        CameraJpegEncoder *mpJpegenc;
+        int mViewNum;
+        bool mbDetached;    //notifier gave up the encoder, the last view destroys it.
+    };
+    static void returnPictureView(const std::shared_ptr<PictureViewOwner>& spOwner,
+        unsigned char *pData0, unsigned int nLen0, unsigned char *pData1, unsigned int nLen1,
+        unsigned char *pData2, unsigned int nLen2);
+    void releaseJpegEncoder();
+
     class DoSavePictureThread : public Thread
     {
     public:
@@ -252,6 +270,8 @@ private:
     Mutex mPicBufLock;
     //Condition mSavePictureCond;
     Mutex mSavePictureLock;
+    std::shared_ptr<CMediaMemoryPool> mspPicturePool;  //raw and compressed-frame pictures, which need a copy
+    std::shared_ptr<PictureViewOwner> mspPictureViewOwner;
     char *mpFolderPath; //picture folder path
     char *mpSnapPath;   //picture path
     int mSavePictureCnt;    //for msg CAMERA_MSG_CONTINUOUSSNAP
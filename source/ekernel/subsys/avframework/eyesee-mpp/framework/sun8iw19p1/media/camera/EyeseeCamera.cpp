@@ -145,15 +145,9 @@ void EyeseeCamera::EventHandler::handleMessage(const CallbackMessage &msg)
             
             if (it->second.mpRawImageCallback) 
             {
-                if(msg.mDataPtr)
+                if(msg.mDataPtr && msg.mDataPtr->getSize() > 0)
                 {
-                    if(msg.mDataPtr->getPointer() != NULL)
-                    {
-                        //int chnId = msg.arg1;
-                        const void *pData = msg.mDataPtr->getPointer();
-                        int nSize = msg.arg2;
-                        it->second.mpRawImageCallback->onPictureTaken(chnId, pData, nSize, mpCamera);
-                    }
+                    it->second.mpRawImageCallback->onPictureData(chnId, msg.mDataPtr, mpCamera);
                 }
             }
             mpCamera->mpVIDevice->notifyPictureRelease(chnId);
@@ -173,16 +167,9 @@ void EyeseeCamera::EventHandler::handleMessage(const CallbackMessage &msg)
             
             if (it->second.mpJpegCallback) 
             {
-                if(msg.mDataPtr)
+                if(msg.mDataPtr && msg.mDataPtr->getSize() > 0)
                 {
-                    if(msg.mDataPtr->getPointer() != NULL) 
-                    {
-                        //int chnId = msg.arg1;
-                        const void *pData = msg.mDataPtr->getPointer();
-                        int nSize = msg.arg2;
-                        it->second.mpJpegCallback->onPictureTaken(chnId, pData, nSize, mpCamera);
-                        //mpCamera->postDataCompleted(msg.arg1, msg.obj, msg.arg2);
-                    }
+                    it->second.mpJpegCallback->onPictureData(chnId, msg.mDataPtr, mpCamera);
                 }
             }
             mpCamera->mpVIDevice->notifyPictureRelease(chnId);
@@ -237,15 +224,9 @@ void EyeseeCamera::EventHandler::handleMessage(const CallbackMessage &msg)
             
             if (it->second.mpPostviewCallback) 
             {
-                if(msg.mDataPtr)
+                if(msg.mDataPtr && msg.mDataPtr->getSize() > 0)
                 {
-                    if(msg.mDataPtr->getPointer() != NULL) 
-                    {
-                        //int chnId = msg.arg1;
-                        const void *pData = msg.mDataPtr->getPointer();
-                        int nSize = msg.arg2;
-                        it->second.mpPostviewCallback->onPictureTaken(chnId, pData, nSize, mpCamera);
-                    }
+                    it->second.mpPostviewCallback->onPictureData(chnId, msg.mDataPtr, mpCamera);
                 }
             }
             mpCamera->mpVIDevice->notifyPictureRelease(chnId);
@@ -0,0 +1,316 @@
+/*******************************************************************************
+--                                                                            --
+--                    CedarX Multimedia Framework                             --
+--                                                                            --
+--          the Multimedia Framework for Linux/Android System                 --
+--                                                                            --
+--       This software is confidential and proprietary and may be used        --
+--        only as expressly authorized by a licensing agreement from          --
+--                         Softwinner Products.                               --
+--                                                                            --
+--                   (C) COPYRIGHT 2011 SOFTWINNER PRODUCTS                   --
+--                            ALL RIGHTS RESERVED                             --
+--                                                                            --
+--                 The entire notice above must be reproduced                 --
+--                  on all copies and should not be removed.                  --
+--                                                                            --
+*******************************************************************************/
+//#define LOG_NDEBUG 0
+#define LOG_TAG "BitRateController"
+#include <utils/plat_log.h>
+
+#include <string.h>
+
+#include "BitRateController.h"
+
+namespace EyeseeLinux {
+
+#define BRC_MIN_UPDATE_INTERVAL     (50*1000)       //us
+#define BRC_OVERSHOOT_WINDOW        (2*1000*1000)   //us, longer than a gop
+#define BRC_FRAME_RATE_HOLD         (1*1000*1000)   //us over mHighFillPercent before the frame rate is lowered
+#define BRC_RESTORE_HOLD            (3*1000*1000)   //us drained before the qp and frame rate come back
+#define BRC_SIGNIFICANT_PERCENT     (3)             //smaller bitrate changes are not applied
+
+void BitRateController::getDefaultConfig(Config &config, int bitRate, int frameRate, int minQp, int maxQp)
+{
+    config.mMaxBitRate = bitRate;
+    config.mMinBitRate = bitRate/8;
+    config.mMinQp = minQp;
+    config.mMaxQp = maxQp;
+    config.mMaxQpCeiling = maxQp + 8 < 51 ? maxQp + 8 : 51;
+    config.mFrameRate = frameRate;
+    config.mMinFrameRate = frameRate/3 > 1 ? frameRate/3 : 1;
+    config.mTargetFillPercent = 30;
+    config.mHighFillPercent = 80;
+    config.mHorizonMs = 2000;
+    config.mRampUpPercent = 10;
+}
+
+BitRateController::BitRateController(const Config &config)
+    : mConfig(config)
+{
+    if(mConfig.mMinBitRate <= 0 || mConfig.mMinBitRate > mConfig.mMaxBitRate)
+    {
+        alogw("minBitRate[%d] out of (0, %d], use 1/8", mConfig.mMinBitRate, mConfig.mMaxBitRate);
+        mConfig.mMinBitRate = mConfig.mMaxBitRate/8;
+    }
+    if(mConfig.mMaxQpCeiling < mConfig.mMaxQp)
+    {
+        mConfig.mMaxQpCeiling = mConfig.mMaxQp;
+    }
+    if(mConfig.mMinFrameRate <= 0 || mConfig.mMinFrameRate > mConfig.mFrameRate)
+    {
+        mConfig.mMinFrameRate = mConfig.mFrameRate;
+    }
+    if(mConfig.mHorizonMs <= 0)
+    {
+        mConfig.mHorizonMs = 2000;
+    }
+    reset();
+}
+
+BitRateController::~BitRateController()
+{
+}
+
+void BitRateController::reset()
+{
+    mDecision.mBitRate = mConfig.mMaxBitRate;
+    mDecision.mMinQp = mConfig.mMinQp;
+    mDecision.mMaxQp = mConfig.mMaxQp;
+    mDecision.mFrameRate = mConfig.mFrameRate;
+
+    mLastUpdateUs = -1;
+    mFrameBytes = 0;
+    mFrames = 0;
+    mTargetBps = mConfig.mMaxBitRate;
+    mEncodedBps = 0;
+    mOvershoot = 1.0;
+    mOvershootBytes = 0;
+    mOvershootAskedBits = 0;
+    mOvershootUs = 0;
+    mHighFillUs = 0;
+    mLowFillUs = 0;
+    mDecisionCount = 0;
+    memset(mSinks, 0, sizeof(mSinks));
+}
+
+void BitRateController::onEncodedFrame(int64_t ptsUs, unsigned int size, bool bKeyFrame)
+{
+    mFrameBytes += size;
+    mFrames++;
+    alogv("frame pts[%lld]us size[%u] key[%d]", ptsUs, size, bKeyFrame);
+}
+
+void BitRateController::onSinkState(SinkType sink, unsigned int backlogBytes, unsigned int capacityBytes)
+{
+    if(sink < 0 || sink >= SINK_NUM || 0 == capacityBytes)
+    {
+        aloge("fatal error! wrong sink[%d] capacity[%u]", sink, capacityBytes);
+        return;
+    }
+    mSinks[sink].mbValid = true;
+    mSinks[sink].mBacklog = backlogBytes;
+    mSinks[sink].mCapacity = capacityBytes;
+}
+
+void BitRateController::onSinkRemoved(SinkType sink)
+{
+    if(sink >= 0 && sink < SINK_NUM)
+    {
+        memset(&mSinks[sink], 0, sizeof(SinkState));
+    }
+}
+
+/**
+ * rate which brings the backlog of the sink to the target in the horizon if
+ * it keeps draining as it did, -1 if the sink does not limit the rate.
+ */
+double BitRateController::allowedRate(SinkState &sink, int64_t inBytes, int64_t dtUs)
+{
+    if(!sink.mbValid)
+    {
+        return -1;
+    }
+    if(sink.mbHavePrev)
+    {
+        int64_t drained = inBytes - (sink.mBacklog - sink.mPrevBacklog);
+        double sample = (drained > 0 ? drained : 0) * 8e6 / dtUs;
+        if(sink.mBacklog > sink.mCapacity/50 && sink.mPrevBacklog > sink.mCapacity/50)
+        {
+            //it had data waiting all along, so it drained as fast as it could
+            sink.mDrainBps = sink.mDrainBps > 0 ? 0.5*sink.mDrainBps + 0.5*sample : sample;
+        }
+        else
+        {
+            //it kept up, how fast it can go is not known
+            sink.mDrainBps = 0;
+        }
+    }
+    sink.mPrevBacklog = sink.mBacklog;
+    sink.mbHavePrev = true;
+
+    int64_t target = sink.mCapacity * mConfig.mTargetFillPercent / 100;
+    if(sink.mBacklog < target/2 || sink.mDrainBps <= 0)
+    {
+        return -1;
+    }
+    double allowed = sink.mDrainBps + (target - sink.mBacklog) * 8e3 / mConfig.mHorizonMs;
+    return allowed > 0 ? allowed : 0;
+}
+
+bool BitRateController::update(int64_t nowUs, Decision &decision)
+{
+    decision = mDecision;
+    if(mLastUpdateUs < 0)
+    {
+        mLastUpdateUs = nowUs;
+        mFrameBytes = 0;
+        mFrames = 0;
+        return false;
+    }
+    int64_t dtUs = nowUs - mLastUpdateUs;
+    if(dtUs < BRC_MIN_UPDATE_INTERVAL)
+    {
+        return false;
+    }
+
+    //what the encoder gave against what it was asked
+    double encodedSample = mFrameBytes * 8e6 / dtUs;
+    mEncodedBps = mEncodedBps > 0 ? 0.7*mEncodedBps + 0.3*encodedSample : encodedSample;
+    mOvershootBytes += mFrameBytes;
+    mOvershootAskedBits += (double)mDecision.mBitRate * dtUs / 1e6;
+    mOvershootUs += dtUs;
+    if(mOvershootUs >= BRC_OVERSHOOT_WINDOW)
+    {
+        if(mOvershootBytes > 0)
+        {
+            double sample = mOvershootBytes * 8 / mOvershootAskedBits;
+            sample = sample < 0.5 ? 0.5 : (sample > 2.0 ? 2.0 : sample);
+            mOvershoot = 0.5*mOvershoot + 0.5*sample;
+        }
+        mOvershootBytes = 0;
+        mOvershootAskedBits = 0;
+        mOvershootUs = 0;
+    }
+
+    //what the sinks can take
+    double want = mConfig.mMaxBitRate;
+    int maxFill = 0;
+    for(int i = 0; i < SINK_NUM; i++)
+    {
+        double allowed = allowedRate(mSinks[i], mFrameBytes, dtUs);
+        if(allowed >= 0 && allowed < want)
+        {
+            want = allowed;
+        }
+        if(mSinks[i].mbValid)
+        {
+            int fill = (int)(mSinks[i].mBacklog * 100 / mSinks[i].mCapacity);
+            if(fill > maxFill)
+            {
+                maxFill = fill;
+            }
+        }
+    }
+    if(want < mTargetBps)
+    {
+        mTargetBps = want;
+    }
+    else
+    {
+        double rampUp = mTargetBps * (1.0 + mConfig.mRampUpPercent * dtUs / 1e8);
+        mTargetBps = want < rampUp ? want : rampUp;
+    }
+    if(mTargetBps < mConfig.mMinBitRate)
+    {
+        mTargetBps = mConfig.mMinBitRate;
+    }
+
+    Decision newDecision = mDecision;
+    double ask = mTargetBps / mOvershoot;
+    ask = ask < mConfig.mMinBitRate ? mConfig.mMinBitRate : (ask > mConfig.mMaxBitRate ? mConfig.mMaxBitRate : ask);
+    newDecision.mBitRate = (int)ask;
+
+    //under the floor of the bitrate, give up quality, then smoothness
+    mHighFillUs = maxFill >= mConfig.mHighFillPercent ? mHighFillUs + dtUs : 0;
+    mLowFillUs = maxFill < mConfig.mTargetFillPercent/2 ? mLowFillUs + dtUs : 0;
+    bool bAtFloor = newDecision.mBitRate <= mConfig.mMinBitRate;
+    if(bAtFloor && (want < mConfig.mMinBitRate || maxFill >= mConfig.mHighFillPercent))
+    {
+        if(newDecision.mMaxQp < mConfig.mMaxQpCeiling)
+        {
+            newDecision.mMaxQp++;
+        }
+        else if(mHighFillUs >= BRC_FRAME_RATE_HOLD && newDecision.mFrameRate > mConfig.mMinFrameRate)
+        {
+            newDecision.mFrameRate = newDecision.mFrameRate*3/4;
+            if(newDecision.mFrameRate < mConfig.mMinFrameRate)
+            {
+                newDecision.mFrameRate = mConfig.mMinFrameRate;
+            }
+            mHighFillUs = 0;
+        }
+    }
+    else if(mLowFillUs >= BRC_RESTORE_HOLD)
+    {
+        if(newDecision.mFrameRate < mConfig.mFrameRate)
+        {
+            int step = mConfig.mFrameRate/6 > 1 ? mConfig.mFrameRate/6 : 1;
+            newDecision.mFrameRate += step;
+            if(newDecision.mFrameRate > mConfig.mFrameRate)
+            {
+                newDecision.mFrameRate = mConfig.mFrameRate;
+            }
+            mLowFillUs -= BRC_FRAME_RATE_HOLD;
+        }
+        else if(newDecision.mMaxQp > mConfig.mMaxQp)
+        {
+            newDecision.mMaxQp--;
+            mLowFillUs -= BRC_FRAME_RATE_HOLD;
+        }
+    }
+    newDecision.mMinQp = mConfig.mMinQp + (newDecision.mMaxQp - mConfig.mMaxQp)/2;
+    if(newDecision.mMinQp > newDecision.mMaxQp)
+    {
+        newDecision.mMinQp = newDecision.mMaxQp;
+    }
+
+    //small bitrate moves are noise of the estimates
+    int64_t diff = (int64_t)newDecision.mBitRate - mDecision.mBitRate;
+    if((diff < 0 ? -diff : diff) * 100 < (int64_t)mDecision.mBitRate * BRC_SIGNIFICANT_PERCENT
+        && newDecision.mBitRate != mConfig.mMinBitRate && newDecision.mBitRate != mConfig.mMaxBitRate)
+    {
+        newDecision.mBitRate = mDecision.mBitRate;
+    }
+
+    mLastUpdateUs = nowUs;
+    mFrameBytes = 0;
+    mFrames = 0;
+    if(0 == memcmp(&newDecision, &mDecision, sizeof(Decision)))
+    {
+        return false;
+    }
+    alogv("bitRate[%d]->[%d]kbps, qp[%d,%d], fps[%d], fill[%d]%%, encoded[%d]kbps, overshoot[%f]",
+        mDecision.mBitRate/1024, newDecision.mBitRate/1024, newDecision.mMinQp, newDecision.mMaxQp,
+        newDecision.mFrameRate, maxFill, (int)mEncodedBps/1024, mOvershoot);
+    mDecision = newDecision;
+    mDecisionCount++;
+    decision = mDecision;
+    return true;
+}
+
+void BitRateController::getStats(Stats &stats) const
+{
+    stats.mTargetBitRate = (int)mTargetBps;
+    stats.mEncodedBitRate = (int)mEncodedBps;
+    for(int i = 0; i < SINK_NUM; i++)
+    {
+        stats.mDrainBitRate[i] = (int)mSinks[i].mDrainBps;
+        stats.mFillPercent[i] = mSinks[i].mbValid ? (int)(mSinks[i].mBacklog * 100 / mSinks[i].mCapacity) : -1;
+    }
+    stats.mDecisionCount = mDecisionCount;
+}
+
+}; /* EyeseeLinux */
+
@@ -0,0 +1,137 @@
+/*******************************************************************************
+--                                                                            --
+--                    CedarX Multimedia Framework                             --
+--                                                                            --
+--          the Multimedia Framework for Linux/Android System                 --
+--                                                                            --
+--       This software is confidential and proprietary and may be used        --
+--        only as expressly authorized by a licensing agreement from          --
+--                         Softwinner Products.                               --
+--                                                                            --
+--                   (C) COPYRIGHT 2011 SOFTWINNER PRODUCTS                   --
+--                            ALL RIGHTS RESERVED                             --
+--                                                                            --
+--                 The entire notice above must be reproduced                 --
+--                  on all copies and should not be removed.                  --
+--                                                                            --
+*******************************************************************************/
+#ifndef __IPCLINUX_BITRATECONTROLLER_H__
+#define __IPCLINUX_BITRATECONTROLLER_H__
+
+#include <stdint.h>
+
+namespace EyeseeLinux {
+
+/**
+ * Rate control policy of DynamicBitRateControl, without any mpp call so that
+ * it can be replayed on the host.
+ *
+ * It is fed with the size of every encoded frame and the backlog of the
+ * sinks of the stream (the muxer cache in front of the card, the send buffer
+ * of a network stream), and decides the target bitrate, the qp range and the
+ * frame rate of the encoder:
+ *  - the rate a sink drains is estimated from what was put in it and how its
+ *    backlog moved. The rate allowed to a backlogged sink is the one which
+ *    brings its backlog back to mTargetFillPercent in mHorizonMs.
+ *  - the target is the lowest allowed rate, it goes down at once and up by
+ *    mRampUpPercent a second, up to mMaxBitRate.
+ *  - the encoder is asked for the target corrected by how much its frames
+ *    overshoot or undershoot what it was asked.
+ *  - at mMinBitRate, if the encoder still overshoots or a sink still fills,
+ *    the max qp is raised up to mMaxQpCeiling, then the frame rate lowered
+ *    down to mMinFrameRate. Both come back when the sinks are drained.
+ * Not thread safe, one thread calls all of it.
+ */
+class BitRateController
+{
+public:
+    enum SinkType
+    {
+        SINK_STORAGE = 0,
+        SINK_NETWORK,
+        SINK_NUM,
+    };
+    struct Config
+    {
+        int mMaxBitRate;        //bps, the bitrate set by the user
+        int mMinBitRate;        //bps
+        int mMinQp;             //qp range set by the user
+        int mMaxQp;
+        int mMaxQpCeiling;      //mMaxQp can be raised up to it
+        int mFrameRate;         //fps set by the user
+        int mMinFrameRate;
+        int mTargetFillPercent; //backlog of the sinks aimed at
+        int mHighFillPercent;   //backlog at which qp and frame rate are given up
+        int mHorizonMs;         //time to bring a backlog back to the target
+        int mRampUpPercent;     //bitrate increase a second when no sink is backlogged
+    };
+    struct Decision
+    {
+        int mBitRate;           //bps asked to the encoder
+        int mMinQp;
+        int mMaxQp;
+        int mFrameRate;
+    };
+    struct Stats
+    {
+        int mTargetBitRate;     //bps the sinks can take
+        int mEncodedBitRate;    //bps the encoder gave
+        int mDrainBitRate[SINK_NUM];    //bps, estimate, 0 if not known
+        int mFillPercent[SINK_NUM];     //-1 if the sink is not fed
+        int mDecisionCount;     //updates which changed the decision
+    };
+
+    static void getDefaultConfig(Config &config, int bitRate, int frameRate, int minQp, int maxQp);
+
+    BitRateController(const Config &config);
+    ~BitRateController();
+
+    void reset();
+    void onEncodedFrame(int64_t ptsUs, unsigned int size, bool bKeyFrame);
+    void onSinkState(SinkType sink, unsigned int backlogBytes, unsigned int capacityBytes);
+    void onSinkRemoved(SinkType sink);
+    /**
+     * recompute the decision, to be called periodically.
+     * @return true if the decision changed and is to be applied.
+     */
+    bool update(int64_t nowUs, Decision &decision);
+    const Decision &getDecision() const { return mDecision; }
+    void getStats(Stats &stats) const;
+
+private:
+    struct SinkState
+    {
+        bool mbValid;           //onSinkState called since reset or removed
+        bool mbHavePrev;        //mPrevBacklog is valid
+        int64_t mBacklog;       //bytes
+        int64_t mCapacity;
+        int64_t mPrevBacklog;
+        double mDrainBps;       //estimate while backlogged, 0 if not known
+    };
+
+    double allowedRate(SinkState &sink, int64_t inBytes, int64_t dtUs);
+
+    Config mConfig;
+    Decision mDecision;
+
+    int64_t mLastUpdateUs;      //-1 before the first update
+    int64_t mFrameBytes;        //encoded since the last update
+    int mFrames;
+
+    double mTargetBps;          //what the sinks can take
+    double mEncodedBps;         //smoothed
+    double mOvershoot;          //encoded / asked, smoothed over windows longer than a gop
+    int64_t mOvershootBytes;    //of the current window
+    double mOvershootAskedBits;
+    int64_t mOvershootUs;
+    int64_t mHighFillUs;        //time the sinks are over mHighFillPercent
+    int64_t mLowFillUs;         //time they are under half mTargetFillPercent
+    int mDecisionCount;
+
+    SinkState mSinks[SINK_NUM];
+};
+
+}; /* EyeseeLinux */
+
+#endif /* __IPCLINUX_BITRATECONTROLLER_H__ */
+
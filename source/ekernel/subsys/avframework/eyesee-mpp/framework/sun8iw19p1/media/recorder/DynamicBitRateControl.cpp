@@ -31,6 +31,7 @@
 #include <ComponentCommon.h>
 #include <mpi_venc.h>
 #include <mpi_mux.h>
+#include <SystemBase.h>
 
 namespace EyeseeLinux {
 
@@ -52,6 +53,15 @@ status_t DynamicBitRateControl::GetBufferState(EyeseeRecorder::BufferState &buff
     return ret;
 }
 
+status_t DynamicBitRateControl::SetNetworkSinkState(unsigned int backlogBytes, unsigned int capacityBytes)
+{
+    Mutex::Autolock lock(mNetworkSinkLock);
+    mbNetworkSinkValid = capacityBytes > 0;
+    mNetworkBacklog = backlogBytes;
+    mNetworkCapacity = capacityBytes;
+    return NO_ERROR;
+}
+
 int DynamicBitRateControl::UpdateVEncBitRate(EyeseeRecorder *pRecCtx, int newBitRate, int *pOldBitRate)
 {
     int ret = -1;
@@ -71,100 +81,148 @@ int DynamicBitRateControl::UpdateVEncBitRate(EyeseeRecorder *pRecCtx, int newBit
     return ret;
 }
 
-void* DynamicBitRateControl::DynamicBitRateControlThread(void* pThreadData)
+int DynamicBitRateControl::UpdateVEncQpRange(EyeseeRecorder *pRecCtx, int minQp, int maxQp)
 {
-    DynamicBitRateControl   *pDBRC = (DynamicBitRateControl*)pThreadData;
-    EyeseeRecorder *rec_ctx = pDBRC->mPriv;
-    message_t msg;
-    int ret = 0;
-    int nDetectDuration = 500; //unit:ms
-    while(1)
+    VENC_CHN_ATTR_S attr;
+    AW_MPI_VENC_GetChnAttr(pRecCtx->mVeChn, &attr);
+    switch(attr.RcAttr.mRcMode)
     {
-PROCESS_MESSAGE:
-        //get bitRate in CBR mode
-        unsigned int nVideoBitRate = 0;
-        if(rec_ctx->mVideoRCMode != rec_ctx->mVEncRcAttr.mRcMode)
-        {
-            aloge("fatal error! check rcMode[0x%x]!=[0x%x]", rec_ctx->mVideoRCMode, rec_ctx->mVEncRcAttr.mRcMode);
-        }
-        if(EyeseeRecorder::VideoRCMode_CBR==rec_ctx->mVideoRCMode)
+        case VENC_RC_MODE_H264CBR:
         {
-            if(PT_H264 == rec_ctx->mVEncRcAttr.mVEncType)
+            if((int)attr.RcAttr.mAttrH264Cbr.mMinQp == minQp && (int)attr.RcAttr.mAttrH264Cbr.mMaxQp == maxQp)
             {
-                nVideoBitRate = rec_ctx->mVEncRcAttr.mAttrH264Cbr.mBitRate;
+                return 0;
             }
-            else if(PT_H265 == rec_ctx->mVEncRcAttr.mVEncType)
-            {
-                nVideoBitRate = rec_ctx->mVEncRcAttr.mAttrH265Cbr.mBitRate;
-            }
-            else if(PT_MJPEG == rec_ctx->mVEncRcAttr.mVEncType)
-            {
-                nVideoBitRate = rec_ctx->mVEncRcAttr.mAttrMjpegCbr.mBitRate;
-            }
-            else
+            attr.RcAttr.mAttrH264Cbr.mMinQp = minQp;
+            attr.RcAttr.mAttrH264Cbr.mMaxQp = maxQp;
+            break;
+        }
+        case VENC_RC_MODE_H265CBR:
+        {
+            if((int)attr.RcAttr.mAttrH265Cbr.mMinQp == minQp && (int)attr.RcAttr.mAttrH265Cbr.mMaxQp == maxQp)
             {
-                aloge("fatal error! unsupport vencType[0x%x]", rec_ctx->mVEncRcAttr.mVEncType);
+                return 0;
             }
+            attr.RcAttr.mAttrH265Cbr.mMinQp = minQp;
+            attr.RcAttr.mAttrH265Cbr.mMaxQp = maxQp;
+            break;
+        }
+        default:
+        {
+            //mjpeg cbr has no qp range
+            return 0;
+        }
+    }
+    return AW_MPI_VENC_SetChnAttr(pRecCtx->mVeChn, &attr);
+}
+
+int DynamicBitRateControl::UpdateVEncFrameRate(EyeseeRecorder *pRecCtx, int frameRate)
+{
+    VENC_FRAME_RATE_S stFrameRate;
+    int ret = AW_MPI_VENC_GetFrameRate(pRecCtx->mVeChn, &stFrameRate);
+    if(ret != SUCCESS)
+    {
+        return ret;
+    }
+    if(stFrameRate.DstFrmRate == frameRate)
+    {
+        return 0;
+    }
+    stFrameRate.DstFrmRate = frameRate;
+    return AW_MPI_VENC_SetFrameRate(pRecCtx->mVeChn, &stFrameRate);
+}
+
+/**
+ * give the controller the frames encoded since the last call and the state of
+ * the network sink. The storage sink is given by the thread with the cache state.
+ */
+void DynamicBitRateControl::FeedController()
+{
+    VENC_FRAME_SIZE_HISTORY_S stHistory;
+    stHistory.mSeq = mFrameSizeSeq;
+    ERRORTYPE eError = AW_MPI_VENC_GetFrameSizeHistory(mPriv->mVeChn, &stHistory);
+    if(SUCCESS == eError)
+    {
+        if(stHistory.mLost > 0)
+        {
+            alogw("DBRC polls too slowly, [%u] encoded frames are not counted", stHistory.mLost);
+        }
+        for(unsigned int i = 0; i < stHistory.mNum; i++)
+        {
+            mpController->onEncodedFrame(stHistory.mFrames[i].mPts, stHistory.mFrames[i].mSize, stHistory.mFrames[i].mbKeyFrame);
         }
+        mFrameSizeSeq = stHistory.mSeq;
+    }
+    else
+    {
+        alogw("get venc frame size history fail[0x%x]", eError);
+    }
+
+    Mutex::Autolock lock(mNetworkSinkLock);
+    if(mbNetworkSinkValid)
+    {
+        mpController->onSinkState(BitRateController::SINK_NETWORK, mNetworkBacklog, mNetworkCapacity);
+    }
+    else
+    {
+        mpController->onSinkRemoved(BitRateController::SINK_NETWORK);
+    }
+}
+
+void DynamicBitRateControl::ApplyDecision(const BitRateController::Decision &decision)
+{
+    EyeseeRecorder *rec_ctx = mPriv;
+    int oldBitRate = 0;
+    int ret = UpdateVEncBitRate(rec_ctx, decision.mBitRate, &oldBitRate);
+    if(ret != 0 && oldBitRate != decision.mBitRate)
+    {
+        aloge("fatal error! set bitRate fail[0x%x]", ret);
+    }
+    ret = UpdateVEncQpRange(rec_ctx, decision.mMinQp, decision.mMaxQp);
+    if(ret != 0)
+    {
+        aloge("fatal error! set qp range fail[0x%x]", ret);
+    }
+    ret = UpdateVEncFrameRate(rec_ctx, decision.mFrameRate);
+    if(ret != 0)
+    {
+        aloge("fatal error! set frame rate fail[0x%x]", ret);
+    }
+    BitRateController::Stats stats;
+    mpController->getStats(stats);
+    alogd("DBRC bitRate[%d]->[%d]kbit/s, qp[%d,%d], fps[%d], sinks can take [%d]kbit/s, encoder gives [%d]kbit/s, fill storage[%d]%% network[%d]%%",
+        oldBitRate/1024, decision.mBitRate/1024, decision.mMinQp, decision.mMaxQp, decision.mFrameRate,
+        stats.mTargetBitRate/1024, stats.mEncodedBitRate/1024,
+        stats.mFillPercent[BitRateController::SINK_STORAGE], stats.mFillPercent[BitRateController::SINK_NETWORK]);
+}
+
+void* DynamicBitRateControl::DynamicBitRateControlThread(void* pThreadData)
+{
+    DynamicBitRateControl   *pDBRC = (DynamicBitRateControl*)pThreadData;
+    EyeseeRecorder *rec_ctx = pDBRC->mPriv;
+    message_t msg;
+    int nDetectDuration = 250; //unit:ms
+    while(1)
+    {
         if(!get_message(&pDBRC->mDBRCMsgQueue, &msg))
         {
             if (msg.command == Stop)
             {
-                alogd("restore bitRate to [%d]kbps before exit DBRCThread", nVideoBitRate/1024);
-                //ret = pDBRC->UpdateVEncBitRate(rec_ctx, nVideoBitRate, NULL);
-//                if(0 != ret)
-//                {
-//                    aloge("fatal error! set bitRate fail[0x%x]", ret);
-//                }
                 // Kill thread
                 goto _ExitThread;
             }
         }
-        if(MEDIA_RECORDER_RECORDING==rec_ctx->mCurrentState && EyeseeRecorder::VideoRCMode_CBR==rec_ctx->mVideoRCMode)
+        if(MEDIA_RECORDER_RECORDING==rec_ctx->mCurrentState && EyeseeRecorder::VideoRCMode_CBR==rec_ctx->mVideoRCMode
+            && pDBRC->mpController != NULL)
         {
-            CacheState  recRenderCacheState;
+            CacheState  cacheState;
             ERRORTYPE   eError;
-            eError = AW_MPI_MUX_GetCacheStatus(rec_ctx->mMuxGrp, &recRenderCacheState);
+            bool bCacheStateValid = false;
+            eError = AW_MPI_MUX_GetCacheStatus(rec_ctx->mMuxGrp, &cacheState);
             if (SUCCESS == eError)
             {
-                /*
-                int oldLevel = pDBRC->mStepLevel;
-                if(recRenderCacheState.mValidSizePercent >= 80)
-                {
-                    pDBRC->mStepLevel = DBRC_MAX_STEP_LEVEL;
-                }
-                else if(recRenderCacheState.mValidSizePercent >= 50)
-                {
-                    pDBRC->mStepLevel = 1;
-                }
-                else
-                {
-                    pDBRC->mStepLevel = 0;
-                }
-
-                if(oldLevel!=pDBRC->mStepLevel)
-                {
-                    int n = 1<<pDBRC->mStepLevel;
-                    int newBitRate = nVideoBitRate/n;
-                    int oldBitRate;
-                    eError = pDBRC->UpdateVEncBitRate(rec_ctx, newBitRate, &oldBitRate);
-                    if(0 == eError)
-                    {
-                        alogd("DBRC bitRate[%d]Mbit/s to [%d]kbit/s, validPercent[%d], stepLevel[%d]->[%d]",
-                            oldBitRate/(1024*1024), newBitRate/1024,
-                            recRenderCacheState.mValidSizePercent, oldLevel, pDBRC->mStepLevel);
-                    }
-                }
-                */
-                //alogd("muxer Buffer[%d],[%d]KB/[%d]KB", recRenderCacheState.mValidSizePercent, recRenderCacheState.mValidSize, recRenderCacheState.mTotalSize);
-                pDBRC->mBufferStateLock.lock();
-                pDBRC->mBufferState.mValidSizePercent = recRenderCacheState.mValidSizePercent;
-                pDBRC->mBufferState.mValidSize = recRenderCacheState.mValidSize;
-                pDBRC->mBufferState.mTotalSize = recRenderCacheState.mTotalSize;
-                pDBRC->mbBufferStateValid = true;
-                pDBRC->mBufferStateLock.unlock();
-                //send message.
-                rec_ctx->postEventFromNative(rec_ctx, MEDIA_RECORDER_EVENT_INFO, EyeseeRecorder::MEDIA_RECORDER_INFO_VENC_BUFFER_USAGE, recRenderCacheState.mValidSizePercent, NULL);
+                //alogd("muxer Buffer[%d],[%d]KB/[%d]KB", cacheState.mValidSizePercent, cacheState.mValidSize, cacheState.mTotalSize);
+                bCacheStateValid = true;
             }
             else if (ERR_MUX_SYS_NOTREADY == eError)
             {
@@ -173,41 +231,12 @@ PROCESS_MESSAGE:
             else if (ERR_MUX_NOT_SUPPORT == eError)
             {
                 alogv("recRender has not cacheManager?");
-                CacheState  vbvCacheState;
-                int oldLevel = pDBRC->mStepLevel;
-                eError = AW_MPI_VENC_GetCacheState(rec_ctx->mVeChn, &vbvCacheState);
+                //the frames the muxer has not taken stay in the vbv
+                eError = AW_MPI_VENC_GetCacheState(rec_ctx->mVeChn, &cacheState);
                 if (SUCCESS == eError)
                 {
-                    /*
-                    if (vbvCacheState.mValidSizePercent >= 50) {
-                        pDBRC->mStepLevel = DBRC_MAX_STEP_LEVEL;
-                    } else if (vbvCacheState.mValidSizePercent >= 30) {
-                        pDBRC->mStepLevel = 1;
-                    } else {
-                        pDBRC->mStepLevel = 0;
-                    }
-
-                    if (oldLevel != pDBRC->mStepLevel)
-                    {
-                        int newBitRate = nVideoBitRate/(1<<pDBRC->mStepLevel);
-                        eError = pDBRC->UpdateVEncBitRate(rec_ctx, newBitRate, NULL);
-                        if (0 == eError)
-                        {
-                            alogd("DBRC bitRate: [%d]->[%d] kbit/s, validPercent[%d], stepLevel: [%d]->[%d]",
-                                nVideoBitRate/1024, newBitRate/1024,
-                                vbvCacheState.mValidSizePercent, oldLevel, pDBRC->mStepLevel);
-                        }
-                    }
-                    */
-                    //alogd("venc Buffer[%d],[%d]KB/[%d]KB", vbvCacheState.mValidSizePercent, vbvCacheState.mValidSize, vbvCacheState.mTotalSize);
-                    pDBRC->mBufferStateLock.lock();
-                    pDBRC->mBufferState.mValidSizePercent = vbvCacheState.mValidSizePercent;
-                    pDBRC->mBufferState.mValidSize = vbvCacheState.mValidSize;
-                    pDBRC->mBufferState.mTotalSize = vbvCacheState.mTotalSize;
-                    pDBRC->mbBufferStateValid = true;
-                    pDBRC->mBufferStateLock.unlock();
-                    //send message.
-                    rec_ctx->postEventFromNative(rec_ctx, MEDIA_RECORDER_EVENT_INFO, EyeseeRecorder::MEDIA_RECORDER_INFO_VENC_BUFFER_USAGE, vbvCacheState.mValidSizePercent, NULL);
+                    //alogd("venc Buffer[%d],[%d]KB/[%d]KB", cacheState.mValidSizePercent, cacheState.mValidSize, cacheState.mTotalSize);
+                    bCacheStateValid = true;
                 }
                 else
                 {
@@ -218,12 +247,29 @@ PROCESS_MESSAGE:
             {
                 aloge("Query Mux CacheState, why retVal is %#x?!", eError);
             }
-            TMessage_WaitQueueNotEmpty(&pDBRC->mDBRCMsgQueue, nDetectDuration);
-        }
-        else
-        {
-            TMessage_WaitQueueNotEmpty(&pDBRC->mDBRCMsgQueue, nDetectDuration);
+            if(bCacheStateValid)
+            {
+                pDBRC->mBufferStateLock.lock();
+                pDBRC->mBufferState.mValidSizePercent = cacheState.mValidSizePercent;
+                pDBRC->mBufferState.mValidSize = cacheState.mValidSize;
+                pDBRC->mBufferState.mTotalSize = cacheState.mTotalSize;
+                pDBRC->mbBufferStateValid = true;
+                pDBRC->mBufferStateLock.unlock();
+                //send message.
+                rec_ctx->postEventFromNative(rec_ctx, MEDIA_RECORDER_EVENT_INFO, EyeseeRecorder::MEDIA_RECORDER_INFO_VENC_BUFFER_USAGE, cacheState.mValidSizePercent, NULL);
+                if(cacheState.mTotalSize > 0)
+                {
+                    pDBRC->mpController->onSinkState(BitRateController::SINK_STORAGE, cacheState.mValidSize*1024, cacheState.mTotalSize*1024);
+                }
+            }
+            pDBRC->FeedController();
+            BitRateController::Decision decision;
+            if(pDBRC->mpController->update(CDX_GetSysTimeUsMonotonic(), decision))
+            {
+                pDBRC->ApplyDecision(decision);
+            }
         }
+        TMessage_WaitQueueNotEmpty(&pDBRC->mDBRCMsgQueue, nDetectDuration);
     }
 
 _ExitThread:
@@ -234,10 +280,60 @@ _ExitThread:
 
 DynamicBitRateControl::DynamicBitRateControl(EyeseeRecorder *pRecCtx):
     mPriv(pRecCtx),
-    mStepLevel(0)
+    mpController(NULL),
+    mFrameSizeSeq(0),
+    mbNetworkSinkValid(false),
+    mNetworkBacklog(0),
+    mNetworkCapacity(0)
 {
     int eError = CDX_OK;
     mbBufferStateValid = false;
+
+    //the bitRate and qp range set by the user are the upper bound of the controller
+    int nBitRate = 0;
+    int nMinQp = 0;
+    int nMaxQp = 0;
+    if(pRecCtx->mVideoRCMode != pRecCtx->mVEncRcAttr.mRcMode)
+    {
+        aloge("fatal error! check rcMode[0x%x]!=[0x%x]", pRecCtx->mVideoRCMode, pRecCtx->mVEncRcAttr.mRcMode);
+    }
+    if(PT_H264 == pRecCtx->mVEncRcAttr.mVEncType)
+    {
+        nBitRate = pRecCtx->mVEncRcAttr.mAttrH264Cbr.mBitRate;
+        nMinQp = pRecCtx->mVEncRcAttr.mAttrH264Cbr.mMinQp;
+        nMaxQp = pRecCtx->mVEncRcAttr.mAttrH264Cbr.mMaxQp;
+    }
+    else if(PT_H265 == pRecCtx->mVEncRcAttr.mVEncType)
+    {
+        nBitRate = pRecCtx->mVEncRcAttr.mAttrH265Cbr.mBitRate;
+        nMinQp = pRecCtx->mVEncRcAttr.mAttrH265Cbr.mMinQp;
+        nMaxQp = pRecCtx->mVEncRcAttr.mAttrH265Cbr.mMaxQp;
+    }
+    else if(PT_MJPEG == pRecCtx->mVEncRcAttr.mVEncType)
+    {
+        nBitRate = pRecCtx->mVEncRcAttr.mAttrMjpegCbr.mBitRate;
+    }
+    else
+    {
+        aloge("fatal error! unsupport vencType[0x%x]", pRecCtx->mVEncRcAttr.mVEncType);
+    }
+    if(nBitRate > 0 && pRecCtx->mFrameRate > 0)
+    {
+        BitRateController::Config config;
+        BitRateController::getDefaultConfig(config, nBitRate, pRecCtx->mFrameRate, nMinQp, nMaxQp);
+        if(PT_MJPEG == pRecCtx->mVEncRcAttr.mVEncType)
+        {
+            config.mMaxQpCeiling = config.mMaxQp;
+        }
+        mpController = new BitRateController(config);
+        alogd("DBRC bitRate[%d, %d]kbit/s, qp[%d, %d->%d], fps[%d, %d]", config.mMinBitRate/1024, config.mMaxBitRate/1024,
+            config.mMinQp, config.mMaxQp, config.mMaxQpCeiling, config.mMinFrameRate, config.mFrameRate);
+    }
+    else
+    {
+        aloge("fatal error! bitRate[%d] frameRate[%d], DBRC only reports the buffer state", nBitRate, pRecCtx->mFrameRate);
+    }
+
     if(message_create(&mDBRCMsgQueue)<0)
     {
         aloge("message create fail!");
@@ -261,7 +357,11 @@ DynamicBitRateControl::~DynamicBitRateControl()
     pthread_join(mDynamicBitRateControlThreadId, (void**) &err);
     alogd("DynamicBitRateControlThread exit!");
     message_destroy(&mDBRCMsgQueue);
+    if(mpController)
+    {
+        delete mpController;
+        mpController = NULL;
+    }
 }
 
 };
-
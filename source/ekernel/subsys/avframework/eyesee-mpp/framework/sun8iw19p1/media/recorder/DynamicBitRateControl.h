@@ -21,9 +21,10 @@
 #include <tmessage.h>
 #include <EyeseeRecorder.h>
 
+#include "BitRateController.h"
+
 namespace EyeseeLinux {
 
-#define DBRC_MAX_STEP_LEVEL (2)
 //typedef struct DynamicBitRateControl
 //{
 //    pthread_t mDynamicBitRateControlThreadId;
@@ -40,12 +41,21 @@ public:
     ~DynamicBitRateControl();
 
     status_t GetBufferState(EyeseeRecorder::BufferState &bufferState);
+    /**
+     * backlog of the network stream fed by the recorder, e.g. the send buffer
+     * of a rtsp session. capacityBytes 0 means the stream is gone.
+     */
+    status_t SetNetworkSinkState(unsigned int backlogBytes, unsigned int capacityBytes);
 private:
     static void* DynamicBitRateControlThread(void *data);
 //    int DynamicBitRateControlInit(void *pRecCtx);
 //    void DynamicBitRateControlDestruct();
 //    int DynamicBitRateControlDestroy();
     int UpdateVEncBitRate(EyeseeRecorder *pRecCtx, int newBitRate, int *pOldBitRate);
+    int UpdateVEncQpRange(EyeseeRecorder *pRecCtx, int minQp, int maxQp);
+    int UpdateVEncFrameRate(EyeseeRecorder *pRecCtx, int frameRate);
+    void FeedController();
+    void ApplyDecision(const BitRateController::Decision &decision);
 
     pthread_t mDynamicBitRateControlThreadId;
     message_queue_t mDBRCMsgQueue;
@@ -55,7 +65,13 @@ private:
     bool mbBufferStateValid;
     EyeseeRecorder::BufferState mBufferState;
 
-    int mStepLevel; //0:not adjust, 1:adjust level one, 2:adjust level two.
+    BitRateController *mpController;
+    unsigned int mFrameSizeSeq; //next encoded frame to read from venc
+
+    Mutex mNetworkSinkLock;
+    bool mbNetworkSinkValid;
+    unsigned int mNetworkBacklog;   //unit:byte
+    unsigned int mNetworkCapacity;
 };
 
 
@@ -2776,6 +2776,18 @@ status_t EyeseeRecorder::GetBufferState(BufferState &state)
     }
 }
 
+status_t EyeseeRecorder::setNetworkSinkState(unsigned int backlogBytes, unsigned int capacityBytes)
+{
+    if(mEnableDBRC && mpDBRC != NULL)
+    {
+        return mpDBRC->SetNetworkSinkState(backlogBytes, capacityBytes);
+    }
+    else
+    {
+        return NO_INIT;
+    }
+}
+
 void EyeseeRecorder::notify(MPP_CHN_S *pChn, MPP_EVENT_TYPE event, void *pEventData)
 {
     if(MOD_ID_AI == pChn->mModId)
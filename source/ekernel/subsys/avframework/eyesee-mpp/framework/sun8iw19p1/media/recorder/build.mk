@@ -7,7 +7,8 @@ TARGET_SRC := \
     CameraFrameManager.cpp \
     EyeseeRecorder.cpp \
     MediaCallbackDispatcher.cpp \
-    DynamicBitRateControl.cpp
+    DynamicBitRateControl.cpp \
+    BitRateController.cpp
 
 TARGET_INC := \
     $(TARGET_TOP)/system/public/include \
@@ -13,7 +13,8 @@ SRCCS := \
     CameraFrameManager.cpp \
     EyeseeRecorder.cpp \
     MediaCallbackDispatcher.cpp \
-    DynamicBitRateControl.cpp
+    DynamicBitRateControl.cpp \
+    BitRateController.cpp
 
 #include directories
 INCLUDE_DIRS := \
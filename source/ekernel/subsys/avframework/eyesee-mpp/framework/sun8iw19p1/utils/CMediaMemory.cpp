@@ -26,11 +26,15 @@ CMediaMemory::CMediaMemory()
 {
     pMem = NULL;
     mSize = 0;
+    mpGather = NULL;
+    mPackNum = 0;
     //alogv("default construct this=%p", this);
 }
 
 CMediaMemory::CMediaMemory(int size)
 {
+    mpGather = NULL;
+    mPackNum = 0;
     if(size > 0)
     {
         pMem = malloc(size);
@@ -52,14 +56,25 @@ CMediaMemory::CMediaMemory(int size)
     //alogv("construct this=%p, mem=%p, size=%d", this, pMem, mSize);
 }
 
+CMediaMemory::CMediaMemory(void *pBorrowed, int size, const ReleaseCallback& onRelease)
+    : pMem(pBorrowed)
+    , mSize(size)
+    , mOnRelease(onRelease)
+{
+    mpGather = NULL;
+    mPackNum = 0;
+}
+
 //copy constructor
 CMediaMemory::CMediaMemory(const CMediaMemory& ref)
 {
-    if(ref.mSize > 0)
+    mpGather = NULL;
+    mPackNum = 0;
+    if(ref.getSize() > 0)
     {
-        mSize = ref.mSize;
+        mSize = ref.getSize();
         pMem = malloc(mSize);
-        memcpy(pMem, ref.pMem, mSize);
+        ref.copyTo(pMem, mSize);
     }
     else
     {
@@ -72,16 +87,16 @@ CMediaMemory::CMediaMemory(const CMediaMemory& ref)
 //copy assignment
 CMediaMemory& CMediaMemory::operator= (const CMediaMemory& ref)
 {
-    if(ref.mSize > 0)
+    if(this == &ref)
     {
-        mSize = ref.mSize;
-        pMem = malloc(mSize);
-        memcpy(pMem, ref.pMem, mSize);
+        return *this;
     }
-    else
+    release();
+    if(ref.getSize() > 0)
     {
-        pMem = NULL;
-        mSize = 0;
+        mSize = ref.getSize();
+        pMem = malloc(mSize);
+        ref.copyTo(pMem, mSize);
     }
     alogw("Be careful! please avoid copy assignment this=%p, mem=%p, size=%d", this, pMem, mSize);
     return *this;
@@ -90,34 +105,187 @@ CMediaMemory& CMediaMemory::operator= (const CMediaMemory& ref)
 //move constructor
 CMediaMemory::CMediaMemory(CMediaMemory&& rRef)
 {
-    pMem = rRef.pMem;
-    mSize = rRef.mSize;
-    rRef.pMem = NULL;
-    rRef.mSize = 0;
+    moveFrom(rRef);
     //alogv("move construct this=%p, mem=%p, size=%d", this, pMem, mSize);
 }
 
 //move assignment
 CMediaMemory& CMediaMemory::operator=(CMediaMemory&& rRef)
 {
-    std::swap(pMem, rRef.pMem);
-    std::swap(mSize, rRef.mSize);
-    //alogv("move assignment this=%p: after swap: mem=%p, size=%d, rRef mem=%p, size=%d", this, pMem, mSize, rRef.pMem, rRef.mSize);
+    if(this != &rRef)
+    {
+        release();
+        moveFrom(rRef);
+    }
+    //alogv("move assignment this=%p: mem=%p, size=%d", this, pMem, mSize);
     return *this;
 }
 
 CMediaMemory::~CMediaMemory()
 {
-    if(pMem)
+    release();
+    //alogv("destructor this=%p: mem=%p, size=%d", this, pMem, mSize);
+}
+
+void CMediaMemory::release()
+{
+    if(mOnRelease)
+    {
+        mOnRelease();
+        mOnRelease = nullptr;
+    }
+    else if(pMem)
     {
         free(pMem);
     }
-    //alogv("destructor this=%p: mem=%p, size=%d", this, pMem, mSize);
+    if(mpGather)
+    {
+        free(mpGather);
+    }
+    for(std::vector<void*>::iterator it = mPackCopies.begin(); it != mPackCopies.end(); ++it)
+    {
+        free(*it);
+    }
+    mPackCopies.clear();
+    pMem = NULL;
+    mSize = 0;
+    mpGather = NULL;
+    mPackNum = 0;
+}
+
+void CMediaMemory::moveFrom(CMediaMemory& rRef)
+{
+    pMem = rRef.pMem;
+    mSize = rRef.mSize;
+    mOnRelease = std::move(rRef.mOnRelease);
+    mpGather = rRef.mpGather;
+    mPackNum = rRef.mPackNum;
+    memcpy(mpPacks, rRef.mpPacks, sizeof(mpPacks));
+    memcpy(mPackSizes, rRef.mPackSizes, sizeof(mPackSizes));
+    mPackCopies.swap(rRef.mPackCopies);
+    rRef.pMem = NULL;
+    rRef.mSize = 0;
+    rRef.mOnRelease = nullptr;
+    rRef.mpGather = NULL;
+    rRef.mPackNum = 0;
+}
+
+int CMediaMemory::addPack(const void *pData, int size)
+{
+    if(pMem != NULL || mpGather != NULL)
+    {
+        aloge("fatal error! only a view which is not gathered can get packs");
+        return -1;
+    }
+    if(size <= 0)
+    {
+        return 0;
+    }
+    if(mPackNum >= MAX_PACK_NUM)
+    {
+        aloge("fatal error! too many packs[%d]", mPackNum);
+        return -1;
+    }
+    mpPacks[mPackNum] = pData;
+    mPackSizes[mPackNum] = size;
+    mPackNum++;
+    mSize += size;
+    return 0;
+}
+
+int CMediaMemory::addPackCopy(const void *pData, int size)
+{
+    if(size <= 0)
+    {
+        return 0;
+    }
+    void *pCopy = malloc(size);
+    if(NULL == pCopy)
+    {
+        aloge("malloc size[%d] fail", size);
+        return -1;
+    }
+    memcpy(pCopy, pData, size);
+    if(addPack(pCopy, size) != 0)
+    {
+        free(pCopy);
+        return -1;
+    }
+    mPackCopies.push_back(pCopy);
+    return 0;
+}
+
+void CMediaMemory::setReleaseCallback(const ReleaseCallback& onRelease)
+{
+    mOnRelease = onRelease;
+}
+
+int CMediaMemory::getPackCount() const
+{
+    if(mPackNum > 0)
+    {
+        return mPackNum;
+    }
+    return pMem != NULL ? 1 : 0;
+}
+
+const void* CMediaMemory::getPack(int index, int *pSize) const
+{
+    if(0 == mPackNum && 0 == index && pMem != NULL)
+    {
+        *pSize = mSize;
+        return pMem;
+    }
+    if(index < 0 || index >= mPackNum)
+    {
+        *pSize = 0;
+        return NULL;
+    }
+    *pSize = mPackSizes[index];
+    return mpPacks[index];
+}
+
+int CMediaMemory::copyTo(void *pDst, int size) const
+{
+    char *p = (char*)pDst;
+    int nLeft = size;
+    int nPackNum = getPackCount();
+    for(int i = 0; i < nPackNum && nLeft > 0; i++)
+    {
+        int nPackSize;
+        const void *pPack = getPack(i, &nPackSize);
+        if(nPackSize > nLeft)
+        {
+            nPackSize = nLeft;
+        }
+        memcpy(p, pPack, nPackSize);
+        p += nPackSize;
+        nLeft -= nPackSize;
+    }
+    return size - nLeft;
 }
 
 void* CMediaMemory::getPointer() const
 {
-    return pMem;
+    if(0 == mPackNum)
+    {
+        return pMem;
+    }
+    if(1 == mPackNum)
+    {
+        return const_cast<void*>(mpPacks[0]);
+    }
+    if(NULL == mpGather)
+    {
+        mpGather = malloc(mSize);
+        if(NULL == mpGather)
+        {
+            aloge("malloc size[%d] fail", mSize);
+            return NULL;
+        }
+        copyTo(mpGather, mSize);
+    }
+    return mpGather;
 }
 
 int CMediaMemory::getSize() const
@@ -125,5 +293,83 @@ int CMediaMemory::getSize() const
     return mSize;
 }
 
-}; /* namespace EyeseeLinux */
+CMediaMemoryPool::CMediaMemoryPool(int maxIdleNum)
+    : mMaxIdleNum(maxIdleNum)
+{
+}
 
+CMediaMemoryPool::~CMediaMemoryPool()
+{
+    trim();
+}
+
+std::shared_ptr<CMediaMemory> CMediaMemoryPool::obtain(int size)
+{
+    void *pMem = NULL;
+    int capacity = size;
+    {
+        AutoMutex lock(mLock);
+        std::vector<IdleBlock>::iterator best = mIdleBlocks.end();
+        for(std::vector<IdleBlock>::iterator it = mIdleBlocks.begin(); it != mIdleBlocks.end(); ++it)
+        {
+            if(it->mCapacity >= size && (best == mIdleBlocks.end() || it->mCapacity < best->mCapacity))
+            {
+                best = it;
+            }
+        }
+        if(best != mIdleBlocks.end())
+        {
+            pMem = best->mpMem;
+            capacity = best->mCapacity;
+            mIdleBlocks.erase(best);
+        }
+    }
+    if(NULL == pMem)
+    {
+        pMem = malloc(size);
+        if(NULL == pMem)
+        {
+            aloge("malloc size[%d] fail", size);
+            return std::make_shared<CMediaMemory>();
+        }
+    }
+    std::weak_ptr<CMediaMemoryPool> wpPool(shared_from_this());
+    return std::make_shared<CMediaMemory>(pMem, size, [wpPool, pMem, capacity]()
+        {
+            std::shared_ptr<CMediaMemoryPool> spPool = wpPool.lock();
+            if(spPool)
+            {
+                spPool->recycle(pMem, capacity);
+            }
+            else
+            {
+                free(pMem);
+            }
+        });
+}
+
+void CMediaMemoryPool::recycle(void *pMem, int capacity)
+{
+    AutoMutex lock(mLock);
+    if((int)mIdleBlocks.size() < mMaxIdleNum)
+    {
+        IdleBlock block = {pMem, capacity};
+        mIdleBlocks.push_back(block);
+    }
+    else
+    {
+        free(pMem);
+    }
+}
+
+void CMediaMemoryPool::trim()
+{
+    AutoMutex lock(mLock);
+    for(std::vector<IdleBlock>::iterator it = mIdleBlocks.begin(); it != mIdleBlocks.end(); ++it)
+    {
+        free(it->mpMem);
+    }
+    mIdleBlocks.clear();
+}
+
+}; /* namespace EyeseeLinux */
@@ -22,6 +22,8 @@
 
 #include <pthread.h>
 
+#include <utility>
+
 #include <CallbackDispatcher.h>
 
 
@@ -63,7 +65,16 @@ CallbackDispatcher::~CallbackDispatcher()
 void CallbackDispatcher::post(const CallbackMessage &msg)
 {
     Mutex::Autolock autoLock(mLock);
-    mQueue.push_back(msg);
+    //reuse an idle node, its extArgs keeps the capacity of former messages.
+    if(mIdleQueue.empty())
+    {
+        mQueue.push_back(msg);
+    }
+    else
+    {
+        mIdleQueue.front() = msg;
+        mQueue.splice(mQueue.end(), mIdleQueue, mIdleQueue.begin());
+    }
     mQueueChanged.signal();
 }
 
@@ -74,9 +85,9 @@ void CallbackDispatcher::dispatch(const CallbackMessage &msg)
 
 bool CallbackDispatcher::loop()
 {
+    CallbackMessage msg;
     for(;;)
     {
-        CallbackMessage msg;
         {
             Mutex::Autolock autoLock(mLock);
             while (!mbDone && mQueue.empty())
@@ -87,10 +98,21 @@ bool CallbackDispatcher::loop()
             {
                 break;
             }
-            msg = mQueue.front();
-            mQueue.pop_front();
+            //swap instead of copy, then keep the node for post(). the data of
+            //the message must not be held by an idle node.
+            std::swap(msg, mQueue.front());
+            if(mIdleQueue.size() < IdleNum_MAX)
+            {
+                mQueue.front().mDataPtr.reset();
+                mIdleQueue.splice(mIdleQueue.end(), mQueue, mQueue.begin());
+            }
+            else
+            {
+                mQueue.pop_front();
+            }
         }
         dispatch(msg);
+        msg.mDataPtr.reset();
     }
     return false;
 }
@@ -20,7 +20,7 @@
 #include <string.h>
 #include <Errors.h>
 
-#include <algorithm>
+#include <utility>
 #include "EyeseeMessageQueue.h"
 
 namespace EyeseeLinux {
@@ -30,7 +30,10 @@ status_t EyeseeMessage::setData(char* pData, int nDataSize)
     if(mpData)
     {
         aloge("fatal error! need free mpData[%p]!", mpData);
-        free(mpData);
+        if(!isInlineData())
+        {
+            free(mpData);
+        }
         mpData = NULL;
         mDataSize = 0;
     }
@@ -38,10 +41,18 @@ status_t EyeseeMessage::setData(char* pData, int nDataSize)
     {
         return NO_ERROR;
     }
-    mpData = malloc(nDataSize);
-    if(NULL == mpData)
+    if(nDataSize <= EYESEE_MESSAGE_INLINE_DATA_SIZE)
     {
-        aloge("fatal error! malloc fail!");
+        mpData = mInlineData;
+    }
+    else
+    {
+        mpData = malloc(nDataSize);
+        if(NULL == mpData)
+        {
+            aloge("fatal error! malloc fail!");
+            return NO_MEMORY;
+        }
     }
     memcpy(mpData, pData, nDataSize);
     mDataSize = nDataSize;
@@ -65,56 +76,73 @@ status_t EyeseeMessage::reset()
 	mPara1 = 0;
     if(mpData!=NULL)
     {
-        free(mpData);
+        if(!isInlineData())
+        {
+            free(mpData);
+        }
         mpData = NULL;
     }
     mDataSize = 0;
     return NO_ERROR;
 }
 
-EyeseeMessage& EyeseeMessage::operator= (const EyeseeMessage& rhs)
+status_t EyeseeMessage::copyFrom(const EyeseeMessage& rhs)
 {
+    reset();
     mWhoseMsg = rhs.mWhoseMsg;
 	mMsgType = rhs.mMsgType;
 	mPara0 = rhs.mPara0;
 	mPara1 = rhs.mPara1;
     if(rhs.mpData!= NULL && rhs.mDataSize > 0)
     {
-        mpData = malloc(rhs.mDataSize);
-        if(mpData)
-        {
-            memcpy(mpData, rhs.mpData, rhs.mDataSize);
-            mDataSize = rhs.mDataSize;
-        }
-        else
-        {
-            aloge("fatal error! malloc fail[%s]!", strerror(errno));
-            mpData = NULL;
-            mDataSize = 0;
-        }
+        return setData((char*)rhs.mpData, rhs.mDataSize);
+    }
+    if(rhs.mpData!=NULL || rhs.mDataSize!=0)
+    {
+        aloge("fatal error! rhs EyeseeMessage wrong[%p][%d]!", rhs.mpData, rhs.mDataSize);
+    }
+    return NO_ERROR;
+}
+
+/**
+ * take rRef's content, a malloced payload is handed over, an inline one is copied.
+ * this must be empty.
+ */
+void EyeseeMessage::moveFrom(EyeseeMessage& rRef)
+{
+    mWhoseMsg = rRef.mWhoseMsg;
+	mMsgType = rRef.mMsgType;
+	mPara0 = rRef.mPara0;
+	mPara1 = rRef.mPara1;
+    if(rRef.isInlineData())
+    {
+        memcpy(mInlineData, rRef.mInlineData, rRef.mDataSize);
+        mpData = mInlineData;
     }
     else
     {
-        if(rhs.mpData!=NULL || rhs.mDataSize!=0)
-        {
-            aloge("fatal error! rhs EyeseeMessage wrong[%p][%d]!", rhs.mpData, rhs.mDataSize);
-        }
-        mpData = NULL;
-        mDataSize = 0;
+        mpData = rRef.mpData;
     }
+    mDataSize = rRef.mDataSize;
+    rRef.mpData = NULL;
+    rRef.mDataSize = 0;
+    rRef.reset();
+}
 
-    return *this; 
+EyeseeMessage::EyeseeMessage(EyeseeMessage&& rRef)
+{
+    mpData = NULL;
+    mDataSize = 0;
+    moveFrom(rRef);
 }
 
 EyeseeMessage& EyeseeMessage::operator=(EyeseeMessage&& rRef)
 {
-    //swap value
-    std::swap(mWhoseMsg, rRef.mWhoseMsg);
-    std::swap(mMsgType, rRef.mMsgType);
-    std::swap(mPara0, rRef.mPara0);
-    std::swap(mPara1, rRef.mPara1);
-    std::swap(mpData, rRef.mpData);
-    std::swap(mDataSize, rRef.mDataSize);
+    if(this != &rRef)
+    {
+        reset();
+        moveFrom(rRef);
+    }
     return *this;
 }
 
@@ -133,27 +161,57 @@ EyeseeMessage::~EyeseeMessage()
     reset();
 }
 
-EyeseeMessageQueue::EyeseeMessageQueue()
+EyeseeMessageQueue::EyeseeMessageQueue(int nCapacity)
 {
     mWaitMessageFlag = false;
+    if(nCapacity <= 0)
+    {
+        nCapacity = EYESEE_MESSAGE_QUEUE_DEFAULT_CAPACITY;
+    }
+    mpSlots = new EyeseeMessage[nCapacity];
+    mCapacity = nCapacity;
+    mHead = 0;
     mCount = 0;
 }
 
-status_t EyeseeMessageQueue::queueMessage(EyeseeMessage *pMsgIn)
+EyeseeMessageQueue::~EyeseeMessageQueue()
 {
-    Mutex::Autolock autoLock(mLock);
-    //find idle message
-    if(mIdleMessageList.empty())
+    delete[] mpSlots;
+}
+
+/**
+ * double the slots, keep the valid messages in order from slot 0.
+ */
+status_t EyeseeMessageQueue::grow_l()
+{
+    int nNewCapacity = mCapacity*2;
+    EyeseeMessage *pNewSlots = new EyeseeMessage[nNewCapacity];
+    for(int i = 0; i < mCount; i++)
     {
-        mIdleMessageList.resize(1);
-        mCount++;
-        if(mCount > 8)
-        {
-            aloge("fatal error! message count[%d] too many", mCount);
-        }
+        pNewSlots[i] = std::move(mpSlots[(mHead + i) % mCapacity]);
     }
-    *mIdleMessageList.begin() = *pMsgIn;
-    mValidMessageList.splice(mValidMessageList.end(), mIdleMessageList, mIdleMessageList.begin());
+    delete[] mpSlots;
+    mpSlots = pNewSlots;
+    mCapacity = nNewCapacity;
+    mHead = 0;
+    aloge("fatal error! message count[%d] too many, grow queue to [%d]", mCount + 1, mCapacity);
+    return NO_ERROR;
+}
+
+EyeseeMessage* EyeseeMessageQueue::getTailSlot_l()
+{
+    if(mCount >= mCapacity)
+    {
+        grow_l();
+    }
+    return &mpSlots[(mHead + mCount) % mCapacity];
+}
+
+status_t EyeseeMessageQueue::queueMessage(EyeseeMessage *pMsgIn)
+{
+    Mutex::Autolock autoLock(mLock);
+    getTailSlot_l()->copyFrom(*pMsgIn);
+    mCount++;
     if(mWaitMessageFlag)
     {
         mCondMessageQueueChanged.signal();
@@ -164,18 +222,8 @@ status_t EyeseeMessageQueue::queueMessage(EyeseeMessage *pMsgIn)
 status_t EyeseeMessageQueue::queueMessage(EyeseeMessage&& rRefMsgIn)
 {
     Mutex::Autolock autoLock(mLock);
-    //find idle message
-    if(mIdleMessageList.empty())
-    {
-        mIdleMessageList.resize(1);
-        mCount++;
-        if(mCount > 8)
-        {
-            aloge("fatal error! message count[%d] too many", mCount);
-        }
-    }
-    *mIdleMessageList.begin() = std::move(rRefMsgIn);
-    mValidMessageList.splice(mValidMessageList.end(), mIdleMessageList, mIdleMessageList.begin());
+    *getTailSlot_l() = std::move(rRefMsgIn);
+    mCount++;
     if(mWaitMessageFlag)
     {
         mCondMessageQueueChanged.signal();
@@ -196,38 +244,47 @@ Time: 2015/7/13
 status_t EyeseeMessageQueue::dequeueMessage(EyeseeMessage *pMsgOut)
 {
     Mutex::Autolock autoLock(mLock);
-    if(mValidMessageList.empty())
+    if(0 == mCount)
     {
         return NOT_ENOUGH_DATA;
     }
-    //pMsgOut->reset();
-    //*pMsgOut = *mValidMessageList.begin();
-    //mValidMessageList.begin()->reset();
-    *pMsgOut = std::move(*mValidMessageList.begin());
-    mIdleMessageList.splice(mIdleMessageList.end(), mValidMessageList, mValidMessageList.begin());
+    *pMsgOut = std::move(mpSlots[mHead]);
+    mHead = (mHead + 1) % mCapacity;
+    mCount--;
     return NO_ERROR;
 }
 
-status_t EyeseeMessageQueue::flushMessage()
+/*******************************************************************************
+Function name: android.EyeseeMessageQueue.dequeueMessages
+Description: 
+    dequeue up to nMaxNum messages under one lock, in order.
+Parameters: 
+    pMsgOut: array of nMaxNum messages.
+Return: 
+    return value is the number of dequeued messages, 0 if queue is empty.
+*******************************************************************************/
+int EyeseeMessageQueue::dequeueMessages(EyeseeMessage *pMsgOut, int nMaxNum)
 {
     Mutex::Autolock autoLock(mLock);
-    /*
-    for(std::list<EyeseeMessage>::iterator it = mValidMessageList.begin(); it != mValidMessageList.end(); ++it)
+    int nNum = mCount < nMaxNum ? mCount : nMaxNum;
+    for(int i = 0; i < nNum; i++)
     {
-        it->reset();
+        pMsgOut[i] = std::move(mpSlots[mHead]);
+        mHead = (mHead + 1) % mCapacity;
     }
-    */
-    /*
-    for(auto& i : mValidMessageList)
+    mCount -= nNum;
+    return nNum < 0 ? 0 : nNum;
+}
+
+status_t EyeseeMessageQueue::flushMessage()
+{
+    Mutex::Autolock autoLock(mLock);
+    for(int i = 0; i < mCount; i++)
     {
-        i.reset();
+        mpSlots[(mHead + i) % mCapacity].reset();
     }
-    */
-    std::for_each( std::begin(mValidMessageList), std::end(mValidMessageList), [](EyeseeMessage& i) {
-        i.reset();
-    } );
-    
-    mIdleMessageList.splice(mIdleMessageList.end(), mValidMessageList);
+    mHead = 0;
+    mCount = 0;
     return NO_ERROR;
 }
 /*******************************************************************************
@@ -243,21 +300,21 @@ Time: 2015/7/13
 int EyeseeMessageQueue::waitMessage(unsigned int timeout)
 {
     Mutex::Autolock autoLock(mLock);
-    if(!mValidMessageList.empty())
+    if(mCount > 0)
     {
-        return mValidMessageList.size();
+        return mCount;
     }
     mWaitMessageFlag = true;
     if(timeout<=0)
     {
-        while(mValidMessageList.empty())
+        while(0 == mCount)
         {
             mCondMessageQueueChanged.waitRelative(mLock, (int64_t)500*1000000);
         }
     }
     else
     {
-        if(mValidMessageList.empty())
+        if(0 == mCount)
         {
             status_t ret = mCondMessageQueueChanged.waitRelative(mLock, (int64_t)timeout*1000000);
             if(TIMED_OUT == ret)
@@ -274,13 +331,13 @@ int EyeseeMessageQueue::waitMessage(unsigned int timeout)
         }
     }
     mWaitMessageFlag = false;
-    return mValidMessageList.size();
+    return mCount;
 }
 
 int EyeseeMessageQueue::getMessageCount()
 {
     Mutex::Autolock autoLock(mLock);
-    return (int)mValidMessageList.size();
+    return mCount;
 }
 
 };
@@ -33,6 +33,9 @@
 #config if include libmpp_uvc.so
 ##MPPCFG_UVC := N
 
+#config if include librtsp_server.so
+##MPPCFG_RTSP_SERVER := N
+
 #prebuild all AI libs and component by static
 ##MPPCFG_COMPILE_STATIC_LIB := Y
 #build component to dynamic so if possible
@@ -238,6 +241,10 @@ ifeq ($(MPPCFG_UVC),Y)
   CEDARX_EXT_CFLAGS += -DMPPCFG_UVC
 endif
 
+ifeq ($(MPPCFG_RTSP_SERVER),Y)
+  CEDARX_EXT_CFLAGS += -DMPPCFG_RTSP_SERVER
+endif
+
 ifeq ($(MPPCFG_USE_IOMMU),Y)
   export USE_IOMMU := true#for libcedarc
 endif
@@ -106,6 +106,8 @@ typedef struct ShutDownType
 #define ERR_MUX_NOMEM             DEF_ERR(MOD_ID_MUX, EN_ERR_LEVEL_ERROR, EN_ERR_NOMEM)
 /* failure caused by malloc buffer */
 #define ERR_MUX_NOBUF             DEF_ERR(MOD_ID_MUX, EN_ERR_LEVEL_ERROR, EN_ERR_NOBUF)
+/* no data in buffer, eg, no complete gop cached */
+#define ERR_MUX_BUF_EMPTY         DEF_ERR(MOD_ID_MUX, EN_ERR_LEVEL_ERROR, EN_ERR_BUF_EMPTY)
 /* system is not ready,had not initialed or loaded*/
 #define ERR_MUX_SYS_NOTREADY      DEF_ERR(MOD_ID_MUX, EN_ERR_LEVEL_ERROR, EN_ERR_SYS_NOTREADY)
 /*system busy*/
@@ -43,6 +43,37 @@ typedef struct MppBindControl {
 
 typedef fd_set handle_set;
 
+/* pipeline stages a video frame is traced through, see AW_MPI_SYS_GetFrameTraceStat() */
+typedef enum MPP_FRAMETRACE_STAGE_E
+{
+    MPP_FRAMETRACE_STAGE_VI = 0,    //capture, the time every other stage is measured from
+    MPP_FRAMETRACE_STAGE_ISE,
+    MPP_FRAMETRACE_STAGE_EIS,
+    MPP_FRAMETRACE_STAGE_VENC,
+    MPP_FRAMETRACE_STAGE_RECRENDER, //encoded frame received until a muxer takes it
+    MPP_FRAMETRACE_STAGE_MUXER,
+    MPP_FRAMETRACE_STAGE_RTSP,      //frame given to the rtsp server until sent to all its clients
+    MPP_FRAMETRACE_STAGE_MAX,
+} MPP_FRAMETRACE_STAGE_E;
+
+/* bin 0 counts latencies below MPP_FRAMETRACE_HIST_UNIT_US, bin i below UNIT<<i, the last one the rest */
+#define MPP_FRAMETRACE_HIST_BINS        (16)
+#define MPP_FRAMETRACE_HIST_UNIT_US     (250)
+
+typedef struct MPP_FRAMETRACE_STAT_S
+{
+    unsigned int mFrameCnt;     //frames which left the stage
+    unsigned int mLostCnt;      //frames which entered and were never seen again
+    unsigned int mDropCnt;      //frames which failed or were skipped in the stage, not in the latencies
+    uint64_t mTotalLatencyUs;   //time in the stage, enter to exit
+    unsigned int mMaxLatencyUs;
+    unsigned int mLatencyHist[MPP_FRAMETRACE_HIST_BINS];
+    uint64_t mTotalCaptureLatencyUs;    //capture to exit of the stage
+    unsigned int mMaxCaptureLatencyUs;
+    unsigned int mCaptureLatencyHist[MPP_FRAMETRACE_HIST_BINS];
+    unsigned int mQueueDepthHist[MPP_FRAMETRACE_HIST_BINS];    //frames queued in the stage when one entered, the last bin counts more
+} MPP_FRAMETRACE_STAT_S;
+
 #define ERR_SYS_NULL_PTR         DEF_ERR(MOD_ID_SYS, EN_ERR_LEVEL_ERROR, EN_ERR_NULL_PTR)
 #define ERR_SYS_NOTREADY         DEF_ERR(MOD_ID_SYS, EN_ERR_LEVEL_ERROR, EN_ERR_SYS_NOTREADY)
 #define ERR_SYS_NOT_PERM         DEF_ERR(MOD_ID_SYS, EN_ERR_LEVEL_ERROR, EN_ERR_NOT_PERM)
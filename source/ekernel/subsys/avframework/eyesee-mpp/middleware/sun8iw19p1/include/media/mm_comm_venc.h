@@ -450,6 +450,27 @@ typedef struct VENC_CHN_STAT_S
     unsigned int mLeftEncPics;                          /*Number of frames to be encoded. This member is valid after AW_MPI_VENC_StartRecvPicEx is called.*/
 }VENC_CHN_STAT_S;
 
+#define VENC_FRAME_SIZE_HISTORY_NUM (64)
+
+typedef struct VENC_FRAME_SIZE_S
+{
+    int64_t mPts;                                       /*unit:us*/
+    unsigned int mSize;                                 /*encoded bytes of the frame*/
+    BOOL mbKeyFrame;
+}VENC_FRAME_SIZE_S;
+
+/* sizes of the frames encoded since the frame mSeq, the oldest first. The
+ * caller passes back the mSeq returned by the previous call to get the
+ * following frames, 0 the first time.
+ */
+typedef struct VENC_FRAME_SIZE_HISTORY_S
+{
+    unsigned int mSeq;                                  /*in: first frame wanted, out: next frame to ask*/
+    unsigned int mNum;                                  /*out: frames in mFrames*/
+    unsigned int mLost;                                 /*out: frames encoded but overwritten before being asked*/
+    VENC_FRAME_SIZE_S mFrames[VENC_FRAME_SIZE_HISTORY_NUM];
+}VENC_FRAME_SIZE_HISTORY_S;
+
 typedef struct VENC_PARAM_H264_SLICE_SPLIT_S
 {
     BOOL mbSplitEnable;                           /*slice split enable, TRUE:enable, FALSE:diable, default value:FALSE*/
@@ -93,6 +93,16 @@ ERRORTYPE AW_MPI_SYS_HANDLE_SET(int handle, handle_set *pHandleSet);
 ERRORTYPE AW_MPI_SYS_HANDLE_ISSET(int handle, handle_set *pHandleSet);
 ERRORTYPE AW_MPI_SYS_HANDLE_Select(handle_set *pRdFds, int nMilliSecs);
 
+/*
+** Frame latency tracing, needs mpp_frametrace in the config. Frames are tagged
+** with their capture pts and every stage records when they enter and leave it.
+** Enable clears the statistics and the event log; the log holds the latest
+** events and is dumped as Chrome/Perfetto trace JSON.
+*/
+ERRORTYPE AW_MPI_SYS_EnableFrameTrace(BOOL bEnable);
+ERRORTYPE AW_MPI_SYS_GetFrameTraceStat(MPP_FRAMETRACE_STAGE_E eStage, MPP_FRAMETRACE_STAT_S* pStat);
+ERRORTYPE AW_MPI_SYS_DumpFrameTrace(const char* pFilePath);
+
 #ifdef __cplusplus
 }
 #endif /* End of #ifdef __cplusplus */
@@ -43,6 +43,7 @@ ERRORTYPE AW_MPI_VENC_StartRecvPicEx(VENC_CHN VeChn, VENC_RECV_PIC_PARAM_S *pRec
 ERRORTYPE AW_MPI_VENC_StopRecvPic(VENC_CHN VeChn);
 
 ERRORTYPE AW_MPI_VENC_Query(VENC_CHN VeChn, VENC_CHN_STAT_S *pStat);
+ERRORTYPE AW_MPI_VENC_GetFrameSizeHistory(VENC_CHN VeChn, VENC_FRAME_SIZE_HISTORY_S *pHistory);
 ERRORTYPE AW_MPI_VENC_RegisterCallback(VENC_CHN VeChn, MPPCallbackInfo *pCallback);
 
 ERRORTYPE AW_MPI_VENC_SetChnAttr(VENC_CHN VeChn, const VENC_CHN_ATTR_S *pAttr);
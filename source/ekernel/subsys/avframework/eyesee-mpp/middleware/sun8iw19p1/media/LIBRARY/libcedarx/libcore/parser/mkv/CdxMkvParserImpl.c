@@ -4311,6 +4311,34 @@ cdx_int32 matroska_read_packet (struct CdxMkvParser *p)
     return 0;
 }
 
+/************************************************************************/
+/*  Binary search of the index entries built from the Cues, which are   */
+/*  sorted by time: return the first entry whose timestamp is greater   */
+/*  than ms (bAfter=1) or not less than ms (bAfter=0), or               */
+/*  nb_index_entries if there is none.                                  */
+/************************************************************************/
+static cdx_int32 matroska_search_index(AVStream *st, cdx_int64 ms, cdx_int32 bAfter)
+{
+    cdx_int32 lo = 0;
+    cdx_int32 hi = st->nb_index_entries;
+
+    while(lo < hi)
+    {
+        cdx_int32 mid = lo + (hi - lo) / 2;
+        cdx_int64 timestamp = st->index_entries[mid].timestamp;
+
+        if(timestamp < ms || (bAfter && timestamp == ms))
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
 /************************************************************************/
 /*  Find from current pos's nearest keyframe index                      */
 /************************************************************************/
@@ -4332,19 +4360,15 @@ cdx_int32 matroska_find_keyframe(struct CdxMkvParser *p,
     {
         if(!direction)
         {
-            for(index=0; index<st->nb_index_entries-1; index++)
-            {
-                if(st->index_entries[index].timestamp >= ms)
-                    break;
-            }
+            //* first keyframe at or after ms, else the last one
+            index = matroska_search_index(st, ms, 0);
+            if(index > st->nb_index_entries-1)
+                index = st->nb_index_entries-1;
         }
         else
         {
-            for(index=st->nb_index_entries-1; index>=0; index--)
-            {
-                if(st->index_entries[index].timestamp <= ms)
-                    break;
-            }
+            //* last keyframe at or before ms
+            index = matroska_search_index(st, ms, 1) - 1;
         }
 
         // find index entry
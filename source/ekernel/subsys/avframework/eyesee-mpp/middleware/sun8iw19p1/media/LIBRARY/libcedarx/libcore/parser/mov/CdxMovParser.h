@@ -223,6 +223,22 @@ typedef struct MOVSidx
     CDX_U32        size;
 } MOVSidx;
 
+//seek index point, one every MOV_SEEK_INDEX_STEP samples of the video track,
+//it keeps where the stts/stsc/stss/ctts walks are at that sample
+typedef struct MovSeekPoint
+{
+    CDX_U64            dts;                //dts of the sample
+    CDX_U64            stts_duration_acc;  //dts of the first sample of the stts entry
+    CDX_U32            sample;             //sample index, 0..x
+    CDX_U32            stts_idx;           //stts entry holding the sample
+    CDX_U32            stts_samples_acc;   //samples before that stts entry
+    CDX_U32            stsc_idx;           //stsc entry holding the sample
+    CDX_S32            stsc_samples_acc;   //samples before that stsc entry
+    CDX_S32            stss_idx;           //key frames before the sample
+    CDX_S32            ctts_idx;           //ctts entry holding the sample
+    CDX_S32            ctts_samples_acc;   //samples before that ctts entry
+} MovSeekPoint;
+
 typedef struct Mov_Index_Context_Extend
 {
     CDX_U32            chunk_idx;
@@ -332,6 +348,11 @@ typedef struct MOVStreamContext
     unsigned int rap_group_count;
     unsigned int rap_seek_count;
     int          *rap_seek;
+
+    // seek index of the video stream, built on the first seek
+    MovSeekPoint *seek_index;
+    CDX_U32      seek_index_count;
+    int          seek_index_state;   // 0: not built, 1: built, -1: cannot build
 } MOVStreamContext;
 
 typedef struct Mov_Index_Context
@@ -190,6 +190,11 @@ CDX_S16 CdxMovClose(struct CdxMovParser *p)
                     free(c->streams[i]->rap_seek);
                     c->streams[i]->rap_seek = NULL;
                 }
+                if(c->streams[i]->seek_index)
+                {
+                    free(c->streams[i]->seek_index);
+                    c->streams[i]->seek_index = NULL;
+                }
                 free(c->streams[i]);
                 c->streams[i] = 0;
             }
@@ -175,6 +175,180 @@ static int getMin(CDX_U64* offset, int idx)
     return ret;
 }
 
+//samples from stsc entry stsc_idx to the next one, as locatingStsc() counts them
+static CDX_S32 movStscSamples(MOVContext *c, MOVStreamContext *st, CDX_U32 stsc_idx)
+{
+    CDX_U32 idx = stsc_idx * 12;
+
+    if(stsc_idx + 1 >= st->stsc_size)
+        return 0x7ffffff;
+
+    return (readStsc(c, st, idx+12) - readStsc(c, st, idx)) * readStsc(c, st, idx+4);
+}
+
+/*
+*  seek index of the video track
+*  the seek walks below read stts/stsc/stss/ctts from the first entry on every
+*  seek. A point every MOV_SEEK_INDEX_STEP samples keeps where each walk is at
+*  that sample, so they start from the nearest point and give the same result.
+*  It is built on the first seek; if it cannot be built (no memory, negative
+*  durations, unsorted stss) the walks start from the first entry as before.
+*/
+static CDX_S32 movBuildSeekIndex(struct CdxMovParser *p, MOVStreamContext *st)
+{
+    MOVContext      *c;
+    MovSeekPoint    *pt;
+    CDX_U64         samples = 0;
+    CDX_U32         count;
+    CDX_U32         sample;
+    CDX_U32         i;
+    CDX_U32         keyframe_num, prev_keyframe_num = 0;
+    CDX_U32         stts_idx = 0, stts_samples_acc = 0;
+    CDX_U64         stts_duration_acc = 0;
+    CDX_S32         stts_sample_count, stts_sample_duration;
+    CDX_U32         stsc_idx = 0;
+    CDX_S32         stsc_samples_acc = 0, samples_in_chunks;
+    CDX_S32         stss_idx = 0;
+    CDX_S32         ctts_idx = 0, ctts_samples_acc = 0;
+
+    c = (MOVContext*)p->privData;
+
+    if(st->seek_index_state != 0)
+        return 0;
+
+    //the points are found by dts and by key frame number, both must only grow
+    for(i = 0; i < st->stts_size; i++)
+    {
+        if((CDX_S32)readStts(c, st, (i<<3)+4) < 0)
+            break;
+        samples += readStts(c, st, i<<3);
+    }
+    for(keyframe_num = 0; keyframe_num < st->stss_size; keyframe_num++)
+    {
+        if(ReadStss(c, st, keyframe_num<<2) < prev_keyframe_num)
+            break;
+        prev_keyframe_num = ReadStss(c, st, keyframe_num<<2);
+    }
+    if(i < st->stts_size || keyframe_num < st->stss_size || samples == 0 || samples > INT_MAX)
+    {
+        CDX_LOGD("no seek index, stts %u stss %u samples %llu", st->stts_size, st->stss_size,
+                 samples);
+        st->seek_index_state = -1;
+        return 0;
+    }
+
+    count = ((CDX_U32)samples + MOV_SEEK_INDEX_STEP - 1) / MOV_SEEK_INDEX_STEP;
+    pt = (MovSeekPoint *)malloc(count * sizeof(MovSeekPoint));
+    if(pt == NULL)
+    {
+        CDX_LOGW("malloc seek index of %u points failed", count);
+        st->seek_index_state = -1;
+        return 0;
+    }
+
+    stts_sample_count    = readStts(c, st, 0);
+    stts_sample_duration = readStts(c, st, 4);
+    samples_in_chunks    = movStscSamples(c, st, 0);
+    for(i = 0; i < count; i++)
+    {
+        if(p->exitFlag)
+        {
+            free(pt);
+            return -1;
+        }
+        sample = i * MOV_SEEK_INDEX_STEP;
+
+        //the stts entry holding the sample, where locatingStts() stops
+        while(sample >= stts_samples_acc + stts_sample_count)
+        {
+            stts_samples_acc += stts_sample_count;
+            stts_duration_acc += (CDX_U64)stts_sample_count * stts_sample_duration;
+            stts_idx++;
+            stts_sample_count    = readStts(c, st, stts_idx<<3);
+            stts_sample_duration = readStts(c, st, (stts_idx<<3)+4);
+        }
+
+        //the stsc entry holding the sample, where locatingStsc() stops
+        while((CDX_S32)sample > stsc_samples_acc + samples_in_chunks - 1 &&
+            stsc_idx + 1 <= st->stsc_size)
+        {
+            stsc_samples_acc += samples_in_chunks;
+            stsc_idx++;
+            samples_in_chunks = movStscSamples(c, st, stsc_idx);
+        }
+
+        //key frames before the sample, stss counts samples from 1
+        while(stss_idx < (CDX_S32)st->stss_size && ReadStss(c, st, stss_idx<<2) < sample)
+        {
+            stss_idx++;
+        }
+
+        //the ctts entry holding the sample, where MovSeekSample() stops
+        while(st->ctts_data && ctts_idx < st->ctts_size &&
+            ctts_samples_acc + st->ctts_data[ctts_idx].count <= (CDX_S32)sample)
+        {
+            ctts_samples_acc += st->ctts_data[ctts_idx].count;
+            ctts_idx++;
+        }
+
+        pt[i].sample = sample;
+        pt[i].dts = stts_duration_acc +
+            (CDX_U64)stts_sample_duration * (sample - stts_samples_acc);
+        pt[i].stts_idx = stts_idx;
+        pt[i].stts_samples_acc = stts_samples_acc;
+        pt[i].stts_duration_acc = stts_duration_acc;
+        pt[i].stsc_idx = stsc_idx;
+        pt[i].stsc_samples_acc = stsc_samples_acc;
+        pt[i].stss_idx = stss_idx;
+        pt[i].ctts_idx = ctts_idx;
+        pt[i].ctts_samples_acc = ctts_samples_acc;
+    }
+
+    st->seek_index = pt;
+    st->seek_index_count = count;
+    st->seek_index_state = 1;
+    CDX_LOGD("seek index: %u points for %u samples", count, (CDX_U32)samples);
+
+    return 0;
+}
+
+//the last point at or before the sample
+static MovSeekPoint *movSeekPointOfSample(MOVStreamContext *st, CDX_U32 sample)
+{
+    CDX_U32 i;
+
+    if(st->seek_index == NULL)
+        return NULL;
+
+    i = sample / MOV_SEEK_INDEX_STEP;
+    if(i >= st->seek_index_count)
+        i = st->seek_index_count - 1;
+
+    return &st->seek_index[i];
+}
+
+//the last point with a dts not after dts, the first point is at dts 0
+static MovSeekPoint *movSeekPointOfDts(MOVStreamContext *st, CDX_U64 dts)
+{
+    CDX_U32 low, high, mid;
+
+    if(st->seek_index == NULL)
+        return NULL;
+
+    low = 0;
+    high = st->seek_index_count;
+    while(low < high)
+    {
+        mid = (low+high)>>1;
+        if(st->seek_index[mid].dts <= dts)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return &st->seek_index[low > 0 ? low-1 : 0];
+}
+
 static CDX_S32 locatingStts(struct CdxMovParser *p,MOVStreamContext* st)
 {
     CDX_S32 stts_sample_count;
@@ -372,6 +546,7 @@ static CDX_S32 movTimeToSample(struct CdxMovParser *p, cdx_int64 seconds)
     CDX_S32   stream_idx;
     CDX_S32   idx;
     CDX_U32   stts_idx;
+    MovSeekPoint *pt;
 
     c = (MOVContext*)p->privData;
 
@@ -379,8 +554,15 @@ static CDX_S32 movTimeToSample(struct CdxMovParser *p, cdx_int64 seconds)
     time_scale = c->streams[stream_idx]->time_scale;
     duration_seek = (CDX_U64)time_scale * seconds/1000;
 
-    //look up from video stts table
+    //look up from video stts table, from the nearest seek point before
     stts_idx = 0;
+    pt = movSeekPointOfDts(c->streams[stream_idx], duration_seek);
+    if(pt)
+    {
+        stts_idx = pt->stts_idx;
+        sample_count_acc = pt->stts_samples_acc;
+        duration_acc = pt->stts_duration_acc;
+    }
 
     while(1)
     { //modify 20090327 night
@@ -426,7 +608,7 @@ static CDX_S32 movTimeToSampleSidx(struct CdxMovParser *p, int seconds, int stre
     CDX_UNUSE(type);
 
     MOVSidx* sidx = s->sidx_buffer;
-    int i = 0;
+    int low, high, mid;
 
     CDX_U32 time_scale = s->streams[stream_index]->time_scale;
     CDX_U64 time = (CDX_U64)seconds * time_scale / 1000;
@@ -443,17 +625,25 @@ static CDX_S32 movTimeToSampleSidx(struct CdxMovParser *p, int seconds, int stre
         CDX_LOGW("--- sidx is NULL, cannot seek");
         return 0;
     }
-    for(i=0; i<s->sidx_count; i++)
+    //the last segment starting before the time, segments are in time order
+    low = 0;
+    high = s->sidx_count;
+    while(low < high)
     {
-        if(sidx[i].current_dts <= time)
+        mid = (low+high)>>1;
+        if(sidx[mid].current_dts <= time)
         {
-            sidx_idx = i;
+            low = mid + 1;
         }
         else
         {
-            break;
+            high = mid;
         }
     }
+    if(low > 0)
+    {
+        sidx_idx = low - 1;
+    }
     s->streams[stream_index]->mov_idx_curr.current_dts = sidx[sidx_idx].current_dts;
     //reset the audio pts
 
@@ -474,10 +664,18 @@ CDX_U64 calcCurrentTime(struct CdxMovParser *p,MOVStreamContext* st,CDX_U32 curr
     CDX_S32       stts_sample_count;
     CDX_S32       stts_sample_duration;
     CDX_S32       idx;
+    MovSeekPoint  *pt;
 
     st->mov_idx_curr.stts_idx = 0;
     st->mov_idx_curr.stts_samples_acc = 0;
     st->mov_idx_curr.stts_duration_acc = 0;
+    pt = movSeekPointOfSample(st, curr_sample_idx);
+    if(pt)
+    {
+        st->mov_idx_curr.stts_idx = pt->stts_idx;
+        st->mov_idx_curr.stts_samples_acc = pt->stts_samples_acc;
+        st->mov_idx_curr.stts_duration_acc = pt->stts_duration_acc;
+    }
     MOVContext    *c;
     c = (MOVContext*)p->privData;
 
@@ -536,6 +734,7 @@ static CDX_S32 movFindKeyframe(struct CdxMovParser *p, CDX_U32 curr_sample_num,
     CDX_U64   previous_sync_time,next_sync_time;
     CDX_U64   diff_time_previous,diff_time_next;
     MOVStreamContext    *st;
+    MovSeekPoint        *pt;
     SeekModeType curSeekMode;
 
     c = (MOVContext*)p->privData;
@@ -630,6 +829,20 @@ static CDX_S32 movFindKeyframe(struct CdxMovParser *p, CDX_U32 curr_sample_num,
     {
         low = 0;
         high = stss_size-1;
+        //the key frames before the seek point are before the sample,
+        //the ones from the next point on are after it
+        pt = movSeekPointOfSample(st, curr_sample_num);
+        if(pt)
+        {
+            if(pt->stss_idx > 1)
+            {
+                low = pt->stss_idx - 1;
+            }
+            if(pt + 1 < st->seek_index + st->seek_index_count && pt[1].stss_idx < high)
+            {
+                high = pt[1].stss_idx > low ? pt[1].stss_idx : low + 1;
+            }
+        }
         nexti = (low+high)>>1;
         while (low+1 < high)
         {
@@ -764,10 +977,18 @@ static CDX_S32 seekVideoSample(struct CdxMovParser *p,MOVContext *c,
     CDX_S32       ret;
     CDX_S32       i;
     CDX_S32       sample_in_chunk_ost;
+    MovSeekPoint  *pt;
     st->mov_idx_curr.stsc_idx = 0;
     memset(&stsc_parameter,0,sizeof(StscParameter));
     stsc_parameter.sample_num = sample_num;
 
+    pt = movSeekPointOfSample(st, sample_num);
+    if(pt)
+    {
+        st->mov_idx_curr.stsc_idx = stsc_parameter.stsc_idx = pt->stsc_idx;
+        stsc_parameter.stsc_samples_acc = pt->stsc_samples_acc;
+    }
+
     ret = locatingStsc(&stsc_parameter,p,st);
     if(ret < 0)
     {
@@ -813,6 +1034,12 @@ static CDX_S32 seekVideoSample(struct CdxMovParser *p,MOVContext *c,
         st->mov_idx_curr.stts_idx = 0;
         st->mov_idx_curr.stts_samples_acc = 0;
         st->mov_idx_curr.stts_duration_acc = 0;
+        if(pt)
+        {
+            st->mov_idx_curr.stts_idx = pt->stts_idx;
+            st->mov_idx_curr.stts_samples_acc = pt->stts_samples_acc;
+            st->mov_idx_curr.stts_duration_acc = pt->stts_duration_acc;
+        }
 
         ret = locatingStts(p,st);
         if(ret < 0)
@@ -2057,6 +2284,12 @@ CDX_S32 MovSeekSample(struct CdxMovParser *p,MOVContext *c,cdx_int64 seekTime,
 
     if (c->has_video)
     {
+        result = movBuildSeekIndex(p, c->streams[c->video_stream_idx]);
+        if(result < 0)
+        {
+            return -1;
+        }
+
         //find the video sample nearest seekTime
         frmidx = movTimeToSample(p, seekTime);
         if(frmidx < 0)
@@ -2077,13 +2310,21 @@ CDX_S32 MovSeekSample(struct CdxMovParser *p,MOVContext *c,cdx_int64 seekTime,
 
         // adjust ctts index
         MOVStreamContext* sc = c->streams[c->video_stream_idx];
+        MovSeekPoint *pt;
         int time_sample;
         int i;
         if(sc->ctts_data)
         {
             time_sample = 0;
             int next = 0;
-            for(i=0; i<sc->ctts_size; i++)
+            i = 0;
+            pt = movSeekPointOfSample(sc, frmidx);
+            if(pt)
+            {
+                i = pt->ctts_idx;
+                time_sample = pt->ctts_samples_acc;
+            }
+            for(; i<sc->ctts_size; i++)
             {
                 next = time_sample + sc->ctts_data[i].count;
                 if(next > frmidx)
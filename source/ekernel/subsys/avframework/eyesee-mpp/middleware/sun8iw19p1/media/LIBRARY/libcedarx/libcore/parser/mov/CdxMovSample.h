@@ -13,6 +13,11 @@
 #define CDX_mov_sample_H
 #include "CdxMovParser.h"
 
+//samples between two points of the seek index
+#ifndef MOV_SEEK_INDEX_STEP
+#define MOV_SEEK_INDEX_STEP 256
+#endif
+
 typedef struct StscParameter
 {
     CDX_U32 stsc_first;
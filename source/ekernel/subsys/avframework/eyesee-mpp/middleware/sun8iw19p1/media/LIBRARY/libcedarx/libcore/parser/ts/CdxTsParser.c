@@ -4049,6 +4049,11 @@ cdx_int32 ProbeByteRate(cdx_uint8* buf, cdx_uint32 buf_size, TSParser *mTSParser
                         block_size*1000*(ptsIndex[j-1] - ptsIndex[0]) / (last_pts - first_pts)*90;
                 }
 #endif
+                for(m=0; m<j; m++)
+                {
+                    TsSeekIndexAdd(&mTSParser->seekIndex, ptsValid[m],
+                        mTSParser->mCacheBuffer.readPos + ptsIndex[m]*block_size);
+                }
                 seekMethod = 0;
             }
             else
@@ -4156,6 +4161,7 @@ cdx_int32 ProbeByteRate(cdx_uint8* buf, cdx_uint32 buf_size, TSParser *mTSParser
                 (mTSParser->fileValidSize*1000)/(last_pts - first_pts)*90;
             mTSParser->durationMs = (last_pts - first_pts)/90;
             mTSParser->seekMethod  = 0;
+            TsSeekIndexAdd(&mTSParser->seekIndex, first_pts, mTSParser->mCacheBuffer.readPos);
         }
         else
         {
@@ -4181,6 +4187,65 @@ cdx_int32 ProbeByteRate(cdx_uint8* buf, cdx_uint32 buf_size, TSParser *mTSParser
     return 0;
 }
 
+#if SeekIndexSidecar
+/* restore what ProbeByteRate found on a former open of the same local file.
+ * <0 no valid sidecar*/
+static cdx_int32 LoadSeekIndex(TSParser *mTSParser)
+{
+    char tmpUrl[4096] = {0};
+    char path[264];
+    TsSeekIndexInfo info;
+
+    if(TSControl(&mTSParser->base, CDX_PSR_CMD_GET_URL, tmpUrl)
+        || TsSeekIndexSidecarPath(tmpUrl, path, sizeof(path)) < 0)
+    {
+        return -1;
+    }
+    mTSParser->seekIndexPath = strdup(path);
+    if(TsSeekIndexLoad(&mTSParser->seekIndex, &info, path) < 0)
+    {
+        return -1;
+    }
+    if(info.fileSize != mTSParser->fileSize
+        || info.rawPacketSize != mTSParser->mRawPacketSize
+        || info.firstPts != mTSParser->curProgram->mFirstPTS
+        || info.seekMethod != 0 || info.byteRate == 0)
+    {
+        CDX_LOGD("%s is stale", path);
+        TsSeekIndexClear(&mTSParser->seekIndex);
+        return -1;
+    }
+    mTSParser->fileValidSize = info.fileValidSize;
+    mTSParser->byteRate = info.byteRate;
+    mTSParser->durationMs = info.durationMs;
+    mTSParser->seekMethod = info.seekMethod;
+    CDX_LOGD("seek index of %d entries from %s, durationMs %llu",
+        mTSParser->seekIndex.num, path, mTSParser->durationMs);
+    return 0;
+}
+
+static void SaveSeekIndex(TSParser *mTSParser)
+{
+    TsSeekIndexInfo info;
+
+    if(!mTSParser->seekIndexPath || !mTSParser->seekIndex.dirty
+        || mTSParser->seekMethod != 0 || !mTSParser->byteRate
+        || !mTSParser->curProgram)
+    {
+        return;
+    }
+    memset(&info, 0, sizeof(info));
+    info.fileSize = mTSParser->fileSize;
+    info.fileValidSize = mTSParser->fileValidSize;
+    info.rawPacketSize = mTSParser->mRawPacketSize;
+    info.seekMethod = mTSParser->seekMethod;
+    info.firstPts = mTSParser->curProgram->mFirstPTS;
+    info.byteRate = mTSParser->byteRate;
+    info.durationMs = mTSParser->durationMs;
+    TsSeekIndexSave(&mTSParser->seekIndex, &info, mTSParser->seekIndexPath);
+}
+#endif
+
 /* <0 fail*/
 cdx_int32 EstimateDuration(TSParser *mTSParser)
 {
@@ -4394,6 +4459,13 @@ cdx_int32 EstimateDuration(TSParser *mTSParser)
     }
     else
     {
+#if SeekIndexSidecar
+        //* the probe reads 10 blocks of 1.5M across the file, skip it if we can
+        if(LoadSeekIndex(mTSParser) == 0)
+        {
+            return 0;
+        }
+#endif
         bufSize = 1.5*1024*1024;
         tmpBuf     = (cdx_uint8*)malloc(bufSize);
         CDX_FORCE_CHECK(tmpBuf);
@@ -4427,6 +4499,14 @@ cdx_int32 TSClose(CdxParserT *parser)
         CdxStreamClose(mTSParser->cdxStream);/*ܵopenthreadķ*/
         mTSParser->cdxStream = NULL;
     }
+#if SeekIndexSidecar
+    SaveSeekIndex(mTSParser);
+#endif
+    TsSeekIndexDestroy(&mTSParser->seekIndex);
+    if(mTSParser->seekIndexPath)
+    {
+        free(mTSParser->seekIndexPath);
+    }
     DestroyPrograms(mTSParser);
     DestroyPSISections(mTSParser);
     if(mTSParser->mCacheBuffer.bigBuf)
@@ -6076,6 +6156,10 @@ cdx_int32 SeekToTime(TSParser *mTSParser, cdx_int64 timeUs, cdx_uint32 mode)
     cdx_int32          pts_high_thredhold;
     cdx_int64    pts_pos;
     cdx_int64    tmp;
+    cdx_int64    next_pos;
+    cdx_int64    read_pos;
+    cdx_int64    lo_pos;
+    cdx_int64    hi_pos;
     cdx_int32 ret = 0;
 
     if(mode == 0)       //* play mode
@@ -6098,13 +6182,19 @@ cdx_int32 SeekToTime(TSParser *mTSParser, cdx_int64 timeUs, cdx_uint32 mode)
     if(mTSParser->seekMethod == 0)
     {
         cdx_int64 curPos = CdxStreamTell(cdxStream);
-        file_pos = mTSParser->byteRate * timeUs / (1000 * 1000);
+        dst_pts = timeUs*9/100 + mTSParser->curProgram->mFirstPTS;
+        //* start from the pts met by the probe and former seeks around dst_pts
+        file_pos = TsSeekIndexEstimatePos(&mTSParser->seekIndex, dst_pts, mTSParser->byteRate);
+        if(file_pos < 0)
+            file_pos = mTSParser->byteRate * timeUs / (1000 * 1000);
         file_pos -= (file_pos % mTSParser->mRawPacketSize);
 
         tmp = 0;
         cnt = 0;
         pts_diff = 0;
-        dst_pts = timeUs*9/100 + mTSParser->curProgram->mFirstPTS;
+        //* dst_pts is after the pes at lo_pos and before a read at hi_pos
+        lo_pos = -1;
+        hi_pos = -1;
 
         cdx_uint32 tmp_size = 204*60;//
         cdx_uint8* tmp_buf = (cdx_uint8*)malloc(tmp_size);
@@ -6131,6 +6221,7 @@ cdx_int32 SeekToTime(TSParser *mTSParser, cdx_int64 timeUs, cdx_uint32 mode)
             }
 
             pts = FindNextPTS(mTSParser, tmp_buf, data_size, &tmp);
+            read_pos = file_pos;
             file_pos = file_pos + tmp;//
 
             if (pts == (cdx_int64)-1)//forcestop
@@ -6151,25 +6242,36 @@ cdx_int32 SeekToTime(TSParser *mTSParser, cdx_int64 timeUs, cdx_uint32 mode)
             else
                 pts_diff = pts - dst_pts;
 
+            //* every pts met refines the index, the next step interpolates
+            //* between it and the nearest known pts beyond dst_pts.
+            TsSeekIndexAdd(&mTSParser->seekIndex, pts, file_pos);
+            next_pos = TsSeekIndexEstimatePos(&mTSParser->seekIndex, dst_pts, mTSParser->byteRate);
+
             CDX_LOGV("pts = %lld, pts_diff = %lld, cnt = %u", pts, pts_diff, cnt);
             if (pts > dst_pts + pts_high_thredhold)
             {
-                file_pos -= mTSParser->byteRate*(pts_diff/90000);
-                if (file_pos <= 0)
-                    file_pos = 0;
+                //* a read finds the next pes, so step back 1s more than
+                //* the pts difference not to land in the same pes again.
+                hi_pos = read_pos;
+                if (next_pos < 0 || next_pos >= read_pos)
+                    next_pos = read_pos - mTSParser->byteRate*(pts_diff + 90000)/90000;
             }
             else if (pts + pts_low_thredhold < dst_pts)
             {
-                file_pos += mTSParser->byteRate*(pts_diff/90000);
-                if (file_pos > mTSParser->fileSize)
-                {
-                    file_pos -= mTSParser->byteRate*(pts_diff/90000);
-                    break;
-                }
+                lo_pos = file_pos;
+                if (next_pos < 0 || next_pos <= file_pos)
+                    next_pos = file_pos + mTSParser->byteRate*pts_diff/90000;
             }
             else
                 break;
 
+            //* bisect what is left once dst_pts is surrounded
+            if (lo_pos >= 0 && hi_pos >= 0 && (next_pos <= lo_pos || next_pos >= hi_pos))
+                next_pos = lo_pos + (hi_pos - lo_pos) / 2;
+            if (next_pos > mTSParser->fileSize)
+                break;
+            file_pos = next_pos > 0 ? next_pos : 0;
+
             CDX_LOGV("tmp = %lld, dst_file_pos = %lld", tmp, file_pos);
             cnt++;
             if(CdxStreamSeek(cdxStream, file_pos, SEEK_SET) < 0)
@@ -6497,6 +6599,7 @@ CdxParserT *TSParserOpen(CdxStreamT *cdxStream, cdx_uint32 flags)
 
     mTSParser->pat_version_number = (unsigned)-1;
     CdxListInit(&mTSParser->mPrograms);
+    TsSeekIndexInit(&mTSParser->seekIndex);
 
     cdx_uint32 bufSize = PROBE_PACKET_NUM * 204 * 2;//
     mTSParser->mCacheBuffer.bigBuf = (cdx_uint8 *)CdxMalloc(bufSize);
@@ -17,6 +17,7 @@
 #include <CdxParser.h>
 #include <CdxStream.h>
 #include <CdxAtomic.h>
+#include <CdxTsSeekIndex.h>
 
 #define MAX_PID_NUM 8192
 //* codec id
@@ -134,6 +135,7 @@ typedef enum {
 #define PtsDebug (0)
 #define PROBE_STREAM (1)
 #define ProbeSpecificData (1)
+#define SeekIndexSidecar (1)  //* keep the seek index of local files in a sidecar file
 #define SIZE_OF_VIDEO_PROVB_DATA (2*1024*1024)
 #define SIZE_OF_AUDIO_PROVB_DATA (150*1024)
 #define    DVB_USED    (1)
@@ -299,6 +301,9 @@ struct TSParserS
     cdx_bool b_hls_discontinue;
     cdx_bool b_steam_change;
     pthread_rwlock_t controlLock;
+
+    TsSeekIndex seekIndex;
+    char *seekIndexPath;    //* sidecar of a local file, NULL if none
 };
 
 struct ProgramS
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2008-2016 Allwinner Technology Co. Ltd.
+ * All rights reserved.
+ *
+ * File : CdxTsSeekIndex.c
+ * Description : pts to file position index of the ts parser
+ * History :
+ *
+ */
+
+#define LOG_TAG "tsSeekIndex"
+#include <cdx_log.h>
+#include <CdxTsSeekIndex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TS_SEEK_INDEX_MAGIC     "CTSI"
+#define TS_SEEK_INDEX_VERSION   (1)
+
+typedef struct TsSeekIndexHeaderS
+{
+    char magic[4];
+    cdx_uint32 version;
+    cdx_int32 num;
+    cdx_int32 reserved;
+    TsSeekIndexInfo info;
+} TsSeekIndexHeader;
+
+void TsSeekIndexInit(TsSeekIndex *index)
+{
+    memset(index, 0, sizeof(TsSeekIndex));
+}
+
+void TsSeekIndexDestroy(TsSeekIndex *index)
+{
+    if(index->entries)
+    {
+        free(index->entries);
+    }
+    memset(index, 0, sizeof(TsSeekIndex));
+}
+
+void TsSeekIndexClear(TsSeekIndex *index)
+{
+    if(index->num > 0)
+    {
+        index->dirty = 1;
+    }
+    index->num = 0;
+}
+
+//* first entry whose pts is not less than pts
+static cdx_int32 SearchIndex(const TsSeekIndex *index, cdx_int64 pts)
+{
+    cdx_int32 lo = 0;
+    cdx_int32 hi = index->num;
+
+    while(lo < hi)
+    {
+        cdx_int32 mid = lo + (hi - lo) / 2;
+        if(index->entries[mid].pts < pts)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+//* keep every other entry, the first and the last ones included
+static void DecimateIndex(TsSeekIndex *index)
+{
+    cdx_int32 i, n = 0;
+
+    for(i = 0; i < index->num; i += 2)
+    {
+        index->entries[n++] = index->entries[i];
+    }
+    if((index->num & 1) == 0)
+    {
+        index->entries[n++] = index->entries[index->num - 1];
+    }
+    index->num = n;
+}
+
+cdx_int32 TsSeekIndexAdd(TsSeekIndex *index, cdx_int64 pts, cdx_int64 pos)
+{
+    cdx_int32 i;
+
+    if(pts < 0 || pos < 0)
+    {
+        return -1;
+    }
+    i = SearchIndex(index, pts);
+    if((i > 0 && pts - index->entries[i-1].pts < TS_SEEK_INDEX_MIN_PTS_GAP)
+        || (i < index->num && index->entries[i].pts - pts < TS_SEEK_INDEX_MIN_PTS_GAP))
+    {
+        return 0;
+    }
+    if((i > 0 && index->entries[i-1].pos >= pos)
+        || (i < index->num && index->entries[i].pos <= pos))
+    {
+        CDX_LOGV("pts %lld at %lld is out of order", pts, pos);
+        return -1;
+    }
+
+    if(index->num == index->capacity)
+    {
+        if(index->capacity < TS_SEEK_INDEX_MAX_NUM)
+        {
+            cdx_int32 capacity = index->capacity ? index->capacity * 2 : 256;
+            TsSeekIndexEntry *entries;
+
+            if(capacity > TS_SEEK_INDEX_MAX_NUM)
+            {
+                capacity = TS_SEEK_INDEX_MAX_NUM;
+            }
+            entries = realloc(index->entries, capacity * sizeof(TsSeekIndexEntry));
+            if(entries == NULL)
+            {
+                CDX_LOGE("realloc fail.");
+                return -1;
+            }
+            index->entries = entries;
+            index->capacity = capacity;
+        }
+        else
+        {
+            DecimateIndex(index);
+            i = SearchIndex(index, pts);
+        }
+    }
+
+    memmove(&index->entries[i+1], &index->entries[i],
+        (index->num - i) * sizeof(TsSeekIndexEntry));
+    index->entries[i].pts = pts;
+    index->entries[i].pos = pos;
+    index->num++;
+    index->dirty = 1;
+    return 1;
+}
+
+cdx_int64 TsSeekIndexEstimatePos(const TsSeekIndex *index, cdx_int64 pts, cdx_uint64 byteRate)
+{
+    const TsSeekIndexEntry *prev, *next;
+    cdx_int32 i;
+    cdx_int64 pos;
+
+    if(index->num == 0)
+    {
+        return -1;
+    }
+    i = SearchIndex(index, pts);
+    if(i == index->num)
+    {
+        prev = &index->entries[i-1];
+        return prev->pos + (cdx_int64)byteRate * (pts - prev->pts) / 90000;
+    }
+    next = &index->entries[i];
+    if(i == 0 || next->pts == pts)
+    {
+        pos = next->pos - (cdx_int64)byteRate * (next->pts - pts) / 90000;
+        return pos > 0 ? pos : 0;
+    }
+    prev = &index->entries[i-1];
+    return prev->pos + (next->pos - prev->pos) * (pts - prev->pts) / (next->pts - prev->pts);
+}
+
+cdx_int32 TsSeekIndexSidecarPath(const char *uri, char *path, cdx_int32 size)
+{
+    char file[256];
+    cdx_int32 fd, len;
+    long long offset = 0;
+
+    if(uri == NULL)
+    {
+        return -1;
+    }
+    if(!strncmp(uri, "file://", 7))
+    {
+        uri += 7;
+    }
+    if(uri[0] == '/')
+    {
+        len = strlen(uri);
+        if(len >= (cdx_int32)sizeof(file))
+        {
+            return -1;
+        }
+        strcpy(file, uri);
+    }
+    else if(sscanf(uri, "fd://%d?offset=%lld", &fd, &offset) >= 1)
+    {
+        //* positions of a stream inside a file are not file positions
+        char link[32];
+        if(offset != 0)
+        {
+            return -1;
+        }
+        sprintf(link, "/proc/self/fd/%d", fd);
+        len = readlink(link, file, sizeof(file) - 1);
+        if(len <= 0 || file[0] != '/')
+        {
+            return -1;
+        }
+        file[len] = '\0';
+    }
+    else
+    {
+        return -1;
+    }
+
+    if(len + (cdx_int32)strlen(TS_SEEK_INDEX_SUFFIX) + 1 > size)
+    {
+        return -1;
+    }
+    sprintf(path, "%s%s", file, TS_SEEK_INDEX_SUFFIX);
+    return 0;
+}
+
+cdx_int32 TsSeekIndexSave(TsSeekIndex *index, const TsSeekIndexInfo *info, const char *path)
+{
+    TsSeekIndexHeader header;
+    char tmpPath[272];
+    FILE *fp;
+    cdx_int32 ok;
+
+    if(strlen(path) + 5 > sizeof(tmpPath))
+    {
+        return -1;
+    }
+    sprintf(tmpPath, "%s.tmp", path);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TS_SEEK_INDEX_MAGIC, 4);
+    header.version = TS_SEEK_INDEX_VERSION;
+    header.num = index->num;
+    header.info = *info;
+
+    //* written aside and renamed, so that a reader never sees half of it
+    fp = fopen(tmpPath, "wb");
+    if(fp == NULL)
+    {
+        CDX_LOGW("can not create %s", tmpPath);
+        return -1;
+    }
+    ok = fwrite(&header, sizeof(header), 1, fp) == 1
+        && (index->num == 0
+            || fwrite(index->entries, sizeof(TsSeekIndexEntry), index->num, fp)
+                == (size_t)index->num);
+    if(fclose(fp) != 0 || !ok || rename(tmpPath, path) != 0)
+    {
+        CDX_LOGW("write %s fail", path);
+        unlink(tmpPath);
+        return -1;
+    }
+    index->dirty = 0;
+    return 0;
+}
+
+cdx_int32 TsSeekIndexLoad(TsSeekIndex *index, TsSeekIndexInfo *info, const char *path)
+{
+    TsSeekIndexHeader header;
+    TsSeekIndexEntry *entries = NULL;
+    FILE *fp;
+    cdx_int32 i;
+
+    fp = fopen(path, "rb");
+    if(fp == NULL)
+    {
+        return -1;
+    }
+    if(fread(&header, sizeof(header), 1, fp) != 1
+        || memcmp(header.magic, TS_SEEK_INDEX_MAGIC, 4)
+        || header.version != TS_SEEK_INDEX_VERSION
+        || header.num < 0 || header.num > TS_SEEK_INDEX_MAX_NUM)
+    {
+        goto _err;
+    }
+    if(header.num > 0)
+    {
+        entries = malloc(header.num * sizeof(TsSeekIndexEntry));
+        if(entries == NULL
+            || fread(entries, sizeof(TsSeekIndexEntry), header.num, fp) != (size_t)header.num)
+        {
+            goto _err;
+        }
+        for(i = 1; i < header.num; i++)
+        {
+            if(entries[i].pts <= entries[i-1].pts || entries[i].pos <= entries[i-1].pos)
+            {
+                goto _err;
+            }
+        }
+    }
+    fclose(fp);
+
+    TsSeekIndexDestroy(index);
+    index->entries = entries;
+    index->num = index->capacity = header.num;
+    *info = header.info;
+    return 0;
+
+_err:
+    CDX_LOGW("%s is not a valid index", path);
+    free(entries);
+    fclose(fp);
+    return -1;
+}
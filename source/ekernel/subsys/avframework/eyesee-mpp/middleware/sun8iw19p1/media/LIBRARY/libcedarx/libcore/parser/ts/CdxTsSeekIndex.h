@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2008-2016 Allwinner Technology Co. Ltd.
+ * All rights reserved.
+ *
+ * File : CdxTsSeekIndex.h
+ * Description : pts to file position index of the ts parser, built from
+ *               the pts it meets when probing and seeking, and kept in a
+ *               sidecar file next to local media for the next open.
+ * History :
+ *
+ */
+
+#ifndef _CDX_TS_SEEK_INDEX_H_
+#define _CDX_TS_SEEK_INDEX_H_
+
+#include <CdxTypes.h>
+
+#define TS_SEEK_INDEX_MAX_NUM       (8192)      //* decimated by 2 when full
+#define TS_SEEK_INDEX_MIN_PTS_GAP   (90*500)    //* 0.5s in 90kHz
+#define TS_SEEK_INDEX_SUFFIX        ".cdxidx"
+
+typedef struct TsSeekIndexEntryS
+{
+    cdx_int64 pts;      //* 90kHz
+    cdx_int64 pos;      //* the first pes with a pts at or after pos has this pts
+} TsSeekIndexEntry;
+
+//* what the byte rate probe found, saved with the index. A sidecar is used
+//* only if fileSize, rawPacketSize and firstPts match the opened file.
+typedef struct TsSeekIndexInfoS
+{
+    cdx_int64 fileSize;
+    cdx_int64 fileValidSize;
+    cdx_uint32 rawPacketSize;
+    cdx_int32 seekMethod;
+    cdx_int64 firstPts;
+    cdx_uint64 byteRate;
+    cdx_uint64 durationMs;
+} TsSeekIndexInfo;
+
+typedef struct TsSeekIndexS
+{
+    TsSeekIndexEntry *entries;  //* sorted by pts, and so by pos
+    cdx_int32 num;
+    cdx_int32 capacity;
+    cdx_int32 dirty;            //* changed since loaded or saved
+} TsSeekIndex;
+
+void TsSeekIndexInit(TsSeekIndex *index);
+void TsSeekIndexDestroy(TsSeekIndex *index);
+void TsSeekIndexClear(TsSeekIndex *index);
+
+/* return 1 added, 0 an entry is nearer than TS_SEEK_INDEX_MIN_PTS_GAP,
+ * -1 out of order with its neighbours (pts loop back) or no memory. */
+cdx_int32 TsSeekIndexAdd(TsSeekIndex *index, cdx_int64 pts, cdx_int64 pos);
+
+/* file position of pts interpolated between the entries around it, or
+ * extrapolated with byteRate past the first or last one. -1 if empty. */
+cdx_int64 TsSeekIndexEstimatePos(const TsSeekIndex *index, cdx_int64 pts, cdx_uint64 byteRate);
+
+/* path of the sidecar of a local file uri ("/...", "file://..." or
+ * "fd://N" without offset), 0 ok, -1 if the uri has none. */
+cdx_int32 TsSeekIndexSidecarPath(const char *uri, char *path, cdx_int32 size);
+
+cdx_int32 TsSeekIndexSave(TsSeekIndex *index, const TsSeekIndexInfo *info, const char *path);
+cdx_int32 TsSeekIndexLoad(TsSeekIndex *index, TsSeekIndexInfo *info, const char *path);
+
+#endif
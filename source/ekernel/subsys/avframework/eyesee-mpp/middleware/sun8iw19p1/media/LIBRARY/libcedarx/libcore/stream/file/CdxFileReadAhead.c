@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2008-2016 Allwinner Technology Co. Ltd.
+ * All rights reserved.
+ *
+ * File : CdxFileReadAhead.c
+ * Description : read-ahead window of the file stream
+ * History :
+ *
+ */
+
+#define LOG_TAG "fileReadAhead"
+#include <CdxFileReadAhead.h>
+#include <CdxMemory.h>
+#include <CdxTime.h>
+#include <cdx_log.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+enum FileBlockStateE
+{
+    FILE_BLOCK_EMPTY = 0,
+    FILE_BLOCK_LOADING,
+    FILE_BLOCK_READY,
+    FILE_BLOCK_ERROR,
+};
+
+/* block n of the file lives in blocks[n % nBlockNum], the window is blocks
+ * winStart to winStart + nBlockNum - 1 of the file. Only the io thread
+ * writes into the blocks, and never into one of the window the reader is
+ * copying from. */
+struct FileBlockS
+{
+    cdx_uint8 *buf;
+    cdx_int64 blockNo;
+    cdx_int32 validLen;
+    enum FileBlockStateE state;
+};
+
+struct CdxFileReadAheadS
+{
+    CdxFileReadAtT readAt;
+    void *user;
+    cdx_int64 size;
+
+    cdx_uint8 *mem;
+    struct FileBlockS *blocks;
+    cdx_int32 nBlockNum;
+    cdx_int64 winStart;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ioCond;      /* window moved or quit, for the io thread */
+    pthread_cond_t readCond;    /* a block is loaded, for the reader */
+    cdx_bool quit;
+
+    struct StreamReadAheadStatsS stats;
+};
+
+/* first block of the window to load, the window in order, -1 if all are */
+static cdx_int64 NextBlockToLoad(CdxFileReadAheadT *ra)
+{
+    cdx_int64 n;
+    cdx_int64 end = ra->winStart + ra->nBlockNum;
+    cdx_int64 fileBlocks = (ra->size + FILE_READ_AHEAD_BLOCK_SIZE - 1) / FILE_READ_AHEAD_BLOCK_SIZE;
+
+    if (end > fileBlocks)
+    {
+        end = fileBlocks;
+    }
+    for (n = ra->winStart; n < end; n++)
+    {
+        struct FileBlockS *block = &ra->blocks[n % ra->nBlockNum];
+        if (block->blockNo != n || block->state == FILE_BLOCK_EMPTY)
+        {
+            /* a block still loading out of the window is waited for */
+            return block->state == FILE_BLOCK_LOADING ? -1 : n;
+        }
+    }
+    return -1;
+}
+
+static void *ReadAheadThread(void *arg)
+{
+    CdxFileReadAheadT *ra = (CdxFileReadAheadT *)arg;
+
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->quit)
+    {
+        struct FileBlockS *block;
+        cdx_int64 n = NextBlockToLoad(ra);
+        cdx_int64 pos;
+        cdx_int32 len, ret;
+
+        if (n < 0)
+        {
+            pthread_cond_wait(&ra->ioCond, &ra->lock);
+            continue;
+        }
+
+        block = &ra->blocks[n % ra->nBlockNum];
+        block->blockNo = n;
+        block->state = FILE_BLOCK_LOADING;
+        pos = n * FILE_READ_AHEAD_BLOCK_SIZE;
+        len = FILE_READ_AHEAD_BLOCK_SIZE;
+        if (pos + len > ra->size)
+        {
+            len = ra->size - pos;
+        }
+        pthread_mutex_unlock(&ra->lock);
+
+        ret = ra->readAt(ra->user, pos, block->buf, len);
+
+        pthread_mutex_lock(&ra->lock);
+        ra->stats.nIoCalls++;
+        block->validLen = ret < 0 ? 0 : ret;
+        block->state = ret < 0 ? FILE_BLOCK_ERROR : FILE_BLOCK_READY;
+        pthread_cond_broadcast(&ra->readCond);
+    }
+    pthread_mutex_unlock(&ra->lock);
+    return NULL;
+}
+
+CdxFileReadAheadT *CdxFileReadAheadCreate(CdxFileReadAtT readAt, void *user,
+                                          cdx_int64 size, cdx_uint32 windowSize)
+{
+    CdxFileReadAheadT *ra;
+    cdx_uint8 *buf;
+    cdx_int32 i;
+
+    ra = CdxMalloc(sizeof(*ra));
+    if (ra == NULL)
+    {
+        CDX_LOGE("malloc fail.");
+        return NULL;
+    }
+    memset(ra, 0, sizeof(*ra));
+    ra->readAt = readAt;
+    ra->user = user;
+    ra->size = size;
+    ra->nBlockNum = (windowSize + FILE_READ_AHEAD_BLOCK_SIZE - 1) / FILE_READ_AHEAD_BLOCK_SIZE;
+    if (ra->nBlockNum < 2)
+    {
+        ra->nBlockNum = 2;
+    }
+    ra->stats.nWindowSize = ra->nBlockNum * FILE_READ_AHEAD_BLOCK_SIZE;
+
+    /* one allocation, the blocks aligned for the dma of the card */
+    ra->mem = CdxMalloc(ra->stats.nWindowSize + FILE_READ_AHEAD_ALIGN);
+    ra->blocks = CdxMalloc(ra->nBlockNum * sizeof(struct FileBlockS));
+    if (ra->mem == NULL || ra->blocks == NULL)
+    {
+        CDX_LOGE("malloc %d fail.", ra->stats.nWindowSize);
+        goto err_free;
+    }
+    buf = (cdx_uint8 *)(((uintptr_t)ra->mem + FILE_READ_AHEAD_ALIGN - 1)
+                        & ~(uintptr_t)(FILE_READ_AHEAD_ALIGN - 1));
+    for (i = 0; i < ra->nBlockNum; i++)
+    {
+        ra->blocks[i].buf = buf + i * FILE_READ_AHEAD_BLOCK_SIZE;
+        ra->blocks[i].blockNo = -1;
+        ra->blocks[i].state = FILE_BLOCK_EMPTY;
+    }
+
+    pthread_mutex_init(&ra->lock, NULL);
+    pthread_cond_init(&ra->ioCond, NULL);
+    pthread_cond_init(&ra->readCond, NULL);
+    if (pthread_create(&ra->thread, NULL, ReadAheadThread, ra) != 0)
+    {
+        CDX_LOGE("create read-ahead thread fail.");
+        pthread_cond_destroy(&ra->readCond);
+        pthread_cond_destroy(&ra->ioCond);
+        pthread_mutex_destroy(&ra->lock);
+        goto err_free;
+    }
+    return ra;
+
+err_free:
+    if (ra->blocks)
+    {
+        CdxFree(ra->blocks);
+    }
+    if (ra->mem)
+    {
+        CdxFree(ra->mem);
+    }
+    CdxFree(ra);
+    return NULL;
+}
+
+void CdxFileReadAheadDestroy(CdxFileReadAheadT *ra)
+{
+    pthread_mutex_lock(&ra->lock);
+    ra->quit = CDX_TRUE;
+    pthread_cond_signal(&ra->ioCond);
+    pthread_mutex_unlock(&ra->lock);
+    pthread_join(ra->thread, NULL);
+
+    pthread_cond_destroy(&ra->readCond);
+    pthread_cond_destroy(&ra->ioCond);
+    pthread_mutex_destroy(&ra->lock);
+    CdxFree(ra->blocks);
+    CdxFree(ra->mem);
+    CdxFree(ra);
+}
+
+cdx_int32 CdxFileReadAheadRead(CdxFileReadAheadT *ra, cdx_int64 pos, void *buf, cdx_uint32 len)
+{
+    cdx_uint8 *dst = (cdx_uint8 *)buf;
+    cdx_int32 total = 0;
+    cdx_int32 ret;
+    cdx_int64 t0;
+
+    pthread_mutex_lock(&ra->lock);
+    ra->stats.nReadCalls++;
+    if (len > (cdx_uint32)ra->stats.nWindowSize)
+    {
+        /* would only flush the window, the file reads it in place */
+        ra->stats.nIoCalls++;
+        pthread_mutex_unlock(&ra->lock);
+        t0 = CdxGetNowUs();
+        ret = ra->readAt(ra->user, pos, buf, len);
+        pthread_mutex_lock(&ra->lock);
+        ra->stats.nStallUs += CdxGetNowUs() - t0;
+        pthread_mutex_unlock(&ra->lock);
+        return ret;
+    }
+
+    while (len > 0 && pos < ra->size)
+    {
+        cdx_int64 n = pos / FILE_READ_AHEAD_BLOCK_SIZE;
+        struct FileBlockS *block = &ra->blocks[n % ra->nBlockNum];
+        cdx_int32 offset = pos - n * FILE_READ_AHEAD_BLOCK_SIZE;
+        cdx_int32 size;
+
+        if (n < ra->winStart || n >= ra->winStart + ra->nBlockNum)
+        {
+            /* a seek: the window starts again from here */
+            ra->stats.nInvalidations++;
+            ra->winStart = n;
+            pthread_cond_signal(&ra->ioCond);
+        }
+        else if (n > ra->winStart + 1)
+        {
+            /* keep the block before for the parsers stepping back a little */
+            ra->winStart = n - 1;
+            pthread_cond_signal(&ra->ioCond);
+        }
+
+        if (block->blockNo != n || block->state < FILE_BLOCK_READY)
+        {
+            t0 = CdxGetNowUs();
+            while (block->blockNo != n || block->state < FILE_BLOCK_READY)
+            {
+                pthread_cond_wait(&ra->readCond, &ra->lock);
+            }
+            ra->stats.nStallUs += CdxGetNowUs() - t0;
+        }
+        if (block->state == FILE_BLOCK_ERROR)
+        {
+            /* loaded again if asked again */
+            block->state = FILE_BLOCK_EMPTY;
+            pthread_cond_signal(&ra->ioCond);
+            pthread_mutex_unlock(&ra->lock);
+            return total > 0 ? total : -1;
+        }
+        if (offset >= block->validLen)
+        {
+            break;
+        }
+
+        size = block->validLen - offset;
+        if ((cdx_uint32)size > len)
+        {
+            size = len;
+        }
+        pthread_mutex_unlock(&ra->lock);
+        memcpy(dst, block->buf + offset, size);
+        pthread_mutex_lock(&ra->lock);
+
+        dst += size;
+        pos += size;
+        len -= size;
+        total += size;
+    }
+    pthread_mutex_unlock(&ra->lock);
+    return total;
+}
+
+void CdxFileReadAheadGetStats(CdxFileReadAheadT *ra, struct StreamReadAheadStatsS *stats)
+{
+    pthread_mutex_lock(&ra->lock);
+    *stats = ra->stats;
+    pthread_mutex_unlock(&ra->lock);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2008-2016 Allwinner Technology Co. Ltd.
+ * All rights reserved.
+ *
+ * File : CdxFileReadAhead.h
+ * Description : read-ahead window of the file stream: a thread reads the
+ *               file by big aligned blocks ahead of the parser, which is
+ *               served from them.
+ * History :
+ *
+ */
+
+#ifndef CDX_FILE_READ_AHEAD_H
+#define CDX_FILE_READ_AHEAD_H
+
+#include <CdxTypes.h>
+#include <CdxStream.h>
+
+#define FILE_READ_AHEAD_BLOCK_SIZE      (256 * 1024)
+#define FILE_READ_AHEAD_DEFAULT_SIZE    (2 * 1024 * 1024)
+#define FILE_READ_AHEAD_ALIGN           (4096)
+
+typedef struct CdxFileReadAheadS CdxFileReadAheadT;
+
+/* read len bytes at pos of the file, return the bytes read or -1 */
+typedef cdx_int32 (*CdxFileReadAtT)(void *user, cdx_int64 pos, void *buf, cdx_uint32 len);
+
+/* windowSize is rounded up to whole blocks, at least 2 of them.
+ * NULL if the memory or the thread can not be had. */
+CdxFileReadAheadT *CdxFileReadAheadCreate(CdxFileReadAtT readAt, void *user,
+                                          cdx_int64 size, cdx_uint32 windowSize);
+void CdxFileReadAheadDestroy(CdxFileReadAheadT *ra);
+
+/* read len bytes at pos from the window, move it if pos is out of it.
+ * Reads bigger than the window go to the file directly. Return the bytes
+ * read, short at the end of the file, or -1 on io error. One reader only. */
+cdx_int32 CdxFileReadAheadRead(CdxFileReadAheadT *ra, cdx_int64 pos, void *buf, cdx_uint32 len);
+
+void CdxFileReadAheadGetStats(CdxFileReadAheadT *ra, struct StreamReadAheadStatsS *stats);
+
+#endif
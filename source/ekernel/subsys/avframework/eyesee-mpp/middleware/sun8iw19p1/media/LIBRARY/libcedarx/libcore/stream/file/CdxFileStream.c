@@ -22,7 +22,10 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
 #include <CdxDebug.h>
+#include <CdxTime.h>
+#include "CdxFileReadAhead.h"
 
 #define FILE_STREAM_SCHEME "file://"
 #define FD_STREAM_SCHEME "fd://"
@@ -49,6 +52,7 @@ enum FileStreamStateE
     FILE_STREAM_SEEKING = 0x02L,
     FILE_STREAM_CLOSING = 0x03L,
     FILE_STREAM_WRITING = 0x04L,
+    FILE_STREAM_CONTROLLING = 0x05L,
 };
 
 /*fmt: "file://xxx" */
@@ -63,6 +67,12 @@ struct CdxFileStreamImplS
     int fd;
     cdx_int64 offset;
     cdx_int64 size;
+    cdx_int64 pos;      /* read position in the stream, seek and tell need no syscall */
+    cdx_int64 fdPos;    /* position of fd in the file */
+    pthread_mutex_t ioLock; /* fd is used by the read-ahead thread too */
+
+    CdxFileReadAheadT *readAhead;
+    struct StreamReadAheadStatsS syncStats; /* when read-ahead is off */
 
     /*when datasource uri is fd, then will try to get the absolute path like "/mnt/..." */
     char *redriectPath;
@@ -102,6 +112,46 @@ static inline cdx_int32 WaitIdleAndSetState(cdx_atomic_t *state, cdx_ssize val)
     return CDX_SUCCESS;
 }
 
+/* read len bytes at pos of the stream, short only at the end of the file */
+static cdx_int32 FileReadAt(void *user, cdx_int64 pos, void *buf, cdx_uint32 len)
+{
+    struct CdxFileStreamImplS *impl = (struct CdxFileStreamImplS *)user;
+    cdx_int32 total = 0;
+    cdx_int32 ret = 0;
+
+    pthread_mutex_lock(&impl->ioLock);
+    if (impl->fdPos != impl->offset + pos)
+    {
+        if (cdxfseek64(impl->fd, impl->offset + pos, SEEK_SET) < 0)
+        {
+            CDX_LOGE("seek to %lld failure, errno(%d)", impl->offset + pos, errno);
+            impl->fdPos = -1;
+            pthread_mutex_unlock(&impl->ioLock);
+            return -1;
+        }
+        impl->fdPos = impl->offset + pos;
+    }
+    while ((cdx_uint32)total < len)
+    {
+        ret = cdxfread64(impl->fd, (char *)buf + total, len - total);
+        if (ret <= 0)
+        {
+            break;
+        }
+        total += ret;
+    }
+    impl->fdPos += total;
+    if (ret < 0 && total == 0)
+    {
+        CDX_LOGE("read at %lld failure, errno(%d)", pos, errno);
+        impl->fdPos = -1;
+        pthread_mutex_unlock(&impl->ioLock);
+        return -1;
+    }
+    pthread_mutex_unlock(&impl->ioLock);
+    return total;
+}
+
 static CdxStreamProbeDataT *__FileStreamGetProbeData(CdxStreamT *stream)
 {
     struct CdxFileStreamImplS *impl;
@@ -123,7 +173,7 @@ static cdx_int32 __FileStreamRead(CdxStreamT *stream, void *buf, cdx_uint32 len)
 
     //* we must limit the HadReadLen within impl->size,
     //* or in some case will be wrong, such as cts
-    nHadReadLen = cdxftell64(impl->fd) - impl->offset;
+    nHadReadLen = impl->pos;
     if(nHadReadLen >= impl->size)
     {
         CDX_LOGD("eos, pos(%lld)",impl->size);
@@ -141,20 +191,35 @@ static cdx_int32 __FileStreamRead(CdxStreamT *stream, void *buf, cdx_uint32 len)
         len = impl->size - nHadReadLen;
     }
 
-    ret = cdxfread64(impl->fd, buf, len);
+    if (impl->readAhead)
+    {
+        ret = CdxFileReadAheadRead(impl->readAhead, nHadReadLen, buf, len);
+    }
+    else
+    {
+        cdx_int64 t0 = CdxGetNowUs();
+        ret = FileReadAt(impl, nHadReadLen, buf, len);
+        impl->syncStats.nReadCalls++;
+        impl->syncStats.nIoCalls++;
+        impl->syncStats.nStallUs += CdxGetNowUs() - t0;
+    }
+    if (ret > 0)
+    {
+        impl->pos += ret;
+    }
 
     if (ret < (cdx_int32)len)
     {
-        if ((cdxftell64(impl->fd) - impl->offset) == impl->size) /*end of file*/
+        if (impl->pos == impl->size) /*end of file*/
         {
             CDX_LOGD("eos, ret(%d), pos(%lld)...", ret, impl->size);
             impl->ioErr = CDX_IO_STATE_EOS;
         }
         else
         {
-            impl->ioErr = errno;
-            CDX_LOGE("ret(%d), errno(%d), cur pos:(%lld), impl->size(%lld)",
-                    ret, impl->ioErr, cdxftell64(impl->fd) - impl->offset, impl->size);
+            impl->ioErr = CDX_IO_STATE_ERROR;
+            CDX_LOGE("ret(%d), cur pos:(%lld), impl->size(%lld)",
+                    ret, impl->pos, impl->size);
         }
     }
 
@@ -176,6 +241,12 @@ static cdx_int32 __FileStreamClose(CdxStreamT *stream)
 
     CDX_FORCE_CHECK(CDX_SUCCESS == ret);
 
+    if (impl->readAhead)
+    {
+        CdxFileReadAheadDestroy(impl->readAhead);
+        impl->readAhead = NULL;
+    }
+
     //* the fd may be invalid when close, such as in TF-card test
     ret = cdxfclose64(impl->fd);
     if(ret != 0)
@@ -198,6 +269,7 @@ static cdx_int32 __FileStreamClose(CdxStreamT *stream)
         CdxFree(impl->redriectPath);
         impl->redriectPath = NULL;
     }
+    pthread_mutex_destroy(&impl->ioLock);
     CdxFree(impl);
     // TODO: use refence
     return CDX_SUCCESS;
@@ -224,13 +296,48 @@ static cdx_int32 __FileStreamControl(CdxStreamT *stream, cdx_int32 cmd, void *pa
 
     struct CdxFileStreamImplS *impl;
 
-    CDX_UNUSE(param);
-
     CDX_CHECK(stream);
     impl = CdxContainerOf(stream, struct CdxFileStreamImplS, base);
 
     switch (cmd)
     {
+    case STREAM_CMD_SET_READ_AHEAD:
+    {
+        cdx_int32 windowSize = *(cdx_int32 *)param;
+
+        if (WaitIdleAndSetState(&impl->state, FILE_STREAM_CONTROLLING) != CDX_SUCCESS)
+        {
+            CDX_LOGE("set state(%d) fail.", CdxAtomicRead(&impl->state));
+            return -1;
+        }
+        if (impl->readAhead)
+        {
+            CdxFileReadAheadDestroy(impl->readAhead);
+            impl->readAhead = NULL;
+        }
+        memset(&impl->syncStats, 0, sizeof(impl->syncStats));
+        if (windowSize > 0)
+        {
+            impl->readAhead = CdxFileReadAheadCreate(FileReadAt, impl, impl->size, windowSize);
+        }
+        CdxAtomicSet(&impl->state, FILE_STREAM_IDLE);
+        CDX_LOGD("read-ahead window %d, %s", windowSize, impl->readAhead ? "on" : "off");
+        return (windowSize > 0 && impl->readAhead == NULL) ? -1 : 0;
+    }
+    case STREAM_CMD_GET_READ_AHEAD_STATS:
+    {
+        struct StreamReadAheadStatsS *stats = (struct StreamReadAheadStatsS *)param;
+
+        if (impl->readAhead)
+        {
+            CdxFileReadAheadGetStats(impl->readAhead, stats);
+        }
+        else
+        {
+            *stats = impl->syncStats;
+        }
+        return 0;
+    }
     default :
         break;
     }
@@ -264,12 +371,12 @@ static cdx_int32 __FileStreamSeek(CdxStreamT *stream, cdx_int64 offset, cdx_int3
             CdxAtomicSet(&impl->state, FILE_STREAM_IDLE);
             return -1;
         }
-        ret = cdxfseek64(impl->fd, impl->offset + offset, SEEK_SET);
+        ret = offset;
         break;
     }
     case STREAM_SEEK_CUR:
     {
-        cdx_int64 curPos = cdxftell64(impl->fd) - impl->offset;
+        cdx_int64 curPos = impl->pos;
         if (curPos + offset < 0 || curPos + offset > impl->size)
         {
             CDX_LOGE("invalid arguments, offset(%lld), size(%lld), curPos(%lld)",
@@ -278,7 +385,7 @@ static cdx_int32 __FileStreamSeek(CdxStreamT *stream, cdx_int64 offset, cdx_int3
             CdxAtomicSet(&impl->state, FILE_STREAM_IDLE);
             return -1;
         }
-        ret = cdxfseek64(impl->fd, offset, SEEK_CUR);
+        ret = curPos + offset;
         break;
     }
     case STREAM_SEEK_END:
@@ -292,7 +399,7 @@ static cdx_int32 __FileStreamSeek(CdxStreamT *stream, cdx_int64 offset, cdx_int3
             CdxAtomicSet(&impl->state, FILE_STREAM_IDLE);
             return -1;
         }
-        ret = cdxfseek64(impl->fd, absOffset, SEEK_SET);
+        ret = impl->size + offset;
         break;
     }
     default :
@@ -300,15 +407,11 @@ static cdx_int32 __FileStreamSeek(CdxStreamT *stream, cdx_int64 offset, cdx_int3
         break;
     }
 
-    if (ret < 0)
-    {
-        impl->ioErr = errno;
-        CDX_LOGE("seek failure, io error(%d); 'whence(%d), base-offset(%lld), offset(%lld)' ",
-                 impl->ioErr, whence, impl->offset, offset);
-    }
+    //* the fd is moved by the next read, which may be served by the read-ahead
+    impl->pos = ret;
 
     CdxAtomicSet(&impl->state, FILE_STREAM_IDLE);
-    return (ret >= 0 ? 0 : -1);
+    return 0;
 }
 
 static cdx_int64 __FileStreamTell(CdxStreamT *stream)
@@ -318,12 +421,7 @@ static cdx_int64 __FileStreamTell(CdxStreamT *stream)
 
     CDX_CHECK(stream);
     impl = CdxContainerOf(stream, struct CdxFileStreamImplS, base);
-    pos = cdxftell64(impl->fd) - impl->offset;
-    if (-1 == pos)
-    {
-        impl->ioErr = errno;
-        CDX_LOGE("ftello failure, io error(%d)", impl->ioErr);
-    }
+    pos = impl->pos;
     return pos;
 }
 
@@ -334,7 +432,7 @@ static cdx_bool __FileStreamEos(CdxStreamT *stream)
 
     CDX_CHECK(stream);
     impl = CdxContainerOf(stream, struct CdxFileStreamImplS, base);
-    pos = cdxftell64(impl->fd) - impl->offset;
+    pos = impl->pos;
     CDX_LOGD("(%lld / %lld / %lld)", pos, impl->offset, impl->size);
     return (pos == impl->size);
 }
@@ -488,12 +586,16 @@ cdx_int32 __FileStreamConnect(CdxStreamT *stream)
 
     CDX_BUF_DUMP(impl->probeData.buf, 16);
 
-    ret = (cdx_int32)cdxfseek64(impl->fd, impl->offset, SEEK_SET);
-    if (-1 == ret)
+    impl->pos = 0;
+    impl->fdPos = impl->offset + impl->probeData.len;
+    ret = 0;
+
+    //* parsers read by small pieces, serve them from big reads ahead
+    impl->readAhead = CdxFileReadAheadCreate(FileReadAt, impl, impl->size,
+                                             FILE_READ_AHEAD_DEFAULT_SIZE);
+    if (impl->readAhead == NULL)
     {
-        CDX_LOGW("io fail errno(%d)", errno);
-        ret = -1;
-        goto failure;
+        CDX_LOGW("no read-ahead, read the file directly");
     }
 
     impl->ioErr = 0;
@@ -533,6 +635,8 @@ static CdxStreamT *__FileStreamCreate(CdxDataSourceT *source)
     impl->base.ops = &fileStreamOps;
     impl->filePath = CdxStrdup(source->uri);
     impl->ioErr = -1;
+    impl->fdPos = -1;
+    pthread_mutex_init(&impl->ioLock, NULL);
     CDX_LOGD("local file '%s'", source->uri);
 
     return &impl->base;
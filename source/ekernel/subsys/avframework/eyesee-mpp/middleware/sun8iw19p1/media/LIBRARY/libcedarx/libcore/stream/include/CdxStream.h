@@ -206,6 +206,15 @@ enum CdxStreamCommandE
 
     STREAM_CMD_SET_PROBE_SIZE     = 0x123,
         /*for setting probe size*/
+
+    STREAM_CMD_SET_READ_AHEAD     = 0x124,
+        /* Set the read-ahead window of a local file stream in bytes,
+         * *(cdx_int32*)param, 0 turns it off. Resets the statistics.
+         * return 0 if OK, return -1 if not supported by the stream handler.
+         */
+
+    STREAM_CMD_GET_READ_AHEAD_STATS = 0x125,
+        /* struct StreamReadAheadStatsS */
 };
 
 /*stream event*/
@@ -266,6 +275,15 @@ struct StreamCacheStateS
     cdx_int32 nPercentage; /* ((100 * download_offset)/totle_size)*/
 };
 
+struct StreamReadAheadStatsS
+{
+    cdx_int32 nWindowSize;      /* bytes, 0 if read-ahead is off */
+    cdx_int32 nInvalidations;   /* reads out of the window, which moved it */
+    cdx_int64 nReadCalls;       /* reads asked by the parser */
+    cdx_int64 nIoCalls;         /* reads of the file */
+    cdx_int64 nStallUs;         /* time the parser waited for the file */
+};
+
 struct CdxStreamProbeDataS
 {
     cdx_char *buf;
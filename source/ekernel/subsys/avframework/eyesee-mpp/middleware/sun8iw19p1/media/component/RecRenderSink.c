@@ -45,6 +45,7 @@
 #include "mm_component.h"
 #include "ComponentCommon.h"
 #include <SystemBase.h>
+#include <mpp_frametrace.h>
 #include "tmessage.h"
 #include "tsemaphore.h"
 #include <aenc_sw_lib.h>
@@ -85,6 +86,7 @@ static ERRORTYPE RSSetRecSinkPacket(PARAM_IN RecSinkPacket *pDes, PARAM_IN RecSi
     pDes->mStreamType   = pSrc->mStreamType;
     pDes->mFlags        = pSrc->mFlags;
     pDes->mPts          = pSrc->mPts;
+    pDes->mTracePts     = pSrc->mTracePts;
     pDes->mpData0       = pSrc->mpData0;
     pDes->mSize0        = pSrc->mSize0;
     pDes->mpData1       = pSrc->mpData1;
@@ -336,7 +338,15 @@ static ERRORTYPE RecSinkWriteRSPacket(RecSink *pRecSink, RecSinkPacket *pSrcPkt)
     {
 		if (pRecSink->pWriter != NULL) 
         {
+            if (CODEC_TYPE_VIDEO == pSrcPkt->mStreamType)
+            {
+                MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_MUXER, pRecSink->mMuxerId, pSrcPkt->mTracePts, -1);
+            }
             ret = pRecSink->pWriter->MuxerWritePacket(pRecSink->pMuxerCtx, pDesPkt);
+            if (CODEC_TYPE_VIDEO == pSrcPkt->mStreamType)
+            {
+                MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_MUXER, pRecSink->mMuxerId, pSrcPkt->mTracePts);
+            }
             if (ret != 0)
             {
                 aloge("fatal error! muxerId[%d]muxerWritePacket FAILED", pRecSink->mMuxerId);
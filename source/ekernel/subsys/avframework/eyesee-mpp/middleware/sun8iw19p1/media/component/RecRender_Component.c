@@ -43,6 +43,7 @@
 #include "RecRender_cache.h"
 
 #include <SystemBase.h>
+#include <mpp_frametrace.h>
 //#include <aenc_sw_lib.h>
 #include <cdx_list.h>
 
@@ -300,6 +301,7 @@ ERRORTYPE setRecSinkPacketByVEncCompOutputBuffer(PARAM_IN RECRENDERDATATYPE *pRe
     pRSPacket->mFlags = 0;
     pRSPacket->mFlags |= (pEncodedStream->nFlags & CEDARV_FLAG_KEYFRAME)? AVPACKET_FLAG_KEYFRAME : 0;
     pRSPacket->mPts = pEncodedStream->nTimeStamp - pRecRenderData->mnBasePts;
+    pRSPacket->mTracePts = pEncodedStream->nTimeStamp;
     if(iSize0 > 0)
     {
         pRSPacket->mpData0 = (char*)pEncodedStream->pBuffer;
@@ -339,6 +341,7 @@ ERRORTYPE setRecSinkPacketByAEncCompOutputBuffer(PARAM_IN RECRENDERDATATYPE *pRe
     pRSPacket->mStreamType = CODEC_TYPE_AUDIO;
     pRSPacket->mFlags = 0;
     pRSPacket->mPts = pEncodedStream->nTimeStamp - pRecRenderData->mnAudioBasePts;
+    pRSPacket->mTracePts = pEncodedStream->nTimeStamp;
     pRSPacket->mpData0 = (char*)pEncodedStream->pBuffer;
     pRSPacket->mSize0 = pEncodedStream->nFilledLen;
     pRSPacket->mpData1 = NULL;
@@ -363,6 +366,7 @@ ERRORTYPE setRecSinkPacketByTEncCompOutputBuffer(PARAM_IN RECRENDERDATATYPE *pRe
     pRSPacket->mStreamType = CODEC_TYPE_TEXT;
     pRSPacket->mFlags = 0;
     pRSPacket->mPts = pEncoderStream->nTimeStamp - pRecRenderData->mnTextBasePts;
+    pRSPacket->mTracePts = pEncoderStream->nTimeStamp;
     pRSPacket->mpData0 = (char*)pEncoderStream->pBuffer;
     pRSPacket->mSize0 = (int)pEncoderStream->nBufferLen;
     pRSPacket->mpData1 = NULL;
@@ -1942,6 +1946,7 @@ ERRORTYPE RecRenderEmptyThisBuffer(
         memcpy(&pFirstNode->stEncodedStream, pOutFrame, sizeof(EncodedStream));
         pFirstNode->mUsedRefCnt = 0;  // clear ref count when moving it to ReadyList
         list_move_tail(&pFirstNode->mList, &pRecRenderData->mVideoInputFrameReadyList);
+        MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_RECRENDER, pRecRenderData->mMppChnInfo.mChnId, pOutFrame->nTimeStamp, -1);
 
         // Send Input data valid message
         if (pRecRenderData->mNoInputFrameFlag)
@@ -3340,6 +3345,7 @@ EndProcessMessage:
                 else
                 {
                     pRecRenderData->duration = RSPacket.mPts;
+                    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_RECRENDER, pRecRenderData->mMppChnInfo.mChnId, RSPacket.mTracePts);
                 }
             }
             if(eRet!=SUCCESS)
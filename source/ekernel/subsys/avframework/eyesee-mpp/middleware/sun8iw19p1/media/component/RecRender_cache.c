@@ -60,6 +60,16 @@
 #define AVPACKET_BEGIN_FLAG				0x55AA55AA
 #define PACKET_NUM_IN_RSPACKETBUF       (1000)
 
+typedef struct RPCMDataSegment
+{
+    char*   mpBuffer;
+    int     mSize;
+    int     mReadOffset;    //oldest packet data.
+    int     mWriteOffset;
+    int     mUsedSize;
+    struct list_head mList;
+}RPCMDataSegment;
+
 typedef struct RPCMDuration
 {
     int64_t mTotalDuration;
@@ -176,6 +186,7 @@ static ERRORTYPE RPCMSetRecSinkPacket(RsPacketCacheManager *pThiz, PARAM_IN RecS
     pDes->mStreamType   = pSrc->mStreamType;
     pDes->mFlags        = pSrc->mFlags;
     pDes->mPts          = pSrc->mPts;
+    pDes->mTracePts     = pSrc->mTracePts;
     pDes->mpData0       = NULL;
     pDes->mSize0        = 0;
     pDes->mpData1       = NULL;
@@ -192,435 +203,311 @@ static ERRORTYPE RPCMSetRecSinkPacket(RsPacketCacheManager *pThiz, PARAM_IN RecS
 
 static ERRORTYPE RPCMIncreaseIdlePacketList(RsPacketCacheManager *pThiz)
 {
-    ERRORTYPE eError = SUCCESS;
     RecSinkPacket   *pRSPacket;
     int i;
+    //one block for all packets, not one malloc per packet.
+    DynamicBuffer *pDB = (DynamicBuffer*)malloc(sizeof(DynamicBuffer));
+    if(NULL == pDB)
+    {
+        aloge("fatal error! malloc fail");
+        return ERR_MUX_NOMEM;
+    }
+    pDB->mSize = sizeof(RecSinkPacket)*PACKET_NUM_IN_RSPACKETBUF;
+    pDB->mpBuffer = (char*)malloc(pDB->mSize);
+    if(NULL == pDB->mpBuffer)
+    {
+        aloge("fatal error! malloc fail");
+        free(pDB);
+        return ERR_MUX_NOMEM;
+    }
+    list_add_tail(&pDB->mList, &pThiz->mRSPacketBufList);
+    pRSPacket = (RecSinkPacket*)pDB->mpBuffer;
     for(i=0;i<PACKET_NUM_IN_RSPACKETBUF;i++)
     {
-        pRSPacket = (RecSinkPacket*)malloc(sizeof(RecSinkPacket));
-        if(NULL == pRSPacket)
-        {
-            aloge("fatal error! malloc fail");
-            eError = ERR_MUX_NOMEM;
-            break;
-        }
-        
-        list_add_tail(&pRSPacket->mList, &pThiz->mIdlePacketList);
+        list_add_tail(&pRSPacket[i].mList, &pThiz->mIdlePacketList);
     }
     return SUCCESS;
 }
 
-static ERRORTYPE RPCMIncreaseDataBufList(RsPacketCacheManager *pThiz, int nSize)
+static RPCMDataSegment *RPCMNewDataSegment(RsPacketCacheManager *pThiz, int nSize)
 {
-    DynamicBuffer *pDB = malloc(sizeof(DynamicBuffer));
-    //int ret = posix_memalign((void **)&pDB->mpBuffer, 4096, nSize);
-    //if(ret!=0)
-    //{
-    //    aloge("fatal error! malloc size[%d] fail(%s)!", nSize, strerror(errno));
-    //    goto _err0;
-    //}
-    //pDB->mpBuffer = memalign(4096, nSize);
-    pDB->mpBuffer = malloc(nSize);
-    if(NULL == pDB->mpBuffer)
+    RPCMDataSegment *pSeg = (RPCMDataSegment*)malloc(sizeof(RPCMDataSegment));
+    if(NULL == pSeg)
+    {
+        aloge("fatal error! malloc fail(%s)!", strerror(errno));
+        return NULL;
+    }
+    pSeg->mpBuffer = (char*)malloc(nSize);
+    if(NULL == pSeg->mpBuffer)
     {
         aloge("fatal error! malloc size[%d] fail(%s)!", nSize, strerror(errno));
-        goto _err0;
+        free(pSeg);
+        return NULL;
     }
-    pDB->mSize = nSize;
-    list_add_tail(&pDB->mList, &pThiz->mDataBufList);
+    pSeg->mSize = nSize;
+    pSeg->mReadOffset = 0;
+    pSeg->mWriteOffset = 0;
+    pSeg->mUsedSize = 0;
+    list_add_tail(&pSeg->mList, &pThiz->mDataBufList);
     pThiz->mBufSize += nSize;
-    return SUCCESS;
-_err0:
-    free(pDB);
-    return ERR_MUX_NOMEM;
+    return pSeg;
 }
 
+static void RPCMFreeDataSegment(RsPacketCacheManager *pThiz, RPCMDataSegment *pSeg)
+{
+    list_del(&pSeg->mList);
+    pThiz->mBufSize -= pSeg->mSize;
+    free(pSeg->mpBuffer);
+    free(pSeg);
+}
+
+static RPCMDataSegment *RPCMGetWriteSegment(RsPacketCacheManager *pThiz)
+{
+    return list_entry(pThiz->mDataBufList.prev, RPCMDataSegment, mList);
+}
 
 /*******************************************************************************
-Function name: RPCMPushPacket
+Function name: RPCMPrepareDataSegment_l
 Description: 
-    get one RecSinkPacket from idleList to readyList.
+    make room of nSize bytes in the write segment. If it is too small, append a
+    segment for the bytes of the whole cache time, estimated from the bytes
+    and time cached so far, plus 1/4 for the packets held by muxers. The
+    former segment is freed when its packets are released.
 Parameters: 
     
 Return: 
     
-Time: 2015/2/26
 *******************************************************************************/
-static ERRORTYPE RPCMPushPacket(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_IN RecSinkPacket *pRSPacket)
+static ERRORTYPE RPCMPrepareDataSegment_l(RsPacketCacheManager *pThiz, int nSize, int64_t nPts)
 {
-    RsPacketCacheManager *manager = (RsPacketCacheManager*)hComponent;
-    ERRORTYPE eError = SUCCESS;
-    int nLeftBufSize;
-    int nPacketDataSize;
-    RecSinkPacket   *pPacketEntry;
-    if (manager == NULL)
+    RPCMDataSegment *pSeg = RPCMGetWriteSegment(pThiz);
+    if(pSeg->mSize - pSeg->mUsedSize >= nSize)
     {
-        return ERR_MUX_NULL_PTR;
+        return SUCCESS;
     }
-    
-    pthread_mutex_lock(&manager->mPacketListLock);
-    //prepare idle RSPacket and dataBuffer.
-    if(list_empty(&manager->mIdlePacketList))
+    int64_t nNeedSize = (int64_t)pThiz->mUsedBufSize + nSize;
+    if(FALSE == pThiz->mIsFull && pThiz->mFirstPts >= 0)
     {
-        alogw("idlePacketList are all used, malloc more!");
-        if(SUCCESS!=RPCMIncreaseIdlePacketList(manager))
+        int64_t nDuration = (nPts - pThiz->mFirstPts)/1000;   //unit:ms
+        if(nDuration > 0 && nDuration < pThiz->mCacheTime)
         {
-            pthread_mutex_unlock(&manager->mPacketListLock);
-            return ERR_MUX_NOMEM;
+            nNeedSize = nNeedSize*pThiz->mCacheTime/nDuration;
         }
     }
-    nPacketDataSize = pRSPacket->mSize0 + pRSPacket->mSize1;
-    nLeftBufSize = manager->mBufSize - manager->mUsedBufSize;
-    if(nLeftBufSize < nPacketDataSize)
+    nNeedSize += nNeedSize/4;
+    nNeedSize = (nNeedSize + AVPACKET_CACHE_ENLARGE_SIZE - 1)/AVPACKET_CACHE_ENLARGE_SIZE*AVPACKET_CACHE_ENLARGE_SIZE;
+    if(nNeedSize > INT32_MAX/2)
     {
-        int nEnlargeSize = ((nPacketDataSize - nLeftBufSize + AVPACKET_CACHE_ENLARGE_SIZE - 1)/AVPACKET_CACHE_ENLARGE_SIZE)*AVPACKET_CACHE_ENLARGE_SIZE;
-        if(SUCCESS!=RPCMIncreaseDataBufList(manager, nEnlargeSize))
-        {
-            pthread_mutex_unlock(&manager->mPacketListLock);
-            return ERR_MUX_NOMEM;
-        }
-        nLeftBufSize = manager->mBufSize - manager->mUsedBufSize;
-        alogd("increase dataBuf size to [%d]KB! packetSize[%d]KB, leftSize[%d]KB",
-            manager->mBufSize/1024, nPacketDataSize/1024, nLeftBufSize/1024);
+        aloge("fatal error! cache size[%lld] too large!", nNeedSize);
+        return ERR_MUX_NOMEM;
     }
-    // get one RecSinkPacket from mIdlePacketList
-    pPacketEntry = list_first_entry(&manager->mIdlePacketList, RecSinkPacket, mList);
-    RPCMSetRecSinkPacket(manager, pPacketEntry, pRSPacket);
-    //if exception, discard packet.
-    if(pRSPacket->mSize0 < 0 || pRSPacket->mSize1 < 0 || (pRSPacket->mSize0==0&&pRSPacket->mSize1>0))
+    RPCMDataSegment *pNewSeg = RPCMNewDataSegment(pThiz, (int)nNeedSize);
+    if(NULL == pNewSeg)
     {
-        aloge("fatal error! packetSize[%d][%d]<0, check code!", pRSPacket->mSize0, pRSPacket->mSize1);
-        pthread_mutex_unlock(&manager->mPacketListLock);
-        return ERR_MUX_ILLEGAL_PARAM;
+        return ERR_MUX_NOMEM;
     }
-    //if empty packet, push to readyPacketList, we accept empty packet.
-    if(pRSPacket->mSize0 + pRSPacket->mSize1 <= 0)
+    alogd("new data segment [%d]KB for packetSize[%d]KB, cache used[%d]KB, all segments[%d]KB",
+        pNewSeg->mSize/1024, nSize/1024, pThiz->mUsedBufSize/1024, pThiz->mBufSize/1024);
+    if(0 == pSeg->mUsedSize)
     {
-        //alogd("empty packet, need not copy.");
-        pPacketEntry->mpData0 = manager->mpWritePos;
-        manager->mPacketCount++;
-        list_move_tail(&pPacketEntry->mList, &manager->mReadyPacketList);
-        goto _configPts;
+        RPCMFreeDataSegment(pThiz, pSeg);
     }
-    
-    int     nDataBufLeftSize;
-    char*     pWritePos = manager->mpWritePos;
-    int     nCopyLen0 = 0;
-    int     nCopyLen1 = 0;
-    int     nArrayDBPacketSize[2] = {0};
-    char*     pArrayDBPacketPtr[2] = {NULL};
-    int     nDataBufNum = 0;
-    BOOL    nLocateFlag = FALSE;
-    BOOL    nDoneFlag = FALSE;
-    DynamicBuffer   *pLocateDataBufEntry;
-    DynamicBuffer   *pDataBufEntry;
-    DynamicBuffer   *pTmpDataBufEntry;
-    //locate dataBuf by mpWritePos, copy packet data.
-    list_for_each_entry(pLocateDataBufEntry, &manager->mDataBufList, mList)
+    return SUCCESS;
+}
+
+/**
+ * copy packet data to the write segment. The data is split in two parts only
+ * where it wraps at the end of the segment.
+ */
+static void RPCMWritePacketData_l(RsPacketCacheManager *pThiz, RecSinkPacket *pDes, RecSinkPacket *pSrc)
+{
+    RPCMDataSegment *pSeg = RPCMGetWriteSegment(pThiz);
+    int nSize = pSrc->mSize0 + pSrc->mSize1;
+    if(0 == pSeg->mUsedSize)
     {
-        if(pWritePos >= pLocateDataBufEntry->mpBuffer && pWritePos < pLocateDataBufEntry->mpBuffer+pLocateDataBufEntry->mSize)
-        {
-            nLocateFlag = TRUE;
-            break;
-        }
+        pSeg->mReadOffset = pSeg->mWriteOffset = 0;
     }
-    if(!nLocateFlag)
+    pDes->mpData0 = pSeg->mpBuffer + pSeg->mWriteOffset;
+    if(pSeg->mWriteOffset + nSize <= pSeg->mSize)
     {
-        aloge("fatal error! why locate dataBuf fail?");
-        pthread_mutex_unlock(&manager->mPacketListLock);
-        return ERR_MUX_UNEXIST;
+        pDes->mSize0 = nSize;
     }
-    pDataBufEntry = pLocateDataBufEntry;
-    list_for_each_entry_from(pDataBufEntry, &manager->mDataBufList, mList)
+    else
     {
-        if(pWritePos < pDataBufEntry->mpBuffer || pWritePos >= pDataBufEntry->mpBuffer+pDataBufEntry->mSize)
-        {
-            aloge("fatal error! pWt wrong, check code!");
-        }
-        if(nDataBufNum>=2)
-        {
-            aloge("fatal error! need 3 or more dataBuf to copy packetSize[%d]KB, don't support, discard packet, modify AVPACKET_CACHE_ENLARGE_SIZE!", 
-                nPacketDataSize/1024);
-            pthread_mutex_unlock(&manager->mPacketListLock);
-            return ERR_MUX_NOT_SUPPORT;
-        }
-        pArrayDBPacketPtr[nDataBufNum] = pWritePos;
-        nDataBufLeftSize = (char*)pDataBufEntry->mpBuffer + pDataBufEntry->mSize - pWritePos;
-        if(nCopyLen0 < pRSPacket->mSize0)
+        pDes->mSize0 = pSeg->mSize - pSeg->mWriteOffset;
+        pDes->mpData1 = pSeg->mpBuffer;
+        pDes->mSize1 = nSize - pDes->mSize0;
+    }
+    //copy mpData0 and mpData1 of source as one stream.
+    char *pSrcData[2] = {pSrc->mpData0, pSrc->mpData1};
+    int nSrcSize[2] = {pSrc->mSize0, pSrc->mSize1};
+    int i;
+    for(i=0;i<2;i++)
+    {
+        int nTailSize = pSeg->mSize - pSeg->mWriteOffset;
+        if(nSrcSize[i] <= 0)
         {
-            if(nDataBufLeftSize >= pRSPacket->mSize0-nCopyLen0)
-            {
-                memcpy(pWritePos, pRSPacket->mpData0+nCopyLen0, pRSPacket->mSize0-nCopyLen0);
-                pWritePos += pRSPacket->mSize0-nCopyLen0;
-                nArrayDBPacketSize[nDataBufNum] += pRSPacket->mSize0-nCopyLen0;
-                nCopyLen0 = pRSPacket->mSize0;
-                if(pWritePos == pDataBufEntry->mpBuffer+pDataBufEntry->mSize)
-                {
-                    if(list_is_last(&pDataBufEntry->mList, &manager->mDataBufList))
-                    {
-                        pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                    }
-                    else
-                    {
-                        pTmpDataBufEntry = list_entry(pDataBufEntry->mList.next, DynamicBuffer, mList);
-                    }
-                    pWritePos = pTmpDataBufEntry->mpBuffer;
-                    //decide if copy done
-                    if(0 == pRSPacket->mSize1)
-                    {
-                        nDoneFlag = TRUE;
-                        break;
-                    }
-                    else
-                    {
-                        nDataBufNum++;
-                        continue;
-                    }
-                }
-                if(0 == pRSPacket->mSize1)
-                {
-                    nDoneFlag = TRUE;
-                    break;
-                }
-            }
-            else
-            {
-                memcpy(pWritePos, pRSPacket->mpData0+nCopyLen0, nDataBufLeftSize);
-                nArrayDBPacketSize[nDataBufNum] += nDataBufLeftSize;
-                nCopyLen0 += nDataBufLeftSize;
-                if(list_is_last(&pDataBufEntry->mList, &manager->mDataBufList))
-                {
-                    pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                }
-                else
-                {
-                    pTmpDataBufEntry = list_entry(pDataBufEntry->mList.next, DynamicBuffer, mList);
-                }
-                pWritePos = pTmpDataBufEntry->mpBuffer;
-                nDataBufNum++;
-                continue;
-            }
+            continue;
         }
-        nDataBufLeftSize = (char*)pDataBufEntry->mpBuffer+pDataBufEntry->mSize-pWritePos;
-        if(nCopyLen1 < pRSPacket->mSize1)
+        if(nSrcSize[i] <= nTailSize)
         {
-            if(nDataBufLeftSize >= pRSPacket->mSize1-nCopyLen1)
-            {
-                memcpy(pWritePos, pRSPacket->mpData1+nCopyLen1, pRSPacket->mSize1-nCopyLen1);
-                pWritePos += pRSPacket->mSize1-nCopyLen1;
-                nArrayDBPacketSize[nDataBufNum] += pRSPacket->mSize1-nCopyLen1;
-                nCopyLen1 = pRSPacket->mSize1;
-                if(pWritePos == pDataBufEntry->mpBuffer+pDataBufEntry->mSize)
-                {
-                    if(list_is_last(&pDataBufEntry->mList, &manager->mDataBufList))
-                    {
-                        pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                    }
-                    else
-                    {
-                        pTmpDataBufEntry = list_entry(pDataBufEntry->mList.next, DynamicBuffer, mList);
-                    }
-                    pWritePos = pTmpDataBufEntry->mpBuffer;
-                    nDataBufNum++;
-                }
-                nDoneFlag = TRUE;
-                break;
-            }
-            else
-            {
-                memcpy(pWritePos, pRSPacket->mpData1+nCopyLen1, nDataBufLeftSize);
-                nArrayDBPacketSize[nDataBufNum] += nDataBufLeftSize;
-                nCopyLen1 += nDataBufLeftSize;
-                if(list_is_last(&pDataBufEntry->mList, &manager->mDataBufList))
-                {
-                    pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                }
-                else
-                {
-                    pTmpDataBufEntry = list_entry(pDataBufEntry->mList.next, DynamicBuffer, mList);
-                }
-                pWritePos = pTmpDataBufEntry->mpBuffer;
-                nDataBufNum++;
-                continue;
-            }
+            memcpy(pSeg->mpBuffer + pSeg->mWriteOffset, pSrcData[i], nSrcSize[i]);
         }
         else
         {
-            aloge("fatal error! impossible come here, check code!");
+            memcpy(pSeg->mpBuffer + pSeg->mWriteOffset, pSrcData[i], nTailSize);
+            memcpy(pSeg->mpBuffer, pSrcData[i] + nTailSize, nSrcSize[i] - nTailSize);
         }
+        pSeg->mWriteOffset = (pSeg->mWriteOffset + nSrcSize[i]) % pSeg->mSize;
     }
-    if(TRUE == nDoneFlag)
-    {
-        manager->mpWritePos = pWritePos;
-        manager->mUsedBufSize+=nPacketDataSize;
-        manager->mPacketCount++;
-        pPacketEntry->mpData0 = pArrayDBPacketPtr[0];
-        pPacketEntry->mSize0 = nArrayDBPacketSize[0];
-        pPacketEntry->mpData1 = pArrayDBPacketPtr[1];
-        pPacketEntry->mSize1 = nArrayDBPacketSize[1];
-        list_move_tail(&pPacketEntry->mList, &manager->mReadyPacketList);
-        goto _configPts;
-    }
-    if(nDataBufNum>=2)
-    {
-        aloge("fatal error! need 3 or more dataBuf to copy packetSize[%d]KB, don't support, discard packet, modify AVPACKET_CACHE_ENLARGE_SIZE!", 
-            nPacketDataSize/1024);
-        pthread_mutex_unlock(&manager->mPacketListLock);
-        return ERR_MUX_NOT_SUPPORT;
-    }
-    BOOL nLoopEndFlag = FALSE;
-    list_for_each_entry(pDataBufEntry, &manager->mDataBufList, mList)
+    pSeg->mUsedSize += nSize;
+}
+
+static int RPCMGetKeyFrameId_l(RsPacketCacheManager *pThiz, int nIndex)
+{
+    return pThiz->mpKeyFrameIds[(pThiz->mKeyFrameHead + nIndex) % pThiz->mKeyFrameIdsSize];
+}
+
+static ERRORTYPE RPCMAddKeyFrame_l(RsPacketCacheManager *pThiz, int nId)
+{
+    if(pThiz->mKeyFrameNum >= pThiz->mKeyFrameIdsSize)
     {
-        if(pWritePos < pDataBufEntry->mpBuffer || pWritePos >= pDataBufEntry->mpBuffer+pDataBufEntry->mSize)
+        int nNewSize = pThiz->mKeyFrameIdsSize > 0 ? pThiz->mKeyFrameIdsSize*2 : 32;
+        int *pNewIds = (int*)malloc(sizeof(int)*nNewSize);
+        if(NULL == pNewIds)
         {
-            aloge("fatal error! pWt wrong, check code!");
+            aloge("fatal error! malloc fail");
+            return ERR_MUX_NOMEM;
         }
-        if(nLoopEndFlag)
+        int i;
+        for(i=0;i<pThiz->mKeyFrameNum;i++)
         {
-            aloge("fatal error! not enough dataBuf to contain packetSize[%d]KB? check code!", nPacketDataSize/1024);
-            break;
+            pNewIds[i] = RPCMGetKeyFrameId_l(pThiz, i);
         }
-        if(pDataBufEntry == pLocateDataBufEntry)
-        {
-            if(manager->mpReadPos < pDataBufEntry->mpBuffer || manager->mpReadPos >= pDataBufEntry->mpBuffer+pDataBufEntry->mSize)
-            {
-                aloge("fatal error! mpReadPos[%p] is wrong?[%p][%p], check code!",
-                    manager->mpReadPos, pDataBufEntry->mpBuffer, pDataBufEntry->mpBuffer+pDataBufEntry->mSize);
-            }
-            nLoopEndFlag = TRUE;
-        }
-        if(nDataBufNum>=2)
-        {
-            aloge("fatal error! need 3 or more dataBuf to copy packetSize[%d]KB, don't support, discard packet, modify AVPACKET_CACHE_ENLARGE_SIZE!", 
-                nPacketDataSize/1024);
-            pthread_mutex_unlock(&manager->mPacketListLock);
-            return ERR_MUX_NOT_SUPPORT;
-        }
-        pArrayDBPacketPtr[nDataBufNum] = pWritePos;
-        nDataBufLeftSize = (char*)pDataBufEntry->mpBuffer + pDataBufEntry->mSize - pWritePos;
-        if(nCopyLen0 < pRSPacket->mSize0)
+        free(pThiz->mpKeyFrameIds);
+        pThiz->mpKeyFrameIds = pNewIds;
+        pThiz->mKeyFrameIdsSize = nNewSize;
+        pThiz->mKeyFrameHead = 0;
+    }
+    pThiz->mpKeyFrameIds[(pThiz->mKeyFrameHead + pThiz->mKeyFrameNum) % pThiz->mKeyFrameIdsSize] = nId;
+    pThiz->mKeyFrameNum++;
+    return SUCCESS;
+}
+
+/**
+ * free the data of a released packet, which is the oldest data of the oldest
+ * segment, and return the packet to idle list.
+ */
+static ERRORTYPE RPCMReleasePacketData_l(RsPacketCacheManager *pThiz, RecSinkPacket *pReleaseEntry)
+{
+    ERRORTYPE eError = SUCCESS;
+    int nSize = pReleaseEntry->mSize0 + pReleaseEntry->mSize1;
+    if(nSize > 0)
+    {
+        RPCMDataSegment *pSeg = list_first_entry(&pThiz->mDataBufList, RPCMDataSegment, mList);
+        if(pReleaseEntry->mpData0 != pSeg->mpBuffer + pSeg->mReadOffset || nSize > pSeg->mUsedSize)
         {
-            if(nDataBufLeftSize >= pRSPacket->mSize0-nCopyLen0)
-            {
-                memcpy(pWritePos, pRSPacket->mpData0+nCopyLen0, pRSPacket->mSize0-nCopyLen0);
-                pWritePos += pRSPacket->mSize0-nCopyLen0;
-                nArrayDBPacketSize[nDataBufNum] += pRSPacket->mSize0-nCopyLen0;
-                nCopyLen0 = pRSPacket->mSize0;
-                if(pWritePos == pDataBufEntry->mpBuffer+pDataBufEntry->mSize)
-                {
-                    if(list_is_last(&pDataBufEntry->mList, &manager->mDataBufList))
-                    {
-                        pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                    }
-                    else
-                    {
-                        pTmpDataBufEntry = list_entry(pDataBufEntry->mList.next, DynamicBuffer, mList);
-                    }
-                    pWritePos = pTmpDataBufEntry->mpBuffer;
-                    //decide if copy done
-                    if(0 == pRSPacket->mSize1)
-                    {
-                        nDoneFlag = TRUE;
-                        break;
-                    }
-                    else
-                    {
-                        nDataBufNum++;
-                        continue;
-                    }
-                }
-                if(0 == pRSPacket->mSize1)
-                {
-                    nDoneFlag = TRUE;
-                    break;
-                }
-            }
-            else
-            {
-                memcpy(pWritePos, pRSPacket->mpData0+nCopyLen0, nDataBufLeftSize);
-                nArrayDBPacketSize[nDataBufNum] += nDataBufLeftSize;
-                nCopyLen0 += nDataBufLeftSize;
-                if(list_is_last(&pDataBufEntry->mList, &manager->mDataBufList))
-                {
-                    pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                }
-                else
-                {
-                    pTmpDataBufEntry = list_entry(pDataBufEntry->mList.next, DynamicBuffer, mList);
-                }
-                pWritePos = pTmpDataBufEntry->mpBuffer;
-                nDataBufNum++;
-                continue;
-            }
+            aloge("fatal error! packet[%p][%d],[%p][%d] is not the oldest data[%p][%d] of segment[%p][%d], check code!",
+                pReleaseEntry->mpData0, pReleaseEntry->mSize0, pReleaseEntry->mpData1, pReleaseEntry->mSize1,
+                pSeg->mpBuffer + pSeg->mReadOffset, pSeg->mUsedSize, pSeg->mpBuffer, pSeg->mSize);
+            eError = ERR_MUX_UNEXIST;
         }
-        nDataBufLeftSize = (char*)pDataBufEntry->mpBuffer+pDataBufEntry->mSize-pWritePos;
-        if(nCopyLen1 < pRSPacket->mSize1)
+        else
         {
-            if(nDataBufLeftSize >= pRSPacket->mSize1-nCopyLen1)
-            {
-                memcpy(pWritePos, pRSPacket->mpData1+nCopyLen1, pRSPacket->mSize1-nCopyLen1);
-                pWritePos += pRSPacket->mSize1-nCopyLen1;
-                nArrayDBPacketSize[nDataBufNum] += pRSPacket->mSize1-nCopyLen1;
-                nCopyLen1 = pRSPacket->mSize1;
-                if(pWritePos == pDataBufEntry->mpBuffer+pDataBufEntry->mSize)
-                {
-                    if(list_is_last(&pDataBufEntry->mList, &manager->mDataBufList))
-                    {
-                        pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                    }
-                    else
-                    {
-                        pTmpDataBufEntry = list_entry(pDataBufEntry->mList.next, DynamicBuffer, mList);
-                    }
-                    pWritePos = pTmpDataBufEntry->mpBuffer;
-                    nDataBufNum++;
-                }
-                nDoneFlag = TRUE;
-                break;
-            }
-            else
+            pSeg->mReadOffset = (pSeg->mReadOffset + nSize) % pSeg->mSize;
+            pSeg->mUsedSize -= nSize;
+            if(0 == pSeg->mUsedSize)
             {
-                memcpy(pWritePos, pRSPacket->mpData1+nCopyLen1, nDataBufLeftSize);
-                nArrayDBPacketSize[nDataBufNum] += nDataBufLeftSize;
-                nCopyLen1 += nDataBufLeftSize;
-                if(list_is_last(&pDataBufEntry->mList, &manager->mDataBufList))
+                if(!list_is_last(&pSeg->mList, &pThiz->mDataBufList))
                 {
-                    pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
+                    alogd("free drained data segment [%d]KB", pSeg->mSize/1024);
+                    RPCMFreeDataSegment(pThiz, pSeg);
                 }
                 else
                 {
-                    pTmpDataBufEntry = list_entry(pDataBufEntry->mList.next, DynamicBuffer, mList);
+                    pSeg->mReadOffset = pSeg->mWriteOffset = 0;
                 }
-                pWritePos = pTmpDataBufEntry->mpBuffer;
-                nDataBufNum++;
-                continue;
             }
         }
-        else
+    }
+    //ids only increase, so the key frames before this packet are gone too.
+    while(pThiz->mKeyFrameNum > 0 && RPCMGetKeyFrameId_l(pThiz, 0) <= pReleaseEntry->mId)
+    {
+        pThiz->mKeyFrameHead = (pThiz->mKeyFrameHead + 1) % pThiz->mKeyFrameIdsSize;
+        pThiz->mKeyFrameNum--;
+    }
+    pThiz->mUsedBufSize -= nSize;
+    pThiz->mPacketCount--;
+    list_move_tail(&pReleaseEntry->mList, &pThiz->mIdlePacketList);
+    return eError;
+}
+
+/*******************************************************************************
+Function name: RPCMPushPacket
+Description: 
+    get one RecSinkPacket from idleList to readyList.
+Parameters: 
+    
+Return: 
+    
+Time: 2015/2/26
+*******************************************************************************/
+static ERRORTYPE RPCMPushPacket(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_IN RecSinkPacket *pRSPacket)
+{
+    RsPacketCacheManager *manager = (RsPacketCacheManager*)hComponent;
+    ERRORTYPE eError = SUCCESS;
+    int nPacketDataSize;
+    RecSinkPacket   *pPacketEntry;
+    if (manager == NULL)
+    {
+        return ERR_MUX_NULL_PTR;
+    }
+    //if exception, discard packet.
+    if(pRSPacket->mSize0 < 0 || pRSPacket->mSize1 < 0 || (pRSPacket->mSize0==0&&pRSPacket->mSize1>0))
+    {
+        aloge("fatal error! packetSize[%d][%d]<0, check code!", pRSPacket->mSize0, pRSPacket->mSize1);
+        return ERR_MUX_ILLEGAL_PARAM;
+    }
+    
+    pthread_mutex_lock(&manager->mPacketListLock);
+    //prepare idle RSPacket and dataBuffer.
+    if(list_empty(&manager->mIdlePacketList))
+    {
+        alogw("idlePacketList are all used, malloc more!");
+        if(SUCCESS!=RPCMIncreaseIdlePacketList(manager))
         {
-            aloge("fatal error! impossible come here, check code!");
+            pthread_mutex_unlock(&manager->mPacketListLock);
+            return ERR_MUX_NOMEM;
         }
     }
-    if(TRUE == nDoneFlag)
+    nPacketDataSize = pRSPacket->mSize0 + pRSPacket->mSize1;
+    if(SUCCESS != RPCMPrepareDataSegment_l(manager, nPacketDataSize, pRSPacket->mPts))
+    {
+        pthread_mutex_unlock(&manager->mPacketListLock);
+        return ERR_MUX_NOMEM;
+    }
+    // get one RecSinkPacket from mIdlePacketList
+    pPacketEntry = list_first_entry(&manager->mIdlePacketList, RecSinkPacket, mList);
+    RPCMSetRecSinkPacket(manager, pPacketEntry, pRSPacket);
+    //we accept empty packet, it points to write position.
+    if(nPacketDataSize > 0)
     {
-        manager->mpWritePos = pWritePos;
-        manager->mUsedBufSize+=nPacketDataSize;
-        manager->mPacketCount++;
-        pPacketEntry->mpData0 = pArrayDBPacketPtr[0];
-        pPacketEntry->mSize0 = nArrayDBPacketSize[0];
-        pPacketEntry->mpData1 = pArrayDBPacketPtr[1];
-        pPacketEntry->mSize1 = nArrayDBPacketSize[1];
-        list_move_tail(&pPacketEntry->mList, &manager->mReadyPacketList);
-        goto _configPts;
+        RPCMWritePacketData_l(manager, pPacketEntry, pRSPacket);
     }
     else
     {
-        aloge("fatal error! copy [%d]KB fail!", nPacketDataSize/1024);
-        pthread_mutex_unlock(&manager->mPacketListLock);
-        return ERR_MUX_ILLEGAL_PARAM;
+        RPCMDataSegment *pSeg = RPCMGetWriteSegment(manager);
+        pPacketEntry->mpData0 = pSeg->mpBuffer + pSeg->mWriteOffset;
+    }
+    if(CODEC_TYPE_VIDEO == pPacketEntry->mStreamType && (pPacketEntry->mFlags & AVPACKET_FLAG_KEYFRAME))
+    {
+        RPCMAddKeyFrame_l(manager, pPacketEntry->mId);
     }
+    manager->mUsedBufSize += nPacketDataSize;
+    manager->mPacketCount++;
+    manager->mReadyPacketCount++;
+    list_move_tail(&pPacketEntry->mList, &manager->mReadyPacketList);
 
-_configPts:
     //config firstPts, decide if is full.
     if(manager->mFirstPts < 0)
     {
@@ -634,12 +521,6 @@ _configPts:
             manager->mIsFull = TRUE;
         }
     }
-    //verify size at last.
-    if(nPacketDataSize!=(pPacketEntry->mSize0 + pPacketEntry->mSize1) || nPacketDataSize!=(pRSPacket->mSize0+pRSPacket->mSize1))
-    {
-        aloge("fatal error! verify packetSize fail.[%d][%d][%d][%d][%d], check code!", 
-            nPacketDataSize, pPacketEntry->mSize0, pPacketEntry->mSize1, pRSPacket->mSize0, pRSPacket->mSize1);
-    }
     pthread_mutex_unlock(&manager->mPacketListLock);
     return eError;
 }
@@ -661,6 +542,7 @@ ERRORTYPE RPCMGetPacket(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_OUT RecSinkPa
         RecSinkPacket   *pEntry = list_first_entry(&manager->mReadyPacketList, RecSinkPacket, mList);
         pEntry->mRefCnt = 1;
         list_move_tail(&pEntry->mList, &manager->mUsingPacketList);
+        manager->mReadyPacketCount--;
         *ppRSPacket = pEntry;
 	}
 	else
@@ -778,67 +660,11 @@ static ERRORTYPE RPCMReleasePacket_l(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_
                 aloge("fatal error! must release first entry in using packet list! check code!");
             }
             //release packet
-            char*     pData;
-            int     nSize;
-            if(pReleaseEntry->mSize1>0)
-            {
-                pData = pReleaseEntry->mpData1;
-                nSize = pReleaseEntry->mSize1;
-            }
-            else
-            {
-                pData = pReleaseEntry->mpData0;
-                nSize = pReleaseEntry->mSize0;
-            }
-            int nFindDBFlag = 0;
-            DynamicBuffer *pDBEntry;
-            DynamicBuffer *pTmpDataBufEntry;
-            list_for_each_entry(pDBEntry, &manager->mDataBufList, mList)
-            {
-                if(pData>=pDBEntry->mpBuffer && pData<pDBEntry->mpBuffer+pDBEntry->mSize)
-                {
-                    if(0 == nFindDBFlag)
-                    {
-                        nFindDBFlag++;
-                        if(pData+nSize < pDBEntry->mpBuffer+pDBEntry->mSize)
-                        {
-                            manager->mpReadPos = pData+nSize;
-                        }
-                        else if(pData+nSize == pDBEntry->mpBuffer+pDBEntry->mSize)
-                        {
-                            if(list_is_last(&pDBEntry->mList, &manager->mDataBufList))
-                            {
-                                pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                            }
-                            else
-                            {
-                                pTmpDataBufEntry = list_entry(pDBEntry->mList.next, DynamicBuffer, mList);
-                            }
-                            manager->mpReadPos = pTmpDataBufEntry->mpBuffer;
-                        }
-                        else
-                        {
-                            aloge("fatal error! what happend? mpData0[%p][%d], mpData1[%p][%d], DB[%p][%d]check code!",
-                                pReleaseEntry->mpData0, pReleaseEntry->mSize0, pReleaseEntry->mpData1, pReleaseEntry->mSize1, pDBEntry->mpBuffer, pDBEntry->mSize);
-                        }
-                        manager->mUsedBufSize -= (pReleaseEntry->mSize0+pReleaseEntry->mSize1);
-                        manager->mPacketCount--;
-                        list_move_tail(&pReleaseEntry->mList, &manager->mIdlePacketList);
-                        nReleaseFlag = TRUE;
-                    }
-                    else
-                    {
-                        nFindDBFlag++;
-                        aloge("fatal error! find more [%d]DataBuf, check code!", nFindFlag);
-                    }
-                }
-            }
-            if(0 == nFindDBFlag)
+            if(SUCCESS != RPCMReleasePacketData_l(manager, pReleaseEntry))
             {
-                aloge("fatal error! no dataBuf is not find! packet[%p][%d],[%p][%d]", 
-                    pReleaseEntry->mpData0, pReleaseEntry->mSize0, pReleaseEntry->mpData1, pReleaseEntry->mSize1);
                 eError = ERR_MUX_UNEXIST;
             }
+            nReleaseFlag = TRUE;
         }
 	}
 	else
@@ -940,67 +766,12 @@ static ERRORTYPE RPCMReleaseReadyPacket_l(PARAM_IN COMP_HANDLETYPE hComponent, P
                 aloge("fatal error! must release first entry in using packet list! check code!");
             }
             //release packet
-            char*   pData;
-            int     nSize;
-            if(pReleaseEntry->mSize1>0)
+            manager->mReadyPacketCount--;
+            if(SUCCESS != RPCMReleasePacketData_l(manager, pReleaseEntry))
             {
-                pData = pReleaseEntry->mpData1;
-                nSize = pReleaseEntry->mSize1;
-            }
-            else
-            {
-                pData = pReleaseEntry->mpData0;
-                nSize = pReleaseEntry->mSize0;
-            }
-            int nFindDBFlag = 0;
-            DynamicBuffer *pDBEntry;
-            DynamicBuffer *pTmpDataBufEntry;
-            list_for_each_entry(pDBEntry, &manager->mDataBufList, mList)
-            {
-                if(pData>=pDBEntry->mpBuffer && pData<pDBEntry->mpBuffer+pDBEntry->mSize)
-                {
-                    if(0 == nFindDBFlag)
-                    {
-                        nFindDBFlag++;
-                        if(pData+nSize < pDBEntry->mpBuffer+pDBEntry->mSize)
-                        {
-                            manager->mpReadPos = pData+nSize;
-                        }
-                        else if(pData+nSize == pDBEntry->mpBuffer+pDBEntry->mSize)
-                        {
-                            if(list_is_last(&pDBEntry->mList, &manager->mDataBufList))
-                            {
-                                pTmpDataBufEntry = list_first_entry(&manager->mDataBufList, DynamicBuffer, mList);
-                            }
-                            else
-                            {
-                                pTmpDataBufEntry = list_entry(pDBEntry->mList.next, DynamicBuffer, mList);
-                            }
-                            manager->mpReadPos = pTmpDataBufEntry->mpBuffer;
-                        }
-                        else
-                        {
-                            aloge("fatal error! what happend? mpData0[%p][%d], mpData1[%p][%d], DB[%p][%d]check code!",
-                                pReleaseEntry->mpData0, pReleaseEntry->mSize0, pReleaseEntry->mpData1, pReleaseEntry->mSize1, pDBEntry->mpBuffer, pDBEntry->mSize);
-                        }
-                        manager->mUsedBufSize -= (pReleaseEntry->mSize0+pReleaseEntry->mSize1);
-                        manager->mPacketCount--;
-                        list_move_tail(&pReleaseEntry->mList, &manager->mIdlePacketList);
-                        nReleaseFlag = TRUE;
-                    }
-                    else
-                    {
-                        nFindDBFlag++;
-                        aloge("fatal error! find more [%d]DataBuf, check code!", nFindFlag);
-                    }
-                }
-            }
-            if(0 == nFindDBFlag)
-            {
-                aloge("fatal error! no dataBuf is not find! packet[%p][%d],[%p][%d]",
-                    pReleaseEntry->mpData0, pReleaseEntry->mSize0, pReleaseEntry->mpData1, pReleaseEntry->mSize1);
                 eError = ERR_MUX_UNEXIST;
             }
+            nReleaseFlag = TRUE;
         }
 	}
 	else
@@ -1151,12 +922,7 @@ static int RPCMGetReadyPacketCount(PARAM_IN COMP_HANDLETYPE hComponent)
 		return -1;
 	}
 	pthread_mutex_lock(&manager->mPacketListLock);
-    nCount = 0;
-    struct list_head    *pEntry;
-    list_for_each(pEntry, &manager->mReadyPacketList)
-    {
-        nCount++;
-    }
+    nCount = manager->mReadyPacketCount;
 	pthread_mutex_unlock(&manager->mPacketListLock);
 	return nCount;
 }
@@ -1170,28 +936,81 @@ ERRORTYPE RPCMQueryCacheState(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_OUT Cac
         pthread_mutex_unlock(&manager->mPacketListLock);
         return ERR_MUX_SYS_NOTREADY;
     }
-    unsigned int nUsedCacheCnt = 0;
-    unsigned int nUsedCacheSize = 0;
-    unsigned int nReadyCacheCnt = 0;
-    unsigned int nReadyCacheSize = 0;
+    pState->mValidSize = manager->mUsedBufSize/1024;
+    pState->mTotalSize = manager->mBufSize/1024;
+    pState->mValidSizePercent = pState->mValidSize*100/pState->mTotalSize;
+    alogv("manager[%p][%d]MB packetCnt[%d], readyPacketCnt[%d], usedSize[%d], sizePercent[%d]!", 
+        manager, manager->mBufSize/(1024*1024), manager->mPacketCount, manager->mReadyPacketCount, manager->mUsedBufSize, pState->mValidSizePercent);
+    pthread_mutex_unlock(&manager->mPacketListLock);
+    return SUCCESS;
+}
+
+static RecSinkPacket *RPCMGetEarlistPacket_l(RsPacketCacheManager *manager)
+{
+    if(!list_empty(&manager->mUsingPacketList))
+    {
+        return list_first_entry(&manager->mUsingPacketList, RecSinkPacket, mList);
+    }
+    if(!list_empty(&manager->mReadyPacketList))
+    {
+        return list_first_entry(&manager->mReadyPacketList, RecSinkPacket, mList);
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+Function name: RPCMReleaseEarlistGop
+Description: 
+    release the packets before the next video key frame found in key frame index,
+    so the cache still begins with a key frame.
+Parameters: 
+    
+Return: 
+    SUCCESS: release one gop.
+    ERR_MUX_BUF_EMPTY: no next key frame is cached, the gop is not complete.
+    others: return value of RPCMReleaseEarlistPacket().
+*******************************************************************************/
+static ERRORTYPE RPCMReleaseEarlistGop(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_IN BOOL bForce)
+{
+    RsPacketCacheManager *manager = (RsPacketCacheManager*)hComponent;
+    ERRORTYPE eError = SUCCESS;
     RecSinkPacket *pEntry;
-    list_for_each_entry(pEntry, &manager->mUsingPacketList, mList)
+    int nEndId;
+    pthread_mutex_lock(&manager->mPacketListLock);
+    pEntry = RPCMGetEarlistPacket_l(manager);
+    if(NULL == pEntry || 0 == manager->mKeyFrameNum)
     {
-        nUsedCacheSize += pEntry->mSize0+pEntry->mSize1;
-        nUsedCacheCnt++;
+        pthread_mutex_unlock(&manager->mPacketListLock);
+        return ERR_MUX_BUF_EMPTY;
     }
-    list_for_each_entry(pEntry, &manager->mReadyPacketList, mList)
+    nEndId = RPCMGetKeyFrameId_l(manager, 0);
+    if(pEntry->mId >= nEndId)
     {
-        nReadyCacheSize += pEntry->mSize0+pEntry->mSize1;
-        nReadyCacheCnt++;
+        if(manager->mKeyFrameNum < 2)
+        {
+            pthread_mutex_unlock(&manager->mPacketListLock);
+            return ERR_MUX_BUF_EMPTY;
+        }
+        nEndId = RPCMGetKeyFrameId_l(manager, 1);
     }
-    pState->mValidSize = (nUsedCacheSize+nReadyCacheSize)/1024;
-    pState->mTotalSize = manager->mBufSize/1024;
-    pState->mValidSizePercent = pState->mValidSize*100/pState->mTotalSize;
-    alogv("manager[%p][%d]MB usingPacketCnt[%d], usingSize[%d], readyPacketCnt[%d], readySize[%d], sizePercent[%d]!", 
-        manager, manager->mBufSize/(1024*1024), nUsedCacheCnt, nUsedCacheSize, nReadyCacheCnt, nReadyCacheSize, pState->mValidSizePercent);
     pthread_mutex_unlock(&manager->mPacketListLock);
-    return SUCCESS;
+    while(1)
+    {
+        pthread_mutex_lock(&manager->mPacketListLock);
+        pEntry = RPCMGetEarlistPacket_l(manager);
+        BOOL bDone = (NULL == pEntry || pEntry->mId >= nEndId) ? TRUE : FALSE;
+        pthread_mutex_unlock(&manager->mPacketListLock);
+        if(bDone)
+        {
+            break;
+        }
+        eError = RPCMReleaseEarlistPacket(manager, bForce);
+        if(eError != SUCCESS)
+        {
+            break;
+        }
+    }
+    return eError;
 }
 
 static ERRORTYPE RPCMControlCacheLevel(PARAM_IN COMP_HANDLETYPE hComponent)
@@ -1221,7 +1040,12 @@ static ERRORTYPE RPCMControlCacheLevel(PARAM_IN COMP_HANDLETYPE hComponent)
                 nForceFlag = FALSE;
             }
         }
-        eError = RPCMReleaseEarlistPacket(manager, nForceFlag);
+        //release whole gops, one gop longer than cache time is released packet by packet.
+        eError = RPCMReleaseEarlistGop(manager, nForceFlag);
+        if(ERR_MUX_BUF_EMPTY == eError)
+        {
+            eError = RPCMReleaseEarlistPacket(manager, nForceFlag);
+        }
         if(SUCCESS == eError)
         {
             continue;
@@ -1365,18 +1189,15 @@ ERRORTYPE RPCMGetUsingPacketList(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_OUT
 ERRORTYPE RsPacketCacheManagerInit(RsPacketCacheManager *pThiz, int64_t nCacheTime)
 {
     int ret;
-    DynamicBuffer   *pDataBufEntry;
-    DynamicBuffer   *pEntry, *pTmp;
 	if (nCacheTime <= 0)
 	{
 		return ERR_MUX_ILLEGAL_PARAM;
 	}
     INIT_LIST_HEAD(&pThiz->mDataBufList);
-    pThiz->mpWritePos = NULL;
-    pThiz->mpReadPos = NULL;
     pThiz->mUsedBufSize = 0;
     pThiz->mBufSize = 0;
     pThiz->mPacketCount = 0;
+    pThiz->mReadyPacketCount = 0;
     pThiz->mCacheTime = nCacheTime;
     pThiz->mFirstPts = -1;
     pThiz->mIsFull = FALSE;
@@ -1399,11 +1220,15 @@ ERRORTYPE RsPacketCacheManagerInit(RsPacketCacheManager *pThiz, int64_t nCacheTi
         goto _err1;
     }
     
-    //INIT_LIST_HEAD(&pThiz->mRSPacketBufList);
+    INIT_LIST_HEAD(&pThiz->mRSPacketBufList);
     INIT_LIST_HEAD(&pThiz->mIdlePacketList);
     INIT_LIST_HEAD(&pThiz->mReadyPacketList);
     INIT_LIST_HEAD(&pThiz->mUsingPacketList);
     pThiz->mPacketIdCounter = 0;
+    pThiz->mpKeyFrameIds = NULL;
+    pThiz->mKeyFrameIdsSize = 0;
+    pThiz->mKeyFrameHead = 0;
+    pThiz->mKeyFrameNum = 0;
 
     pThiz->PushPacket = RPCMPushPacket;
     pThiz->GetPacket = RPCMGetPacket;
@@ -1416,8 +1241,8 @@ ERRORTYPE RsPacketCacheManagerInit(RsPacketCacheManager *pThiz, int64_t nCacheTi
     pThiz->LockPacketList = RPCMLockPacketList;
     pThiz->UnlockPacketList = RPCMUnlockPacketList;
     pThiz->GetUsingPacketList = RPCMGetUsingPacketList;
-    //malloc fisrt data buffer here.
-    if(SUCCESS!=RPCMIncreaseDataBufList(pThiz, AVPACKET_CACHE_SIZE*sizeof(char)))
+    //malloc fisrt data segment here, it grows with the bitrate.
+    if(NULL == RPCMNewDataSegment(pThiz, AVPACKET_CACHE_SIZE*sizeof(char)))
     {
         goto _err2;
     }
@@ -1426,23 +1251,10 @@ ERRORTYPE RsPacketCacheManagerInit(RsPacketCacheManager *pThiz, int64_t nCacheTi
     {
         goto _err3;
     }
-    //init mpWritePos, mpReadPos
-    pDataBufEntry = list_first_entry(&pThiz->mDataBufList, DynamicBuffer, mList);
-    pThiz->mpWritePos = pThiz->mpReadPos = pDataBufEntry->mpBuffer;
 	return SUCCESS;
 
 _err3:
-    list_for_each_entry_safe(pEntry, pTmp, &pThiz->mDataBufList, mList)
-    {
-        if(pEntry->mpBuffer)
-        {
-            free(pEntry->mpBuffer);
-            pEntry->mpBuffer = NULL;
-        }
-        pEntry->mSize = 0;
-        list_del(&pEntry->mList);
-        free(pEntry);
-    }
+    RPCMFreeDataSegment(pThiz, list_first_entry(&pThiz->mDataBufList, RPCMDataSegment, mList));
 _err2:
     pthread_cond_destroy(&pThiz->mCondReleaseUsingPacket);
 _err1:
@@ -1478,23 +1290,21 @@ ERRORTYPE RsPacketCacheManagerDestroy(RsPacketCacheManager *pThiz)
         }
         alogd("release [%d]using packet!", cnt);
     }
-    list_for_each_entry_safe(pPktEntry, pPktTmp, &pThiz->mIdlePacketList, mList)
-    {
-        list_del(&pPktEntry->mList);
-        free(pPktEntry);
-    }
     DynamicBuffer *pEntry, *pTmp;
-    list_for_each_entry_safe(pEntry, pTmp, &pThiz->mDataBufList, mList)
+    list_for_each_entry_safe(pEntry, pTmp, &pThiz->mRSPacketBufList, mList)
     {
-        if(pEntry->mpBuffer)
-        {
-            free(pEntry->mpBuffer);
-            pEntry->mpBuffer = NULL;
-        }
-        pEntry->mSize = 0;
+        free(pEntry->mpBuffer);
         list_del(&pEntry->mList);
         free(pEntry);
     }
+    RPCMDataSegment *pSegEntry, *pSegTmp;
+    list_for_each_entry_safe(pSegEntry, pSegTmp, &pThiz->mDataBufList, mList)
+    {
+        RPCMFreeDataSegment(pThiz, pSegEntry);
+    }
+    free(pThiz->mpKeyFrameIds);
+    pThiz->mpKeyFrameIds = NULL;
+    pThiz->mKeyFrameNum = 0;
     INIT_LIST_HEAD(&pThiz->mIdlePacketList);
     INIT_LIST_HEAD(&pThiz->mReadyPacketList);
     INIT_LIST_HEAD(&pThiz->mUsingPacketList);
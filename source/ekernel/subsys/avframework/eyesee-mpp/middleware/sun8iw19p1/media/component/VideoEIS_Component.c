@@ -30,6 +30,7 @@
 #include "cdx_list.h"
 
 #include "SystemBase.h"
+#include "mpp_frametrace.h"
 #include <VIDEO_FRAME_INFO_S.h>
 #include "mm_comm_eis.h"
 #include "mm_comm_video.h"
@@ -2832,6 +2833,8 @@ static void *EIS_CompStabThread(void *pThreadData)
             }
             iSelfProcTest++;
 #else
+            MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_EIS, pVideoEISData->mMppChnInfo.mChnId, pVInFrm->VFrame.mpts,
+                __builtin_popcountll(pVideoEISData->mEisPktMap));
             EIS_setFrameData(&pVideoEISData->mEisHd, pEisProcPkt);
             pVideoEISData->dEisGetInputFrmCnt++;
             if (pVideoEISData->mEISAttr.bRetInFrmFast &&
@@ -2905,9 +2908,11 @@ static void *EIS_CompStabThread(void *pThreadData)
                     * or valid frame list.
                     */
                     if (bCanGetOutBuf) {
-                        if (pVideoInBufTmp)
+                        if (pVideoInBufTmp) {
                             pVFrmOutputCur->mFrame.VFrame.mpts = stVideoInBufRetTmp.VFrame.mpts;
-                        else
+                            MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_EIS, pVideoEISData->mMppChnInfo.mChnId,
+                                stVideoInBufRetTmp.VFrame.mpts);
+                        } else
                             pVFrmOutputCur->mFrame.VFrame.mpts = 0;
 
                         if (FALSE == pVideoEISData->bOutputPortTunnelFlag) {
@@ -37,6 +37,7 @@
 
 //media api headers to app
 #include "SystemBase.h"
+#include "mpp_frametrace.h"
 #include "mm_common.h"
 #include "mm_comm_video.h"
 #include "mm_comm_venc.h"
@@ -3582,6 +3583,36 @@ ERRORTYPE VideoEncGetStreamBufInfo(
     return eError;
 }
 
+ERRORTYPE VideoEncGetFrameSizeHistory(
+        PARAM_IN COMP_HANDLETYPE hComponent,
+        PARAM_INOUT VENC_FRAME_SIZE_HISTORY_S *pHistory)
+{
+    VIDEOENCDATATYPE *pVideoEncData = (VIDEOENCDATATYPE *) (((MM_COMPONENTTYPE*) hComponent)->pComponentPrivate);
+    unsigned int nSeq, nFirst, i;
+    pthread_mutex_lock(&pVideoEncData->mOutFrameListMutex);
+    nSeq = pVideoEncData->mFrameSizeSeq;
+    nFirst = pHistory->mSeq;
+    pHistory->mLost = 0;
+    if((int)(nSeq - nFirst) < 0)
+    {
+        alogw("seq[%u] is after the frames encoded[%u]", nFirst, nSeq);
+        nFirst = nSeq;
+    }
+    if(nSeq - nFirst > VENC_FRAME_SIZE_HISTORY_NUM)
+    {
+        pHistory->mLost = nSeq - nFirst - VENC_FRAME_SIZE_HISTORY_NUM;
+        nFirst = nSeq - VENC_FRAME_SIZE_HISTORY_NUM;
+    }
+    for(i = 0; nFirst + i != nSeq; i++)
+    {
+        pHistory->mFrames[i] = pVideoEncData->mFrameSizeHistory[(nFirst + i) % VENC_FRAME_SIZE_HISTORY_NUM];
+    }
+    pHistory->mNum = i;
+    pHistory->mSeq = nSeq;
+    pthread_mutex_unlock(&pVideoEncData->mOutFrameListMutex);
+    return SUCCESS;
+}
+
 ERRORTYPE VideoEncGetSuperFrameCfg(
         PARAM_IN COMP_HANDLETYPE hComponent, 
         PARAM_OUT VENC_SUPERFRAME_CFG_S* pSuperFrmParam)
@@ -4822,6 +4853,11 @@ ERRORTYPE VideoEncGetConfig(
             eError = VideoEncGetStreamBufInfo(hComponent, (VENC_STREAM_BUF_INFO_S*)pComponentConfigStructure);
             break;
         }
+        case COMP_IndexVendorVencFrameSizeHistory:
+        {
+            eError = VideoEncGetFrameSizeHistory(hComponent, (VENC_FRAME_SIZE_HISTORY_S*)pComponentConfigStructure);
+            break;
+        }
         case COMP_IndexVendorVencRcPriority:
         {
             alogw("unsupported temporary: VencRcPriority");
@@ -5540,6 +5576,8 @@ ERRORTYPE VideoEncEmptyThisBuffer(
         pVideoEncData->mPrevInputPts = pEncFrame->VFrame.mpts;
         memcpy(pDstEncFrame, pEncFrame, sizeof(VIDEO_FRAME_INFO_S));
         alogv("wr buf_id: %d, nTimeStamp: [%lld]us", pDstEncFrame->mId, pDstEncFrame->VFrame.mpts);
+        MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_VENC, pVideoEncData->mMppChnInfo.mChnId, pEncFrame->VFrame.mpts,
+            ENC_FIFO_LEVEL - pVideoEncData->mBufQ.buf_unused);
         pVideoEncData->mBufQ.buf_unused--;
         list_move_tail(&pFirstNode->mList, &pVideoEncData->mBufQ.mReadyFrameList);
         /*int cnt = 0;
@@ -6724,6 +6762,15 @@ PROCESS_MESSAGE:
                 ret = VideoEncodeOneFrame(pCedarV);
                 //pthread_mutex_unlock(&pVideoEncData->mVencOverlayLock);
                 MPP_AtraceEnd(ATRACE_TAG_MPP_VENC);
+                //a failed frame kept for another try stays in the stage
+                if(VENC_RESULT_OK == ret)
+                {
+                    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, pVideoEncData->mMppChnInfo.mChnId, pFrameNode->VFrame.VFrame.mpts);
+                }
+                else if(FALSE == pVideoEncData->mbForbidDiscardingFrame)
+                {
+                    MPP_FrameTraceDrop(MPP_FRAMETRACE_STAGE_VENC, pVideoEncData->mMppChnInfo.mChnId, pFrameNode->VFrame.VFrame.mpts);
+                }
                 pVideoEncData->mDbgEncodeCnt++;
 
                 //alogd("encodeRet[0x%x]", ret);
@@ -7020,6 +7067,11 @@ PROCESS_MESSAGE:
 //                                    dstPicSize.Width, dstPicSize.Height);
 //                            }
                         }
+                        VENC_FRAME_SIZE_S *pFrameSize = &pVideoEncData->mFrameSizeHistory[pVideoEncData->mFrameSizeSeq % VENC_FRAME_SIZE_HISTORY_NUM];
+                        pFrameSize->mPts = stOutputBuffer.nPts;
+                        pFrameSize->mSize = stOutputBuffer.nSize0 + stOutputBuffer.nSize1;
+                        pFrameSize->mbKeyFrame = (stOutputBuffer.nFlag & VENC_BUFFERFLAG_KEYFRAME) ? TRUE : FALSE;
+                        pVideoEncData->mFrameSizeSeq++;
                         //alogd("encode outPts[%lld]us, flag[0x%x], [%p][%d][%p][%d]", pOutFrame->mOutBuf.nPts, pOutFrame->mOutBuf.nFlag, pOutFrame->mOutBuf.pData0, pOutFrame->mOutBuf.nSize0, pOutFrame->mOutBuf.pData1, pOutFrame->mOutBuf.nSize1);
                         //if(pOutFrame->mOutBuf.nFlag & VENC_BUFFERFLAG_KEYFRAME)
                         //{
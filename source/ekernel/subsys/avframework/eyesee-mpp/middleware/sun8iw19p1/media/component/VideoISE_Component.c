@@ -27,6 +27,7 @@
 #include <sys/time.h>
 // media api headers to app
 #include "SystemBase.h"
+#include "mpp_frametrace.h"
 #include "mm_comm_ise.h"
 #include "mm_comm_vi.h"
 #include "mm_comm_video.h"
@@ -2387,6 +2388,8 @@ ERRORTYPE VideoIseEmptyThisBuffer(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_IN
             pFirstNode->mInYuvPort = ISE_PORT_INDEX_CAP0_IN;
             pVideoIseData->mBufQ.buf_unused--;
             list_move_tail(&pFirstNode->mList, &pVideoIseData->mBufQ.mReadyFrameList);
+            MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_ISE, pVideoIseData->mMppChnInfo.mChnId, pDstIseFrame->VFrame.mpts,
+                ISE_FIFO_LEVEL - pVideoIseData->mBufQ.buf_unused);
             pthread_mutex_unlock(&pVideoIseData->mutex_fifo_ops_lock);
         }
         else if (pBuffer->nInputPortIndex == pVideoIseData->sInPortDef[ISE_PORT_INDEX_CAP1_IN].nPortIndex)
@@ -2463,6 +2466,8 @@ ERRORTYPE VideoIseEmptyThisBuffer(PARAM_IN COMP_HANDLETYPE hComponent, PARAM_IN
             pFirstNode->mInYuvPort = ISE_PORT_INDEX_CAP0_IN;
             pVideoIseData->mBufQ.buf_unused--;
             list_move_tail(&pFirstNode->mList, &pVideoIseData->mBufQ.mReadyFrameList);
+            MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_ISE, pVideoIseData->mMppChnInfo.mChnId, pDstIseFrame->VFrame.mpts,
+                ISE_FIFO_LEVEL - pVideoIseData->mBufQ.buf_unused);
         }
         // chn1
         if (((pVideoIseData->iseMode == ISEMODE_TWO_FISHEYE) && (NULL != pIseFrame1)) ||
@@ -3255,6 +3260,7 @@ PROCESS_MESSAGE:
                     {
                         uint64_t pts = pFrameNode->mInYuv.VFrame.mpts;
                         unsigned int exptime = pFrameNode->mInYuv.VFrame.mExposureTime;
+                        MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_ISE, pVideoIseData->mMppChnInfo.mChnId, pts);
                         list_for_each_entry(pEntry, &pVideoIseData->mValidChnAttrList, mList)
                         {
                             if ((0 == pEntry->mIseChn) || (1 == pEntry->mIseChn) ||
@@ -3420,6 +3426,7 @@ PROCESS_MESSAGE:
                     if (!list_empty(&(pVideoIseData->mValidChnAttrList)))
                     {
                         uint64_t pts = pFrameNode->mInYuv.VFrame.mpts;
+                        MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_ISE, pVideoIseData->mMppChnInfo.mChnId, pts);
                         list_for_each_entry(pEntry, &pVideoIseData->mValidChnAttrList, mList)
                         {
                             if ((0 == pEntry->mIseChn) || (1 == pEntry->mIseChn) ||
@@ -3613,6 +3620,7 @@ PROCESS_MESSAGE:
                     if (!list_empty(&(pVideoIseData->mValidChnAttrList)))
                     {
                         uint64_t pts = pFrameNode->mInYuv.VFrame.mpts;
+                        MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_ISE, pVideoIseData->mMppChnInfo.mChnId, pts);
                         list_for_each_entry(pEntry, &pVideoIseData->mValidChnAttrList, mList)
                         {
                             if ((0 == pEntry->mIseChn) || (1 == pEntry->mIseChn) ||
@@ -55,6 +55,7 @@ typedef struct RecSinkPacket {
     int     mStreamType;   //CodecType
     int     mFlags;  //AVPACKET_FLAGS
     int64_t     mPts;   //unit:us
+    int64_t     mTracePts;  //pts before the base pts is taken off, it is the frame's key in mpp_frametrace.
     char*     mpData0;
     int     mSize0;
     char*     mpData1;
@@ -7,13 +7,19 @@
 //media internal common headers.
 #include "mm_component.h"
 
+/*
+ * Packet data is kept in contiguous ring segments. Only the last segment is
+ * written; when a packet does not fit, a bigger segment sized by the byte rate
+ * of the cache time is appended, and the former ones are freed as soon as
+ * their packets are released. Video key frames are indexed so that the cache
+ * level is controlled by evicting whole GOPs.
+ */
 typedef struct RsPacketCacheManager {
-    struct list_head    mDataBufList;   //DynamicBuffer
-    char*             mpWritePos;
-    char*             mpReadPos;
-    int             mUsedBufSize;
-    int             mBufSize;
+    struct list_head    mDataBufList;   //RPCMDataSegment, oldest first.
+    int             mUsedBufSize;   //data size of all cached packets.
+    int             mBufSize;       //size of all segments.
     int             mPacketCount;
+    int             mReadyPacketCount;
     int64_t             mCacheTime; //unit:ms
     int64_t             mFirstPts;  //unit:us
     volatile BOOL   mIsFull;
@@ -21,11 +27,15 @@ typedef struct RsPacketCacheManager {
     int             mWaitReleaseUsingPacketId;
     pthread_cond_t      mCondReleaseUsingPacket;
     pthread_mutex_t     mPacketListLock;
-    //struct list_head    mRSPacketBufList;   //DynamicBuffer, sizeof(RecSinkPacket)*PACKET_NUM_IN_RSPACKETBUF
+    struct list_head    mRSPacketBufList;   //DynamicBuffer, sizeof(RecSinkPacket)*PACKET_NUM_IN_RSPACKETBUF
     struct list_head    mIdlePacketList; //RecSinkPacket
     struct list_head    mReadyPacketList;
     struct list_head    mUsingPacketList;
     int             mPacketIdCounter;
+    int*            mpKeyFrameIds;  //ring of the packet ids of cached video key frames, oldest first.
+    int             mKeyFrameIdsSize;
+    int             mKeyFrameHead;
+    int             mKeyFrameNum;
 
     ERRORTYPE (*PushPacket)(
         PARAM_IN COMP_HANDLETYPE hComponent,
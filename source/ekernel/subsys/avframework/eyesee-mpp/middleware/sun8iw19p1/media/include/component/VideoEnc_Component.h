@@ -222,6 +222,8 @@ typedef struct VIDEOENCDATATYPE {
     int64_t mTotalEncodeSuccessDuration;
     unsigned int mStatMaxFrameSize;
     int64_t mStatStreamSize;    //stat encode stream total size
+    VENC_FRAME_SIZE_S mFrameSizeHistory[VENC_FRAME_SIZE_HISTORY_NUM];  //protected by mOutFrameListMutex
+    unsigned int mFrameSizeSeq; //frames put in mFrameSizeHistory
 
     VencHighPassFilter mVencHighPassFilter;
     int DayOrNight;     // 0:day;1:night
@@ -331,6 +333,9 @@ ERRORTYPE VideoEncSetCropCfg(
 ERRORTYPE VideoEncGetStreamBufInfo(
         PARAM_IN COMP_HANDLETYPE hComponent,
         PARAM_OUT VENC_STREAM_BUF_INFO_S *pStreamBufInfo);
+ERRORTYPE VideoEncGetFrameSizeHistory(
+        PARAM_IN COMP_HANDLETYPE hComponent,
+        PARAM_INOUT VENC_FRAME_SIZE_HISTORY_S *pHistory);
 ERRORTYPE VideoEncExtraData(
         PARAM_IN COMP_HANDLETYPE hComponent, 
         PARAM_OUT VencHeaderData *pVencHeaderData);
@@ -362,6 +362,7 @@ typedef enum COMP_INDEXTYPE {
     COMP_IndexVendorVencBinImageData,       /**< reference: VENC_BinImageBuf */
     COMP_IndexVendorVencEnableMvInfo,       /**< reference: BOOL */
     COMP_IndexVendorVencMvInfoData,         /**< reference: VENC_MvInfoBuf */
+    COMP_IndexVendorVencFrameSizeHistory,   /**< reference: VENC_FRAME_SIZE_HISTORY_S */
 
     // below for aenc
     COMP_IndexVendorAencChnAttr = 0x7F002200,        /**< reference: AENC_CHN_ATTR_S */
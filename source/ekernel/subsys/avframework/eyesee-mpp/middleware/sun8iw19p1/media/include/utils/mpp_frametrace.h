@@ -0,0 +1,68 @@
+/******************************************************************************
+  Copyright (C), 2001-2016, Allwinner Tech. Co., Ltd.
+ ******************************************************************************
+  File Name     : mpp_frametrace.h
+  Version       : Initial Draft
+  Author        : Allwinner PDC-PD5 Team
+  Created       : 2020/11/16
+  Last Modified :
+  Description   : built-in frame latency tracing of the mpp components
+  Function List :
+  History       :
+******************************************************************************/
+#ifndef _MPP_FRAMETRACE_H_
+#define _MPP_FRAMETRACE_H_
+
+#include <stdint.h>
+#include "plat_type.h"
+#include "mm_comm_sys.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A frame is known by its capture pts, which every stage keeps: VI records
+ * when it got the frame, the other stages when a frame enters and leaves
+ * them, or when a stage gives up a frame it entered (drop). Channels tell
+ * apart several instances of one stage; nDepth is the number of frames
+ * queued in the stage, -1 if unknown.
+ */
+#ifdef MPPCFG_FRAMETRACE
+
+#define MPP_FRAMETRACE_EVENT_NUM    (2048)  //events kept for the dump, a power of 2
+
+extern volatile int gMppFrameTraceEnable;
+
+void MppFrameTraceCapture(int nChn, int64_t nPts);
+void MppFrameTraceEnter(MPP_FRAMETRACE_STAGE_E eStage, int nChn, int64_t nPts, int nDepth);
+void MppFrameTraceExit(MPP_FRAMETRACE_STAGE_E eStage, int nChn, int64_t nPts);
+void MppFrameTraceDrop(MPP_FRAMETRACE_STAGE_E eStage, int nChn, int64_t nPts);
+
+ERRORTYPE MppFrameTraceSetEnable(BOOL bEnable);
+ERRORTYPE MppFrameTraceGetStat(MPP_FRAMETRACE_STAGE_E eStage, MPP_FRAMETRACE_STAT_S *pStat);
+ERRORTYPE MppFrameTraceDump(const char *pFilePath);
+
+#define MPP_FrameTraceCapture(chn, pts) \
+    do { if(gMppFrameTraceEnable) MppFrameTraceCapture(chn, pts); } while(0)
+#define MPP_FrameTraceEnter(stage, chn, pts, depth) \
+    do { if(gMppFrameTraceEnable) MppFrameTraceEnter(stage, chn, pts, depth); } while(0)
+#define MPP_FrameTraceExit(stage, chn, pts) \
+    do { if(gMppFrameTraceEnable) MppFrameTraceExit(stage, chn, pts); } while(0)
+#define MPP_FrameTraceDrop(stage, chn, pts) \
+    do { if(gMppFrameTraceEnable) MppFrameTraceDrop(stage, chn, pts); } while(0)
+
+#else
+
+#define MPP_FrameTraceCapture(chn, pts)
+#define MPP_FrameTraceEnter(stage, chn, pts, depth)
+#define MPP_FrameTraceExit(stage, chn, pts)
+#define MPP_FrameTraceDrop(stage, chn, pts)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _MPP_FRAMETRACE_H_ */
@@ -31,6 +31,12 @@ extern "C" {
 
 #define MAX_MESSAGE_ELEMENTS (8)    //20000
 
+//entries of the lock-free ring of a message queue, a power of 2.
+//messages which do not fit go to a list under the mutex.
+#ifndef MESSAGE_RING_DEPTH
+#define MESSAGE_RING_DEPTH (32)
+#endif
+
 //typedef struct message_t message_t;
 typedef struct message_t
 {
@@ -44,15 +50,28 @@ typedef struct message_t
 	struct list_head    mList;
 }message_t;
 
+typedef struct message_slot_t
+{
+    volatile unsigned int mSeq;     //ring position it can be written at, +1 when it holds a message
+    int                 command;
+    int                 para0;
+    int                 para1;
+    void*               mpData;
+    int                 mDataSize;
+}message_slot_t;
+
 typedef struct message_queue_t
 {
+    message_slot_t*     mpRing;     //MESSAGE_RING_DEPTH entries, allocated in message_create()
+    volatile unsigned int mRingHead;    //next position to read
+    volatile unsigned int mRingTail;    //next position to write
+    volatile int        mSpillCount;    //messages in mReadyMessageList, changed under mutex
     struct list_head    mIdleMessageList;   //message_t
-    struct list_head    mReadyMessageList;   //message_t
+    struct list_head    mReadyMessageList;   //message_t, put while the ring was full
     //struct list_head    mMessageBufList;   //DynamicBuffer, sizeof(message_t)*MAX_MESSAGE_ELEMENTS
-	int                 message_count;
 	pthread_mutex_t     mutex;
     pthread_cond_t      mCondMessageQueueChanged;
-    int                 mWaitMessageFlag;
+    volatile int        mWaitMessageFlag;   //threads sleeping in TMessage_WaitQueueNotEmpty()
 }message_queue_t;
 
 int  message_create(message_queue_t* message);
@@ -61,6 +80,7 @@ void flush_message(message_queue_t* msg_queue);
 int  put_message(message_queue_t* msg_queue, message_t *msg_in);
 int  get_message(message_queue_t* msg_queue, message_t *msg_out);
 int putMessageWithData(message_queue_t* msg_queue, message_t *msg_in);
+int putMessageWithDataRef(message_queue_t* msg_queue, message_t *msg_in);
 int  get_message_count(message_queue_t* message);
 int TMessage_WaitQueueNotEmpty(message_queue_t* msg_queue, unsigned int timeout);   //unit:ms
 
@@ -50,6 +50,7 @@
 #include <mpi_isp.h>
 //#include <mpi_vi.h>
 #include <SystemBase.h>
+#include <mpp_frametrace.h>
 #include <memoryAdapter.h>
 #include <sc_interface.h>
 #include <audio_hw.h>
@@ -1821,3 +1822,31 @@ ERRORTYPE AW_MPI_SYS_HANDLE_Select(handle_set *pRdFds, int nMilliSecs)
     return retval;
 }
 
+
+ERRORTYPE AW_MPI_SYS_EnableFrameTrace(BOOL bEnable)
+{
+#ifdef MPPCFG_FRAMETRACE
+    return MppFrameTraceSetEnable(bEnable);
+#else
+    alogw("frame trace is not configured");
+    return ERR_SYS_NOT_SUPPORT;
+#endif
+}
+
+ERRORTYPE AW_MPI_SYS_GetFrameTraceStat(MPP_FRAMETRACE_STAGE_E eStage, MPP_FRAMETRACE_STAT_S* pStat)
+{
+#ifdef MPPCFG_FRAMETRACE
+    return MppFrameTraceGetStat(eStage, pStat);
+#else
+    return ERR_SYS_NOT_SUPPORT;
+#endif
+}
+
+ERRORTYPE AW_MPI_SYS_DumpFrameTrace(const char* pFilePath)
+{
+#ifdef MPPCFG_FRAMETRACE
+    return MppFrameTraceDump(pFilePath);
+#else
+    return ERR_SYS_NOT_SUPPORT;
+#endif
+}
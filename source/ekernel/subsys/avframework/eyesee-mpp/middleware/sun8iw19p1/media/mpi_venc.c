@@ -733,6 +733,30 @@ ERRORTYPE AW_MPI_VENC_Query(VENC_CHN VeChn, VENC_CHN_STAT_S *pStat)
     return ret;
 }
 
+ERRORTYPE AW_MPI_VENC_GetFrameSizeHistory(VENC_CHN VeChn, VENC_FRAME_SIZE_HISTORY_S *pHistory)
+{
+    if(!(VeChn>=0 && VeChn <VENC_MAX_CHN_NUM))
+    {
+        aloge("fatal error! invalid VeChn[%d]!", VeChn);
+        return ERR_VENC_INVALID_CHNID;
+    }
+    VENC_CHN_MAP_S *pChn;
+    if(SUCCESS != searchExistChannel(VeChn, &pChn))
+    {
+        return ERR_VENC_UNEXIST;
+    }
+    ERRORTYPE ret;
+    COMP_STATETYPE nState;
+    ret = pChn->mEncComp->GetState(pChn->mEncComp, &nState);
+    if(COMP_StateExecuting != nState && COMP_StateIdle != nState)
+    {
+        aloge("wrong state[0x%x], return!", nState);
+        return ERR_VENC_NOT_PERM;
+    }
+    ret = pChn->mEncComp->GetConfig(pChn->mEncComp, COMP_IndexVendorVencFrameSizeHistory, pHistory);
+    return ret;
+}
+
 ERRORTYPE AW_MPI_VENC_RegisterCallback(VENC_CHN VeChn, MPPCallbackInfo *pCallback)
 {
     if(!(VeChn>=0 && VeChn <VENC_MAX_CHN_NUM))
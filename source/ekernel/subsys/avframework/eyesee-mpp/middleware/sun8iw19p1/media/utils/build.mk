@@ -23,7 +23,8 @@ TARGET_SRC := \
             media_common.c \
             mpi_videoformat_conversion.c \
             mm_comm_venc.c \
-            video_buffer_manager.c
+            video_buffer_manager.c \
+            mpp_frametrace.c
 
 TARGET_INC := \
             $(TARGET_TOP)/system/public/include/kernel-headers \
@@ -80,7 +81,8 @@ TARGET_SRC := \
             media_common.c \
             mpi_videoformat_conversion.c \
             mm_comm_venc.c \
-            video_buffer_manager.c
+            video_buffer_manager.c \
+            mpp_frametrace.c
 
 TARGET_INC := \
             $(TARGET_TOP)/system/public/include/kernel-headers \
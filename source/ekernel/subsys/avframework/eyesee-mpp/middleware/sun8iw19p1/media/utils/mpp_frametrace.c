@@ -0,0 +1,368 @@
+/******************************************************************************
+  Copyright (C), 2001-2016, Allwinner Tech. Co., Ltd.
+ ******************************************************************************
+  File Name     : mpp_frametrace.c
+  Version       : Initial Draft
+  Author        : Allwinner PDC-PD5 Team
+  Created       : 2020/11/16
+  Last Modified :
+  Description   : built-in frame latency tracing of the mpp components
+  Function List :
+  History       :
+******************************************************************************/
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mpp_frametrace"
+#include <utils/plat_log.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "plat_type.h"
+#include "plat_errno.h"
+#include "mm_common.h"
+#include "mm_comm_sys.h"
+#include "SystemBase.h"
+#include "mpp_frametrace.h"
+
+#ifdef MPPCFG_FRAMETRACE
+
+#define FRAMETRACE_CAPTURE_NUM  (64)    //captured frames still in the pipeline
+#define FRAMETRACE_PENDING_NUM  (32)    //frames inside one stage at once, all its channels
+
+typedef enum FRAMETRACE_PHASE_E
+{
+    FRAMETRACE_PHASE_CAPTURE = 0,
+    FRAMETRACE_PHASE_ENTER,
+    FRAMETRACE_PHASE_EXIT,
+    FRAMETRACE_PHASE_DROP,
+} FRAMETRACE_PHASE_E;
+
+typedef struct FrameTraceEvent
+{
+    int64_t mTimeUs;
+    int64_t mPts;
+    short   mStage;     //MPP_FRAMETRACE_STAGE_E
+    short   mPhase;     //FRAMETRACE_PHASE_E
+    short   mChn;
+    short   mDepth;
+} FrameTraceEvent;
+
+typedef struct FrameTraceMark
+{
+    int64_t mPts;
+    int64_t mTimeUs;    //0: free
+    int     mChn;
+} FrameTraceMark;
+
+typedef struct FrameTraceManager
+{
+    pthread_mutex_t mLock;
+    FrameTraceEvent *mpEvents;  //MPP_FRAMETRACE_EVENT_NUM, kept until the next enable
+    unsigned int mEventCnt;     //events recorded since enable, the latest ones are in mpEvents
+    FrameTraceMark mCapture[FRAMETRACE_CAPTURE_NUM];
+    unsigned int mCaptureIdx;   //next one to overwrite
+    FrameTraceMark mPending[MPP_FRAMETRACE_STAGE_MAX][FRAMETRACE_PENDING_NUM];
+    MPP_FRAMETRACE_STAT_S mStat[MPP_FRAMETRACE_STAGE_MAX];
+} FrameTraceManager;
+
+static const char *gFrameTraceStageName[MPP_FRAMETRACE_STAGE_MAX] =
+{
+    "VI", "ISE", "EIS", "VENC", "RecRender", "Muxer", "RTSP",
+};
+
+volatile int gMppFrameTraceEnable = 0;
+
+static FrameTraceManager gFrameTrace =
+{
+    .mLock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static int FrameTraceHistBin(int64_t nUs)
+{
+    int64_t nLimit = MPP_FRAMETRACE_HIST_UNIT_US;
+    int i;
+
+    for(i = 0; i < MPP_FRAMETRACE_HIST_BINS-1 && nUs >= nLimit; i++)
+    {
+        nLimit <<= 1;
+    }
+    return i;
+}
+
+static void FrameTraceAddLatency(unsigned int *pHist, uint64_t *pTotal, unsigned int *pMax, int64_t nUs)
+{
+    if(nUs < 0)
+    {
+        nUs = 0;
+    }
+    pHist[FrameTraceHistBin(nUs)]++;
+    *pTotal += nUs;
+    if(nUs > *pMax)
+    {
+        *pMax = (unsigned int)nUs;
+    }
+}
+
+static void FrameTraceLog_l(MPP_FRAMETRACE_STAGE_E eStage, FRAMETRACE_PHASE_E ePhase, int nChn, int64_t nPts, int nDepth, int64_t nTimeUs)
+{
+    FrameTraceEvent *pEvent;
+
+    if(NULL == gFrameTrace.mpEvents)
+    {
+        return;
+    }
+    pEvent = &gFrameTrace.mpEvents[gFrameTrace.mEventCnt++ & (MPP_FRAMETRACE_EVENT_NUM-1)];
+    pEvent->mTimeUs = nTimeUs;
+    pEvent->mPts = nPts;
+    pEvent->mStage = (short)eStage;
+    pEvent->mPhase = (short)ePhase;
+    pEvent->mChn = (short)nChn;
+    pEvent->mDepth = (short)nDepth;
+}
+
+void MppFrameTraceCapture(int nChn, int64_t nPts)
+{
+    MPP_FRAMETRACE_STAT_S *pStat = &gFrameTrace.mStat[MPP_FRAMETRACE_STAGE_VI];
+    FrameTraceMark *pMark;
+    int64_t nTimeUs = CDX_GetSysTimeUsMonotonic();
+    int i;
+
+    pthread_mutex_lock(&gFrameTrace.mLock);
+    for(i = 0; i < FRAMETRACE_CAPTURE_NUM; i++)
+    {
+        //another vipp of the same sensor: keep the first capture
+        if(gFrameTrace.mCapture[i].mTimeUs != 0 && gFrameTrace.mCapture[i].mPts == nPts)
+        {
+            break;
+        }
+    }
+    if(i == FRAMETRACE_CAPTURE_NUM)
+    {
+        pMark = &gFrameTrace.mCapture[gFrameTrace.mCaptureIdx++ % FRAMETRACE_CAPTURE_NUM];
+        pMark->mPts = nPts;
+        pMark->mTimeUs = nTimeUs;
+        pMark->mChn = nChn;
+    }
+    pStat->mFrameCnt++;
+    pStat->mLatencyHist[0]++;
+    pStat->mCaptureLatencyHist[0]++;
+    FrameTraceLog_l(MPP_FRAMETRACE_STAGE_VI, FRAMETRACE_PHASE_CAPTURE, nChn, nPts, -1, nTimeUs);
+    pthread_mutex_unlock(&gFrameTrace.mLock);
+}
+
+void MppFrameTraceEnter(MPP_FRAMETRACE_STAGE_E eStage, int nChn, int64_t nPts, int nDepth)
+{
+    MPP_FRAMETRACE_STAT_S *pStat = &gFrameTrace.mStat[eStage];
+    FrameTraceMark *pPending = gFrameTrace.mPending[eStage];
+    FrameTraceMark *pMark = NULL;
+    int64_t nTimeUs = CDX_GetSysTimeUsMonotonic();
+    int i;
+
+    pthread_mutex_lock(&gFrameTrace.mLock);
+    for(i = 0; i < FRAMETRACE_PENDING_NUM; i++)
+    {
+        if(0 == pPending[i].mTimeUs || (pPending[i].mPts == nPts && pPending[i].mChn == nChn))
+        {
+            pMark = &pPending[i];
+            break;
+        }
+        if(NULL == pMark || pPending[i].mTimeUs < pMark->mTimeUs)
+        {
+            pMark = &pPending[i];
+        }
+    }
+    if(i == FRAMETRACE_PENDING_NUM)
+    {
+        //the oldest one never left
+        pStat->mLostCnt++;
+    }
+    pMark->mPts = nPts;
+    pMark->mTimeUs = nTimeUs;
+    pMark->mChn = nChn;
+    if(nDepth >= 0)
+    {
+        pStat->mQueueDepthHist[nDepth < MPP_FRAMETRACE_HIST_BINS ? nDepth : MPP_FRAMETRACE_HIST_BINS-1]++;
+    }
+    FrameTraceLog_l(eStage, FRAMETRACE_PHASE_ENTER, nChn, nPts, nDepth, nTimeUs);
+    pthread_mutex_unlock(&gFrameTrace.mLock);
+}
+
+void MppFrameTraceExit(MPP_FRAMETRACE_STAGE_E eStage, int nChn, int64_t nPts)
+{
+    MPP_FRAMETRACE_STAT_S *pStat = &gFrameTrace.mStat[eStage];
+    FrameTraceMark *pPending = gFrameTrace.mPending[eStage];
+    int64_t nTimeUs = CDX_GetSysTimeUsMonotonic();
+    int i;
+
+    pthread_mutex_lock(&gFrameTrace.mLock);
+    for(i = 0; i < FRAMETRACE_PENDING_NUM; i++)
+    {
+        if(pPending[i].mTimeUs != 0 && pPending[i].mPts == nPts && pPending[i].mChn == nChn)
+        {
+            break;
+        }
+    }
+    if(i == FRAMETRACE_PENDING_NUM)
+    {
+        //entered before the trace was enabled, or left already
+        pthread_mutex_unlock(&gFrameTrace.mLock);
+        return;
+    }
+    pStat->mFrameCnt++;
+    FrameTraceAddLatency(pStat->mLatencyHist, &pStat->mTotalLatencyUs, &pStat->mMaxLatencyUs, nTimeUs - pPending[i].mTimeUs);
+    pPending[i].mTimeUs = 0;
+    for(i = 0; i < FRAMETRACE_CAPTURE_NUM; i++)
+    {
+        if(gFrameTrace.mCapture[i].mTimeUs != 0 && gFrameTrace.mCapture[i].mPts == nPts)
+        {
+            FrameTraceAddLatency(pStat->mCaptureLatencyHist, &pStat->mTotalCaptureLatencyUs,
+                &pStat->mMaxCaptureLatencyUs, nTimeUs - gFrameTrace.mCapture[i].mTimeUs);
+            break;
+        }
+    }
+    FrameTraceLog_l(eStage, FRAMETRACE_PHASE_EXIT, nChn, nPts, -1, nTimeUs);
+    pthread_mutex_unlock(&gFrameTrace.mLock);
+}
+
+/* the frame left the stage without a result: no latency, and no exit for the next stage to follow */
+void MppFrameTraceDrop(MPP_FRAMETRACE_STAGE_E eStage, int nChn, int64_t nPts)
+{
+    MPP_FRAMETRACE_STAT_S *pStat = &gFrameTrace.mStat[eStage];
+    FrameTraceMark *pPending = gFrameTrace.mPending[eStage];
+    int64_t nTimeUs = CDX_GetSysTimeUsMonotonic();
+    int i;
+
+    pthread_mutex_lock(&gFrameTrace.mLock);
+    for(i = 0; i < FRAMETRACE_PENDING_NUM; i++)
+    {
+        if(pPending[i].mTimeUs != 0 && pPending[i].mPts == nPts && pPending[i].mChn == nChn)
+        {
+            break;
+        }
+    }
+    if(i == FRAMETRACE_PENDING_NUM)
+    {
+        pthread_mutex_unlock(&gFrameTrace.mLock);
+        return;
+    }
+    pStat->mDropCnt++;
+    pPending[i].mTimeUs = 0;
+    FrameTraceLog_l(eStage, FRAMETRACE_PHASE_DROP, nChn, nPts, -1, nTimeUs);
+    pthread_mutex_unlock(&gFrameTrace.mLock);
+}
+
+ERRORTYPE MppFrameTraceSetEnable(BOOL bEnable)
+{
+    pthread_mutex_lock(&gFrameTrace.mLock);
+    if(bEnable)
+    {
+        if(NULL == gFrameTrace.mpEvents)
+        {
+            gFrameTrace.mpEvents = (FrameTraceEvent*)malloc(MPP_FRAMETRACE_EVENT_NUM*sizeof(FrameTraceEvent));
+            if(NULL == gFrameTrace.mpEvents)
+            {
+                aloge("fatal error! malloc fail!");
+                pthread_mutex_unlock(&gFrameTrace.mLock);
+                return ERR_SYS_NOMEM;
+            }
+        }
+        gFrameTrace.mEventCnt = 0;
+        gFrameTrace.mCaptureIdx = 0;
+        memset(gFrameTrace.mCapture, 0, sizeof(gFrameTrace.mCapture));
+        memset(gFrameTrace.mPending, 0, sizeof(gFrameTrace.mPending));
+        memset(gFrameTrace.mStat, 0, sizeof(gFrameTrace.mStat));
+    }
+    gMppFrameTraceEnable = bEnable ? 1 : 0;
+    pthread_mutex_unlock(&gFrameTrace.mLock);
+    return SUCCESS;
+}
+
+ERRORTYPE MppFrameTraceGetStat(MPP_FRAMETRACE_STAGE_E eStage, MPP_FRAMETRACE_STAT_S *pStat)
+{
+    if((int)eStage < 0 || eStage >= MPP_FRAMETRACE_STAGE_MAX || NULL == pStat)
+    {
+        return ERR_SYS_ILLEGAL_PARAM;
+    }
+    pthread_mutex_lock(&gFrameTrace.mLock);
+    *pStat = gFrameTrace.mStat[eStage];
+    pthread_mutex_unlock(&gFrameTrace.mLock);
+    return SUCCESS;
+}
+
+/*
+ * Chrome trace event JSON, which ui.perfetto.dev and chrome://tracing open.
+ * Every stage channel is a track of async slices with the pts as id, so
+ * the frames overlapping in a stage are drawn apart; captures are instants,
+ * a drop ends its slice with a "drop" arg.
+ */
+ERRORTYPE MppFrameTraceDump(const char *pFilePath)
+{
+    FrameTraceEvent *pEvents;
+    FrameTraceEvent *pEvent;
+    unsigned int nFirst, nCnt, i;
+    const char *pPhase;
+    FILE *fp;
+
+    if(NULL == pFilePath)
+    {
+        return ERR_SYS_ILLEGAL_PARAM;
+    }
+    pEvents = (FrameTraceEvent*)malloc(MPP_FRAMETRACE_EVENT_NUM*sizeof(FrameTraceEvent));
+    if(NULL == pEvents)
+    {
+        aloge("fatal error! malloc fail!");
+        return ERR_SYS_NOMEM;
+    }
+    //copy the log, the components must not wait for the file
+    pthread_mutex_lock(&gFrameTrace.mLock);
+    nCnt = gFrameTrace.mEventCnt < MPP_FRAMETRACE_EVENT_NUM ? gFrameTrace.mEventCnt : MPP_FRAMETRACE_EVENT_NUM;
+    nFirst = gFrameTrace.mEventCnt - nCnt;
+    for(i = 0; i < nCnt; i++)
+    {
+        pEvents[i] = gFrameTrace.mpEvents[(nFirst + i) & (MPP_FRAMETRACE_EVENT_NUM-1)];
+    }
+    pthread_mutex_unlock(&gFrameTrace.mLock);
+
+    fp = fopen(pFilePath, "w");
+    if(NULL == fp)
+    {
+        aloge("fatal error! open %s fail!", pFilePath);
+        free(pEvents);
+        return ERR_SYS_NOT_PERM;
+    }
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"mpp\"}}");
+    for(i = 0; i < nCnt; i++)
+    {
+        pEvent = &pEvents[i];
+        if(FRAMETRACE_PHASE_CAPTURE == pEvent->mPhase)
+        {
+            fprintf(fp, ",\n{\"name\":\"capture\",\"cat\":\"VI\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%lld,\"pid\":1,\"tid\":0,"
+                "\"args\":{\"chn\":%d,\"pts\":%lld}}",
+                (long long)pEvent->mTimeUs, pEvent->mChn, (long long)pEvent->mPts);
+            continue;
+        }
+        pPhase = FRAMETRACE_PHASE_ENTER == pEvent->mPhase ? "b" : "e";
+        fprintf(fp, ",\n{\"name\":\"%s %d\",\"cat\":\"%s\",\"ph\":\"%s\",\"id\":%lld,\"ts\":%lld,\"pid\":1,\"tid\":0",
+            gFrameTraceStageName[pEvent->mStage], pEvent->mChn, gFrameTraceStageName[pEvent->mStage], pPhase,
+            (long long)pEvent->mPts, (long long)pEvent->mTimeUs);
+        if(FRAMETRACE_PHASE_ENTER == pEvent->mPhase)
+        {
+            fprintf(fp, ",\"args\":{\"pts\":%lld,\"depth\":%d}", (long long)pEvent->mPts, pEvent->mDepth);
+        }
+        else if(FRAMETRACE_PHASE_DROP == pEvent->mPhase)
+        {
+            fprintf(fp, ",\"args\":{\"drop\":1}");
+        }
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    free(pEvents);
+    alogd("dump %u frame trace events to %s", nCnt, pFilePath);
+    return SUCCESS;
+}
+
+#endif
@@ -23,7 +23,8 @@ SRCCS := \
     media_common.c \
     mpi_videoformat_conversion.c \
     mm_comm_venc.c \
-    video_buffer_manager.c
+    video_buffer_manager.c \
+    mpp_frametrace.c
 
 #include directories
 INCLUDE_DIRS := \
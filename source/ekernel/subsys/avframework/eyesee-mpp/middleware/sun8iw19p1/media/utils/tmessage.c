@@ -30,6 +30,24 @@
 #include "SystemBase.h"
 #include <cdx_list.h>
 
+/*
+ * A message queue is a bounded ring of MESSAGE_RING_DEPTH preallocated slots
+ * (D. Vyukov's bounded queue): a writer takes a position by CAS on mRingTail
+ * and publishes the slot by storing position+1 in its mSeq, the reader takes
+ * it by CAS on mRingHead and frees it by storing position+depth. No lock is
+ * taken while the ring has room.
+ *
+ * A put on a full ring goes to mReadyMessageList under the mutex, and so do
+ * the following puts as long as that list is not empty, so the messages of
+ * one thread keep their order: the ring always holds the older ones and
+ * get_message() empties it first.
+ *
+ * The reader sleeps on mCondMessageQueueChanged only when nothing can be
+ * read. It counts itself in mWaitMessageFlag before looking at the ring, a
+ * writer publishes its slot before looking at mWaitMessageFlag, both with
+ * sequentially consistent accesses, so one of them sees the other; the
+ * writer then takes the mutex to signal, like writing an eventfd.
+ */
 static int TMessageDeepCopyMessage(message_t *pDesMsg, message_t *pSrcMsg)
 {
     pDesMsg->command = pSrcMsg->command;
@@ -83,10 +101,169 @@ static int TMessageIncreaseIdleMessageList(message_queue_t* pThiz)
     return ret;
 }
 
+static int TMessageRingPut(message_queue_t* pThiz, message_t *pMsg)
+{
+    message_slot_t *pSlot;
+    unsigned int nPos = pThiz->mRingTail;
+    int nDiff;
+
+    while(1)
+    {
+        pSlot = &pThiz->mpRing[nPos & (MESSAGE_RING_DEPTH-1)];
+        nDiff = (int)(__atomic_load_n(&pSlot->mSeq, __ATOMIC_ACQUIRE) - nPos);
+        if(0 == nDiff)
+        {
+            if(__atomic_compare_exchange_n(&pThiz->mRingTail, &nPos, nPos+1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if(nDiff < 0)
+        {
+            return -1;  //full
+        }
+        nPos = pThiz->mRingTail;
+    }
+    pSlot->command = pMsg->command;
+    pSlot->para0 = pMsg->para0;
+    pSlot->para1 = pMsg->para1;
+    pSlot->mpData = pMsg->mpData;
+    pSlot->mDataSize = pMsg->mDataSize;
+    __atomic_store_n(&pSlot->mSeq, nPos + 1, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+static int TMessageRingGet(message_queue_t* pThiz, message_t *pMsg)
+{
+    message_slot_t *pSlot;
+    unsigned int nPos = pThiz->mRingHead;
+    int nDiff;
+
+    while(1)
+    {
+        pSlot = &pThiz->mpRing[nPos & (MESSAGE_RING_DEPTH-1)];
+        nDiff = (int)(__atomic_load_n(&pSlot->mSeq, __ATOMIC_ACQUIRE) - (nPos+1));
+        if(0 == nDiff)
+        {
+            if(__atomic_compare_exchange_n(&pThiz->mRingHead, &nPos, nPos+1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if(nDiff < 0)
+        {
+            return -1;  //empty
+        }
+        nPos = pThiz->mRingHead;
+    }
+    pMsg->command = pSlot->command;
+    pMsg->para0 = pSlot->para0;
+    pMsg->para1 = pSlot->para1;
+    pMsg->mpData = pSlot->mpData;
+    pMsg->mDataSize = pSlot->mDataSize;
+    __atomic_store_n(&pSlot->mSeq, nPos + MESSAGE_RING_DEPTH, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int TMessagePut(message_queue_t* msg_queue, message_t *pMsg)
+{
+    message_t   *pMessageEntry;
+
+    if(0 == msg_queue->mSpillCount && 0 == TMessageRingPut(msg_queue, pMsg))
+    {
+        alogv(" new msg command[%d], para[%d][%d] pData[%p]size[%d]",
+            pMsg->command, pMsg->para0, pMsg->para1, pMsg->mpData, pMsg->mDataSize);
+        if(__atomic_load_n(&msg_queue->mWaitMessageFlag, __ATOMIC_SEQ_CST))
+        {
+            pthread_mutex_lock(&msg_queue->mutex);
+            pthread_cond_signal(&msg_queue->mCondMessageQueueChanged);
+            pthread_mutex_unlock(&msg_queue->mutex);
+        }
+        return 0;
+    }
+
+    pthread_mutex_lock(&msg_queue->mutex);
+    if(0 == msg_queue->mSpillCount && 0 == TMessageRingPut(msg_queue, pMsg))
+    {
+        goto _done;
+    }
+    if(list_empty(&msg_queue->mIdleMessageList))
+    {
+        alogw(" message ring is full, malloc more!");
+        //dumpCallStack("TMsg");
+        if(0!=TMessageIncreaseIdleMessageList(msg_queue) && list_empty(&msg_queue->mIdleMessageList))
+        {
+            pthread_mutex_unlock(&msg_queue->mutex);
+            return -1;
+        }
+    }
+    pMessageEntry = list_first_entry(&msg_queue->mIdleMessageList, message_t, mList);
+    TMessageSetMessage(pMessageEntry, pMsg);
+    list_move_tail(&pMessageEntry->mList, &msg_queue->mReadyMessageList);
+    msg_queue->mSpillCount++;
+
+_done:
+    alogv(" new msg command[%d], para[%d][%d] pData[%p]size[%d]",
+        pMsg->command, pMsg->para0, pMsg->para1, pMsg->mpData, pMsg->mDataSize);
+    if(msg_queue->mWaitMessageFlag)
+    {
+        pthread_cond_signal(&msg_queue->mCondMessageQueueChanged);
+    }
+    pthread_mutex_unlock(&msg_queue->mutex);
+    return 0;
+}
+
+/*
+ * Whether TMessageGet() finds a message: the oldest ring slot is written, or
+ * the ring is empty and the list is not. A slot taken but not written yet
+ * holds the queue back until its writer is done.
+ */
+static int TMessageReadable(message_queue_t* msg_queue)
+{
+    unsigned int nPos = msg_queue->mRingHead;
+
+    if(__atomic_load_n(&msg_queue->mpRing[nPos & (MESSAGE_RING_DEPTH-1)].mSeq, __ATOMIC_SEQ_CST) == nPos+1)
+    {
+        return 1;
+    }
+    return msg_queue->mSpillCount > 0 && nPos == msg_queue->mRingTail;
+}
+
+static int TMessageGet(message_queue_t* msg_queue, message_t *pMsg)
+{
+    message_t   *pMessageEntry;
+    int ret = -1;
+
+    if(0 == TMessageRingGet(msg_queue, pMsg))
+    {
+        return 0;
+    }
+    if(0 == msg_queue->mSpillCount)
+    {
+        return -1;
+    }
+    pthread_mutex_lock(&msg_queue->mutex);
+    if(0 == TMessageRingGet(msg_queue, pMsg))
+    {
+        ret = 0;
+    }
+    else if(!list_empty(&msg_queue->mReadyMessageList) && msg_queue->mRingHead == msg_queue->mRingTail)
+    {
+        pMessageEntry = list_first_entry(&msg_queue->mReadyMessageList, message_t, mList);
+        TMessageSetMessage(pMsg, pMessageEntry);
+        list_move_tail(&pMessageEntry->mList, &msg_queue->mIdleMessageList);
+        msg_queue->mSpillCount--;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&msg_queue->mutex);
+    return ret;
+}
+
 int message_create(message_queue_t* msg_queue)
 {
 	//int 		i;
     int         ret;
+    unsigned int i;
   
 	alogv("msg create\n");
     
@@ -110,11 +287,19 @@ int message_create(message_queue_t* msg_queue)
     //INIT_LIST_HEAD(&msg_queue->mMessageBufList);
     INIT_LIST_HEAD(&msg_queue->mIdleMessageList);
     INIT_LIST_HEAD(&msg_queue->mReadyMessageList);
-    if(0!=TMessageIncreaseIdleMessageList(msg_queue))
+    msg_queue->mpRing = (message_slot_t*)malloc(MESSAGE_RING_DEPTH*sizeof(message_slot_t));
+    if(NULL == msg_queue->mpRing)
     {
+        aloge(" fatal error! malloc fail");
         goto _err1;
     }
-	msg_queue->message_count = 0;
+    for(i=0;i<MESSAGE_RING_DEPTH;i++)
+    {
+        msg_queue->mpRing[i].mSeq = i;
+    }
+    msg_queue->mRingHead = 0;
+    msg_queue->mRingTail = 0;
+    msg_queue->mSpillCount = 0;
     
 	return 0;
 _err1:
@@ -127,27 +312,8 @@ _err0:
 
 void message_destroy(message_queue_t* msg_queue)
 {
+    flush_message(msg_queue);
 	pthread_mutex_lock(&msg_queue->mutex);
-    if(!list_empty(&msg_queue->mReadyMessageList))
-    {
-        message_t *pEntry, *pTmp;
-        list_for_each_entry_safe(pEntry, pTmp, &msg_queue->mReadyMessageList, mList)
-        {
-            alogd(" msg destroy: cmd[%x]mpData[%p]size[%d]", pEntry->command, pEntry->mpData, pEntry->mDataSize);
-            if(pEntry->mpData)
-            {
-                free(pEntry->mpData);
-                pEntry->mpData = NULL;
-            }
-            pEntry->mDataSize = 0;
-            list_move_tail(&pEntry->mList, &msg_queue->mIdleMessageList);
-            msg_queue->message_count--;
-        }
-    }
-    if(msg_queue->message_count != 0)
-    {
-        aloge(" fatal error! msg count[%d]!=0", msg_queue->message_count);
-    }
     int cnt = 0;
     if(!list_empty(&msg_queue->mIdleMessageList))
     {
@@ -161,6 +327,8 @@ void message_destroy(message_queue_t* msg_queue)
     }
     INIT_LIST_HEAD(&msg_queue->mIdleMessageList);
     INIT_LIST_HEAD(&msg_queue->mReadyMessageList);
+    free(msg_queue->mpRing);
+    msg_queue->mpRing = NULL;
 	pthread_mutex_unlock(&msg_queue->mutex);
     pthread_cond_destroy(&msg_queue->mCondMessageQueueChanged);
 	pthread_mutex_destroy(&msg_queue->mutex);
@@ -169,28 +337,21 @@ void message_destroy(message_queue_t* msg_queue)
 
 void flush_message(message_queue_t* msg_queue)
 {
-	pthread_mutex_lock(&msg_queue->mutex);
-    if(!list_empty(&msg_queue->mReadyMessageList))
+    message_t   message;
+
+    while(0 == TMessageGet(msg_queue, &message))
     {
-        message_t   *pEntry, *pTmp;
-        list_for_each_entry_safe(pEntry, pTmp, &msg_queue->mReadyMessageList, mList)
+        alogd(" msg destroy: cmd[%x]mpData[%p]size[%d]", message.command, message.mpData, message.mDataSize);
+        if(message.mpData)
         {
-            alogd(" msg destroy: cmd[%x]mpData[%p]size[%d]", pEntry->command, pEntry->mpData, pEntry->mDataSize);
-            if(pEntry->mpData)
-            {
-                free(pEntry->mpData);
-                pEntry->mpData = NULL;
-            }
-            pEntry->mDataSize = 0;
-            list_move_tail(&pEntry->mList, &msg_queue->mIdleMessageList);
-            msg_queue->message_count--;
+            free(message.mpData);
+            message.mpData = NULL;
         }
     }
-    if(msg_queue->message_count != 0)
+    if(get_message_count(msg_queue) != 0)
     {
-        aloge(" fatal error! msg count[%d]!=0", msg_queue->message_count);
+        aloge(" fatal error! msg count[%d]!=0", get_message_count(msg_queue));
     }
-	pthread_mutex_unlock(&msg_queue->mutex);
 }
 
 /*******************************************************************************
@@ -212,88 +373,83 @@ int put_message(message_queue_t* msg_queue, message_t *msg_in)
     message.para1 = msg_in->para1;
     message.mpData = NULL;
     message.mDataSize = 0;
-    return putMessageWithData(msg_queue, &message);
+    return TMessagePut(msg_queue, &message);
 }
 
 int get_message(message_queue_t* msg_queue, message_t *msg_out)
 {
-	pthread_mutex_lock(&msg_queue->mutex);
+    message_t message;
 
-    if(list_empty(&msg_queue->mReadyMessageList))
+    if(0 != TMessageGet(msg_queue, &message))
     {
-        pthread_mutex_unlock(&msg_queue->mutex);
         return -1;
     }
-    message_t   *pMessageEntry = list_first_entry(&msg_queue->mReadyMessageList, message_t, mList);
-    TMessageSetMessage(msg_out, pMessageEntry);
-    list_move_tail(&pMessageEntry->mList, &msg_queue->mIdleMessageList);
-    msg_queue->message_count--;
-
-    pthread_mutex_unlock(&msg_queue->mutex);
+    TMessageSetMessage(msg_out, &message);
 	return 0;
 }
 
+/*******************************************************************************
+Function name: putMessageWithData
+Description: 
+    mpData is copied to a new buffer, which the receiver must free.
+*******************************************************************************/
 int putMessageWithData(message_queue_t* msg_queue, message_t *msg_in)
 {
-    int ret = 0;
-	pthread_mutex_lock(&msg_queue->mutex);
-    if(list_empty(&msg_queue->mIdleMessageList))
-    {
-        alogw(" idleMessageList are all used, malloc more!");
-        //dumpCallStack("TMsg");
-        if(0!=TMessageIncreaseIdleMessageList(msg_queue))
-        {
-            pthread_mutex_unlock(&msg_queue->mutex);
-            return -1;
-        }
-    }
-    message_t   *pMessageEntry = list_first_entry(&msg_queue->mIdleMessageList, message_t, mList);
-    if(0==TMessageDeepCopyMessage(pMessageEntry, msg_in))
+    message_t message;
+
+    if(0 != TMessageDeepCopyMessage(&message, msg_in))
     {
-        list_move_tail(&pMessageEntry->mList, &msg_queue->mReadyMessageList);
-        msg_queue->message_count++;
-        alogv(" new msg command[%d], para[%d][%d] pData[%p]size[%d]", 
-            pMessageEntry->command, pMessageEntry->para0, pMessageEntry->para1, pMessageEntry->mpData, pMessageEntry->mDataSize);
-        if(msg_queue->mWaitMessageFlag)
-        {
-            pthread_cond_signal(&msg_queue->mCondMessageQueueChanged);
-        }
+        return -1;
     }
-    else
+    if(0 != TMessagePut(msg_queue, &message))
     {
-        ret = -1;
+        free(message.mpData);
+        return -1;
     }
-    pthread_mutex_unlock(&msg_queue->mutex);
-	return ret;
+	return 0;
 }
 
-int get_message_count(message_queue_t* msg_queue)
+/*******************************************************************************
+Function name: putMessageWithDataRef
+Description: 
+    mpData is passed as it is, not copied: the receiver gets the caller's
+    buffer and owns it from then on. For large payloads, or ones already
+    allocated for the message. On failure the caller still owns it.
+*******************************************************************************/
+int putMessageWithDataRef(message_queue_t* msg_queue, message_t *msg_in)
 {
-	int message_count;
+    message_t message;
 
-	pthread_mutex_lock(&msg_queue->mutex);
-	message_count = msg_queue->message_count;
-	pthread_mutex_unlock(&msg_queue->mutex);
+    TMessageSetMessage(&message, msg_in);
+    return TMessagePut(msg_queue, &message);
+}
 
-	return message_count;
+int get_message_count(message_queue_t* msg_queue)
+{
+    unsigned int nHead = msg_queue->mRingHead;
+	int message_count = (int)(msg_queue->mRingTail - nHead) + msg_queue->mSpillCount;
+
+	return message_count > 0 ? message_count : 0;
 }
 
 int TMessage_WaitQueueNotEmpty(message_queue_t* msg_queue, unsigned int timeout)
 {
-    int message_count;
-
+    if(TMessageReadable(msg_queue))
+    {
+        return get_message_count(msg_queue);
+    }
     pthread_mutex_lock(&msg_queue->mutex);
-    msg_queue->mWaitMessageFlag = 1;
+    __atomic_add_fetch(&msg_queue->mWaitMessageFlag, 1, __ATOMIC_SEQ_CST);
     if(timeout <= 0)
     {
-        while(list_empty(&msg_queue->mReadyMessageList))
+        while(!TMessageReadable(msg_queue))
         {
             pthread_cond_wait(&msg_queue->mCondMessageQueueChanged, &msg_queue->mutex);
         }
     }
     else
     {
-        if(list_empty(&msg_queue->mReadyMessageList))
+        if(!TMessageReadable(msg_queue))
         {
             int ret = pthread_cond_wait_timeout(&msg_queue->mCondMessageQueueChanged, &msg_queue->mutex, timeout);
             if(ETIMEDOUT == ret)
@@ -309,10 +465,8 @@ int TMessage_WaitQueueNotEmpty(message_queue_t* msg_queue, unsigned int timeout)
             }
         }
     }
-    msg_queue->mWaitMessageFlag = 0;
-    message_count = msg_queue->message_count;
+    msg_queue->mWaitMessageFlag--;
     pthread_mutex_unlock(&msg_queue->mutex);
 
-    return message_count;
+    return TMessageReadable(msg_queue) ? get_message_count(msg_queue) : 0;
 }
-
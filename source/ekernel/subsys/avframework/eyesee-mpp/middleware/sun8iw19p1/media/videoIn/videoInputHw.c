@@ -43,6 +43,7 @@
 
 #include <cdx_list.h>
 #include <ConfigOption.h>
+#include <mpp_frametrace.h>
 
 // viChnManager *gpViChnManager = NULL;
 //viChnManager *gpVippManager[VI_VIPP_NUM_MAX] = {NULL}; // { NULL, NULL, NULL, NULL };
@@ -3984,6 +3985,7 @@ static ERRORTYPE videoInputHw_GetData(int *pvipp_id, VIDEO_FRAME_INFO_S *pstFram
     pstFrameInfo->VFrame.mField = vfmt.format.field;
     pstFrameInfo->VFrame.mPixelFormat = map_V4L2_PIX_FMT_to_PIXEL_FORMAT_E(vfmt.format.pixelformat);// V4L2_PIX_FMT_SBGGR12;
     pstFrameInfo->VFrame.mpts = (int64_t)buffer.timestamp.tv_sec*1000*1000 + buffer.timestamp.tv_usec;
+    MPP_FrameTraceCapture(ViCh, pstFrameInfo->VFrame.mpts);
     pstFrameInfo->VFrame.mFramecnt = buffer.frame_cnt;
     pstFrameInfo->VFrame.mExposureTime = buffer.exp_time / 1000;
     pstFrameInfo->mId = buffer.index;
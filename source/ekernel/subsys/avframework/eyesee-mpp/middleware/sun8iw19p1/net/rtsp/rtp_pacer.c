@@ -0,0 +1,73 @@
+/******************************************************************************
+  Copyright (C), 2001-2016, Allwinner Tech. Co., Ltd.
+ ******************************************************************************
+  File Name     : rtp_pacer.c
+  Version       : Initial Draft
+  Author        : Allwinner PDC-PD5 Team
+  Created       : 2020/12/07
+  Last Modified :
+  Description   : token bucket spreading the rtp packets of big frames
+  Function List :
+  History       :
+******************************************************************************/
+#include <string.h>
+
+#include "rtp_pacer.h"
+
+#define TOKENS_OF_BYTES(n)  ((int64_t)(n) * 8 * 1000000)
+
+void RtpPacerInit(RTP_PACER_S *pPacer, int nBitRate, int nBurstBytes)
+{
+    memset(pPacer, 0, sizeof(*pPacer));
+    pPacer->mBitRate = nBitRate > 0 ? nBitRate : 0;
+    pPacer->mBurstBytes = nBurstBytes > 0 ? nBurstBytes : 0;
+    pPacer->mTokens = TOKENS_OF_BYTES(pPacer->mBurstBytes);
+    pPacer->mLastUs = -1;
+}
+
+static void RtpPacerRefill(RTP_PACER_S *pPacer, int64_t nNowUs)
+{
+    if(pPacer->mLastUs >= 0 && nNowUs > pPacer->mLastUs)
+    {
+        pPacer->mTokens += (int64_t)pPacer->mBitRate * (nNowUs - pPacer->mLastUs);
+        if(pPacer->mTokens > TOKENS_OF_BYTES(pPacer->mBurstBytes))
+        {
+            pPacer->mTokens = TOKENS_OF_BYTES(pPacer->mBurstBytes);
+        }
+    }
+    if(nNowUs > pPacer->mLastUs)
+    {
+        pPacer->mLastUs = nNowUs;
+    }
+}
+
+int64_t RtpPacerDelayUs(RTP_PACER_S *pPacer, unsigned int nBytes, int64_t nNowUs)
+{
+    int64_t nNeed;
+    if(0 == pPacer->mBitRate)
+    {
+        return 0;
+    }
+    RtpPacerRefill(pPacer, nNowUs);
+    //a packet bigger than the bucket goes when it is full
+    nNeed = TOKENS_OF_BYTES(nBytes);
+    if(nNeed > TOKENS_OF_BYTES(pPacer->mBurstBytes))
+    {
+        nNeed = TOKENS_OF_BYTES(pPacer->mBurstBytes);
+    }
+    if(pPacer->mTokens >= nNeed)
+    {
+        return 0;
+    }
+    return (nNeed - pPacer->mTokens + pPacer->mBitRate - 1) / pPacer->mBitRate;
+}
+
+void RtpPacerConsume(RTP_PACER_S *pPacer, unsigned int nBytes, int64_t nNowUs)
+{
+    if(0 == pPacer->mBitRate)
+    {
+        return;
+    }
+    RtpPacerRefill(pPacer, nNowUs);
+    pPacer->mTokens -= TOKENS_OF_BYTES(nBytes);
+}
@@ -0,0 +1,46 @@
+/******************************************************************************
+  Copyright (C), 2001-2016, Allwinner Tech. Co., Ltd.
+ ******************************************************************************
+  File Name     : rtp_pacer.h
+  Version       : Initial Draft
+  Author        : Allwinner PDC-PD5 Team
+  Created       : 2020/12/07
+  Last Modified :
+  Description   : token bucket spreading the rtp packets of big frames
+  Function List :
+  History       :
+******************************************************************************/
+#ifndef _RTP_PACER_H_
+#define _RTP_PACER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The bucket fills at mBitRate up to mBurstBytes, a packet takes its bytes
+ * from it. The clock is given by the caller so that it can be tested.
+ */
+typedef struct RTP_PACER_S
+{
+    int mBitRate;           //0: no pacing
+    int mBurstBytes;
+    int64_t mTokens;        //bits*1000000, see TOKENS_OF_BYTES, so that a us of bitrate is mBitRate tokens
+    int64_t mLastUs;        //-1 before the first packet
+} RTP_PACER_S;
+
+void RtpPacerInit(RTP_PACER_S *pPacer, int nBitRate, int nBurstBytes);
+
+/* us to wait before nBytes can go at nNowUs, 0 if they can go now */
+int64_t RtpPacerDelayUs(RTP_PACER_S *pPacer, unsigned int nBytes, int64_t nNowUs);
+
+/* nBytes went at nNowUs, after RtpPacerDelayUs() said they could */
+void RtpPacerConsume(RTP_PACER_S *pPacer, unsigned int nBytes, int64_t nNowUs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _RTP_PACER_H_ */
@@ -0,0 +1,274 @@
+/******************************************************************************
+  Copyright (C), 2001-2016, Allwinner Tech. Co., Ltd.
+ ******************************************************************************
+  File Name     : rtp_packetizer.c
+  Version       : Initial Draft
+  Author        : Allwinner PDC-PD5 Team
+  Created       : 2020/12/07
+  Last Modified :
+  Description   : h264/h265 rtp packetization without copying the payload
+  Function List :
+  History       :
+******************************************************************************/
+//#define LOG_NDEBUG 0
+#define LOG_TAG "rtp_packetizer"
+#include <utils/plat_log.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp_packetizer.h"
+
+#define H264_NAL_FU_A       (28)    //rfc6184
+#define H265_NAL_FU         (49)    //rfc7798
+#define FU_START_BIT        (0x80)
+#define FU_END_BIT          (0x40)
+
+/* first "00 00 01" of p[nFrom, nEnd), nEnd if none */
+static unsigned int ScanStartCode(const uint8_t *p, unsigned int nFrom, unsigned int nEnd)
+{
+    unsigned int i = nFrom;
+    while(i + 2 < nEnd)
+    {
+        if(p[i+2] > 1)
+        {
+            //none of i, i+1, i+2 can start one
+            i += 3;
+        }
+        else if(1 == p[i+2] && 0 == p[i+1] && 0 == p[i])
+        {
+            return i;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    return nEnd;
+}
+
+/* first start code of the frame at or after nFrom, nTotal if none */
+static unsigned int FindStartCode(const RTP_FRAME_BUF_S *pFrame, unsigned int nFrom, unsigned int nTotal)
+{
+    unsigned int nLen0 = pFrame->mLen[0];
+    unsigned int i;
+
+    if(nFrom < nLen0)
+    {
+        i = ScanStartCode(pFrame->mpData[0], nFrom, nLen0);
+        if(i < nLen0)
+        {
+            return i;
+        }
+        //the ones across the two parts
+        for(i = nLen0 >= 2 && nLen0 - 2 > nFrom ? nLen0 - 2 : nFrom; i < nLen0 && i + 2 < nTotal; i++)
+        {
+            if(0 == RtpFrameByte(pFrame, i) && 0 == RtpFrameByte(pFrame, i+1) && 1 == RtpFrameByte(pFrame, i+2))
+            {
+                return i;
+            }
+        }
+        nFrom = nLen0;
+    }
+    i = ScanStartCode(pFrame->mpData[1], nFrom - nLen0, nTotal - nLen0);
+    return nLen0 + i;
+}
+
+int RtpFindNalUnits(const RTP_FRAME_BUF_S *pFrame, RTP_NAL_S *pNals, int nMaxNum)
+{
+    unsigned int nTotal = pFrame->mLen[0] + pFrame->mLen[1];
+    unsigned int nStart, nNext;
+    int nNum = 0;
+
+    nStart = FindStartCode(pFrame, 0, nTotal);
+    while(nStart < nTotal)
+    {
+        unsigned int nOffset = nStart + 3;
+        unsigned int nEnd;
+        nNext = FindStartCode(pFrame, nOffset, nTotal);
+        nEnd = nNext;
+        //the zero_byte of a 4 bytes start code and trailing_zero_8bits
+        while(nEnd > nOffset && 0 == RtpFrameByte(pFrame, nEnd - 1))
+        {
+            nEnd--;
+        }
+        if(nEnd > nOffset)
+        {
+            if(nNum >= nMaxNum)
+            {
+                return -1;
+            }
+            pNals[nNum].mOffset = nOffset;
+            pNals[nNum].mLen = nEnd - nOffset;
+            nNum++;
+        }
+        nStart = nNext;
+    }
+    return nNum;
+}
+
+int RtpNalType(RTP_CODEC_E eCodec, const RTP_FRAME_BUF_S *pFrame, unsigned int nOffset)
+{
+    uint8_t nByte = RtpFrameByte(pFrame, nOffset);
+    return RTP_CODEC_H264 == eCodec ? (nByte & 0x1F) : ((nByte >> 1) & 0x3F);
+}
+
+int RtpPacketizerInit(RTP_PACKETIZER_S *pPacketizer, RTP_CODEC_E eCodec, unsigned int nMaxPayload, uint32_t nSsrc, uint16_t nFirstSeq)
+{
+    memset(pPacketizer, 0, sizeof(*pPacketizer));
+    if(nMaxPayload < 16)
+    {
+        aloge("fatal error! max payload[%u] too small", nMaxPayload);
+        return -1;
+    }
+    pPacketizer->meCodec = eCodec;
+    pPacketizer->mMaxPayload = nMaxPayload;
+    pPacketizer->mPayloadType = RTP_DEFAULT_PAYLOAD_TYPE;
+    pPacketizer->mSsrc = nSsrc;
+    pPacketizer->mSeq = nFirstSeq;
+    return 0;
+}
+
+void RtpPacketizerDeinit(RTP_PACKETIZER_S *pPacketizer)
+{
+    free(pPacketizer->mpPackets);
+    pPacketizer->mpPackets = NULL;
+    pPacketizer->mPacketNum = 0;
+    pPacketizer->mPacketCap = 0;
+}
+
+/* payload iovs of [nOffset, nOffset+nLen) of the frame */
+static void AddPayload(RTP_PACKET_S *pPacket, const RTP_FRAME_BUF_S *pFrame, unsigned int nOffset, unsigned int nLen)
+{
+    unsigned int nLen0 = pFrame->mLen[0];
+    if(nOffset < nLen0)
+    {
+        unsigned int nPart = nOffset + nLen > nLen0 ? nLen0 - nOffset : nLen;
+        pPacket->mIov[pPacket->mIovNum].iov_base = (void*)(pFrame->mpData[0] + nOffset);
+        pPacket->mIov[pPacket->mIovNum].iov_len = nPart;
+        pPacket->mIovNum++;
+        nOffset += nPart;
+        nLen -= nPart;
+    }
+    if(nLen > 0)
+    {
+        pPacket->mIov[pPacket->mIovNum].iov_base = (void*)(pFrame->mpData[1] + (nOffset - nLen0));
+        pPacket->mIov[pPacket->mIovNum].iov_len = nLen;
+        pPacket->mIovNum++;
+    }
+}
+
+static RTP_PACKET_S *NewPacket(RTP_PACKETIZER_S *pPacketizer, uint32_t nRtpTime, int nExtraHeader)
+{
+    RTP_PACKET_S *pPacket = &pPacketizer->mpPackets[pPacketizer->mPacketNum++];
+    uint8_t *h = pPacket->mHeader;
+    uint16_t nSeq = pPacketizer->mSeq++;
+
+    h[0] = 0x80;    //version 2
+    h[1] = pPacketizer->mPayloadType;
+    h[2] = nSeq >> 8;
+    h[3] = nSeq & 0xFF;
+    h[4] = nRtpTime >> 24;
+    h[5] = (nRtpTime >> 16) & 0xFF;
+    h[6] = (nRtpTime >> 8) & 0xFF;
+    h[7] = nRtpTime & 0xFF;
+    h[8] = pPacketizer->mSsrc >> 24;
+    h[9] = (pPacketizer->mSsrc >> 16) & 0xFF;
+    h[10] = (pPacketizer->mSsrc >> 8) & 0xFF;
+    h[11] = pPacketizer->mSsrc & 0xFF;
+    pPacket->mIov[0].iov_base = h;
+    pPacket->mIov[0].iov_len = RTP_HEADER_SIZE + nExtraHeader;
+    pPacket->mIovNum = 1;
+    return pPacket;
+}
+
+int RtpPacketizeNals(RTP_PACKETIZER_S *pPacketizer, const RTP_FRAME_BUF_S *pFrame, const RTP_NAL_S *pNals, int nNalNum, uint32_t nRtpTime, int bEndOfFrame)
+{
+    int nNalHeader = RTP_CODEC_H264 == pPacketizer->meCodec ? 1 : 2;
+    unsigned int nFuPayload = pPacketizer->mMaxPayload - (nNalHeader + 1);
+    int nNum = 0;
+    int i, j;
+
+    for(i = 0; i < nNalNum; i++)
+    {
+        if(pNals[i].mLen <= pPacketizer->mMaxPayload)
+        {
+            nNum++;
+        }
+        else
+        {
+            nNum += (pNals[i].mLen - nNalHeader + nFuPayload - 1) / nFuPayload;
+        }
+    }
+    if(nNum > pPacketizer->mPacketCap)
+    {
+        RTP_PACKET_S *pPackets = (RTP_PACKET_S*)realloc(pPacketizer->mpPackets, nNum * sizeof(RTP_PACKET_S));
+        if(NULL == pPackets)
+        {
+            aloge("fatal error! malloc %d packets fail", nNum);
+            pPacketizer->mPacketNum = 0;
+            return -1;
+        }
+        pPacketizer->mpPackets = pPackets;
+        pPacketizer->mPacketCap = nNum;
+    }
+
+    pPacketizer->mPacketNum = 0;
+    for(i = 0; i < nNalNum; i++)
+    {
+        unsigned int nOffset = pNals[i].mOffset;
+        unsigned int nLen = pNals[i].mLen;
+        RTP_PACKET_S *pPacket;
+
+        if(nLen <= pPacketizer->mMaxPayload)
+        {
+            //single nal unit packet
+            pPacket = NewPacket(pPacketizer, nRtpTime, 0);
+            AddPayload(pPacket, pFrame, nOffset, nLen);
+            continue;
+        }
+
+        //fragmentation units, the nal header goes into the fu headers
+        uint8_t nByte0 = RtpFrameByte(pFrame, nOffset);
+        uint8_t nByte1 = nNalHeader > 1 ? RtpFrameByte(pFrame, nOffset + 1) : 0;
+        nOffset += nNalHeader;
+        nLen -= nNalHeader;
+        for(j = 0; nLen > 0; j++)
+        {
+            unsigned int nPart = nLen > nFuPayload ? nFuPayload : nLen;
+            uint8_t *h;
+            pPacket = NewPacket(pPacketizer, nRtpTime, nNalHeader + 1);
+            h = pPacket->mHeader + RTP_HEADER_SIZE;
+            if(RTP_CODEC_H264 == pPacketizer->meCodec)
+            {
+                h[0] = (nByte0 & 0xE0) | H264_NAL_FU_A;
+                h[1] = nByte0 & 0x1F;
+            }
+            else
+            {
+                h[0] = (nByte0 & 0x81) | (H265_NAL_FU << 1);
+                h[1] = nByte1;
+                h[2] = (nByte0 >> 1) & 0x3F;
+            }
+            h[nNalHeader] |= (0 == j ? FU_START_BIT : 0) | (nPart == nLen ? FU_END_BIT : 0);
+            AddPayload(pPacket, pFrame, nOffset, nPart);
+            nOffset += nPart;
+            nLen -= nPart;
+        }
+    }
+
+    for(i = 0; i < pPacketizer->mPacketNum; i++)
+    {
+        RTP_PACKET_S *pPacket = &pPacketizer->mpPackets[i];
+        pPacket->mLen = 0;
+        for(j = 0; j < pPacket->mIovNum; j++)
+        {
+            pPacket->mLen += pPacket->mIov[j].iov_len;
+        }
+    }
+    if(bEndOfFrame && pPacketizer->mPacketNum > 0)
+    {
+        pPacketizer->mpPackets[pPacketizer->mPacketNum - 1].mHeader[1] |= 0x80;
+    }
+    return pPacketizer->mPacketNum;
+}
@@ -0,0 +1,109 @@
+/******************************************************************************
+  Copyright (C), 2001-2016, Allwinner Tech. Co., Ltd.
+ ******************************************************************************
+  File Name     : rtp_packetizer.h
+  Version       : Initial Draft
+  Author        : Allwinner PDC-PD5 Team
+  Created       : 2020/12/07
+  Last Modified :
+  Description   : h264/h265 rtp packetization without copying the payload
+  Function List :
+  History       :
+******************************************************************************/
+#ifndef _RTP_PACKETIZER_H_
+#define _RTP_PACKETIZER_H_
+
+#include <stdint.h>
+#include <sys/socket.h>  //struct iovec, lwip has no sys/uio.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RTP_HEADER_SIZE         (12)
+#define RTP_PACKET_HEADER_MAX   (RTP_HEADER_SIZE + 3)   //rtp header + fu indicator/payload header + fu header
+#define RTP_PACKET_IOV_MAX      (3)     //header, the payload may wrap in the venc buffer
+#define RTP_DEFAULT_PAYLOAD_TYPE (96)
+
+typedef enum RTP_CODEC_E
+{
+    RTP_CODEC_H264 = 0,
+    RTP_CODEC_H265,
+} RTP_CODEC_E;
+
+/*
+ * An annexb access unit, in one or two parts: the venc output buffer is a
+ * ring and a frame can wrap at its end.
+ */
+typedef struct RTP_FRAME_BUF_S
+{
+    const uint8_t *mpData[2];
+    unsigned int mLen[2];
+} RTP_FRAME_BUF_S;
+
+/*
+ * mIov[0] is mHeader, the others point into the frame: a packet is only
+ * valid as long as the frame it was made from.
+ */
+typedef struct RTP_PACKET_S
+{
+    uint8_t mHeader[RTP_PACKET_HEADER_MAX];
+    struct iovec mIov[RTP_PACKET_IOV_MAX];
+    int mIovNum;
+    unsigned int mLen;          //of all the iovs
+} RTP_PACKET_S;
+
+typedef struct RTP_PACKETIZER_S
+{
+    RTP_CODEC_E meCodec;
+    unsigned int mMaxPayload;   //rtp payload bytes, without the rtp header
+    uint8_t mPayloadType;
+    uint32_t mSsrc;
+    uint16_t mSeq;              //of the next packet
+
+    RTP_PACKET_S *mpPackets;    //of the last frame
+    int mPacketNum;
+    int mPacketCap;
+} RTP_PACKETIZER_S;
+
+/*
+ * nal unit found by RtpFindNalUnits(), offsets in the frame as if its two
+ * parts were one, without the start code.
+ */
+typedef struct RTP_NAL_S
+{
+    unsigned int mOffset;
+    unsigned int mLen;
+} RTP_NAL_S;
+
+int RtpPacketizerInit(RTP_PACKETIZER_S *pPacketizer, RTP_CODEC_E eCodec, unsigned int nMaxPayload, uint32_t nSsrc, uint16_t nFirstSeq);
+void RtpPacketizerDeinit(RTP_PACKETIZER_S *pPacketizer);
+
+/*
+ * split the nal units of pNals into packets with timestamp nRtpTime, the
+ * marker bit set on the last one if bEndOfFrame. The packets replace the
+ * ones of the previous call, see mpPackets and mPacketNum.
+ * @return the number of packets, -1 if out of memory.
+ */
+int RtpPacketizeNals(RTP_PACKETIZER_S *pPacketizer, const RTP_FRAME_BUF_S *pFrame, const RTP_NAL_S *pNals, int nNalNum, uint32_t nRtpTime, int bEndOfFrame);
+
+/*
+ * find the nal units of an annexb frame.
+ * @return the number found, at most nMaxNum; -1 if there are more.
+ */
+int RtpFindNalUnits(const RTP_FRAME_BUF_S *pFrame, RTP_NAL_S *pNals, int nMaxNum);
+
+/* byte of the frame at nOffset, the two parts taken as one */
+static inline uint8_t RtpFrameByte(const RTP_FRAME_BUF_S *pFrame, unsigned int nOffset)
+{
+    return nOffset < pFrame->mLen[0] ? pFrame->mpData[0][nOffset] : pFrame->mpData[1][nOffset - pFrame->mLen[0]];
+}
+
+/* nal unit type of the nal starting at nOffset */
+int RtpNalType(RTP_CODEC_E eCodec, const RTP_FRAME_BUF_S *pFrame, unsigned int nOffset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _RTP_PACKETIZER_H_ */
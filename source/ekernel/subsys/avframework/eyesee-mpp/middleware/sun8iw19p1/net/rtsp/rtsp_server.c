@@ -0,0 +1,1587 @@
+/******************************************************************************
+  Copyright (C), 2001-2016, Allwinner Tech. Co., Ltd.
+ ******************************************************************************
+  File Name     : rtsp_server.c
+  Version       : Initial Draft
+  Author        : Allwinner PDC-PD5 Team
+  Created       : 2020/12/07
+  Last Modified :
+  Description   : rtsp server streaming the venc output over rtp
+  Function List :
+  History       :
+******************************************************************************/
+//#define LOG_NDEBUG 0
+#define LOG_TAG "rtsp_server"
+#include <utils/plat_log.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#include <SystemBase.h>
+#include <mpp_frametrace.h>
+
+#include "rtp_pacer.h"
+#include "rtsp_server.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL        (0)
+#endif
+
+#define RTSP_DEFAULT_MAX_CLIENT_NUM     (8)
+#define RTSP_DEFAULT_SESSION_TIMEOUT    (60)
+#define RTSP_DEFAULT_RTCP_INTERVAL_MS   (5000)
+#define RTSP_DEFAULT_MAX_PAYLOAD        (1400)
+#define RTSP_DEFAULT_PACE_BURST         (16*1024)
+#define RTSP_RECV_BUF_SIZE              (4096)
+#define RTSP_SEND_BUF_SIZE              (8192)  //rtsp responses, and the rest of a partly sent interleaved packet
+#define RTSP_MAX_PAYLOAD                (RTSP_SEND_BUF_SIZE - 4 - RTP_PACKET_HEADER_MAX)   //the rest of a packet fits in mSendBuf
+#define RTSP_RESPONSE_SIZE              (3072)  //with the sdp
+#define RTSP_MAX_NAL_NUM                (64)
+#define RTSP_PARAM_SET_NUM              (3)     //vps, sps, pps
+#define RTSP_PARAM_SET_SIZE             (256)
+#define RTSP_SELECT_TIMEOUT_MS          (100)
+#define RTP_CLOCK_RATE                  (90000)
+#define RTCP_SR                         (200)
+#define RTCP_RR                         (201)
+#define RTCP_SDES                       (202)
+#define NTP_UNIX_EPOCH_OFFSET           (2208988800U)
+
+typedef struct RTSP_CLIENT_S
+{
+    int mFd;
+    struct sockaddr_in mPeer;
+    char mRecvBuf[RTSP_RECV_BUF_SIZE];
+    int mRecvLen;
+    uint8_t mSendBuf[RTSP_SEND_BUF_SIZE];
+    int mSendLen;
+    int mbClosing;              //to be removed by the control thread
+
+    RTSP_STREAM_S *mpStream;    //after SETUP
+    uint32_t mSessionId;
+    int mbPlaying;
+    int mbTcp;
+    int mRtpChannel;            //interleaved channels
+    int mRtcpChannel;
+    struct sockaddr_in mRtpAddr;    //udp
+    struct sockaddr_in mRtcpAddr;
+    int mbWaitKeyFrame;         //packets were lost, or just started
+    int mbLagging;              //packets were lost, the backlog counts as full until the next key frame
+    int mbInFrame;              //receives the frame being sent
+    int64_t mLastActiveUs;
+    int64_t mLastSrUs;
+    uint32_t mLastSrNtpMid;     //middle 32 bits of the ntp time of the last sender report
+
+    RTSP_CLIENT_STAT_S mStat;
+} RTSP_CLIENT_S;
+
+struct RTSP_STREAM_S
+{
+    RTSP_SERVER_S *mpServer;
+    int mIndex;                 //frame trace channel
+    RTSP_STREAM_ATTR_S mAttr;
+    RTP_PACKETIZER_S mPacketizer;   //only used by the sending thread
+    RTP_PACER_S mPacer;
+    uint32_t mSsrc;
+    uint32_t mRtpTimeBase;
+
+    //the ones below are guarded by the mLock of the server
+    uint16_t mNextSeq;
+    uint32_t mLastRtpTime;
+    int64_t mLastFrameUs;       //-1 before the first frame
+    uint8_t mParamSet[RTSP_PARAM_SET_NUM][RTSP_PARAM_SET_SIZE];
+    unsigned int mParamSetLen[RTSP_PARAM_SET_NUM];
+    RTSP_STREAM_STAT_S mStat;
+};
+
+struct RTSP_SERVER_S
+{
+    RTSP_SERVER_ATTR_S mAttr;
+    int mListenFd;
+    int mRtpFd;                 //udp, shared by the clients of all the streams
+    int mRtcpFd;
+    int mPort;
+    int mRtpPort;
+    uint32_t mRandom;
+
+    pthread_t mThreadId;
+
+    pthread_mutex_t mLock;
+    int mbQuit;
+    RTSP_STREAM_S *mpStreams[RTSP_SERVER_MAX_STREAM_NUM];
+    int mStreamNum;
+    RTSP_CLIENT_S **mppClients; //mAttr.mMaxClientNum slots
+};
+
+static uint32_t RtspRandom(RTSP_SERVER_S *pServer)
+{
+    //xorshift32
+    uint32_t x = pServer->mRandom;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pServer->mRandom = x;
+    return x;
+}
+
+static void GetNtpTime(uint32_t *pSec, uint32_t *pFrac)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    *pSec = (uint32_t)tv.tv_sec + NTP_UNIX_EPOCH_OFFSET;
+    *pFrac = (uint32_t)(((uint64_t)tv.tv_usec << 32) / 1000000);
+}
+
+static void PutBe16(uint8_t *p, unsigned int n)
+{
+    p[0] = (n >> 8) & 0xFF;
+    p[1] = n & 0xFF;
+}
+
+static void PutBe32(uint8_t *p, uint32_t n)
+{
+    p[0] = n >> 24;
+    p[1] = (n >> 16) & 0xFF;
+    p[2] = (n >> 8) & 0xFF;
+    p[3] = n & 0xFF;
+}
+
+static uint32_t GetBe32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int Base64Encode(const uint8_t *pSrc, unsigned int nLen, char *pDst, int nSize)
+{
+    static const char sTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    unsigned int i;
+    int n = 0;
+    if((int)((nLen + 2) / 3 * 4) >= nSize)
+    {
+        return -1;
+    }
+    for(i = 0; i < nLen; i += 3)
+    {
+        uint32_t v = (uint32_t)pSrc[i] << 16;
+        if(i + 1 < nLen)
+        {
+            v |= (uint32_t)pSrc[i+1] << 8;
+        }
+        if(i + 2 < nLen)
+        {
+            v |= pSrc[i+2];
+        }
+        pDst[n++] = sTable[(v >> 18) & 0x3F];
+        pDst[n++] = sTable[(v >> 12) & 0x3F];
+        pDst[n++] = i + 1 < nLen ? sTable[(v >> 6) & 0x3F] : '=';
+        pDst[n++] = i + 2 < nLen ? sTable[v & 0x3F] : '=';
+    }
+    pDst[n] = '\0';
+    return n;
+}
+
+/* slot of the parameter set of nal type nType in mParamSet[], -1 if it is none */
+static int ParamSetIndex(RTP_CODEC_E eCodec, int nType)
+{
+    if(RTP_CODEC_H264 == eCodec)
+    {
+        return 7 == nType ? 1 : (8 == nType ? 2 : -1);
+    }
+    return 32 == nType ? 0 : (33 == nType ? 1 : (34 == nType ? 2 : -1));
+}
+
+/* keep the parameter sets of the nals, under mLock. @return the number found */
+static int StoreParamSets(RTSP_STREAM_S *pStream, const RTP_FRAME_BUF_S *pFrame, const RTP_NAL_S *pNals, int nNalNum)
+{
+    int nFound = 0;
+    int i;
+    unsigned int j;
+    for(i = 0; i < nNalNum; i++)
+    {
+        int nIndex = ParamSetIndex(pStream->mAttr.meCodec, RtpNalType(pStream->mAttr.meCodec, pFrame, pNals[i].mOffset));
+        if(nIndex < 0)
+        {
+            continue;
+        }
+        nFound++;
+        if(pNals[i].mLen > RTSP_PARAM_SET_SIZE)
+        {
+            alogw("parameter set of %u bytes too long, ignore it", pNals[i].mLen);
+            continue;
+        }
+        for(j = 0; j < pNals[i].mLen; j++)
+        {
+            pStream->mParamSet[nIndex][j] = RtpFrameByte(pFrame, pNals[i].mOffset + j);
+        }
+        pStream->mParamSetLen[nIndex] = pNals[i].mLen;
+    }
+    return nFound;
+}
+
+static void ClientFlush(RTSP_CLIENT_S *pClient)
+{
+    int n;
+    if(pClient->mSendLen <= 0 || pClient->mbClosing)
+    {
+        return;
+    }
+    n = send(pClient->mFd, pClient->mSendBuf, pClient->mSendLen, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if(n < 0)
+    {
+        if(EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno)
+        {
+            alogw("client %s send fail[%d]", pClient->mStat.mAddr, errno);
+            pClient->mbClosing = 1;
+        }
+        return;
+    }
+    pClient->mSendLen -= n;
+    if(pClient->mSendLen > 0)
+    {
+        memmove(pClient->mSendBuf, pClient->mSendBuf + n, pClient->mSendLen);
+    }
+}
+
+/* queue rtsp or rtcp bytes to the connection, under mLock */
+static void ClientQueue(RTSP_CLIENT_S *pClient, const void *pData, int nLen)
+{
+    if(pClient->mSendLen + nLen > RTSP_SEND_BUF_SIZE)
+    {
+        alogw("client %s does not read, close it", pClient->mStat.mAddr);
+        pClient->mbClosing = 1;
+        return;
+    }
+    memcpy(pClient->mSendBuf + pClient->mSendLen, pData, nLen);
+    pClient->mSendLen += nLen;
+    ClientFlush(pClient);
+}
+
+/* rtp packet to a client, under mLock. @return 0 if it was sent or queued */
+static int ClientSendRtp(RTSP_SERVER_S *pServer, RTSP_CLIENT_S *pClient, const RTP_PACKET_S *pPacket)
+{
+    struct iovec stIov[RTP_PACKET_IOV_MAX + 1];
+    struct msghdr stMsg;
+    uint8_t nPrefix[4];
+    unsigned int nTotal;
+    int i, n;
+
+    memset(&stMsg, 0, sizeof(stMsg));
+    if(!pClient->mbTcp)
+    {
+        stMsg.msg_name = &pClient->mRtpAddr;
+        stMsg.msg_namelen = sizeof(pClient->mRtpAddr);
+        stMsg.msg_iov = (struct iovec*)pPacket->mIov;
+        stMsg.msg_iovlen = pPacket->mIovNum;
+        n = sendmsg(pServer->mRtpFd, &stMsg, MSG_DONTWAIT);
+        return n == (int)pPacket->mLen ? 0 : -1;
+    }
+
+    //interleaved: the rest of a packet must go before another one starts
+    if(pClient->mSendLen > 0)
+    {
+        ClientFlush(pClient);
+        if(pClient->mSendLen > 0)
+        {
+            return -1;
+        }
+    }
+    nPrefix[0] = '$';
+    nPrefix[1] = pClient->mRtpChannel;
+    PutBe16(nPrefix + 2, pPacket->mLen);
+    stIov[0].iov_base = nPrefix;
+    stIov[0].iov_len = sizeof(nPrefix);
+    for(i = 0; i < pPacket->mIovNum; i++)
+    {
+        stIov[i+1] = pPacket->mIov[i];
+    }
+    nTotal = sizeof(nPrefix) + pPacket->mLen;
+    stMsg.msg_iov = stIov;
+    stMsg.msg_iovlen = pPacket->mIovNum + 1;
+    n = sendmsg(pClient->mFd, &stMsg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if(n < 0)
+    {
+        if(EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno)
+        {
+            alogw("client %s send fail[%d]", pClient->mStat.mAddr, errno);
+            pClient->mbClosing = 1;
+        }
+        return -1;
+    }
+    if((unsigned int)n < nTotal)
+    {
+        //keep the rest, the packet is not valid after the frame is released
+        int nSkip = n;
+        for(i = 0; i < pPacket->mIovNum + 1; i++)
+        {
+            int nIovLen = (int)stIov[i].iov_len;
+            if(nSkip >= nIovLen)
+            {
+                nSkip -= nIovLen;
+                continue;
+            }
+            memcpy(pClient->mSendBuf + pClient->mSendLen, (uint8_t*)stIov[i].iov_base + nSkip, nIovLen - nSkip);
+            pClient->mSendLen += nIovLen - nSkip;
+            nSkip = 0;
+        }
+    }
+    return 0;
+}
+
+static void ClientSendRtcp(RTSP_SERVER_S *pServer, RTSP_CLIENT_S *pClient, const uint8_t *pData, int nLen)
+{
+    if(pClient->mbTcp)
+    {
+        uint8_t nPrefix[4];
+        if(pClient->mSendLen + (int)sizeof(nPrefix) + nLen > RTSP_SEND_BUF_SIZE)
+        {
+            return;
+        }
+        nPrefix[0] = '$';
+        nPrefix[1] = pClient->mRtcpChannel;
+        PutBe16(nPrefix + 2, nLen);
+        ClientQueue(pClient, nPrefix, sizeof(nPrefix));
+        ClientQueue(pClient, pData, nLen);
+    }
+    else
+    {
+        sendto(pServer->mRtcpFd, pData, nLen, MSG_DONTWAIT, (struct sockaddr*)&pClient->mRtcpAddr, sizeof(pClient->mRtcpAddr));
+    }
+}
+
+/* sender report and cname, under mLock */
+static void ClientSendSenderReport(RTSP_SERVER_S *pServer, RTSP_CLIENT_S *pClient, int64_t nNowUs)
+{
+    RTSP_STREAM_S *pStream = pClient->mpStream;
+    static const char sCname[] = "eyesee-mpp";
+    uint8_t nBuf[64];
+    uint32_t nSec, nFrac, nRtpTime;
+    int nSdesLen, nLen;
+
+    GetNtpTime(&nSec, &nFrac);
+    nRtpTime = pStream->mRtpTimeBase;
+    if(pStream->mLastFrameUs >= 0)
+    {
+        nRtpTime = pStream->mLastRtpTime + (uint32_t)((nNowUs - pStream->mLastFrameUs) * 9 / 100);
+    }
+    nBuf[0] = 0x80;
+    nBuf[1] = RTCP_SR;
+    PutBe16(nBuf + 2, 6);
+    PutBe32(nBuf + 4, pStream->mSsrc);
+    PutBe32(nBuf + 8, nSec);
+    PutBe32(nBuf + 12, nFrac);
+    PutBe32(nBuf + 16, nRtpTime);
+    PutBe32(nBuf + 20, (uint32_t)pClient->mStat.mPackets);
+    PutBe32(nBuf + 24, (uint32_t)(pClient->mStat.mBytes - pClient->mStat.mPackets * RTP_HEADER_SIZE));
+
+    //sdes: ssrc, cname item, end of items, padded to 4 bytes
+    nSdesLen = 4 + 4 + 2 + (sizeof(sCname) - 1) + 1;
+    nSdesLen = (nSdesLen + 3) & ~3;
+    memset(nBuf + 28, 0, nSdesLen);
+    nBuf[28] = 0x81;
+    nBuf[29] = RTCP_SDES;
+    PutBe16(nBuf + 30, nSdesLen / 4 - 1);
+    PutBe32(nBuf + 32, pStream->mSsrc);
+    nBuf[36] = 1;   //cname
+    nBuf[37] = sizeof(sCname) - 1;
+    memcpy(nBuf + 38, sCname, sizeof(sCname) - 1);
+    nLen = 28 + nSdesLen;
+
+    ClientSendRtcp(pServer, pClient, nBuf, nLen);
+    pClient->mLastSrUs = nNowUs;
+    pClient->mLastSrNtpMid = (nSec << 16) | (nFrac >> 16);
+}
+
+/* rtcp compound packet from a client, under mLock */
+static void ClientParseRtcp(RTSP_CLIENT_S *pClient, const uint8_t *p, int nLen)
+{
+    while(nLen >= 4)
+    {
+        int nPacketLen = (((p[2] << 8) | p[3]) + 1) * 4;
+        int nCount = p[0] & 0x1F;
+        if((p[0] >> 6) != 2 || nPacketLen > nLen)
+        {
+            break;
+        }
+        if(RTCP_RR == p[1] && nCount > 0 && nPacketLen >= 8 + 24)
+        {
+            const uint8_t *pBlock = p + 8;
+            uint32_t nLsr = GetBe32(pBlock + 16);
+            uint32_t nDlsr = GetBe32(pBlock + 20);
+            pClient->mStat.mReceiverReports++;
+            pClient->mStat.mFractionLost = pBlock[4];
+            pClient->mStat.mCumulativeLost = (int)(GetBe32(pBlock + 4) & 0xFFFFFF);
+            if(pClient->mStat.mCumulativeLost & 0x800000)
+            {
+                pClient->mStat.mCumulativeLost -= 0x1000000;
+            }
+            pClient->mStat.mJitter = GetBe32(pBlock + 12);
+            if(nLsr != 0)
+            {
+                uint32_t nSec, nFrac;
+                int32_t nRtt;
+                GetNtpTime(&nSec, &nFrac);
+                nRtt = (int32_t)(((nSec << 16) | (nFrac >> 16)) - nLsr - nDlsr);
+                pClient->mStat.mRttMs = nRtt >= 0 ? (int)((int64_t)nRtt * 1000 / 65536) : 0;
+            }
+        }
+        p += nPacketLen;
+        nLen -= nPacketLen;
+    }
+    pClient->mLastActiveUs = CDX_GetSysTimeUsMonotonic();
+}
+
+static void ClientDestroy(RTSP_CLIENT_S *pClient)
+{
+    alogd("client %s:%d gone", pClient->mStat.mAddr, pClient->mStat.mPort);
+    close(pClient->mFd);
+    free(pClient);
+}
+
+typedef struct RTSP_REQUEST_S
+{
+    char mMethod[16];
+    char mUrl[256];
+    int mCSeq;
+    const char *mpTransport;    //value of the header, up to the end of the line
+    uint32_t mSession;
+    int mbHaveSession;
+} RTSP_REQUEST_S;
+
+static const char *FindHeader(const char *pReq, const char *pName)
+{
+    int nNameLen = strlen(pName);
+    const char *p = strstr(pReq, "\r\n");
+    while(p != NULL && p[2] != '\0' && p[2] != '\r')
+    {
+        p += 2;
+        if(0 == strncasecmp(p, pName, nNameLen) && ':' == p[nNameLen])
+        {
+            p += nNameLen + 1;
+            while(' ' == *p || '\t' == *p)
+            {
+                p++;
+            }
+            return p;
+        }
+        p = strstr(p, "\r\n");
+    }
+    return NULL;
+}
+
+static int ParseRequest(const char *pReq, RTSP_REQUEST_S *pRequest)
+{
+    const char *p;
+    memset(pRequest, 0, sizeof(*pRequest));
+    if(sscanf(pReq, "%15s %255s", pRequest->mMethod, pRequest->mUrl) != 2)
+    {
+        return -1;
+    }
+    p = FindHeader(pReq, "CSeq");
+    pRequest->mCSeq = p != NULL ? atoi(p) : 0;
+    pRequest->mpTransport = FindHeader(pReq, "Transport");
+    p = FindHeader(pReq, "Session");
+    if(p != NULL)
+    {
+        pRequest->mSession = (uint32_t)strtoul(p, NULL, 16);
+        pRequest->mbHaveSession = 1;
+    }
+    return 0;
+}
+
+/* stream named by the path of the url, with or without the track suffix */
+static RTSP_STREAM_S *FindStream(RTSP_SERVER_S *pServer, const char *pUrl)
+{
+    const char *pPath = pUrl;
+    int i;
+    if(0 == strncasecmp(pPath, "rtsp://", 7))
+    {
+        pPath = strchr(pPath + 7, '/');
+        if(NULL == pPath)
+        {
+            return NULL;
+        }
+    }
+    while('/' == *pPath)
+    {
+        pPath++;
+    }
+    for(i = 0; i < pServer->mStreamNum; i++)
+    {
+        RTSP_STREAM_S *pStream = pServer->mpStreams[i];
+        int nNameLen = strlen(pStream->mAttr.mName);
+        if(0 == strncmp(pPath, pStream->mAttr.mName, nNameLen)
+            && ('\0' == pPath[nNameLen] || '/' == pPath[nNameLen]))
+        {
+            return pStream;
+        }
+    }
+    return NULL;
+}
+
+static void SendResponse(RTSP_CLIENT_S *pClient, const RTSP_REQUEST_S *pRequest, int nCode, const char *pReason, const char *pHeaders, const char *pBody)
+{
+    char pBuf[RTSP_RESPONSE_SIZE];
+    int nLen;
+    nLen = snprintf(pBuf, sizeof(pBuf), "RTSP/1.0 %d %s\r\nCSeq: %d\r\nServer: eyesee-mpp\r\n%s", nCode, pReason, pRequest->mCSeq, pHeaders != NULL ? pHeaders : "");
+    if(pBody != NULL)
+    {
+        nLen += snprintf(pBuf + nLen, sizeof(pBuf) - nLen, "Content-Length: %d\r\n\r\n%s", (int)strlen(pBody), pBody);
+    }
+    else
+    {
+        nLen += snprintf(pBuf + nLen, sizeof(pBuf) - nLen, "\r\n");
+    }
+    if(nLen >= (int)sizeof(pBuf))
+    {
+        aloge("fatal error! rtsp response too long");
+        return;
+    }
+    ClientQueue(pClient, pBuf, nLen);
+}
+
+
+static int MakeSdp(RTSP_STREAM_S *pStream, const char *pLocalIp, char *pSdp, int nSize)
+{
+    char pSets[RTSP_PARAM_SET_NUM][(RTSP_PARAM_SET_SIZE + 2) / 3 * 4 + 1];
+    int n, i;
+
+    for(i = 0; i < RTSP_PARAM_SET_NUM; i++)
+    {
+        pSets[i][0] = '\0';
+        if(pStream->mParamSetLen[i] > 0)
+        {
+            Base64Encode(pStream->mParamSet[i], pStream->mParamSetLen[i], pSets[i], sizeof(pSets[i]));
+        }
+    }
+    n = snprintf(pSdp, nSize,
+        "v=0\r\n"
+        "o=- %u 1 IN IP4 %s\r\n"
+        "s=%s\r\n"
+        "c=IN IP4 0.0.0.0\r\n"
+        "t=0 0\r\n"
+        "a=control:*\r\n"
+        "a=range:npt=0-\r\n"
+        "m=video 0 RTP/AVP %d\r\n",
+        pStream->mSsrc, pLocalIp, pStream->mAttr.mName, RTP_DEFAULT_PAYLOAD_TYPE);
+    if(RTP_CODEC_H264 == pStream->mAttr.meCodec)
+    {
+        n += snprintf(pSdp + n, nSize - n, "a=rtpmap:%d H264/%d\r\na=fmtp:%d packetization-mode=1",
+            RTP_DEFAULT_PAYLOAD_TYPE, RTP_CLOCK_RATE, RTP_DEFAULT_PAYLOAD_TYPE);
+        if(pStream->mParamSetLen[1] >= 4 && pStream->mParamSetLen[2] > 0)
+        {
+            n += snprintf(pSdp + n, nSize - n, ";profile-level-id=%02X%02X%02X;sprop-parameter-sets=%s,%s",
+                pStream->mParamSet[1][1], pStream->mParamSet[1][2], pStream->mParamSet[1][3], pSets[1], pSets[2]);
+        }
+    }
+    else
+    {
+        n += snprintf(pSdp + n, nSize - n, "a=rtpmap:%d H265/%d\r\na=fmtp:%d profile-id=1",
+            RTP_DEFAULT_PAYLOAD_TYPE, RTP_CLOCK_RATE, RTP_DEFAULT_PAYLOAD_TYPE);
+        if(pStream->mParamSetLen[0] > 0 && pStream->mParamSetLen[1] > 0 && pStream->mParamSetLen[2] > 0)
+        {
+            n += snprintf(pSdp + n, nSize - n, ";sprop-vps=%s;sprop-sps=%s;sprop-pps=%s", pSets[0], pSets[1], pSets[2]);
+        }
+    }
+    n += snprintf(pSdp + n, nSize - n, "\r\na=control:track0\r\n");
+    return n < nSize ? n : -1;
+}
+
+/* the request of a session, 454 if it is not the one of the client */
+static int CheckSession(RTSP_CLIENT_S *pClient, const RTSP_REQUEST_S *pRequest)
+{
+    if(!pRequest->mbHaveSession || 0 == pClient->mSessionId || pRequest->mSession != pClient->mSessionId)
+    {
+        SendResponse(pClient, pRequest, 454, "Session Not Found", NULL, NULL);
+        return -1;
+    }
+    return 0;
+}
+
+static void HandleSetup(RTSP_SERVER_S *pServer, RTSP_CLIENT_S *pClient, const RTSP_REQUEST_S *pRequest)
+{
+    RTSP_STREAM_S *pStream = FindStream(pServer, pRequest->mUrl);
+    const char *pTransport = pRequest->mpTransport;
+    char pHeaders[512];
+    const char *p;
+    int nRtpPort = 0, nRtcpPort = 0;
+
+    if(NULL == pStream)
+    {
+        SendResponse(pClient, pRequest, 404, "Not Found", NULL, NULL);
+        return;
+    }
+    if(pRequest->mbHaveSession && (0 == pClient->mSessionId || pRequest->mSession != pClient->mSessionId))
+    {
+        SendResponse(pClient, pRequest, 454, "Session Not Found", NULL, NULL);
+        return;
+    }
+    if(pClient->mpStream != NULL && pClient->mpStream != pStream)
+    {
+        SendResponse(pClient, pRequest, 459, "Aggregate Operation Not Allowed", NULL, NULL);
+        return;
+    }
+    if(NULL == pTransport || ((p = strstr(pTransport, "multicast")) != NULL && p < strstr(pTransport, "\r\n")))
+    {
+        SendResponse(pClient, pRequest, 461, "Unsupported Transport", NULL, NULL);
+        return;
+    }
+    if(0 == strncmp(pTransport, "RTP/AVP/TCP", 11))
+    {
+        pClient->mbTcp = 1;
+        pClient->mRtpChannel = 0;
+        pClient->mRtcpChannel = 1;
+        p = strstr(pTransport, "interleaved=");
+        if(p != NULL && p < strstr(pTransport, "\r\n"))
+        {
+            sscanf(p, "interleaved=%d-%d", &pClient->mRtpChannel, &pClient->mRtcpChannel);
+        }
+        snprintf(pHeaders, sizeof(pHeaders), "Transport: RTP/AVP/TCP;unicast;interleaved=%d-%d;ssrc=%08X\r\n",
+            pClient->mRtpChannel, pClient->mRtcpChannel, pStream->mSsrc);
+    }
+    else
+    {
+        p = strstr(pTransport, "client_port=");
+        if(pServer->mRtpFd < 0 || NULL == p || p > strstr(pTransport, "\r\n")
+            || sscanf(p, "client_port=%d-%d", &nRtpPort, &nRtcpPort) < 1)
+        {
+            SendResponse(pClient, pRequest, 461, "Unsupported Transport", NULL, NULL);
+            return;
+        }
+        if(0 == nRtcpPort)
+        {
+            nRtcpPort = nRtpPort + 1;
+        }
+        pClient->mbTcp = 0;
+        pClient->mRtpAddr = pClient->mPeer;
+        pClient->mRtpAddr.sin_port = htons(nRtpPort);
+        pClient->mRtcpAddr = pClient->mPeer;
+        pClient->mRtcpAddr.sin_port = htons(nRtcpPort);
+        snprintf(pHeaders, sizeof(pHeaders), "Transport: RTP/AVP;unicast;client_port=%d-%d;server_port=%d-%d;ssrc=%08X\r\n",
+            nRtpPort, nRtcpPort, pServer->mRtpPort, pServer->mRtpPort + 1, pStream->mSsrc);
+    }
+    if(0 == pClient->mSessionId)
+    {
+        pClient->mSessionId = RtspRandom(pServer) | 1;
+    }
+    pClient->mpStream = pStream;
+    pClient->mStat.mbTcp = pClient->mbTcp;
+    snprintf(pHeaders + strlen(pHeaders), sizeof(pHeaders) - strlen(pHeaders), "Session: %08X;timeout=%d\r\n",
+        pClient->mSessionId, pServer->mAttr.mSessionTimeoutSec);
+    SendResponse(pClient, pRequest, 200, "OK", pHeaders, NULL);
+}
+
+/* a request of the client, under mLock */
+static void HandleRequest(RTSP_SERVER_S *pServer, RTSP_CLIENT_S *pClient, const char *pReq)
+{
+    RTSP_REQUEST_S stRequest;
+    char pHeaders[512];
+
+    if(ParseRequest(pReq, &stRequest) != 0)
+    {
+        memset(&stRequest, 0, sizeof(stRequest));
+        SendResponse(pClient, &stRequest, 400, "Bad Request", NULL, NULL);
+        return;
+    }
+    alogv("client %s: %s %s", pClient->mStat.mAddr, stRequest.mMethod, stRequest.mUrl);
+    if(0 == strcmp(stRequest.mMethod, "OPTIONS"))
+    {
+        SendResponse(pClient, &stRequest, 200, "OK", "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER, SET_PARAMETER\r\n", NULL);
+    }
+    else if(0 == strcmp(stRequest.mMethod, "DESCRIBE"))
+    {
+        RTSP_STREAM_S *pStream = FindStream(pServer, stRequest.mUrl);
+        struct sockaddr_in stLocal;
+        socklen_t nAddrLen = sizeof(stLocal);
+        char pLocalIp[16] = "0.0.0.0";
+        char pSdp[2048];
+
+        if(NULL == pStream)
+        {
+            SendResponse(pClient, &stRequest, 404, "Not Found", NULL, NULL);
+            return;
+        }
+        if(0 == getsockname(pClient->mFd, (struct sockaddr*)&stLocal, &nAddrLen))
+        {
+            strncpy(pLocalIp, inet_ntoa(stLocal.sin_addr), sizeof(pLocalIp) - 1);
+        }
+        if(MakeSdp(pStream, pLocalIp, pSdp, sizeof(pSdp)) < 0)
+        {
+            SendResponse(pClient, &stRequest, 500, "Internal Server Error", NULL, NULL);
+            return;
+        }
+        snprintf(pHeaders, sizeof(pHeaders), "Content-Base: %s/\r\nContent-Type: application/sdp\r\n", stRequest.mUrl);
+        SendResponse(pClient, &stRequest, 200, "OK", pHeaders, pSdp);
+    }
+    else if(0 == strcmp(stRequest.mMethod, "SETUP"))
+    {
+        HandleSetup(pServer, pClient, &stRequest);
+    }
+    else if(0 == strcmp(stRequest.mMethod, "PLAY"))
+    {
+        RTSP_STREAM_S *pStream = pClient->mpStream;
+        int nUrlLen;
+        if(CheckSession(pClient, &stRequest) != 0)
+        {
+            return;
+        }
+        pClient->mbPlaying = 1;
+        pClient->mbWaitKeyFrame = 1;
+        pClient->mbLagging = 0;
+        pClient->mbInFrame = 0;
+        pClient->mLastSrUs = CDX_GetSysTimeUsMonotonic();
+        pClient->mStat.mbPlaying = 1;
+        nUrlLen = strlen(stRequest.mUrl);
+        snprintf(pHeaders, sizeof(pHeaders), "Range: npt=0.000-\r\nSession: %08X\r\nRTP-Info: url=%s%strack0;seq=%u;rtptime=%u\r\n",
+            pClient->mSessionId, stRequest.mUrl, nUrlLen > 0 && '/' == stRequest.mUrl[nUrlLen - 1] ? "" : "/",
+            pStream->mNextSeq, pStream->mLastRtpTime);
+        SendResponse(pClient, &stRequest, 200, "OK", pHeaders, NULL);
+        alogd("client %s:%d plays %s over %s", pClient->mStat.mAddr, pClient->mStat.mPort, pStream->mAttr.mName, pClient->mbTcp ? "tcp" : "udp");
+    }
+    else if(0 == strcmp(stRequest.mMethod, "PAUSE") || 0 == strcmp(stRequest.mMethod, "TEARDOWN"))
+    {
+        if(CheckSession(pClient, &stRequest) != 0)
+        {
+            return;
+        }
+        snprintf(pHeaders, sizeof(pHeaders), "Session: %08X\r\n", pClient->mSessionId);
+        SendResponse(pClient, &stRequest, 200, "OK", pHeaders, NULL);
+        pClient->mbPlaying = 0;
+        pClient->mbInFrame = 0;
+        pClient->mStat.mbPlaying = 0;
+        if(0 == strcmp(stRequest.mMethod, "TEARDOWN"))
+        {
+            pClient->mpStream = NULL;
+            pClient->mSessionId = 0;
+        }
+    }
+    else if(0 == strcmp(stRequest.mMethod, "GET_PARAMETER") || 0 == strcmp(stRequest.mMethod, "SET_PARAMETER"))
+    {
+        //keep alive
+        if(stRequest.mbHaveSession && CheckSession(pClient, &stRequest) != 0)
+        {
+            return;
+        }
+        SendResponse(pClient, &stRequest, 200, "OK", NULL, NULL);
+    }
+    else
+    {
+        SendResponse(pClient, &stRequest, 501, "Not Implemented", NULL, NULL);
+    }
+}
+
+/* rtsp requests and interleaved rtcp of a client, under mLock */
+static void ClientOnReadable(RTSP_SERVER_S *pServer, RTSP_CLIENT_S *pClient)
+{
+    char pReq[RTSP_RECV_BUF_SIZE + 1];
+    int n;
+
+    n = recv(pClient->mFd, pClient->mRecvBuf + pClient->mRecvLen, RTSP_RECV_BUF_SIZE - pClient->mRecvLen, MSG_DONTWAIT);
+    if(n <= 0)
+    {
+        if(0 == n || (EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno))
+        {
+            pClient->mbClosing = 1;
+        }
+        return;
+    }
+    pClient->mRecvLen += n;
+    pClient->mLastActiveUs = CDX_GetSysTimeUsMonotonic();
+
+    while(pClient->mRecvLen > 0 && !pClient->mbClosing)
+    {
+        const char *pEnd;
+        const char *pContentLength;
+        int nUsed;
+
+        if('$' == pClient->mRecvBuf[0])
+        {
+            const uint8_t *p = (const uint8_t*)pClient->mRecvBuf;
+            int nLen;
+            if(pClient->mRecvLen < 4)
+            {
+                break;
+            }
+            nLen = (p[2] << 8) | p[3];
+            if(4 + nLen > RTSP_RECV_BUF_SIZE)
+            {
+                alogw("client %s: interleaved packet of %d bytes", pClient->mStat.mAddr, nLen);
+                pClient->mbClosing = 1;
+                break;
+            }
+            if(pClient->mRecvLen < 4 + nLen)
+            {
+                break;
+            }
+            if(pClient->mbTcp && p[1] == pClient->mRtcpChannel)
+            {
+                ClientParseRtcp(pClient, p + 4, nLen);
+            }
+            nUsed = 4 + nLen;
+        }
+        else
+        {
+            memcpy(pReq, pClient->mRecvBuf, pClient->mRecvLen);
+            pReq[pClient->mRecvLen] = '\0';
+            pEnd = strstr(pReq, "\r\n\r\n");
+            if(NULL == pEnd)
+            {
+                if(RTSP_RECV_BUF_SIZE == pClient->mRecvLen || strlen(pReq) < (size_t)pClient->mRecvLen)
+                {
+                    alogw("client %s: bad request", pClient->mStat.mAddr);
+                    pClient->mbClosing = 1;
+                }
+                break;
+            }
+            nUsed = pEnd + 4 - pReq;
+            pContentLength = FindHeader(pReq, "Content-Length");
+            if(pContentLength != NULL && pContentLength < pEnd)
+            {
+                int nBody = atoi(pContentLength);
+                if(nBody < 0 || nUsed + nBody > RTSP_RECV_BUF_SIZE)
+                {
+                    pClient->mbClosing = 1;
+                    break;
+                }
+                if(pClient->mRecvLen < nUsed + nBody)
+                {
+                    break;
+                }
+                nUsed += nBody;
+            }
+            pReq[pEnd + 2 - pReq] = '\0';
+            HandleRequest(pServer, pClient, pReq);
+        }
+        pClient->mRecvLen -= nUsed;
+        memmove(pClient->mRecvBuf, pClient->mRecvBuf + nUsed, pClient->mRecvLen);
+    }
+}
+
+static void AcceptClient(RTSP_SERVER_S *pServer)
+{
+    struct sockaddr_in stPeer;
+    socklen_t nAddrLen = sizeof(stPeer);
+    RTSP_CLIENT_S *pClient;
+    int nFd, nOn = 1;
+    int i;
+
+    nFd = accept(pServer->mListenFd, (struct sockaddr*)&stPeer, &nAddrLen);
+    if(nFd < 0)
+    {
+        alogw("accept fail[%d]", errno);
+        return;
+    }
+    pthread_mutex_lock(&pServer->mLock);
+    for(i = 0; i < pServer->mAttr.mMaxClientNum; i++)
+    {
+        if(NULL == pServer->mppClients[i])
+        {
+            break;
+        }
+    }
+    if(i >= pServer->mAttr.mMaxClientNum)
+    {
+        pthread_mutex_unlock(&pServer->mLock);
+        alogw("too many clients, refuse %s", inet_ntoa(stPeer.sin_addr));
+        close(nFd);
+        return;
+    }
+    pClient = (RTSP_CLIENT_S*)calloc(1, sizeof(RTSP_CLIENT_S));
+    if(NULL == pClient)
+    {
+        pthread_mutex_unlock(&pServer->mLock);
+        aloge("fatal error! malloc fail");
+        close(nFd);
+        return;
+    }
+    setsockopt(nFd, IPPROTO_TCP, TCP_NODELAY, &nOn, sizeof(nOn));
+    pClient->mFd = nFd;
+    pClient->mPeer = stPeer;
+    pClient->mLastActiveUs = CDX_GetSysTimeUsMonotonic();
+    strncpy(pClient->mStat.mAddr, inet_ntoa(stPeer.sin_addr), sizeof(pClient->mStat.mAddr) - 1);
+    pClient->mStat.mPort = ntohs(stPeer.sin_port);
+    pClient->mStat.mRttMs = -1;
+    pServer->mppClients[i] = pClient;
+    pthread_mutex_unlock(&pServer->mLock);
+    alogd("client %s:%d connected", pClient->mStat.mAddr, pClient->mStat.mPort);
+}
+
+/* receiver reports over udp, under mLock */
+static void ReadRtcpSocket(RTSP_SERVER_S *pServer)
+{
+    uint8_t nBuf[1500];
+    struct sockaddr_in stFrom;
+    socklen_t nAddrLen = sizeof(stFrom);
+    int n, i;
+
+    n = recvfrom(pServer->mRtcpFd, nBuf, sizeof(nBuf), MSG_DONTWAIT, (struct sockaddr*)&stFrom, &nAddrLen);
+    if(n <= 0)
+    {
+        return;
+    }
+    for(i = 0; i < pServer->mAttr.mMaxClientNum; i++)
+    {
+        RTSP_CLIENT_S *pClient = pServer->mppClients[i];
+        if(pClient != NULL && pClient->mpStream != NULL && !pClient->mbTcp
+            && pClient->mRtcpAddr.sin_addr.s_addr == stFrom.sin_addr.s_addr
+            && pClient->mRtcpAddr.sin_port == stFrom.sin_port)
+        {
+            ClientParseRtcp(pClient, nBuf, n);
+            break;
+        }
+    }
+}
+
+static void *RtspServerThread(void *pThreadData)
+{
+    RTSP_SERVER_S *pServer = (RTSP_SERVER_S*)pThreadData;
+    int64_t nRtcpIntervalUs = (int64_t)pServer->mAttr.mRtcpIntervalMs * 1000;
+    int64_t nTimeoutUs = (int64_t)pServer->mAttr.mSessionTimeoutSec * 1000000;
+    fd_set stReadSet, stWriteSet;
+    struct timeval tv;
+    int nMaxFd, nRet, i;
+
+    while(1)
+    {
+        FD_ZERO(&stReadSet);
+        FD_ZERO(&stWriteSet);
+        FD_SET(pServer->mListenFd, &stReadSet);
+        nMaxFd = pServer->mListenFd;
+        if(pServer->mRtpFd >= 0)
+        {
+            FD_SET(pServer->mRtpFd, &stReadSet);
+            FD_SET(pServer->mRtcpFd, &stReadSet);
+            nMaxFd = pServer->mRtpFd > nMaxFd ? pServer->mRtpFd : nMaxFd;
+            nMaxFd = pServer->mRtcpFd > nMaxFd ? pServer->mRtcpFd : nMaxFd;
+        }
+        pthread_mutex_lock(&pServer->mLock);
+        if(pServer->mbQuit)
+        {
+            pthread_mutex_unlock(&pServer->mLock);
+            break;
+        }
+        for(i = 0; i < pServer->mAttr.mMaxClientNum; i++)
+        {
+            RTSP_CLIENT_S *pClient = pServer->mppClients[i];
+            if(NULL == pClient)
+            {
+                continue;
+            }
+            FD_SET(pClient->mFd, &stReadSet);
+            if(pClient->mSendLen > 0)
+            {
+                FD_SET(pClient->mFd, &stWriteSet);
+            }
+            nMaxFd = pClient->mFd > nMaxFd ? pClient->mFd : nMaxFd;
+        }
+        pthread_mutex_unlock(&pServer->mLock);
+
+        tv.tv_sec = 0;
+        tv.tv_usec = RTSP_SELECT_TIMEOUT_MS * 1000;
+        nRet = select(nMaxFd + 1, &stReadSet, &stWriteSet, NULL, &tv);
+        if(nRet < 0)
+        {
+            if(errno != EINTR)
+            {
+                aloge("fatal error! select fail[%d]", errno);
+                usleep(RTSP_SELECT_TIMEOUT_MS * 1000);
+            }
+            continue;
+        }
+        if(nRet > 0 && FD_ISSET(pServer->mListenFd, &stReadSet))
+        {
+            AcceptClient(pServer);
+        }
+
+        pthread_mutex_lock(&pServer->mLock);
+        if(nRet > 0 && pServer->mRtpFd >= 0)
+        {
+            if(FD_ISSET(pServer->mRtcpFd, &stReadSet))
+            {
+                ReadRtcpSocket(pServer);
+            }
+            if(FD_ISSET(pServer->mRtpFd, &stReadSet))
+            {
+                uint8_t nBuf[64];
+                recv(pServer->mRtpFd, nBuf, sizeof(nBuf), MSG_DONTWAIT);   //nat keep alive, nothing to do
+            }
+        }
+        int64_t nNowUs = CDX_GetSysTimeUsMonotonic();
+        for(i = 0; i < pServer->mAttr.mMaxClientNum; i++)
+        {
+            RTSP_CLIENT_S *pClient = pServer->mppClients[i];
+            if(NULL == pClient)
+            {
+                continue;
+            }
+            //a client accepted after select() is not in the sets
+            if(nRet > 0 && FD_ISSET(pClient->mFd, &stReadSet))
+            {
+                ClientOnReadable(pServer, pClient);
+            }
+            if(nRet > 0 && FD_ISSET(pClient->mFd, &stWriteSet))
+            {
+                ClientFlush(pClient);
+            }
+            if(pClient->mbPlaying && !pClient->mbClosing && nNowUs - pClient->mLastSrUs >= nRtcpIntervalUs)
+            {
+                ClientSendSenderReport(pServer, pClient, nNowUs);
+            }
+            if(pClient->mbPlaying && !pClient->mbTcp && nNowUs - pClient->mLastActiveUs > nTimeoutUs)
+            {
+                alogw("client %s:%d timeout", pClient->mStat.mAddr, pClient->mStat.mPort);
+                pClient->mbClosing = 1;
+            }
+            if(pClient->mbClosing)
+            {
+                pServer->mppClients[i] = NULL;
+                ClientDestroy(pClient);
+            }
+        }
+        pthread_mutex_unlock(&pServer->mLock);
+    }
+    return NULL;
+}
+
+static int OpenUdpSocket(const struct sockaddr_in *pAddr, int nPort)
+{
+    struct sockaddr_in stAddr = *pAddr;
+    int nFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(nFd < 0)
+    {
+        return -1;
+    }
+    stAddr.sin_port = htons(nPort);
+    if(bind(nFd, (struct sockaddr*)&stAddr, sizeof(stAddr)) != 0)
+    {
+        close(nFd);
+        return -1;
+    }
+    return nFd;
+}
+
+/* rtp on an even port, rtcp on the next one */
+static int OpenRtpSockets(RTSP_SERVER_S *pServer, const struct sockaddr_in *pAddr)
+{
+    struct sockaddr_in stAddr;
+    socklen_t nAddrLen;
+    int nTry;
+
+    for(nTry = 0; nTry < 16; nTry++)
+    {
+        pServer->mRtpFd = OpenUdpSocket(pAddr, 0);
+        if(pServer->mRtpFd < 0)
+        {
+            break;
+        }
+        nAddrLen = sizeof(stAddr);
+        getsockname(pServer->mRtpFd, (struct sockaddr*)&stAddr, &nAddrLen);
+        pServer->mRtpPort = ntohs(stAddr.sin_port);
+        if(0 == (pServer->mRtpPort & 1))
+        {
+            pServer->mRtcpFd = OpenUdpSocket(pAddr, pServer->mRtpPort + 1);
+            if(pServer->mRtcpFd >= 0)
+            {
+                return 0;
+            }
+        }
+        close(pServer->mRtpFd);
+    }
+    pServer->mRtpFd = -1;
+    pServer->mRtcpFd = -1;
+    return -1;
+}
+
+RTSP_SERVER_S *RtspServerCreate(const RTSP_SERVER_ATTR_S *pAttr)
+{
+    RTSP_SERVER_S *pServer;
+    struct sockaddr_in stAddr;
+    socklen_t nAddrLen;
+    int nOn = 1;
+
+    pServer = (RTSP_SERVER_S*)calloc(1, sizeof(RTSP_SERVER_S));
+    if(NULL == pServer)
+    {
+        aloge("fatal error! malloc fail");
+        return NULL;
+    }
+    pServer->mAttr = *pAttr;
+    pServer->mAttr.mIp[sizeof(pServer->mAttr.mIp) - 1] = '\0';
+    if(pServer->mAttr.mMaxClientNum <= 0)
+    {
+        pServer->mAttr.mMaxClientNum = RTSP_DEFAULT_MAX_CLIENT_NUM;
+    }
+    if(pServer->mAttr.mSessionTimeoutSec <= 0)
+    {
+        pServer->mAttr.mSessionTimeoutSec = RTSP_DEFAULT_SESSION_TIMEOUT;
+    }
+    if(pServer->mAttr.mRtcpIntervalMs <= 0)
+    {
+        pServer->mAttr.mRtcpIntervalMs = RTSP_DEFAULT_RTCP_INTERVAL_MS;
+    }
+    pServer->mListenFd = -1;
+    pServer->mRtpFd = -1;
+    pServer->mRtcpFd = -1;
+    pServer->mRandom = (uint32_t)CDX_GetSysTimeUsMonotonic() ^ (uint32_t)(uintptr_t)pServer;
+    if(0 == pServer->mRandom)
+    {
+        pServer->mRandom = 0x12345678;
+    }
+    pthread_mutex_init(&pServer->mLock, NULL);
+    pServer->mppClients = (RTSP_CLIENT_S**)calloc(pServer->mAttr.mMaxClientNum, sizeof(RTSP_CLIENT_S*));
+    if(NULL == pServer->mppClients)
+    {
+        aloge("fatal error! malloc fail");
+        goto _err0;
+    }
+
+    memset(&stAddr, 0, sizeof(stAddr));
+    stAddr.sin_family = AF_INET;
+    stAddr.sin_addr.s_addr = pServer->mAttr.mIp[0] != '\0' ? inet_addr(pServer->mAttr.mIp) : htonl(INADDR_ANY);
+    pServer->mListenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if(pServer->mListenFd < 0)
+    {
+        aloge("fatal error! socket fail[%d]", errno);
+        goto _err0;
+    }
+    setsockopt(pServer->mListenFd, SOL_SOCKET, SO_REUSEADDR, &nOn, sizeof(nOn));
+    stAddr.sin_port = htons(pServer->mAttr.mPort);
+    if(bind(pServer->mListenFd, (struct sockaddr*)&stAddr, sizeof(stAddr)) != 0
+        || listen(pServer->mListenFd, pServer->mAttr.mMaxClientNum) != 0)
+    {
+        aloge("fatal error! listen on %s:%d fail[%d]", pServer->mAttr.mIp, pServer->mAttr.mPort, errno);
+        goto _err0;
+    }
+    nAddrLen = sizeof(stAddr);
+    getsockname(pServer->mListenFd, (struct sockaddr*)&stAddr, &nAddrLen);
+    pServer->mPort = ntohs(stAddr.sin_port);
+    stAddr.sin_port = 0;
+    if(OpenRtpSockets(pServer, &stAddr) != 0)
+    {
+        alogw("no udp port pair, rtp over tcp only");
+    }
+
+    if(pthread_create(&pServer->mThreadId, NULL, RtspServerThread, pServer) != 0)
+    {
+        aloge("fatal error! create thread fail");
+        goto _err0;
+    }
+    alogd("rtsp server on port %d, rtp port %d", pServer->mPort, pServer->mRtpPort);
+    return pServer;
+
+_err0:
+    if(pServer->mRtpFd >= 0)
+    {
+        close(pServer->mRtpFd);
+        close(pServer->mRtcpFd);
+    }
+    if(pServer->mListenFd >= 0)
+    {
+        close(pServer->mListenFd);
+    }
+    free(pServer->mppClients);
+    pthread_mutex_destroy(&pServer->mLock);
+    free(pServer);
+    return NULL;
+}
+
+void RtspServerDestroy(RTSP_SERVER_S *pServer)
+{
+    int i;
+    if(NULL == pServer)
+    {
+        return;
+    }
+    pthread_mutex_lock(&pServer->mLock);
+    pServer->mbQuit = 1;
+    pthread_mutex_unlock(&pServer->mLock);
+    pthread_join(pServer->mThreadId, NULL);
+    for(i = 0; i < pServer->mAttr.mMaxClientNum; i++)
+    {
+        if(pServer->mppClients[i] != NULL)
+        {
+            ClientDestroy(pServer->mppClients[i]);
+        }
+    }
+    for(i = 0; i < pServer->mStreamNum; i++)
+    {
+        RtpPacketizerDeinit(&pServer->mpStreams[i]->mPacketizer);
+        free(pServer->mpStreams[i]);
+    }
+    if(pServer->mRtpFd >= 0)
+    {
+        close(pServer->mRtpFd);
+        close(pServer->mRtcpFd);
+    }
+    close(pServer->mListenFd);
+    free(pServer->mppClients);
+    pthread_mutex_destroy(&pServer->mLock);
+    free(pServer);
+}
+
+int RtspServerGetPort(RTSP_SERVER_S *pServer)
+{
+    return pServer->mPort;
+}
+
+RTSP_STREAM_S *RtspServerCreateStream(RTSP_SERVER_S *pServer, const RTSP_STREAM_ATTR_S *pAttr)
+{
+    RTSP_STREAM_S *pStream;
+    int i;
+
+    pthread_mutex_lock(&pServer->mLock);
+    if(pServer->mStreamNum >= RTSP_SERVER_MAX_STREAM_NUM)
+    {
+        pthread_mutex_unlock(&pServer->mLock);
+        aloge("fatal error! too many streams");
+        return NULL;
+    }
+    for(i = 0; i < pServer->mStreamNum; i++)
+    {
+        if(0 == strncmp(pServer->mpStreams[i]->mAttr.mName, pAttr->mName, RTSP_STREAM_NAME_LEN))
+        {
+            pthread_mutex_unlock(&pServer->mLock);
+            aloge("fatal error! stream %s exists", pAttr->mName);
+            return NULL;
+        }
+    }
+    pStream = (RTSP_STREAM_S*)calloc(1, sizeof(RTSP_STREAM_S));
+    if(NULL == pStream)
+    {
+        pthread_mutex_unlock(&pServer->mLock);
+        aloge("fatal error! malloc fail");
+        return NULL;
+    }
+    pStream->mpServer = pServer;
+    pStream->mAttr = *pAttr;
+    pStream->mAttr.mName[RTSP_STREAM_NAME_LEN - 1] = '\0';
+    if(pStream->mAttr.mMaxPayload <= 0)
+    {
+        pStream->mAttr.mMaxPayload = RTSP_DEFAULT_MAX_PAYLOAD;
+    }
+    else if(pStream->mAttr.mMaxPayload > RTSP_MAX_PAYLOAD)
+    {
+        alogw("max payload[%d] of stream %s too big, use %d", pStream->mAttr.mMaxPayload, pStream->mAttr.mName, RTSP_MAX_PAYLOAD);
+        pStream->mAttr.mMaxPayload = RTSP_MAX_PAYLOAD;
+    }
+    if(pStream->mAttr.mPaceBurstBytes <= 0)
+    {
+        pStream->mAttr.mPaceBurstBytes = RTSP_DEFAULT_PACE_BURST;
+    }
+    pStream->mSsrc = RtspRandom(pServer);
+    pStream->mRtpTimeBase = RtspRandom(pServer);
+    pStream->mNextSeq = RtspRandom(pServer) & 0xFFFF;
+    pStream->mLastRtpTime = pStream->mRtpTimeBase;
+    pStream->mLastFrameUs = -1;
+    if(RtpPacketizerInit(&pStream->mPacketizer, pStream->mAttr.meCodec, pStream->mAttr.mMaxPayload, pStream->mSsrc, pStream->mNextSeq) != 0)
+    {
+        pthread_mutex_unlock(&pServer->mLock);
+        free(pStream);
+        return NULL;
+    }
+    RtpPacerInit(&pStream->mPacer, pStream->mAttr.mPaceBitRate, pStream->mAttr.mPaceBurstBytes);
+    pStream->mIndex = pServer->mStreamNum;
+    pServer->mpStreams[pServer->mStreamNum++] = pStream;
+    pthread_mutex_unlock(&pServer->mLock);
+    return pStream;
+}
+
+int RtspStreamGetUrl(RTSP_STREAM_S *pStream, char *pUrl, int nSize)
+{
+    RTSP_SERVER_S *pServer = pStream->mpServer;
+    int n = snprintf(pUrl, nSize, "rtsp://%s:%d/%s", pServer->mAttr.mIp[0] != '\0' ? pServer->mAttr.mIp : "127.0.0.1",
+        pServer->mPort, pStream->mAttr.mName);
+    return n < nSize ? 0 : -1;
+}
+
+int RtspStreamSetParameterSets(RTSP_STREAM_S *pStream, const uint8_t *pData, unsigned int nLen)
+{
+    RTP_FRAME_BUF_S stBuf;
+    RTP_NAL_S stNals[RTSP_MAX_NAL_NUM];
+    int nNalNum, nFound;
+
+    memset(&stBuf, 0, sizeof(stBuf));
+    stBuf.mpData[0] = pData;
+    stBuf.mLen[0] = nLen;
+    nNalNum = RtpFindNalUnits(&stBuf, stNals, RTSP_MAX_NAL_NUM);
+    if(nNalNum <= 0)
+    {
+        aloge("fatal error! no nal unit in the parameter sets");
+        return -1;
+    }
+    pthread_mutex_lock(&pStream->mpServer->mLock);
+    nFound = StoreParamSets(pStream, &stBuf, stNals, nNalNum);
+    pthread_mutex_unlock(&pStream->mpServer->mLock);
+    return nFound > 0 ? 0 : -1;
+}
+
+/* send the packets of the packetizer to the clients in the frame */
+static void SendPackets(RTSP_STREAM_S *pStream, int nReceivers)
+{
+    RTSP_SERVER_S *pServer = pStream->mpServer;
+    RTP_PACKETIZER_S *pPacketizer = &pStream->mPacketizer;
+    int64_t nNowUs, nDelayUs, nWaitUs = 0;
+    int i, j;
+
+    for(i = 0; i < pPacketizer->mPacketNum && nReceivers > 0; i++)
+    {
+        RTP_PACKET_S *pPacket = &pPacketizer->mpPackets[i];
+        int nSent = 0;
+
+        //the bucket is shared by the clients: a packet costs its bytes for each of them
+        nNowUs = CDX_GetSysTimeUsMonotonic();
+        nDelayUs = RtpPacerDelayUs(&pStream->mPacer, pPacket->mLen * nReceivers, nNowUs);
+        if(nDelayUs > 0)
+        {
+            usleep(nDelayUs);
+            nWaitUs += nDelayUs;
+            nNowUs = CDX_GetSysTimeUsMonotonic();
+        }
+
+        pthread_mutex_lock(&pServer->mLock);
+        for(j = 0; j < pServer->mAttr.mMaxClientNum; j++)
+        {
+            RTSP_CLIENT_S *pClient = pServer->mppClients[j];
+            if(NULL == pClient || pClient->mpStream != pStream || !pClient->mbInFrame)
+            {
+                continue;
+            }
+            if(!pClient->mbPlaying || pClient->mbClosing)
+            {
+                pClient->mbInFrame = 0;
+                nReceivers--;
+                continue;
+            }
+            if(0 == ClientSendRtp(pServer, pClient, pPacket))
+            {
+                pClient->mStat.mPackets++;
+                pClient->mStat.mBytes += pPacket->mLen;
+                pStream->mStat.mSentPackets++;
+                pStream->mStat.mSentBytes += pPacket->mLen;
+                nSent++;
+            }
+            else
+            {
+                //the rest of the frame can not be decoded, wait for a key frame
+                pClient->mStat.mDroppedPackets++;
+                pStream->mStat.mDroppedPackets++;
+                pClient->mbInFrame = 0;
+                pClient->mbWaitKeyFrame = 1;
+                pClient->mbLagging = 1;
+                nReceivers--;
+            }
+        }
+        pthread_mutex_unlock(&pServer->mLock);
+        RtpPacerConsume(&pStream->mPacer, pPacket->mLen * nSent, nNowUs);
+    }
+
+    pthread_mutex_lock(&pServer->mLock);
+    pStream->mStat.mPaceWaitUs += nWaitUs;
+    pthread_mutex_unlock(&pServer->mLock);
+}
+
+static int StreamSendFrame(RTSP_STREAM_S *pStream, const RTSP_FRAME_S *pFrame)
+{
+    RTSP_SERVER_S *pServer = pStream->mpServer;
+    RTP_NAL_S stNals[RTSP_MAX_NAL_NUM];
+    uint8_t pParamSets[RTSP_PARAM_SET_NUM * (RTSP_PARAM_SET_SIZE + 4)];
+    unsigned int nParamSetsLen = 0;
+    uint32_t nRtpTime = pStream->mRtpTimeBase + (uint32_t)(pFrame->mPts * 9 / 100);
+    int nNalNum, nReceivers = 0;
+    int bHaveParamSets;
+    int i;
+
+    nNalNum = RtpFindNalUnits(&pFrame->mBuf, stNals, RTSP_MAX_NAL_NUM);
+    if(nNalNum < 0)
+    {
+        aloge("fatal error! more than %d nal units in a frame", RTSP_MAX_NAL_NUM);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pServer->mLock);
+    pStream->mStat.mFrames++;
+    pStream->mLastRtpTime = nRtpTime;
+    pStream->mLastFrameUs = CDX_GetSysTimeUsMonotonic();
+    bHaveParamSets = StoreParamSets(pStream, &pFrame->mBuf, stNals, nNalNum) > 0;
+    for(i = 0; i < pServer->mAttr.mMaxClientNum; i++)
+    {
+        RTSP_CLIENT_S *pClient = pServer->mppClients[i];
+        if(NULL == pClient || pClient->mpStream != pStream)
+        {
+            continue;
+        }
+        pClient->mbInFrame = 0;
+        if(!pClient->mbPlaying || pClient->mbClosing)
+        {
+            continue;
+        }
+        if(pClient->mbWaitKeyFrame && pFrame->mbKeyFrame)
+        {
+            pClient->mbWaitKeyFrame = 0;
+            pClient->mbLagging = 0;
+        }
+        if(!pClient->mbWaitKeyFrame)
+        {
+            pClient->mbInFrame = 1;
+            nReceivers++;
+        }
+    }
+    if(0 == nReceivers)
+    {
+        pthread_mutex_unlock(&pServer->mLock);
+        return 0;
+    }
+    if(pFrame->mbKeyFrame && !bHaveParamSets)
+    {
+        //a decoder joining at this key frame needs them
+        for(i = 0; i < RTSP_PARAM_SET_NUM; i++)
+        {
+            if(pStream->mParamSetLen[i] > 0)
+            {
+                PutBe32(pParamSets + nParamSetsLen, 1);
+                memcpy(pParamSets + nParamSetsLen + 4, pStream->mParamSet[i], pStream->mParamSetLen[i]);
+                nParamSetsLen += 4 + pStream->mParamSetLen[i];
+            }
+        }
+    }
+    pthread_mutex_unlock(&pServer->mLock);
+
+    if(nParamSetsLen > 0)
+    {
+        RTP_FRAME_BUF_S stBuf;
+        RTP_NAL_S stSetNals[RTSP_PARAM_SET_NUM];
+        int nSetNum;
+        memset(&stBuf, 0, sizeof(stBuf));
+        stBuf.mpData[0] = pParamSets;
+        stBuf.mLen[0] = nParamSetsLen;
+        nSetNum = RtpFindNalUnits(&stBuf, stSetNals, RTSP_PARAM_SET_NUM);
+        if(nSetNum > 0 && RtpPacketizeNals(&pStream->mPacketizer, &stBuf, stSetNals, nSetNum, nRtpTime, 0) > 0)
+        {
+            pthread_mutex_lock(&pServer->mLock);
+            pStream->mStat.mPackets += pStream->mPacketizer.mPacketNum;
+            pthread_mutex_unlock(&pServer->mLock);
+            SendPackets(pStream, nReceivers);
+        }
+    }
+    if(RtpPacketizeNals(&pStream->mPacketizer, &pFrame->mBuf, stNals, nNalNum, nRtpTime, 1) < 0)
+    {
+        return -1;
+    }
+    pthread_mutex_lock(&pServer->mLock);
+    pStream->mStat.mPacketizedFrames++;
+    pStream->mStat.mPackets += pStream->mPacketizer.mPacketNum;
+    pthread_mutex_unlock(&pServer->mLock);
+    SendPackets(pStream, nReceivers);
+
+    pthread_mutex_lock(&pServer->mLock);
+    pStream->mNextSeq = pStream->mPacketizer.mSeq;
+    pthread_mutex_unlock(&pServer->mLock);
+    return 0;
+}
+
+int RtspStreamSendFrame(RTSP_STREAM_S *pStream, const RTSP_FRAME_S *pFrame)
+{
+    int ret;
+
+    MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_RTSP, pStream->mIndex, pFrame->mPts, -1);
+    ret = StreamSendFrame(pStream, pFrame);
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_RTSP, pStream->mIndex, pFrame->mPts);
+    return ret;
+}
+
+/* bytes waiting in the send queue of a socket, 0 where it can not be known (lwip) */
+static unsigned int SocketSendQueued(int nFd)
+{
+#if defined(__linux__) && defined(TIOCOUTQ)
+    int n = 0;
+    if(ioctl(nFd, TIOCOUTQ, &n) == 0 && n > 0)
+    {
+        return n;
+    }
+#endif
+    return 0;
+}
+
+static unsigned int SocketSendBufSize(int nFd)
+{
+    int n = 0;
+    socklen_t nLen = sizeof(n);
+    if(getsockopt(nFd, SOL_SOCKET, SO_SNDBUF, &n, &nLen) == 0 && n > 0)
+    {
+        return n;
+    }
+    return 0;
+}
+
+/* under mLock */
+static void ClientGetBacklog(RTSP_SERVER_S *pServer, RTSP_CLIENT_S *pClient, unsigned int *pBytes, unsigned int *pCapacity)
+{
+    int nFd = pClient->mbTcp ? pClient->mFd : pServer->mRtpFd;
+
+    *pBytes = SocketSendQueued(nFd);
+    *pCapacity = RTSP_SEND_BUF_SIZE + SocketSendBufSize(nFd);
+    if(pClient->mbTcp)
+    {
+        *pBytes += pClient->mSendLen;
+    }
+    if(pClient->mbLagging || *pBytes > *pCapacity)
+    {
+        *pBytes = *pCapacity;
+    }
+}
+
+int RtspStreamGetStat(RTSP_STREAM_S *pStream, RTSP_STREAM_STAT_S *pStat, RTSP_CLIENT_STAT_S *pClients, int *pClientNum)
+{
+    RTSP_SERVER_S *pServer = pStream->mpServer;
+    int nMax = pClientNum != NULL ? *pClientNum : 0;
+    int nNum = 0;
+    int i;
+
+    pthread_mutex_lock(&pServer->mLock);
+    *pStat = pStream->mStat;
+    pStat->mClientNum = 0;
+    pStat->mBacklogBytes = 0;
+    pStat->mBacklogCapacity = 0;
+    for(i = 0; i < pServer->mAttr.mMaxClientNum; i++)
+    {
+        RTSP_CLIENT_S *pClient = pServer->mppClients[i];
+        if(NULL == pClient || pClient->mpStream != pStream)
+        {
+            continue;
+        }
+        ClientGetBacklog(pServer, pClient, &pClient->mStat.mBacklogBytes, &pClient->mStat.mBacklogCapacity);
+        if(pClient->mbPlaying)
+        {
+            pStat->mClientNum++;
+            //the most backlogged client
+            if((uint64_t)pClient->mStat.mBacklogBytes * (pStat->mBacklogCapacity > 0 ? pStat->mBacklogCapacity : 1)
+                >= (uint64_t)pStat->mBacklogBytes * pClient->mStat.mBacklogCapacity)
+            {
+                pStat->mBacklogBytes = pClient->mStat.mBacklogBytes;
+                pStat->mBacklogCapacity = pClient->mStat.mBacklogCapacity;
+            }
+        }
+        if(pClients != NULL && nNum < nMax)
+        {
+            pClients[nNum++] = pClient->mStat;
+        }
+    }
+    pthread_mutex_unlock(&pServer->mLock);
+    if(pClientNum != NULL)
+    {
+        *pClientNum = nNum;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+/******************************************************************************
+  Copyright (C), 2001-2016, Allwinner Tech. Co., Ltd.
+ ******************************************************************************
+  File Name     : rtsp_server.h
+  Version       : Initial Draft
+  Author        : Allwinner PDC-PD5 Team
+  Created       : 2020/12/07
+  Last Modified :
+  Description   : rtsp server streaming the venc output over rtp
+  Function List :
+  History       :
+******************************************************************************/
+#ifndef _RTSP_SERVER_H_
+#define _RTSP_SERVER_H_
+
+#include <stdint.h>
+
+#include "rtp_packetizer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * One thread of the server answers the rtsp requests and sends the rtcp
+ * sender reports. The frames are sent by the caller of RtspStreamSendFrame():
+ * they are split into rtp packets once, the packets point into the frame and
+ * go to every client of the stream with scatter-gather sends. When it
+ * returns the frame has been sent and the venc stream can be released.
+ * A token bucket can spread the packets of a big frame, so that the key
+ * frames do not overflow the wifi send queue.
+ *
+ * Clients choose rtp over udp or interleaved in the rtsp connection. A
+ * client whose socket is full loses the packets, then waits for the next
+ * key frame.
+ *
+ * The backlog of RtspStreamGetStat() is what EyeseeRecorder::setNetworkSinkState()
+ * takes, to lower the bitrate before packets are lost. A client counts as
+ * full while it waits for a key frame after a loss.
+ */
+
+#define RTSP_SERVER_DEFAULT_PORT    (8554)
+#define RTSP_SERVER_MAX_STREAM_NUM  (8)
+#define RTSP_STREAM_NAME_LEN        (32)
+
+typedef struct RTSP_SERVER_S RTSP_SERVER_S;
+typedef struct RTSP_STREAM_S RTSP_STREAM_S;
+
+typedef struct RTSP_SERVER_ATTR_S
+{
+    char mIp[16];               //address to listen on, "" for all
+    int mPort;                  //0: any free port, see RtspServerGetPort()
+    int mMaxClientNum;          //0: 8
+    int mSessionTimeoutSec;     //0: 60, a udp client silent for it is dropped
+    int mRtcpIntervalMs;        //0: 5000, of the sender reports
+} RTSP_SERVER_ATTR_S;
+
+typedef struct RTSP_STREAM_ATTR_S
+{
+    char mName[RTSP_STREAM_NAME_LEN];   //rtsp://ip:port/name
+    RTP_CODEC_E meCodec;
+    int mMaxPayload;            //0: 1400, rtp payload bytes, at most 8173
+    int mPaceBitRate;           //bps on the wire, all clients together. 0: no pacing
+    int mPaceBurstBytes;        //0: 16KB
+} RTSP_STREAM_ATTR_S;
+
+typedef struct RTSP_FRAME_S
+{
+    RTP_FRAME_BUF_S mBuf;       //annexb access unit, e.g. mpAddr0/mLen0, mpAddr1/mLen1 of VENC_PACK_S
+    int64_t mPts;               //unit:us
+    int mbKeyFrame;
+} RTSP_FRAME_S;
+
+typedef struct RTSP_CLIENT_STAT_S
+{
+    char mAddr[16];
+    int mPort;
+    int mbTcp;                  //rtp interleaved in the rtsp connection
+    int mbPlaying;
+    uint64_t mPackets;          //rtp packets sent
+    uint64_t mBytes;
+    uint64_t mDroppedPackets;   //the socket was full
+    int mReceiverReports;
+    int mFractionLost;          //x/256, of the last receiver report
+    int mCumulativeLost;
+    unsigned int mJitter;       //unit: 1/90000s
+    int mRttMs;                 //-1 if not known
+    unsigned int mBacklogBytes; //the rest of an interleaved packet and the socket send queue (not known with lwip)
+    unsigned int mBacklogCapacity;
+} RTSP_CLIENT_STAT_S;
+
+typedef struct RTSP_STREAM_STAT_S
+{
+    uint64_t mFrames;
+    uint64_t mPacketizedFrames; //once for all the clients, none when nobody plays
+    uint64_t mPackets;          //rtp packets made
+    uint64_t mSentPackets;      //to all the clients
+    uint64_t mSentBytes;
+    uint64_t mDroppedPackets;
+    int64_t mPaceWaitUs;        //the sender waited for the token bucket
+    int mClientNum;             //playing
+    unsigned int mBacklogBytes; //of the playing client with the fullest backlog
+    unsigned int mBacklogCapacity;  //0 when nobody plays
+} RTSP_STREAM_STAT_S;
+
+RTSP_SERVER_S *RtspServerCreate(const RTSP_SERVER_ATTR_S *pAttr);
+void RtspServerDestroy(RTSP_SERVER_S *pServer);
+int RtspServerGetPort(RTSP_SERVER_S *pServer);
+
+/* the streams are destroyed with the server */
+RTSP_STREAM_S *RtspServerCreateStream(RTSP_SERVER_S *pServer, const RTSP_STREAM_ATTR_S *pAttr);
+int RtspStreamGetUrl(RTSP_STREAM_S *pStream, char *pUrl, int nSize);
+
+/*
+ * annexb sps/pps (and vps) for the sdp and to be sent before the key frames
+ * which have none, e.g. VencHeaderData. Those found in the frames are taken too.
+ */
+int RtspStreamSetParameterSets(RTSP_STREAM_S *pStream, const uint8_t *pData, unsigned int nLen);
+
+/* one thread a stream */
+int RtspStreamSendFrame(RTSP_STREAM_S *pStream, const RTSP_FRAME_S *pFrame);
+
+/* *pClientNum: in, the size of pClients; out, the clients of the stream */
+int RtspStreamGetStat(RTSP_STREAM_S *pStream, RTSP_STREAM_STAT_S *pStat, RTSP_CLIENT_STAT_S *pClients, int *pClientNum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _RTSP_SERVER_H_ */
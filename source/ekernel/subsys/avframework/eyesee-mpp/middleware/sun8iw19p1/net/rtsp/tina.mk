@@ -0,0 +1,103 @@
+# Makefile for eyesee-mpp/middleware/net/rtsp
+CUR_PATH := .
+PACKAGE_TOP := ../..
+EYESEE_MPP_INCLUDE:=$(STAGING_DIR)/usr/include/eyesee-mpp
+EYESEE_MPP_LIBDIR:=$(STAGING_DIR)/usr/lib/eyesee-mpp
+# STAGING_DIR is exported in rules.mk, so it can be used directly here.
+# STAGING_DIR:=.../tina-v316/out/v316-perfnor/staging_dir/target
+
+include $(PACKAGE_TOP)/config/mpp_config.mk
+
+#set source files here.
+SRCCS := \
+    rtsp_server.c \
+    rtp_packetizer.c \
+    rtp_pacer.c
+
+#include directories
+INCLUDE_DIRS := \
+    $(CUR_PATH) \
+    $(EYESEE_MPP_INCLUDE)/system/public/include \
+    $(EYESEE_MPP_INCLUDE)/system/public/include/utils \
+    $(PACKAGE_TOP)/include/utils \
+    $(PACKAGE_TOP)/include/media \
+    $(PACKAGE_TOP)/media/include/utils
+
+LOCAL_SHARED_LIBS := \
+    libpthread \
+    liblog \
+    libmedia_utils
+
+LOCAL_STATIC_LIBS :=
+
+#set dst file name: shared library, static library, execute bin.
+LOCAL_TARGET_DYNAMIC := librtsp_server
+LOCAL_TARGET_STATIC := librtsp_server
+LOCAL_TARGET_BIN :=
+
+#generate include directory flags for gcc.
+inc_paths := $(foreach inc,$(filter-out -I%,$(INCLUDE_DIRS)),$(addprefix -I, $(inc))) \
+                $(filter -I%, $(INCLUDE_DIRS))
+#Extra flags to give to the C compiler
+LOCAL_CFLAGS := $(CFLAGS) $(CEDARX_EXT_CFLAGS) $(inc_paths) -fPIC -Wall
+#Extra flags to give to the C++ compiler
+LOCAL_CXXFLAGS := $(CXXFLAGS) $(CEDARX_EXT_CFLAGS) $(inc_paths) -fPIC -Wall
+#Extra flags to give to the C preprocessor and programs that use it (the C and Fortran compilers).
+LOCAL_CPPFLAGS := $(CPPFLAGS)
+#target device arch: x86, arm
+LOCAL_TARGET_ARCH := $(ARCH)
+#Extra flags to give to compilers when they are supposed to invoke the linker,‘ld’.
+LOCAL_LDFLAGS := $(LDFLAGS)
+
+LOCAL_DYNAMIC_LDFLAGS := $(LOCAL_LDFLAGS) -shared \
+    -L $(EYESEE_MPP_LIBDIR) \
+    -L $(PACKAGE_TOP)/media/utils \
+    -Wl,-Bstatic \
+    -Wl,--start-group $(foreach n, $(LOCAL_STATIC_LIBS), -l$(patsubst lib%,%,$(patsubst %.a,%,$(notdir $(n))))) -Wl,--end-group \
+    -Wl,-Bdynamic \
+    $(foreach y, $(LOCAL_SHARED_LIBS), -l$(patsubst lib%,%,$(patsubst %.so,%,$(notdir $(y)))))
+
+#generate object files
+OBJS := $(SRCCS:%=%.o) #OBJS=$(patsubst %,%.o,$(SRCCS))
+
+#add dynamic lib name suffix and static lib name suffix.
+target_dynamic := $(if $(LOCAL_TARGET_DYNAMIC),$(addsuffix .so,$(LOCAL_TARGET_DYNAMIC)),)
+target_static := $(if $(LOCAL_TARGET_STATIC),$(addsuffix .a,$(LOCAL_TARGET_STATIC)),)
+
+#generate exe file.
+.PHONY: all
+all: $(target_dynamic) $(target_static)
+	@echo ===================================
+	@echo build eyesee-mpp-middleware-net-rtsp done
+	@echo ===================================
+
+$(target_dynamic): $(OBJS)
+	$(CXX) $+ $(LOCAL_DYNAMIC_LDFLAGS) -o $@
+	@echo ----------------------------
+	@echo "finish target: $@"
+#	@echo "object files:  $+"
+#	@echo "source files:  $(SRCCS)"
+	@echo ----------------------------
+
+$(target_static): $(OBJS)
+	$(AR) -rcs -o $@ $+
+	@echo ----------------------------
+	@echo "finish target: $@"
+#	@echo "object files:  $+"
+#	@echo "source files:  $(SRCCS)"
+	@echo ----------------------------
+
+#patten rules to generate local object files
+$(filter %.cpp.o %.cc.o, $(OBJS)): %.o: %
+	$(CXX) $(LOCAL_CXXFLAGS) $(LOCAL_CPPFLAGS) -MD -MP -MF $(@:%=%.d) -c $< -o $@
+$(filter %.c.o, $(OBJS)): %.o: %
+	$(CC) $(LOCAL_CFLAGS) $(LOCAL_CPPFLAGS) -MD -MP -MF $(@:%=%.d) -c $< -o $@
+
+# clean all
+.PHONY: clean
+clean:
+	-rm -f $(OBJS) $(OBJS:%=%.d) $(target_dynamic) $(target_static)
+
+#add *.h prerequisites
+-include $(OBJS:%=%.d)
+
@@ -41,8 +41,7 @@
 #include <confparser.h>
 #include "sample_rtsp.h"
 #include "sample_rtsp_config.h"
-#include "MediaStream.h"
-#include "TinyServer.h"
+#include "rtsp_server.h"
 
 //#define MAX_VIPP_DEV_NUM  2
 //#define MAX_VIDEO_NUM         MAX_VIPP_DEV_NUM
@@ -64,14 +63,12 @@ struct vi_venc_param {
     int             venc_chn;
     int             run_flag;
     PAYLOAD_TYPE_E  venc_type;
-    MediaStream    *stream;
+    RTSP_STREAM_S  *stream;
 };
 
-static MediaStream *g_stream_0 = NULL;
+static RTSP_STREAM_S *g_stream_0 = NULL;
 static struct vi_venc_param g_param_0;
 static struct vi_venc_param g_param_1;
-#define MAX_FRAME_BUF_SiZE  1920*1080*3  /* 4K YUV444 */
-static unsigned char g_stream_buf[MAX_FRAME_BUF_SiZE] = {0};
 
 static int enable_network()
 {
@@ -124,14 +121,13 @@ static int get_net_dev_ip(const char *netdev_name, char *ip)
     return 0;
 }
 
-static int CreateRtspServer(TinyServer **rtsp)
+static int CreateRtspServer(RTSP_SERVER_S **rtsp)
 {
     enable_network();
 
     int ret  = 0;
-    int port = 8554;
     char ip[64] = {0};
-    std::string ip_addr;
+    RTSP_SERVER_ATTR_S attr;
 
     ret = get_net_dev_ip("wlan0", ip);
     if (ret)
@@ -141,26 +137,45 @@ static int CreateRtspServer(TinyServer **rtsp)
     }
     aloge("This dev eth0 ip:%s \n", ip);
 
-    ip_addr = ip;
-    *rtsp = TinyServer::createServer(ip_addr, port);
-
-    aloge("============================================================\n");
-    aloge("   rtsp://%s:%d/ch0~n  \n", ip_addr.c_str(), port);
-    aloge("============================================================\n");
+    memset(&attr, 0, sizeof(attr));
+    strncpy(attr.mIp, ip, sizeof(attr.mIp) - 1);
+    attr.mPort = RTSP_SERVER_DEFAULT_PORT;
+    *rtsp = RtspServerCreate(&attr);
+    if (NULL == *rtsp)
+    {
+        aloge("Do RtspServerCreate fail!\n");
+        return -1;
+    }
 
     return 0;
 }
 
-static int rtsp_start(TinyServer *rtsp)
+static int rtsp_start(RTSP_SERVER_S *rtsp, PAYLOAD_TYPE_E type, int bitRate, VencHeaderData *pHeader)
 {
-    MediaStream::MediaStreamAttr attr;
-    attr.videoType  = MediaStream::MediaStreamAttr::VIDEO_TYPE_H264;
-    attr.audioType  = MediaStream::MediaStreamAttr::AUDIO_TYPE_AAC;
-    attr.streamType = MediaStream::MediaStreamAttr::STREAM_TYPE_UNICAST;
+    RTSP_STREAM_ATTR_S attr;
+    char url[128];
+
+    memset(&attr, 0, sizeof(attr));
+    strcpy(attr.mName, "ch0");
+    attr.meCodec = PT_H265 == type ? RTP_CODEC_H265 : RTP_CODEC_H264;
+    /* spread the key frames over the wifi, at twice the average rate */
+    attr.mPaceBitRate = bitRate * 2;
+
+    g_stream_0 = RtspServerCreateStream(rtsp, &attr);
+    if (NULL == g_stream_0)
+    {
+        aloge("Do RtspServerCreateStream fail!\n");
+        return -1;
+    }
+    if (pHeader->nLength > 0)
+    {
+        RtspStreamSetParameterSets(g_stream_0, (const uint8_t*)pHeader->pBuffer, pHeader->nLength);
+    }
+    RtspStreamGetUrl(g_stream_0, url, sizeof(url));
 
-    g_stream_0 = rtsp->createMediaStream("ch0", attr);
-    std::string url_ = g_stream_0->streamURL();
-    rtsp->runWithNewThread();
+    aloge("============================================================\n");
+    aloge("   %s  \n", url);
+    aloge("============================================================\n");
 
     return 0;
 }
@@ -370,75 +385,29 @@ static void *GetEncoderFrameThread(void *pArg)
         }
         else
         {
-            if (VencFrame.mpPack != NULL && VencFrame.mpPack->mLen0 > 0)
+            if (VencFrame.mpPack != NULL && VencFrame.mpPack->mLen0 > 0 && g_stream_0 != NULL)
             {
-                uint64_t pts = VencFrame.mpPack->mPTS;
-                int frame_type, len;
-                VencHeaderData head_info;
-                unsigned char *buf = NULL;
-                if (H264E_NALU_ISLICE == VencFrame.mpPack->mDataType.enH264EType)
+                RTSP_FRAME_S stFrame;
+                /* sent from the venc buffer, it is released after */
+                stFrame.mBuf.mpData[0] = VencFrame.mpPack->mpAddr0;
+                stFrame.mBuf.mLen[0] = VencFrame.mpPack->mLen0;
+                stFrame.mBuf.mpData[1] = VencFrame.mpPack->mpAddr1;
+                stFrame.mBuf.mLen[1] = VencFrame.mpPack->mLen1;
+                stFrame.mPts = VencFrame.mpPack->mPTS;
+                if (PT_H265 == pCap->EncoderType)
                 {
-                    /* Get sps/pps first */
-                    ret = AW_MPI_VENC_GetH264SpsPpsInfo(nVencChn, &head_info);
-                    if (SUCCESS != ret) {
-                        aloge("Do AW_MPI_VENC_GetH264SpsPpsInfo fail! ret:%d \n", ret);
-                    }
-                
-                    frame_type = 1;
-                }
-                else if (H264E_NALU_PSLICE == VencFrame.mpPack->mDataType.enH264EType)
-                {
-                    frame_type = 0;
-                }
-
-                if (MAX_FRAME_BUF_SiZE > VencFrame.mpPack->mLen0)
-                {
-                    memcpy(g_stream_buf, VencFrame.mpPack->mpAddr0, VencFrame.mpPack->mLen0);
-                    buf = g_stream_buf;
-                    len = VencFrame.mpPack->mLen0;
+                    stFrame.mbKeyFrame = H265E_NALU_ISLICE == VencFrame.mpPack->mDataType.enH265EType;
                 }
                 else
                 {
-                    AW_MPI_VENC_ReleaseStream(nVencChn, &VencFrame);
-                    aloge("Output frame stream is too big > MAX_FRAME_BUF_SiZE! mLen0:%d\n", VencFrame.mpPack->mLen0);
-                    continue;
-                }
-
-                if (VencFrame.mpPack->mLen1 > 0)
-                {
-                    if (MAX_FRAME_BUF_SiZE > (VencFrame.mpPack->mLen0 + VencFrame.mpPack->mLen1))
-                    {
-                        memcpy(g_stream_buf + VencFrame.mpPack->mLen0, VencFrame.mpPack->mpAddr1, VencFrame.mpPack->mLen1);
-                        buf = g_stream_buf;
-                        len += VencFrame.mpPack->mLen1;
-                    }
-                    else
-                    {
-                        AW_MPI_VENC_ReleaseStream(nVencChn, &VencFrame);
-                        aloge("Output frame stream is too big > MAX_FRAME_BUF_SiZE:%d! mLen0:%d  mLen1:%d\n",
-                                                     MAX_FRAME_BUF_SiZE, VencFrame.mpPack->mLen0, VencFrame.mpPack->mLen0);
-                        continue;
-                    }
-                }
-                ret = AW_MPI_VENC_ReleaseStream(nVencChn, &VencFrame);
-                if(ret < 0)
-                {
-                    alogd("falied error,release failed!!!\n");
-                }
-
-                if(g_stream_0 != NULL)
-                {
-                    if (1 == frame_type)
-                    {
-                        /* Get I frame */
-                        g_stream_0->appendVideoData(head_info.pBuffer, head_info.nLength, pts, MediaStream::FRAME_DATA_TYPE_HEADER);
-                        g_stream_0->appendVideoData(buf, len, pts, MediaStream::FRAME_DATA_TYPE_I);
-                    }
-                    else
-                    {
-                        g_stream_0->appendVideoData(buf, len, pts, MediaStream::FRAME_DATA_TYPE_P);
-                    }
+                    stFrame.mbKeyFrame = H264E_NALU_ISLICE == VencFrame.mpPack->mDataType.enH264EType;
                 }
+                RtspStreamSendFrame(g_stream_0, &stFrame);
+            }
+            ret = AW_MPI_VENC_ReleaseStream(nVencChn, &VencFrame);
+            if(ret < 0)
+            {
+                alogd("falied error,release failed!!!\n");
             }
 #if 0
             if(VencFrame.mpPack != NULL && VencFrame.mpPack->mLen0)
@@ -603,7 +572,7 @@ int main(int argc, char *argv[])
             goto _exit;
         }
 #endif
-        TinyServer *rtsp;
+        RTSP_SERVER_S *rtsp;
         ret = CreateRtspServer(&rtsp);
         if (ret)
         {
@@ -651,6 +620,7 @@ int main(int argc, char *argv[])
                 pContext->privCap[pContext->mViDev][virvi_chn].mVencChn = pContext->mVeChn;
                 AW_MPI_VENC_SetFrameRate(pContext->mVeChn, &pContext->mVencFrameRateConfig);
                 VencHeaderData vencheader;
+                memset(&vencheader, 0, sizeof(vencheader));
                 //open output file
                 pContext->mOutputFileFp = fopen(pContext->mConfigPara.OutputFilePath, "wb+");
                 if(!pContext->mOutputFileFp)
@@ -675,13 +645,13 @@ int main(int argc, char *argv[])
                         fwrite(vencheader.pBuffer,vencheader.nLength, 1, pContext->mOutputFileFp);
                     }
                 }
+                rtsp_start(rtsp, pContext->mVEncChnAttr.VeAttr.Type, pContext->mConfigPara.DestBitRate, &vencheader);
                 result = pthread_create(&pContext->privCap[pContext->mViDev][virvi_chn].thid, NULL, GetEncoderFrameThread, (void *)&pContext->privCap[pContext->mViDev][virvi_chn]);
                 if (result < 0)
                 {
                     alogd("pthread_create failed, Dev[%d], Chn[%d].\n", pContext->privCap[pContext->mViDev][virvi_chn].Dev, pContext->privCap[pContext->mViDev][virvi_chn].Chn);
                     continue;
                 }
-                rtsp_start(rtsp);
             }
         }
         for (virvi_chn = 0; virvi_chn < 1; virvi_chn++)
@@ -739,6 +709,9 @@ int main(int argc, char *argv[])
         AW_MPI_ISP_Stop(pContext->mIspDev);
         AW_MPI_ISP_Exit();
 
+        RtspServerDestroy(rtsp);
+        g_stream_0 = NULL;
+
         hal_vipp_end(pContext->mViDev);
         /* exit mpp systerm */
         ret = AW_MPI_SYS_Exit();
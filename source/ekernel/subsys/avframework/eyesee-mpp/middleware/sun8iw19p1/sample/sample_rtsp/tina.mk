@@ -31,7 +31,8 @@ INCLUDE_DIRS := \
     $(PACKAGE_TOP)/media/LIBRARY/include_FsWriter \
     $(PACKAGE_TOP)/media/LIBRARY/libcedarc/include \
     $(PACKAGE_TOP)/media/LIBRARY/libcedarx/libcore/common/iniparser \
-    $(PACKAGE_TOP)/sample/configfileparser
+    $(PACKAGE_TOP)/sample/configfileparser \
+    $(PACKAGE_TOP)/net/rtsp
 
 ifeq ($(MPPCFG_COMPILE_DYNAMIC_LIB), Y)
 LOCAL_SHARED_LIBS := \
@@ -45,7 +46,7 @@ LOCAL_SHARED_LIBS := \
     libmedia_mpp \
     libmpp_component \
     libsample_confparser \
-    libTinyServer
+    librtsp_server
 
 ifeq ($(MPPCFG_VI),Y)
 LOCAL_SHARED_LIBS += \
@@ -115,7 +116,7 @@ LOCAL_STATIC_LIBS := \
     libisp_rolloff \
     libcedarxstream \
     libion \
-	libTinyServer
+    librtsp_server
 
 ifeq ($(MPPCFG_VO),Y)
 LOCAL_STATIC_LIBS += \
@@ -197,6 +198,7 @@ LOCAL_LDFLAGS := $(LDFLAGS)
 LIB_SEARCH_PATHS := \
     $(EYESEE_MPP_LIBDIR) \
     $(PACKAGE_TOP)/sample/configfileparser \
+    $(PACKAGE_TOP)/net/rtsp \
     $(PACKAGE_TOP)/media/utils \
     $(PACKAGE_TOP)/media \
     $(PACKAGE_TOP)/media/component \
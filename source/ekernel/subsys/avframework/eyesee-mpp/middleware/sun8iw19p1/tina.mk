@@ -103,6 +103,9 @@ endif
 #	make -C media/isp_tool                              all
 	make -C media -f tina_mpp_static.mk                 all
 	make -C sample/configfileparser -f tina.mk                    all
+ifeq ($(MPPCFG_RTSP_SERVER),Y)
+	make -C net/rtsp -f tina.mk                                   all
+endif
 #	make -C sample/sample_adec -f tina.mk               all
 #	make -C sample/sample_aenc -f tina.mk               all
 #	make -C sample/sample_ai -f tina.mk                 all
@@ -211,6 +214,9 @@ clean:
 #	make -C media/isp_tool                              clean
 	make -C media -f tina_mpp_static.mk                 clean
 	make -C sample/configfileparser -f tina.mk                    clean
+ifeq ($(MPPCFG_RTSP_SERVER),Y)
+	make -C net/rtsp -f tina.mk                                   clean
+endif
 #	make -C sample/sample_adec -f tina.mk               clean
 #	make -C sample/sample_aenc -f tina.mk               clean
 #	make -C sample/sample_ai -f tina.mk                 clean
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-03-22     Bernard      first version
+ * 2026-10-19     melis        one section per command, sorted at link time.
  */
 #ifndef FINSH_API_H__
 #define FINSH_API_H__
@@ -29,10 +30,17 @@ struct finsh_syscall
     syscall_func func;      /* the function address of system call */
 };
 extern struct finsh_syscall *_syscall_table_begin, *_syscall_table_end;
+/* the table is ordered by name, finsh_syscall_bound/find may be used */
+extern rt_bool_t _syscall_table_sorted;
 
 /* find out system call, which should be implemented in user program */
 struct finsh_syscall* finsh_syscall_lookup(const char* name);
 
+/* binary search of the sorted table, see finsh_symtab.c */
+void finsh_syscall_index_init(void);
+struct finsh_syscall *finsh_syscall_bound(const char *prefix, const char *key, int size);
+struct finsh_syscall *finsh_syscall_find(const char *prefix, const char *key, int size);
+
 #ifdef FINSH_USING_SYMTAB
 
 #ifdef __TI_COMPILER_VERSION__
@@ -91,10 +99,14 @@ struct finsh_syscall* finsh_syscall_lookup(const char* name);
                 };
 
         #else
+            /*
+             * one "FSymTab.<cmd>" section per command, the kernel link script
+             * sorts them by name so msh can binary search the table.
+             */
             #define FINSH_FUNCTION_EXPORT_CMD(name, cmd, desc)                      \
                 const char __fsym_##cmd##_name[] SECTION(".rodata.name") = #cmd;    \
                 const char __fsym_##cmd##_desc[] SECTION(".rodata.name") = #desc;   \
-                RT_USED const struct finsh_syscall __fsym_##cmd SECTION("FSymTab")= \
+                RT_USED const struct finsh_syscall __fsym_##cmd SECTION("FSymTab." #cmd)= \
                 {                           \
                     __fsym_##cmd##_name,    \
                     __fsym_##cmd##_desc,    \
@@ -157,7 +169,7 @@ struct finsh_syscall* finsh_syscall_lookup(const char* name);
         #else
             #define FINSH_FUNCTION_EXPORT_CMD(name, cmd, desc)                      \
                 const char __fsym_##cmd##_name[] = #cmd;                            \
-                RT_USED const struct finsh_syscall __fsym_##cmd SECTION("FSymTab")= \
+                RT_USED const struct finsh_syscall __fsym_##cmd SECTION("FSymTab." #cmd)= \
                 {                                                                   \
                     __fsym_##cmd##_name,                                            \
                     (syscall_func)&name                                             \
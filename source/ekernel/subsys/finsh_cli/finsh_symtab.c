@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-19     melis        first version, binary search over the
+ *                             link-time sorted FSymTab.
+ */
+
+/*
+ * Name index of the shell command table.
+ *
+ * FINSH_FUNCTION_EXPORT_CMD() puts every entry in its own "FSymTab.<cmd>"
+ * section and kernel.lds collects them with SORT_BY_NAME, so with GNU ld
+ * the table comes out ordered by name: msh dispatch, finsh lookups and tab
+ * completion binary search it instead of comparing every command. Tables
+ * that are not sorted (armcc, IAR) or not a plain array (MSVC and x86_64
+ * pad the entries) are detected at init and keep the linear scans.
+ */
+
+#include <rtthread.h>
+#include <string.h>
+
+#include "finsh.h"
+
+rt_bool_t _syscall_table_sorted = RT_FALSE;
+
+void finsh_syscall_index_init(void)
+{
+    struct finsh_syscall *index;
+
+    _syscall_table_sorted = RT_FALSE;
+    for (index = _syscall_table_begin; index < _syscall_table_end; index ++)
+    {
+        /* padding between the entries, only finsh_syscall_next() walks it */
+        if (index->name == RT_NULL)
+        {
+            return;
+        }
+
+        if (index + 1 < _syscall_table_end && (index + 1)->name != RT_NULL &&
+                strcmp(index->name, (index + 1)->name) >= 0)
+        {
+            rt_kprintf("finsh: command table not sorted at %s, linear lookup\n",
+                       (index + 1)->name);
+            return;
+        }
+    }
+
+    _syscall_table_sorted = RT_TRUE;
+}
+
+/* compare name with prefix followed by the first size bytes of key */
+static int finsh_syscall_keycmp(const char *name, const char *prefix,
+                                const char *key, int size)
+{
+    const unsigned char *n = (const unsigned char *)name;
+    const unsigned char *p = (const unsigned char *)prefix;
+    const unsigned char *k = (const unsigned char *)key;
+
+    for (; *p; n ++, p ++)
+    {
+        if (*n != *p)
+        {
+            return *n - *p;
+        }
+    }
+
+    for (; size > 0; n ++, k ++, size --)
+    {
+        if (*n != *k)
+        {
+            return *n - *k;
+        }
+    }
+
+    return *n;
+}
+
+/*
+ * First entry of the sorted table not below prefix + key[0..size), the end
+ * of the table if there is none. The entries starting with that string
+ * follow it as one run.
+ */
+struct finsh_syscall *finsh_syscall_bound(const char *prefix, const char *key, int size)
+{
+    struct finsh_syscall *low = _syscall_table_begin;
+    struct finsh_syscall *high = _syscall_table_end;
+    struct finsh_syscall *mid;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (finsh_syscall_keycmp(mid->name, prefix, key, size) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/* the entry named exactly prefix + key[0..size) in the sorted table */
+struct finsh_syscall *finsh_syscall_find(const char *prefix, const char *key, int size)
+{
+    struct finsh_syscall *index;
+
+    index = finsh_syscall_bound(prefix, key, size);
+    if (index < _syscall_table_end &&
+            finsh_syscall_keycmp(index->name, prefix, key, size) == 0)
+    {
+        return index;
+    }
+
+    return RT_NULL;
+}
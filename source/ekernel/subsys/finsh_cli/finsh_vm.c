@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-03-22     Bernard      first version
+ * 2026-10-19     melis        finsh_syscall_lookup() on the sorted table.
  */
 #include <finsh.h>
 
@@ -83,11 +84,20 @@ struct finsh_syscall* finsh_syscall_lookup(const char* name)
     struct finsh_syscall* index;
     struct finsh_syscall_item* item;
 
-    for (index = _syscall_table_begin; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
+    if (_syscall_table_sorted)
     {
-        if (strcmp(index->name, name) == 0)
+        index = finsh_syscall_find("", name, strlen(name));
+        if (index != NULL)
             return index;
     }
+    else
+    {
+        for (index = _syscall_table_begin; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
+        {
+            if (strcmp(index->name, name) == 0)
+                return index;
+        }
+    }
 
     /* find on syscall list */
     item = global_syscall_list;
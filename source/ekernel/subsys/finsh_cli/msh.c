@@ -8,6 +8,7 @@
  * 2013-03-30     Bernard      the first verion for finsh
  * 2014-01-03     Bernard      msh can execute module.
  * 2017-07-19     Aubr.Cool    limit argc to RT_FINSH_ARG_MAX
+ * 2026-10-19     melis        binary search for commands and completion.
  */
 #include <rtthread.h>
 
@@ -211,6 +212,23 @@ cmd_function_t msh_get_cmd(char *cmd, int size)
 {
     struct finsh_syscall *index;
     cmd_function_t cmd_func = RT_NULL;
+
+    if (_syscall_table_sorted)
+    {
+        index = finsh_syscall_find("__cmd_", cmd, size);
+        if (index == RT_NULL)
+        {
+            /* finsh functions, by their plain name only */
+            index = finsh_syscall_find("", cmd, size);
+            if (index != RT_NULL && strncmp(index->name, "__cmd_", 6) == 0)
+            {
+                index = RT_NULL;
+            }
+        }
+
+        return index ? (cmd_function_t)index->func : RT_NULL;
+    }
+
     for (index = _syscall_table_begin;
             index < _syscall_table_end;
             FINSH_NEXT_SYSCALL(index))
@@ -634,13 +652,28 @@ void msh_auto_complete(char *prefix)
 
     /* checks in internal command */
     {
-        for (index = _syscall_table_begin; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
+        index = _syscall_table_begin;
+        if (_syscall_table_sorted)
+        {
+            /* the matches are one run of the sorted table, starting here */
+            index = finsh_syscall_bound("__cmd_", prefix, strlen(prefix));
+        }
+
+        for (; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
         {
             /* skip finsh shell function */
-            if (strncmp(index->name, "__cmd_", 6) != 0) continue;
+            if (strncmp(index->name, "__cmd_", 6) != 0)
+            {
+                if (_syscall_table_sorted) break;
+                continue;
+            }
 
             cmd_name = (const char *) &index->name[6];
-            if (strncmp(prefix, cmd_name, strlen(prefix)) == 0)
+            if (strncmp(prefix, cmd_name, strlen(prefix)) != 0)
+            {
+                if (_syscall_table_sorted) break;
+            }
+            else
             {
                 if (min_length == 0)
                 {
@@ -16,6 +16,7 @@
  *                             initialization when use GNU GCC compiler.
  * 2016-11-26     armink       add password authentication
  * 2018-07-02     aozima       add custome prompt support.
+ * 2026-10-19     melis        index the command table at init.
  */
 
 #include <rthw.h>
@@ -797,6 +798,7 @@ void finsh_system_function_init(const void *begin, const void *end)
 {
     _syscall_table_begin = (struct finsh_syscall *) begin;
     _syscall_table_end = (struct finsh_syscall *) end;
+    finsh_syscall_index_init();
 }
 
 void finsh_system_var_init(const void *begin, const void *end)
@@ -0,0 +1,401 @@
+/*
+ * lib/checksum.c
+ *
+ * Table driven CRC32/CRC32C/CRC16/Adler32 shared by the filesystems,
+ * archival, adbd and ota code.
+ *
+ * CRC32 and CRC32C use the "slicing-by-N" algorithm (N = 8, or 16 with
+ * CONFIG_CHECKSUM_SLICE_BY_16): N bytes are folded into the register per
+ * iteration with N independent table lookups, instead of one dependent
+ * lookup per byte. When the compiler targets a core with the ARMv8 CRC32
+ * extension (__ARM_FEATURE_CRC32) the crc32/crc32c instructions are used
+ * instead and the tables are never built.
+ *
+ * The tables are generated on first use; generation is idempotent so a
+ * race between two first callers only costs time, never correctness.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation. See README and COPYING for
+ * more details.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <libs/checksum.h>
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32_USE_HW    1
+#else
+#define CRC32_USE_HW    0
+#endif
+
+#ifdef CONFIG_CHECKSUM_SLICE_BY_16
+#define CRC_SLICES      16
+#else
+#define CRC_SLICES      8
+#endif
+
+#define CRC32_POLY_LE   0xedb88320
+#define CRC32_POLY_BE   0x04c11db7
+#define CRC32C_POLY_LE  0x82f63b78
+#define CRC16_POLY_LE   0xa001
+#define CRC_ITU_T_POLY  0x1021
+
+#define ADLER_BASE      65521U  /* largest prime smaller than 65536 */
+#define ADLER_NMAX      5552    /* largest n with 255n(n+1)/2 + (n+1)(BASE-1) < 2^32 */
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define CRC_SLICE_OK    0
+#else
+#define CRC_SLICE_OK    1
+#endif
+
+static inline uint32_t load_le32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void checksum_barrier(void)
+{
+    __sync_synchronize();
+}
+
+/* ------------------------------------------------------------------------- */
+/* reflected CRC32 family                                                     */
+/* ------------------------------------------------------------------------- */
+
+#if !CRC32_USE_HW
+static uint32_t crc32_le_table[CRC_SLICES][256];
+static uint32_t crc32c_le_table[CRC_SLICES][256];
+static volatile int crc32_le_ready;
+static volatile int crc32c_le_ready;
+
+/*
+ * table[0] is the classic byte table, table[k][i] is the CRC of byte i
+ * followed by k zero bytes, which lets a whole word be folded at once.
+ */
+static void crc32_slice_init(uint32_t (*table)[256], uint32_t poly)
+{
+    uint32_t c;
+    int i, j;
+
+    for (i = 0; i < 256; i++)
+    {
+        c = i;
+        for (j = 0; j < 8; j++)
+        {
+            c = (c & 1) ? ((c >> 1) ^ poly) : (c >> 1);
+        }
+        table[0][i] = c;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        c = table[0][i];
+        for (j = 1; j < CRC_SLICES; j++)
+        {
+            c = table[0][c & 0xff] ^ (c >> 8);
+            table[j][i] = c;
+        }
+    }
+}
+
+#define CRC_WORD(t, w, k)                          \
+    ((t)[(k) + 3][(w) & 0xff] ^                     \
+     (t)[(k) + 2][((w) >> 8) & 0xff] ^              \
+     (t)[(k) + 1][((w) >> 16) & 0xff] ^             \
+     (t)[(k)][(w) >> 24])
+
+static uint32_t crc32_slice(uint32_t (*t)[256], uint32_t crc,
+                            const uint8_t *p, size_t len)
+{
+    /* walk up to a word boundary so the word loads below are aligned */
+    while (len && ((uintptr_t)p & 3))
+    {
+        crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+        len--;
+    }
+
+#if CRC_SLICE_OK
+    while (len >= CRC_SLICES)
+    {
+        uint32_t w0 = load_le32(p) ^ crc;
+        uint32_t w1 = load_le32(p + 4);
+#if CRC_SLICES == 16
+        uint32_t w2 = load_le32(p + 8);
+        uint32_t w3 = load_le32(p + 12);
+
+        crc = CRC_WORD(t, w0, 12) ^ CRC_WORD(t, w1, 8) ^
+              CRC_WORD(t, w2, 4) ^ CRC_WORD(t, w3, 0);
+#else
+        crc = CRC_WORD(t, w0, 4) ^ CRC_WORD(t, w1, 0);
+#endif
+        p += CRC_SLICES;
+        len -= CRC_SLICES;
+    }
+#endif
+
+    while (len--)
+    {
+        crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+#endif /* !CRC32_USE_HW */
+
+uint32_t crc32_le(uint32_t crc, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+
+#if CRC32_USE_HW
+    while (len && ((uintptr_t)p & 3))
+    {
+        crc = __crc32b(crc, *p++);
+        len--;
+    }
+    while (len >= 4)
+    {
+        crc = __crc32w(crc, load_le32(p));
+        p += 4;
+        len -= 4;
+    }
+    while (len--)
+    {
+        crc = __crc32b(crc, *p++);
+    }
+    return crc;
+#else
+    if (!crc32_le_ready)
+    {
+        crc32_slice_init(crc32_le_table, CRC32_POLY_LE);
+        checksum_barrier();
+        crc32_le_ready = 1;
+    }
+    return crc32_slice(crc32_le_table, crc, p, len);
+#endif
+}
+
+uint32_t crc32c_le(uint32_t crc, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+
+#if CRC32_USE_HW
+    while (len && ((uintptr_t)p & 3))
+    {
+        crc = __crc32cb(crc, *p++);
+        len--;
+    }
+    while (len >= 4)
+    {
+        crc = __crc32cw(crc, load_le32(p));
+        p += 4;
+        len -= 4;
+    }
+    while (len--)
+    {
+        crc = __crc32cb(crc, *p++);
+    }
+    return crc;
+#else
+    if (!crc32c_le_ready)
+    {
+        crc32_slice_init(crc32c_le_table, CRC32C_POLY_LE);
+        checksum_barrier();
+        crc32c_le_ready = 1;
+    }
+    return crc32_slice(crc32c_le_table, crc, p, len);
+#endif
+}
+
+const char *crc32_impl_name(void)
+{
+#if CRC32_USE_HW
+    return "armv8-crc";
+#elif CRC_SLICES == 16
+    return "slice-by-16";
+#else
+    return "slice-by-8";
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+/* byte table CRCs                                                           */
+/* ------------------------------------------------------------------------- */
+
+static uint32_t crc32_be_table[256];
+static uint16_t crc16_table[256];
+static uint16_t crc_itu_t_table[256];
+static volatile int crc32_be_ready;
+static volatile int crc16_ready;
+static volatile int crc_itu_t_ready;
+
+uint32_t crc32_be(uint32_t crc, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    uint32_t c;
+    int i, j;
+
+    if (!crc32_be_ready)
+    {
+        for (i = 0; i < 256; i++)
+        {
+            c = (uint32_t)i << 24;
+            for (j = 0; j < 8; j++)
+            {
+                c = (c & 0x80000000) ? ((c << 1) ^ CRC32_POLY_BE) : (c << 1);
+            }
+            crc32_be_table[i] = c;
+        }
+        checksum_barrier();
+        crc32_be_ready = 1;
+    }
+
+    while (len--)
+    {
+        crc = (crc << 8) ^ crc32_be_table[(crc >> 24) ^ *p++];
+    }
+    return crc;
+}
+
+uint16_t melis_crc16(uint16_t crc, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    uint16_t c;
+    int i, j;
+
+    if (!crc16_ready)
+    {
+        for (i = 0; i < 256; i++)
+        {
+            c = i;
+            for (j = 0; j < 8; j++)
+            {
+                c = (c & 1) ? ((c >> 1) ^ CRC16_POLY_LE) : (c >> 1);
+            }
+            crc16_table[i] = c;
+        }
+        checksum_barrier();
+        crc16_ready = 1;
+    }
+
+    while (len--)
+    {
+        crc = (crc >> 8) ^ crc16_table[(crc ^ *p++) & 0xff];
+    }
+    return crc;
+}
+
+uint16_t crc_itu_t(uint16_t crc, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    uint16_t c;
+    int i, j;
+
+    if (!crc_itu_t_ready)
+    {
+        for (i = 0; i < 256; i++)
+        {
+            c = (uint16_t)(i << 8);
+            for (j = 0; j < 8; j++)
+            {
+                c = (c & 0x8000) ? (uint16_t)((c << 1) ^ CRC_ITU_T_POLY) : (uint16_t)(c << 1);
+            }
+            crc_itu_t_table[i] = c;
+        }
+        checksum_barrier();
+        crc_itu_t_ready = 1;
+    }
+
+    while (len--)
+    {
+        crc = (uint16_t)(crc << 8) ^ crc_itu_t_table[((crc >> 8) ^ *p++) & 0xff];
+    }
+    return crc;
+}
+
+/* ------------------------------------------------------------------------- */
+/* sums                                                                      */
+/* ------------------------------------------------------------------------- */
+
+#define ADLER_DO1(p, i)     { a += (p)[i]; b += a; }
+#define ADLER_DO2(p, i)     ADLER_DO1(p, i) ADLER_DO1(p, i + 1)
+#define ADLER_DO4(p, i)     ADLER_DO2(p, i) ADLER_DO2(p, i + 2)
+#define ADLER_DO8(p, i)     ADLER_DO4(p, i) ADLER_DO4(p, i + 4)
+#define ADLER_DO16(p)       ADLER_DO8(p, 0) ADLER_DO8(p, 8)
+
+uint32_t melis_adler32(uint32_t adler, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    size_t n;
+
+    while (len > 0)
+    {
+        /* defer the modulo as long as b cannot overflow */
+        n = len < ADLER_NMAX ? len : ADLER_NMAX;
+        len -= n;
+        while (n >= 16)
+        {
+            ADLER_DO16(p);
+            p += 16;
+            n -= 16;
+        }
+        while (n--)
+        {
+            a += *p++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return (b << 16) | a;
+}
+
+uint32_t csum_bytes(uint32_t sum, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    uint32_t acc, w;
+    size_t n;
+
+    while (len && ((uintptr_t)p & 3))
+    {
+        sum += *p++;
+        len--;
+    }
+
+    /*
+     * Sum two byte lanes per 16bit half of a word. Each word adds at most
+     * 2 * 255 to a half, so flushing every 128 words keeps the halves from
+     * carrying into each other.
+     */
+    while (len >= 4)
+    {
+        acc = 0;
+        n = len / 4;
+        if (n > 128)
+        {
+            n = 128;
+        }
+        len -= n * 4;
+        while (n--)
+        {
+            w = load_le32(p);
+            acc += (w & 0x00ff00ff) + ((w >> 8) & 0x00ff00ff);
+            p += 4;
+        }
+        sum += (acc & 0xffff) + (acc >> 16);
+    }
+
+    while (len--)
+    {
+        sum += *p++;
+    }
+    return sum;
+}
@@ -62,6 +62,11 @@
 // Regular implementation
 //
 
+#if defined(MBEDTLS_AES_ALT_QUEUE)
+#include <rtthread.h>
+#include <drv/sunxi_drv_crypto.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -187,6 +192,32 @@ int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
                     unsigned char iv[16],
                     const unsigned char *input,
                     unsigned char *output );
+
+#if defined(MBEDTLS_AES_ALT_QUEUE)
+/**
+ * \brief  This function prepares an AES-CBC operation as a CE queue job
+ *         instead of running it.
+ *
+ *         The parameters are those of mbedtls_aes_crypt_cbc(). The caller
+ *         sets \c job->done and \c job->priv and hands the job to
+ *         crypto_aes_job_submit(), so many records can be queued and run
+ *         as batches. \p ctx, \p iv and the buffers must stay valid until
+ *         the done callback, which also updates \p iv. The buffers must
+ *         be ADDR_ALIGN_SIZE aligned.
+ *
+ * \param job     The job to fill in.
+ *
+ * \return         \c 0 on success, or #MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH
+ *                 on failure.
+ */
+int mbedtls_aes_job_setup( mbedtls_aes_context *ctx,
+                    int mode,
+                    size_t length,
+                    unsigned char iv[16],
+                    const unsigned char *input,
+                    unsigned char *output,
+                    crypto_aes_job_t *job );
+#endif /* MBEDTLS_AES_ALT_QUEUE */
 #endif /* MBEDTLS_CIPHER_MODE_CBC */
 
 #if defined(MBEDTLS_CIPHER_MODE_CFB)
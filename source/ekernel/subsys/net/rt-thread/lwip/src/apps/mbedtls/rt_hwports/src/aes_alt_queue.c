@@ -0,0 +1,429 @@
+/*
+ *  AES alt backend on top of the CE job queue
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+/*
+ *  Single blocks (ECB, and through it CFB/CTR/GCM) and short or unaligned
+ *  CBC buffers are done with the software cipher of the CE driver, a CE
+ *  round trip costs more than they do. Everything else becomes a job on
+ *  the CE queue, and mbedtls_aes_job_setup() lets callers with many
+ *  records queue them all and wait once.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_AES_C)
+
+#include <string.h>
+#include <rtthread.h>
+
+#include <log.h>
+
+#include <aes_alt.h>
+
+#if defined(MBEDTLS_AES_ALT) && defined(MBEDTLS_AES_ALT_QUEUE)
+
+/* below this a CBC buffer is cheaper in software */
+#define AES_QUEUE_MIN_LENGTH    64
+
+struct aes_queue_ctx
+{
+    rt_uint8_t key[32];
+    rt_uint32_t key_length;
+    crypto_aes_soft_ctx_t soft;
+};
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx)
+{
+    if (ctx)
+    {
+        *ctx = rt_malloc(sizeof(struct aes_queue_ctx));
+        if (*ctx)
+        {
+            memset(*ctx, 0, sizeof(struct aes_queue_ctx));
+        }
+        else
+        {
+            pr_err("aes init. malloc fail");
+        }
+    }
+    else
+    {
+        pr_err("aes init. but ctx is null");
+    }
+}
+
+void mbedtls_aes_free(mbedtls_aes_context *ctx)
+{
+    if (ctx && *ctx)
+    {
+        memset(*ctx, 0, sizeof(struct aes_queue_ctx));
+        rt_free(*ctx);
+        *ctx = NULL;
+    }
+}
+
+static int aes_queue_setkey(mbedtls_aes_context *ctx, const unsigned char *key,
+                            unsigned int keybits, rt_uint32_t dir)
+{
+    struct aes_queue_ctx *aes_ctx;
+
+    switch( keybits )
+    {
+        case 128: break;
+        case 192: break;
+        case 256: break;
+        default : return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+    }
+
+    if (ctx == NULL || *ctx == NULL)
+    {
+        pr_err("aes setkey. but ctx is null");
+        return( MBEDTLS_ERR_AES_HW_ACCEL_FAILED );
+    }
+
+    aes_ctx = (struct aes_queue_ctx *)(*ctx);
+    memcpy(aes_ctx->key, key, keybits >> 3);
+    aes_ctx->key_length = keybits >> 3;
+
+    if (crypto_aes_soft_setkey(&aes_ctx->soft, key, keybits >> 3, dir) != RT_EOK)
+        return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+
+    return 0;
+}
+
+/*
+ * AES key schedule (encryption)
+ */
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits)
+{
+    return aes_queue_setkey(ctx, key, keybits, CRYPTO_DIR_ENCRYPT);
+}
+
+/*
+ * AES key schedule (decryption)
+ */
+int mbedtls_aes_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits)
+{
+    return aes_queue_setkey(ctx, key, keybits, CRYPTO_DIR_DECRYPT);
+}
+
+/*
+ * AES-ECB block encryption
+ */
+int mbedtls_internal_aes_encrypt(mbedtls_aes_context *ctx,
+                                 const unsigned char input[16],
+                                 unsigned char output[16])
+{
+    return mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, input, output);
+}
+
+void mbedtls_aes_encrypt(mbedtls_aes_context *ctx,
+                         const unsigned char input[16],
+                         unsigned char output[16])
+{
+    mbedtls_internal_aes_encrypt(ctx, input, output);
+}
+
+/*
+ * AES-ECB block decryption
+ */
+int mbedtls_internal_aes_decrypt(mbedtls_aes_context *ctx,
+                                 const unsigned char input[16],
+                                 unsigned char output[16])
+{
+    return mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_DECRYPT, input, output);
+}
+
+void mbedtls_aes_decrypt(mbedtls_aes_context *ctx,
+                         const unsigned char input[16],
+                         unsigned char output[16])
+{
+    mbedtls_internal_aes_decrypt(ctx, input, output);
+}
+
+/*
+ * AES-ECB block encryption/decryption
+ *
+ * mbedtls derives CFB, CTR and GCM from this one block at a time, so it
+ * never leaves the cpu. The key schedule follows the last setkey, as
+ * with the software aes.c.
+ */
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx,
+                          int mode,
+                          const unsigned char input[16],
+                          unsigned char output[16])
+{
+    struct aes_queue_ctx *aes_ctx;
+
+    if (ctx == NULL || *ctx == NULL)
+    {
+        pr_err("aes crypt ecb. but ctx is null");
+        return( MBEDTLS_ERR_AES_HW_ACCEL_FAILED );
+    }
+
+    aes_ctx = (struct aes_queue_ctx *)(*ctx);
+    (void)mode;
+    crypto_aes_soft_block(&aes_ctx->soft, input, output);
+
+    return 0;
+}
+
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+int mbedtls_aes_job_setup(mbedtls_aes_context *ctx,
+                          int mode,
+                          size_t length,
+                          unsigned char iv[16],
+                          const unsigned char *input,
+                          unsigned char *output,
+                          crypto_aes_job_t *job)
+{
+    struct aes_queue_ctx *aes_ctx;
+
+    if( length % 16 )
+        return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
+
+    if (ctx == NULL || *ctx == NULL || job == NULL)
+    {
+        pr_err("aes job setup. but ctx is null");
+        return( MBEDTLS_ERR_AES_HW_ACCEL_FAILED );
+    }
+
+    aes_ctx = (struct aes_queue_ctx *)(*ctx);
+    memset(job, 0, sizeof(*job));
+    job->src = input;
+    job->dst = output;
+    job->length = length;
+    job->key = aes_ctx->key;
+    job->key_length = aes_ctx->key_length;
+    job->iv = iv;
+    job->dir = mode == MBEDTLS_AES_ENCRYPT ? CRYPTO_DIR_ENCRYPT : CRYPTO_DIR_DECRYPT;
+    job->mode = AES_MODE_CBC;
+
+    return 0;
+}
+
+/*
+ * CBC on the cpu with the schedule of the last setkey
+ */
+static void aes_queue_cbc_soft(struct aes_queue_ctx *aes_ctx,
+                               int mode,
+                               size_t length,
+                               unsigned char iv[16],
+                               const unsigned char *input,
+                               unsigned char *output)
+{
+    unsigned char temp[16];
+    int i;
+
+    if( mode == MBEDTLS_AES_DECRYPT )
+    {
+        while( length > 0 )
+        {
+            memcpy( temp, input, 16 );
+            crypto_aes_soft_block( &aes_ctx->soft, input, output );
+
+            for( i = 0; i < 16; i++ )
+                output[i] = (unsigned char)( output[i] ^ iv[i] );
+
+            memcpy( iv, temp, 16 );
+
+            input  += 16;
+            output += 16;
+            length -= 16;
+        }
+    }
+    else
+    {
+        while( length > 0 )
+        {
+            for( i = 0; i < 16; i++ )
+                temp[i] = (unsigned char)( input[i] ^ iv[i] );
+
+            crypto_aes_soft_block( &aes_ctx->soft, temp, output );
+            memcpy( iv, output, 16 );
+
+            input  += 16;
+            output += 16;
+            length -= 16;
+        }
+    }
+}
+
+/*
+ * AES-CBC buffer encryption/decryption
+ */
+int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
+                          int mode,
+                          size_t length,
+                          unsigned char iv[16],
+                          const unsigned char *input,
+                          unsigned char *output)
+{
+    crypto_aes_job_t job;
+    int ret;
+
+    ret = mbedtls_aes_job_setup(ctx, mode, length, iv, input, output, &job);
+    if (ret != 0)
+        return ret;
+
+    if (length >= AES_QUEUE_MIN_LENGTH
+        && (((rt_ubase_t)input | (rt_ubase_t)output) % ADDR_ALIGN_SIZE) == 0)
+    {
+        ret = crypto_aes_job_run(&job);
+        if (ret == RT_EOK)
+            return 0;
+        /* -RT_ERROR: no engine registered yet, nothing was touched */
+        if (ret != -RT_ERROR)
+        {
+            pr_err("aes crypt cbc err %d", ret);
+            return( MBEDTLS_ERR_AES_HW_ACCEL_FAILED );
+        }
+    }
+
+    aes_queue_cbc_soft((struct aes_queue_ctx *)(*ctx), mode, length, iv, input, output);
+
+    return 0;
+}
+#endif /* MBEDTLS_CIPHER_MODE_CBC */
+
+#if defined(MBEDTLS_CIPHER_MODE_CFB)
+/*
+ * AES-CFB128 buffer encryption/decryption
+ */
+int mbedtls_aes_crypt_cfb128( mbedtls_aes_context *ctx,
+                       int mode,
+                       size_t length,
+                       size_t *iv_off,
+                       unsigned char iv[16],
+                       const unsigned char *input,
+                       unsigned char *output )
+{
+    int c;
+    size_t n = *iv_off;
+
+    if( mode == MBEDTLS_AES_DECRYPT )
+    {
+        while( length-- )
+        {
+            if( n == 0 )
+                mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+            c = *input++;
+            *output++ = (unsigned char)( c ^ iv[n] );
+            iv[n] = (unsigned char) c;
+
+            n = ( n + 1 ) & 0x0F;
+        }
+    }
+    else
+    {
+        while( length-- )
+        {
+            if( n == 0 )
+                mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+            iv[n] = *output++ = (unsigned char)( iv[n] ^ *input++ );
+
+            n = ( n + 1 ) & 0x0F;
+        }
+    }
+
+    *iv_off = n;
+
+    return( 0 );
+}
+
+/*
+ * AES-CFB8 buffer encryption/decryption
+ */
+int mbedtls_aes_crypt_cfb8( mbedtls_aes_context *ctx,
+                       int mode,
+                       size_t length,
+                       unsigned char iv[16],
+                       const unsigned char *input,
+                       unsigned char *output )
+{
+    unsigned char c;
+    unsigned char ov[17];
+
+    while( length-- )
+    {
+        memcpy( ov, iv, 16 );
+        mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+        if( mode == MBEDTLS_AES_DECRYPT )
+            ov[16] = *input;
+
+        c = *output++ = (unsigned char)( iv[0] ^ *input++ );
+
+        if( mode == MBEDTLS_AES_ENCRYPT )
+            ov[16] = c;
+
+        memcpy( iv, ov + 1, 16 );
+    }
+
+    return( 0 );
+}
+#endif /*MBEDTLS_CIPHER_MODE_CFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+/*
+ * AES-CTR buffer encryption/decryption
+ */
+int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
+                       size_t length,
+                       size_t *nc_off,
+                       unsigned char nonce_counter[16],
+                       unsigned char stream_block[16],
+                       const unsigned char *input,
+                       unsigned char *output )
+{
+    int c, i;
+    size_t n = *nc_off;
+
+    while( length-- )
+    {
+        if( n == 0 ) {
+            mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, nonce_counter, stream_block );
+
+            for( i = 16; i > 0; i-- )
+                if( ++nonce_counter[i - 1] != 0 )
+                    break;
+        }
+        c = *input++;
+        *output++ = (unsigned char)( c ^ stream_block[n] );
+
+        n = ( n + 1 ) & 0x0F;
+    }
+
+    *nc_off = n;
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CTR */
+
+#endif /* MBEDTLS_AES_ALT && MBEDTLS_AES_ALT_QUEUE */
+#endif /* MBEDTLS_AES_C */
@@ -5,28 +5,16 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "lfs_util.h"
+#include <libs/checksum.h>
 
 // Only compile if user does not provide custom config
 #ifndef LFS_CONFIG
 
 
-// Software CRC implementation with small lookup table
+// CRC-32 through the kernel checksum library (slice-by-8 tables or the
+// ARMv8 crc32 instructions), same polynomial and raw update semantics
 uint32_t lfs_crc(uint32_t crc, const void *buffer, size_t size) {
-    static const uint32_t rtable[16] = {
-        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
-        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
-        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
-        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
-    };
-
-    const uint8_t *data = buffer;
-
-    for (size_t i = 0; i < size; i++) {
-        crc = (crc >> 4) ^ rtable[(crc ^ (data[i] >> 0)) & 0xf];
-        crc = (crc >> 4) ^ rtable[(crc ^ (data[i] >> 4)) & 0xf];
-    }
-
-    return crc;
+    return crc32_le(crc, buffer, size);
 }
 
 
@@ -0,0 +1,39 @@
+#ifndef _CHECKSUM_H_
+#define _CHECKSUM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Shared checksum library (ekernel/subsys/lib/checksum.c).
+ *
+ * All CRC routines are "raw" update functions: they neither pre- nor
+ * post-invert the register, so callers keep their own conventions, e.g.
+ * gzip/littlefs start with ~0 and gzip inverts the final value.
+ */
+
+/* CRC32, reflected polynomial 0xedb88320 (gzip, zip, littlefs, png). */
+uint32_t crc32_le(uint32_t crc, const void *buf, size_t len);
+
+/* CRC32, normal polynomial 0x04c11db7 (bzip2, mpeg-ts). */
+uint32_t crc32_be(uint32_t crc, const void *buf, size_t len);
+
+/* CRC32C (Castagnoli), reflected polynomial 0x82f63b78. */
+uint32_t crc32c_le(uint32_t crc, const void *buf, size_t len);
+
+/* CRC16, reflected polynomial 0xa001 (CRC-16/ARC, modbus). */
+uint16_t melis_crc16(uint16_t crc, const void *buf, size_t len);
+
+/* CRC16-ITU-T, normal polynomial 0x1021 (UDF descriptor tags, xmodem). */
+uint16_t crc_itu_t(uint16_t crc, const void *buf, size_t len);
+
+/* Adler32 as defined by zlib, start with adler = 1. */
+uint32_t melis_adler32(uint32_t adler, const void *buf, size_t len);
+
+/* Plain 32bit sum of all bytes (adb packet data_check). */
+uint32_t csum_bytes(uint32_t sum, const void *buf, size_t len);
+
+/* Name of the CRC32 implementation selected at build time. */
+const char *crc32_impl_name(void);
+
+#endif
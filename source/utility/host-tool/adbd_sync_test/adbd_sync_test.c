@@ -0,0 +1,458 @@
+/*
+ * Host test and throughput benchmark for adb file sync,
+ * ekernel/subsys/adbd, over a socketpair loopback transport.
+ *
+ *   adbd_sync_test           run the checks and the throughput benchmark
+ *   adbd_sync_test -q        checks only
+ *
+ * The test plays the adb host: CNXN with protocol v1 (4 KB payloads,
+ * checksummed) or v2 (up to MAX_PAYLOAD, no checksum), then "sync:" with
+ * a push and a pull of the same file, compared byte for byte. The device
+ * side is the adbd code itself on a local transport.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "adb.h"
+#include "file_sync_service.h"
+#include <libs/checksum.h>
+
+#define FILE_SIZE       (16 * 1024 * 1024 + 12345)
+#define HOST_LOCALID    1
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static int read_full(int fd, void *buf, size_t len)
+{
+    char *p = buf;
+    ssize_t n;
+
+    while (len)
+    {
+        n = read(fd, p, len);
+        if (n <= 0)
+        {
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void *buf, size_t len)
+{
+    const char *p = buf;
+    ssize_t n;
+
+    while (len)
+    {
+        n = write(fd, p, len);
+        if (n <= 0)
+        {
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* the device end of the loopback, in place of transport_usb.c */
+struct loopback
+{
+    atransport t;
+    int fd;
+};
+
+static int loopback_read(apacket *p, atransport *t)
+{
+    struct loopback *lb = (struct loopback *)t;
+
+    if (read_full(lb->fd, &p->msg, sizeof(p->msg)) || check_header(p))
+    {
+        return -1;
+    }
+    if (p->msg.data_length > 0)
+    {
+        if (apacket_reserve(p, p->msg.data_length) ||
+            read_full(lb->fd, p->data, p->msg.data_length))
+        {
+            return -1;
+        }
+    }
+    return check_data(p, t);
+}
+
+static int loopback_write(apacket *p, atransport *t)
+{
+    struct loopback *lb = (struct loopback *)t;
+
+    if (write_full(lb->fd, &p->msg, sizeof(p->msg)))
+    {
+        return -1;
+    }
+    if (p->msg.data_length == 0)
+    {
+        return 0;
+    }
+    return write_full(lb->fd, p->data, p->msg.data_length);
+}
+
+static void loopback_close(atransport *t)
+{
+}
+
+/* the adb host */
+struct host
+{
+    int fd;
+    unsigned int version;
+    unsigned int max_payload;
+    unsigned int remoteid;
+    int ready;
+    int closed;
+    unsigned int packets;       /* WRTE received */
+    unsigned int short_packets; /* of those, not max_payload */
+    char *in;                   /* stream received, from in_off to in_len */
+    size_t in_off, in_len, in_size;
+    char *out;                  /* stream not sent yet */
+    size_t out_len;
+};
+
+static void host_send(struct host *h, unsigned int command, unsigned int arg0,
+                      unsigned int arg1, const void *data, unsigned int len)
+{
+    amessage msg;
+
+    msg.command = command;
+    msg.arg0 = arg0;
+    msg.arg1 = arg1;
+    msg.data_length = len;
+    msg.data_check = h->version < A_VERSION_SKIP_CHECKSUM ? csum_bytes(0, data, len) : 0;
+    msg.magic = command ^ 0xffffffff;
+    if (write_full(h->fd, &msg, sizeof(msg)) || (len && write_full(h->fd, data, len)))
+    {
+        CHECK(0, "host write");
+        exit(1);
+    }
+}
+
+/* one packet from the device: a WRTE is kept and acknowledged */
+static void host_pump(struct host *h, amessage *msg, char *data)
+{
+    if (read_full(h->fd, msg, sizeof(*msg)) || msg->magic != (msg->command ^ 0xffffffff) ||
+        msg->data_length > MAX_PAYLOAD || read_full(h->fd, data, msg->data_length))
+    {
+        CHECK(0, "host read");
+        exit(1);
+    }
+    if (h->version < A_VERSION_SKIP_CHECKSUM || msg->command == A_CNXN)
+    {
+        CHECK(msg->data_check == csum_bytes(0, data, msg->data_length), "data_check");
+    }
+    else
+    {
+        CHECK(msg->data_check == 0, "data_check 0x%x with v2", msg->data_check);
+    }
+
+    switch (msg->command)
+    {
+    case A_OKAY:
+        h->ready = 1;
+        break;
+    case A_CLSE:
+        h->closed = 1;
+        break;
+    case A_WRTE:
+        CHECK(msg->data_length <= h->max_payload, "%u byte WRTE, max %u",
+              msg->data_length, h->max_payload);
+        if (h->in_off > h->in_size / 2)
+        {
+            memmove(h->in, h->in + h->in_off, h->in_len - h->in_off);
+            h->in_len -= h->in_off;
+            h->in_off = 0;
+        }
+        if (h->in_len + msg->data_length > h->in_size)
+        {
+            h->in_size = (h->in_len + msg->data_length) * 2;
+            h->in = realloc(h->in, h->in_size);
+        }
+        memcpy(h->in + h->in_len, data, msg->data_length);
+        h->in_len += msg->data_length;
+        h->packets++;
+        h->short_packets += msg->data_length < h->max_payload;
+        host_send(h, A_OKAY, HOST_LOCALID, h->remoteid, NULL, 0);
+        break;
+    }
+}
+
+static void host_wait(struct host *h, unsigned int command, amessage *msg, char *data)
+{
+    do
+    {
+        host_pump(h, msg, data);
+    } while (msg->command != command);
+}
+
+/* WRTE the buffered stream, full packets unless all is set */
+static void host_flush(struct host *h, int all)
+{
+    static char data[MAX_PAYLOAD];
+    amessage msg;
+    size_t off = 0, n;
+
+    while (h->out_len - off >= h->max_payload || (all && off < h->out_len))
+    {
+        while (!h->ready)
+        {
+            host_pump(h, &msg, data);
+        }
+        n = h->out_len - off < h->max_payload ? h->out_len - off : h->max_payload;
+        h->ready = 0;
+        host_send(h, A_WRTE, HOST_LOCALID, h->remoteid, h->out + off, n);
+        off += n;
+    }
+    memmove(h->out, h->out + off, h->out_len - off);
+    h->out_len -= off;
+}
+
+static void host_put(struct host *h, const void *buf, size_t len)
+{
+    memcpy(h->out + h->out_len, buf, len);
+    h->out_len += len;
+    host_flush(h, 0);
+}
+
+static void host_get(struct host *h, void *buf, size_t len)
+{
+    static char data[MAX_PAYLOAD];
+    amessage msg;
+
+    while (h->in_len - h->in_off < len)
+    {
+        host_pump(h, &msg, data);
+    }
+    memcpy(buf, h->in + h->in_off, len);
+    h->in_off += len;
+}
+
+static void host_request(struct host *h, unsigned int id, const char *name)
+{
+    syncmsg msg;
+
+    msg.req.id = id;
+    msg.req.namelen = strlen(name);
+    host_put(h, &msg.req, sizeof(msg.req));
+    host_put(h, name, strlen(name));
+}
+
+static void push(struct host *h, const char *src, const char *dst)
+{
+    static char buf[SYNC_DATA_MAX];
+    char name[256];
+    syncmsg msg;
+    FILE *fp = fopen(src, "rb");
+    size_t n;
+
+    snprintf(name, sizeof(name), "%s,%d", dst, 0644);
+    host_request(h, ID_SEND, name);
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        msg.data.id = ID_DATA;
+        msg.data.size = n;
+        host_put(h, &msg.data, sizeof(msg.data));
+        host_put(h, buf, n);
+    }
+    fclose(fp);
+    msg.data.id = ID_DONE;
+    msg.data.size = 0;
+    host_put(h, &msg.data, sizeof(msg.data));
+    host_flush(h, 1);
+
+    host_get(h, &msg.status, sizeof(msg.status));
+    CHECK(msg.status.id == ID_OKAY, "push: status 0x%x", msg.status.id);
+}
+
+static void pull(struct host *h, const char *src, const char *dst)
+{
+    static char buf[SYNC_DATA_MAX];
+    syncmsg msg;
+    FILE *fp = fopen(dst, "wb");
+
+    host_request(h, ID_RECV, src);
+    host_flush(h, 1);
+    for (;;)
+    {
+        host_get(h, &msg.data, sizeof(msg.data));
+        if (msg.data.id != ID_DATA)
+        {
+            break;
+        }
+        CHECK(msg.data.size <= SYNC_DATA_MAX, "pull: %u byte DATA", msg.data.size);
+        host_get(h, buf, msg.data.size);
+        fwrite(buf, 1, msg.data.size, fp);
+    }
+    fclose(fp);
+    CHECK(msg.data.id == ID_DONE, "pull: ended with 0x%x", msg.data.id);
+}
+
+static int same_file(const char *a, const char *b)
+{
+    static char ba[65536], bb[65536];
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    size_t na, nb;
+    int same = fa && fb;
+
+    while (same)
+    {
+        na = fread(ba, 1, sizeof(ba), fa);
+        nb = fread(bb, 1, sizeof(bb), fb);
+        same = na == nb && !memcmp(ba, bb, na);
+        if (!na)
+        {
+            break;
+        }
+    }
+    if (fa)
+    {
+        fclose(fa);
+    }
+    if (fb)
+    {
+        fclose(fb);
+    }
+    return same;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void run(const char *label, unsigned int version, unsigned int payload,
+                const char *file, int quiet)
+{
+    static char data[MAX_PAYLOAD];
+    char pushed[64], pulled[64];
+    struct loopback *lb = calloc(1, sizeof(*lb));
+    struct host h;
+    amessage msg;
+    unsigned int want_version, want_payload;
+    double t0, t_push, t_pull;
+    int fds[2];
+
+    snprintf(pushed, sizeof(pushed), "%s.push", file);
+    snprintf(pulled, sizeof(pulled), "%s.pull", file);
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    lb->fd = fds[0];
+    lb->t.read_from_remote = loopback_read;
+    lb->t.write_to_remote = loopback_write;
+    lb->t.close = loopback_close;
+    lb->t.kick = loopback_close;
+    register_local_transport(&lb->t);
+
+    memset(&h, 0, sizeof(h));
+    h.fd = fds[1];
+    h.version = A_VERSION_MIN;
+    h.max_payload = MAX_PAYLOAD_V1;
+    h.out = malloc(2 * MAX_PAYLOAD + SYNC_DATA_MAX);
+
+    host_send(&h, A_CNXN, version, payload, "host::", 7);
+    host_wait(&h, A_CNXN, &msg, data);
+    want_version = version < A_VERSION ? version : A_VERSION;
+    want_payload = payload < MAX_PAYLOAD ? payload : MAX_PAYLOAD;
+    CHECK(msg.arg0 == want_version && msg.arg1 == want_payload,
+          "%s: CNXN 0x%08x/%u, want 0x%08x/%u", label, msg.arg0, msg.arg1,
+          want_version, want_payload);
+    h.version = msg.arg0;
+    h.max_payload = msg.arg1;
+
+    host_send(&h, A_OPEN, HOST_LOCALID, 0, "sync:", 6);
+    host_wait(&h, A_OKAY, &msg, data);
+    h.remoteid = msg.arg0;
+
+    t0 = now_s();
+    push(&h, file, pushed);
+    t_push = now_s() - t0;
+    CHECK(same_file(file, pushed), "%s: pushed file differs", label);
+
+    h.packets = 0;
+    h.short_packets = 0;
+    t0 = now_s();
+    pull(&h, pushed, pulled);
+    t_pull = now_s() - t0;
+    CHECK(same_file(file, pulled), "%s: pulled file differs", label);
+
+    /* DATA messages are packed into full packets: the last one is short,
+     * and the one before if DONE did not fit */
+    CHECK(h.short_packets <= 2, "%s: %u of %u packets not full", label,
+          h.short_packets, h.packets);
+
+    if (!quiet)
+    {
+        printf("  %-4s %6u byte packets  push %7.1f MB/s  pull %7.1f MB/s, %u packets\n",
+               label, h.max_payload, FILE_SIZE / t_push / 1e6, FILE_SIZE / t_pull / 1e6,
+               h.packets);
+    }
+
+    host_request(&h, ID_QUIT, "");
+    host_flush(&h, 1);
+    while (!h.closed)
+    {
+        host_pump(&h, &msg, data);
+    }
+    host_send(&h, A_CLSE, HOST_LOCALID, h.remoteid, NULL, 0);
+    close(h.fd);
+    unlink(pushed);
+    unlink(pulled);
+    free(h.in);
+    free(h.out);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+    char file[64];
+    unsigned int i, x = 0x36;
+    FILE *fp;
+
+    snprintf(file, sizeof(file), "/tmp/adbd_sync_test.%d", (int)getpid());
+    fp = fopen(file, "wb");
+    for (i = 0; i < FILE_SIZE; i++)
+    {
+        x = x * 1103515245 + 12345;
+        fputc(x >> 16, fp);
+    }
+    fclose(fp);
+
+    if (!quiet)
+    {
+        printf("adb sync over loopback, %d byte file:\n", FILE_SIZE);
+    }
+    run("v1", A_VERSION_MIN, 4096, file, quiet);
+    run("v2", A_VERSION, 1024 * 1024, file, quiet);
+    /* a v2 host that asks for less than we offer */
+    run("v2", A_VERSION, 64 * 1024, file, quiet);
+    unlink(file);
+
+    printf("adbd sync: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * host stub: the adbd primitives of adb_misc.c on pthreads, and the usb
+ * and socket entry points adbd links against.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "adb.h"
+
+struct host_queue
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int msgsize;
+    int head, count;
+    char msg[ADB_QUEUE_NUMBER][16];
+};
+
+static struct host_queue *queue_create(int msgsize)
+{
+    struct host_queue *q = calloc(1, sizeof(*q));
+
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    q->msgsize = msgsize;
+    return q;
+}
+
+static void queue_send(struct host_queue *q, const void *msg)
+{
+    pthread_mutex_lock(&q->mutex);
+    while (q->count == ADB_QUEUE_NUMBER)
+    {
+        pthread_cond_wait(&q->cond, &q->mutex);
+    }
+    memcpy(q->msg[(q->head + q->count) % ADB_QUEUE_NUMBER], msg, q->msgsize);
+    q->count++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+/* ms == 0 waits for good */
+static int queue_receive(struct host_queue *q, void *msg, int ms)
+{
+    struct timespec ts;
+    int ret = 0;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&q->mutex);
+    while (!q->count && ret == 0)
+    {
+        ret = ms ? pthread_cond_timedwait(&q->cond, &q->mutex, &ts)
+                 : pthread_cond_wait(&q->cond, &q->mutex);
+    }
+    if (q->count)
+    {
+        memcpy(msg, q->msg[q->head], q->msgsize);
+        q->head = (q->head + 1) % ADB_QUEUE_NUMBER;
+        q->count--;
+        pthread_cond_broadcast(&q->cond);
+        ret = 0;
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return ret ? -1 : 0;
+}
+
+static void queue_release(struct host_queue *q)
+{
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->mutex);
+    free(q);
+}
+
+adb_queue adb_queue_init(void)
+{
+    return queue_create(sizeof(void *));
+}
+
+void adb_queue_release(adb_queue queue)
+{
+    if (queue)
+    {
+        queue_release(queue);
+    }
+}
+
+int adb_enqueue(adb_queue q, void **data, int ms)
+{
+    queue_send(q, data);
+    return 0;
+}
+
+int adb_dequeue(adb_queue q, void **data, int ms)
+{
+    return queue_receive(q, data, 0);
+}
+
+typedef struct queue_event
+{
+    int event;
+    void *data;
+} queue_event;
+
+adb_queue_ev *adb_queue_event_init(void)
+{
+    adb_queue_ev *q = calloc(1, sizeof(*q));
+
+    q->queue = queue_create(sizeof(queue_event));
+    return q;
+}
+
+void adb_queue_event_release(adb_queue_ev *aqe)
+{
+    if (aqe)
+    {
+        queue_release(aqe->queue);
+        free(aqe);
+    }
+}
+
+int adb_enqueue_event(adb_queue_ev *aqe, int event, void *data, int ms)
+{
+    queue_event ev = { event, data };
+
+    queue_send(aqe->queue, &ev);
+    return 0;
+}
+
+int adb_dequeue_event(adb_queue_ev *aqe, int *event, void **data, int ms)
+{
+    queue_event ev;
+
+    if (queue_receive(aqe->queue, &ev, ms))
+    {
+        return -1;
+    }
+    if (event)
+    {
+        *event = ev.event;
+    }
+    *data = ev.data;
+    return 0;
+}
+
+adb_schd_t adb_schd_init(int mask)
+{
+    adb_schd_t schd = calloc(1, sizeof(adb_schd));
+
+    pthread_cond_init(&schd->cond, NULL);
+    pthread_mutex_init(&schd->mutex, NULL);
+    schd->mask = mask;
+    return schd;
+}
+
+int adb_schd_wait(adb_schd_t schd)
+{
+    int event;
+
+    pthread_mutex_lock(&schd->mutex);
+    while (!(schd->event & schd->mask))
+    {
+        pthread_cond_wait(&schd->cond, &schd->mutex);
+    }
+    event = schd->event;
+    schd->event = 0;
+    pthread_mutex_unlock(&schd->mutex);
+    return event;
+}
+
+void adb_schd_wakeup(adb_schd_t schd, int event)
+{
+    pthread_mutex_lock(&schd->mutex);
+    schd->event |= event;
+    if (schd->event & schd->mask)
+    {
+        pthread_cond_signal(&schd->cond);
+    }
+    pthread_mutex_unlock(&schd->mutex);
+}
+
+void adb_schd_release(adb_schd_t schd)
+{
+    pthread_cond_destroy(&schd->cond);
+    pthread_mutex_destroy(&schd->mutex);
+    free(schd);
+}
+
+void record_alive_thread_add(const char *name)
+{
+}
+
+void record_alive_thread_print(void)
+{
+}
+
+int usb_init(void)
+{
+    return -1;
+}
+
+int usb_read(usb_handle *h, void *data, int len)
+{
+    return -1;
+}
+
+int usb_write(usb_handle *h, const void *data, int len)
+{
+    return -1;
+}
+
+int socket_loopback_client(int port)
+{
+    return -1;
+}
+
+void socket_recv_service(void *xfer_handle, void *cookie)
+{
+}
+
+int socket_enqueue(aservice *ser, apacket *p)
+{
+    put_apacket(p);
+    return 0;
+}
+
+int socket_ready(aservice *ser)
+{
+    return 0;
+}
+
+int lwip_close(int s)
+{
+    return 0;
+}
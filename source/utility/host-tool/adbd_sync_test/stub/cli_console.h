@@ -0,0 +1,7 @@
+/* host stub: no console, the adb shell is not built */
+#ifndef __CLI_CONSOLE_H__
+#define __CLI_CONSOLE_H__
+
+typedef struct cli_console cli_console;
+
+#endif
@@ -0,0 +1,7 @@
+/* host stub: adbd queues are implemented in adb_host.c, only the handle type */
+#ifndef __HOST_MQUEUE_H__
+#define __HOST_MQUEUE_H__
+
+typedef void *mqd_t;
+
+#endif
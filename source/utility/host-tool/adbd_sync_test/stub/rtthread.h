@@ -0,0 +1,8 @@
+/* host stub: what adbd takes from rt-thread, the kernel list */
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+#include <stdint.h>
+#include <list.h>
+
+#endif
@@ -0,0 +1,516 @@
+/*
+ * Host test and benchmark for the packed plugin loops,
+ * ekernel/drivers/hal/source/sound/component/aw-alsa-lib/pcm_conv.c.
+ *
+ *   alsa_conv_test           run the checks and the benchmark
+ *   alsa_conv_test -q        checks only
+ *
+ * Each loop must give the samples of the generic path it replaces: the
+ * conv_* labels of plugin_ops.h for the linear plugin, MULTI_DIV_* of
+ * pcm_softvol.c for the gains and the float sums of the route plugin.
+ * Built with ../stub/arm_neon.h and __ARM_NEON defined as alsa_conv_test_neon,
+ * the same checks cover the NEON paths.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "pcm_conv.h"
+#include "bswap.h"
+#include "plugin_ops.h"
+
+#define MAX_FRAMES	4096
+#define BENCH_FRAMES	1024
+
+static int failures;
+
+#define CHECK(cond, ...)			\
+	do {					\
+		if (!(cond)) {			\
+			printf("FAIL: " __VA_ARGS__);	\
+			printf("\n");		\
+			failures++;		\
+		}				\
+	} while (0)
+
+static unsigned int rnd(void)
+{
+	static unsigned int seed = 0x9e3779b9;
+
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+/* random samples, a quarter of them at full scale */
+static void fill(void *buf, unsigned int bytes)
+{
+	unsigned int *p = buf, i, v;
+
+	for (i = 0; i < bytes / 4; i++) {
+		v = rnd();
+		if ((v & 7) == 0)
+			v = v & 8 ? 0x7fff7fff : 0x80008000;
+		else if ((v & 7) == 1)
+			v = v & 8 ? 0x7fffffff : 0x80000000;
+		p[i] = v;
+	}
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ---- format conversion, against snd_pcm_linear_convert() ---- */
+
+struct format {
+	const char *name;
+	snd_pcm_format_t format;
+	unsigned int bytes;
+	unsigned int width;	/* index of plugin_ops.h, bytes of the value - 1 */
+};
+
+static const struct format formats[] = {
+	{ "S16_LE", SND_PCM_FORMAT_S16_LE, 2, 1 },
+	{ "S24_LE", SND_PCM_FORMAT_S24_LE, 4, 2 },
+	{ "S32_LE", SND_PCM_FORMAT_S32_LE, 4, 3 },
+};
+
+/* the loop of snd_pcm_linear_convert() over one area */
+static void conv_ref(void *dst, const void *src, unsigned int n,
+		     const struct format *sf, const struct format *df)
+{
+#define CONV_LABELS
+#include "plugin_ops.h"
+#undef CONV_LABELS
+	void *conv = conv_labels[sf->width * 32 + df->width * 2];
+	const char *s = src;
+	char *d = dst;
+
+	while (n-- > 0) {
+		const char *src = s;
+		char *dst = d;
+
+		goto *conv;
+#define CONV_END after
+#include "plugin_ops.h"
+#undef CONV_END
+	after:
+		s += sf->bytes;
+		d += df->bytes;
+	}
+}
+
+static unsigned char conv_src[MAX_FRAMES * 8 * 4];
+static unsigned char conv_dst[2][MAX_FRAMES * 8 * 4];
+
+static void check_conv(void)
+{
+	static const unsigned int sizes[] = { 1, 3, 7, 8, 9, 31, 64, 1001, MAX_FRAMES * 8 };
+	unsigned int s, d, k;
+
+	for (s = 0; s < 3; s++) {
+		for (d = 0; d < 3; d++) {
+			const struct format *sf = &formats[s], *df = &formats[d];
+			snd_pcm_conv_func_t fn = snd_pcm_conv_find(sf->format, df->format);
+
+			CHECK(fn, "no conversion %s -> %s", sf->name, df->name);
+			if (!fn)
+				continue;
+			for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+				fill(conv_src, sizeof(conv_src));
+				memset(conv_dst, 0x55, sizeof(conv_dst));
+				conv_ref(conv_dst[0], conv_src, sizes[k], sf, df);
+				fn(conv_dst[1], conv_src, sizes[k]);
+				CHECK(!memcmp(conv_dst[0], conv_dst[1], sizes[k] * df->bytes),
+				      "%s -> %s: %u samples", sf->name, df->name, sizes[k]);
+			}
+		}
+	}
+	CHECK(!snd_pcm_conv_find(SND_PCM_FORMAT_S16_BE, SND_PCM_FORMAT_S32_LE),
+	      "S16_BE has no packed conversion");
+	CHECK(!snd_pcm_conv_find(SND_PCM_FORMAT_S16_LE, SND_PCM_FORMAT_U8),
+	      "U8 has no packed conversion");
+}
+
+/* ---- gains, against CONVERT_AREA() of pcm_softvol.c ---- */
+
+typedef union {
+	int i;
+	short s[2];
+} val_t;
+
+/* copied from pcm_softvol.c, without the byte swapping */
+static inline int MULTI_DIV_32x16(int a, unsigned short b)
+{
+	val_t v, x, y;
+	v.i = a;
+	y.i = 0;
+	x.i = (unsigned short)v.s[0];
+	x.i *= b;
+	y.s[0] = x.s[1];
+	y.i += (int)v.s[1] * b;
+
+	return y.i;
+}
+
+static inline int MULTI_DIV_int(int a, unsigned int b)
+{
+	unsigned int gain = (b >> 16);
+	int fraction;
+	fraction = MULTI_DIV_32x16(a, b & 0xffff);
+	if (gain) {
+		long long amp = (long long)a * gain + fraction;
+		if (amp > (int)0x7fffffff)
+			amp = (int)0x7fffffff;
+		else if (amp < (int)0x80000000)
+			amp = (int)0x80000000;
+		return (int)amp;
+	}
+	return fraction;
+}
+
+static inline short MULTI_DIV_short(short a, unsigned int b)
+{
+	unsigned int gain = b >> 16;
+	int fraction;
+	fraction = (int)(a * (b & 0xffff)) >> 16;
+	if (gain) {
+		int amp = a * gain + fraction;
+		if (abs(amp) > 0x7fff)
+			amp = (a<0) ? (short)0x8000 : (short)0x7fff;
+		return (short)amp;
+	}
+	return (short)fraction;
+}
+
+/* a channel at a time, as CONVERT_AREA(), vol 0 silent and 0xffff copied */
+static void scale_ref(void *dst, const void *src, unsigned int frames, unsigned int channels,
+		      const unsigned int *vol, int bits)
+{
+	unsigned int ch, f;
+
+	for (ch = 0; ch < channels; ch++) {
+		for (f = 0; f < frames; f++) {
+			unsigned int i = f * channels + ch;
+
+			if (bits == 16) {
+				short a = ((const short *)src)[i];
+
+				((short *)dst)[i] = !vol[ch] ? 0 : vol[ch] == 0xffff ? a :
+						    MULTI_DIV_short(a, vol[ch]);
+			} else {
+				int a = ((const int *)src)[i];
+
+				((int *)dst)[i] = !vol[ch] ? 0 : vol[ch] == 0xffff ? a :
+						  MULTI_DIV_int(a, vol[ch]);
+			}
+		}
+	}
+}
+
+static unsigned int random_vol(int boost)
+{
+	static const unsigned int some[] = { 0, 0xffff, 0x00b8, 0x0fc8, 0x7fff, 0x8000, 0xffff };
+	unsigned int v = rnd();
+
+	if (v % 4 == 0)
+		return some[(v >> 8) % 7];
+	if (boost && v % 4 == 1)
+		return 0x10000 + (v >> 8) % 0x1400000;	/* up to +50 dB */
+	return (v >> 8) & 0xffff;
+}
+
+static void check_scale(void)
+{
+	static const unsigned int sizes[] = { 1, 2, 3, 5, 8, 17, 333, MAX_FRAMES };
+	unsigned int vol[8], gain[8];
+	unsigned int ch, k, c, round, bits;
+
+	for (bits = 16; bits <= 32; bits += 16) {
+		for (ch = 1; ch <= 8; ch++) {
+			for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+				for (round = 0; round < 8; round++) {
+					for (c = 0; c < ch; c++) {
+						vol[c] = random_vol(round & 1);
+						gain[c] = vol[c] == 0xffff ? SND_PCM_CONV_UNITY : vol[c];
+					}
+					fill(conv_src, sizes[k] * ch * bits / 8);
+					scale_ref(conv_dst[0], conv_src, sizes[k], ch, vol, bits);
+					if (bits == 16)
+						snd_pcm_conv_scale_s16((int16_t *)conv_dst[1], (int16_t *)conv_src,
+								       sizes[k], ch, gain);
+					else
+						snd_pcm_conv_scale_s32((int32_t *)conv_dst[1], (int32_t *)conv_src,
+								       sizes[k], ch, gain);
+					CHECK(!memcmp(conv_dst[0], conv_dst[1], sizes[k] * ch * bits / 8),
+					      "S%u scale: %u frames of %u channels, round %u",
+					      bits, sizes[k], ch, round);
+				}
+			}
+		}
+	}
+}
+
+static void check_ramp(void)
+{
+	unsigned int from[2] = { 0, 0x10000 }, to[2] = { 0x10000, 0x0800 };
+	unsigned int frames = 480, f, bits;
+	int last[2];
+
+	for (bits = 16; bits <= 32; bits += 16) {
+		for (f = 0; f < frames * 2; f++) {
+			if (bits == 16)
+				((int16_t *)conv_src)[f] = f & 1 ? -20000 : 20000;
+			else
+				((int32_t *)conv_src)[f] = f & 1 ? -2000000000 : 2000000000;
+		}
+		if (bits == 16)
+			snd_pcm_conv_ramp_s16((int16_t *)conv_dst[0], (int16_t *)conv_src,
+					      frames, 2, from, to);
+		else
+			snd_pcm_conv_ramp_s32((int32_t *)conv_dst[0], (int32_t *)conv_src,
+					      frames, 2, from, to);
+		/* fading in on the left, out on the right, ending on the new gains */
+		last[0] = -1;
+		last[1] = 0x7fffffff;
+		for (f = 0; f < frames; f++) {
+			long long l, r;
+
+			if (bits == 16) {
+				l = ((int16_t *)conv_dst[0])[2 * f];
+				r = -((int16_t *)conv_dst[0])[2 * f + 1];
+			} else {
+				l = ((int32_t *)conv_dst[0])[2 * f];
+				r = -(long long)((int32_t *)conv_dst[0])[2 * f + 1];
+			}
+			CHECK(l >= last[0] && r <= last[1], "S%u ramp not monotonic at frame %u",
+			      bits, f);
+			last[0] = l;
+			last[1] = r;
+		}
+		CHECK(last[0] == (bits == 16 ? 20000 : 2000000000) &&
+		      last[1] == (bits == 16 ? 20000 / 32 : 2000000000 / 32),
+		      "S%u ramp ends at %d %d", bits, last[0], last[1]);
+		CHECK(((bits == 16) ? ((int16_t *)conv_dst[0])[0] : ((int32_t *)conv_dst[0])[0]) <
+		      (bits == 16 ? 20000 / 100 : 2000000000 / 100),
+		      "S%u ramp starts too loud", bits);
+	}
+}
+
+/* ---- routing, against snd_pcm_route_convert1_many() with float sums ---- */
+
+static void route_ref(void *dst, const void *src, unsigned int frames,
+		      const snd_pcm_conv_route_t *r)
+{
+	int src16 = r->src_format == SND_PCM_FORMAT_S16_LE;
+	int dst16 = r->dst_format == SND_PCM_FORMAT_S16_LE;
+	unsigned int d, s, f, nsrcs, one;
+	int att;
+
+	for (d = 0; d < r->dst_channels; d++) {
+		nsrcs = 0;
+		att = 0;
+		one = 0;
+		for (s = 0; s < r->src_channels; s++) {
+			if (r->weight[d][s]) {
+				nsrcs++;
+				one = s;
+				if (r->weight[d][s] != 16)
+					att = 1;
+			}
+		}
+		for (f = 0; f < frames; f++) {
+			int32_t sample = 0;
+
+			if (nsrcs == 1 && !att) {
+				/* convert1_one, the conv labels */
+				sample = src16 ? (int32_t)((uint32_t)((const uint16_t *)src)[f * r->src_channels + one] << 16) :
+					 ((const int32_t *)src)[f * r->src_channels + one];
+			} else if (nsrcs) {
+				float sum = 0.0;
+
+				for (s = 0; s < r->src_channels; s++) {
+					int32_t v;
+
+					if (!r->weight[d][s])
+						continue;
+					v = src16 ? (int32_t)((uint32_t)((const uint16_t *)src)[f * r->src_channels + s] << 16) :
+					    ((const int32_t *)src)[f * r->src_channels + s];
+					if (att)
+						sum += v * (r->weight[d][s] / 16.0f);
+					else
+						sum += v;
+				}
+				sum = rint(sum);
+				if (sum > (int64_t)0x7fffffff)
+					sample = 0x7fffffff;
+				else if (sum < -(int64_t)0x80000000)
+					sample = 0x80000000;
+				else
+					sample = sum;
+			}
+			if (dst16)
+				((uint16_t *)dst)[f * r->dst_channels + d] = (uint32_t)sample >> 16;
+			else
+				((int32_t *)dst)[f * r->dst_channels + d] = sample;
+		}
+	}
+}
+
+static void route_table(snd_pcm_conv_route_t *r, unsigned int sch, unsigned int dch,
+			const char *table)
+{
+	unsigned int d, s;
+
+	r->src_channels = sch;
+	r->dst_channels = dch;
+	memset(r->weight, 0, sizeof(r->weight));
+	for (d = 0; d < dch; d++)
+		for (s = 0; s < sch; s++)
+			r->weight[d][s] = table[d * sch + s];
+}
+
+static const struct {
+	const char *name;
+	unsigned int sch, dch;
+	char table[16];
+	int mix;
+} tables[] = {
+	{ "copy 2->2", 2, 2, { 16, 0, 0, 16 }, 0 },
+	{ "swap 2->2", 2, 2, { 0, 16, 16, 0 }, 0 },
+	{ "dup 1->2", 1, 2, { 16, 16 }, 0 },
+	{ "average 2->1", 2, 1, { 8, 8 }, 1 },
+	{ "sum 2->1", 2, 1, { 16, 16 }, 1 },
+	{ "pan 2->2", 2, 2, { 12, 4, 4, 12 }, 1 },
+	{ "copy 2->4", 2, 4, { 16, 0, 0, 16, 0, 0, 0, 0 }, 0 },
+	{ "average 4->2", 4, 2, { 8, 0, 8, 0, 0, 8, 0, 8 }, 1 },
+	{ "half 1->1", 1, 1, { 8 }, 1 },
+};
+
+static unsigned char route_src[MAX_FRAMES * 8 * 4];
+static unsigned char route_dst[2][MAX_FRAMES * 8 * 4];
+
+static void check_route(void)
+{
+	static const snd_pcm_format_t fmts[2] = { SND_PCM_FORMAT_S16_LE, SND_PCM_FORMAT_S32_LE };
+	static const unsigned int sizes[] = { 1, 7, 64, 1000, MAX_FRAMES };
+	snd_pcm_conv_route_t r;
+	unsigned int t, s, d, k;
+
+	for (t = 0; t < sizeof(tables) / sizeof(tables[0]); t++) {
+		for (s = 0; s < 2; s++) {
+			for (d = 0; d < 2; d++) {
+				route_table(&r, tables[t].sch, tables[t].dch, tables[t].table);
+				r.src_format = fmts[s];
+				r.dst_format = fmts[d];
+				if (!snd_pcm_conv_route_supported(&r)) {
+					/* mixes of S32 stay with the float sums */
+					CHECK(tables[t].mix && s == 1, "%s S%d->S%d not supported",
+					      tables[t].name, s ? 32 : 16, d ? 32 : 16);
+					continue;
+				}
+				CHECK(!tables[t].mix || s == 0, "%s S32 mix supported", tables[t].name);
+				for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+					unsigned int bytes = sizes[k] * r.dst_channels * (d ? 4 : 2);
+
+					fill(route_src, sizeof(route_src));
+					route_ref(route_dst[0], route_src, sizes[k], &r);
+					snd_pcm_conv_route(route_dst[1], route_src, sizes[k], &r);
+					CHECK(!memcmp(route_dst[0], route_dst[1], bytes),
+					      "%s S%d->S%d: %u frames", tables[t].name,
+					      s ? 32 : 16, d ? 32 : 16, sizes[k]);
+				}
+			}
+		}
+	}
+
+	route_table(&r, 2, 1, (const char []){ 5, 5 });
+	r.src_format = r.dst_format = SND_PCM_FORMAT_S16_LE;
+	CHECK(snd_pcm_conv_route_supported(&r), "5/16 weights are exact for S16");
+	route_table(&r, 9, 1, (const char [9]){ 16 });
+	CHECK(!snd_pcm_conv_route_supported(&r), "9 channels supported");
+}
+
+/* ---- benchmark ---- */
+
+static void bench(void)
+{
+	static const unsigned int stereo_vol[2] = { 0x4826, 0x2984 };
+	static const unsigned int stereo_gain[2] = { 0x4826, 0x2984 };
+	snd_pcm_conv_route_t r;
+	unsigned int i, loops = 2000, n = BENCH_FRAMES * 2;
+	double t0, t1, t2;
+
+	fill(conv_src, sizeof(conv_src));
+	printf("ns per sample, %u stereo frames a period:\n", BENCH_FRAMES);
+
+	t0 = now_ns();
+	for (i = 0; i < loops; i++)
+		conv_ref(conv_dst[0], conv_src, n, &formats[0], &formats[2]);
+	t1 = now_ns();
+	for (i = 0; i < loops; i++)
+		snd_pcm_conv_find(SND_PCM_FORMAT_S16_LE, SND_PCM_FORMAT_S32_LE)(conv_dst[1], conv_src, n);
+	t2 = now_ns();
+	printf("  linear S16 -> S32      %.2f -> %.2f\n", (t1 - t0) / loops / n, (t2 - t1) / loops / n);
+
+	t0 = now_ns();
+	for (i = 0; i < loops; i++)
+		scale_ref(conv_dst[0], conv_src, BENCH_FRAMES, 2, stereo_vol, 16);
+	t1 = now_ns();
+	for (i = 0; i < loops; i++)
+		snd_pcm_conv_scale_s16((int16_t *)conv_dst[1], (int16_t *)conv_src, BENCH_FRAMES, 2, stereo_gain);
+	t2 = now_ns();
+	printf("  softvol S16            %.2f -> %.2f\n", (t1 - t0) / loops / n, (t2 - t1) / loops / n);
+
+	t0 = now_ns();
+	for (i = 0; i < loops; i++)
+		scale_ref(conv_dst[0], conv_src, BENCH_FRAMES, 2, stereo_vol, 32);
+	t1 = now_ns();
+	for (i = 0; i < loops; i++)
+		snd_pcm_conv_scale_s32((int32_t *)conv_dst[1], (int32_t *)conv_src, BENCH_FRAMES, 2, stereo_gain);
+	t2 = now_ns();
+	printf("  softvol S32            %.2f -> %.2f\n", (t1 - t0) / loops / n, (t2 - t1) / loops / n);
+
+	for (i = 0; i < 3; i++) {
+		static const char *name[3] = { "dup 1->2", "average 2->1", "pan 2->2" };
+		static const char *table[3] = { "\x10\x10", "\x08\x08", "\x0c\x04\x04\x0c" };
+		unsigned int j;
+
+		route_table(&r, i == 0 ? 1 : 2, i == 1 ? 1 : 2, table[i]);
+		r.src_format = r.dst_format = SND_PCM_FORMAT_S16_LE;
+		t0 = now_ns();
+		for (j = 0; j < loops; j++)
+			route_ref(route_dst[0], route_src, BENCH_FRAMES, &r);
+		t1 = now_ns();
+		for (j = 0; j < loops; j++)
+			snd_pcm_conv_route(route_dst[1], route_src, BENCH_FRAMES, &r);
+		t2 = now_ns();
+		printf("  route S16 %-12s %.2f -> %.2f\n", name[i],
+		       (t1 - t0) / loops / BENCH_FRAMES / r.dst_channels,
+		       (t2 - t1) / loops / BENCH_FRAMES / r.dst_channels);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+	check_conv();
+	check_scale();
+	check_ramp();
+	check_route();
+	if (!quiet)
+		bench();
+
+	printf("%s: %s\n", argv[0], failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
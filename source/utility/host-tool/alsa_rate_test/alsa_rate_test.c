@@ -0,0 +1,537 @@
+/*
+ * Host test and benchmark for the polyphase rate converter,
+ * ekernel/drivers/hal/source/sound/component/aw-alsa-lib/pcm_rate_polyphase.c,
+ * next to the two it joins: speexrate, built from its sources, and linear,
+ * whose S16 loops are copied below (pcm_rate_linear.c needs the kernel).
+ *
+ *   alsa_rate_test           run the checks, print SNR, aliasing and speed
+ *   alsa_rate_test -q        checks only
+ *
+ * Every converter is driven through its snd_pcm_rate_ops_t the way
+ * pcm_rate.c does it: init and adjust_pitch with the period sizes that
+ * pcm_rate.c picks for a 1024 frame client period, then one period at a
+ * time. SNR is what is left of a sine after a least squares fit; aliasing
+ * is the level that comes out of a tone above the output Nyquist.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <aw-alsa-lib/plugin/pcm_rate.h>
+
+#define CHANNELS	2
+#define PERIOD		1024
+#define PERIODS		48
+#define SETTLE		8	/* periods left out of the measures */
+
+extern int SND_PCM_RATE_PLUGIN_ENTRY(speexrate) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
+extern int SND_PCM_RATE_PLUGIN_ENTRY(polyphase_low) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
+extern int SND_PCM_RATE_PLUGIN_ENTRY(polyphase) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
+extern int SND_PCM_RATE_PLUGIN_ENTRY(polyphase_best) (unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
+
+static int failures;
+
+#define CHECK(cond, ...)			\
+	do {					\
+		if (!(cond)) {			\
+			printf("FAIL: " __VA_ARGS__);	\
+			printf("\n");		\
+			failures++;		\
+		}				\
+	} while (0)
+
+/* ---- linear, the S16 loops of pcm_rate_linear.c on interleaved buffers ---- */
+
+#define LINEAR_DIV_SHIFT 19
+#define LINEAR_DIV (1<<LINEAR_DIV_SHIFT)
+
+struct rate_linear {
+	unsigned int pitch;
+	unsigned int pitch_shift;
+	unsigned int channels;
+	int expand;
+	int16_t old_sample[CHANNELS];
+};
+
+static snd_pcm_uframes_t linear_input_frames(void *obj, snd_pcm_uframes_t frames)
+{
+	struct rate_linear *rate = obj;
+
+	if (frames == 0)
+		return 0;
+	return ((unsigned long long)frames * LINEAR_DIV + rate->pitch / 2) / rate->pitch;
+}
+
+static snd_pcm_uframes_t linear_output_frames(void *obj, snd_pcm_uframes_t frames)
+{
+	struct rate_linear *rate = obj;
+
+	if (frames == 0)
+		return 0;
+	return ((unsigned long long)frames * rate->pitch + LINEAR_DIV / 2) / LINEAR_DIV;
+}
+
+static void linear_expand_s16(struct rate_linear *rate, int16_t *dst, unsigned int dst_frames,
+			      const int16_t *src, unsigned int src_frames)
+{
+	unsigned int get_threshold = rate->pitch;
+	unsigned int channel, src_frames1, dst_frames1, pos;
+
+	for (channel = 0; channel < rate->channels; ++channel) {
+		const int16_t *s = src + channel;
+		int16_t *d = dst + channel;
+		int16_t old_sample = 0;
+		int16_t new_sample;
+		int old_weight, new_weight;
+
+		src_frames1 = 0;
+		dst_frames1 = 0;
+		new_sample = rate->old_sample[channel];
+		pos = get_threshold;
+		while (dst_frames1 < dst_frames) {
+			if (pos >= get_threshold) {
+				pos -= get_threshold;
+				old_sample = new_sample;
+				if (src_frames1 < src_frames)
+					new_sample = *s;
+			}
+			new_weight = (pos << (16 - rate->pitch_shift)) / (get_threshold >> rate->pitch_shift);
+			old_weight = 0x10000 - new_weight;
+			*d = (old_sample * old_weight + new_sample * new_weight) >> 16;
+			d += rate->channels;
+			dst_frames1++;
+			pos += LINEAR_DIV;
+			if (pos >= get_threshold) {
+				s += rate->channels;
+				src_frames1++;
+			}
+		}
+		rate->old_sample[channel] = new_sample;
+	}
+}
+
+static void linear_shrink_s16(struct rate_linear *rate, int16_t *dst, unsigned int dst_frames,
+			      const int16_t *src, unsigned int src_frames)
+{
+	unsigned int get_increment = rate->pitch;
+	unsigned int channel, src_frames1, dst_frames1, pos;
+
+	for (channel = 0; channel < rate->channels; ++channel) {
+		const int16_t *s = src + channel;
+		int16_t *d = dst + channel;
+		int16_t old_sample = 0;
+		int16_t new_sample = 0;
+		int old_weight, new_weight;
+
+		pos = LINEAR_DIV - get_increment;
+		src_frames1 = 0;
+		dst_frames1 = 0;
+		while (src_frames1 < src_frames) {
+			new_sample = *s;
+			s += rate->channels;
+			src_frames1++;
+			pos += get_increment;
+			if (pos >= LINEAR_DIV) {
+				pos -= LINEAR_DIV;
+				old_weight = (pos << (32 - LINEAR_DIV_SHIFT)) / (get_increment >> (LINEAR_DIV_SHIFT - 16));
+				new_weight = 0x10000 - old_weight;
+				*d = (old_sample * old_weight + new_sample * new_weight) >> 16;
+				d += rate->channels;
+				dst_frames1++;
+				if (dst_frames1 >= dst_frames)
+					break;
+			}
+			old_sample = new_sample;
+		}
+	}
+}
+
+static void linear_convert_s16(void *obj, int16_t *dst, unsigned int dst_frames,
+			       const int16_t *src, unsigned int src_frames)
+{
+	struct rate_linear *rate = obj;
+
+	if (rate->expand)
+		linear_expand_s16(rate, dst, dst_frames, src, src_frames);
+	else
+		linear_shrink_s16(rate, dst, dst_frames, src, src_frames);
+}
+
+static int linear_init(void *obj, snd_pcm_rate_info_t *info)
+{
+	struct rate_linear *rate = obj;
+
+	rate->expand = info->in.rate < info->out.rate;
+	rate->pitch = (((unsigned long long)info->out.rate * LINEAR_DIV) +
+		       (info->in.rate / 2)) / info->in.rate;
+	rate->channels = info->channels;
+	return 0;
+}
+
+static int linear_adjust_pitch(void *obj, snd_pcm_rate_info_t *info)
+{
+	struct rate_linear *rate = obj;
+	snd_pcm_uframes_t cframes;
+
+	rate->pitch = (((unsigned long long)info->out.period_size * LINEAR_DIV) +
+		       (info->in.period_size / 2)) / info->in.period_size;
+	cframes = linear_input_frames(rate, info->out.period_size);
+	while (cframes != info->in.period_size) {
+		if (cframes > info->in.period_size)
+			rate->pitch++;
+		else
+			rate->pitch--;
+		cframes = linear_input_frames(rate, info->out.period_size);
+	}
+	if (rate->pitch >= LINEAR_DIV) {
+		rate->pitch_shift = 0;
+		while ((rate->pitch >> rate->pitch_shift) >= (1 << 16))
+			rate->pitch_shift++;
+	}
+	return 0;
+}
+
+static void linear_reset(void *obj)
+{
+	struct rate_linear *rate = obj;
+
+	memset(rate->old_sample, 0, sizeof(rate->old_sample));
+}
+
+static void linear_close(void *obj)
+{
+	free(obj);
+}
+
+static int linear_open(unsigned int version, void **objp, snd_pcm_rate_ops_t *ops)
+{
+	static const snd_pcm_rate_ops_t linear_ops = {
+		.close = linear_close,
+		.init = linear_init,
+		.reset = linear_reset,
+		.adjust_pitch = linear_adjust_pitch,
+		.convert_s16 = linear_convert_s16,
+		.input_frames = linear_input_frames,
+		.output_frames = linear_output_frames,
+	};
+
+	*objp = calloc(1, sizeof(struct rate_linear));
+	*ops = linear_ops;
+	return *objp ? 0 : -1;
+}
+
+/* ---- driving a converter like pcm_rate.c ---- */
+
+static const struct converter {
+	const char *name;
+	int (*open)(unsigned int version, void **objp, snd_pcm_rate_ops_t *ops);
+	int polyphase;
+} converters[] = {
+	{ "linear", linear_open, 0 },
+	{ "speexrate", SND_PCM_RATE_PLUGIN_ENTRY(speexrate), 0 },
+	{ "polyphase_low", SND_PCM_RATE_PLUGIN_ENTRY(polyphase_low), 1 },
+	{ "polyphase", SND_PCM_RATE_PLUGIN_ENTRY(polyphase), 1 },
+	{ "polyphase_best", SND_PCM_RATE_PLUGIN_ENTRY(polyphase_best), 1 },
+};
+
+#define NCONVERTERS	(sizeof(converters) / sizeof(converters[0]))
+
+static const struct ratio {
+	unsigned int in, out;
+} ratios[] = {
+	{ 44100, 48000 }, { 48000, 44100 }, { 16000, 48000 }, { 48000, 16000 },
+	{ 8000, 48000 }, { 48000, 8000 }, { 44100, 16000 }, { 22050, 44100 },
+};
+
+#define NRATIOS		(sizeof(ratios) / sizeof(ratios[0]))
+
+struct run {
+	void *obj;
+	snd_pcm_rate_ops_t ops;
+	snd_pcm_rate_info_t info;
+	int16_t *in, *out;
+};
+
+static int run_open(struct run *r, const struct converter *c, const struct ratio *ratio)
+{
+	memset(r, 0, sizeof(*r));
+	if (c->open(SND_PCM_RATE_PLUGIN_VERSION, &r->obj, &r->ops))
+		return -1;
+	r->info.channels = CHANNELS;
+	r->info.in.format = r->info.out.format = SND_PCM_FORMAT_S16_LE;
+	r->info.in.rate = ratio->in;
+	r->info.out.rate = ratio->out;
+	r->info.in.period_size = PERIOD;
+	/* the slave period of snd_pcm_rate_hw_params() */
+	r->info.out.period_size = ratio->out * 10000 / ratio->in * PERIOD / 10000;
+	r->info.in.buffer_size = r->info.in.period_size * 4;
+	r->info.out.buffer_size = r->info.out.period_size * 4;
+	if (r->ops.init(r->obj, &r->info) || r->ops.adjust_pitch(r->obj, &r->info))
+		return -1;
+	r->ops.reset(r->obj);
+	r->in = calloc(PERIODS * PERIOD * CHANNELS, sizeof(int16_t));
+	r->out = calloc(PERIODS * r->info.out.period_size * CHANNELS, sizeof(int16_t));
+	return 0;
+}
+
+static void run_periods(struct run *r)
+{
+	unsigned int p, ip = r->info.in.period_size, op = r->info.out.period_size;
+
+	for (p = 0; p < PERIODS; p++)
+		r->ops.convert_s16(r->obj, r->out + p * op * CHANNELS, op,
+				   r->in + p * ip * CHANNELS, ip);
+}
+
+static void run_close(struct run *r)
+{
+	if (r->ops.free)
+		r->ops.free(r->obj);
+	r->ops.close(r->obj);
+	free(r->in);
+	free(r->out);
+}
+
+/* the same tone on every channel, the right one inverted */
+static void fill_tone(struct run *r, double freq, double amp)
+{
+	unsigned int n, ch;
+
+	for (n = 0; n < PERIODS * PERIOD; n++)
+		for (ch = 0; ch < CHANNELS; ch++)
+			r->in[n * CHANNELS + ch] = lrint((ch ? -amp : amp) *
+							 sin(2 * M_PI * freq * n / r->info.in.rate));
+}
+
+/*
+ * The tone comes out at freq * in.period_size / out.period_size frames
+ * per input frame: the period ratio, not the rate ratio, sets the pitch.
+ */
+static double measure_snr(const struct run *r, double freq)
+{
+	unsigned int op = r->info.out.period_size, n, first = SETTLE * op, last = PERIODS * op;
+	double w = 2 * M_PI * freq / r->info.in.rate * r->info.in.period_size / op;
+	double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0, a, b, det, sig = 0, err = 0;
+
+	for (n = first; n < last; n++) {
+		double s = sin(w * n), c = cos(w * n), y = r->out[n * CHANNELS];
+
+		ss += s * s;
+		cc += c * c;
+		sc += s * c;
+		ys += y * s;
+		yc += y * c;
+	}
+	det = ss * cc - sc * sc;
+	a = (ys * cc - yc * sc) / det;
+	b = (yc * ss - ys * sc) / det;
+	for (n = first; n < last; n++) {
+		double fit = a * sin(w * n) + b * cos(w * n), e = r->out[n * CHANNELS] - fit;
+
+		sig += fit * fit;
+		err += e * e;
+	}
+	return 10 * log10(sig / (err + 1e-9));
+}
+
+static double measure_level(const struct run *r, double amp)
+{
+	unsigned int op = r->info.out.period_size, n;
+	double sum = 0;
+
+	for (n = SETTLE * op; n < PERIODS * op; n++)
+		sum += (double)r->out[n * CHANNELS] * r->out[n * CHANNELS];
+	return 10 * log10(sum / (PERIODS - SETTLE) / op / (amp * amp / 2) + 1e-20);
+}
+
+/* ---- checks ---- */
+
+#define NO_ALIAS	1.0	/* not a downsampling by more than 1.5 */
+
+static double snr[NRATIOS][NCONVERTERS][2];
+static double alias[NRATIOS][NCONVERTERS];
+
+static void measure(void)
+{
+	unsigned int i, k, t;
+	struct run r;
+
+	for (i = 0; i < NRATIOS; i++) {
+		const struct ratio *ratio = &ratios[i];
+		unsigned int low = ratio->in < ratio->out ? ratio->in : ratio->out;
+		double tones[2] = { 1000.0, 0.4 * low };
+
+		for (k = 0; k < NCONVERTERS; k++) {
+			for (t = 0; t < 2; t++) {
+				if (run_open(&r, &converters[k], ratio)) {
+					CHECK(0, "%s: open %u -> %u", converters[k].name, ratio->in, ratio->out);
+					continue;
+				}
+				fill_tone(&r, tones[t], 16384);
+				run_periods(&r);
+				snr[i][k][t] = measure_snr(&r, tones[t]);
+				run_close(&r);
+			}
+			alias[i][k] = NO_ALIAS;
+			if (ratio->in > ratio->out * 3 / 2 && !run_open(&r, &converters[k], ratio)) {
+				fill_tone(&r, 0.75 * ratio->out, 16384);
+				run_periods(&r);
+				alias[i][k] = measure_level(&r, 16384);
+				run_close(&r);
+			}
+		}
+	}
+}
+
+static void check_quality(void)
+{
+	static const double min_snr[3] = { 45, 60, 70 };
+	static const double max_alias[3] = { -40, -60, -75 };
+	unsigned int i, k, t;
+
+	for (i = 0; i < NRATIOS; i++) {
+		for (k = 0; k < NCONVERTERS; k++) {
+			int q = k - 2;
+
+			if (!converters[k].polyphase)
+				continue;
+			for (t = 0; t < 2; t++) {
+				CHECK(snr[i][k][t] >= min_snr[q], "%s %u -> %u: SNR %.1f dB, tone %u",
+				      converters[k].name, ratios[i].in, ratios[i].out, snr[i][k][t], t);
+				/* linear holds up at 1 kHz, the low quality need not beat it there */
+				CHECK(snr[i][k][t] > snr[i][0][t] || (q == 0 && t == 0),
+				      "%s %u -> %u: not above linear", converters[k].name,
+				      ratios[i].in, ratios[i].out);
+			}
+			CHECK(alias[i][k] == NO_ALIAS || alias[i][k] <= max_alias[q], "%s %u -> %u: aliasing %.1f dB",
+			      converters[k].name, ratios[i].in, ratios[i].out, alias[i][k]);
+		}
+	}
+}
+
+/* DC goes through, the same input gives the same output after a reset */
+static void check_state(void)
+{
+	unsigned int i, k, n, op, bad;
+	struct run r;
+	int16_t *first;
+
+	for (i = 0; i < NRATIOS; i++) {
+		for (k = 0; k < NCONVERTERS; k++) {
+			if (!converters[k].polyphase || run_open(&r, &converters[k], &ratios[i]))
+				continue;
+			op = r.info.out.period_size;
+			for (n = 0; n < PERIODS * PERIOD * CHANNELS; n++)
+				r.in[n] = n & 1 ? -12345 : 23456;
+			run_periods(&r);
+			bad = 0;
+			for (n = SETTLE * op * CHANNELS; n < PERIODS * op * CHANNELS; n++)
+				bad += abs(r.out[n] - (n & 1 ? -12345 : 23456)) > 1;
+			CHECK(!bad, "%s %u -> %u: %u samples off DC", converters[k].name,
+			      ratios[i].in, ratios[i].out, bad);
+
+			fill_tone(&r, 997, 30000);
+			r.ops.reset(r.obj);
+			run_periods(&r);
+			first = malloc(PERIODS * op * CHANNELS * sizeof(int16_t));
+			memcpy(first, r.out, PERIODS * op * CHANNELS * sizeof(int16_t));
+			r.ops.reset(r.obj);
+			run_periods(&r);
+			CHECK(!memcmp(first, r.out, PERIODS * op * CHANNELS * sizeof(int16_t)),
+			      "%s %u -> %u: differs after reset", converters[k].name,
+			      ratios[i].in, ratios[i].out);
+
+			/* a drained tail, shorter than a period */
+			r.ops.convert_s16(r.obj, r.out, r.ops.output_frames(r.obj, 100), r.in, 100);
+			free(first);
+			run_close(&r);
+		}
+	}
+}
+
+/* ---- benchmark ---- */
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static void bench(void)
+{
+	static const unsigned int which[] = { 0, 1, 5 };
+	unsigned int i, j, k, loops = 20;
+	struct run r;
+
+	printf("\nSNR in dB, 1 kHz / 0.4 of the lower rate, aliasing in dB:\n%-15s", "");
+	for (k = 0; k < NCONVERTERS; k++)
+		printf(" %16s", converters[k].name);
+	printf("\n");
+	for (i = 0; i < NRATIOS; i++) {
+		printf("%5u -> %5u  ", ratios[i].in, ratios[i].out);
+		for (k = 0; k < NCONVERTERS; k++)
+			printf("     %5.1f/%5.1f", snr[i][k][0], snr[i][k][1]);
+		printf("\n");
+		if (alias[i][0] != NO_ALIAS) {
+			printf("      aliasing ");
+			for (k = 0; k < NCONVERTERS; k++)
+				printf("           %5.1f", alias[i][k]);
+			printf("\n");
+		}
+	}
+
+	printf("\nper stereo output frame, ns (TSC cycles):\n");
+	for (j = 0; j < sizeof(which) / sizeof(which[0]); j++) {
+		i = which[j];
+		printf("%5u -> %5u  ", ratios[i].in, ratios[i].out);
+		for (k = 0; k < NCONVERTERS; k++) {
+			double t0, t1;
+			unsigned long long c0, c1;
+			unsigned int l;
+
+			if (run_open(&r, &converters[k], &ratios[i]))
+				continue;
+			fill_tone(&r, 1000, 16384);
+			t0 = now_ns();
+			c0 = cycles();
+			for (l = 0; l < loops; l++)
+				run_periods(&r);
+			c1 = cycles();
+			t1 = now_ns();
+			printf("   %6.1f (%5.0f)", (t1 - t0) / loops / PERIODS / r.info.out.period_size,
+			       (double)(c1 - c0) / loops / PERIODS / r.info.out.period_size);
+			run_close(&r);
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+	measure();
+	check_quality();
+	check_state();
+	if (!quiet)
+		bench();
+
+	printf("%s: %s\n", argv[0], failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
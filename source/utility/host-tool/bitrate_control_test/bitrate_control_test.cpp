@@ -0,0 +1,491 @@
+/*
+ * Host test and simulation harness for the rate control policy of
+ * DynamicBitRateControl, eyesee-mpp framework/media/recorder/BitRateController.cpp.
+ *
+ *   bitrate_control_test               run the checks and the simulation
+ *   bitrate_control_test -q            checks only
+ *   bitrate_control_test trace.txt     replay a frame size trace
+ *   bitrate_control_test -w trace.txt  write the built-in trace and exit
+ *
+ * A trace is a text file of one encoded frame a line, "<bytes> <key 0|1>",
+ * '#' starts a comment, "# fps N" sets its frame rate (30 by default). The
+ * sizes are taken as what the encoder gives at qp 30. The encoder model
+ * sets the qp from the mean size of the last second against the frame
+ * budget of the bitrate asked, clamped to the qp range, +6 qp halving the
+ * size, and drops frames down to the frame rate asked.
+ *
+ * The frames go to two sinks: the muxer cache in front of a SD card whose
+ * write speed collapses for a while, and the send buffer of a network
+ * stream whose bandwidth drops. A frame which does not fit is lost. The
+ * fixed bitrate, the former step policy of DynamicBitRateControl (1/2, 1/4
+ * of the bitrate at 50%, 80% of the muxer cache) and the controller are
+ * compared on the frames lost, the fill of the sinks and the bitrate kept.
+ * Everything is driven by the simulated clock, runs are deterministic.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <vector>
+
+#include <BitRateController.h>
+
+using namespace EyeseeLinux;
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static unsigned int rnd_state = 1;
+
+static unsigned int rnd(unsigned int n)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state % n;
+}
+
+struct TraceFrame
+{
+    unsigned int size;
+    bool key;
+};
+
+struct Trace
+{
+    int fps;
+    std::vector<TraceFrame> frames;
+};
+
+#define BIT_RATE    (6*1000*1000)
+#define FRAME_RATE  (30)
+#define MIN_QP      (10)
+#define MAX_QP      (40)
+#define REF_QP      (30)
+
+/* 100s of 6Mbps 30fps, gop 30 with key frames 6 times a P frame, the
+ * complexity drifting and doubled for 5s at scene changes. */
+static void make_trace(Trace &trace)
+{
+    double complexity = 1.0;
+    int i, n = 100 * FRAME_RATE;
+
+    rnd_state = 12345;
+    trace.fps = FRAME_RATE;
+    trace.frames.clear();
+    for (i = 0; i < n; i++)
+    {
+        double p = (double)BIT_RATE / 8 / FRAME_RATE * 30 / 35;
+        double scene = (i % (15 * FRAME_RATE)) < 5 * FRAME_RATE && i > FRAME_RATE ? 1.6 : 0.8;
+        TraceFrame f;
+
+        complexity *= exp(((int)rnd(2001) - 1000) / 20000.0);
+        complexity = complexity < 0.5 ? 0.5 : (complexity > 2.0 ? 2.0 : complexity);
+        f.key = i % 30 == 0;
+        f.size = (unsigned int)(p * complexity * scene * (f.key ? 6 : 1) * (0.8 + rnd(400) / 1000.0));
+        trace.frames.push_back(f);
+    }
+}
+
+static int write_trace(const Trace &trace, const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    size_t i;
+
+    if (fp == NULL)
+    {
+        printf("can not create %s\n", path);
+        return -1;
+    }
+    fprintf(fp, "# fps %d\n", trace.fps);
+    for (i = 0; i < trace.frames.size(); i++)
+    {
+        fprintf(fp, "%u %d\n", trace.frames[i].size, trace.frames[i].key ? 1 : 0);
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int read_trace(Trace &trace, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[256];
+    int fps;
+
+    if (fp == NULL)
+    {
+        printf("can not open %s\n", path);
+        return -1;
+    }
+    trace.fps = FRAME_RATE;
+    trace.frames.clear();
+    while (fgets(line, sizeof(line), fp))
+    {
+        unsigned int size;
+        int key = 0;
+        TraceFrame f;
+
+        if (line[0] == '#')
+        {
+            if (sscanf(line, "# fps %d", &fps) == 1 && fps > 0)
+            {
+                trace.fps = fps;
+            }
+            continue;
+        }
+        if (sscanf(line, "%u %d", &size, &key) < 1)
+        {
+            continue;
+        }
+        f.size = size;
+        f.key = key != 0;
+        trace.frames.push_back(f);
+    }
+    fclose(fp);
+    return trace.frames.empty() ? -1 : 0;
+}
+
+enum Policy
+{
+    POLICY_FIXED,
+    POLICY_STEP,
+    POLICY_CONTROLLER,
+};
+
+struct Sink
+{
+    double capacity;
+    double backlog;
+    double maxBacklog;
+    int lost;
+};
+
+struct Result
+{
+    int frames;
+    int lost[BitRateController::SINK_NUM];
+    int maxFill[BitRateController::SINK_NUM];
+    double meanMbps;        /* encoded */
+    double meanQp;
+    int minFps;
+    int changes;
+};
+
+/* write speed of the card, bytes a second */
+static double storage_speed(double t)
+{
+    return t >= 20 && t < 40 ? 0.25e6 : 2.5e6;
+}
+
+/* bandwidth of the network stream, bytes a second */
+static double network_speed(double t)
+{
+    if (t >= 45 && t < 65)
+    {
+        return 1.5e6 / 8;
+    }
+    if (t >= 65 && t < 80)
+    {
+        return 3e6 / 8;
+    }
+    return 8e6 / 8;
+}
+
+static void simulate(const Trace &trace, Policy policy, Result &r)
+{
+    BitRateController::Config config;
+    BitRateController::getDefaultConfig(config, BIT_RATE, trace.fps, MIN_QP, MAX_QP);
+    BitRateController brc(config);
+    BitRateController::Decision d = brc.getDecision();
+    Sink sinks[BitRateController::SINK_NUM] = { { 8e6, 0, 0, 0 }, { 512e3, 0, 0, 0 } };
+    double avgComplexity = 0, fpsAcc = 0, qpSum = 0, bytes = 0;
+    int64_t frameUs = 1000000 / trace.fps, nextUpdateUs = 0;
+    size_t i;
+    int s;
+
+    memset(&r, 0, sizeof(r));
+    r.minFps = d.mFrameRate;
+    for (i = 0; i < trace.frames.size(); i++)
+    {
+        int64_t nowUs = (int64_t)i * frameUs;
+        double t = nowUs / 1e6;
+        const TraceFrame &f = trace.frames[i];
+
+        /* the sinks drain for a frame interval */
+        sinks[0].backlog -= storage_speed(t) / trace.fps;
+        sinks[1].backlog -= network_speed(t) / trace.fps;
+        for (s = 0; s < BitRateController::SINK_NUM; s++)
+        {
+            sinks[s].backlog = sinks[s].backlog < 0 ? 0 : sinks[s].backlog;
+        }
+
+        if (nowUs >= nextUpdateUs)
+        {
+            nextUpdateUs += 250 * 1000;
+            if (policy == POLICY_CONTROLLER)
+            {
+                for (s = 0; s < BitRateController::SINK_NUM; s++)
+                {
+                    brc.onSinkState((BitRateController::SinkType)s, (unsigned int)sinks[s].backlog,
+                                    (unsigned int)sinks[s].capacity);
+                }
+                if (brc.update(nowUs, d))
+                {
+                    r.changes++;
+                }
+            }
+            else if (policy == POLICY_STEP)
+            {
+                int fill = (int)(sinks[0].backlog * 100 / sinks[0].capacity);
+                int bitRate = fill >= 80 ? BIT_RATE / 4 : (fill >= 50 ? BIT_RATE / 2 : BIT_RATE);
+                if (bitRate != d.mBitRate)
+                {
+                    d.mBitRate = bitRate;
+                    r.changes++;
+                }
+            }
+        }
+
+        /* frames over the frame rate asked are dropped before the encoder */
+        avgComplexity = avgComplexity > 0 ? 0.97 * avgComplexity + 0.03 * f.size : f.size;
+        fpsAcc += d.mFrameRate;
+        if (fpsAcc < trace.fps && !f.key)
+        {
+            continue;
+        }
+        fpsAcc -= trace.fps;
+        if (fpsAcc < 0)
+        {
+            fpsAcc = 0;
+        }
+
+        /* the qp follows the mean complexity, not the frame itself */
+        double budget = (double)d.mBitRate / 8 / d.mFrameRate;
+        double qp = REF_QP + 6 * log2(avgComplexity / budget);
+        qp = qp < d.mMinQp ? d.mMinQp : (qp > d.mMaxQp ? d.mMaxQp : qp);
+        double size = f.size * pow(2, -(qp - REF_QP) / 6);
+
+        r.frames++;
+        qpSum += qp;
+        bytes += size;
+        if (r.minFps > d.mFrameRate)
+        {
+            r.minFps = d.mFrameRate;
+        }
+        if (policy == POLICY_CONTROLLER)
+        {
+            brc.onEncodedFrame(nowUs, (unsigned int)size, f.key);
+        }
+        for (s = 0; s < BitRateController::SINK_NUM; s++)
+        {
+            if (sinks[s].backlog + size > sinks[s].capacity)
+            {
+                sinks[s].lost++;
+                continue;
+            }
+            sinks[s].backlog += size;
+            if (sinks[s].backlog > sinks[s].maxBacklog)
+            {
+                sinks[s].maxBacklog = sinks[s].backlog;
+            }
+        }
+    }
+    for (s = 0; s < BitRateController::SINK_NUM; s++)
+    {
+        r.lost[s] = sinks[s].lost;
+        r.maxFill[s] = (int)(sinks[s].maxBacklog * 100 / sinks[s].capacity);
+    }
+    r.meanMbps = bytes * 8 / (trace.frames.size() / (double)trace.fps) / 1e6;
+    r.meanQp = r.frames ? qpSum / r.frames : 0;
+}
+
+static void print_result(const char *name, const Result &r)
+{
+    printf("%-11s %5d frames  lost card %4d net %4d  max fill card %3d%% net %3d%%"
+           "  %5.2f Mbps  qp %4.1f  min fps %2d  %4d changes\n",
+           name, r.frames, r.lost[0], r.lost[1], r.maxFill[0], r.maxFill[1],
+           r.meanMbps, r.meanQp, r.minFps, r.changes);
+}
+
+static void test_no_sink(void)
+{
+    BitRateController::Config config;
+    BitRateController::getDefaultConfig(config, BIT_RATE, FRAME_RATE, MIN_QP, MAX_QP);
+    BitRateController brc(config);
+    BitRateController::Decision d;
+    int64_t t;
+    bool changed = false;
+
+    for (t = 0; t < 10 * 1000 * 1000; t += 250 * 1000)
+    {
+        int k;
+        for (k = 0; k < 7; k++)
+        {
+            brc.onEncodedFrame(t, BIT_RATE / 8 / FRAME_RATE, k == 0);
+        }
+        changed |= brc.update(t, d);
+    }
+    CHECK(!changed && d.mBitRate == BIT_RATE && d.mMaxQp == MAX_QP && d.mFrameRate == FRAME_RATE,
+          "nothing limits, nothing changes: %d %d %d", d.mBitRate, d.mMaxQp, d.mFrameRate);
+}
+
+/* one sink draining drainBps, the encoder giving what it is asked but not
+ * less than 1.5Mbps at 30fps and qp 40 */
+static void run_sink(BitRateController &brc, double &backlog, double capacity,
+                     double drainBps, int64_t &t, int64_t untilUs)
+{
+    BitRateController::Decision d = brc.getDecision();
+    for (; t < untilUs; t += 250 * 1000)
+    {
+        double floorBps = 1.5e6 / pow(2, (d.mMaxQp - MAX_QP) / 6.0) * d.mFrameRate / FRAME_RATE;
+        double in = (d.mBitRate > floorBps ? d.mBitRate : floorBps) / 8 / 4;
+        brc.onEncodedFrame(t, (unsigned int)in, false);
+        backlog += in - drainBps / 8 / 4;
+        backlog = backlog < 0 ? 0 : (backlog > capacity ? capacity : backlog);
+        brc.onSinkState(BitRateController::SINK_NETWORK, (unsigned int)backlog, (unsigned int)capacity);
+        brc.update(t, d);
+    }
+}
+
+static void test_follow_drain(void)
+{
+    BitRateController::Config config;
+    BitRateController::getDefaultConfig(config, BIT_RATE, FRAME_RATE, MIN_QP, MAX_QP);
+    BitRateController brc(config);
+    BitRateController::Stats stats;
+    double backlog = 0;
+    int64_t t = 0;
+    int bitRate;
+
+    /* the link drops to 2Mbps, the bitrate follows within a few seconds */
+    run_sink(brc, backlog, 1e6, 2e6, t, 10 * 1000 * 1000);
+    bitRate = brc.getDecision().mBitRate;
+    brc.getStats(stats);
+    CHECK(bitRate > 1.6e6 && bitRate < 2.4e6, "follows the drain, %d", bitRate);
+    CHECK(stats.mDrainBitRate[BitRateController::SINK_NETWORK] > 1.8e6
+          && stats.mDrainBitRate[BitRateController::SINK_NETWORK] < 2.2e6,
+          "drain estimate %d", stats.mDrainBitRate[BitRateController::SINK_NETWORK]);
+    CHECK(backlog < 1e6 * 0.5, "backlog kept, %f", backlog);
+
+    /* the link comes back, the bitrate ramps up by 10% a second at most */
+    run_sink(brc, backlog, 1e6, 20e6, t, 11 * 1000 * 1000);
+    CHECK(brc.getDecision().mBitRate <= bitRate * 1.12, "ramp up, %d -> %d",
+          bitRate, brc.getDecision().mBitRate);
+    run_sink(brc, backlog, 1e6, 20e6, t, 40 * 1000 * 1000);
+    CHECK(brc.getDecision().mBitRate == BIT_RATE, "back to the max, %d", brc.getDecision().mBitRate);
+}
+
+static void test_floor(void)
+{
+    BitRateController::Config config;
+    BitRateController::getDefaultConfig(config, BIT_RATE, FRAME_RATE, MIN_QP, MAX_QP);
+    BitRateController brc(config);
+    BitRateController::Decision d;
+    double backlog = 0;
+    int64_t t = 0;
+
+    /* a quarter of the min bitrate: qp up to the ceiling, then fewer frames */
+    run_sink(brc, backlog, 1e6, config.mMinBitRate / 4.0, t, 30 * 1000 * 1000);
+    d = brc.getDecision();
+    CHECK(d.mBitRate == config.mMinBitRate, "at the floor, %d", d.mBitRate);
+    CHECK(d.mMaxQp == config.mMaxQpCeiling, "max qp raised, %d", d.mMaxQp);
+    CHECK(d.mMinQp > MIN_QP && d.mMinQp <= d.mMaxQp, "min qp follows, %d", d.mMinQp);
+    CHECK(d.mFrameRate < FRAME_RATE && d.mFrameRate >= config.mMinFrameRate, "frame rate lowered, %d",
+          d.mFrameRate);
+
+    /* drained: all comes back */
+    run_sink(brc, backlog, 1e6, 50e6, t, 120 * 1000 * 1000);
+    d = brc.getDecision();
+    CHECK(d.mBitRate == BIT_RATE && d.mMaxQp == MAX_QP && d.mMinQp == MIN_QP && d.mFrameRate == FRAME_RATE,
+          "restored, %d [%d,%d] %d", d.mBitRate, d.mMinQp, d.mMaxQp, d.mFrameRate);
+}
+
+static void test_simulation(const Trace &trace, bool print)
+{
+    Result fixed, step, ctrl, again;
+
+    simulate(trace, POLICY_FIXED, fixed);
+    simulate(trace, POLICY_STEP, step);
+    simulate(trace, POLICY_CONTROLLER, ctrl);
+    simulate(trace, POLICY_CONTROLLER, again);
+    if (print)
+    {
+        print_result("fixed", fixed);
+        print_result("step", step);
+        print_result("controller", ctrl);
+    }
+    CHECK(!memcmp(&ctrl, &again, sizeof(ctrl)), "deterministic");
+    CHECK(fixed.lost[0] > 0 && fixed.lost[1] > 0, "the trace overflows the sinks");
+    CHECK(ctrl.lost[0] == 0 && ctrl.lost[1] == 0, "controller loses no frame, %d %d",
+          ctrl.lost[0], ctrl.lost[1]);
+    CHECK(ctrl.meanMbps > fixed.meanMbps * 0.5, "controller keeps the bitrate, %.2f", ctrl.meanMbps);
+}
+
+int main(int argc, char **argv)
+{
+    bool quiet = argc > 1 && !strcmp(argv[1], "-q");
+    Trace trace;
+
+    if (argc > 2 && !strcmp(argv[1], "-w"))
+    {
+        make_trace(trace);
+        return write_trace(trace, argv[2]) ? 1 : 0;
+    }
+    if (argc > 1 && argv[1][0] != '-')
+    {
+        Result fixed, step, ctrl;
+        if (read_trace(trace, argv[1]))
+        {
+            return 1;
+        }
+        printf("%s: %d frames at %d fps\n", argv[1], (int)trace.frames.size(), trace.fps);
+        simulate(trace, POLICY_FIXED, fixed);
+        simulate(trace, POLICY_STEP, step);
+        simulate(trace, POLICY_CONTROLLER, ctrl);
+        print_result("fixed", fixed);
+        print_result("step", step);
+        print_result("controller", ctrl);
+        return 0;
+    }
+
+    test_no_sink();
+    test_follow_drain();
+    test_floor();
+
+    make_trace(trace);
+    test_simulation(trace, false);
+
+    /* a written trace replays the same */
+    {
+        Trace replay;
+        Result a, b;
+        CHECK(write_trace(trace, "builtin.trace") == 0 && read_trace(replay, "builtin.trace") == 0,
+              "trace file");
+        simulate(trace, POLICY_CONTROLLER, a);
+        simulate(replay, POLICY_CONTROLLER, b);
+        CHECK(!memcmp(&a, &b, sizeof(a)), "replay");
+        remove("builtin.trace");
+    }
+
+    printf("bitrate_control_test: %s\n", failures ? "FAILED" : "ok");
+    if (failures)
+    {
+        return 1;
+    }
+    if (!quiet)
+    {
+        printf("\n100s 6Mbps 30fps trace, card of 8MB cache at 20Mbps dropping to 2Mbps for 20s,\n"
+               "network of 512KB send buffer at 8Mbps dropping to 1.5Mbps for 20s then 3Mbps for 15s\n");
+        test_simulation(trace, true);
+    }
+    return 0;
+}
@@ -0,0 +1,535 @@
+/*
+ * Host test and benchmark for the AES job queue of the CE driver,
+ * ekernel/drivers/hal/source/ce/hal_ce_queue.c, and its software reference
+ * engine, ce_aes_soft.c.
+ *
+ *   ce_queue_test            run the checks and the benchmark
+ *   ce_queue_test -q         checks only
+ *
+ * The cipher is checked against the FIPS-197 and SP 800-38A vectors. The
+ * queue runs on the software engine both with completions inside submit
+ * (inline) and with completions only on poll (deferred, the way the CE
+ * behaves); checked are data and chaining values against direct software
+ * runs, FIFO order of the callbacks, the batch size, resubmission from the
+ * callback and parameter checks. The benchmark compares one job per
+ * submission with full batches and with the bare software cipher.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <rtthread.h>
+#include <sunxi_drv_crypto.h>
+
+#define NR_JOB          64
+#define MAX_LEN         (64 * AES_BLOCK_SIZE)
+#define ROUNDS          50
+#define BENCH_SIZE      (1024 * 1024)
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+/* semaphore stub, a take with nothing released polls the deferred engine */
+rt_err_t rt_sem_init(struct rt_semaphore *sem, const char *name, rt_uint32_t value, rt_uint8_t flag)
+{
+    (void)name;
+    (void)flag;
+    sem->count = value;
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_detach(struct rt_semaphore *sem)
+{
+    (void)sem;
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_take(struct rt_semaphore *sem, rt_int32_t time)
+{
+    (void)time;
+    while (sem->count == 0)
+    {
+        if (!crypto_aes_soft_poll())
+        {
+            printf("FAIL: wait with nothing in flight\n");
+            exit(1);
+        }
+    }
+    sem->count--;
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_release(struct rt_semaphore *sem)
+{
+    sem->count++;
+    return RT_EOK;
+}
+
+static void unhex(const char *s, rt_uint8_t *out)
+{
+    unsigned int b;
+
+    while (*s)
+    {
+        sscanf(s, "%2x", &b);
+        *out++ = (rt_uint8_t)b;
+        s += 2;
+    }
+}
+
+static const struct
+{
+    const char *key, *pt, *ct;
+} ecb_vectors[] =
+{
+    /* FIPS-197 appendix C */
+    { "000102030405060708090a0b0c0d0e0f",
+      "00112233445566778899aabbccddeeff", "69c4e0d86a7b0430d8cdb78070b4c55a" },
+    { "000102030405060708090a0b0c0d0e0f1011121314151617",
+      "00112233445566778899aabbccddeeff", "dda97ca4864cdfe06eaf70a0ec0d7191" },
+    { "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+      "00112233445566778899aabbccddeeff", "8ea2b7ca516745bfeafc49904b496089" },
+};
+
+/* SP 800-38A F.2.1 and F.2.5, CBC-AES128 and CBC-AES256 */
+static const struct
+{
+    const char *key, *iv, *pt, *ct;
+} cbc_vectors[] =
+{
+    { "2b7e151628aed2a6abf7158809cf4f3c", "000102030405060708090a0b0c0d0e0f",
+      "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+      "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710",
+      "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+      "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7" },
+    { "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+      "000102030405060708090a0b0c0d0e0f",
+      "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+      "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710",
+      "f58c4c04d6e5f1ba779eabfb5f7bfbd69cfc4e967edb808d679f777bc6702c7d"
+      "39f23369a9d9bacfa530e26304231461b2eb05e2c39be9fcda6c19078c6a9d1b" },
+};
+
+static void check_vectors(void)
+{
+    crypto_aes_job_t job;
+    rt_uint8_t key[32], pt[64], ct[64], iv[16], out[64];
+    unsigned int i, klen, len;
+
+    for (i = 0; i < sizeof(ecb_vectors) / sizeof(ecb_vectors[0]); i++)
+    {
+        klen = strlen(ecb_vectors[i].key) / 2;
+        unhex(ecb_vectors[i].key, key);
+        unhex(ecb_vectors[i].pt, pt);
+        unhex(ecb_vectors[i].ct, ct);
+
+        memset(&job, 0, sizeof(job));
+        job.src = pt;
+        job.dst = out;
+        job.length = AES_BLOCK_SIZE;
+        job.key = key;
+        job.key_length = klen;
+        job.mode = AES_MODE_ECB;
+        job.dir = CRYPTO_DIR_ENCRYPT;
+        CHECK(crypto_aes_soft_crypt(&job) == RT_EOK && !memcmp(out, ct, 16), "ecb encrypt aes-%u", klen * 8);
+
+        job.src = ct;
+        job.dir = CRYPTO_DIR_DECRYPT;
+        CHECK(crypto_aes_soft_crypt(&job) == RT_EOK && !memcmp(out, pt, 16), "ecb decrypt aes-%u", klen * 8);
+    }
+
+    for (i = 0; i < sizeof(cbc_vectors) / sizeof(cbc_vectors[0]); i++)
+    {
+        klen = strlen(cbc_vectors[i].key) / 2;
+        len = strlen(cbc_vectors[i].pt) / 2;
+        unhex(cbc_vectors[i].key, key);
+        unhex(cbc_vectors[i].pt, pt);
+        unhex(cbc_vectors[i].ct, ct);
+
+        memset(&job, 0, sizeof(job));
+        unhex(cbc_vectors[i].iv, iv);
+        job.src = pt;
+        job.dst = out;
+        job.length = len;
+        job.key = key;
+        job.key_length = klen;
+        job.iv = iv;
+        job.mode = AES_MODE_CBC;
+        job.dir = CRYPTO_DIR_ENCRYPT;
+        CHECK(crypto_aes_soft_crypt(&job) == RT_EOK && !memcmp(out, ct, len), "cbc encrypt aes-%u", klen * 8);
+        CHECK(!memcmp(iv, ct + len - 16, 16), "cbc encrypt iv aes-%u", klen * 8);
+
+        /* in place, the chaining value must come from the ciphertext */
+        unhex(cbc_vectors[i].iv, iv);
+        memcpy(out, ct, len);
+        job.src = out;
+        job.dir = CRYPTO_DIR_DECRYPT;
+        CHECK(crypto_aes_soft_crypt(&job) == RT_EOK && !memcmp(out, pt, len), "cbc decrypt aes-%u", klen * 8);
+        CHECK(!memcmp(iv, ct + len - 16, 16), "cbc decrypt iv aes-%u", klen * 8);
+    }
+}
+
+struct test_job
+{
+    crypto_aes_job_t job;
+    rt_uint8_t key[32];
+    rt_uint8_t iv[16];
+    rt_uint8_t ref_iv[16];
+    rt_uint8_t src[MAX_LEN] __attribute__((aligned(4)));
+    rt_uint8_t dst[MAX_LEN] __attribute__((aligned(4)));
+    rt_uint8_t ref[MAX_LEN];
+    int id;
+    int status;
+    int done;
+};
+
+static struct test_job jobs[NR_JOB];
+static int order[NR_JOB];
+static int nr_done;
+
+static void job_done(crypto_aes_job_t *job, int status)
+{
+    struct test_job *t = job->priv;
+
+    t->status = status;
+    t->done++;
+    if (nr_done < NR_JOB)
+    {
+        order[nr_done] = t->id;
+    }
+    nr_done++;
+}
+
+static void job_fill(struct test_job *t, int id)
+{
+    static const rt_uint32_t key_lengths[] = { 16, 24, 32 };
+    crypto_aes_job_t ref;
+    rt_uint32_t i;
+
+    memset(&t->job, 0, sizeof(t->job));
+    t->id = id;
+    t->done = 0;
+    t->status = 1;
+    t->job.length = (1 + rand() % (MAX_LEN / AES_BLOCK_SIZE)) * AES_BLOCK_SIZE;
+    t->job.key_length = key_lengths[rand() % 3];
+    t->job.mode = rand() & 1 ? AES_MODE_CBC : AES_MODE_ECB;
+    t->job.dir = rand() & 1 ? CRYPTO_DIR_DECRYPT : CRYPTO_DIR_ENCRYPT;
+    for (i = 0; i < t->job.key_length; i++)
+    {
+        t->key[i] = (rt_uint8_t)rand();
+    }
+    for (i = 0; i < 16; i++)
+    {
+        t->iv[i] = (rt_uint8_t)rand();
+    }
+    for (i = 0; i < t->job.length; i++)
+    {
+        t->src[i] = (rt_uint8_t)rand();
+    }
+    memset(t->dst, 0, sizeof(t->dst));
+
+    /* reference result from a direct software run */
+    memcpy(t->ref_iv, t->iv, 16);
+    ref = t->job;
+    ref.src = t->src;
+    ref.dst = t->ref;
+    ref.key = t->key;
+    ref.iv = t->ref_iv;
+    crypto_aes_soft_crypt(&ref);
+
+    /* decrypt in place now and then */
+    t->job.src = (t->job.dir == CRYPTO_DIR_DECRYPT && rand() % 4 == 0) ? t->dst : t->src;
+    if (t->job.src == t->dst)
+    {
+        memcpy(t->dst, t->src, t->job.length);
+    }
+    t->job.dst = t->dst;
+    t->job.key = t->key;
+    t->job.iv = t->iv;
+    t->job.done = job_done;
+    t->job.priv = t;
+}
+
+static int job_ok(const struct test_job *t)
+{
+    if (memcmp(t->dst, t->ref, t->job.length))
+    {
+        return 0;
+    }
+    return t->job.mode != AES_MODE_CBC || !memcmp(t->iv, t->ref_iv, 16);
+}
+
+static void test_fifo(int deferred)
+{
+    int i, n, polled, max_batch = 0;
+
+    CHECK(crypto_aes_soft_init(deferred) == RT_EOK, "init soft engine");
+    nr_done = 0;
+    n = 1 + rand() % NR_JOB;
+    for (i = 0; i < n; i++)
+    {
+        job_fill(&jobs[i], i);
+        CHECK(crypto_aes_job_submit(&jobs[i].job) == RT_EOK, "submit %d", i);
+    }
+    if (deferred)
+    {
+        CHECK(nr_done == 0, "deferred engine completed inside submit");
+        while ((polled = crypto_aes_soft_poll()) > 0)
+        {
+            if (polled > max_batch)
+            {
+                max_batch = polled;
+            }
+        }
+        /* the first job starts alone, the rest queue up behind it */
+        CHECK(max_batch == (n == 1 ? 1 : n - 1 < CE_JOB_BATCH_MAX ? n - 1 : CE_JOB_BATCH_MAX),
+              "batch size %d for %d jobs", max_batch, n);
+    }
+
+    CHECK(nr_done == n, "%d of %d jobs completed", nr_done, n);
+    for (i = 0; i < n; i++)
+    {
+        CHECK(jobs[i].done == 1 && jobs[i].status == RT_EOK, "job %d done %d status %d",
+              i, jobs[i].done, jobs[i].status);
+        CHECK(job_ok(&jobs[i]), "job %d data (len %u, key %u, mode %u, dir %u)", i,
+              jobs[i].job.length, jobs[i].job.key_length, jobs[i].job.mode, jobs[i].job.dir);
+        CHECK(order[i] == i, "callback %d was job %d", i, order[i]);
+    }
+}
+
+/* a stream of CBC records, each resubmitted from the previous callback */
+static struct
+{
+    crypto_aes_job_t job;
+    rt_uint8_t key[16];
+    rt_uint8_t iv[16];
+    rt_uint8_t buf[NR_JOB * 64] __attribute__((aligned(4)));
+    int next;
+} stream;
+
+static void stream_done(crypto_aes_job_t *job, int status)
+{
+    CHECK(status == RT_EOK, "stream record %d status %d", stream.next, status);
+    if (++stream.next < NR_JOB)
+    {
+        job->src = stream.buf + stream.next * 64;
+        job->dst = stream.buf + stream.next * 64;
+        CHECK(crypto_aes_job_submit(job) == RT_EOK, "resubmit record %d", stream.next);
+    }
+}
+
+static void test_resubmit(int deferred)
+{
+    rt_uint8_t plain[sizeof(stream.buf)], iv[16];
+    crypto_aes_job_t whole;
+    unsigned int i;
+
+    CHECK(crypto_aes_soft_init(deferred) == RT_EOK, "init soft engine");
+    for (i = 0; i < sizeof(plain); i++)
+    {
+        plain[i] = (rt_uint8_t)rand();
+    }
+    for (i = 0; i < 16; i++)
+    {
+        stream.key[i] = (rt_uint8_t)rand();
+        stream.iv[i] = iv[i] = (rt_uint8_t)rand();
+    }
+    memcpy(stream.buf, plain, sizeof(plain));
+    stream.next = 0;
+
+    memset(&stream.job, 0, sizeof(stream.job));
+    stream.job.src = stream.buf;
+    stream.job.dst = stream.buf;
+    stream.job.length = 64;
+    stream.job.key = stream.key;
+    stream.job.key_length = 16;
+    stream.job.iv = stream.iv;
+    stream.job.mode = AES_MODE_CBC;
+    stream.job.dir = CRYPTO_DIR_ENCRYPT;
+    stream.job.done = stream_done;
+    CHECK(crypto_aes_job_submit(&stream.job) == RT_EOK, "submit stream");
+    while (crypto_aes_soft_poll())
+        ;
+    CHECK(stream.next == NR_JOB, "stream stopped at record %d", stream.next);
+
+    /* the records chain like one buffer */
+    memset(&whole, 0, sizeof(whole));
+    whole.src = stream.buf;
+    whole.dst = stream.buf;
+    whole.length = sizeof(stream.buf);
+    whole.key = stream.key;
+    whole.key_length = 16;
+    whole.iv = iv;
+    whole.mode = AES_MODE_CBC;
+    whole.dir = CRYPTO_DIR_DECRYPT;
+    CHECK(crypto_aes_soft_crypt(&whole) == RT_EOK && !memcmp(stream.buf, plain, sizeof(plain)),
+          "stream decrypts as one buffer");
+    CHECK(!memcmp(iv, stream.iv, 16), "stream chaining value");
+}
+
+static void test_blocking_deferred(void)
+{
+    int r;
+
+    CHECK(crypto_aes_soft_init(1) == RT_EOK, "init soft engine");
+    for (r = 0; r < ROUNDS; r++)
+    {
+        job_fill(&jobs[0], 0);
+        CHECK(crypto_aes_job_run(&jobs[0].job) == RT_EOK && job_ok(&jobs[0]), "blocking run %d", r);
+    }
+    CHECK(crypto_aes_soft_poll() == 0, "blocking run left work behind");
+}
+
+static void test_params(void)
+{
+    struct test_job *t = &jobs[0];
+
+    CHECK(crypto_aes_engine_register(NULL) == RT_EOK, "unregister");
+    job_fill(t, 0);
+    CHECK(crypto_aes_job_submit(&t->job) == -RT_ERROR, "submit without engine");
+    CHECK(crypto_aes_soft_init(0) == RT_EOK, "init soft engine");
+
+    job_fill(t, 0);
+    CHECK(crypto_aes_job_submit(NULL) == -RT_EINVAL, "NULL job");
+    t->job.length = 15;
+    CHECK(crypto_aes_job_submit(&t->job) == -RT_EINVAL, "partial block");
+    t->job.length = 0;
+    CHECK(crypto_aes_job_submit(&t->job) == -RT_EINVAL, "zero length");
+    t->job.length = 16;
+    t->job.key_length = 20;
+    CHECK(crypto_aes_job_submit(&t->job) == -RT_EINVAL, "key length");
+    t->job.key_length = 16;
+    t->job.dst = t->dst + 1;
+    CHECK(crypto_aes_job_submit(&t->job) == -RT_EINVAL, "unaligned dst");
+    t->job.dst = t->dst;
+    t->job.mode = AES_MODE_CBC;
+    t->job.iv = NULL;
+    CHECK(crypto_aes_job_submit(&t->job) == -RT_EINVAL, "cbc without iv");
+    t->job.mode = 7;
+    CHECK(crypto_aes_job_submit(&t->job) == -RT_EINVAL, "unknown mode");
+    CHECK(t->done == 0, "rejected job completed");
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_done(crypto_aes_job_t *job, int status)
+{
+    (void)job;
+    (void)status;
+}
+
+static void bench(void)
+{
+    static const rt_uint32_t records[] = { 64, 256, 1024, 16384 };
+    static crypto_aes_job_t job[CE_JOB_BATCH_MAX];
+    rt_uint8_t *buf = malloc(BENCH_SIZE);
+    rt_uint8_t key[16] = { 0 }, iv[16] = { 0 };
+    rt_uint32_t r, off, len;
+    double t0, single, batch, bare;
+    int i;
+
+    if (!buf)
+    {
+        return;
+    }
+    memset(buf, 0x5a, BENCH_SIZE);
+    crypto_aes_soft_init(0);
+
+    printf("benchmark, %d KB of aes-128-cbc encrypt on the software engine:\n", BENCH_SIZE / 1024);
+    printf("  %-8s %12s %12s %12s\n", "record", "job_run", "batched", "bare");
+    for (r = 0; r < sizeof(records) / sizeof(records[0]); r++)
+    {
+        len = records[r];
+        for (i = 0; i < CE_JOB_BATCH_MAX; i++)
+        {
+            memset(&job[i], 0, sizeof(job[i]));
+            job[i].length = len;
+            job[i].key = key;
+            job[i].key_length = 16;
+            job[i].iv = iv;
+            job[i].mode = AES_MODE_CBC;
+            job[i].dir = CRYPTO_DIR_ENCRYPT;
+            job[i].done = bench_done;
+        }
+
+        t0 = now_sec();
+        for (off = 0; off < BENCH_SIZE; off += len)
+        {
+            job[0].src = job[0].dst = buf + off;
+            crypto_aes_job_run(&job[0]);
+        }
+        single = BENCH_SIZE / (now_sec() - t0) / 1e6;
+
+        crypto_aes_soft_init(1);
+        t0 = now_sec();
+        for (off = 0; off < BENCH_SIZE; )
+        {
+            for (i = 0; i < CE_JOB_BATCH_MAX && off < BENCH_SIZE; i++, off += len)
+            {
+                job[i].src = job[i].dst = buf + off;
+                job[i].done = bench_done;
+                crypto_aes_job_submit(&job[i]);
+            }
+            while (crypto_aes_soft_poll())
+                ;
+        }
+        batch = BENCH_SIZE / (now_sec() - t0) / 1e6;
+        crypto_aes_soft_init(0);
+
+        t0 = now_sec();
+        for (off = 0; off < BENCH_SIZE; off += len)
+        {
+            job[0].src = job[0].dst = buf + off;
+            crypto_aes_soft_crypt(&job[0]);
+        }
+        bare = BENCH_SIZE / (now_sec() - t0) / 1e6;
+
+        printf("  %-8u %7.1f MB/s %7.1f MB/s %7.1f MB/s\n", len, single, batch, bare);
+    }
+    free(buf);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+    int r;
+
+    srand(0xce);
+    check_vectors();
+    test_params();
+    for (r = 0; r < ROUNDS && failures < 20; r++)
+    {
+        test_fifo(0);
+        test_fifo(1);
+    }
+    test_resubmit(0);
+    test_resubmit(1);
+    test_blocking_deferred();
+
+    printf("ce job queue: %s\n", failures ? "FAILED" : "ok");
+    if (failures)
+    {
+        return 1;
+    }
+    if (!quiet)
+    {
+        bench();
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+/* host stub: the types and the semaphore of rt-thread the ce queue uses */
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+#include <stdint.h>
+
+typedef int8_t rt_int8_t;
+typedef int16_t rt_int16_t;
+typedef int32_t rt_int32_t;
+typedef uint8_t rt_uint8_t;
+typedef uint16_t rt_uint16_t;
+typedef uint32_t rt_uint32_t;
+typedef long rt_base_t;
+typedef unsigned long rt_ubase_t;
+typedef rt_base_t rt_err_t;
+
+#define RT_NULL             0
+#define RT_EOK              0
+#define RT_ERROR            1
+#define RT_ETIMEOUT         2
+#define RT_EFULL            3
+#define RT_EEMPTY           4
+#define RT_ENOMEM           5
+#define RT_ENOSYS           6
+#define RT_EBUSY            7
+#define RT_EIO              8
+#define RT_EINTR            9
+#define RT_EINVAL           10
+
+#define RT_WAITING_FOREVER  -1
+#define RT_IPC_FLAG_FIFO    0x00
+
+struct rt_semaphore
+{
+    int count;
+};
+
+rt_err_t rt_sem_init(struct rt_semaphore *sem, const char *name, rt_uint32_t value, rt_uint8_t flag);
+rt_err_t rt_sem_detach(struct rt_semaphore *sem);
+rt_err_t rt_sem_take(struct rt_semaphore *sem, rt_int32_t time);
+rt_err_t rt_sem_release(struct rt_semaphore *sem);
+
+#endif
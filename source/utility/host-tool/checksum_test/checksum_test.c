@@ -0,0 +1,259 @@
+/*
+ * Host conformance test and benchmark for ekernel/subsys/lib/checksum.c.
+ *
+ *   checksum_test            run the conformance checks and the benchmark
+ *   checksum_test -q         conformance checks only
+ *
+ * Every routine is checked against the standard check value of "123456789"
+ * and against a bit-at-a-time reference over random buffers, lengths,
+ * alignments and split points. The benchmark compares the library with the
+ * byte-at-a-time table code it replaced.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <libs/checksum.h>
+
+#define BENCH_SIZE      (4 * 1024 * 1024)
+#define BENCH_LOOPS     16
+#define FUZZ_ROUNDS     20000
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+/* bitwise references, deliberately as simple as possible */
+static uint32_t ref_crc32_refl(uint32_t poly, uint32_t crc, const uint8_t *p, size_t len)
+{
+    int j;
+
+    while (len--)
+    {
+        crc ^= *p++;
+        for (j = 0; j < 8; j++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ poly) : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static uint32_t ref_crc32_be(uint32_t crc, const uint8_t *p, size_t len)
+{
+    int j;
+
+    while (len--)
+    {
+        crc ^= (uint32_t)*p++ << 24;
+        for (j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x80000000) ? ((crc << 1) ^ 0x04c11db7) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t ref_crc16(uint16_t crc, const uint8_t *p, size_t len)
+{
+    return (uint16_t)ref_crc32_refl(0xa001, crc, p, len);
+}
+
+static uint16_t ref_crc_itu_t(uint16_t crc, const uint8_t *p, size_t len)
+{
+    int j;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint32_t ref_adler32(uint32_t adler, const uint8_t *p, size_t len)
+{
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+
+    while (len--)
+    {
+        a = (a + *p++) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+static uint32_t ref_sum(uint32_t sum, const uint8_t *p, size_t len)
+{
+    while (len--)
+    {
+        sum += *p++;
+    }
+    return sum;
+}
+
+/* the byte-at-a-time table loop previously used by busybox crc32.c */
+static uint32_t old_table[256];
+
+static uint32_t old_crc32(uint32_t val, const uint8_t *p, size_t len)
+{
+    while (len--)
+    {
+        val = old_table[(uint8_t)val ^ *p++] ^ (val >> 8);
+    }
+    return val;
+}
+
+static void check_vectors(void)
+{
+    const char *s = "123456789";
+    size_t n = strlen(s);
+
+    CHECK(~crc32_le(~0u, s, n) == 0xcbf43926, "crc32 check value");
+    CHECK(~crc32c_le(~0u, s, n) == 0xe3069283, "crc32c check value");
+    CHECK(~crc32_be(~0u, s, n) == 0xfc891918, "crc32 bzip2 check value");
+    CHECK(melis_crc16(0, s, n) == 0xbb3d, "crc16/arc check value");
+    CHECK(crc_itu_t(0, s, n) == 0x31c3, "crc-itu-t/xmodem check value");
+    CHECK(melis_adler32(1, s, n) == 0x091e01de, "adler32 check value");
+    CHECK(csum_bytes(0, s, n) == 477, "byte sum check value");
+    CHECK(crc32_le(0x12345678, s, 0) == 0x12345678, "crc32 empty buffer");
+}
+
+static void check_random(void)
+{
+    static uint8_t buf[70000 + 16];
+    size_t i, len, off, split;
+    const uint8_t *p;
+    uint32_t seed;
+    int r;
+
+    for (i = 0; i < sizeof(buf); i++)
+    {
+        buf[i] = (uint8_t)rand();
+    }
+
+    for (r = 0; r < FUZZ_ROUNDS; r++)
+    {
+        /* mostly short buffers, some crossing the adler32 NMAX block */
+        len = (r % 50 == 0) ? (size_t)(rand() % 70000) : (size_t)(rand() % 300);
+        off = rand() % 16;
+        split = len ? rand() % (len + 1) : 0;
+        seed = (uint32_t)rand() * 2654435761u;
+        p = buf + off;
+
+        CHECK(crc32_le(crc32_le(seed, p, split), p + split, len - split) ==
+              ref_crc32_refl(0xedb88320, seed, p, len),
+              "crc32_le len %zu off %zu split %zu", len, off, split);
+        CHECK(crc32c_le(crc32c_le(seed, p, split), p + split, len - split) ==
+              ref_crc32_refl(0x82f63b78, seed, p, len),
+              "crc32c_le len %zu off %zu split %zu", len, off, split);
+        CHECK(crc32_be(seed, p, len) == ref_crc32_be(seed, p, len),
+              "crc32_be len %zu off %zu", len, off);
+        CHECK(melis_crc16((uint16_t)seed, p, len) == ref_crc16((uint16_t)seed, p, len),
+              "crc16 len %zu off %zu", len, off);
+        CHECK(crc_itu_t((uint16_t)seed, p, len) == ref_crc_itu_t((uint16_t)seed, p, len),
+              "crc_itu_t len %zu off %zu", len, off);
+        CHECK(melis_adler32(melis_adler32(1, p, split), p + split, len - split) == ref_adler32(1, p, len),
+              "adler32 len %zu off %zu split %zu", len, off, split);
+        CHECK(csum_bytes(seed, p, len) == ref_sum(seed, p, len),
+              "csum_bytes len %zu off %zu", len, off);
+        if (failures > 20)
+        {
+            return;
+        }
+    }
+
+    /* the byte sum lanes must not carry even for all-0xff input */
+    memset(buf, 0xff, sizeof(buf));
+    CHECK(csum_bytes(0, buf, sizeof(buf)) == 0xff * sizeof(buf), "csum_bytes saturation");
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define BENCH(name, expr)                                                   \
+    do {                                                                    \
+        double t0 = now_sec();                                              \
+        int l;                                                              \
+        for (l = 0; l < BENCH_LOOPS; l++)                                   \
+        {                                                                   \
+            sink ^= (uint32_t)(expr);                                       \
+        }                                                                   \
+        printf("  %-22s %8.1f MB/s\n", name,                                \
+               (double)BENCH_SIZE * BENCH_LOOPS / (now_sec() - t0) / 1e6);  \
+    } while (0)
+
+static void bench(void)
+{
+    uint8_t *buf = malloc(BENCH_SIZE);
+    volatile uint32_t sink = 0;
+    uint32_t c;
+    int i, j;
+
+    if (!buf)
+    {
+        return;
+    }
+    for (i = 0; i < BENCH_SIZE; i++)
+    {
+        buf[i] = (uint8_t)(i * 131 + (i >> 7));
+    }
+    for (i = 0; i < 256; i++)
+    {
+        c = i;
+        for (j = 0; j < 8; j++)
+        {
+            c = (c & 1) ? ((c >> 1) ^ 0xedb88320) : (c >> 1);
+        }
+        old_table[i] = c;
+    }
+
+    printf("benchmark, %d x %d KB, crc32 implementation %s:\n",
+           BENCH_LOOPS, BENCH_SIZE / 1024, crc32_impl_name());
+    BENCH("crc32 bytewise (old)", old_crc32(~0u, buf, BENCH_SIZE));
+    BENCH("crc32_le", crc32_le(~0u, buf, BENCH_SIZE));
+    BENCH("crc32c_le", crc32c_le(~0u, buf, BENCH_SIZE));
+    BENCH("crc32_be", crc32_be(~0u, buf, BENCH_SIZE));
+    BENCH("crc16", melis_crc16(0, buf, BENCH_SIZE));
+    BENCH("crc_itu_t", crc_itu_t(0, buf, BENCH_SIZE));
+    BENCH("adler32", melis_adler32(1, buf, BENCH_SIZE));
+    BENCH("byte sum (old)", ref_sum(0, buf, BENCH_SIZE));
+    BENCH("csum_bytes", csum_bytes(0, buf, BENCH_SIZE));
+    free(buf);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    srand(0x5eed);
+    check_vectors();
+    check_random();
+    printf("checksum conformance: %s\n", failures ? "FAILED" : "ok");
+    if (failures)
+    {
+        return 1;
+    }
+    if (!quiet)
+    {
+        bench();
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * Host test and benchmark for the kernel symbol lookup of the module loader,
+ * ekernel/core/rt-thread/libdl/dlsymtab.c.
+ *
+ *   dlsymtab_test            run the checks and the lookup benchmark
+ *   dlsymtab_test -q         checks only
+ *
+ * The table stands in for the linker's RTMSymTab: __rtmsymtab_start/end are
+ * set over a static array, filled sorted the way kernel.lds lays it out,
+ * then shuffled to check the fallback for toolchains that do not sort.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rtthread.h>
+
+rt_uint32_t dlmodule_symbol_find(const char *sym_str);
+int rt_system_dlmodule_init(void);
+
+#define NSYM            2048
+#define NAME_LEN        40
+#define BENCH_LOOKUPS   200000
+
+#define STR(x)          #x
+#define XSTR(x)         STR(x)
+
+struct rt_module_symtab test_symtab[NSYM];
+
+__asm__(".globl __rtmsymtab_start\n"
+        ".set __rtmsymtab_start, test_symtab\n"
+        ".globl __rtmsymtab_end\n"
+        ".set __rtmsymtab_end, test_symtab + " XSTR(NSYM) " * 16\n");
+
+typedef char symtab_entry_is_16_bytes[sizeof(struct rt_module_symtab) == 16 ? 1 : -1];
+
+static char names[NSYM][NAME_LEN];
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static int cmp_entry(const void *a, const void *b)
+{
+    return strcmp(((const struct rt_module_symtab *)a)->name,
+                  ((const struct rt_module_symtab *)b)->name);
+}
+
+/* kernel-like names: a handful of long shared prefixes */
+static void make_names(void)
+{
+    static const char *prefix[] =
+    {
+        "rt_", "rt_thread_", "rt_device_", "rt_sem_", "hal_", "esKRNL_", "dlmodule_", "lwip_",
+    };
+    int i;
+
+    for (i = 0; i < NSYM; i++)
+    {
+        snprintf(names[i], NAME_LEN, "%s%x_%d", prefix[(i * 7) % 8], (unsigned int)(i * 2654435761u) >> 20, i);
+        test_symtab[i].name = names[i];
+        test_symtab[i].addr = (void *)(rt_ubase_t)(0x40000000u + i * 4);
+    }
+}
+
+static void shuffle(void)
+{
+    struct rt_module_symtab tmp;
+    int i, j;
+
+    for (i = NSYM - 1; i > 0; i--)
+    {
+        j = rand() % (i + 1);
+        tmp = test_symtab[i];
+        test_symtab[i] = test_symtab[j];
+        test_symtab[j] = tmp;
+    }
+}
+
+static void check_all(const char *what)
+{
+    char miss[NAME_LEN + 2];
+    int i;
+
+    for (i = 0; i < NSYM; i++)
+    {
+        CHECK(dlmodule_symbol_find(test_symtab[i].name) == (rt_uint32_t)(rt_ubase_t)test_symtab[i].addr,
+              "%s: lookup %s", what, test_symtab[i].name);
+
+        /* near misses on both sides */
+        snprintf(miss, sizeof(miss), "%sx", test_symtab[i].name);
+        CHECK(dlmodule_symbol_find(miss) == 0, "%s: found %s", what, miss);
+        strcpy(miss, test_symtab[i].name);
+        miss[strlen(miss) - 1] = '\0';
+        CHECK(dlmodule_symbol_find(miss) == 0 || strcmp(miss, test_symtab[i].name) != 0,
+              "%s: prefix of %s", what, test_symtab[i].name);
+    }
+
+    CHECK(dlmodule_symbol_find("") == 0, "%s: empty name", what);
+    CHECK(dlmodule_symbol_find("\x01") == 0, "%s: below first", what);
+    CHECK(dlmodule_symbol_find("\x7f") == 0, "%s: above last", what);
+}
+
+int rt_kprintf(const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench_lookup(void)
+{
+    volatile rt_uint32_t sink = 0;
+    double t0;
+    int i;
+
+    t0 = now_sec();
+    for (i = 0; i < BENCH_LOOKUPS; i++)
+    {
+        sink += dlmodule_symbol_find(names[(i * 7919) % NSYM]);
+    }
+    (void)sink;
+    return (now_sec() - t0) * 1e9 / BENCH_LOOKUPS;
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+    double sorted_ns, linear_ns = 0;
+
+    srand(0x1d1);
+    make_names();
+
+    /* what kernel.lds produces */
+    qsort(test_symtab, NSYM, sizeof(test_symtab[0]), cmp_entry);
+    rt_system_dlmodule_init();
+    check_all("sorted");
+    sorted_ns = bench_lookup();
+
+    /* armcc/IAR: unsorted, must fall back */
+    shuffle();
+    printf("expect a warning:\n  ");
+    rt_system_dlmodule_init();
+    check_all("unsorted");
+    if (!quiet)
+    {
+        linear_ns = bench_lookup();
+    }
+
+    printf("dlsymtab: %s\n", failures ? "FAILED" : "ok");
+    if (failures)
+    {
+        return 1;
+    }
+    if (!quiet)
+    {
+        printf("lookup over %d symbols: sorted %.0f ns, linear %.0f ns\n", NSYM, sorted_ns, linear_ns);
+    }
+    return 0;
+}
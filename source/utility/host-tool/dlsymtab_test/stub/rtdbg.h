@@ -0,0 +1,10 @@
+/* host stub of rtdbg.h */
+#ifndef RT_DBG_H__
+#define RT_DBG_H__
+
+#define LOG_D(...)
+#define LOG_I(...)
+#define LOG_W(fmt, ...)     printf("[W/%s] " fmt "\n", DBG_TAG, ##__VA_ARGS__)
+#define LOG_E(fmt, ...)     printf("[E/%s] " fmt "\n", DBG_TAG, ##__VA_ARGS__)
+
+#endif
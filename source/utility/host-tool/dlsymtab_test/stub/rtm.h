@@ -0,0 +1,13 @@
+/* host stub of core/rt-thread/include/rtm.h */
+#ifndef __RTM_H__
+#define __RTM_H__
+
+struct rt_module_symtab
+{
+    void       *addr;
+    const char *name;
+};
+
+#define RTM_EXPORT(symbol)
+
+#endif
@@ -0,0 +1,41 @@
+/* host stub: what core/rt-thread/libdl/dlsymtab.c needs from rtthread.h */
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+#include <stdio.h>
+#include <string.h>
+
+#include <rtm.h>
+
+typedef unsigned char   rt_uint8_t;
+typedef unsigned short  rt_uint16_t;
+typedef unsigned int    rt_uint32_t;
+typedef int             rt_int32_t;
+typedef unsigned long   rt_ubase_t;
+typedef int             rt_bool_t;
+typedef long            rt_err_t;
+
+#define RT_NULL         ((void *)0)
+#define RT_TRUE         1
+#define RT_FALSE        0
+
+typedef struct rt_list_node
+{
+    struct rt_list_node *next, *prev;
+} rt_list_t;
+
+struct rt_object
+{
+    char name[8];
+};
+
+struct rt_thread;
+
+#define rt_strcmp(a, b)                 strcmp((a), (b))
+/* no format attribute: the kernel prints addresses with %x */
+int rt_kprintf(const char *fmt, ...);
+
+#define INIT_COMPONENT_EXPORT(fn)
+#define MSH_CMD_EXPORT(cmd, desc)
+
+#endif
@@ -0,0 +1,385 @@
+/*
+ * Host unit test for the queueing logic of the asynchronous DMA memcpy
+ * service, ekernel/drivers/hal/source/dma/hal_dma_async.c.
+ *
+ *   dma_async_test
+ *
+ * The service runs against its software backend, both with completions
+ * inside submit (inline) and with completions only on poll (deferred, the
+ * way the dma engine behaves), and against a test backend that refuses
+ * misaligned requests like the hardware one. Checked are data, FIFO order
+ * of the callbacks, resubmission and freeing from the callback, recursion
+ * depth with inline completion and the hal_dma_memcpy() fallbacks.
+ *
+ * The service passes addresses as uint32_t like the target, so every buffer
+ * comes from a MAP_32BIT mapping.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/mman.h>
+
+#include <sunxi_hal_dma.h>
+#include <hal_sem.h>
+
+#define ARENA_SIZE      (8 * 1024 * 1024)
+#define NR_REQ          64
+#define MAX_NENTS       8
+#define ROUNDS          200
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+/* semaphore stub, a wait with nothing posted polls the deferred backend */
+struct host_sem
+{
+    int count;
+};
+
+int hal_sem_create(hal_sem_t *sem, unsigned int cnt)
+{
+    *sem = malloc(sizeof(**sem));
+    if (*sem == NULL)
+    {
+        return -1;
+    }
+    (*sem)->count = cnt;
+    return 0;
+}
+
+int hal_sem_delete(hal_sem_t sem)
+{
+    free(sem);
+    return 0;
+}
+
+int hal_sem_post(hal_sem_t sem)
+{
+    sem->count++;
+    return 0;
+}
+
+int hal_sem_wait(hal_sem_t sem)
+{
+    while (sem->count == 0)
+    {
+        if (!hal_dma_async_sw_poll())
+        {
+            printf("FAIL: wait with nothing in flight\n");
+            exit(1);
+        }
+    }
+    sem->count--;
+    return 0;
+}
+
+static uint8_t *arena;
+static size_t arena_used;
+
+static void *arena_alloc(size_t len, size_t align)
+{
+    void *p;
+
+    arena_used = (arena_used + align - 1) & ~(align - 1);
+    if (arena_used + len > ARENA_SIZE)
+    {
+        arena_used = 0;
+    }
+    p = arena + arena_used;
+    arena_used += len;
+    return p;
+}
+
+static uint32_t addr(const void *p)
+{
+    return (uint32_t)(unsigned long)p;
+}
+
+struct job
+{
+    struct hal_dma_async_req req;
+    struct dma_sg_entry sg[MAX_NENTS];
+    uint32_t nents;
+    int id;
+    int resubmit;
+    hal_dma_status_t status;
+    bool done;
+};
+
+static int order[4 * NR_REQ];
+static int order_len;
+static int depth, max_depth;
+
+static void job_done(void *arg, hal_dma_status_t status)
+{
+    struct job *job = arg;
+
+    depth++;
+    if (depth > max_depth)
+    {
+        max_depth = depth;
+    }
+    job->status = status;
+    job->done = true;
+    order[order_len++] = job->id;
+    if (job->resubmit > 0)
+    {
+        job->resubmit--;
+        job->done = false;
+        CHECK(hal_dma_memcpy_sg_async(&job->req, job->sg, job->nents, job_done, job) == HAL_DMA_STATUS_OK,
+              "resubmit from callback");
+    }
+    depth--;
+}
+
+static void job_fill(struct job *job, int id)
+{
+    uint32_t i, len;
+    uint8_t *src, *dst;
+
+    memset(job, 0, sizeof(*job));
+    job->id = id;
+    job->nents = 1 + rand() % MAX_NENTS;
+    for (i = 0; i < job->nents; i++)
+    {
+        len = 1 + rand() % 3000;
+        src = arena_alloc(len, 1);
+        dst = arena_alloc(len, 1);
+        memset(src, rand(), len);
+        src[0] = (uint8_t)id;
+        memset(dst, 0, len);
+        job->sg[i].src = addr(src);
+        job->sg[i].dst = addr(dst);
+        job->sg[i].len = len;
+    }
+}
+
+static bool job_copied(const struct job *job)
+{
+    uint32_t i;
+
+    for (i = 0; i < job->nents; i++)
+    {
+        if (memcmp((void *)(unsigned long)job->sg[i].dst,
+                   (void *)(unsigned long)job->sg[i].src, job->sg[i].len))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_fifo(bool deferred)
+{
+    static struct job jobs[NR_REQ];
+    int i, n, polls = 0, expect = 0;
+
+    CHECK(hal_dma_async_init_sw(deferred) == HAL_DMA_STATUS_OK, "init sw backend");
+    order_len = 0;
+    max_depth = 0;
+    for (i = 0; i < NR_REQ; i++)
+    {
+        job_fill(&jobs[i], i);
+        jobs[i].resubmit = (i % 5 == 0) ? 2 : 0;
+        expect += 1 + jobs[i].resubmit;
+        CHECK(hal_dma_memcpy_sg_async(&jobs[i].req, jobs[i].sg, jobs[i].nents, job_done, &jobs[i]) == HAL_DMA_STATUS_OK,
+              "submit %d", i);
+        if (deferred && i == 0)
+        {
+            CHECK(!jobs[0].done && !job_copied(&jobs[0]), "deferred request finished early");
+        }
+    }
+
+    if (deferred)
+    {
+        /* the backend is busy, switching it now must be refused */
+        CHECK(hal_dma_async_init_sw(false) == HAL_DMA_STATUS_ERROR, "register while busy");
+        while (hal_dma_async_sw_poll())
+        {
+            polls++;
+        }
+        CHECK(polls == expect, "deferred polls %d, expected %d", polls, expect);
+    }
+
+    CHECK(order_len == expect, "%d callbacks, expected %d", order_len, expect);
+    for (i = 0, n = 0; i < NR_REQ; i++)
+    {
+        CHECK(jobs[i].done && jobs[i].status == HAL_DMA_STATUS_OK && job_copied(&jobs[i]),
+              "%s request %d", deferred ? "deferred" : "inline", i);
+    }
+    /* deferred: first pass in submission order, resubmissions queue behind */
+    for (i = 0; deferred && i < NR_REQ && i < order_len; i++)
+    {
+        n += order[i] != i;
+    }
+    CHECK(n == 0, "deferred completion order");
+    CHECK(max_depth <= 2, "inline completion nested %d callbacks deep", max_depth);
+}
+
+/* callback frees its own request, the service must not touch it again */
+static void free_done(void *arg, hal_dma_status_t status)
+{
+    struct job *job = arg;
+
+    order[order_len++] = job->id;
+    memset(job, 0xa5, sizeof(*job));
+    free(job);
+}
+
+static void test_free_in_callback(void)
+{
+    struct job *job;
+    int i;
+
+    CHECK(hal_dma_async_init_sw(true) == HAL_DMA_STATUS_OK, "init sw backend");
+    order_len = 0;
+    for (i = 0; i < 16; i++)
+    {
+        job = malloc(sizeof(*job));
+        job_fill(job, i);
+        hal_dma_memcpy_sg_async(&job->req, job->sg, job->nents, free_done, job);
+    }
+    while (hal_dma_async_sw_poll())
+    {
+    }
+    CHECK(order_len == 16, "freed requests completed %d of 16", order_len);
+}
+
+/* like the dma backend: refuse anything not cache line aligned */
+static int strict_submits;
+
+static hal_dma_status_t strict_submit(void *priv, const struct dma_sg_entry *sg, uint32_t nents)
+{
+    uint32_t i;
+
+    strict_submits++;
+    for (i = 0; i < nents; i++)
+    {
+        if ((sg[i].dst | sg[i].len) & (HAL_DMA_ASYNC_ALIGN - 1))
+        {
+            return HAL_DMA_STATUS_INVALID_PARAMETER;
+        }
+    }
+    for (i = 0; i < nents; i++)
+    {
+        memcpy((void *)(unsigned long)sg[i].dst, (void *)(unsigned long)sg[i].src, sg[i].len);
+    }
+    hal_dma_async_complete(HAL_DMA_STATUS_OK);
+    return HAL_DMA_STATUS_OK;
+}
+
+static const struct hal_dma_async_ops strict_ops =
+{
+    .name = "strict",
+    .submit = strict_submit,
+};
+
+static void test_refused(void)
+{
+    struct job good, bad;
+    uint8_t *src, *dst;
+
+    CHECK(hal_dma_async_register(&strict_ops) == HAL_DMA_STATUS_OK, "register strict backend");
+    order_len = 0;
+
+    job_fill(&bad, 1);
+    bad.sg[0].dst |= 1;
+    job_fill(&good, 2);
+    good.nents = 1;
+    good.sg[0].len = 4096;
+    good.sg[0].src = addr(arena_alloc(4096, 1));
+    good.sg[0].dst = addr(arena_alloc(4096, HAL_DMA_ASYNC_ALIGN));
+
+    hal_dma_memcpy_sg_async(&bad.req, bad.sg, bad.nents, job_done, &bad);
+    hal_dma_memcpy_sg_async(&good.req, good.sg, good.nents, job_done, &good);
+    CHECK(bad.done && bad.status == HAL_DMA_STATUS_INVALID_PARAMETER, "refused request status %d", bad.status);
+    CHECK(good.done && good.status == HAL_DMA_STATUS_OK && job_copied(&good), "request after a refused one");
+    CHECK(order_len == 2 && order[0] == 1 && order[1] == 2, "order around a refused request");
+
+    /* hal_dma_memcpy(): refused and small copies go through the cpu */
+    src = arena_alloc(3 * HAL_DMA_ASYNC_MIN_LEN, 1);
+    dst = arena_alloc(3 * HAL_DMA_ASYNC_MIN_LEN, HAL_DMA_ASYNC_ALIGN);
+    memset(src, 0x3c, 3 * HAL_DMA_ASYNC_MIN_LEN);
+    strict_submits = 0;
+    CHECK(hal_dma_memcpy(dst + 1, src, 2 * HAL_DMA_ASYNC_MIN_LEN) == HAL_DMA_STATUS_OK
+          && !memcmp(dst + 1, src, 2 * HAL_DMA_ASYNC_MIN_LEN), "misaligned hal_dma_memcpy");
+    CHECK(strict_submits == 1, "misaligned hal_dma_memcpy tried the backend %d times", strict_submits);
+    CHECK(hal_dma_memcpy(dst, src, 100) == HAL_DMA_STATUS_OK && !memcmp(dst, src, 100), "small hal_dma_memcpy");
+    CHECK(strict_submits == 1, "small hal_dma_memcpy went to the backend");
+    memset(dst, 0, 3 * HAL_DMA_ASYNC_MIN_LEN);
+    CHECK(hal_dma_memcpy(dst, src, 2 * HAL_DMA_ASYNC_MIN_LEN) == HAL_DMA_STATUS_OK
+          && !memcmp(dst, src, 2 * HAL_DMA_ASYNC_MIN_LEN), "aligned hal_dma_memcpy");
+    CHECK(strict_submits == 2, "aligned hal_dma_memcpy bypassed the backend");
+}
+
+static void test_blocking_deferred(void)
+{
+    uint8_t *src, *dst;
+    uint32_t len;
+    int r;
+
+    CHECK(hal_dma_async_init_sw(true) == HAL_DMA_STATUS_OK, "init sw backend");
+    for (r = 0; r < ROUNDS; r++)
+    {
+        len = 1 + rand() % (4 * HAL_DMA_ASYNC_MIN_LEN);
+        src = arena_alloc(len, 1);
+        dst = arena_alloc(len, 1);
+        memset(src, r, len);
+        memset(dst, ~r, len);
+        hal_dma_memcpy(dst, src, len);
+        CHECK(!memcmp(dst, src, len), "blocking copy round %d len %u", r, len);
+    }
+    CHECK(hal_dma_async_sw_poll() == 0, "blocking copy left work behind");
+}
+
+static void test_params(void)
+{
+    struct hal_dma_async_req req;
+    struct dma_sg_entry sg = {1, 1, 1};
+    uint8_t b;
+
+    CHECK(hal_dma_async_register(NULL) == HAL_DMA_STATUS_OK, "unregister");
+    CHECK(hal_dma_memcpy_sg_async(&req, &sg, 1, NULL, NULL) == HAL_DMA_STATUS_ERROR, "submit without backend");
+    CHECK(hal_dma_memcpy(&b, "x", 1) == HAL_DMA_STATUS_OK && b == 'x', "hal_dma_memcpy without backend");
+    CHECK(hal_dma_memcpy_sg_async(NULL, &sg, 1, NULL, NULL) == HAL_DMA_STATUS_INVALID_PARAMETER, "NULL request");
+    CHECK(hal_dma_memcpy_sg_async(&req, &sg, 0, NULL, NULL) == HAL_DMA_STATUS_INVALID_PARAMETER, "empty list");
+    CHECK(hal_dma_memcpy_async(&req, &b, &b, 0, NULL, NULL) == HAL_DMA_STATUS_INVALID_PARAMETER, "zero length");
+}
+
+int main(void)
+{
+    int r;
+
+    arena = mmap(NULL, ARENA_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (arena == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+
+    srand(0xd3a);
+    test_params();
+    for (r = 0; r < 10 && failures < 20; r++)
+    {
+        test_fifo(false);
+        test_fifo(true);
+    }
+    test_free_in_callback();
+    test_refused();
+    test_blocking_deferred();
+
+    printf("dma async queue: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
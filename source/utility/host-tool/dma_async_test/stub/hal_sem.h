@@ -0,0 +1,12 @@
+/* host stub: counting semaphore, waiting drives the deferred backend */
+#ifndef SUNXI_HAL_SEM_H
+#define SUNXI_HAL_SEM_H
+
+typedef struct host_sem *hal_sem_t;
+
+int hal_sem_create(hal_sem_t *sem, unsigned int cnt);
+int hal_sem_delete(hal_sem_t sem);
+int hal_sem_post(hal_sem_t sem);
+int hal_sem_wait(hal_sem_t sem);
+
+#endif
@@ -0,0 +1,337 @@
+/*
+ * Host test and benchmark for the dmix mixing loops,
+ * ekernel/drivers/hal/source/sound/component/aw-alsa-lib/pcm_dmix_generic.c.
+ *
+ *   dmix_test                run the checks and the benchmark
+ *   dmix_test -q             checks only
+ *
+ * The callbacks picked by generic_mix_select_callbacks() must leave dst and
+ * the sum buffer exactly as the per sample loops do, for every format, for
+ * packed and strided areas, silent and busy dst samples and sums at the
+ * clamps. Built with ../stub/arm_neon.h and __ARM_NEON defined as
+ * dmix_test_neon, the same checks cover the NEON paths.
+ */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef void (mix_areas_16_t)(unsigned int size,
+			      volatile signed short *dst, signed short *src,
+			      volatile signed int *sum, size_t dst_step,
+			      size_t src_step, size_t sum_step);
+
+typedef void (mix_areas_32_t)(unsigned int size,
+			      volatile signed int *dst, signed int *src,
+			      volatile signed int *sum, size_t dst_step,
+			      size_t src_step, size_t sum_step);
+
+typedef void (mix_areas_24_t)(unsigned int size,
+			      volatile unsigned char *dst, unsigned char *src,
+			      volatile signed int *sum, size_t dst_step,
+			      size_t src_step, size_t sum_step);
+
+typedef void (mix_areas_u8_t)(unsigned int size,
+			      volatile unsigned char *dst, unsigned char *src,
+			      volatile signed int *sum, size_t dst_step,
+			      size_t src_step, size_t sum_step);
+
+/* the part of pcm_direct.h the mixing loops use */
+typedef struct snd_pcm_direct {
+	union {
+		struct {
+			mix_areas_16_t *mix_areas_16;
+			mix_areas_32_t *mix_areas_32;
+			mix_areas_24_t *mix_areas_24;
+			mix_areas_u8_t *mix_areas_u8;
+			mix_areas_16_t *remix_areas_16;
+			mix_areas_32_t *remix_areas_32;
+			mix_areas_24_t *remix_areas_24;
+			mix_areas_u8_t *remix_areas_u8;
+		} dmix;
+	} u;
+} snd_pcm_direct_t;
+
+#include "pcm_dmix_generic.c"
+
+#define MAX_SAMPLES	4096
+#define MAX_STRIDE	4
+#define BENCH_SAMPLES	(2 * 1024)
+
+enum { FMT_16, FMT_32, FMT_24, FMT_U8, FMT_NUM };
+
+static const char *fmt_name[FMT_NUM] = { "S16_LE", "S32_LE", "S24_LE", "U8" };
+static const size_t fmt_width[FMT_NUM] = { 2, 4, 4, 1 };
+
+typedef void (mix_fn)(unsigned int size, volatile void *dst, void *src,
+		      volatile signed int *sum, size_t dst_step,
+		      size_t src_step, size_t sum_step);
+
+static snd_pcm_direct_t dmix;
+static mix_fn *ref_mix[FMT_NUM], *ref_remix[FMT_NUM];
+static mix_fn *new_mix[FMT_NUM], *new_remix[FMT_NUM];
+static int failures;
+
+#define CHECK(cond, ...)			\
+	do {					\
+		if (!(cond)) {			\
+			printf("FAIL: " __VA_ARGS__);	\
+			printf("\n");		\
+			failures++;		\
+		}				\
+	} while (0)
+
+static void setup(void)
+{
+	generic_mix_select_callbacks(&dmix);
+
+	ref_mix[FMT_16] = (mix_fn *)generic_mix_areas_16_native;
+	ref_mix[FMT_32] = (mix_fn *)generic_mix_areas_32_native;
+	ref_mix[FMT_24] = (mix_fn *)generic_mix_areas_24;
+	ref_mix[FMT_U8] = (mix_fn *)generic_mix_areas_u8;
+	ref_remix[FMT_16] = (mix_fn *)generic_remix_areas_16_native;
+	ref_remix[FMT_32] = (mix_fn *)generic_remix_areas_32_native;
+	ref_remix[FMT_24] = (mix_fn *)generic_remix_areas_24;
+	ref_remix[FMT_U8] = (mix_fn *)generic_remix_areas_u8;
+
+	new_mix[FMT_16] = (mix_fn *)dmix.u.dmix.mix_areas_16;
+	new_mix[FMT_32] = (mix_fn *)dmix.u.dmix.mix_areas_32;
+	new_mix[FMT_24] = (mix_fn *)dmix.u.dmix.mix_areas_24;
+	new_mix[FMT_U8] = (mix_fn *)dmix.u.dmix.mix_areas_u8;
+	new_remix[FMT_16] = (mix_fn *)dmix.u.dmix.remix_areas_16;
+	new_remix[FMT_32] = (mix_fn *)dmix.u.dmix.remix_areas_32;
+	new_remix[FMT_24] = (mix_fn *)dmix.u.dmix.remix_areas_24;
+	new_remix[FMT_U8] = (mix_fn *)dmix.u.dmix.remix_areas_u8;
+}
+
+static unsigned int rnd(void)
+{
+	static unsigned int seed = 0x2545f491;
+
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+/* a random sample, often full scale so that the sums reach the clamps */
+static void put_sample(int fmt, unsigned char *p, int loud)
+{
+	unsigned int v = rnd();
+
+	if (loud && (v & 3) == 0)
+		v = v & 4 ? 0x7fffffff : 0x80000000;
+	switch (fmt) {
+	case FMT_16:
+		*(signed short *)p = v >> 16;
+		break;
+	case FMT_32:
+		*(signed int *)p = v;
+		break;
+	case FMT_24:
+		/* the top byte is padding, left alone by the mixer */
+		*(unsigned int *)p = v >> 8 | (rnd() & 0xff000000);
+		break;
+	case FMT_U8:
+		*p = v >> 24;
+		break;
+	}
+}
+
+/* the dst value the mixer reads as nothing mixed in yet */
+static void put_silence(int fmt, unsigned char *p)
+{
+	switch (fmt) {
+	case FMT_16:
+		*(signed short *)p = 0;
+		break;
+	case FMT_32:
+		*(signed int *)p = 0;
+		break;
+	case FMT_24:
+		*(unsigned int *)p = rnd() & 0xff000000;
+		break;
+	case FMT_U8:
+		*p = 0x80;
+		break;
+	}
+}
+
+static signed int sum_value(int fmt)
+{
+	/* around the clamp of the format */
+	static const signed int range[FMT_NUM] = { 0x8000, 0x800000, 0x800000, 0x80 };
+	unsigned int v = rnd();
+
+	switch (v & 3) {
+	case 0:
+		return range[fmt] - 8 + (v >> 8) % 16;
+	case 1:
+		return -range[fmt] - 8 + (v >> 8) % 16;
+	default:
+		return (signed int)(v >> 4) % (4 * range[fmt]);
+	}
+}
+
+struct area {
+	unsigned char dst[2][MAX_SAMPLES * MAX_STRIDE * 4 + 64];
+	unsigned char src[MAX_SAMPLES * MAX_STRIDE * 4 + 64];
+	signed int sum[2][MAX_SAMPLES * MAX_STRIDE + 16];
+};
+
+static struct area area;
+
+/*
+ * One call on both implementations, with the given layout: stride in
+ * samples, a byte offset into the buffers and a share of silent dst
+ * samples out of 4.
+ */
+static void check_once(int fmt, int remix, unsigned int size, unsigned int stride,
+		       unsigned int offset, unsigned int silent)
+{
+	size_t width = fmt_width[fmt];
+	size_t step = width * stride;
+	unsigned char *dst0 = area.dst[0] + offset, *dst1 = area.dst[1] + offset;
+	unsigned char *src = area.src + offset;
+	signed int *sum0 = area.sum[0], *sum1 = area.sum[1];
+	mix_fn *ref = remix ? ref_remix[fmt] : ref_mix[fmt];
+	mix_fn *fn = remix ? new_remix[fmt] : new_mix[fmt];
+	unsigned int i;
+
+	for (i = 0; i < size * stride; i++) {
+		if (rnd() % 4 < silent)
+			put_silence(fmt, dst0 + i * width);
+		else
+			put_sample(fmt, dst0 + i * width, 0);
+		put_sample(fmt, src + i * width, 1);
+		sum0[i] = sum_value(fmt);
+	}
+	memcpy(dst1, dst0, size * step);
+	memcpy(sum1, sum0, size * stride * sizeof(signed int));
+
+	ref(size, dst0, src, sum0, step, step, stride * sizeof(signed int));
+	fn(size, dst1, src, sum1, step, step, stride * sizeof(signed int));
+
+	CHECK(!memcmp(dst0, dst1, size * step) &&
+	      !memcmp(sum0, sum1, size * stride * sizeof(signed int)),
+	      "%s %s: %u samples, stride %u, offset %u, silent %u/4",
+	      fmt_name[fmt], remix ? "remix" : "mix", size, stride, offset, silent);
+}
+
+static void check_layouts(void)
+{
+	static const unsigned int sizes[] = {
+		1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 1023, MAX_SAMPLES
+	};
+	unsigned int s, stride, offset, silent;
+	int fmt, remix;
+
+	for (fmt = 0; fmt < FMT_NUM; fmt++)
+		for (remix = 0; remix < 2; remix++)
+			for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+				for (stride = 1; stride <= MAX_STRIDE; stride++)
+					for (offset = 0; offset < 8; offset += fmt_width[fmt] > 1 ? 1 : 3)
+						for (silent = 0; silent <= 4; silent++)
+							check_once(fmt, remix, sizes[s], stride, offset, silent);
+}
+
+/*
+ * How the plugin uses them: several clients mix into one period and some
+ * take their samples back out again, the sum buffer carried across.
+ */
+static void check_clients(void)
+{
+	static unsigned char src[6][MAX_SAMPLES * 4];
+	unsigned int size = 1021, i, c, round;
+	int fmt;
+
+	for (fmt = 0; fmt < FMT_NUM; fmt++) {
+		size_t width = fmt_width[fmt];
+
+		for (i = 0; i < size; i++) {
+			put_silence(fmt, area.dst[0] + i * width);
+			area.sum[0][i] = 0;
+		}
+		memcpy(area.dst[1], area.dst[0], size * width);
+		memcpy(area.sum[1], area.sum[0], size * sizeof(signed int));
+
+		for (round = 0; round < 40; round++) {
+			c = rnd() % 6;
+			if (round % 3 == 2) {
+				/* a client leaving */
+				ref_remix[fmt](size, area.dst[0], src[c], area.sum[0],
+					       width, width, sizeof(signed int));
+				new_remix[fmt](size, area.dst[1], src[c], area.sum[1],
+					       width, width, sizeof(signed int));
+			} else {
+				for (i = 0; i < size; i++)
+					put_sample(fmt, src[c] + i * width, 1);
+				ref_mix[fmt](size, area.dst[0], src[c], area.sum[0],
+					     width, width, sizeof(signed int));
+				new_mix[fmt](size, area.dst[1], src[c], area.sum[1],
+					     width, width, sizeof(signed int));
+			}
+			if (round % 10 == 9) {
+				/* the period played out and cleared */
+				for (i = 0; i < size; i++)
+					put_silence(fmt, area.dst[0] + i * width);
+				memcpy(area.dst[1], area.dst[0], size * width);
+			}
+			CHECK(!memcmp(area.dst[0], area.dst[1], size * width) &&
+			      !memcmp(area.sum[0], area.sum[1], size * sizeof(signed int)),
+			      "%s clients: round %u", fmt_name[fmt], round);
+		}
+	}
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double bench_one(mix_fn *fn, int fmt)
+{
+	size_t width = fmt_width[fmt];
+	unsigned int i, loops = 2000;
+	double t0;
+
+	for (i = 0; i < BENCH_SAMPLES; i++) {
+		put_sample(fmt, area.dst[0] + i * width, 0);
+		put_sample(fmt, area.src + i * width, 0);
+		area.sum[0][i] = sum_value(fmt);
+	}
+	t0 = now_ns();
+	for (i = 0; i < loops; i++)
+		fn(BENCH_SAMPLES, area.dst[0], area.src, area.sum[0],
+		   width, width, sizeof(signed int));
+	return (now_ns() - t0) / ((double)loops * BENCH_SAMPLES);
+}
+
+static void bench(void)
+{
+	int fmt;
+
+	printf("ns per sample, %u interleaved samples a call:\n", BENCH_SAMPLES);
+	for (fmt = 0; fmt < FMT_NUM; fmt++)
+		printf("  %-7s mix %.2f -> %.2f, remix %.2f -> %.2f\n", fmt_name[fmt],
+		       bench_one(ref_mix[fmt], fmt), bench_one(new_mix[fmt], fmt),
+		       bench_one(ref_remix[fmt], fmt), bench_one(new_remix[fmt], fmt));
+}
+
+int main(int argc, char **argv)
+{
+	int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+	setup();
+	check_layouts();
+	check_clients();
+	if (!quiet)
+		bench();
+
+	printf("%s: %s\n", argv[0], failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * Host test and benchmark for the read-ahead window of the file stream,
+ * libcedarx/libcore/stream/file/CdxFileReadAhead.c.
+ *
+ *   file_read_ahead_test      run the checks and the small read benchmark
+ *   file_read_ahead_test -q   checks only
+ *
+ * The file is in memory behind a read function which counts its calls
+ * and, for the benchmark, sleeps like a SD card: a fixed cost per call
+ * plus the transfer. The parser model reads ts packet sized pieces and
+ * spends some time on each, as the demux does, with a seek every few MB.
+ * Sync reads are compared with the read-ahead window by the file reads
+ * issued and the time the parser waited for them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <CdxFileReadAhead.h>
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+/* libcore/base/CdxTime.c needs the kernel clock */
+cdx_int64 CdxGetNowUs(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (cdx_int64)tv.tv_usec + tv.tv_sec * 1000000ll;
+}
+
+static unsigned int rnd_state = 1;
+
+static unsigned int rnd(unsigned int n)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state % n;
+}
+
+struct fake_file
+{
+    cdx_int64 size;
+    int calls;
+    int call_us;        /* cost of a call */
+    int mb_us;          /* cost of a MB */
+    cdx_int64 fail_pos; /* the read covering it fails once, -1 none */
+};
+
+static unsigned char byte_at(cdx_int64 pos)
+{
+    return (unsigned char)(pos * 7 + (pos >> 12));
+}
+
+static cdx_int32 fake_read_at(void *user, cdx_int64 pos, void *buf, cdx_uint32 len)
+{
+    struct fake_file *f = user;
+    unsigned char *p = buf;
+    cdx_uint32 i;
+
+    __sync_fetch_and_add(&f->calls, 1);
+    if (f->fail_pos >= pos && f->fail_pos < pos + len)
+    {
+        f->fail_pos = -1;
+        return -1;
+    }
+    if (pos >= f->size)
+    {
+        return 0;
+    }
+    if (pos + len > f->size)
+    {
+        len = f->size - pos;
+    }
+    for (i = 0; i < len; i++)
+    {
+        p[i] = byte_at(pos + i);
+    }
+    if (f->call_us || f->mb_us)
+    {
+        usleep(f->call_us + (cdx_int64)f->mb_us * len / (1024 * 1024));
+    }
+    return len;
+}
+
+static int same(const unsigned char *buf, cdx_int64 pos, int len)
+{
+    int i;
+    for (i = 0; i < len; i++)
+    {
+        if (buf[i] != byte_at(pos + i))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void test_sequential(void)
+{
+    struct fake_file f = { 5 * FILE_READ_AHEAD_BLOCK_SIZE + 1234, 0, 0, 0, -1 };
+    struct StreamReadAheadStatsS stats;
+    CdxFileReadAheadT *ra;
+    unsigned char buf[4096];
+    cdx_int64 pos = 0;
+    int ret, ok = 1, reads = 0;
+
+    ra = CdxFileReadAheadCreate(fake_read_at, &f, f.size, 3 * FILE_READ_AHEAD_BLOCK_SIZE - 1);
+    CHECK(ra != NULL, "create");
+    for (;;)
+    {
+        int len = 1 + rnd(sizeof(buf));
+        ret = CdxFileReadAheadRead(ra, pos, buf, len);
+        reads++;
+        if (ret <= 0)
+        {
+            break;
+        }
+        ok &= same(buf, pos, ret);
+        if (ret < len)
+        {
+            CHECK(pos + ret == f.size, "short read only at the end");
+        }
+        pos += ret;
+    }
+    CHECK(ok, "sequential data");
+    CHECK(ret == 0 && pos == f.size, "end of file, ret %d pos %lld", ret, (long long)pos);
+
+    CdxFileReadAheadGetStats(ra, &stats);
+    CHECK(stats.nWindowSize == 3 * FILE_READ_AHEAD_BLOCK_SIZE, "window rounded to blocks");
+    CHECK(stats.nReadCalls == reads, "read calls %lld", (long long)stats.nReadCalls);
+    CHECK(stats.nIoCalls == 6 && f.calls == 6, "one io per block, %lld", (long long)stats.nIoCalls);
+    CHECK(stats.nInvalidations == 0, "no invalidation");
+    CdxFileReadAheadDestroy(ra);
+}
+
+static void test_seek(void)
+{
+    struct fake_file f = { 40 * FILE_READ_AHEAD_BLOCK_SIZE, 0, 0, 0, -1 };
+    struct StreamReadAheadStatsS stats;
+    CdxFileReadAheadT *ra;
+    unsigned char buf[8192];
+    int i, ret, ok = 1;
+
+    ra = CdxFileReadAheadCreate(fake_read_at, &f, f.size, 4 * FILE_READ_AHEAD_BLOCK_SIZE);
+
+    /* back a little stays in the window */
+    ret = CdxFileReadAheadRead(ra, 3 * FILE_READ_AHEAD_BLOCK_SIZE + 10, buf, 100);
+    ok &= ret == 100 && same(buf, 3 * FILE_READ_AHEAD_BLOCK_SIZE + 10, 100);
+    ret = CdxFileReadAheadRead(ra, 2 * FILE_READ_AHEAD_BLOCK_SIZE + 10, buf, 100);
+    ok &= ret == 100 && same(buf, 2 * FILE_READ_AHEAD_BLOCK_SIZE + 10, 100);
+    CdxFileReadAheadGetStats(ra, &stats);
+    CHECK(stats.nInvalidations == 0, "back a block is kept");
+
+    /* far seeks move it */
+    ret = CdxFileReadAheadRead(ra, 30 * FILE_READ_AHEAD_BLOCK_SIZE, buf, 100);
+    ok &= ret == 100 && same(buf, 30 * FILE_READ_AHEAD_BLOCK_SIZE, 100);
+    ret = CdxFileReadAheadRead(ra, 5, buf, 100);
+    ok &= ret == 100 && same(buf, 5, 100);
+    CdxFileReadAheadGetStats(ra, &stats);
+    CHECK(stats.nInvalidations == 2, "two seeks, %d", stats.nInvalidations);
+
+    /* random reads, across blocks too */
+    for (i = 0; i < 2000; i++)
+    {
+        cdx_int64 pos = rnd(f.size);
+        int len = 1 + rnd(sizeof(buf));
+        int want = pos + len > f.size ? f.size - pos : len;
+        ret = CdxFileReadAheadRead(ra, pos, buf, len);
+        ok &= ret == want && same(buf, pos, ret);
+    }
+    CHECK(ok, "seek data");
+    CHECK(CdxFileReadAheadRead(ra, f.size, buf, 10) == 0, "read at the end");
+    CdxFileReadAheadDestroy(ra);
+}
+
+static void test_error_and_bypass(void)
+{
+    struct fake_file f = { 8 * FILE_READ_AHEAD_BLOCK_SIZE, 0, 0, 0, -1 };
+    struct StreamReadAheadStatsS stats;
+    CdxFileReadAheadT *ra;
+    unsigned char *buf = malloc(3 * FILE_READ_AHEAD_BLOCK_SIZE);
+    cdx_int64 pos = FILE_READ_AHEAD_BLOCK_SIZE + 100;
+    int ret, calls;
+
+    f.fail_pos = pos;
+    ra = CdxFileReadAheadCreate(fake_read_at, &f, f.size, 2 * FILE_READ_AHEAD_BLOCK_SIZE);
+
+    /* the error is for the read of its block, the next one loads it again */
+    ret = CdxFileReadAheadRead(ra, pos - 200, buf, 1000);
+    CHECK(ret == 100 && same(buf, pos - 200, 100), "read up to the failed block, %d", ret);
+    ret = CdxFileReadAheadRead(ra, pos, buf, 1000);
+    CHECK(ret == 1000 && same(buf, pos, 1000), "failed block read again, %d", ret);
+
+    /* bigger than the window goes to the file */
+    CdxFileReadAheadGetStats(ra, &stats);
+    calls = stats.nIoCalls;
+    ret = CdxFileReadAheadRead(ra, 12345, buf, 3 * FILE_READ_AHEAD_BLOCK_SIZE);
+    CHECK(ret == 3 * FILE_READ_AHEAD_BLOCK_SIZE && same(buf, 12345, ret), "bypass");
+    CdxFileReadAheadGetStats(ra, &stats);
+    CHECK(stats.nIoCalls >= calls + 1, "bypass counted, %lld", (long long)stats.nIoCalls);
+
+    CdxFileReadAheadDestroy(ra);
+    free(buf);
+}
+
+/* ts demux: 7 packets a read, 2ms of work a 100K, a seek every 4MB */
+static void bench_one(const char *name, int window, cdx_int64 size)
+{
+    struct fake_file f = { size, 0, 300, 50000, -1 };
+    struct StreamReadAheadStatsS stats;
+    CdxFileReadAheadT *ra = NULL;
+    unsigned char buf[188 * 7];
+    cdx_int64 pos = 0, done = 0, t0, stall = 0, reads = 0;
+    int ret;
+
+    if (window > 0)
+    {
+        ra = CdxFileReadAheadCreate(fake_read_at, &f, f.size, window);
+    }
+    t0 = CdxGetNowUs();
+    while (pos < size)
+    {
+        if (ra)
+        {
+            ret = CdxFileReadAheadRead(ra, pos, buf, sizeof(buf));
+        }
+        else
+        {
+            cdx_int64 t = CdxGetNowUs();
+            ret = fake_read_at(&f, pos, buf, sizeof(buf));
+            stall += CdxGetNowUs() - t;
+        }
+        reads++;
+        if (ret <= 0)
+        {
+            break;
+        }
+        pos += ret;
+        done += ret;
+        if (done % (100 * 1024) < sizeof(buf))
+        {
+            usleep(2000);
+        }
+        if (done % (4 * 1024 * 1024) < sizeof(buf))
+        {
+            pos += 3 * 1024 * 1024;     /* skip forward */
+        }
+    }
+    if (ra)
+    {
+        CdxFileReadAheadGetStats(ra, &stats);
+        CdxFileReadAheadDestroy(ra);
+    }
+    else
+    {
+        memset(&stats, 0, sizeof(stats));
+        stats.nReadCalls = stats.nIoCalls = reads;
+        stats.nStallUs = stall;
+    }
+    printf("%-16s %8lld reads %6lld io calls %3d moves  stall %6lld ms  total %6lld ms\n",
+           name, (long long)stats.nReadCalls, (long long)stats.nIoCalls, stats.nInvalidations,
+           (long long)stats.nStallUs / 1000, (long long)(CdxGetNowUs() - t0) / 1000);
+}
+
+static void bench(void)
+{
+    cdx_int64 size = 24 * 1024 * 1024;
+
+    printf("\n24MB ts file, 1316 byte reads, SD card of 300us a call + 20MB/s\n");
+    bench_one("sync", 0, size);
+    bench_one("read-ahead 1MB", 1024 * 1024, size);
+    bench_one("read-ahead 2MB", 2 * 1024 * 1024, size);
+    bench_one("read-ahead 4MB", 4 * 1024 * 1024, size);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    test_sequential();
+    test_seek();
+    test_error_and_bypass();
+    printf("file_read_ahead_test: %s\n", failures ? "FAILED" : "ok");
+    if (failures)
+    {
+        return 1;
+    }
+    if (!quiet)
+    {
+        bench();
+    }
+    return 0;
+}
@@ -0,0 +1,274 @@
+/*
+ * Host test and benchmark for the shell command index,
+ * ekernel/subsys/finsh_cli/finsh_symtab.c.
+ *
+ *   finsh_symtab_test        run the checks and the dispatch benchmark
+ *   finsh_symtab_test -q     checks only
+ *
+ * The table stands in for the linker's FSymTab: msh commands ("__cmd_")
+ * and finsh functions, sorted the way kernel.lds lays them out. Lookups
+ * and completion runs are compared with the linear scans msh.c keeps for
+ * unsorted tables, then the table is shuffled and padded to check that
+ * the index falls back.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../../ekernel/subsys/finsh_cli/finsh.h"
+
+#define NCMD            600
+#define NAME_LEN        32
+#define BENCH_LOOKUPS   200000
+
+struct finsh_syscall *_syscall_table_begin;
+struct finsh_syscall *_syscall_table_end;
+
+static struct finsh_syscall table[NCMD];
+static char names[NCMD][NAME_LEN];
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static int cmp_entry(const void *a, const void *b)
+{
+    return strcmp(((const struct finsh_syscall *)a)->name,
+                  ((const struct finsh_syscall *)b)->name);
+}
+
+/* shell-like names, two thirds msh commands, the rest finsh functions */
+static void make_table(void)
+{
+    static const char *stem[] =
+    {
+        "ls", "list_", "mem", "hal_", "audio_", "drv_", "cat", "ps", "test_", "adb",
+    };
+    int i;
+
+    for (i = 0; i < NCMD; i++)
+    {
+        snprintf(names[i], NAME_LEN, "%s%s%x", i % 3 ? "__cmd_" : "",
+                 stem[(i * 7) % 10], (unsigned int)(i * 2654435761u) >> 22);
+        snprintf(names[i] + strlen(names[i]), NAME_LEN - strlen(names[i]), "_%d", i);
+        table[i].name = names[i];
+        table[i].desc = "test";
+        table[i].func = (syscall_func)(rt_ubase_t)(0x40000000u + i * 4);
+    }
+
+    qsort(table, NCMD, sizeof(table[0]), cmp_entry);
+    _syscall_table_begin = table;
+    _syscall_table_end = table + NCMD;
+}
+
+/* msh_get_cmd() as it scans an unsorted table */
+static struct finsh_syscall *linear_get_cmd(const char *cmd, int size)
+{
+    struct finsh_syscall *index;
+
+    for (index = _syscall_table_begin; index < _syscall_table_end; index++)
+    {
+        if (strncmp(index->name, "__cmd_", 6) == 0)
+        {
+            if (strncmp(&index->name[6], cmd, size) == 0 && index->name[6 + size] == '\0')
+            {
+                return index;
+            }
+            continue;
+        }
+
+        if (strncmp(index->name, cmd, size) == 0 && index->name[size] == '\0')
+        {
+            return index;
+        }
+    }
+
+    return NULL;
+}
+
+/* msh_get_cmd() on the sorted table */
+static struct finsh_syscall *sorted_get_cmd(const char *cmd, int size)
+{
+    struct finsh_syscall *index;
+
+    index = finsh_syscall_find("__cmd_", cmd, size);
+    if (index == NULL)
+    {
+        index = finsh_syscall_find("", cmd, size);
+        if (index != NULL && strncmp(index->name, "__cmd_", 6) == 0)
+        {
+            index = NULL;
+        }
+    }
+
+    return index;
+}
+
+static int linear_complete(const char *prefix)
+{
+    struct finsh_syscall *index;
+    int n = 0;
+
+    for (index = _syscall_table_begin; index < _syscall_table_end; index++)
+    {
+        if (strncmp(index->name, "__cmd_", 6) == 0 &&
+            strncmp(prefix, &index->name[6], strlen(prefix)) == 0)
+        {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/* msh_auto_complete(): the matches are one run from the bound */
+static int sorted_complete(const char *prefix)
+{
+    struct finsh_syscall *index;
+    int n = 0;
+
+    for (index = finsh_syscall_bound("__cmd_", prefix, strlen(prefix));
+         index < _syscall_table_end; index++)
+    {
+        if (strncmp(index->name, "__cmd_", 6) != 0 ||
+            strncmp(prefix, &index->name[6], strlen(prefix)) != 0)
+        {
+            break;
+        }
+        n++;
+    }
+
+    return n;
+}
+
+static void check_lookups(void)
+{
+    static const char *prefixes[] =
+    {
+        "l", "ls", "list_", "hal_", "a", "audio_1", "adb", "zz", "_", "",
+    };
+    char cmd[NAME_LEN + 8];
+    const char *name;
+    int i, len;
+
+    for (i = 0; i < NCMD; i++)
+    {
+        name = names[i];
+        if (strncmp(name, "__cmd_", 6) == 0)
+        {
+            name += 6;
+        }
+        len = strlen(name);
+
+        /* the command line is not terminated after the command name */
+        snprintf(cmd, sizeof(cmd), "%s arg", name);
+        CHECK(sorted_get_cmd(cmd, len) == linear_get_cmd(cmd, len) &&
+              sorted_get_cmd(cmd, len) != NULL, "lookup %s", names[i]);
+
+        /* near misses */
+        CHECK(sorted_get_cmd(cmd, len - 1) == linear_get_cmd(cmd, len - 1), "short %s", names[i]);
+        snprintf(cmd, sizeof(cmd), "%sx", name);
+        CHECK(sorted_get_cmd(cmd, len + 1) == NULL, "long %s", names[i]);
+        CHECK(finsh_syscall_find("", names[i], strlen(names[i])) != NULL, "finsh lookup %s", names[i]);
+    }
+
+    /* an msh command is not reachable by its table name */
+    for (i = 0; i < NCMD; i++)
+    {
+        if (strncmp(names[i], "__cmd_", 6) == 0)
+        {
+            CHECK(sorted_get_cmd(names[i], strlen(names[i])) == NULL, "raw name %s", names[i]);
+            break;
+        }
+    }
+
+    for (i = 0; i < (int)(sizeof(prefixes) / sizeof(prefixes[0])); i++)
+    {
+        CHECK(sorted_complete(prefixes[i]) == linear_complete(prefixes[i]),
+              "complete \"%s\": %d vs %d", prefixes[i],
+              sorted_complete(prefixes[i]), linear_complete(prefixes[i]));
+    }
+}
+
+static void check_fallback(void)
+{
+    struct finsh_syscall tmp;
+    int i, j;
+
+    for (i = NCMD - 1; i > 0; i--)
+    {
+        j = rand() % (i + 1);
+        tmp = table[i];
+        table[i] = table[j];
+        table[j] = tmp;
+    }
+    finsh_syscall_index_init();
+    CHECK(!_syscall_table_sorted, "shuffled table reported sorted");
+
+    /* zero padding between entries, as x86_64 and MSVC lay the table out */
+    qsort(table, NCMD, sizeof(table[0]), cmp_entry);
+    memset(&table[NCMD / 2], 0, sizeof(table[0]));
+    finsh_syscall_index_init();
+    CHECK(!_syscall_table_sorted, "padded table reported sorted");
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(void)
+{
+    struct finsh_syscall *(*fn[2])(const char *, int) = { linear_get_cmd, sorted_get_cmd };
+    static const char *label[2] = { "linear", "sorted" };
+    volatile rt_ubase_t sink = 0;
+    const char *name;
+    double t0;
+    int k, i;
+
+    printf("msh_get_cmd, %d commands, ns per lookup:\n", NCMD);
+    for (k = 0; k < 2; k++)
+    {
+        t0 = now_ns();
+        for (i = 0; i < BENCH_LOOKUPS; i++)
+        {
+            name = names[(i * 7919) % NCMD];
+            if (strncmp(name, "__cmd_", 6) == 0)
+            {
+                name += 6;
+            }
+            sink += (rt_ubase_t)fn[k](name, strlen(name));
+        }
+        printf("  %-8s %8.0f\n", label[k], (now_ns() - t0) / BENCH_LOOKUPS);
+    }
+    (void)sink;
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    srand(0x34);
+    make_table();
+    finsh_syscall_index_init();
+    CHECK(_syscall_table_sorted, "sorted table reported unsorted");
+    check_lookups();
+    if (!quiet)
+    {
+        bench();
+    }
+    check_fallback();
+
+    printf("finsh symtab: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
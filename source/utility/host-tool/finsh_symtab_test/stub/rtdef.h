@@ -0,0 +1,19 @@
+/* host stub: the rtdef.h types used by subsys/finsh_cli/finsh_api.h */
+#ifndef __RT_DEF_H__
+#define __RT_DEF_H__
+
+typedef unsigned char   rt_uint8_t;
+typedef unsigned short  rt_uint16_t;
+typedef unsigned int    rt_uint32_t;
+typedef int             rt_int32_t;
+typedef unsigned long   rt_ubase_t;
+typedef int             rt_bool_t;
+
+#define RT_NULL         ((void *)0)
+#define RT_TRUE         1
+#define RT_FALSE        0
+
+#define SECTION(x)      __attribute__((section(x)))
+#define RT_USED         __attribute__((used))
+
+#endif
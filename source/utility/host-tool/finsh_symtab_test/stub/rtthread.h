@@ -0,0 +1,12 @@
+/* host stub: what subsys/finsh_cli/finsh.h and finsh_symtab.c need from rtthread.h */
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+#include <stdio.h>
+#include <string.h>
+
+#include <rtdef.h>
+
+#define rt_kprintf      printf
+
+#endif
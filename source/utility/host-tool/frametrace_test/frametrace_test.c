@@ -0,0 +1,359 @@
+/*
+ * Host test and benchmark for the frame latency trace of eyesee-mpp
+ * media/utils/mpp_frametrace.c. The clock is the test's own, so the
+ * latencies and histogram bins are exact.
+ *
+ *   frametrace_test         run the checks and the cost of one stage
+ *   frametrace_test -q      checks only
+ *
+ * Checks the stage and capture latencies, histogram bins and queue depths,
+ * exits without an enter, drops, the count of frames lost in a full stage,
+ * and that the Perfetto dump is well formed and keeps only the latest events.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <mpp_frametrace.h>
+
+#define DUMP_FILE   "frametrace_test.json"
+
+static int failures;
+static int64_t host_time_us;    /* 0: the real clock */
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+/* host stand-in for the one SystemBase.c call of mpp_frametrace.c */
+int64_t CDX_GetSysTimeUsMonotonic(void)
+{
+    struct timespec ts;
+
+    if (host_time_us)
+    {
+        return host_time_us;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static MPP_FRAMETRACE_STAT_S get_stat(MPP_FRAMETRACE_STAGE_E stage)
+{
+    MPP_FRAMETRACE_STAT_S stat;
+
+    memset(&stat, 0xff, sizeof(stat));
+    CHECK(MppFrameTraceGetStat(stage, &stat) == SUCCESS, "get stat of stage %d", stage);
+    return stat;
+}
+
+static void test_latency(void)
+{
+    MPP_FRAMETRACE_STAT_S stat;
+
+    CHECK(MppFrameTraceSetEnable(TRUE) == SUCCESS, "enable");
+    CHECK(gMppFrameTraceEnable, "enable flag");
+
+    /* frame 1: captured at 10000, in VENC from 10100 to 10600 */
+    host_time_us = 10000;
+    MPP_FrameTraceCapture(0, 1000);
+    MPP_FrameTraceCapture(1, 1000);     /* a second vipp of the sensor */
+    host_time_us = 10100;
+    MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_VENC, 0, 1000, 3);
+    host_time_us = 10600;
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, 0, 1000);
+
+    /* frame 2: 100us in VENC, 40ms after its capture */
+    host_time_us = 43000;
+    MPP_FrameTraceCapture(0, 34000);
+    host_time_us = 82900;
+    MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_VENC, 0, 34000, 0);
+    host_time_us = 83000;
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, 0, 34000);
+
+    /* left a stage it never entered, or another channel of it */
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, 0, 99);
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, 1, 1000);
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_ISE, 0, 1000);
+
+    stat = get_stat(MPP_FRAMETRACE_STAGE_VI);
+    CHECK(stat.mFrameCnt == 3, "VI frames %u", stat.mFrameCnt);
+
+    stat = get_stat(MPP_FRAMETRACE_STAGE_VENC);
+    CHECK(stat.mFrameCnt == 2, "VENC frames %u", stat.mFrameCnt);
+    CHECK(stat.mLostCnt == 0, "VENC lost %u", stat.mLostCnt);
+    CHECK(stat.mTotalLatencyUs == 600, "VENC total %llu", (unsigned long long)stat.mTotalLatencyUs);
+    CHECK(stat.mMaxLatencyUs == 500, "VENC max %u", stat.mMaxLatencyUs);
+    /* bins: [0,250) [250,500) [500,1000) ... */
+    CHECK(stat.mLatencyHist[0] == 1 && stat.mLatencyHist[2] == 1, "VENC latency bins %u %u %u",
+        stat.mLatencyHist[0], stat.mLatencyHist[1], stat.mLatencyHist[2]);
+    CHECK(stat.mTotalCaptureLatencyUs == 600 + 40000, "VENC capture total %llu",
+        (unsigned long long)stat.mTotalCaptureLatencyUs);
+    CHECK(stat.mMaxCaptureLatencyUs == 40000, "VENC capture max %u", stat.mMaxCaptureLatencyUs);
+    /* 40000us is in [32000,64000), bin 8 */
+    CHECK(stat.mCaptureLatencyHist[2] == 1 && stat.mCaptureLatencyHist[8] == 1, "VENC capture bins");
+    CHECK(stat.mQueueDepthHist[0] == 1 && stat.mQueueDepthHist[3] == 1, "VENC depth bins");
+
+    stat = get_stat(MPP_FRAMETRACE_STAGE_ISE);
+    CHECK(stat.mFrameCnt == 0, "ISE frames %u", stat.mFrameCnt);
+
+    CHECK(MppFrameTraceGetStat(MPP_FRAMETRACE_STAGE_MAX, &stat) != SUCCESS, "stage out of range");
+    CHECK(MppFrameTraceGetStat(MPP_FRAMETRACE_STAGE_VI, NULL) != SUCCESS, "NULL stat");
+}
+
+static void test_lost(void)
+{
+    MPP_FRAMETRACE_STAT_S stat;
+    int i;
+
+    CHECK(MppFrameTraceSetEnable(TRUE) == SUCCESS, "enable");
+    /* far more frames go in than the stage keeps, none comes out */
+    for (i = 0; i < 100; i++)
+    {
+        host_time_us = 1000 + i;
+        MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_EIS, 2, i * 33333, 100);
+    }
+    stat = get_stat(MPP_FRAMETRACE_STAGE_EIS);
+    CHECK(stat.mLostCnt > 0 && stat.mLostCnt < 100, "EIS lost %u", stat.mLostCnt);
+    CHECK(stat.mQueueDepthHist[MPP_FRAMETRACE_HIST_BINS - 1] == 100, "deep queues in the last bin");
+
+    /* the latest ones are still known, the first ones were given up */
+    host_time_us = 5000;
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_EIS, 2, 99 * 33333);
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_EIS, 2, 0);
+    stat = get_stat(MPP_FRAMETRACE_STAGE_EIS);
+    CHECK(stat.mFrameCnt == 1, "EIS frames %u", stat.mFrameCnt);
+    CHECK(stat.mMaxLatencyUs == 5000 - 1099, "EIS max %u", stat.mMaxLatencyUs);
+
+    /* entering again restarts the frame instead of losing a slot */
+    CHECK(MppFrameTraceSetEnable(TRUE) == SUCCESS, "enable");
+    for (i = 0; i < 100; i++)
+    {
+        host_time_us = 1000 + i;
+        MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_EIS, 2, 7, -1);
+    }
+    stat = get_stat(MPP_FRAMETRACE_STAGE_EIS);
+    CHECK(stat.mLostCnt == 0, "EIS re-enter lost %u", stat.mLostCnt);
+
+    /* disabled: the macros do nothing */
+    CHECK(MppFrameTraceSetEnable(FALSE) == SUCCESS, "disable");
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_EIS, 2, 7);
+    stat = get_stat(MPP_FRAMETRACE_STAGE_EIS);
+    CHECK(stat.mFrameCnt == 0, "frames while disabled %u", stat.mFrameCnt);
+}
+
+static void test_drop(void)
+{
+    MPP_FRAMETRACE_STAT_S stat;
+
+    CHECK(MppFrameTraceSetEnable(TRUE) == SUCCESS, "enable");
+    host_time_us = 1000;
+    MPP_FrameTraceCapture(0, 66);
+    MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_VENC, 0, 66, 0);
+    host_time_us = 2000;
+    MPP_FrameTraceDrop(MPP_FRAMETRACE_STAGE_VENC, 0, 66);
+    /* a dropped frame has left: a late exit or a second drop is not counted */
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, 0, 66);
+    MPP_FrameTraceDrop(MPP_FRAMETRACE_STAGE_VENC, 0, 66);
+    MPP_FrameTraceDrop(MPP_FRAMETRACE_STAGE_VENC, 0, 99);
+
+    stat = get_stat(MPP_FRAMETRACE_STAGE_VENC);
+    CHECK(stat.mDropCnt == 1, "VENC drops %u", stat.mDropCnt);
+    CHECK(stat.mFrameCnt == 0 && stat.mTotalLatencyUs == 0 && stat.mTotalCaptureLatencyUs == 0,
+        "a drop is not a latency");
+    CHECK(stat.mLostCnt == 0, "VENC lost %u", stat.mLostCnt);
+}
+
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char *buf;
+    long len;
+
+    if (!fp)
+    {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = malloc(len + 1);
+    len = fread(buf, 1, len, fp);
+    buf[len] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+static int count_of(const char *s, const char *what)
+{
+    int n = 0;
+
+    while ((s = strstr(s, what)))
+    {
+        n++;
+        s += strlen(what);
+    }
+    return n;
+}
+
+/* outside strings, brackets nest and commas only follow values */
+static int json_well_formed(const char *s)
+{
+    char stack[64];
+    int depth = 0, in_str = 0;
+
+    for (; *s; s++)
+    {
+        if (in_str)
+        {
+            if (*s == '\\' && s[1])
+            {
+                s++;
+            }
+            else if (*s == '"')
+            {
+                in_str = 0;
+            }
+            continue;
+        }
+        switch (*s)
+        {
+        case '"':
+            in_str = 1;
+            break;
+        case '{':
+        case '[':
+            if (depth == (int)sizeof(stack))
+            {
+                return 0;
+            }
+            stack[depth++] = *s;
+            break;
+        case '}':
+        case ']':
+            if (!depth || stack[--depth] != (*s == '}' ? '{' : '['))
+            {
+                return 0;
+            }
+            break;
+        case ',':
+            {
+                const char *p = s + 1;
+
+                while (*p == ' ' || *p == '\n')
+                {
+                    p++;
+                }
+                if (*p == '}' || *p == ']')
+                {
+                    return 0;
+                }
+            }
+            break;
+        }
+    }
+    return depth == 0 && !in_str;
+}
+
+static void test_dump(void)
+{
+    char *json;
+    int i;
+
+    CHECK(MppFrameTraceSetEnable(TRUE) == SUCCESS, "enable");
+    host_time_us = 100;
+    MPP_FrameTraceCapture(0, 500);
+    MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_ISE, 0, 500, 1);
+    MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_ISE, 0, 500);
+    MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_MUXER, 1, 500, -1);
+    MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_VENC, 0, 500, 0);
+    MPP_FrameTraceDrop(MPP_FRAMETRACE_STAGE_VENC, 0, 500);
+    CHECK(MppFrameTraceDump(DUMP_FILE) == SUCCESS, "dump");
+    json = read_file(DUMP_FILE);
+    CHECK(json != NULL, "read %s", DUMP_FILE);
+    if (json)
+    {
+        CHECK(json_well_formed(json), "dump is not well formed JSON");
+        CHECK(count_of(json, "\"ph\":\"i\"") == 1, "capture events");
+        CHECK(count_of(json, "\"ph\":\"b\"") == 3, "enter events");
+        CHECK(count_of(json, "\"ph\":\"e\"") == 2, "exit events");
+        CHECK(count_of(json, "\"drop\":1") == 1, "drop events");
+        CHECK(strstr(json, "\"name\":\"ISE 0\"") && strstr(json, "\"name\":\"Muxer 1\""), "track names");
+        CHECK(strstr(json, "\"id\":500"), "pts as slice id");
+        free(json);
+    }
+
+    /* the log wraps: only the latest events are dumped */
+    for (i = 0; i < MPP_FRAMETRACE_EVENT_NUM; i++)
+    {
+        host_time_us = 1000 + i;
+        MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_VENC, 0, i, 0);
+        MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, 0, i);
+    }
+    CHECK(MppFrameTraceDump(DUMP_FILE) == SUCCESS, "dump");
+    json = read_file(DUMP_FILE);
+    if (json)
+    {
+        CHECK(json_well_formed(json), "wrapped dump is not well formed JSON");
+        CHECK(count_of(json, "\"ph\":\"b\"") + count_of(json, "\"ph\":\"e\"") == MPP_FRAMETRACE_EVENT_NUM,
+            "wrapped dump keeps %d events", MPP_FRAMETRACE_EVENT_NUM);
+        CHECK(!strstr(json, "\"name\":\"ISE 0\""), "old events are dropped");
+        free(json);
+    }
+    CHECK(MppFrameTraceDump(NULL) != SUCCESS, "dump to NULL");
+    remove(DUMP_FILE);
+}
+
+static void bench(void)
+{
+    struct timespec t0, t1;
+    double ns;
+    int i, n = 2000000;
+
+    host_time_us = 0;
+    MppFrameTraceSetEnable(TRUE);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++)
+    {
+        MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_VENC, 0, i, 2);
+        MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, 0, i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / n;
+    printf("enter+exit, trace on:  %6.1f ns\n", ns);
+
+    MppFrameTraceSetEnable(FALSE);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < n; i++)
+    {
+        MPP_FrameTraceEnter(MPP_FRAMETRACE_STAGE_VENC, 0, i, 2);
+        MPP_FrameTraceExit(MPP_FRAMETRACE_STAGE_VENC, 0, i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / n;
+    printf("enter+exit, trace off: %6.1f ns\n", ns);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    test_latency();
+    test_lost();
+    test_drop();
+    test_dump();
+    if (!quiet)
+    {
+        bench();
+    }
+
+    printf("frametrace_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * Forced include for building the busybox archival sources on the host.
+ *
+ * Pull in the system headers first, then hide the host architecture so
+ * platform.h picks the same "int smallint" branch as the ARM target and
+ * does not clash with bb_archive.h.
+ */
+#include <setjmp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <limits.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#undef __x86_64__
+#undef __i386__
+#undef i386
+
+#define CONFIG_ARCHIVAL_FAST_INFLATE 1
@@ -0,0 +1,209 @@
+/*
+ * Host benchmark for the gunzip decoders in ekernel/subsys/archival.
+ *
+ *   inflate_bench file.gz ...
+ *
+ * Every file is decompressed with
+ *   busybox  - the original inflate_codes() decoder (gunzip_fast_inflate = 0)
+ *   fast     - inflate_fast.c behind the same unpack_gz_stream() entry
+ *   fast-mem - fast_gunzip_mem(), memory to memory as used for images
+ * and the throughput is reported in MB/s of decompressed output. The gzip
+ * trailer (crc32 + length) is verified on every run by each decoder.
+ * Throughput is computed from the size in the last gzip trailer, so for
+ * multi member files (*.cat.gz from "make test") the stream figures are
+ * understated; fast-mem only decodes the first member.
+ * Afterwards the compressed data is mutated at random and fed to the fast
+ * decoder to make sure corrupted input is rejected without crashing.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "glibbb.h"
+#include "bb_archive.h"
+#include "inflate_fast.h"
+
+#define MIN_BENCH_SEC   0.5
+#define FUZZ_ROUNDS     300
+
+/* libbb helpers the archival sources expect */
+void *xmalloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (!p)
+    {
+        perror("malloc");
+        exit(1);
+    }
+    return p;
+}
+
+void *xzalloc(size_t size)
+{
+    void *p = xmalloc(size);
+
+    memset(p, 0, size);
+    return p;
+}
+
+void *xmalloc_read(int fd, size_t *maxsz_p)
+{
+    (void)fd;
+    (void)maxsz_p;
+    return NULL;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long long run_stream(const char *path, int fast)
+{
+    transformer_state_t xstate;
+    long long ret;
+    int fd, null_fd;
+
+    fd = open(path, O_RDONLY);
+    null_fd = open("/dev/null", O_WRONLY);
+    if (fd < 0 || null_fd < 0)
+    {
+        perror(path);
+        exit(1);
+    }
+
+    gunzip_fast_inflate = fast;
+    init_transformer_state(&xstate);
+    xstate.src_fd = fd;
+    xstate.dst_fd = null_fd;
+    ret = unpack_gz_stream(&xstate);
+    close(fd);
+    close(null_fd);
+    return ret;
+}
+
+static uint32_t gz_isize(const unsigned char *gz, size_t len)
+{
+    const unsigned char *p = gz + len - 4;
+
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static unsigned char *read_file(const char *path, size_t *len)
+{
+    struct stat st;
+    unsigned char *buf;
+    FILE *fp;
+
+    fp = fopen(path, "rb");
+    if (!fp || fstat(fileno(fp), &st))
+    {
+        perror(path);
+        exit(1);
+    }
+    buf = xmalloc(st.st_size + 1);
+    *len = fread(buf, 1, st.st_size, fp);
+    fclose(fp);
+    return buf;
+}
+
+static int fuzz(const unsigned char *gz, size_t gz_len, size_t out_len)
+{
+    unsigned char *bad = xmalloc(gz_len);
+    unsigned char *out = xmalloc(out_len + 1);
+    size_t n;
+    int r, i, rejected = 0;
+
+    for (r = 0; r < FUZZ_ROUNDS; r++)
+    {
+        memcpy(bad, gz, gz_len);
+        for (i = 0; i < 1 + r % 8; i++)
+        {
+            /* keep the gzip header, hit the deflate data */
+            bad[10 + rand() % (gz_len - 18)] ^= 1 << (rand() % 8);
+        }
+        if (fast_gunzip_mem(out, out_len + 1, bad, gz_len, &n) != 0)
+        {
+            rejected++;
+        }
+    }
+    free(bad);
+    free(out);
+    return rejected;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *names[] = { "busybox", "fast", "fast-mem" };
+    unsigned char *gz, *out;
+    size_t gz_len, out_len, n;
+    double t0, t, mbs[3];
+    long loops;
+    int i, m, failures = 0;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s file.gz ...\n", argv[0]);
+        return 2;
+    }
+
+    srand(0x1f8b);
+    printf("%-28s %10s %10s %10s %10s  %s\n", "file", "bytes", names[0], names[1], names[2], "fuzz");
+    for (i = 1; i < argc; i++)
+    {
+        gz = read_file(argv[i], &gz_len);
+        if (gz_len < 18)
+        {
+            printf("%-28s too short\n", argv[i]);
+            free(gz);
+            continue;
+        }
+        out_len = gz_isize(gz, gz_len);
+        out = xmalloc(out_len + 1);
+
+        for (m = 0; m < 3; m++)
+        {
+            loops = 0;
+            t0 = now_sec();
+            do
+            {
+                if (m < 2)
+                {
+                    if (run_stream(argv[i], m) < 0)
+                    {
+                        printf("%s: %s decoder failed\n", argv[i], names[m]);
+                        failures++;
+                        break;
+                    }
+                }
+                else if (fast_gunzip_mem(out, out_len + 1, gz, gz_len, &n) != 0 || n != out_len)
+                {
+                    printf("%s: %s decoder failed\n", argv[i], names[m]);
+                    failures++;
+                    break;
+                }
+                loops++;
+                t = now_sec() - t0;
+            } while (t < MIN_BENCH_SEC);
+            mbs[m] = (double)out_len * loops / (now_sec() - t0) / 1e6;
+        }
+
+        printf("%-28s %10zu %7.1f MB/s %5.1f MB/s %5.1f MB/s  %d/%d rejected\n",
+               argv[i], out_len, mbs[0], mbs[1], mbs[2],
+               fuzz(gz, gz_len, out_len), FUZZ_ROUNDS);
+        free(out);
+        free(gz);
+    }
+
+    printf("inflate conformance: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
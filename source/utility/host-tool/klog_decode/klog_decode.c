@@ -0,0 +1,248 @@
+/*
+ * Decoder for the deferred console log, ekernel/core/rt-thread/klog.c.
+ *
+ *   klog_decode [-t] <kernel.elf> <dump>
+ *
+ * <dump> is a "klog dump <file>" output pulled over adb, or a RAM dump
+ * that contains the ring: it is found by its magic. The messages still
+ * queued (tail to head) are formatted with the format strings read from
+ * <kernel.elf>, or copied in the entry when they were not in the image,
+ * and printed; -t prefixes each with its tick.
+ */
+#include <elf.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtthread.h>
+#include <klog.h>
+
+struct section
+{
+    unsigned long long addr;
+    unsigned long long size;
+    const char *data;
+};
+
+static struct section *sections;
+static int nsections;
+
+static char *load_file(const char *path, long *size)
+{
+    FILE *fp = fopen(path, "rb");
+    char *buf;
+
+    if (!fp)
+    {
+        perror(path);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = malloc(*size + 1);
+    if (!buf || fread(buf, 1, *size, fp) != (size_t)*size)
+    {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(fp);
+        free(buf);
+        return NULL;
+    }
+    buf[*size] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+/* the allocated sections with file contents, ELF32 or ELF64 */
+static int load_elf(const char *image, long size)
+{
+    const unsigned char *ident = (const unsigned char *)image;
+    int i, n;
+
+    if (size < EI_NIDENT || memcmp(ident, ELFMAG, SELFMAG))
+    {
+        return -1;
+    }
+
+    if (ident[EI_CLASS] == ELFCLASS32)
+    {
+        const Elf32_Ehdr *eh = (const Elf32_Ehdr *)image;
+        const Elf32_Shdr *sh = (const Elf32_Shdr *)(image + eh->e_shoff);
+
+        n = eh->e_shnum;
+        if (eh->e_shoff + (long)n * sizeof(*sh) > (unsigned long)size)
+        {
+            return -1;
+        }
+        sections = calloc(n, sizeof(*sections));
+        for (i = 0; i < n; i++)
+        {
+            if ((sh[i].sh_flags & SHF_ALLOC) && sh[i].sh_type != SHT_NOBITS &&
+                sh[i].sh_offset + sh[i].sh_size <= (unsigned long)size)
+            {
+                sections[nsections].addr = sh[i].sh_addr;
+                sections[nsections].size = sh[i].sh_size;
+                sections[nsections].data = image + sh[i].sh_offset;
+                nsections++;
+            }
+        }
+        return 0;
+    }
+
+    if (ident[EI_CLASS] == ELFCLASS64)
+    {
+        const Elf64_Ehdr *eh = (const Elf64_Ehdr *)image;
+        const Elf64_Shdr *sh = (const Elf64_Shdr *)(image + eh->e_shoff);
+
+        n = eh->e_shnum;
+        if (eh->e_shoff + (long)n * sizeof(*sh) > (unsigned long)size)
+        {
+            return -1;
+        }
+        sections = calloc(n, sizeof(*sections));
+        for (i = 0; i < n; i++)
+        {
+            if ((sh[i].sh_flags & SHF_ALLOC) && sh[i].sh_type != SHT_NOBITS &&
+                sh[i].sh_offset + sh[i].sh_size <= (unsigned long)size)
+            {
+                sections[nsections].addr = sh[i].sh_addr;
+                sections[nsections].size = sh[i].sh_size;
+                sections[nsections].data = image + sh[i].sh_offset;
+                nsections++;
+            }
+        }
+        return 0;
+    }
+
+    return -1;
+}
+
+/* the format string at a kernel address, NULL if not in the image */
+static const char *lookup_string(rt_uint32_t addr)
+{
+    int i;
+
+    for (i = 0; i < nsections; i++)
+    {
+        if (addr >= sections[i].addr && addr < sections[i].addr + sections[i].size)
+        {
+            const char *s = sections[i].data + (addr - sections[i].addr);
+
+            if (memchr(s, '\0', sections[i].size - (addr - sections[i].addr)))
+            {
+                return s;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static const struct rt_klog_ring *find_ring(const char *dump, long size)
+{
+    const struct rt_klog_ring *ring;
+    long off, hdr = offsetof(struct rt_klog_ring, data);
+
+    for (off = 0; off + hdr <= size; off += 4)
+    {
+        ring = (const struct rt_klog_ring *)(dump + off);
+        if (ring->magic == RT_KLOG_MAGIC && ring->size >= 64 &&
+            !(ring->size & (ring->size - 1)) && off + hdr + (long)ring->size <= size &&
+            ring->head - ring->tail <= ring->size)
+        {
+            return ring;
+        }
+    }
+
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    static char line[4096];
+    const struct rt_klog_ring *ring;
+    const struct rt_klog_entry *entry;
+    const char *image, *dump, *fmt, *text;
+    long image_size, dump_size;
+    rt_uint32_t tail, off, count = 0;
+    int ticks = 0;
+
+    if (argc > 1 && !strcmp(argv[1], "-t"))
+    {
+        ticks = 1;
+        argc--;
+        argv++;
+    }
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: klog_decode [-t] <kernel.elf> <dump>\n");
+        return 2;
+    }
+
+    image = load_file(argv[1], &image_size);
+    dump = load_file(argv[2], &dump_size);
+    if (!image || !dump)
+    {
+        return 1;
+    }
+    if (load_elf(image, image_size))
+    {
+        fprintf(stderr, "%s: not an ELF image\n", argv[1]);
+        return 1;
+    }
+    ring = find_ring(dump, dump_size);
+    if (!ring)
+    {
+        fprintf(stderr, "%s: no klog ring found\n", argv[2]);
+        return 1;
+    }
+
+    tail = ring->tail;
+    while (tail != ring->head)
+    {
+        off = tail & (ring->size - 1);
+        if (ring->size - off < sizeof(*entry))
+        {
+            tail += ring->size - off;
+            continue;
+        }
+
+        entry = (const struct rt_klog_entry *)&ring->data[off];
+        if (entry->pos != RT_KLOG_POS_DONE(tail) || entry->size < sizeof(*entry) || off + entry->size > ring->size)
+        {
+            /* claimed but never finished, the writer was interrupted for good */
+            fprintf(stderr, "klog_decode: incomplete entry at %u, stopping\n", tail);
+            break;
+        }
+        tail += entry->size;
+        if (entry->flags & RT_KLOG_ENTRY_PAD)
+        {
+            continue;
+        }
+
+        /* a format copied into the entry is found there by rt_klog_format() */
+        fmt = entry->flags & RT_KLOG_ENTRY_FMT ? "" : lookup_string(entry->fmt);
+        if (!fmt)
+        {
+            printf("<format at 0x%08x not in %s>\n", entry->fmt, argv[1]);
+            continue;
+        }
+        rt_klog_format(fmt, entry, line, sizeof(line));
+        text = line;
+        if ((entry->flags & RT_KLOG_LEVEL) && text[0] == '<' &&
+            text[1] >= '0' && text[1] <= '7' && text[2] == '>')
+        {
+            text += 3;
+        }
+        if (ticks)
+        {
+            printf("[%10u] ", entry->tick);
+        }
+        fputs(text, stdout);
+        count++;
+    }
+
+    fprintf(stderr, "klog_decode: %u messages, %u dropped\n", count, ring->dropped);
+    return 0;
+}
@@ -0,0 +1,403 @@
+/*
+ * Host test and benchmark for the deferred console log,
+ * ekernel/core/rt-thread/klog.c, with pthreads for the rt-thread calls.
+ *
+ *   klog_test                run the checks and the producer benchmark
+ *   klog_test -q             checks only
+ *
+ * Formats are compared with the C library, a format outside the image
+ * (a module's) must outlive its memory, a %s that changes while it is
+ * logged must not overrun its entry, several producers log into the ring
+ * while the klog thread drains it and every message must arrive once and
+ * in order, and the drained ring is left zeroed. Last, the klog thread is
+ * paused and the ring is written to klog.bin with the expected text in
+ * klog.txt, for the Makefile to run klog_decode on.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rtthread.h>
+#include <klog.h>
+
+#define PRODUCERS       4
+#define MESSAGES        20000
+#define DUMP_MESSAGES   40
+
+extern struct rt_klog_ring rt_klog_ring;
+extern volatile int host_pause;
+extern volatile int host_paused;
+
+static char output[64 * 1024 * 1024];
+static size_t output_len;
+static pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+void rt_klog_output(const char *str, rt_size_t length)
+{
+    pthread_mutex_lock(&output_lock);
+    if (output_len + length < sizeof(output))
+    {
+        memcpy(output + output_len, str, length);
+        output_len += length;
+    }
+    pthread_mutex_unlock(&output_lock);
+}
+
+static int klog(const char *fmt, ...)
+{
+    va_list args;
+    int ret;
+
+    va_start(args, fmt);
+    ret = rt_klog_vprintf(0, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+static void wait_drained(void)
+{
+    while (__atomic_load_n(&rt_klog_ring.tail, __ATOMIC_ACQUIRE) !=
+           __atomic_load_n(&rt_klog_ring.head, __ATOMIC_ACQUIRE))
+    {
+        usleep(1000);
+    }
+    usleep(5000);
+}
+
+static void take_output(char *buf, size_t size)
+{
+    pthread_mutex_lock(&output_lock);
+    if (output_len >= size)
+    {
+        output_len = size - 1;
+    }
+    memcpy(buf, output, output_len);
+    buf[output_len] = '\0';
+    output_len = 0;
+    pthread_mutex_unlock(&output_lock);
+}
+
+static void check_formats(void)
+{
+    static char got[8192];
+    char want[8192];
+    char local[32];
+    size_t n = 0;
+
+    strcpy(local, "stack string");
+#define BOTH(...)                                                       \
+    do {                                                                \
+        CHECK(klog(__VA_ARGS__) == 0, "not queued: %s", #__VA_ARGS__);  \
+        n += snprintf(want + n, sizeof(want) - n, __VA_ARGS__);         \
+    } while (0)
+
+    BOTH("plain text\n");
+    BOTH("%d %i %u %x %X %o\n", -42, 7, 3000000000u, 0xbeef, 0xbeef, 8);
+    BOTH("[%5d] [%-5d] [%05d] [%+d] [% d] [%#x]\n", 12, 12, 12, 12, 12, 255);
+    BOTH("[%s] [%10s] [%-10s] [%.3s]\n", "abc", "abc", "abc", "abcdef");
+    BOTH("[%*d] [%-*d] [%.*s]\n", 6, 1, 6, 2, 2, "xyz");
+    BOTH("%c%c%c %% %hd\n", 'k', 'l', 'g', (short)-3);
+    BOTH("%s copied before the caller returns\n", local);
+    BOTH("%08x %p\n", 0x1234, (void *)0x1000);
+    BOTH("%s\n", "a string longer than the cut at one hundred and twenty eight "
+         "bytes is kept only up to that point, the rest of it is dropped by klog");
+#undef BOTH
+
+    strcpy(local, "overwritten");
+    wait_drained();
+    take_output(got, sizeof(got));
+
+    /* where klog differs from libc: %s is cut at RT_KLOG_STR_MAX, %p is
+     * zero padded hex like rt_vsnprintf() prints it */
+    {
+        char *p = strstr(want, "0x1000");
+
+        if (p)
+        {
+            memmove(p + 2, p, strlen(p) + 1);
+            memcpy(p, "00001000", 8);
+        }
+        p = strstr(want, "a string longer");
+        if (p && strlen(p) > RT_KLOG_STR_MAX + 1)
+        {
+            strcpy(p + RT_KLOG_STR_MAX, "\n");
+        }
+    }
+    CHECK(!strcmp(got, want), "formats differ:\n--- klog\n%s--- libc\n%s", got, want);
+}
+
+static void pause_thread(void)
+{
+    host_pause = 1;
+    while (!host_paused)
+    {
+        usleep(1000);
+    }
+}
+
+/* a format in heap memory stands for one in a module unloaded meanwhile */
+static void check_module_format(void)
+{
+    static char got[1024];
+    char *fmt = strdup("module %s: %d of %d\n");
+    char *str = strdup("sensor");
+
+    pause_thread();
+    CHECK(klog(fmt, str, 1, 2) == 0, "module format not queued");
+    memset(fmt, '#', strlen(fmt));
+    memset(str, '#', strlen(str));
+    free(fmt);
+    free(str);
+    host_pause = 0;
+    wait_drained();
+    take_output(got, sizeof(got));
+    CHECK(!strcmp(got, "module sensor: 1 of 2\n"), "module format: \"%s\"", got);
+}
+
+static char changing[RT_KLOG_STR_MAX];
+static volatile int changing_stop;
+
+static void *changer_main(void *arg)
+{
+    while (!changing_stop)
+    {
+        memset(changing, 'L', sizeof(changing) - 1);
+        changing[sizeof(changing) - 1] = '\0';
+        changing[2] = '\0';
+    }
+    return NULL;
+}
+
+/* the string grows and shrinks between the sizing and the copy */
+static void check_changing_string(void)
+{
+    pthread_t tid;
+    char *buf, *line, *save;
+    int i, queued = 0, lines = 0;
+    rt_uint32_t dropped0 = rt_klog_ring.dropped;
+
+    strcpy(changing, "ab");
+    changing_stop = 0;
+    pthread_create(&tid, NULL, changer_main, NULL);
+    for (i = 0; i < MESSAGES; i++)
+    {
+        if (klog("c %s %d end\n", changing, i) == 0)
+        {
+            queued++;
+        }
+        if ((i & 31) == 31)
+        {
+            usleep(1000);
+        }
+    }
+    changing_stop = 1;
+    pthread_join(tid, NULL);
+    wait_drained();
+
+    buf = malloc(sizeof(output));
+    take_output(buf, sizeof(output));
+    for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save))
+    {
+        if (!strncmp(line, "klog: ", 6))
+        {
+            continue;
+        }
+        /* a cut string leaves "%d end" literal, anything else is an overrun */
+        CHECK(!strncmp(line, "c ", 2) && strlen(line) < 2 + RT_KLOG_STR_MAX + 16,
+              "bad line \"%.40s\"", line);
+        lines++;
+    }
+    free(buf);
+    CHECK((rt_uint32_t)lines + rt_klog_ring.dropped - dropped0 == (rt_uint32_t)queued,
+          "%d lines, %u dropped, %d queued", lines, rt_klog_ring.dropped - dropped0, queued);
+}
+
+struct producer
+{
+    pthread_t tid;
+    int id;
+    int queued;
+};
+
+static void *producer_main(void *arg)
+{
+    struct producer *p = arg;
+    int i;
+
+    for (i = 0; i < MESSAGES; i++)
+    {
+        if (klog("p%d seq %d %s\n", p->id, i, i & 1 ? "odd" : "even number") == 0)
+        {
+            p->queued++;
+        }
+        if ((i & 31) == 31)
+        {
+            usleep(1000);
+        }
+    }
+    return NULL;
+}
+
+static void check_producers(void)
+{
+    struct producer prod[PRODUCERS];
+    int last[PRODUCERS];
+    int received = 0, id, seq, i;
+    rt_uint32_t dropped0 = rt_klog_ring.dropped;
+    char *buf, *line, *save;
+
+    for (i = 0; i < PRODUCERS; i++)
+    {
+        prod[i].id = i;
+        prod[i].queued = 0;
+        last[i] = -1;
+        pthread_create(&prod[i].tid, NULL, producer_main, &prod[i]);
+    }
+    for (i = 0; i < PRODUCERS; i++)
+    {
+        pthread_join(prod[i].tid, NULL);
+    }
+    wait_drained();
+
+    buf = malloc(sizeof(output));
+    take_output(buf, sizeof(output));
+    for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save))
+    {
+        if (!strncmp(line, "klog: ", 6))
+        {
+            continue;
+        }
+        if (sscanf(line, "p%d seq %d", &id, &seq) != 2 || id < 0 || id >= PRODUCERS)
+        {
+            CHECK(0, "bad line \"%s\"", line);
+            break;
+        }
+        CHECK(seq > last[id], "p%d: %d after %d", id, seq, last[id]);
+        CHECK(!strcmp(strchr(strchr(line, ' ') + 5, ' ') + 1, seq & 1 ? "odd" : "even number"),
+              "bad string in \"%s\"", line);
+        last[id] = seq;
+        received++;
+    }
+    free(buf);
+
+    for (i = 0; i < PRODUCERS; i++)
+    {
+        CHECK(last[i] >= 0, "nothing from p%d", i);
+    }
+    CHECK((rt_uint32_t)received + rt_klog_ring.dropped - dropped0 == PRODUCERS * MESSAGES,
+          "%d received, %u dropped, %d sent", received, rt_klog_ring.dropped - dropped0,
+          PRODUCERS * MESSAGES);
+    printf("producers: %d messages, %u dropped with a %u byte ring\n", received,
+           rt_klog_ring.dropped - dropped0, rt_klog_ring.size);
+
+    /* after many laps, a drained ring holds no word a writer could be taken for */
+    for (i = 0; i < (int)rt_klog_ring.size && !rt_klog_ring.data[i]; i++)
+    {
+    }
+    CHECK(i == (int)rt_klog_ring.size, "drained ring not zeroed at %d", i);
+}
+
+/* leave entries in the ring, across the wrap, for klog_decode */
+static void write_dump(void)
+{
+    FILE *fp;
+    char want[8192];
+    char *fmt;
+    size_t n = 0;
+    int i;
+
+    pause_thread();
+
+    for (i = 0; i < DUMP_MESSAGES; i++)
+    {
+        klog("dump %d of %d: %s 0x%08x\n", i, DUMP_MESSAGES, "queued", i * 0x1111);
+        n += snprintf(want + n, sizeof(want) - n, "dump %d of %d: %s 0x%08x\n",
+                      i, DUMP_MESSAGES, "queued", i * 0x1111);
+    }
+
+    /* and one the decoder cannot look up in the ELF */
+    fmt = strdup("dump from a module: %s\n");
+    klog(fmt, "copied");
+    free(fmt);
+    n += snprintf(want + n, sizeof(want) - n, "dump from a module: %s\n", "copied");
+
+    fp = fopen("klog.bin", "wb");
+    fwrite(&rt_klog_ring, sizeof(rt_klog_ring), 1, fp);
+    fclose(fp);
+    fp = fopen("klog.txt", "wb");
+    fwrite(want, 1, n, fp);
+    fclose(fp);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(void)
+{
+    static char line[RT_CONSOLEBUF_SIZE];
+    double t0, t_klog = 0, t_fmt;
+    int i, j, batches = 100;
+
+    /* batches that fit the ring, drained in between outside the timing */
+    for (j = 0; j < batches; j++)
+    {
+        t0 = now_ns();
+        for (i = 0; i < 64; i++)
+        {
+            klog("[%s:%04u]: buffer %d/%d at 0x%08x\n", __func__, __LINE__, i, j, i * 64);
+        }
+        t_klog += now_ns() - t0;
+        wait_drained();
+        take_output(line, sizeof(line));
+    }
+    t_klog /= batches * 64;
+
+    t0 = now_ns();
+    for (j = 0; j < batches * 64; j++)
+    {
+        snprintf(line, sizeof(line), "[%s:%04u]: buffer %d/%d at 0x%08x\n",
+                 __func__, __LINE__, j & 63, j >> 6, j * 64);
+    }
+    t_fmt = (now_ns() - t0) / (batches * 64);
+    printf("caller cost, ns per message: klog %.0f, formatting alone %.0f, "
+           "before any uart wait\n", t_klog, t_fmt);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    CHECK(klog("before init\n") == -1, "queued before the klog thread runs");
+    rt_klog_init();
+
+    check_formats();
+    check_module_format();
+    check_changing_string();
+    check_producers();
+    if (!quiet)
+    {
+        bench();
+    }
+    write_dump();
+
+    printf("klog: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * host stand-ins for the rt-thread calls of core/rt-thread/klog.c: threads
+ * are pthreads, ticks are milliseconds. host_pause stops the klog thread at
+ * its next delay, for tests that need entries left in the ring.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rtthread.h>
+
+struct rt_thread
+{
+    pthread_t tid;
+    void (*entry)(void *parameter);
+    void *parameter;
+};
+
+static __thread rt_thread_t host_self;
+volatile int host_pause;
+volatile int host_paused;
+
+static void *host_thread_main(void *arg)
+{
+    rt_thread_t thread = arg;
+
+    host_self = thread;
+    thread->entry(thread->parameter);
+    return NULL;
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick)
+{
+    rt_thread_t thread = calloc(1, sizeof(*thread));
+
+    if (thread)
+    {
+        thread->entry = entry;
+        thread->parameter = parameter;
+    }
+    return thread;
+}
+
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    pthread_create(&thread->tid, NULL, host_thread_main, thread);
+    pthread_detach(thread->tid);
+    return RT_EOK;
+}
+
+rt_thread_t rt_thread_self(void)
+{
+    return host_self;
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+    do
+    {
+        host_paused = host_pause;
+        usleep(tick * 1000);
+    } while (host_pause);
+    host_paused = 0;
+    return RT_EOK;
+}
+
+rt_tick_t rt_tick_get(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (rt_tick_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms)
+{
+    return ms;
+}
+
+__attribute__((weak)) void rt_klog_output(const char *str, rt_size_t length)
+{
+    fwrite(str, 1, length, stdout);
+}
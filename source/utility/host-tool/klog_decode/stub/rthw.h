@@ -0,0 +1,7 @@
+/* host stub: interrupt masking is never needed, the host has CAS */
+#ifndef __RT_HW_H__
+#define __RT_HW_H__
+
+#include <rtthread.h>
+
+#endif
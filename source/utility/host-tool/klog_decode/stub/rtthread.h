@@ -0,0 +1,45 @@
+/* host stub: what core/rt-thread/klog.c needs from rtthread.h, see rthost.c */
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef unsigned char       rt_uint8_t;
+typedef unsigned short      rt_uint16_t;
+typedef unsigned int        rt_uint32_t;
+typedef unsigned long long  rt_uint64_t;
+typedef int                 rt_int32_t;
+typedef long                rt_base_t;
+typedef unsigned long       rt_ubase_t;
+typedef unsigned long       rt_size_t;
+typedef unsigned int        rt_tick_t;
+typedef long                rt_err_t;
+
+#define RT_NULL                 ((void *)0)
+#define RT_EOK                  0
+#define RT_ENOMEM               5
+#define RT_THREAD_PRIORITY_MAX  32
+#define RT_CONSOLEBUF_SIZE      1024
+
+typedef struct rt_thread *rt_thread_t;
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_startup(rt_thread_t thread);
+rt_thread_t rt_thread_self(void);
+rt_err_t rt_thread_delay(rt_tick_t tick);
+rt_tick_t rt_tick_get(void);
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms);
+
+#define rt_memcpy       memcpy
+#define rt_memset       memset
+#define rt_strlen       strlen
+#define rt_strcmp       strcmp
+#define rt_snprintf     snprintf
+#define rt_kprintf      printf
+
+#define RTM_EXPORT(symbol)
+
+#endif
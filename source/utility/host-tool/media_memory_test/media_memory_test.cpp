@@ -0,0 +1,258 @@
+/*
+ * Host test and benchmark for CMediaMemory views and CMediaMemoryPool of
+ * eyesee-mpp framework/utils/CMediaMemory.cpp, which carry the pictures
+ * of CallbackNotifier.
+ *
+ *   media_memory_test       run the checks and the picture copy benchmark
+ *   media_memory_test -q    checks only
+ *
+ * Checks that a view reads its packs in place, gathers them once and only
+ * when asked, releases its owner's memory exactly once, and that the pool
+ * recycles blocks, keeps no more than asked and can die before its blocks.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <CMediaMemory.h>
+
+using namespace EyeseeLinux;
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static void test_block(void)
+{
+    CMediaMemory empty;
+    CHECK(empty.getPointer() == NULL && empty.getSize() == 0, "empty block");
+    CHECK(empty.getPackCount() == 0, "empty block packs");
+
+    CMediaMemory a(16);
+    memset(a.getPointer(), 'a', 16);
+    CHECK(a.getPackCount() == 1, "block is one pack");
+
+    CMediaMemory b(std::move(a));
+    CHECK(a.getPointer() == NULL && a.getSize() == 0, "moved from");
+    CHECK(b.getSize() == 16 && ((char*)b.getPointer())[15] == 'a', "moved to");
+
+    CMediaMemory c(8);
+    c = std::move(b);
+    CHECK(c.getSize() == 16 && ((char*)c.getPointer())[0] == 'a', "move assigned");
+    CHECK(b.getSize() == 0, "move assigned from");
+
+    int released = 0;
+    char borrowed[4] = {1, 2, 3, 4};
+    {
+        CMediaMemory d(borrowed, sizeof(borrowed), [&released]() { released++; });
+        CHECK(d.getPointer() == borrowed, "borrowed pointer");
+    }
+    CHECK(released == 1, "borrowed block released %d times", released);
+}
+
+static void test_view(void)
+{
+    char pack0[100], pack1[50];
+    const char trailer[4] = {'t', 'a', 'i', 'l'};
+    int released = 0;
+
+    for (int i = 0; i < (int)sizeof(pack0); i++)
+    {
+        pack0[i] = (char)i;
+    }
+    for (int i = 0; i < (int)sizeof(pack1); i++)
+    {
+        pack1[i] = (char)(100 + i);
+    }
+
+    std::shared_ptr<CMediaMemory> spView = std::make_shared<CMediaMemory>();
+    CHECK(spView->addPack(pack0, sizeof(pack0)) == 0, "add pack0");
+    CHECK(spView->addPack(NULL, 0) == 0, "empty pack is skipped");
+    CHECK(spView->addPack(pack1, sizeof(pack1)) == 0, "add pack1");
+    CHECK(spView->addPackCopy(trailer, sizeof(trailer)) == 0, "add trailer");
+    spView->setReleaseCallback([&released]() { released++; });
+
+    CHECK(spView->getSize() == 154, "view size %d", spView->getSize());
+    CHECK(spView->getPackCount() == 3, "view packs %d", spView->getPackCount());
+    int size;
+    CHECK(spView->getPack(0, &size) == pack0 && size == 100, "pack0 is read in place");
+    CHECK(spView->getPack(1, &size) == pack1 && size == 50, "pack1 is read in place");
+    const void *pTail = spView->getPack(2, &size);
+    CHECK(pTail != trailer && size == 4 && !memcmp(pTail, trailer, 4), "trailer is copied");
+    CHECK(spView->getPack(3, &size) == NULL && size == 0, "no pack 3");
+
+    char part[120];
+    CHECK(spView->copyTo(part, sizeof(part)) == 120, "copyTo a short buffer");
+    CHECK(part[99] == 99 && part[100] == 100 && part[119] == 119, "copyTo crosses packs");
+
+    const char *p = (const char*)spView->getPointer();
+    CHECK(p != NULL && p != pack0, "gathered");
+    CHECK(p == spView->getPointer(), "gathered once");
+    CHECK(p[0] == 0 && p[99] == 99 && p[100] == 100 && p[149] == (char)149 && !memcmp(p + 150, trailer, 4),
+        "gathered data");
+    CHECK(spView->addPack(pack0, 1) != 0, "no pack after gathering");
+
+    /* a deep copy owns its data and releases nothing of the owner */
+    CMediaMemory copy(*spView);
+    CHECK(copy.getSize() == 154 && copy.getPackCount() == 1, "copy of a view");
+    CHECK(!memcmp(copy.getPointer(), p, 154), "copy data");
+
+    std::shared_ptr<CMediaMemory> spOther = spView;
+    spView.reset();
+    CHECK(released == 0, "released while still held");
+    spOther.reset();
+    CHECK(released == 1, "view released %d times", released);
+
+    /* one pack: the pointer is the pack itself */
+    CMediaMemory single;
+    single.addPack(pack1, sizeof(pack1));
+    CHECK(single.getPointer() == pack1, "single pack is not copied");
+
+    CMediaMemory full;
+    for (int i = 0; i < CMediaMemory::MAX_PACK_NUM; i++)
+    {
+        full.addPack(pack0, 1);
+    }
+    CHECK(full.addPack(pack0, 1) != 0, "too many packs");
+
+    CMediaMemory block(8);
+    CHECK(block.addPack(pack0, 1) != 0, "a block is not a view");
+}
+
+static void test_pool(void)
+{
+    std::shared_ptr<CMediaMemoryPool> spPool = std::make_shared<CMediaMemoryPool>(2);
+
+    std::shared_ptr<CMediaMemory> a = spPool->obtain(1000);
+    void *pA = a->getPointer();
+    CHECK(pA != NULL && a->getSize() == 1000, "obtain");
+    a.reset();
+
+    /* smaller sizes reuse the block, bigger ones do not */
+    std::shared_ptr<CMediaMemory> b = spPool->obtain(800);
+    CHECK(b->getPointer() == pA && b->getSize() == 800, "recycled block");
+    std::shared_ptr<CMediaMemory> c = spPool->obtain(900);
+    CHECK(c->getPointer() != pA, "block in use is not given twice");
+    b.reset();
+    std::shared_ptr<CMediaMemory> d = spPool->obtain(2000);
+    CHECK(d->getPointer() != pA, "too small block is not used");
+    std::shared_ptr<CMediaMemory> e = spPool->obtain(1000);
+    CHECK(e->getPointer() == pA, "capacity is kept, not the last size");
+
+    /* best fit */
+    void *pC = c->getPointer();
+    c.reset();
+    e.reset();
+    std::shared_ptr<CMediaMemory> f = spPool->obtain(900);
+    CHECK(f->getPointer() == pC, "best fit");
+    f.reset();
+
+    /* only 2 idle blocks are kept */
+    std::shared_ptr<CMediaMemory> g[4];
+    for (int i = 0; i < 4; i++)
+    {
+        g[i] = spPool->obtain(100);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        g[i].reset();
+    }
+    d.reset();
+    spPool->trim();
+
+    /* blocks outlive the pool */
+    std::shared_ptr<CMediaMemory> h = spPool->obtain(64);
+    memset(h->getPointer(), 0, 64);
+    spPool.reset();
+    h.reset();
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* a burst of 3MB jpegs which wrap in the vbv buffer */
+static void bench(void)
+{
+    const int size0 = 2 << 20, size1 = 1 << 20, n = 200;
+    char *vbv = (char*)malloc(size0 + size1);
+    char trailer[12] = {0};
+    volatile char sink = 0;
+    double t0;
+
+    memset(vbv, 1, size0 + size1);
+
+    t0 = now_ms();
+    for (int i = 0; i < n; i++)
+    {
+        std::shared_ptr<CMediaMemory> sp = std::make_shared<CMediaMemory>(size0 + size1 + 12);
+        char *p = (char*)sp->getPointer();
+        memcpy(p, vbv, size0);
+        memcpy(p + size0, vbv + size0, size1);
+        memcpy(p + size0 + size1, trailer, 12);
+        sink += p[i];
+    }
+    printf("copy into new block:  %7.3f ms/picture\n", (now_ms() - t0) / n);
+
+    t0 = now_ms();
+    for (int i = 0; i < n; i++)
+    {
+        std::shared_ptr<CMediaMemory> sp = std::make_shared<CMediaMemory>();
+        sp->addPack(vbv, size0);
+        sp->addPack(vbv + size0, size1);
+        sp->addPackCopy(trailer, 12);
+        int size;
+        sink += ((const char*)sp->getPack(0, &size))[i];
+    }
+    printf("view, read in place:  %7.3f ms/picture\n", (now_ms() - t0) / n);
+
+    t0 = now_ms();
+    for (int i = 0; i < n; i++)
+    {
+        std::shared_ptr<CMediaMemory> sp = std::make_shared<CMediaMemory>();
+        sp->addPack(vbv, size0);
+        sp->addPack(vbv + size0, size1);
+        sp->addPackCopy(trailer, 12);
+        sink += ((const char*)sp->getPointer())[i];
+    }
+    printf("view, gathered:       %7.3f ms/picture\n", (now_ms() - t0) / n);
+
+    std::shared_ptr<CMediaMemoryPool> spPool = std::make_shared<CMediaMemoryPool>(2);
+    t0 = now_ms();
+    for (int i = 0; i < n; i++)
+    {
+        std::shared_ptr<CMediaMemory> sp = spPool->obtain(size0 + size1);
+        memcpy(sp->getPointer(), vbv, size0 + size1);
+        sink += ((char*)sp->getPointer())[i];
+    }
+    printf("copy into pool block: %7.3f ms/picture\n", (now_ms() - t0) / n);
+    free(vbv);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    test_block();
+    test_view();
+    test_pool();
+    if (!quiet)
+    {
+        bench();
+    }
+
+    printf("media_memory_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
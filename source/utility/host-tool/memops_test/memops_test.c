@@ -0,0 +1,296 @@
+/*
+ * Host fuzzer and benchmark for the generic rt_memcpy/rt_memmove/rt_memset,
+ * ekernel/core/rt-thread/memops.c.
+ *
+ *   memops_test              run the fuzzer and the size sweep benchmark
+ *   memops_test -q           fuzzer only
+ *
+ * Every length up to a few hundred bytes is run against every source and
+ * destination alignment, plus random large copies, overlapping moves in
+ * both directions and guard bytes around the destination. The benchmark
+ * sweeps sizes for aligned and mutually misaligned buffers and compares
+ * with the word/byte code the file replaced and with the host libc.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <rtthread.h>
+
+#define ALIGN_MAX       16
+#define SWEEP_MAX       320
+#define BUF_SIZE        (256 * 1024)
+#define GUARD           32
+#define FUZZ_ROUNDS     20000
+#define BENCH_BYTES     (256 * 1024 * 1024)
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static unsigned char *src_buf, *dst_buf, *ref_buf;
+
+static void fill(unsigned char *p, size_t len, unsigned int seed)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        p[i] = (unsigned char)(seed + i * 251 + (i >> 8) * 7);
+    }
+}
+
+static void ref_move(unsigned char *d, const unsigned char *s, size_t n)
+{
+    size_t i;
+
+    if (d < s)
+    {
+        for (i = 0; i < n; i++)
+        {
+            d[i] = s[i];
+        }
+    }
+    else
+    {
+        for (i = n; i > 0; i--)
+        {
+            d[i - 1] = s[i - 1];
+        }
+    }
+}
+
+static void check_copy(size_t doff, size_t soff, size_t len)
+{
+    unsigned char *d = dst_buf + GUARD + doff;
+    unsigned char *s = src_buf + GUARD + soff;
+
+    memset(dst_buf, 0xa5, len + 2 * GUARD + ALIGN_MAX);
+    memcpy(ref_buf, dst_buf, len + 2 * GUARD + ALIGN_MAX);
+    ref_move(ref_buf + GUARD + doff, s, len);
+
+    CHECK(rt_memcpy(d, s, len) == d, "rt_memcpy return value");
+    CHECK(!memcmp(dst_buf, ref_buf, len + 2 * GUARD + ALIGN_MAX),
+          "rt_memcpy len %zu dst+%zu src+%zu", len, doff, soff);
+}
+
+static void check_set(size_t doff, size_t len, int c)
+{
+    unsigned char *d = dst_buf + GUARD + doff;
+    size_t i;
+
+    memset(dst_buf, 0xa5, len + 2 * GUARD + ALIGN_MAX);
+    memcpy(ref_buf, dst_buf, len + 2 * GUARD + ALIGN_MAX);
+    for (i = 0; i < len; i++)
+    {
+        ref_buf[GUARD + doff + i] = (unsigned char)c;
+    }
+
+    CHECK(rt_memset(d, c, len) == d, "rt_memset return value");
+    CHECK(!memcmp(dst_buf, ref_buf, len + 2 * GUARD + ALIGN_MAX),
+          "rt_memset len %zu dst+%zu c %#x", len, doff, c);
+}
+
+static void check_move(size_t doff, size_t soff, size_t len)
+{
+    size_t span = (doff > soff ? doff : soff) + len + 2 * GUARD;
+    unsigned char *d = dst_buf + GUARD + doff;
+
+    fill(dst_buf, span, (unsigned int)(doff * 31 + soff));
+    memcpy(ref_buf, dst_buf, span);
+    ref_move(ref_buf + GUARD + doff, ref_buf + GUARD + soff, len);
+
+    CHECK(rt_memmove(d, dst_buf + GUARD + soff, len) == d, "rt_memmove return value");
+    CHECK(!memcmp(dst_buf, ref_buf, span), "rt_memmove len %zu dst+%zu src+%zu", len, doff, soff);
+}
+
+static void fuzz(void)
+{
+    size_t len, doff, soff;
+    int r;
+
+    fill(src_buf, BUF_SIZE, 1);
+    for (len = 0; len <= SWEEP_MAX && failures < 20; len++)
+    {
+        for (doff = 0; doff < ALIGN_MAX; doff++)
+        {
+            for (soff = 0; soff < ALIGN_MAX; soff++)
+            {
+                check_copy(doff, soff, len);
+            }
+            check_set(doff, len, (int)(len * 7 + doff));
+        }
+    }
+
+    for (r = 0; r < FUZZ_ROUNDS && failures < 20; r++)
+    {
+        len = rand() % (BUF_SIZE / 2);
+        if (r & 1)
+        {
+            len %= 4096;
+        }
+        doff = rand() % ALIGN_MAX;
+        soff = rand() % ALIGN_MAX;
+        check_copy(doff, soff, len);
+        check_set(doff, len, rand());
+
+        /* overlapping moves, distance below and above a word */
+        soff = rand() % (4 * ALIGN_MAX);
+        doff = rand() % (4 * ALIGN_MAX);
+        check_move(doff, soff, len % 8192);
+    }
+
+    CHECK(rt_memset(dst_buf, 0, 0) == dst_buf, "zero length set");
+    CHECK(rt_memcpy(dst_buf, src_buf, 0) == dst_buf, "zero length copy");
+    CHECK(rt_memmove(dst_buf, dst_buf, 64) == dst_buf, "move onto itself");
+}
+
+/* the versions memops.c replaced, for the benchmark */
+static void *old_memcpy(void *dst, const void *src, rt_ubase_t count)
+{
+    char *dst_ptr = (char *)dst;
+    char *src_ptr = (char *)src;
+    long *aligned_dst;
+    long *aligned_src;
+    int len = count;
+
+    if (len >= (int)(sizeof(long) << 2)
+        && !(((long)src_ptr & (sizeof(long) - 1)) | ((long)dst_ptr & (sizeof(long) - 1))))
+    {
+        aligned_dst = (long *)dst_ptr;
+        aligned_src = (long *)src_ptr;
+        while (len >= (int)(sizeof(long) << 2))
+        {
+            *aligned_dst++ = *aligned_src++;
+            *aligned_dst++ = *aligned_src++;
+            *aligned_dst++ = *aligned_src++;
+            *aligned_dst++ = *aligned_src++;
+            len -= sizeof(long) << 2;
+        }
+        while (len >= (int)sizeof(long))
+        {
+            *aligned_dst++ = *aligned_src++;
+            len -= sizeof(long);
+        }
+        dst_ptr = (char *)aligned_dst;
+        src_ptr = (char *)aligned_src;
+    }
+
+    while (len--)
+    {
+        *dst_ptr++ = *src_ptr++;
+    }
+
+    return dst;
+}
+
+static void *old_memmove(void *dest, const void *src, rt_ubase_t n)
+{
+    char *tmp = (char *)dest, *s = (char *)src;
+
+    if (s < tmp && tmp < s + n)
+    {
+        tmp += n;
+        s += n;
+        while (n--)
+        {
+            *(--tmp) = *(--s);
+        }
+    }
+    else
+    {
+        while (n--)
+        {
+            *tmp++ = *s++;
+        }
+    }
+
+    return dest;
+}
+
+static void *libc_memcpy(void *dst, const void *src, rt_ubase_t count)
+{
+    return memcpy(dst, src, count);
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench_one(void *(*fn)(void *, const void *, rt_ubase_t),
+                        size_t len, size_t doff, size_t soff)
+{
+    size_t loops = BENCH_BYTES / len / 4 + 1;
+    volatile unsigned char sink;
+    double t0;
+    size_t i;
+
+    t0 = now_sec();
+    for (i = 0; i < loops; i++)
+    {
+        fn(dst_buf + doff, src_buf + soff, len);
+        sink = dst_buf[doff];
+    }
+    (void)sink;
+    return (double)len * loops / (now_sec() - t0) / 1e6;
+}
+
+static void bench(void)
+{
+    static const size_t sizes[] = { 16, 64, 256, 1024, 4096, 65536 };
+    unsigned int i;
+
+    printf("benchmark, MB/s, aligned and dst+1/src+3:\n");
+    printf("  %-6s %9s %9s %9s %9s %9s %9s %9s\n", "size", "old", "new",
+           "old+1/3", "new+1/3", "move old", "move new", "libc+1/3");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        printf("  %-6zu %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f\n", sizes[i],
+               bench_one(old_memcpy, sizes[i], 0, 0),
+               bench_one(rt_memcpy, sizes[i], 0, 0),
+               bench_one(old_memcpy, sizes[i], 1, 3),
+               bench_one(rt_memcpy, sizes[i], 1, 3),
+               bench_one(old_memmove, sizes[i], 1, 3),
+               bench_one(rt_memmove, sizes[i], 1, 3),
+               bench_one(libc_memcpy, sizes[i], 1, 3));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    src_buf = malloc(BUF_SIZE + 4 * GUARD + 8 * ALIGN_MAX);
+    dst_buf = malloc(BUF_SIZE + 4 * GUARD + 8 * ALIGN_MAX);
+    ref_buf = malloc(BUF_SIZE + 4 * GUARD + 8 * ALIGN_MAX);
+    if (!src_buf || !dst_buf || !ref_buf)
+    {
+        return 1;
+    }
+
+    srand(0x3e3);
+    fuzz();
+    printf("memops fuzz: %s\n", failures ? "FAILED" : "ok");
+    if (failures)
+    {
+        return 1;
+    }
+    if (!quiet)
+    {
+        bench();
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+/* host stub: what core/rt-thread/memops.c needs from rtthread.h */
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+typedef unsigned long rt_ubase_t;
+
+#define RTM_EXPORT(symbol)
+
+void *rt_memset(void *s, int c, rt_ubase_t count);
+void *rt_memcpy(void *dst, const void *src, rt_ubase_t count);
+void *rt_memmove(void *dest, const void *src, rt_ubase_t n);
+
+#endif
@@ -0,0 +1,353 @@
+/*
+ * Host test and benchmark for EyeseeMessage and EyeseeMessageQueue of
+ * eyesee-mpp framework/utils/EyeseeMessageQueue.cpp.
+ *
+ *   message_queue_test       run the checks and the benchmark
+ *   message_queue_test -q    checks only
+ *
+ * Checks order, inline and malloced payloads, move-only messages, growth of
+ * the ring, batch dequeue, flush and waiting from another thread. The
+ * benchmark reports latency and allocations per message.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <new>
+#include <utility>
+
+#include <EyeseeMessageQueue.h>
+
+using namespace EyeseeLinux;
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+/* allocations of the queue sources: malloc is wrapped at link time */
+static volatile long allocs;
+
+extern "C" void *__real_malloc(size_t size);
+extern "C" void *__wrap_malloc(size_t size)
+{
+    __sync_fetch_and_add(&allocs, 1);
+    return __real_malloc(size);
+}
+
+void *operator new(size_t size)
+{
+    __sync_fetch_and_add(&allocs, 1);
+    void *p = __real_malloc(size);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static void test_order(void)
+{
+    EyeseeMessageQueue q;
+    EyeseeMessage msg;
+
+    CHECK(q.dequeueMessage(&msg) == NOT_ENOUGH_DATA, "empty queue");
+    for (int i = 0; i < 5; i++)
+    {
+        msg.mMsgType = i;
+        msg.mPara0 = i * 10;
+        q.queueMessage(&msg);
+    }
+    CHECK(q.getMessageCount() == 5, "count %d", q.getMessageCount());
+    for (int i = 0; i < 5; i++)
+    {
+        EyeseeMessage out;
+        CHECK(q.dequeueMessage(&out) == NO_ERROR && out.mMsgType == i && out.mPara0 == i * 10, "order %d", i);
+    }
+    CHECK(q.dequeueMessage(&msg) == NOT_ENOUGH_DATA, "drained");
+}
+
+static void test_payload(void)
+{
+    EyeseeMessageQueue q;
+    char small[EYESEE_MESSAGE_INLINE_DATA_SIZE], big[1000];
+    int size;
+
+    memset(small, 's', sizeof(small));
+    memset(big, 'b', sizeof(big));
+
+    /* queueing by pointer copies the message, the caller keeps its payload */
+    EyeseeMessage msg;
+    msg.setData(small, sizeof(small));
+    long n = allocs;
+    q.queueMessage(&msg);
+    CHECK(allocs == n, "inline payload is not malloced");
+    CHECK(msg.getData(&size) != NULL && size == (int)sizeof(small), "copied from");
+
+    EyeseeMessage out;
+    q.dequeueMessage(&out);
+    char *p = (char*)out.getData(&size);
+    CHECK(allocs == n, "dequeue allocates nothing");
+    CHECK(p != NULL && p != msg.getData() && size == (int)sizeof(small) && !memcmp(p, small, size), "inline data");
+
+    /* a moved message hands over a malloced payload */
+    EyeseeMessage large;
+    large.setData(big, sizeof(big));
+    void *pBig = large.getData();
+    q.queueMessage(std::move(large));
+    CHECK(large.getData(&size) == NULL && size == 0, "moved from");
+    q.dequeueMessage(&out);
+    CHECK(out.getData(&size) == pBig && size == (int)sizeof(big), "malloced payload is not copied");
+
+    /* and copies an inline one, whose pointer must follow the message */
+    EyeseeMessage tiny;
+    tiny.setData((char*)"abc", 4);
+    EyeseeMessage moved(std::move(tiny));
+    p = (char*)moved.getData(&size);
+    CHECK(tiny.getData() == NULL, "move constructed from");
+    CHECK(size == 4 && !strcmp(p, "abc") && (char*)&moved <= p && p < (char*)(&moved + 1), "inline data moved");
+
+    out = std::move(moved);
+    CHECK(!strcmp((char*)out.getData(), "abc") && moved.getData() == NULL, "move assigned");
+    out.reset();
+    CHECK(out.getData(&size) == NULL && size == 0, "reset");
+}
+
+static void test_grow(void)
+{
+    EyeseeMessageQueue q(2);
+    EyeseeMessage msg;
+    char big[100];
+
+    /* start in the middle of the ring so the growth has to unwrap it */
+    msg.mMsgType = -1;
+    q.queueMessage(&msg);
+    q.dequeueMessage(&msg);
+    for (int i = 0; i < 10; i++)
+    {
+        memset(big, i, sizeof(big));
+        msg.mMsgType = i;
+        msg.setData(big, i & 1 ? (int)sizeof(big) : 1);
+        q.queueMessage(std::move(msg));
+    }
+    CHECK(q.getMessageCount() == 10, "no message dropped");
+    for (int i = 0; i < 10; i++)
+    {
+        int size;
+        q.dequeueMessage(&msg);
+        char *p = (char*)msg.getData(&size);
+        CHECK(msg.mMsgType == i && size == (i & 1 ? (int)sizeof(big) : 1) && p[size - 1] == i, "grown order %d", i);
+    }
+}
+
+static void test_batch(void)
+{
+    EyeseeMessageQueue q(4);
+    EyeseeMessage msg, out[3];
+
+    for (int i = 0; i < 5; i++)
+    {
+        msg.mMsgType = i;
+        q.queueMessage(&msg);
+    }
+    CHECK(q.dequeueMessages(out, 3) == 3, "batch of 3");
+    CHECK(out[0].mMsgType == 0 && out[2].mMsgType == 2, "batch order");
+    CHECK(q.dequeueMessages(out, 3) == 2 && out[1].mMsgType == 4, "last batch");
+    CHECK(q.dequeueMessages(out, 3) == 0, "empty batch");
+}
+
+static void test_flush(void)
+{
+    EyeseeMessageQueue q(2);
+    EyeseeMessage msg;
+    char big[200] = {0};
+
+    for (int i = 0; i < 3; i++)
+    {
+        msg.setData(big, sizeof(big));
+        q.queueMessage(std::move(msg));
+    }
+    q.flushMessage();
+    CHECK(q.getMessageCount() == 0 && q.dequeueMessage(&msg) == NOT_ENOUGH_DATA, "flushed");
+    msg.mMsgType = 7;
+    q.queueMessage(&msg);
+    CHECK(q.dequeueMessage(&msg) == NO_ERROR && msg.mMsgType == 7, "queue after flush");
+}
+
+static void *post_later(void *arg)
+{
+    EyeseeMessageQueue *pQueue = (EyeseeMessageQueue*)arg;
+    EyeseeMessage msg;
+
+    usleep(20 * 1000);
+    msg.mMsgType = 42;
+    pQueue->queueMessage(&msg);
+    return NULL;
+}
+
+static void test_wait(void)
+{
+    EyeseeMessageQueue q;
+    EyeseeMessage msg;
+    pthread_t thread;
+
+    CHECK(q.waitMessage(10) == 0, "wait times out");
+    pthread_create(&thread, NULL, post_later, &q);
+    CHECK(q.waitMessage() == 1, "woken by the message");
+    CHECK(q.dequeueMessage(&msg) == NO_ERROR && msg.mMsgType == 42, "message of the other thread");
+    pthread_join(thread, NULL);
+}
+
+/* after warming up, a message with an inline payload allocates nothing */
+static void test_no_alloc(void)
+{
+    EyeseeMessageQueue q;
+    EyeseeMessage msg, out;
+    char data[32] = {0};
+
+    for (int i = 0; i < 4; i++)
+    {
+        msg.setData(data, sizeof(data));
+        q.queueMessage(std::move(msg));
+    }
+    q.flushMessage();
+    long n = allocs;
+    for (int i = 0; i < 1000; i++)
+    {
+        msg.setData(data, sizeof(data));
+        q.queueMessage(std::move(msg));
+        q.dequeueMessage(&out);
+    }
+    CHECK(allocs == n, "%ld allocations in steady state", allocs - n);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* the callers' pattern: a message on the stack per event, queued by pointer */
+static void bench_one(int nDataSize)
+{
+    const int n = 200000, burst = 4;
+    EyeseeMessageQueue q;
+    char data[256] = {0};
+    volatile int sink = 0;
+
+    long n0 = allocs;
+    double t0 = now_ns();
+    for (int i = 0; i < n; i += burst)
+    {
+        for (int j = 0; j < burst; j++)
+        {
+            EyeseeMessage msg;
+            msg.mMsgType = i + j;
+            msg.setData(data, nDataSize);
+            q.queueMessage(&msg);
+        }
+        for (int j = 0; j < burst; j++)
+        {
+            EyeseeMessage out;
+            q.dequeueMessage(&out);
+            sink += out.mMsgType;
+        }
+    }
+    printf("payload %3d: %6.1f ns/message, %.2f allocations/message\n",
+        nDataSize, (now_ns() - t0) / n, (double)(allocs - n0) / n);
+}
+
+static void *bench_producer(void *arg)
+{
+    EyeseeMessageQueue *pQueue = (EyeseeMessageQueue*)arg;
+    char data[32] = {0};
+
+    for (int i = 0; i < 200000; i++)
+    {
+        /* keep within the ring like a paced producer */
+        while (pQueue->getMessageCount() >= 48)
+        {
+            sched_yield();
+        }
+        EyeseeMessage msg;
+        msg.mMsgType = i;
+        msg.setData(data, sizeof(data));
+        pQueue->queueMessage(std::move(msg));
+    }
+    return NULL;
+}
+
+/* a consumer thread draining by batches */
+static void bench_threads(void)
+{
+    const int n = 200000;
+    EyeseeMessageQueue q(64);
+    EyeseeMessage out[16];
+    pthread_t thread;
+    int got = 0;
+
+    double t0 = now_ns();
+    pthread_create(&thread, NULL, bench_producer, &q);
+    while (got < n)
+    {
+        if (q.waitMessage(100) > 0)
+        {
+            got += q.dequeueMessages(out, 16);
+        }
+    }
+    pthread_join(thread, NULL);
+    printf("2 threads, batch dequeue: %6.1f ns/message\n", (now_ns() - t0) / n);
+}
+
+static void bench(void)
+{
+    const int sizes[] = {0, 32, 256};
+
+    for (int i = 0; i < 3; i++)
+    {
+        bench_one(sizes[i]);
+    }
+    bench_threads();
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    test_order();
+    test_payload();
+    test_grow();
+    test_batch();
+    test_flush();
+    test_wait();
+    test_no_alloc();
+    if (!quiet)
+    {
+        bench();
+    }
+
+    printf("message_queue_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
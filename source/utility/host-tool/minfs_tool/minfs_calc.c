@@ -22,7 +22,7 @@
 #include "minfs_tool_i.h"
 typedef void *HANDLE;
 
-__s32 MINFS_CalcCompressedFileLen(const char *pFullPath, __u32 *FDataLen)
+__s32 MINFS_CalcCompressedFileLen(const char *pFullPath, __u32 *FDataLen, __u32 BlockSize)
 {
     __u8            *pFileData;
     __u32            FileLen;
@@ -60,6 +60,31 @@ __s32 MINFS_CalcCompressedFileLen(const char *pFullPath, __u32 *FDataLen)
     //close file handle
     fclose(hFile);
 
+    if (BlockSize)
+    {
+        //block-indexed compress
+        CompressLen   = MINFS_BlocksMaxLen(FileLen, BlockSize);
+        pCompressData = (__u8 *)malloc(CompressLen);
+        if (pCompressData == NULL)
+        {
+            MSG("allocate buffer for compress data failed\n");
+            free(pFileData);
+            return EPDK_FAIL;
+        }
+        if (MINFS_CompressBlocks(pCompressData, &CompressLen,
+                                 pFileData, FileLen, BlockSize) != EPDK_OK)
+        {
+            MSG("compress file [%s] data failed\n", pFullPath);
+            free(pFileData);
+            free(pCompressData);
+            return EPDK_FAIL;
+        }
+        (*FDataLen) = CompressLen;
+        free(pFileData);
+        free(pCompressData);
+        return EPDK_OK;
+    }
+
     //compress file data to get compressed data length
     pCompressData = (__u8 *)malloc(MINFS_MAX_EXPAND_RATIO * FileLen);
     if (pCompressData == NULL)
@@ -161,7 +186,8 @@ __s32 MINFS_CalcMFSFile(const char *pFullPath,
             //calculate file data length
             if (FilePara.CompressON)
             {
-                if (MINFS_CalcCompressedFileLen(pFullPath, &FDataLen) \
+                if (MINFS_CalcCompressedFileLen(pFullPath, &FDataLen,
+                                                FilePara.BlockSize) \
                         != EPDK_OK)
                 {
                     MSG("calculate file [%s] compressed "\
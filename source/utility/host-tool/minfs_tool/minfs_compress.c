@@ -52,3 +52,159 @@ __s32 MINFS_Uncompress(__u8 *pDst, __u32 *DstLen, __u8 *pSrcData, __u32 *SrcLen)
     }
     return EPDK_OK;
 }
+
+//the byte size of block-indexed data before compression,
+//header and offset table are followed by the blocks.
+__u32 MINFS_BlocksHdrLen(__u32 SrcLen, __u32 BlockSize)
+{
+    __u32 BlockNum = (SrcLen + BlockSize - 1) / BlockSize;
+
+    return MINFS_BLK_HDR_LEN + (BlockNum + 1) * 4;
+}
+
+//the worst case byte size of block-indexed data,
+//blocks which do not shrink are stored raw.
+__u32 MINFS_BlocksMaxLen(__u32 SrcLen, __u32 BlockSize)
+{
+    return MINFS_BlocksHdrLen(SrcLen, BlockSize) + SrcLen;
+}
+
+__s32 MINFS_CompressBlocks(__u8 *pDst, __u32 *DstLen,
+                           __u8 *pSrc, __u32 SrcLen, __u32 BlockSize)
+{
+    __minfs_blk_hdr_t   *pHdr = (__minfs_blk_hdr_t *)pDst;
+    __u32               *pOffsets;
+    __u8                *pCompressData;
+    __u8                 OutProps[MINFS_MAX_COMPRESS_PROPS_LEN];
+    __u32                OutPropsLen;
+    __u32                CompressLen;
+    __u32                BlockLen;
+    __u32                Offset;
+    __u32                Index;
+
+    if (BlockSize < MINFS_BLK_MIN_SIZE || BlockSize > MINFS_BLK_MAX_SIZE)
+    {
+        MSG("invalid compress block size %d\n", BlockSize);
+        return EPDK_FAIL;
+    }
+    Offset = MINFS_BlocksHdrLen(SrcLen, BlockSize);
+    if (Offset > (*DstLen))
+    {
+        MSG("compress dest buffer not enough\n");
+        return EPDK_FAIL;
+    }
+
+    //one compress buffer reused by all blocks
+    pCompressData = (__u8 *)malloc(MINFS_MAX_EXPAND_RATIO * BlockSize);
+    if (pCompressData == NULL)
+    {
+        MSG("allocate buffer for compress data failed\n");
+        return EPDK_FAIL;
+    }
+
+    pHdr->Magic      = MINFS_BLK_MAGIC;
+    pHdr->BlockSize  = BlockSize;
+    pHdr->BlockNum   = (SrcLen + BlockSize - 1) / BlockSize;
+    pHdr->UnPackSize = SrcLen;
+    pOffsets = (__u32 *)(pDst + MINFS_BLK_HDR_LEN);
+
+    for (Index = 0; Index < pHdr->BlockNum; Index++)
+    {
+        BlockLen = SrcLen - Index * BlockSize;
+        if (BlockLen > BlockSize)
+        {
+            BlockLen = BlockSize;
+        }
+        pOffsets[Index] = Offset;
+
+        //every block is an independent lzma stream
+        CompressLen = MINFS_MAX_EXPAND_RATIO * BlockSize;
+        memset(OutProps, 0, MINFS_MAX_COMPRESS_PROPS_LEN);
+        OutPropsLen = MINFS_MAX_COMPRESS_PROPS_LEN;
+        if (MINFS_Compress(pCompressData, &CompressLen,
+                           pSrc + Index * BlockSize, BlockLen,
+                           OutProps, &OutPropsLen) != EPDK_OK)
+        {
+            free(pCompressData);
+            return EPDK_FAIL;
+        }
+
+        if (OutPropsLen + CompressLen >= BlockLen)
+        {
+            //no gain, store raw data, the reader detects it by length
+            if (Offset + BlockLen > (*DstLen))
+            {
+                MSG("compress dest buffer not enough\n");
+                free(pCompressData);
+                return EPDK_FAIL;
+            }
+            memcpy(pDst + Offset, pSrc + Index * BlockSize, BlockLen);
+            Offset += BlockLen;
+        }
+        else
+        {
+            if (Offset + OutPropsLen + CompressLen > (*DstLen))
+            {
+                MSG("compress dest buffer not enough\n");
+                free(pCompressData);
+                return EPDK_FAIL;
+            }
+            memcpy(pDst + Offset, OutProps, OutPropsLen);
+            memcpy(pDst + Offset + OutPropsLen, pCompressData, CompressLen);
+            Offset += OutPropsLen + CompressLen;
+        }
+    }
+    pOffsets[pHdr->BlockNum] = Offset;
+    (*DstLen) = Offset;
+
+    free(pCompressData);
+    return EPDK_OK;
+}
+
+__s32 MINFS_UncompressBlocks(__u8 *pDst, __u32 *DstLen, __u8 *pSrcData, __u32 SrcLen)
+{
+    __minfs_blk_hdr_t   *pHdr = (__minfs_blk_hdr_t *)pSrcData;
+    __u32               *pOffsets;
+    __u32                BlockLen;
+    __u32                PackLen;
+    __u32                UnPackLen;
+    __u32                Index;
+
+    if (SrcLen < MINFS_BLK_HDR_LEN || pHdr->Magic != MINFS_BLK_MAGIC ||
+        pHdr->BlockSize == 0 || pHdr->UnPackSize > (*DstLen) ||
+        MINFS_BlocksHdrLen(pHdr->UnPackSize, pHdr->BlockSize) > SrcLen)
+    {
+        MSG("invalid block-indexed data\n");
+        return EPDK_FAIL;
+    }
+    pOffsets = (__u32 *)(pSrcData + MINFS_BLK_HDR_LEN);
+    for (Index = 0; Index < pHdr->BlockNum; Index++)
+    {
+        BlockLen = pHdr->UnPackSize - Index * pHdr->BlockSize;
+        if (BlockLen > pHdr->BlockSize)
+        {
+            BlockLen = pHdr->BlockSize;
+        }
+        if (pOffsets[Index + 1] < pOffsets[Index] || pOffsets[Index + 1] > SrcLen)
+        {
+            MSG("invalid block index\n");
+            return EPDK_FAIL;
+        }
+        PackLen = pOffsets[Index + 1] - pOffsets[Index];
+        if (PackLen == BlockLen)
+        {
+            memcpy(pDst + Index * pHdr->BlockSize, pSrcData + pOffsets[Index], BlockLen);
+            continue;
+        }
+        UnPackLen = BlockLen;
+        if (MINFS_Uncompress(pDst + Index * pHdr->BlockSize, &UnPackLen,
+                             pSrcData + pOffsets[Index], &PackLen) != EPDK_OK ||
+            UnPackLen != BlockLen)
+        {
+            MSG("uncompress block %d failed\n", Index);
+            return EPDK_FAIL;
+        }
+    }
+    (*DstLen) = pHdr->UnPackSize;
+    return EPDK_OK;
+}
@@ -28,4 +28,12 @@ __s32 MINFS_Compress(__u8 *pDst, __u32 *DstLen,
 __s32 MINFS_Uncompress(__u8 *pDst, __u32 *DstLen,
                        __u8 *pSrcData, __u32 *SrcLen);
 
+//block-indexed data, see __minfs_blk_hdr_t
+__u32 MINFS_BlocksHdrLen(__u32 SrcLen, __u32 BlockSize);
+__u32 MINFS_BlocksMaxLen(__u32 SrcLen, __u32 BlockSize);
+__s32 MINFS_CompressBlocks(__u8 *pDst, __u32 *DstLen,
+                           __u8 *pSrc, __u32 SrcLen, __u32 BlockSize);
+__s32 MINFS_UncompressBlocks(__u8 *pDst, __u32 *DstLen,
+                             __u8 *pSrcData, __u32 SrcLen);
+
 #endif  // __MINFS_COMPRESS_H__
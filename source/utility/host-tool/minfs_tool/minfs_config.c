@@ -34,6 +34,8 @@ __s32 MINFS_ParseFileConfigPara(__minfs_config_t *pConfig,
     //get filename extension
     _splitpath(pFullPath, drive, dir, fname, ext);
 
+    pFilePara->BlockSize = pConfig->BlockSize;
+
     for (Index = 0; Index < pConfig->CExtNum; Index++)
     {
         //ext include char '.', we should skip it
@@ -54,6 +56,7 @@ __s32 MINFS_ParseConfigFile(const char *pFile, __minfs_config_t *pConfig)
 {
     HCONFIG hCfg;
     __u32   ImageSize;
+    __u32   BlockSize;
     __u32   ExtCount;
     __u32   CKeyNum;
     __u32   Index;
@@ -81,6 +84,21 @@ __s32 MINFS_ParseConfigFile(const char *pFile, __minfs_config_t *pConfig)
     }
     pConfig->Size = ImageSize * 1024;
 
+    //get compress block size, optional,
+    //without it every compressed file is one lzma stream.
+    pConfig->BlockSize = 0;
+    if (GetKeyValue(hCfg, "COMPRESS_CFG", "block_size", &BlockSize) == OK)
+    {
+        BlockSize *= 1024;
+        if (BlockSize < MINFS_BLK_MIN_SIZE || BlockSize > MINFS_BLK_MAX_SIZE)
+        {
+            MSG("config file [%s] compress block size %d invalid\n", pFile, BlockSize);
+            CloseConfig(hCfg);
+            return EPDK_FAIL;
+        }
+        pConfig->BlockSize = BlockSize;
+    }
+
     //get uncompress section key number
     if (GetSectionKeyCount(hCfg, "COMPRESS_EXT", &CKeyNum) != OK)
     {
@@ -26,11 +26,13 @@
 typedef struct __FILE_PARA
 {
     __bool CompressON;
+    __u32  BlockSize;       //compress block size, 0 : one lzma stream
 } __file_para_t;
 
 typedef struct __MINFS_CONFIG
 {
     __u32   Size;
+    __u32   BlockSize;
     __u32   CExtNum;
     char    CExtTable[MINFS_MAX_EXT_NUM][_MAX_EXT];
 } __minfs_config_t;
@@ -98,8 +98,20 @@ __s32 DumpCompressedDataToFile(const char *pFile, __u32 unPackSize,
 
     //uncompress file data
     UncompressLen = unPackSize;
-    if (MINFS_Uncompress(pUncompressData, &UncompressLen,
-                         pBuffer, &BufferLen) != EPDK_OK)
+    if (BufferLen >= MINFS_BLK_HDR_LEN &&
+        ((__minfs_blk_hdr_t *)pBuffer)->Magic == MINFS_BLK_MAGIC)
+    {
+        //block-indexed data
+        if (MINFS_UncompressBlocks(pUncompressData, &UncompressLen,
+                                   pBuffer, BufferLen) != EPDK_OK)
+        {
+            MSG("uncompress file data failed\n");
+            free(pUncompressData);
+            return EPDK_FAIL;
+        }
+    }
+    else if (MINFS_Uncompress(pUncompressData, &UncompressLen,
+                              pBuffer, &BufferLen) != EPDK_OK)
     {
         MSG("uncompress file data failed\n");
         free(pUncompressData);
@@ -237,8 +249,16 @@ __s32 DumpModuleDataToFile(__dump_context_t *pContext,
                     free(pBuffer);
                     return EPDK_FAIL;
                 }
-                MINFS_Uncompress(unCompressBuffer, &unCompressLen, \
-                                 pMFSSectionData, &(pMFSSectionEntry->RecSize));
+                if (pMFSSectionEntry->Attribute & MINFS_SECTION_ATTR_BLOCKED)
+                {
+                    MINFS_UncompressBlocks(unCompressBuffer, &unCompressLen, \
+                                           pMFSSectionData, pMFSSectionEntry->RecSize);
+                }
+                else
+                {
+                    MINFS_Uncompress(unCompressBuffer, &unCompressLen, \
+                                     pMFSSectionData, &(pMFSSectionEntry->RecSize));
+                }
 
                 //store uncompress data to elf buffer
                 memcpy(pSectionData, unCompressBuffer, unCompressLen);
@@ -216,7 +216,21 @@ __s32 MINFS_LoadFileData(const char *pFullPath,
 
     //allocate buffer from minfs image for this file
     pBuffer = pContext->pBuffer + pContext->CurDataOffset;
-    if (FilePara.CompressON)
+    if (FilePara.CompressON && FilePara.BlockSize)
+    {
+        //block-indexed compress, minfs can decode any range of it
+        MFSFileLen = pContext->ImageSize - pContext->CurDataOffset;
+        if (MINFS_CompressBlocks(pBuffer, &MFSFileLen,
+                                 pFileData, SrcFileLen,
+                                 FilePara.BlockSize)
+                != EPDK_OK)
+        {
+            MSG("image file have no free space\n");
+            return EPDK_FAIL;
+        }
+        pDEntry->Attribute |= (MINFS_ATTR_COMPRESS | MINFS_ATTR_BLOCKED);
+    }
+    else if (FilePara.CompressON)
     {
         //this file should compressed or not
         MFSFileLen = pContext->ImageSize - pContext->CurDataOffset;
@@ -19,7 +19,8 @@
 #include "config/config.h"
 #include    "minfs_tool_i.h"
 
-__s32  MINFS_CalcSectionCompressedLen(HELFPSR hPSR, __u32 Index, __u32 *SectionLen)
+__s32  MINFS_CalcSectionCompressedLen(HELFPSR hPSR, __u32 Index, __u32 *SectionLen,
+                                      __u32 BlockSize)
 {
     Elf32_Shdr  *pSHdr;
     __u8        *pSectionData;
@@ -34,6 +35,29 @@ __s32  MINFS_CalcSectionCompressedLen(HELFPSR hPSR, __u32 Index, __u32 *SectionL
     //get this section data
     pSectionData = GetSectionData(hPSR, Index);
 
+    if (BlockSize)
+    {
+        //block-indexed compress
+        CompressLen   = MINFS_BlocksMaxLen(pSHdr->size, BlockSize);
+        pCompressData = (__u8 *)malloc(CompressLen);
+        if (pCompressData == NULL)
+        {
+            MSG("allocate buffer for compress data failed\n");
+            UnLoadELFFile(hPSR);
+            return EPDK_FAIL;
+        }
+        if (MINFS_CompressBlocks(pCompressData, &CompressLen,
+                                 pSectionData, pSHdr->size, BlockSize) != EPDK_OK)
+        {
+            free(pCompressData);
+            UnLoadELFFile(hPSR);
+            return EPDK_FAIL;
+        }
+        free(pCompressData);
+        (*SectionLen) = CompressLen;
+        return EPDK_OK;
+    }
+
     //allocate buffer for compressed
     CompressLen   = MINFS_MAX_EXPAND_RATIO * pSHdr->size;
     pCompressData = (__u8 *)malloc(CompressLen);
@@ -72,7 +96,8 @@ __s32  MINFS_CalcSectionCompressedLen(HELFPSR hPSR, __u32 Index, __u32 *SectionL
     return EPDK_OK;
 }
 
-__s32 MINFS_CompressSectionData(HELFPSR hPSR, __u32 Index, __u8 *pBuffer, __u32 *DataLen)
+__s32 MINFS_CompressSectionData(HELFPSR hPSR, __u32 Index, __u8 *pBuffer, __u32 *DataLen,
+                                __u32 BlockSize)
 {
     __u8        *pSectionData;
     __u8        *pCompressData;
@@ -85,6 +110,13 @@ __s32 MINFS_CompressSectionData(HELFPSR hPSR, __u32 Index, __u8 *pBuffer, __u32
     pSectionData = GetSectionData(hPSR, Index);
     pSHdr = GetSectionHeader(hPSR, Index);
 
+    if (BlockSize)
+    {
+        //block-indexed compress, straight to image buffer
+        return MINFS_CompressBlocks(pBuffer, DataLen,
+                                    pSectionData, pSHdr->size, BlockSize);
+    }
+
     //allocate buffer for compressed
     CompressLen   = MINFS_MAX_EXPAND_RATIO * pSHdr->size;
     pCompressData = (__u8 *)malloc(CompressLen);
@@ -195,7 +227,8 @@ __s32 MINFS_CalcMFSModuleFile(const char *pFullPath,
                         MINFS_IsCompressedSection(pSHdr, tmpName))
                 {
                     //section should compressed
-                    MINFS_CalcSectionCompressedLen(hPSR, Index, &SectionLen);
+                    MINFS_CalcSectionCompressedLen(hPSR, Index, &SectionLen,
+                                                   FilePara.BlockSize);
                 }
                 else
                 {
@@ -315,13 +348,18 @@ __s32 MINFS_LoadModuleFile(const char *pFullPath,
                 //section data should compressed
                 MFSSctLen = pContext->ImageSize - pContext->CurDataOffset;
                 if (MINFS_CompressSectionData(hPSR, Index,
-                                              pBuffer, &MFSSctLen)
+                                              pBuffer, &MFSSctLen,
+                                              FilePara.BlockSize)
                         != EPDK_OK)
                 {
                     MSG("image file have no free space\n");
                     return EPDK_FAIL;
                 }
                 pMFSSctHdr->Attribute |= MINFS_SECTION_ATTR_COMPRESS;
+                if (FilePara.BlockSize)
+                {
+                    pMFSSctHdr->Attribute |= MINFS_SECTION_ATTR_BLOCKED;
+                }
             }
             else
             {
@@ -0,0 +1,486 @@
+/*
+ * Host test and benchmark for the seek index of the mov parser,
+ * libcedarx/libcore/parser/mov/CdxMovSample.c.
+ *
+ *   mov_seek_test           run the checks, print seek times
+ *   mov_seek_test -q        checks only
+ *
+ * A synthetic moov holds the sample tables of a video track (variable
+ * frame durations, irregular GOPs and chunks, per frame ctts) and of an
+ * aac track. Every seek runs on two parsers over the same moov: one with
+ * the index and one with it turned off (seek_index_state -1), which walks
+ * the tables from the first entry as before. Both must leave the same
+ * stream state and seek the stream to the same offset. The sidx seek of
+ * fragmented files is checked against a linear scan.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "CdxMovSample.h"
+
+#define VIDEO_SCALE     90000
+#define AUDIO_SCALE     48000
+#define AUDIO_FRAME     1024
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static unsigned int rnd_state = 1;
+
+static unsigned int rnd(unsigned int n)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state % n;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* ---- the moov, tables appended as big endian words ---- */
+
+static unsigned char *moov;
+static unsigned int moov_size, moov_cap;
+
+static void put32(CDX_U32 v)
+{
+    if (moov_size + 4 > moov_cap)
+    {
+        moov_cap = moov_cap ? moov_cap * 2 : 1 << 20;
+        moov = realloc(moov, moov_cap);
+    }
+    moov[moov_size++] = v >> 24;
+    moov[moov_size++] = v >> 16;
+    moov[moov_size++] = v >> 8;
+    moov[moov_size++] = v;
+}
+
+struct scenario
+{
+    const char *name;
+    unsigned int frames;
+    unsigned int frame_duration;
+    int vfr;                /* runs of 3000/3003/1500 and some empty stts entries */
+    int gop_min, gop_max;
+    int chunk_max;          /* samples per video chunk, 1..chunk_max */
+    int ctts;
+    int audio;
+};
+
+static const struct scenario scenarios[] = {
+    { "1h vfr 30fps",      108000, 3000, 1, 10, 90, 8, 1, 1 },
+    { "20s 30fps",            600, 3000, 0, 30, 30, 1, 0, 1 },
+    { "2h 60fps",          432000, 1500, 0, 60, 60, 4, 0, 0 },
+};
+
+struct track
+{
+    MOVStreamContext st;
+    MOVCtts *ctts;
+    CDX_U64 duration;
+};
+
+static void build_tracks(const struct scenario *sc, struct track *v, struct track *a)
+{
+    unsigned int i, n, chunks, samples, key;
+    CDX_U64 offset = 0x1000;
+    CDX_U32 *chunk_offset;
+    unsigned int *chunk_samples;
+    unsigned int audio_frames, audio_chunks = 0;
+
+    moov_size = 0;
+    memset(v, 0, sizeof(*v));
+    memset(a, 0, sizeof(*a));
+
+    /* stts */
+    v->st.stts_offset = moov_size;
+    for (i = 0; i < sc->frames; i += n)
+    {
+        unsigned int duration = sc->frame_duration;
+
+        n = sc->vfr ? 1 + rnd(6) : sc->frames;
+        if (n > sc->frames - i)
+            n = sc->frames - i;
+        if (sc->vfr)
+        {
+            duration = rnd(8) == 0 ? 1500 : rnd(2) ? 3000 : 3003;
+            if (rnd(100) == 0)
+            {
+                put32(0);
+                put32(3000);
+                v->st.stts_size++;
+            }
+        }
+        put32(n);
+        put32(duration);
+        v->st.stts_size++;
+        v->duration += (CDX_U64)n * duration;
+    }
+
+    /* stss, 1 based */
+    v->st.stss_offset = moov_size;
+    for (key = 1; key <= sc->frames; key += sc->gop_min + rnd(sc->gop_max - sc->gop_min + 1))
+    {
+        put32(key);
+        v->st.stss_size++;
+    }
+    v->st.real_stss_size = v->st.stss_size;
+
+    /* stsz */
+    v->st.stsz_offset = moov_size;
+    v->st.stsz_size = sc->frames;
+    for (i = 0; i < sc->frames; i++)
+        put32(2000 + rnd(60000));
+
+    /* chunks: runs of chunks with the same sample count */
+    chunk_samples = malloc(sc->frames * sizeof(*chunk_samples));
+    v->st.stsc_offset = moov_size;
+    for (samples = 0, chunks = 0; samples < sc->frames; )
+    {
+        unsigned int run = 1 + rnd(20), per = 1 + rnd(sc->chunk_max);
+
+        put32(chunks + 1);
+        put32(per);
+        put32(1);
+        v->st.stsc_size++;
+        for (i = 0; i < run && samples < sc->frames; i++)
+        {
+            chunk_samples[chunks++] = per;
+            samples += per;
+        }
+    }
+
+    /* the audio chunks go between the video ones, 10 frames each */
+    audio_frames = sc->audio ? (unsigned int)(v->duration * AUDIO_SCALE / VIDEO_SCALE / AUDIO_FRAME) : 0;
+    chunk_offset = malloc((chunks + audio_frames / 10 + 1) * 2 * sizeof(*chunk_offset));
+    v->st.stco_offset = moov_size;
+    v->st.stco_size = chunks;
+    for (i = 0; i < chunks; i++)
+    {
+        put32(offset);
+        offset += chunk_samples[i] * 30000;
+        if (i % 3 == 0 && audio_chunks * 10 < audio_frames)
+        {
+            chunk_offset[audio_chunks++] = offset;
+            offset += 10 * 600;
+        }
+    }
+    while (audio_chunks * 10 < audio_frames)
+    {
+        chunk_offset[audio_chunks++] = offset;
+        offset += 10 * 600;
+    }
+
+    if (sc->ctts)
+    {
+        v->ctts = malloc(sc->frames * sizeof(MOVCtts));
+        for (i = 0, n = 0; n < sc->frames; i++)
+        {
+            v->ctts[i].count = 1 + rnd(2);
+            v->ctts[i].duration = 3000 * (1 + rnd(3));
+            n += v->ctts[i].count;
+        }
+        v->st.ctts_size = i;
+        v->st.ctts_data = v->ctts;
+    }
+    v->st.stsd_type = 1;
+    v->st.time_scale = VIDEO_SCALE;
+
+    if (sc->audio)
+    {
+        a->st.stts_offset = moov_size;
+        put32(audio_frames);
+        put32(AUDIO_FRAME);
+        a->st.stts_size = 1;
+        a->st.stsc_offset = moov_size;
+        put32(1);
+        put32(10);
+        put32(1);
+        a->st.stsc_size = 1;
+        a->st.stsz_offset = moov_size;
+        a->st.stsz_size = audio_chunks * 10;
+        for (i = 0; i < audio_chunks * 10; i++)
+            put32(300 + rnd(500));
+        a->st.stco_offset = moov_size;
+        a->st.stco_size = audio_chunks;
+        for (i = 0; i < audio_chunks; i++)
+            put32(chunk_offset[i]);
+        a->st.stsd_type = 2;
+        a->st.time_scale = AUDIO_SCALE;
+        a->st.eCodecFormat = AUDIO_CODEC_FORMAT_MPEG_AAC_LC;
+        a->duration = (CDX_U64)audio_frames * AUDIO_FRAME;
+    }
+
+    free(chunk_samples);
+    free(chunk_offset);
+}
+
+/* ---- a parser over the moov, the stream only records where it is sent ---- */
+
+struct host_stream
+{
+    CdxStreamT base;
+    cdx_int64 offset;
+};
+
+static cdx_uint32 host_attribute(CdxStreamT *stream)
+{
+    return CDX_STREAM_FLAG_SEEK | CDX_STREAM_FLAG_NET;
+}
+
+static cdx_int32 host_seek(CdxStreamT *stream, cdx_int64 offset, cdx_int32 whence)
+{
+    ((struct host_stream *)stream)->offset = offset;
+    return 0;
+}
+
+static cdx_int64 host_tell(CdxStreamT *stream)
+{
+    return ((struct host_stream *)stream)->offset;
+}
+
+static struct CdxStreamOpsS host_ops = {
+    .attribute = host_attribute,
+    .seek = host_seek,
+    .tell = host_tell,
+};
+
+struct parser
+{
+    struct CdxMovParser p;
+    MOVContext c;
+    MOVStreamContext video, audio;
+    struct host_stream stream;
+};
+
+static void parser_init(struct parser *m, const struct track *v, const struct track *a,
+                        int indexed)
+{
+    memset(m, 0, sizeof(*m));
+    m->stream.base.ops = &host_ops;
+    m->p.privData = &m->c;
+    m->p.totalTime = v->duration * 1000 / VIDEO_SCALE;
+    m->c.fp = &m->stream.base;
+    m->c.moov_buffer = moov;
+    m->c.moov_size = moov_size;
+    m->c.Vsamples = aw_list_new();
+    m->c.Asamples = aw_list_new();
+
+    m->video = v->st;
+    m->video.seek_index_state = indexed ? 0 : -1;
+    m->c.streams[0] = &m->video;
+    m->c.nb_streams = 1;
+    m->c.has_video = 1;
+    m->c.video_stream_idx = 0;
+    if (a->st.stsd_type)
+    {
+        m->audio = a->st;
+        m->audio.stream_index = 0;
+        m->c.streams[1] = &m->audio;
+        m->c.nb_streams = 2;
+        m->c.has_audio = 1;
+        m->c.audio_stream_idx = 1;
+    }
+}
+
+static void parser_exit(struct parser *m)
+{
+    free(m->video.seek_index);
+    aw_list_del(m->c.Vsamples);
+    aw_list_del(m->c.Asamples);
+}
+
+static int same_state(struct parser *x, struct parser *y)
+{
+    int i;
+
+    if (x->stream.offset != y->stream.offset ||
+        x->c.chunk_sample_idx_assgin_by_seek != y->c.chunk_sample_idx_assgin_by_seek)
+        return 0;
+    for (i = 0; i < x->c.nb_streams; i++)
+    {
+        MOVStreamContext *s = x->c.streams[i], *t = y->c.streams[i];
+
+        if (memcmp(&s->mov_idx_curr, &t->mov_idx_curr, sizeof(s->mov_idx_curr)) ||
+            s->ctts_index != t->ctts_index || s->ctts_sample != t->ctts_sample ||
+            s->read_va_end != t->read_va_end)
+            return 0;
+    }
+    return 1;
+}
+
+static const SeekModeType modes[] = {
+    AW_SEEK_PREVIOUS_SYNC, AW_SEEK_NEXT_SYNC, AW_SEEK_CLOSEST_SYNC, AW_SEEK_CLOSEST,
+};
+
+static void check_scenario(const struct scenario *sc, int seeks, int quiet)
+{
+    struct track v, a;
+    struct parser *ref = malloc(sizeof(*ref)), *idx = malloc(sizeof(*idx));
+    double t0, t_ref = 0, t_idx = 0, t_build;
+    int i, r0, r1, m, bad = 0;
+    cdx_int64 ms;
+
+    build_tracks(sc, &v, &a);
+    parser_init(ref, &v, &a, 0);
+    parser_init(idx, &v, &a, 1);
+
+    t0 = now_us();
+    MovSeekSample(&idx->p, &idx->c, 0, AW_SEEK_PREVIOUS_SYNC);
+    t_build = now_us() - t0;
+    MovSeekSample(&ref->p, &ref->c, 0, AW_SEEK_PREVIOUS_SYNC);
+    CHECK(idx->video.seek_index_state == 1, "%s: no seek index", sc->name);
+    CHECK(same_state(ref, idx), "%s: seek to 0", sc->name);
+
+    for (i = 0; i < seeks; i++)
+    {
+        m = i % 4;
+        ms = i < 3 ? (cdx_int64)ref->p.totalTime - 1 - i : rnd(ref->p.totalTime);
+
+        t0 = now_us();
+        r0 = MovSeekSample(&ref->p, &ref->c, ms, modes[m]);
+        t_ref += now_us() - t0;
+        t0 = now_us();
+        r1 = MovSeekSample(&idx->p, &idx->c, ms, modes[m]);
+        t_idx += now_us() - t0;
+
+        if (r0 != r1 || !same_state(ref, idx))
+        {
+            if (bad++ < 5)
+                CHECK(0, "%s: seek to %lld ms mode %d: %d/%d, sample %u/%u dts %llu/%llu",
+                      sc->name, (long long)ms, modes[m], r0, r1,
+                      ref->video.mov_idx_curr.sample_idx, idx->video.mov_idx_curr.sample_idx,
+                      ref->video.mov_idx_curr.current_dts, idx->video.mov_idx_curr.current_dts);
+        }
+    }
+    CHECK(bad == 0, "%s: %d of %d seeks differ", sc->name, bad, seeks);
+
+    if (!quiet)
+        printf("%-14s %7u samples %6u stts %6u stss: index %5u points %4u KiB in %6.0f us, "
+               "seek %8.1f us -> %5.1f us\n", sc->name, sc->frames, v.st.stts_size,
+               v.st.stss_size, idx->video.seek_index_count,
+               (unsigned)(idx->video.seek_index_count * sizeof(MovSeekPoint) >> 10), t_build,
+               t_ref / seeks, t_idx / seeks);
+
+    parser_exit(ref);
+    parser_exit(idx);
+    free(ref);
+    free(idx);
+    free(v.ctts);
+}
+
+/* tables the index must leave alone: decreasing key frames, negative durations */
+static void check_fallback(void)
+{
+    struct scenario sc = scenarios[1];
+    struct track v, a;
+    struct parser *ref = malloc(sizeof(*ref)), *idx = malloc(sizeof(*idx));
+    unsigned int i;
+
+    build_tracks(&sc, &v, &a);
+    /* swap two key frames */
+    for (i = 0; i < 4; i++)
+    {
+        unsigned char t = moov[v.st.stss_offset + 4 + i];
+        moov[v.st.stss_offset + 4 + i] = moov[v.st.stss_offset + 8 + i];
+        moov[v.st.stss_offset + 8 + i] = t;
+    }
+    parser_init(ref, &v, &a, 0);
+    parser_init(idx, &v, &a, 1);
+    MovSeekSample(&ref->p, &ref->c, 15000, AW_SEEK_CLOSEST_SYNC);
+    MovSeekSample(&idx->p, &idx->c, 15000, AW_SEEK_CLOSEST_SYNC);
+    CHECK(idx->video.seek_index_state == -1 && idx->video.seek_index == NULL,
+          "index built over an unsorted stss");
+    CHECK(same_state(ref, idx), "seek without index");
+    parser_exit(ref);
+    parser_exit(idx);
+    free(ref);
+    free(idx);
+}
+
+/* ---- sidx ---- */
+
+static void check_sidx(int seeks, int quiet)
+{
+    struct track v, a;
+    struct parser *m = malloc(sizeof(*m));
+    MOVSidx *sidx;
+    int count = 20000, i, j, k, bad = 0;
+    CDX_U64 dts = 0, offset = 0x2000, time;
+    double t0, t_seek = 0;
+    cdx_int64 ms;
+
+    build_tracks(&scenarios[1], &v, &a);
+    parser_init(m, &v, &a, 1);
+    sidx = malloc(count * sizeof(*sidx));
+    for (i = 0; i < count; i++)
+    {
+        sidx[i].current_dts = dts;
+        sidx[i].offset = offset;
+        sidx[i].duration = 90000 + rnd(180000);
+        sidx[i].size = 100000 + rnd(1000000);
+        dts += sidx[i].duration;
+        offset += sidx[i].size;
+    }
+    m->c.sidx_buffer = sidx;
+    m->c.sidx_count = count;
+    m->c.has_audio = 0;
+
+    for (i = 0; i < seeks; i++)
+    {
+        ms = i == 0 ? 0 : i == 1 ? (cdx_int64)(dts / 90) + 5000 : rnd(dts / 90);
+        t0 = now_us();
+        MovSeekSampleFragment(&m->p, &m->c, ms * 1000);
+        t_seek += now_us() - t0;
+
+        time = (CDX_U64)ms * VIDEO_SCALE / 1000;
+        for (j = 0, k = 0; j < count && sidx[j].current_dts <= time; j++)
+            k = j;
+        if (m->video.mov_idx_curr.current_dts != sidx[k].current_dts ||
+            m->stream.offset != (cdx_int64)sidx[k].offset)
+            bad++;
+    }
+    CHECK(bad == 0, "sidx: %d of %d seeks differ", bad, seeks);
+    if (!quiet)
+        printf("sidx           %7d segments: seek %5.2f us\n", count, t_seek / seeks);
+
+    parser_exit(m);
+    free(m);
+    free(sidx);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+    unsigned int i;
+
+    for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+        check_scenario(&scenarios[i], quiet ? 400 : 2000, quiet);
+    check_fallback();
+    check_sidx(quiet ? 400 : 5000, quiet);
+
+    free(moov);
+    if (failures)
+    {
+        printf("mov_seek_test: %d failures\n", failures);
+        return 1;
+    }
+    printf("mov_seek_test: ok\n");
+    return 0;
+}
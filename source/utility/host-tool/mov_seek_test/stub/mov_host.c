@@ -0,0 +1,26 @@
+/*
+ * host stand-ins for what parser/mov/CdxMovSample.c takes from
+ * CdxMovAtom.c, which needs the whole parser: the moov byte readers
+ * and the top atom table.
+ */
+#include "CdxMovSample.h"
+#include "CdxMovAtom.h"
+
+MovTopParserProcess g_mov_top_parser[] = {
+    { 0, NULL },
+};
+
+CDX_U32 MoovGetLe32(unsigned char *s)
+{
+    return s[0] | (s[1] << 8) | (s[2] << 16) | ((CDX_U32)s[3] << 24);
+}
+
+CDX_U32 MoovGetBe32(unsigned char *s)
+{
+    return ((CDX_U32)s[0] << 24) | (s[1] << 16) | (s[2] << 8) | s[3];
+}
+
+CDX_S64 MoovGetBe64(unsigned char *s)
+{
+    return ((CDX_S64)MoovGetBe32(s) << 32) | MoovGetBe32(s + 4);
+}
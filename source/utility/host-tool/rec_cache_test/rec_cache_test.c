@@ -0,0 +1,404 @@
+/*
+ * Host test and benchmark for the prerecord cache of eyesee-mpp
+ * media/component/RecRender_cache.c, which keeps the last seconds of
+ * packets for emergency recording.
+ *
+ *   rec_cache_test          run the checks and the long stream benchmark
+ *   rec_cache_test -q       checks only
+ *
+ * Feeds a stream of video and audio packets like RecRender does, with and
+ * without a muxer reading the cache, and checks that the cache begins with
+ * a key frame and is not longer than the cache time, that the data of every
+ * cached packet is intact across the wrap of the ring, that the ring grows
+ * with the bitrate into one segment and frees the former ones, and that the
+ * key frame index follows the packets.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <plat_type.h>
+#include <record_writer.h>
+#include <RecRenderSink.h>
+#include <RecRender_cache.h>
+#include <cdx_list.h>
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+/* malloc calls of the cache, it is linked with --wrap=malloc */
+static long allocs;
+
+void *__real_malloc(size_t size);
+void *__wrap_malloc(size_t size)
+{
+    allocs++;
+    return __real_malloc(size);
+}
+
+typedef struct Stream
+{
+    int     mFrameRate;     //video frames per second
+    int     mGop;           //video frames per key frame
+    int     mFrameSize;     //bytes of a video frame, key frames are 4 times bigger
+    int     mAudioPerSecond;
+    int     mSplit;         //give the packets in two parts like the encoder ring does
+    int     mMuxerLag;      //packets the muxer holds, 0 for no muxer
+    int64_t mVideoPts;      //unit:us
+    int64_t mAudioPts;
+    int     mVideoIndex;
+    int     mIndex;
+    char    *mpData;
+    int     mHeld[256];     //ids held by the muxer, fifo
+    int     mHeldNum;
+} Stream;
+
+static unsigned char pattern(int nIndex, int i)
+{
+    return (unsigned char)(nIndex*131 + i);
+}
+
+static void stream_init(Stream *s, int nFrameRate, int nGop, int nFrameSize, int nMuxerLag)
+{
+    memset(s, 0, sizeof(*s));
+    s->mFrameRate = nFrameRate;
+    s->mGop = nGop;
+    s->mFrameSize = nFrameSize;
+    s->mAudioPerSecond = 43;
+    s->mMuxerLag = nMuxerLag;
+    s->mpData = malloc(nFrameSize*4);
+}
+
+/* push the next packet, then do what RecRender does with the cache */
+static void stream_push(Stream *s, RsPacketCacheManager *pCache)
+{
+    RecSinkPacket pkt;
+    int nSize, i;
+
+    memset(&pkt, 0, sizeof(pkt));
+    if (s->mAudioPts < s->mVideoPts)
+    {
+        pkt.mStreamType = CODEC_TYPE_AUDIO;
+        pkt.mPts = s->mAudioPts;
+        s->mAudioPts += 1000000 / s->mAudioPerSecond;
+        nSize = 300;
+    }
+    else
+    {
+        pkt.mStreamType = CODEC_TYPE_VIDEO;
+        pkt.mPts = s->mVideoPts;
+        s->mVideoPts += 1000000 / s->mFrameRate;
+        nSize = s->mFrameSize;
+        if (s->mVideoIndex % s->mGop == 0)
+        {
+            pkt.mFlags = AVPACKET_FLAG_KEYFRAME;
+            nSize *= 4;
+        }
+        s->mVideoIndex++;
+    }
+    nSize -= s->mIndex % 7;
+    pkt.mnTotalIndex = s->mIndex++;
+    for (i = 0; i < nSize; i++)
+    {
+        s->mpData[i] = pattern(pkt.mnTotalIndex, i);
+    }
+    pkt.mpData0 = s->mpData;
+    pkt.mSize0 = nSize;
+    if (s->mSplit && nSize > 1)
+    {
+        pkt.mSize0 = nSize / 3 + 1;
+        pkt.mpData1 = s->mpData + pkt.mSize0;
+        pkt.mSize1 = nSize - pkt.mSize0;
+    }
+    CHECK(pCache->PushPacket(pCache, &pkt) == SUCCESS, "push packet %d", pkt.mnTotalIndex);
+    pCache->ControlCacheLevel(pCache);
+
+    if (s->mMuxerLag > 0)
+    {
+        RecSinkPacket *pCachePkt;
+        while (pCache->GetPacket(pCache, &pCachePkt) == SUCCESS)
+        {
+            pCache->RefPacket(pCache, pCachePkt->mId);
+            s->mHeld[s->mHeldNum++] = pCachePkt->mId;
+            while (s->mHeldNum > s->mMuxerLag)
+            {
+                pCache->ReleasePacket(pCache, s->mHeld[0]);
+                memmove(s->mHeld, s->mHeld + 1, --s->mHeldNum * sizeof(int));
+            }
+        }
+    }
+}
+
+/* like RecRender before it destroys the cache: flush ready packets, the muxer releases */
+static void stream_release(Stream *s, RsPacketCacheManager *pCache)
+{
+    RecSinkPacket *pCachePkt;
+
+    while (pCache->GetPacket(pCache, &pCachePkt) == SUCCESS)
+    {
+    }
+    while (s->mHeldNum > 0)
+    {
+        pCache->ReleasePacket(pCache, s->mHeld[0]);
+        memmove(s->mHeld, s->mHeld + 1, --s->mHeldNum * sizeof(int));
+    }
+    free(s->mpData);
+}
+
+static int packet_intact(RecSinkPacket *p)
+{
+    int i, n = 0;
+
+    if (p->mSize1 > 0 && p->mpData1 == NULL)
+    {
+        return 0;
+    }
+    for (i = 0; i < p->mSize0; i++, n++)
+    {
+        if ((unsigned char)p->mpData0[i] != pattern(p->mnTotalIndex, n))
+        {
+            return 0;
+        }
+    }
+    for (i = 0; i < p->mSize1; i++, n++)
+    {
+        if ((unsigned char)p->mpData1[i] != pattern(p->mnTotalIndex, n))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int list_count(struct list_head *pList)
+{
+    struct list_head *pos;
+    int n = 0;
+
+    list_for_each(pos, pList)
+    {
+        n++;
+    }
+    return n;
+}
+
+/* walk using then ready packets, oldest first */
+static void check_cache(RsPacketCacheManager *pCache, const char *name)
+{
+    struct list_head *lists[2] = {&pCache->mUsingPacketList, &pCache->mReadyPacketList};
+    RecSinkPacket *p;
+    int64_t nFirstVideoPts = -1, nLastVideoPts = -1;
+    int nKeyFrames = 0, nPackets = 0, nSize = 0, bFirstVideoKey = 0, bIntact = 1, nLastId = -1, bOrder = 1;
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        list_for_each_entry(p, lists[i], mList)
+        {
+            if (p->mId <= nLastId)
+            {
+                bOrder = 0;
+            }
+            nLastId = p->mId;
+            nPackets++;
+            nSize += p->mSize0 + p->mSize1;
+            bIntact &= packet_intact(p);
+            if (CODEC_TYPE_VIDEO == p->mStreamType)
+            {
+                if (nFirstVideoPts < 0)
+                {
+                    nFirstVideoPts = p->mPts;
+                    bFirstVideoKey = (p->mFlags & AVPACKET_FLAG_KEYFRAME) != 0;
+                }
+                nLastVideoPts = p->mPts;
+                if (p->mFlags & AVPACKET_FLAG_KEYFRAME)
+                {
+                    nKeyFrames++;
+                }
+            }
+        }
+    }
+    CHECK(bOrder, "%s: packets out of order", name);
+    CHECK(bIntact, "%s: packet data corrupted", name);
+    CHECK(nPackets == pCache->mPacketCount, "%s: packet count %d != %d", name, nPackets, pCache->mPacketCount);
+    CHECK(nSize == pCache->mUsedBufSize, "%s: used size %d != %d", name, nSize, pCache->mUsedBufSize);
+    CHECK(list_count(&pCache->mReadyPacketList) == pCache->GetReadyPacketCount(pCache), "%s: ready count", name);
+    CHECK(nKeyFrames == pCache->mKeyFrameNum, "%s: key frame index %d != %d", name, pCache->mKeyFrameNum, nKeyFrames);
+    if (pCache->IsReady(pCache) && nFirstVideoPts >= 0)
+    {
+        CHECK(bFirstVideoKey, "%s: cache does not begin with a key frame", name);
+        CHECK((nLastVideoPts - nFirstVideoPts) / 1000 <= pCache->mCacheTime, "%s: cache %lldms longer than %lldms",
+            name, (long long)(nLastVideoPts - nFirstVideoPts) / 1000, (long long)pCache->mCacheTime);
+    }
+}
+
+static void run(const char *name, int64_t nCacheTime, int nFrameRate, int nGop, int nFrameSize, int nSplit, int nMuxerLag,
+    int nSeconds)
+{
+    RsPacketCacheManager *pCache = RsPacketCacheManagerConstruct(nCacheTime);
+    Stream s;
+    int i, n;
+
+    stream_init(&s, nFrameRate, nGop, nFrameSize, nMuxerLag);
+    s.mSplit = nSplit;
+    n = nSeconds * (nFrameRate + s.mAudioPerSecond);
+    for (i = 0; i < n; i++)
+    {
+        stream_push(&s, pCache);
+        if (i % 97 == 0 || i == n - 1)
+        {
+            check_cache(pCache, name);
+        }
+    }
+    CHECK(pCache->IsReady(pCache), "%s: cache full", name);
+    CHECK(list_count(&pCache->mDataBufList) == 1, "%s: %d segments left", name, list_count(&pCache->mDataBufList));
+    stream_release(&s, pCache);
+    RsPacketCacheManagerDestruct(pCache);
+}
+
+/* 8Mbps, 2s: the first 4MB segment is enough */
+static void test_basic(void)
+{
+    run("basic", 2000, 30, 30, 30000, 0, 0, 6);
+    run("split", 2000, 30, 30, 30000, 1, 0, 6);
+    run("muxer", 2000, 30, 15, 30000, 1, 10, 6);
+}
+
+/* 30Mbps for 5s: the ring has to grow, once the window is known it stays one segment */
+static void test_grow(void)
+{
+    RsPacketCacheManager *pCache = RsPacketCacheManagerConstruct(5000);
+    Stream s;
+    int i, nWindow = 0, nMaxBufSize = 0;
+    long nAllocs;
+
+    stream_init(&s, 30, 30, 100000, 4);
+    for (i = 0; i < 30 * 73; i++)
+    {
+        stream_push(&s, pCache);
+        if (pCache->mBufSize > nMaxBufSize)
+        {
+            nMaxBufSize = pCache->mBufSize;
+        }
+    }
+    check_cache(pCache, "grow");
+    nWindow = pCache->mUsedBufSize;
+    CHECK(pCache->mBufSize > 4 << 20, "ring did not grow");
+    CHECK(list_count(&pCache->mDataBufList) == 1, "former segments are not freed");
+
+    nAllocs = allocs;
+    for (i = 0; i < 30 * 73; i++)
+    {
+        stream_push(&s, pCache);
+    }
+    check_cache(pCache, "grown");
+    CHECK(allocs == nAllocs, "%ld mallocs once grown", allocs - nAllocs);
+    CHECK(pCache->mBufSize <= nWindow * 2, "ring %dKB for a window of %dKB", pCache->mBufSize / 1024, nWindow / 1024);
+    CHECK(nMaxBufSize <= nWindow * 4, "peak %dKB for a window of %dKB", nMaxBufSize / 1024, nWindow / 1024);
+    stream_release(&s, pCache);
+    RsPacketCacheManagerDestruct(pCache);
+}
+
+/* a gop longer than the cache time is released packet by packet */
+static void test_long_gop(void)
+{
+    run("long gop", 1000, 30, 150, 20000, 0, 0, 12);
+}
+
+/* a muxer which holds packets keeps them in cache */
+static void test_held(void)
+{
+    RsPacketCacheManager *pCache = RsPacketCacheManagerConstruct(1000);
+    Stream s;
+    RecSinkPacket *p;
+    int i, nFirstId;
+
+    stream_init(&s, 30, 30, 10000, 0);
+    for (i = 0; i < 30 * 2; i++)
+    {
+        stream_push(&s, pCache);
+    }
+    /* the muxer takes the cached window and holds its first packet */
+    CHECK(pCache->GetPacket(pCache, &p) == SUCCESS, "get packet");
+    nFirstId = p->mId;
+    pCache->RefPacket(pCache, nFirstId);
+    while (pCache->GetPacket(pCache, &p) == SUCCESS)
+    {
+    }
+    for (i = 0; i < 30 * 3; i++)
+    {
+        stream_push(&s, pCache);
+        while (pCache->GetPacket(pCache, &p) == SUCCESS)
+        {
+        }
+    }
+    p = list_first_entry(&pCache->mUsingPacketList, RecSinkPacket, mList);
+    CHECK(p->mId == nFirstId && packet_intact(p), "held packet is kept");
+    pCache->ReleasePacket(pCache, nFirstId);
+    stream_push(&s, pCache);
+    check_cache(pCache, "released");
+    p = list_first_entry(&pCache->mUsingPacketList, RecSinkPacket, mList);
+    CHECK(p->mId != nFirstId, "released packet is evicted");
+    stream_release(&s, pCache);
+    RsPacketCacheManagerDestruct(pCache);
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* 10 minutes of 8Mbps with a 10s prerecord window and a muxer */
+static void bench(void)
+{
+    RsPacketCacheManager *pCache = RsPacketCacheManagerConstruct(10000);
+    Stream s;
+    int i, n = 600 * (30 + 43), nMaxBufSize = 0;
+    long nAllocs = allocs;
+    double t0;
+
+    stream_init(&s, 30, 30, 30000, 10);
+    t0 = now_ms();
+    for (i = 0; i < n; i++)
+    {
+        stream_push(&s, pCache);
+        if (pCache->mBufSize > nMaxBufSize)
+        {
+            nMaxBufSize = pCache->mBufSize;
+        }
+    }
+    printf("%d packets: %.2f us/packet, %ld mallocs, window %dKB, ring %dKB, peak %dKB\n", n, (now_ms() - t0) * 1000 / n,
+        allocs - nAllocs, pCache->mUsedBufSize / 1024, pCache->mBufSize / 1024, nMaxBufSize / 1024);
+    stream_release(&s, pCache);
+    RsPacketCacheManagerDestruct(pCache);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    test_basic();
+    test_grow();
+    test_long_gop();
+    test_held();
+    if (!quiet)
+    {
+        bench();
+    }
+
+    printf("rec_cache_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+/*
+ * host stand-in for pthread_cond_wait_timeout() of media/utils/SystemBase.c,
+ * which needs the rest of the middleware. It waits on CLOCK_MONOTONIC like
+ * the condition RsPacketCacheManagerInit() sets up.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+int pthread_cond_wait_timeout(pthread_cond_t* const condition, pthread_mutex_t* const mutex, unsigned int msecs)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += msecs / 1000;
+    ts.tv_nsec += (msecs % 1000) * 1000000;
+    ts.tv_sec += ts.tv_nsec / 1000000000;
+    ts.tv_nsec %= 1000000000;
+    return pthread_cond_timedwait(condition, mutex, &ts);
+}
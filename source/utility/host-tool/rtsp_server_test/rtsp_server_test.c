@@ -0,0 +1,1278 @@
+/*
+ * Host test and benchmark for the rtsp server of eyesee-mpp
+ * middleware/sun8iw19p1/net/rtsp. A synthetic h264/h265 elementary stream
+ * is served on 127.0.0.1 to clients running in threads of the test.
+ *
+ *   rtsp_server_test        run the checks and the pacing benchmark
+ *   rtsp_server_test -q     checks only
+ *
+ * Checks the start code scan and the fu-a/fu split of frames wrapping at
+ * any offset, the token bucket with a fake clock, the rtsp dialog (sdp,
+ * 404/454/461/501, rtp-info), byte exact access units over interleaved tcp
+ * and udp, the sender and receiver reports, one packetization for several
+ * clients, a late client starting at a key frame, the backlog of a client
+ * which stops reading, the frame trace of the send stage and the spread of
+ * a paced key frame.
+ */
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <rtp_pacer.h>
+#include <rtp_packetizer.h>
+#include <rtsp_server.h>
+#include <mpp_frametrace.h>
+
+#define MAX_AU_NUM      128
+#define FRAME_US        33333
+#define GOP             15
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+/* host stand-in for the SystemBase.c call of the server */
+int64_t CDX_GetSysTimeUsMonotonic(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static unsigned int rnd_state = 1;
+
+static unsigned int rnd(void)
+{
+    rnd_state = rnd_state * 1103515245 + 12345;
+    return (rnd_state >> 8) & 0xffffff;
+}
+
+/* ------------------------------------------------------------------------
+ * synthetic elementary stream
+ */
+
+typedef struct
+{
+    uint8_t *raw;       /* annexb as the encoder gives it */
+    size_t raw_len;
+    uint8_t *norm;      /* the nals with 4 byte start codes, as a client rebuilds them */
+    size_t norm_len;
+    uint8_t *sets;      /* the parameter sets of a key frame, annexb */
+    size_t sets_len;
+    int key;
+    int64_t pts;
+} AU;
+
+static void put(uint8_t *buf, size_t *len, const void *data, size_t n)
+{
+    memcpy(buf + *len, data, n);
+    *len += n;
+}
+
+/* nal of n bytes after its header, with zeros but no start code emulation */
+static size_t make_nal_body(uint8_t *p, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        unsigned int r = rnd();
+        p[i] = (r & 7) == 0 ? 0 : (uint8_t)(r >> 3);
+        if (i >= 2 && p[i - 1] == 0 && p[i - 2] == 0 && p[i] <= 3)
+        {
+            p[i] = 3;
+        }
+    }
+    if (n > 0 && p[n - 1] == 0)
+    {
+        p[n - 1] = 0x80;    /* rbsp_stop_one_bit */
+    }
+    return n;
+}
+
+static void add_nal(AU *au, const uint8_t *nal, size_t n, int long_start_code, int trailing_zeros)
+{
+    static const uint8_t sc4[4] = {0, 0, 0, 1};
+
+    put(au->raw, &au->raw_len, long_start_code ? sc4 : sc4 + 1, long_start_code ? 4 : 3);
+    put(au->raw, &au->raw_len, nal, n);
+    while (trailing_zeros-- > 0)
+    {
+        au->raw[au->raw_len++] = 0;
+    }
+    put(au->norm, &au->norm_len, sc4, 4);
+    put(au->norm, &au->norm_len, nal, n);
+}
+
+/*
+ * a frame of the stream: the parameter sets on the key frames if inline_sets,
+ * then the slice. The sets of a key frame are in au->sets in any case.
+ */
+static void make_au(AU *au, RTP_CODEC_E codec, int index, int key, int inline_sets, size_t slice_len)
+{
+    static const uint8_t sc4[4] = {0, 0, 0, 1};
+    uint8_t nal[64];
+    uint8_t *slice;
+    size_t n;
+    int i;
+
+    memset(au, 0, sizeof(*au));
+    au->raw = malloc(slice_len + 512);
+    au->norm = malloc(slice_len + 512);
+    au->sets = malloc(512);
+    au->key = key;
+    au->pts = (int64_t)index * FRAME_US;
+    if (key)
+    {
+        for (i = codec == RTP_CODEC_H264 ? 1 : 0; i < 3; i++)
+        {
+            if (codec == RTP_CODEC_H264)
+            {
+                /* sps: baseline, level 3.1 */
+                static const uint8_t h264_hdr[3][4] = {{0}, {0x67, 0x42, 0xc0, 0x1f}, {0x68, 0xce, 0x3c, 0x80}};
+                memcpy(nal, h264_hdr[i], 4);
+            }
+            else
+            {
+                nal[0] = (32 + i) << 1;
+                nal[1] = 1;
+                nal[2] = 0x0c;
+                nal[3] = 0x01;
+            }
+            n = 4 + make_nal_body(nal + 4, i == 2 ? 3 : 20);
+            put(au->sets, &au->sets_len, sc4, 4);
+            put(au->sets, &au->sets_len, nal, n);
+            if (inline_sets)
+            {
+                add_nal(au, nal, n, 1, i == 2);
+            }
+        }
+    }
+    slice = malloc(slice_len);
+    if (codec == RTP_CODEC_H264)
+    {
+        slice[0] = key ? 0x65 : 0x41;
+        make_nal_body(slice + 1, slice_len - 1);
+    }
+    else
+    {
+        slice[0] = (key ? 19 : 1) << 1;
+        slice[1] = 1;
+        make_nal_body(slice + 2, slice_len - 2);
+    }
+    add_nal(au, slice, slice_len, !inline_sets || !key, index % 3 == 0);
+    free(slice);
+}
+
+static void free_au(AU *au)
+{
+    free(au->raw);
+    free(au->norm);
+    free(au->sets);
+}
+
+/* the frame in two buffers split at off, as a wrap in the venc ring buffer */
+static void split_frame(const AU *au, size_t off, RTP_FRAME_BUF_S *buf)
+{
+    uint8_t *a = malloc(off ? off : 1);
+    uint8_t *b = malloc(au->raw_len - off ? au->raw_len - off : 1);
+
+    memcpy(a, au->raw, off);
+    memcpy(b, au->raw + off, au->raw_len - off);
+    buf->mpData[0] = a;
+    buf->mLen[0] = off;
+    buf->mpData[1] = b;
+    buf->mLen[1] = au->raw_len - off;
+}
+
+static void free_frame(RTP_FRAME_BUF_S *buf)
+{
+    free((void *)buf->mpData[0]);
+    free((void *)buf->mpData[1]);
+}
+
+static size_t base64(const uint8_t *src, size_t n, char *dst)
+{
+    static const char t[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i, o = 0;
+
+    for (i = 0; i < n; i += 3)
+    {
+        unsigned int v = src[i] << 16 | (i + 1 < n ? src[i + 1] << 8 : 0) | (i + 2 < n ? src[i + 2] : 0);
+        dst[o++] = t[v >> 18 & 63];
+        dst[o++] = t[v >> 12 & 63];
+        dst[o++] = i + 1 < n ? t[v >> 6 & 63] : '=';
+        dst[o++] = i + 2 < n ? t[v & 63] : '=';
+    }
+    dst[o] = 0;
+    return o;
+}
+
+/* ------------------------------------------------------------------------
+ * depacketizer, the way a player rebuilds the access units
+ */
+
+typedef struct
+{
+    RTP_CODEC_E codec;
+    uint8_t *cur;
+    size_t cur_len, cur_cap;
+    int in_fu;
+    int have_seq;
+    uint16_t first_seq, last_seq;
+    int seq_gaps;
+    int fu_errors;
+    unsigned int max_packet;
+    int64_t cur_start_us;
+
+    uint8_t *au[MAX_AU_NUM];
+    size_t au_len[MAX_AU_NUM];
+    uint32_t au_ts[MAX_AU_NUM];
+    int64_t au_spread_us[MAX_AU_NUM];   /* first to last packet */
+    int au_num;
+
+    /* arrival of the bytes, for the peak rate */
+    int64_t *arrival_us;
+    int *arrival_bytes;
+    int arrivals, arrival_cap;
+} DEPACK;
+
+static void append(DEPACK *d, const uint8_t *p, size_t n)
+{
+    if (d->cur_len + n > d->cur_cap)
+    {
+        d->cur_cap = (d->cur_len + n) * 2;
+        d->cur = realloc(d->cur, d->cur_cap);
+    }
+    memcpy(d->cur + d->cur_len, p, n);
+    d->cur_len += n;
+}
+
+static void depack_rtp(DEPACK *d, const uint8_t *p, unsigned int len)
+{
+    static const uint8_t sc4[4] = {0, 0, 0, 1};
+    int64_t now = CDX_GetSysTimeUsMonotonic();
+    uint16_t seq;
+    const uint8_t *pl;
+    unsigned int pl_len;
+    int type;
+
+    if (len < RTP_HEADER_SIZE + 2 || (p[0] >> 6) != 2)
+    {
+        d->fu_errors++;
+        return;
+    }
+    seq = p[2] << 8 | p[3];
+    if (!d->have_seq)
+    {
+        d->first_seq = seq;
+        d->have_seq = 1;
+    }
+    else if ((uint16_t)(d->last_seq + 1) != seq)
+    {
+        d->seq_gaps++;
+    }
+    d->last_seq = seq;
+    if (len > d->max_packet)
+    {
+        d->max_packet = len;
+    }
+    if (d->arrivals < d->arrival_cap)
+    {
+        d->arrival_us[d->arrivals] = now;
+        d->arrival_bytes[d->arrivals++] = len;
+    }
+    if (d->cur_len == 0)
+    {
+        d->cur_start_us = now;
+    }
+
+    pl = p + RTP_HEADER_SIZE;
+    pl_len = len - RTP_HEADER_SIZE;
+    if (d->codec == RTP_CODEC_H264)
+    {
+        type = pl[0] & 0x1f;
+        if (type == 28)
+        {
+            uint8_t hdr = (pl[0] & 0xe0) | (pl[1] & 0x1f);
+            if (pl[1] & 0x80)
+            {
+                d->fu_errors += d->in_fu;
+                d->in_fu = 1;
+                append(d, sc4, 4);
+                append(d, &hdr, 1);
+            }
+            else if (!d->in_fu)
+            {
+                d->fu_errors++;
+            }
+            append(d, pl + 2, pl_len - 2);
+            if (pl[1] & 0x40)
+            {
+                d->in_fu = 0;
+            }
+        }
+        else
+        {
+            d->fu_errors += d->in_fu;
+            append(d, sc4, 4);
+            append(d, pl, pl_len);
+        }
+    }
+    else
+    {
+        type = pl[0] >> 1 & 0x3f;
+        if (type == 49)
+        {
+            uint8_t hdr[2] = {(uint8_t)((pl[0] & 0x81) | (pl[2] & 0x3f) << 1), pl[1]};
+            if (pl[2] & 0x80)
+            {
+                d->fu_errors += d->in_fu;
+                d->in_fu = 1;
+                append(d, sc4, 4);
+                append(d, hdr, 2);
+            }
+            else if (!d->in_fu)
+            {
+                d->fu_errors++;
+            }
+            append(d, pl + 3, pl_len - 3);
+            if (pl[2] & 0x40)
+            {
+                d->in_fu = 0;
+            }
+        }
+        else
+        {
+            d->fu_errors += d->in_fu;
+            append(d, sc4, 4);
+            append(d, pl, pl_len);
+        }
+    }
+
+    if (p[1] & 0x80)
+    {
+        d->fu_errors += d->in_fu;
+        d->in_fu = 0;
+        if (d->au_num < MAX_AU_NUM)
+        {
+            d->au[d->au_num] = malloc(d->cur_len);
+            memcpy(d->au[d->au_num], d->cur, d->cur_len);
+            d->au_len[d->au_num] = d->cur_len;
+            d->au_ts[d->au_num] = (uint32_t)p[4] << 24 | p[5] << 16 | p[6] << 8 | p[7];
+            d->au_spread_us[d->au_num] = now - d->cur_start_us;
+            d->au_num++;
+        }
+        d->cur_len = 0;
+    }
+}
+
+static void depack_free(DEPACK *d)
+{
+    int i;
+
+    for (i = 0; i < d->au_num; i++)
+    {
+        free(d->au[i]);
+    }
+    free(d->cur);
+    free(d->arrival_us);
+    free(d->arrival_bytes);
+}
+
+/* ------------------------------------------------------------------------
+ * packetizer and pacer
+ */
+
+static void flatten(const RTP_PACKET_S *pkt, uint8_t *out)
+{
+    size_t n = 0;
+    int i;
+
+    for (i = 0; i < pkt->mIovNum; i++)
+    {
+        memcpy(out + n, pkt->mIov[i].iov_base, pkt->mIov[i].iov_len);
+        n += pkt->mIov[i].iov_len;
+    }
+}
+
+static void test_packetizer_codec(RTP_CODEC_E codec)
+{
+    const char *name = codec == RTP_CODEC_H264 ? "h264" : "h265";
+    const unsigned int max_payload = 100;
+    RTP_PACKETIZER_S pz;
+    RTP_NAL_S nals[16];
+    uint8_t pkt_buf[RTP_HEADER_SIZE + 128];
+    AU au;
+    size_t off;
+    int frame;
+
+    CHECK(RtpPacketizerInit(&pz, codec, max_payload, 0x1234, 65530) == 0, "%s init", name);
+    for (frame = 0; frame < 4; frame++)
+    {
+        make_au(&au, codec, frame, frame == 0 || frame == 2, frame != 2, frame == 3 ? 60 : 1000);
+        /* every split, the ones inside the start codes above all */
+        for (off = 0; off <= au.raw_len; off++)
+        {
+            RTP_FRAME_BUF_S buf;
+            DEPACK d;
+            int num, i, n;
+
+            split_frame(&au, off, &buf);
+            num = RtpFindNalUnits(&buf, nals, 16);
+            memset(&d, 0, sizeof(d));
+            d.codec = codec;
+            n = RtpPacketizeNals(&pz, &buf, nals, num, 9000, 1);
+            CHECK(n > 0 && n == pz.mPacketNum, "%s frame %d split %zu: %d packets", name, frame, off, n);
+            for (i = 0; i < pz.mPacketNum; i++)
+            {
+                const RTP_PACKET_S *pkt = &pz.mpPackets[i];
+                if (pkt->mLen > RTP_HEADER_SIZE + max_payload || pkt->mIovNum > RTP_PACKET_IOV_MAX)
+                {
+                    CHECK(0, "%s frame %d split %zu: packet %d of %u bytes, %d iovs", name, frame, off, i, pkt->mLen, pkt->mIovNum);
+                    break;
+                }
+                CHECK(!!(pkt->mHeader[1] & 0x80) == (i == pz.mPacketNum - 1), "%s frame %d: marker of packet %d", name, frame, i);
+                flatten(pkt, pkt_buf);
+                depack_rtp(&d, pkt_buf, pkt->mLen);
+            }
+            if (d.au_num != 1 || d.au_len[0] != au.norm_len || memcmp(d.au[0], au.norm, au.norm_len) || d.fu_errors || d.seq_gaps)
+            {
+                CHECK(0, "%s frame %d split %zu: %d nals, rebuilt %zu bytes of %zu, %d fu errors, %d gaps",
+                      name, frame, off, num, d.au_num ? d.au_len[0] : 0, au.norm_len, d.fu_errors, d.seq_gaps);
+                off = au.raw_len;
+            }
+            depack_free(&d);
+            free_frame(&buf);
+        }
+        free_au(&au);
+    }
+
+    /* too many nals */
+    make_au(&au, codec, 0, 1, 1, 200);
+    {
+        RTP_FRAME_BUF_S buf = {{au.raw, NULL}, {(unsigned int)au.raw_len, 0}};
+        CHECK(RtpFindNalUnits(&buf, nals, 1) == -1, "%s: more nals than room", name);
+        CHECK(RtpFindNalUnits(&buf, nals, 16) == (codec == RTP_CODEC_H264 ? 3 : 4), "%s: nal count", name);
+    }
+    free_au(&au);
+    RtpPacketizerDeinit(&pz);
+}
+
+static void test_packetizer(void)
+{
+    rnd_state = 7;
+    test_packetizer_codec(RTP_CODEC_H264);
+    test_packetizer_codec(RTP_CODEC_H265);
+}
+
+static void test_pacer(void)
+{
+    RTP_PACER_S p;
+
+    /* 8Mbps: a byte a us */
+    RtpPacerInit(&p, 8000000, 10000);
+    CHECK(RtpPacerDelayUs(&p, 10000, 0) == 0, "full bucket");
+    RtpPacerConsume(&p, 10000, 0);
+    CHECK(RtpPacerDelayUs(&p, 1000, 0) == 1000, "empty bucket: %lld", (long long)RtpPacerDelayUs(&p, 1000, 0));
+    CHECK(RtpPacerDelayUs(&p, 1000, 400) == 600, "refill: %lld", (long long)RtpPacerDelayUs(&p, 1000, 400));
+    CHECK(RtpPacerDelayUs(&p, 1000, 1000) == 0, "refilled");
+    RtpPacerConsume(&p, 1000, 1000);
+    /* bigger than the bucket: goes when it is full */
+    CHECK(RtpPacerDelayUs(&p, 50000, 1000) == 10000, "big packet: %lld", (long long)RtpPacerDelayUs(&p, 50000, 1000));
+    RtpPacerConsume(&p, 50000, 11000);
+    CHECK(RtpPacerDelayUs(&p, 1, 11000) == 40001, "debt of the big packet: %lld", (long long)RtpPacerDelayUs(&p, 1, 11000));
+    /* idle: the bucket does not grow past its size */
+    CHECK(RtpPacerDelayUs(&p, 10000, 10000000) == 0, "idle");
+    RtpPacerConsume(&p, 10000, 10000000);
+    CHECK(RtpPacerDelayUs(&p, 1, 10000000) == 1, "capped at the burst");
+    /* a clock going back does not refill */
+    CHECK(RtpPacerDelayUs(&p, 1, 5000000) == 1, "clock going back");
+
+    RtpPacerInit(&p, 0, 0);
+    RtpPacerConsume(&p, 1000000, 0);
+    CHECK(RtpPacerDelayUs(&p, 1000000, 0) == 0, "no pacing");
+}
+
+/* ------------------------------------------------------------------------
+ * rtsp client
+ */
+
+typedef struct
+{
+    int fd;
+    int tcp;
+    int udp[2];
+    int server_rtcp_port;
+    int rtcp_channel;
+    char buf[70000];
+    int len;
+    int cseq;
+    char session[32];
+    char resp[8192];
+    int rtp_info_seq;
+
+    DEPACK d;
+    int sr_count;
+    pthread_t thread;
+    int stop;          /* __atomic */
+} CLIENT;
+
+static int client_open(CLIENT *c, int port, RTP_CODEC_E codec)
+{
+    struct sockaddr_in sa;
+
+    memset(c, 0, sizeof(*c));
+    c->udp[0] = c->udp[1] = -1;
+    c->rtp_info_seq = -1;
+    c->d.codec = codec;
+    c->d.arrival_cap = 20000;
+    c->d.arrival_us = malloc(sizeof(int64_t) * c->d.arrival_cap);
+    c->d.arrival_bytes = malloc(sizeof(int) * c->d.arrival_cap);
+    c->fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return connect(c->fd, (struct sockaddr *)&sa, sizeof(sa));
+}
+
+static void client_close(CLIENT *c)
+{
+    close(c->fd);
+    if (c->udp[0] >= 0)
+    {
+        close(c->udp[0]);
+        close(c->udp[1]);
+    }
+    depack_free(&c->d);
+}
+
+/* receiver report answering the sender report p */
+static void client_on_rtcp(CLIENT *c, const uint8_t *p, int len)
+{
+    uint8_t rr[36];
+
+    if (len < 28 || p[1] != 200)
+    {
+        return;
+    }
+    c->sr_count++;
+    memset(rr, 0, sizeof(rr));
+    rr[0] = 0x81;
+    rr[1] = 201;
+    rr[3] = 7;
+    rr[4] = 0x11;                   /* ssrc of the client */
+    memcpy(rr + 8, p + 4, 4);       /* of the sender */
+    rr[12] = 5;                     /* fraction lost */
+    rr[15] = 7;                     /* cumulative lost */
+    rr[18] = c->d.last_seq >> 8;
+    rr[19] = c->d.last_seq & 0xff;
+    rr[23] = 90;                    /* jitter */
+    memcpy(rr + 24, p + 10, 4);     /* lsr */
+    if (c->tcp)
+    {
+        uint8_t frame[40] = {'$', (uint8_t)c->rtcp_channel, 0, 32};
+        memcpy(frame + 4, rr, 32);
+        send(c->fd, frame, 36, MSG_NOSIGNAL);
+    }
+    else
+    {
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(c->server_rtcp_port);
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sendto(c->udp[1], rr, 32, 0, (struct sockaddr *)&sa, sizeof(sa));
+    }
+}
+
+/* interleaved packets at the head of the buffer, @return 1 if one was taken */
+static int client_take_interleaved(CLIENT *c)
+{
+    const uint8_t *p = (const uint8_t *)c->buf;
+    int n;
+
+    if (c->len < 4 || p[0] != '$')
+    {
+        return 0;
+    }
+    n = p[2] << 8 | p[3];
+    if (c->len < 4 + n)
+    {
+        return 0;
+    }
+    if (p[1] == c->rtcp_channel)
+    {
+        client_on_rtcp(c, p + 4, n);
+    }
+    else
+    {
+        depack_rtp(&c->d, p + 4, n);
+    }
+    c->len -= 4 + n;
+    memmove(c->buf, c->buf + 4 + n, c->len);
+    return 1;
+}
+
+static int client_recv(CLIENT *c, int timeout_ms)
+{
+    struct pollfd pfd = {c->fd, POLLIN, 0};
+    int n;
+
+    if (poll(&pfd, 1, timeout_ms) <= 0)
+    {
+        return -1;
+    }
+    n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+    if (n <= 0)
+    {
+        return -1;
+    }
+    c->len += n;
+    return 0;
+}
+
+/* @return the status code of the response, -1 if none */
+static int client_request(CLIENT *c, const char *method, const char *url, const char *headers)
+{
+    char req[1024];
+    int n;
+
+    n = snprintf(req, sizeof(req), "%s %s RTSP/1.0\r\nCSeq: %d\r\nUser-Agent: rtsp_server_test\r\n%s%s%s%s\r\n",
+                 method, url, ++c->cseq, c->session[0] ? "Session: " : "", c->session, c->session[0] ? "\r\n" : "",
+                 headers ? headers : "");
+    if (send(c->fd, req, n, MSG_NOSIGNAL) != n)
+    {
+        return -1;
+    }
+    for (;;)
+    {
+        char *end;
+        const char *cl;
+        int hdr, body = 0, code = -1, cseq = -1;
+
+        while (client_take_interleaved(c))
+        {
+        }
+        c->buf[c->len] = 0;
+        end = c->len > 0 && c->buf[0] != '$' ? strstr(c->buf, "\r\n\r\n") : NULL;
+        if (end)
+        {
+            hdr = end + 4 - c->buf;
+            cl = strstr(c->buf, "Content-Length: ");
+            if (cl && cl < end)
+            {
+                body = atoi(cl + 16);
+            }
+            if (c->len >= hdr + body)
+            {
+                memcpy(c->resp, c->buf, hdr + body);
+                c->resp[hdr + body] = 0;
+                c->len -= hdr + body;
+                memmove(c->buf, c->buf + hdr + body, c->len);
+                sscanf(c->resp, "RTSP/1.0 %d", &code);
+                cl = strstr(c->resp, "CSeq: ");
+                if (cl)
+                {
+                    cseq = atoi(cl + 6);
+                }
+                CHECK(cseq == c->cseq, "%s: cseq %d of %d", method, cseq, c->cseq);
+                return code;
+            }
+        }
+        if (client_recv(c, 2000) != 0)
+        {
+            return -1;
+        }
+    }
+}
+
+static const char *header_value(const char *resp, const char *name)
+{
+    const char *p = strstr(resp, name);
+    return p ? p + strlen(name) : NULL;
+}
+
+static int client_setup(CLIENT *c, const char *url, int tcp)
+{
+    char transport[128];
+    char track[300];
+    const char *p;
+    int code;
+
+    c->tcp = tcp;
+    if (tcp)
+    {
+        c->rtcp_channel = 1;
+        snprintf(transport, sizeof(transport), "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n");
+    }
+    else
+    {
+        struct sockaddr_in sa;
+        socklen_t sl = sizeof(sa);
+        int rcvbuf = 4 * 1024 * 1024;
+        int i;
+        for (i = 0; i < 2; i++)
+        {
+            c->udp[i] = socket(AF_INET, SOCK_DGRAM, 0);
+            setsockopt(c->udp[i], SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+            memset(&sa, 0, sizeof(sa));
+            sa.sin_family = AF_INET;
+            sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            bind(c->udp[i], (struct sockaddr *)&sa, sizeof(sa));
+        }
+        getsockname(c->udp[0], (struct sockaddr *)&sa, &sl);
+        snprintf(transport, sizeof(transport), "Transport: RTP/AVP;unicast;client_port=%d", ntohs(sa.sin_port));
+        getsockname(c->udp[1], (struct sockaddr *)&sa, &sl);
+        snprintf(transport + strlen(transport), sizeof(transport) - strlen(transport), "-%d\r\n", ntohs(sa.sin_port));
+    }
+    snprintf(track, sizeof(track), "%s/track0", url);
+    code = client_request(c, "SETUP", track, transport);
+    if (code != 200)
+    {
+        return code;
+    }
+    p = header_value(c->resp, "Session: ");
+    if (p)
+    {
+        sscanf(p, "%31[^;\r]", c->session);
+    }
+    CHECK(p && strstr(c->resp, "timeout=60"), "session of the setup response");
+    if (tcp)
+    {
+        CHECK(strstr(c->resp, "interleaved=0-1") != NULL, "interleaved channels");
+    }
+    else
+    {
+        p = header_value(c->resp, "server_port=");
+        CHECK(p != NULL, "server port");
+        c->server_rtcp_port = p ? atoi(p) + 1 : 0;
+    }
+    return code;
+}
+
+static void *client_thread(void *arg)
+{
+    CLIENT *c = arg;
+
+    while (!__atomic_load_n(&c->stop, __ATOMIC_ACQUIRE))
+    {
+        if (c->tcp)
+        {
+            if (client_recv(c, 20) == 0)
+            {
+                while (client_take_interleaved(c))
+                {
+                }
+            }
+        }
+        else
+        {
+            struct pollfd pfd[2] = {{c->udp[0], POLLIN, 0}, {c->udp[1], POLLIN, 0}};
+            uint8_t pkt[2048];
+            int i, n;
+            if (poll(pfd, 2, 20) <= 0)
+            {
+                continue;
+            }
+            for (i = 0; i < 2; i++)
+            {
+                if (pfd[i].revents & POLLIN)
+                {
+                    n = recv(c->udp[i], pkt, sizeof(pkt), 0);
+                    if (n > 0 && i == 0)
+                    {
+                        depack_rtp(&c->d, pkt, n);
+                    }
+                    else if (n > 0)
+                    {
+                        client_on_rtcp(c, pkt, n);
+                    }
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static int client_play(CLIENT *c, const char *url)
+{
+    int code = client_request(c, "PLAY", url, NULL);
+    const char *p;
+
+    if (code == 200)
+    {
+        p = header_value(c->resp, "seq=");
+        c->rtp_info_seq = p ? atoi(p) : -1;
+        CHECK(p && strstr(c->resp, "rtptime="), "rtp-info of the play response");
+        __atomic_store_n(&c->stop, 0, __ATOMIC_RELEASE);
+        pthread_create(&c->thread, NULL, client_thread, c);
+    }
+    return code;
+}
+
+static void client_stop(CLIENT *c)
+{
+    __atomic_store_n(&c->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(c->thread, NULL);
+}
+
+/* ------------------------------------------------------------------------
+ * server tests
+ */
+
+static RTSP_SERVER_S *open_server(void)
+{
+    RTSP_SERVER_ATTR_S attr;
+
+    memset(&attr, 0, sizeof(attr));
+    strcpy(attr.mIp, "127.0.0.1");
+    attr.mRtcpIntervalMs = 100;
+    return RtspServerCreate(&attr);
+}
+
+static RTSP_STREAM_S *open_stream(RTSP_SERVER_S *server, const char *name, RTP_CODEC_E codec, int max_payload, int pace_bitrate)
+{
+    RTSP_STREAM_ATTR_S attr;
+
+    memset(&attr, 0, sizeof(attr));
+    snprintf(attr.mName, sizeof(attr.mName), "%s", name);
+    attr.meCodec = codec;
+    attr.mMaxPayload = max_payload;
+    attr.mPaceBitRate = pace_bitrate;
+    return RtspServerCreateStream(server, &attr);
+}
+
+static void send_au(RTSP_STREAM_S *stream, const AU *au)
+{
+    RTSP_FRAME_S frame;
+
+    split_frame(au, rnd() % (au->raw_len + 1), &frame.mBuf);
+    frame.mPts = au->pts;
+    frame.mbKeyFrame = au->key;
+    CHECK(RtspStreamSendFrame(stream, &frame) == 0, "send frame");
+    free_frame(&frame.mBuf);
+}
+
+/* the client rebuilt aus[first...] byte for byte, after the sets of sets_au on the key frames if not inline */
+static void check_aus(const char *what, const CLIENT *c, const AU *aus, int first, int num, const AU *sets_au)
+{
+    uint8_t *expect = malloc(200000);
+    int i;
+
+    CHECK(c->d.au_num == num, "%s: %d frames of %d", what, c->d.au_num, num);
+    for (i = 0; i < c->d.au_num && i < num; i++)
+    {
+        const AU *au = &aus[first + i];
+        size_t n = 0;
+        if (au->key && sets_au)
+        {
+            put(expect, &n, sets_au->sets, sets_au->sets_len);
+        }
+        put(expect, &n, au->norm, au->norm_len);
+        if (c->d.au_len[i] != n || memcmp(c->d.au[i], expect, n))
+        {
+            CHECK(0, "%s: frame %d differs, %zu bytes of %zu", what, first + i, c->d.au_len[i], n);
+            break;
+        }
+        if (i > 0)
+        {
+            uint32_t dt = c->d.au_ts[i] - c->d.au_ts[i - 1];
+            CHECK(dt == (uint32_t)(au->pts * 9 / 100 - au[-1].pts * 9 / 100), "%s: timestamp step %u", what, dt);
+        }
+    }
+    CHECK(c->d.seq_gaps == 0 && c->d.fu_errors == 0, "%s: %d sequence gaps, %d fu errors", what, c->d.seq_gaps, c->d.fu_errors);
+    free(expect);
+}
+
+static void test_dialog(RTSP_SERVER_S *server, char *url)
+{
+    CLIENT c;
+    char bad[300];
+    char b64[64];
+    AU au;
+    RTSP_STREAM_S *stream = open_stream(server, "h265", RTP_CODEC_H265, 0, 0);
+
+    rnd_state = 11;
+    make_au(&au, RTP_CODEC_H265, 0, 1, 0, 100);
+    CHECK(RtspStreamSetParameterSets(stream, au.sets, au.sets_len) == 0, "set parameter sets");
+    RtspStreamGetUrl(stream, url, 256);
+
+    CHECK(client_open(&c, RtspServerGetPort(server), RTP_CODEC_H265) == 0, "connect");
+    CHECK(client_request(&c, "OPTIONS", url, NULL) == 200 && strstr(c.resp, "Public: ") && strstr(c.resp, "SETUP"), "options");
+    CHECK(client_request(&c, "DESCRIBE", url, "Accept: application/sdp\r\n") == 200, "describe");
+    CHECK(strstr(c.resp, "Content-Type: application/sdp") && strstr(c.resp, "a=rtpmap:96 H265/90000")
+          && strstr(c.resp, "a=control:track0"), "h265 sdp:\n%s", c.resp);
+    base64(au.sets + 4, 4 + 20, b64);
+    CHECK(strstr(c.resp, b64) && strstr(c.resp, "sprop-vps="), "sprop-vps %s", b64);
+    base64(au.sets + 2 * (4 + 24) + 4, 4 + 3, b64);
+    CHECK(strstr(c.resp, b64) && strstr(c.resp, "sprop-pps="), "sprop-pps %s", b64);
+
+    snprintf(bad, sizeof(bad), "rtsp://127.0.0.1:%d/nosuch", RtspServerGetPort(server));
+    CHECK(client_request(&c, "DESCRIBE", bad, NULL) == 404, "describe of an unknown stream");
+    CHECK(client_request(&c, "RECORD", url, NULL) == 501, "record");
+    CHECK(client_request(&c, "PLAY", url, NULL) == 454, "play before setup");
+    strcpy(c.session, "DEADBEEF");
+    CHECK(client_request(&c, "PLAY", url, NULL) == 454, "play of another session");
+    c.session[0] = 0;
+    snprintf(bad, sizeof(bad), "%s/track0", url);
+    CHECK(client_request(&c, "SETUP", bad, "Transport: RTP/AVP;multicast;port=5000-5001\r\n") == 461, "multicast setup");
+    CHECK(client_setup(&c, url, 1) == 200, "setup");
+    CHECK(client_request(&c, "GET_PARAMETER", url, NULL) == 200, "keep alive");
+    CHECK(client_request(&c, "TEARDOWN", url, NULL) == 200, "teardown");
+    CHECK(client_request(&c, "PLAY", url, NULL) == 454, "play after teardown");
+    client_close(&c);
+    free_au(&au);
+}
+
+/* max_payload above what a partly sent interleaved packet can keep is clamped */
+static void test_tcp(RTSP_SERVER_S *server, const char *name, int max_payload)
+{
+    enum { FRAMES = 45, CLAMPED_PAYLOAD = 8173 };
+    RTSP_STREAM_S *stream = open_stream(server, name, RTP_CODEC_H264, max_payload, 0);
+    unsigned int payload = max_payload <= 0 ? 1400 : max_payload > CLAMPED_PAYLOAD ? CLAMPED_PAYLOAD : max_payload;
+    RTSP_STREAM_STAT_S stat;
+    RTSP_CLIENT_STAT_S cs[4];
+    MPP_FRAMETRACE_STAT_S trace0, trace;
+    AU aus[FRAMES];
+    CLIENT c;
+    char url[256];
+    char b64[64];
+    int i, n = 4;
+
+    rnd_state = 23;
+    for (i = 0; i < FRAMES; i++)
+    {
+        make_au(&aus[i], RTP_CODEC_H264, i, i % GOP == 0, 1, i % GOP == 0 ? 40000 : 2000 + rnd() % 4000);
+    }
+    MppFrameTraceGetStat(MPP_FRAMETRACE_STAGE_RTSP, &trace0);
+    RtspStreamGetUrl(stream, url, sizeof(url));
+    CHECK(client_open(&c, RtspServerGetPort(server), RTP_CODEC_H264) == 0, "connect");
+    CHECK(client_request(&c, "DESCRIBE", url, NULL) == 200, "describe");
+    CHECK(!strstr(c.resp, "sprop-parameter-sets"), "sdp without parameter sets");
+    CHECK(RtspStreamSetParameterSets(stream, aus[0].sets, aus[0].sets_len) == 0, "set parameter sets");
+    CHECK(client_request(&c, "DESCRIBE", url, NULL) == 200, "describe");
+    base64(aus[0].sets + 4, 24, b64);
+    CHECK(strstr(c.resp, "packetization-mode=1") && strstr(c.resp, "profile-level-id=42C01F")
+          && strstr(c.resp, b64), "h264 sdp:\n%s", c.resp);
+    CHECK(client_setup(&c, url, 1) == 200, "setup");
+    CHECK(client_play(&c, url) == 200, "play");
+
+    for (i = 0; i < FRAMES; i++)
+    {
+        send_au(stream, &aus[i]);
+        usleep(10000);
+    }
+    usleep(300000);
+    RtspStreamGetStat(stream, &stat, cs, &n);
+    client_stop(&c);
+
+    check_aus("tcp", &c, aus, 0, FRAMES, NULL);
+    CHECK(c.d.first_seq == c.rtp_info_seq, "first seq %u, rtp-info seq %d", c.d.first_seq, c.rtp_info_seq);
+    CHECK(c.d.max_packet <= RTP_HEADER_SIZE + payload, "packet of %u bytes", c.d.max_packet);
+    CHECK(payload == 1400 || c.d.max_packet > RTP_HEADER_SIZE + 1400, "largest packet %u bytes", c.d.max_packet);
+    CHECK(c.sr_count >= 2, "%d sender reports", c.sr_count);
+    CHECK(stat.mFrames == FRAMES && stat.mPacketizedFrames == FRAMES && stat.mDroppedPackets == 0,
+          "stream stat: %llu frames, %llu packetized, %llu dropped", (unsigned long long)stat.mFrames,
+          (unsigned long long)stat.mPacketizedFrames, (unsigned long long)stat.mDroppedPackets);
+    CHECK(n == 1 && stat.mClientNum == 1, "%d clients", n);
+    CHECK(cs[0].mbTcp && cs[0].mbPlaying && cs[0].mPackets == stat.mSentPackets && cs[0].mPackets == stat.mPackets,
+          "client stat: %llu packets of %llu", (unsigned long long)cs[0].mPackets, (unsigned long long)stat.mPackets);
+    CHECK(cs[0].mReceiverReports >= 1 && cs[0].mFractionLost == 5 && cs[0].mCumulativeLost == 7 && cs[0].mJitter == 90,
+          "receiver report: %d, lost %d/256 %d, jitter %u", cs[0].mReceiverReports, cs[0].mFractionLost,
+          cs[0].mCumulativeLost, cs[0].mJitter);
+    CHECK(cs[0].mRttMs >= 0 && cs[0].mRttMs < 100, "rtt %d ms", cs[0].mRttMs);
+    CHECK(stat.mBacklogBytes == 0 && stat.mBacklogCapacity >= 8192 && cs[0].mBacklogCapacity == stat.mBacklogCapacity,
+          "backlog of a drained client %u/%u", stat.mBacklogBytes, stat.mBacklogCapacity);
+    MppFrameTraceGetStat(MPP_FRAMETRACE_STAGE_RTSP, &trace);
+    CHECK(trace.mFrameCnt - trace0.mFrameCnt == FRAMES && trace.mLostCnt == trace0.mLostCnt,
+          "frame trace: %u frames sent, %u lost", trace.mFrameCnt - trace0.mFrameCnt, trace.mLostCnt - trace0.mLostCnt);
+    CHECK(client_request(&c, "TEARDOWN", url, NULL) == 200, "teardown");
+    client_close(&c);
+    for (i = 0; i < FRAMES; i++)
+    {
+        free_au(&aus[i]);
+    }
+}
+
+/* a tcp client which stops reading: the backlog grows, then counts as full once packets are lost */
+static void test_backlog(RTSP_SERVER_S *server)
+{
+    RTSP_STREAM_S *stream = open_stream(server, "slow", RTP_CODEC_H264, 0, 0);
+    RTSP_STREAM_STAT_S stat;
+    AU au;
+    CLIENT c;
+    char url[256];
+    unsigned int seen = 0;
+    int i, rcvbuf = 4096;
+
+    rnd_state = 41;
+    make_au(&au, RTP_CODEC_H264, 0, 1, 1, 40000);
+    RtspStreamGetUrl(stream, url, sizeof(url));
+    CHECK(client_open(&c, RtspServerGetPort(server), RTP_CODEC_H264) == 0, "connect");
+    setsockopt(c.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    CHECK(client_setup(&c, url, 1) == 200, "setup");
+    CHECK(client_request(&c, "PLAY", url, NULL) == 200, "play");
+
+    memset(&stat, 0, sizeof(stat));
+    for (i = 0; i < 2000 && stat.mDroppedPackets == 0; i++)
+    {
+        send_au(stream, &au);
+        RtspStreamGetStat(stream, &stat, NULL, NULL);
+        if (stat.mDroppedPackets == 0 && stat.mBacklogBytes > seen)
+        {
+            seen = stat.mBacklogBytes;
+        }
+    }
+    CHECK(stat.mDroppedPackets > 0, "no packet lost after %d frames", i);
+    CHECK(seen > 0 && seen <= stat.mBacklogCapacity, "backlog before the loss %u/%u", seen, stat.mBacklogCapacity);
+    CHECK(stat.mBacklogCapacity > 0 && stat.mBacklogBytes == stat.mBacklogCapacity,
+          "backlog after the loss %u/%u", stat.mBacklogBytes, stat.mBacklogCapacity);
+    client_close(&c);
+    free_au(&au);
+}
+
+static void test_fanout(RTSP_SERVER_S *server)
+{
+    enum { FRAMES = 60, LATE_JOIN = 37, CLIENTS = 3 };
+    RTSP_STREAM_S *stream = open_stream(server, "fan", RTP_CODEC_H265, 1000, 0);
+    RTSP_STREAM_STAT_S stat;
+    RTSP_CLIENT_STAT_S cs[8];
+    AU aus[FRAMES];
+    CLIENT c[CLIENTS + 1];
+    char url[256];
+    int i, n = 8, tcp_num = 0, full_num = 0;
+    uint64_t sent = 0, packets_at_key = 0;
+
+    rnd_state = 31;
+    for (i = 0; i < FRAMES; i++)
+    {
+        make_au(&aus[i], RTP_CODEC_H265, i, i % GOP == 0, 0, i % GOP == 0 ? 30000 : 1500 + rnd() % 3000);
+    }
+    CHECK(RtspStreamSetParameterSets(stream, aus[0].sets, aus[0].sets_len) == 0, "set parameter sets");
+    RtspStreamGetUrl(stream, url, sizeof(url));
+    for (i = 0; i < CLIENTS; i++)
+    {
+        CHECK(client_open(&c[i], RtspServerGetPort(server), RTP_CODEC_H265) == 0, "connect %d", i);
+        CHECK(client_setup(&c[i], url, i == 2) == 200, "setup %d", i);
+        CHECK(client_play(&c[i], url) == 200, "play %d", i);
+    }
+
+    for (i = 0; i < FRAMES; i++)
+    {
+        if (i == 45)
+        {
+            RtspStreamGetStat(stream, &stat, NULL, NULL);
+            packets_at_key = stat.mPackets;
+        }
+        if (i == LATE_JOIN)
+        {
+            CHECK(client_open(&c[CLIENTS], RtspServerGetPort(server), RTP_CODEC_H265) == 0, "connect late");
+            CHECK(client_setup(&c[CLIENTS], url, 1) == 200, "setup late");
+            CHECK(client_play(&c[CLIENTS], url) == 200, "play late");
+        }
+        send_au(stream, &aus[i]);
+        usleep(5000);
+    }
+    usleep(200000);
+    RtspStreamGetStat(stream, &stat, cs, &n);
+    for (i = 0; i <= CLIENTS; i++)
+    {
+        client_stop(&c[i]);
+    }
+
+    check_aus("udp 0", &c[0], aus, 0, FRAMES, &aus[0]);
+    check_aus("udp 1", &c[1], aus, 0, FRAMES, &aus[0]);
+    check_aus("tcp", &c[2], aus, 0, FRAMES, &aus[0]);
+    /* the late client waits for the key frame */
+    check_aus("late tcp", &c[3], aus, 45, FRAMES - 45, &aus[0]);
+    CHECK(c[0].d.max_packet <= RTP_HEADER_SIZE + 1000, "packet of %u bytes", c[0].d.max_packet);
+
+    CHECK(stat.mFrames == FRAMES && stat.mPacketizedFrames == FRAMES, "%llu frames, %llu packetized",
+          (unsigned long long)stat.mFrames, (unsigned long long)stat.mPacketizedFrames);
+    CHECK(stat.mDroppedPackets == 0, "%llu dropped", (unsigned long long)stat.mDroppedPackets);
+    CHECK(n == CLIENTS + 1 && stat.mClientNum == CLIENTS + 1, "%d clients, %d playing", n, stat.mClientNum);
+    for (i = 0; i < n; i++)
+    {
+        sent += cs[i].mPackets;
+        full_num += cs[i].mPackets == stat.mPackets;
+        tcp_num += cs[i].mbTcp;
+        CHECK(strcmp(cs[i].mAddr, "127.0.0.1") == 0, "client address %s", cs[i].mAddr);
+        CHECK(cs[i].mReceiverReports >= 1, "client %d: no receiver report", i);
+    }
+    CHECK(tcp_num == 2, "%d tcp clients", tcp_num);
+    CHECK(full_num == CLIENTS && sent == stat.mSentPackets, "%d clients got the %llu packets made, %llu sent of %llu",
+          full_num, (unsigned long long)stat.mPackets, (unsigned long long)sent, (unsigned long long)stat.mSentPackets);
+    /* from the key frame after it joined */
+    CHECK(c[3].d.first_seq == (uint16_t)(c[0].d.first_seq + packets_at_key), "first packet of the late client");
+
+    for (i = 0; i <= CLIENTS; i++)
+    {
+        client_close(&c[i]);
+    }
+    for (i = 0; i < FRAMES; i++)
+    {
+        free_au(&aus[i]);
+    }
+}
+
+/* highest rate over 5ms windows of the arrivals, bps */
+static double peak_rate(const DEPACK *d)
+{
+    double peak = 0;
+    int i, j = 0;
+    int64_t bytes = 0;
+
+    for (i = 0; i < d->arrivals; i++)
+    {
+        bytes += d->arrival_bytes[i];
+        while (d->arrival_us[i] - d->arrival_us[j] >= 5000)
+        {
+            bytes -= d->arrival_bytes[j++];
+        }
+        if (bytes * 8 / 0.005 > peak)
+        {
+            peak = bytes * 8 / 0.005;
+        }
+    }
+    return peak;
+}
+
+/* a 120KB key frame and some small ones to one tcp client, @return the spread of the key frame */
+static int64_t run_paced(RTSP_SERVER_S *server, const char *name, int bitrate, double *peak, int64_t *wait_us)
+{
+    enum { FRAMES = 10 };
+    RTSP_STREAM_S *stream = open_stream(server, name, RTP_CODEC_H264, 0, bitrate);
+    RTSP_STREAM_STAT_S stat;
+    AU aus[FRAMES];
+    CLIENT c;
+    char url[256];
+    int64_t spread;
+    int i;
+
+    rnd_state = 41;
+    for (i = 0; i < FRAMES; i++)
+    {
+        make_au(&aus[i], RTP_CODEC_H264, i, i == 0, 1, i == 0 ? 120000 : 3000);
+    }
+    RtspStreamGetUrl(stream, url, sizeof(url));
+    CHECK(client_open(&c, RtspServerGetPort(server), RTP_CODEC_H264) == 0, "connect");
+    CHECK(client_setup(&c, url, 1) == 200, "setup");
+    CHECK(client_play(&c, url) == 200, "play");
+    for (i = 0; i < FRAMES; i++)
+    {
+        send_au(stream, &aus[i]);
+        usleep(FRAME_US);
+    }
+    usleep(100000);
+    client_stop(&c);
+    RtspStreamGetStat(stream, &stat, NULL, NULL);
+    check_aus(name, &c, aus, 0, FRAMES, NULL);
+    spread = c.d.au_num > 0 ? c.d.au_spread_us[0] : 0;
+    *peak = peak_rate(&c.d);
+    *wait_us = stat.mPaceWaitUs;
+    client_close(&c);
+    for (i = 0; i < FRAMES; i++)
+    {
+        free_au(&aus[i]);
+    }
+    return spread;
+}
+
+static void test_pacing(RTSP_SERVER_S *server, int verbose)
+{
+    double peak_paced, peak_unpaced;
+    int64_t wait_paced, wait_unpaced;
+    int64_t spread_paced = run_paced(server, "paced", 4000000, &peak_paced, &wait_paced);
+    int64_t spread_unpaced = run_paced(server, "unpaced", 0, &peak_unpaced, &wait_unpaced);
+
+    /* (120000 - 16384) bytes at 4Mbps */
+    CHECK(spread_paced >= 190000 && wait_paced >= 150000, "paced key frame spread over %lld us, waited %lld us",
+          (long long)spread_paced, (long long)wait_paced);
+    CHECK(spread_unpaced < spread_paced / 4 && wait_unpaced == 0, "unpaced key frame spread over %lld us",
+          (long long)spread_unpaced);
+    if (verbose)
+    {
+        printf("\n120KB key frame to one tcp client on loopback\n");
+        printf("unpaced:     spread %6.1f ms, peak %7.1f Mbps over 5ms\n", spread_unpaced / 1000.0, peak_unpaced / 1e6);
+        printf("paced 4Mbps: spread %6.1f ms, peak %7.1f Mbps over 5ms\n", spread_paced / 1000.0, peak_paced / 1e6);
+    }
+}
+
+static void bench_packetize(void)
+{
+    RTP_PACKETIZER_S pz;
+    RTP_NAL_S nals[16];
+    RTP_FRAME_BUF_S buf;
+    AU au;
+    int64_t t0, t;
+    int i, num, packets = 0;
+    const int loops = 2000;
+
+    rnd_state = 3;
+    make_au(&au, RTP_CODEC_H264, 0, 1, 1, 120000);
+    split_frame(&au, au.raw_len / 3, &buf);
+    RtpPacketizerInit(&pz, RTP_CODEC_H264, 1400, 1, 0);
+    t0 = CDX_GetSysTimeUsMonotonic();
+    for (i = 0; i < loops; i++)
+    {
+        num = RtpFindNalUnits(&buf, nals, 16);
+        packets += RtpPacketizeNals(&pz, &buf, nals, num, i, 1);
+    }
+    t = CDX_GetSysTimeUsMonotonic() - t0;
+    printf("\n120KB frame: scan + packetize %.1f us, %d packets, %.1f ns a packet\n",
+           (double)t / loops, packets / loops, t * 1000.0 / packets);
+    RtpPacketizerDeinit(&pz);
+    free_frame(&buf);
+    free_au(&au);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+    RTSP_SERVER_S *server;
+    char url[256];
+
+    test_packetizer();
+    test_pacer();
+    MppFrameTraceSetEnable(TRUE);
+    server = open_server();
+    CHECK(server != NULL, "create server");
+    if (server)
+    {
+        test_dialog(server, url);
+        test_tcp(server, "live/main", 0);
+        test_tcp(server, "live/big", 100000);
+        test_backlog(server);
+        test_fanout(server);
+        test_pacing(server, !quiet);
+        RtspServerDestroy(server);
+    }
+    printf("rtsp_server_test: %s\n", failures ? "FAILED" : "ok");
+    if (failures)
+    {
+        return 1;
+    }
+    if (!quiet)
+    {
+        bench_packetize();
+    }
+    return 0;
+}
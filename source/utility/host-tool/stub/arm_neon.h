@@ -0,0 +1,94 @@
+/*
+ * The NEON intrinsics used by the alsa-lib pcm_conv.c, pcm_dmix_generic.c
+ * and pcm_rate_polyphase.c, in plain C lane by lane, so that their
+ * __ARM_NEON paths can be checked on the build host. Only the results are
+ * modelled, not the speed.
+ */
+#ifndef HOST_TOOL_ARM_NEON_H
+#define HOST_TOOL_ARM_NEON_H
+
+#include <stdint.h>
+
+typedef struct { int16_t v[8]; } int16x8_t;
+typedef struct { int16_t v[4]; } int16x4_t;
+typedef struct { uint16_t v[8]; } uint16x8_t;
+typedef struct { uint16_t v[4]; } uint16x4_t;
+typedef struct { int32_t v[4]; } int32x4_t;
+typedef struct { int32_t v[2]; } int32x2_t;
+typedef struct { uint32_t v[4]; } uint32x4_t;
+typedef struct { int64_t v[2]; } int64x2_t;
+
+#define LANES(r, n, expr)	do { int i_; for (i_ = 0; i_ < (n); i_++) r.v[i_] = (expr); } while (0)
+
+static inline int16x8_t vld1q_s16(const int16_t *p) { int16x8_t r; LANES(r, 8, p[i_]); return r; }
+static inline int32x4_t vld1q_s32(const int32_t *p) { int32x4_t r; LANES(r, 4, p[i_]); return r; }
+static inline uint32x4_t vld1q_u32(const uint32_t *p) { uint32x4_t r; LANES(r, 4, p[i_]); return r; }
+static inline void vst1q_s16(int16_t *p, int16x8_t a) { int i; for (i = 0; i < 8; i++) p[i] = a.v[i]; }
+static inline void vst1q_s32(int32_t *p, int32x4_t a) { int i; for (i = 0; i < 4; i++) p[i] = a.v[i]; }
+static inline void vst1q_u32(uint32_t *p, uint32x4_t a) { int i; for (i = 0; i < 4; i++) p[i] = a.v[i]; }
+
+static inline int16x8_t vdupq_n_s16(int16_t x) { int16x8_t r; LANES(r, 8, x); return r; }
+static inline int32x4_t vdupq_n_s32(int32_t x) { int32x4_t r; LANES(r, 4, x); return r; }
+static inline uint32x4_t vdupq_n_u32(uint32_t x) { uint32x4_t r; LANES(r, 4, x); return r; }
+
+static inline uint16x8_t vceqq_s16(int16x8_t a, int16x8_t b) { uint16x8_t r; LANES(r, 8, a.v[i_] == b.v[i_] ? 0xffff : 0); return r; }
+static inline uint32x4_t vceqq_s32(int32x4_t a, int32x4_t b) { uint32x4_t r; LANES(r, 4, a.v[i_] == b.v[i_] ? 0xffffffff : 0); return r; }
+static inline uint32x4_t vtstq_u32(uint32x4_t a, uint32x4_t b) { uint32x4_t r; LANES(r, 4, (a.v[i_] & b.v[i_]) ? 0xffffffff : 0); return r; }
+
+static inline int16x4_t vget_low_s16(int16x8_t a) { int16x4_t r; LANES(r, 4, a.v[i_]); return r; }
+static inline int16x4_t vget_high_s16(int16x8_t a) { int16x4_t r; LANES(r, 4, a.v[i_ + 4]); return r; }
+static inline uint16x4_t vget_low_u16(uint16x8_t a) { uint16x4_t r; LANES(r, 4, a.v[i_]); return r; }
+static inline uint16x4_t vget_high_u16(uint16x8_t a) { uint16x4_t r; LANES(r, 4, a.v[i_ + 4]); return r; }
+static inline int32x2_t vget_low_s32(int32x4_t a) { int32x2_t r; LANES(r, 2, a.v[i_]); return r; }
+static inline int32x2_t vget_high_s32(int32x4_t a) { int32x2_t r; LANES(r, 2, a.v[i_ + 2]); return r; }
+static inline int16x8_t vcombine_s16(int16x4_t a, int16x4_t b) { int16x8_t r; LANES(r, 8, i_ < 4 ? a.v[i_] : b.v[i_ - 4]); return r; }
+static inline int32x4_t vcombine_s32(int32x2_t a, int32x2_t b) { int32x4_t r; LANES(r, 4, i_ < 2 ? a.v[i_] : b.v[i_ - 2]); return r; }
+#define vget_lane_s32(a, n)	((a).v[(n)])
+
+static inline int16x4_t vreinterpret_s16_u16(uint16x4_t a) { int16x4_t r; LANES(r, 4, (int16_t)a.v[i_]); return r; }
+static inline int32x4_t vreinterpretq_s32_u32(uint32x4_t a) { int32x4_t r; LANES(r, 4, (int32_t)a.v[i_]); return r; }
+static inline uint32x4_t vreinterpretq_u32_s32(int32x4_t a) { uint32x4_t r; LANES(r, 4, (uint32_t)a.v[i_]); return r; }
+
+static inline int32x4_t vmovl_s16(int16x4_t a) { int32x4_t r; LANES(r, 4, a.v[i_]); return r; }
+static inline int16x4_t vqmovn_s32(int32x4_t a)
+{
+	int16x4_t r;
+
+	LANES(r, 4, a.v[i_] > 0x7fff ? 0x7fff : a.v[i_] < -0x8000 ? -0x8000 : a.v[i_]);
+	return r;
+}
+
+/* wrapping like the hardware, through unsigned arithmetic */
+static inline int32x4_t vaddq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r, 4, (int32_t)((uint32_t)a.v[i_] + (uint32_t)b.v[i_])); return r; }
+static inline int32x2_t vadd_s32(int32x2_t a, int32x2_t b) { int32x2_t r; LANES(r, 2, (int32_t)((uint32_t)a.v[i_] + (uint32_t)b.v[i_])); return r; }
+static inline int32x2_t vpadd_s32(int32x2_t a, int32x2_t b)
+{ int32x2_t r; r.v[0] = (int32_t)((uint32_t)a.v[0] + (uint32_t)a.v[1]); r.v[1] = (int32_t)((uint32_t)b.v[0] + (uint32_t)b.v[1]); return r; }
+static inline int32x4_t vsubq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r, 4, (int32_t)((uint32_t)a.v[i_] - (uint32_t)b.v[i_])); return r; }
+static inline int32x4_t vmulq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r, 4, (int32_t)((uint32_t)a.v[i_] * (uint32_t)b.v[i_])); return r; }
+static inline int64x2_t vmull_s32(int32x2_t a, int32x2_t b) { int64x2_t r; LANES(r, 2, (int64_t)a.v[i_] * b.v[i_]); return r; }
+static inline int32x4_t vmlal_s16(int32x4_t a, int16x4_t b, int16x4_t c)
+{ int32x4_t r; LANES(r, 4, (int32_t)((uint32_t)a.v[i_] + (uint32_t)(b.v[i_] * c.v[i_]))); return r; }
+static inline int16x8_t vnegq_s16(int16x8_t a) { int16x8_t r; LANES(r, 8, (int16_t)(0u - (uint16_t)a.v[i_])); return r; }
+static inline int32x4_t vnegq_s32(int32x4_t a) { int32x4_t r; LANES(r, 4, (int32_t)(0u - (uint32_t)a.v[i_])); return r; }
+static inline int32x4_t vandq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r, 4, a.v[i_] & b.v[i_]); return r; }
+static inline int32x4_t vbicq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r, 4, a.v[i_] & ~b.v[i_]); return r; }
+static inline int32x4_t vminq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r, 4, a.v[i_] < b.v[i_] ? a.v[i_] : b.v[i_]); return r; }
+static inline int32x4_t vmaxq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r, 4, a.v[i_] > b.v[i_] ? a.v[i_] : b.v[i_]); return r; }
+
+#define vshrq_n_s32(a, n)	({ int32x4_t r_; LANES(r_, 4, (a).v[i_] >> (n)); r_; })
+#define vshlq_n_s32(a, n)	({ int32x4_t r_; LANES(r_, 4, (int32_t)((uint32_t)(a).v[i_] << (n))); r_; })
+#define vqshlq_n_s32(a, n)	({ int32x4_t r_; LANES(r_, 4,					\
+				   (a).v[i_] > (INT32_MAX >> (n)) ? INT32_MAX :			\
+				   (a).v[i_] < (INT32_MIN >> (n)) ? INT32_MIN :			\
+				   (int32_t)((uint32_t)(a).v[i_] << (n))); r_; })
+#define vshrn_n_s32(a, n)	({ int16x4_t r_; LANES(r_, 4, (int16_t)((a).v[i_] >> (n))); r_; })
+#define vqshrn_n_s64(a, n)	({ int32x2_t r_; LANES(r_, 2,					\
+				   ((a).v[i_] >> (n)) > INT32_MAX ? INT32_MAX :			\
+				   ((a).v[i_] >> (n)) < INT32_MIN ? INT32_MIN :			\
+				   (int32_t)((a).v[i_] >> (n))); r_; })
+
+static inline int16x8_t vbslq_s16(uint16x8_t m, int16x8_t a, int16x8_t b) { int16x8_t r; LANES(r, 8, (int16_t)((m.v[i_] & (uint16_t)a.v[i_]) | (~m.v[i_] & (uint16_t)b.v[i_]))); return r; }
+static inline int32x4_t vbslq_s32(uint32x4_t m, int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r, 4, (int32_t)((m.v[i_] & (uint32_t)a.v[i_]) | (~m.v[i_] & (uint32_t)b.v[i_]))); return r; }
+static inline uint32x4_t vbslq_u32(uint32x4_t m, uint32x4_t a, uint32x4_t b) { uint32x4_t r; LANES(r, 4, (m.v[i_] & a.v[i_]) | (~m.v[i_] & b.v[i_])); return r; }
+
+#endif
@@ -0,0 +1,2 @@
+/* host stub: melis pthread clock helpers, the host has them in <time.h> */
+#include <time.h>
@@ -0,0 +1,17 @@
+/* host stub: the tests are single threaded */
+#ifndef SUNXI_HAL_ATOMIC_H
+#define SUNXI_HAL_ATOMIC_H
+
+#include <stdint.h>
+
+static inline uint32_t hal_spin_lock_irqsave(void)
+{
+    return 0;
+}
+
+static inline void hal_spin_unlock_irqrestore(uint32_t __cpsr)
+{
+    (void)__cpsr;
+}
+
+#endif
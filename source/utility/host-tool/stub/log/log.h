@@ -0,0 +1,18 @@
+/* host stub: the glog calls of plat_log.h, errors go to stderr */
+#ifndef __HOST_LOG_H__
+#define __HOST_LOG_H__
+
+#include <stdio.h>
+
+#define _GLOG_INFO      0
+#define _GLOG_WARN      1
+#define _GLOG_ERROR     2
+#define _GLOG_FATAL     3
+
+#define GLOG_PRINT(level, fmt, arg...)                              \
+    do {                                                            \
+        if ((level) >= _GLOG_ERROR)                                 \
+            fprintf(stderr, LOG_TAG ": " fmt "\n", ##arg);          \
+    } while (0)
+
+#endif
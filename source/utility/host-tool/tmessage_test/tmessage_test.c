@@ -0,0 +1,369 @@
+/*
+ * Host test and benchmark for the message queue of eyesee-mpp
+ * media/utils/tmessage.c, built with a small MESSAGE_RING_DEPTH so the
+ * spill list under the mutex is used often.
+ *
+ *   tmessage_test           run the checks and the throughput benchmark
+ *   tmessage_test -q        checks only
+ *
+ * Checks FIFO order and the count on one thread, puts on a full ring,
+ * copied and by-reference payloads, flush, the timed wait, and that
+ * several writers and one sleeping reader lose nothing and keep the order
+ * of each writer.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <tmessage.h>
+
+#define WRITERS     4
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static long long now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void test_fifo(void)
+{
+    message_queue_t q;
+    message_t msg;
+    int i, bad = 0;
+
+    CHECK(message_create(&q) == 0, "message_create");
+    CHECK(get_message(&q, &msg) == -1, "get on an empty queue");
+
+    /* several times around the ring, and then past its end */
+    for (i = 0; i < 10 * MESSAGE_RING_DEPTH; i++)
+    {
+        memset(&msg, 0, sizeof(msg));
+        msg.command = i;
+        msg.para0 = i * 2;
+        msg.para1 = -i;
+        put_message(&q, &msg);
+        if (get_message(&q, &msg) != 0 || msg.command != i || msg.para0 != i * 2 || msg.para1 != -i)
+        {
+            bad++;
+        }
+    }
+    CHECK(bad == 0, "%d messages wrong going round the ring", bad);
+
+    for (i = 0; i < 5 * MESSAGE_RING_DEPTH + 3; i++)
+    {
+        memset(&msg, 0, sizeof(msg));
+        msg.command = i;
+        CHECK(put_message(&q, &msg) == 0, "put %d on a full ring", i);
+    }
+    CHECK(get_message_count(&q) == 5 * MESSAGE_RING_DEPTH + 3, "count %d", get_message_count(&q));
+    CHECK(q.mSpillCount == 4 * MESSAGE_RING_DEPTH + 3, "spilled %d", q.mSpillCount);
+
+    /* a put while the list drains must still come last */
+    for (i = 0; i < 5 * MESSAGE_RING_DEPTH + 3; i++)
+    {
+        if (i == MESSAGE_RING_DEPTH + 1)
+        {
+            msg.command = 9999;
+            put_message(&q, &msg);
+        }
+        if (get_message(&q, &msg) != 0 || msg.command != i)
+        {
+            bad++;
+        }
+    }
+    CHECK(bad == 0, "%d messages out of order after a full ring", bad);
+    CHECK(get_message(&q, &msg) == 0 && msg.command == 9999, "message put while draining");
+    CHECK(get_message_count(&q) == 0 && q.mSpillCount == 0, "count %d after draining", get_message_count(&q));
+
+    message_destroy(&q);
+}
+
+static void test_data(void)
+{
+    message_queue_t q;
+    message_t msg;
+    char text[] = "copied payload";
+    char *ref;
+    int i;
+
+    message_create(&q);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.command = 1;
+    msg.mpData = text;
+    msg.mDataSize = sizeof(text);
+    CHECK(putMessageWithData(&q, &msg) == 0, "putMessageWithData");
+    text[0] = 'X';
+
+    ref = malloc(4096);
+    memset(ref, 0x5a, 4096);
+    msg.command = 2;
+    msg.mpData = ref;
+    msg.mDataSize = 4096;
+    CHECK(putMessageWithDataRef(&q, &msg) == 0, "putMessageWithDataRef");
+
+    CHECK(get_message(&q, &msg) == 0 && msg.command == 1, "copied message");
+    CHECK(msg.mpData != text && msg.mDataSize == sizeof(text) && !strcmp(msg.mpData, "copied payload"),
+          "payload was not copied");
+    free(msg.mpData);
+
+    CHECK(get_message(&q, &msg) == 0 && msg.command == 2, "by-reference message");
+    CHECK(msg.mpData == ref && msg.mDataSize == 4096, "payload was not passed by reference");
+    free(msg.mpData);
+
+    /* flush and destroy free what the reader never took, run it under ASan */
+    for (i = 0; i < 3 * MESSAGE_RING_DEPTH; i++)
+    {
+        msg.command = i;
+        msg.mpData = malloc(64);
+        msg.mDataSize = 64;
+        putMessageWithDataRef(&q, &msg);
+    }
+    flush_message(&q);
+    CHECK(get_message_count(&q) == 0, "count %d after flush", get_message_count(&q));
+    for (i = 0; i < 3 * MESSAGE_RING_DEPTH; i++)
+    {
+        msg.mpData = text;
+        msg.mDataSize = sizeof(text);
+        putMessageWithData(&q, &msg);
+    }
+    message_destroy(&q);
+}
+
+static void *late_put_main(void *arg)
+{
+    message_t msg;
+
+    usleep(20000);
+    memset(&msg, 0, sizeof(msg));
+    msg.command = 7;
+    put_message(arg, &msg);
+    return NULL;
+}
+
+static void test_wait(void)
+{
+    message_queue_t q;
+    message_t msg;
+    pthread_t tid;
+    long long t;
+
+    message_create(&q);
+
+    t = now_us();
+    CHECK(TMessage_WaitQueueNotEmpty(&q, 50) == 0, "wait on an empty queue");
+    t = now_us() - t;
+    CHECK(t >= 45000 && t < 1000000, "timed wait took %lld us", t);
+
+    memset(&msg, 0, sizeof(msg));
+    put_message(&q, &msg);
+    put_message(&q, &msg);
+    t = now_us();
+    CHECK(TMessage_WaitQueueNotEmpty(&q, 1000) == 2, "wait with two messages");
+    CHECK(TMessage_WaitQueueNotEmpty(&q, 0) == 2, "untimed wait with two messages");
+    CHECK(now_us() - t < 10000, "wait with messages slept");
+    flush_message(&q);
+
+    /* a sleeping reader is woken by the put of another thread */
+    pthread_create(&tid, NULL, late_put_main, &q);
+    t = now_us();
+    CHECK(TMessage_WaitQueueNotEmpty(&q, 0) == 1, "wait for another thread");
+    t = now_us() - t;
+    CHECK(t >= 15000 && t < 1000000, "woken after %lld us", t);
+    CHECK(get_message(&q, &msg) == 0 && msg.command == 7, "message of the other thread");
+    pthread_join(tid, NULL);
+    CHECK(q.mWaitMessageFlag == 0, "waiters %d", q.mWaitMessageFlag);
+
+    message_destroy(&q);
+}
+
+struct writer
+{
+    pthread_t tid;
+    message_queue_t *q;
+    int id;
+    int count;
+    int paced;
+};
+
+static void *writer_main(void *arg)
+{
+    struct writer *w = arg;
+    message_t msg;
+    int i, *p;
+
+    memset(&msg, 0, sizeof(msg));
+    for (i = 0; i < w->count; i++)
+    {
+        msg.command = w->id;
+        msg.para0 = i;
+        msg.para1 = i ^ 0x5555;
+        if (i % 8 == 3)
+        {
+            p = malloc(sizeof(int));
+            *p = i;
+            msg.mpData = p;
+            msg.mDataSize = sizeof(int);
+            while (putMessageWithDataRef(w->q, &msg) != 0)
+                ;
+        }
+        else
+        {
+            msg.mpData = NULL;
+            msg.mDataSize = 0;
+            while (put_message(w->q, &msg) != 0)
+                ;
+        }
+        if (i % 1024 == 0)
+        {
+            usleep(100);
+        }
+        /* commands come a few at a time, not as a flood */
+        while (w->paced && get_message_count(w->q) >= MESSAGE_RING_DEPTH / 2)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/*
+ * WRITERS threads put count messages each, the caller reads them as a mpp
+ * component thread does. Paced writers keep the queue short, else the ring
+ * overflows all the time.
+ */
+static long long run_writers(int count, int check, int paced)
+{
+    message_queue_t q;
+    struct writer w[WRITERS];
+    message_t msg;
+    int next[WRITERS] = { 0 };
+    int total = 0, bad = 0;
+    long long t;
+    int i;
+
+    message_create(&q);
+    t = now_us();
+    for (i = 0; i < WRITERS; i++)
+    {
+        w[i].q = &q;
+        w[i].id = i;
+        w[i].count = count;
+        w[i].paced = paced;
+        pthread_create(&w[i].tid, NULL, writer_main, &w[i]);
+    }
+    while (total < WRITERS * count)
+    {
+        if (get_message(&q, &msg) != 0)
+        {
+            if (TMessage_WaitQueueNotEmpty(&q, 0) == 0)
+            {
+                bad++;
+            }
+            continue;
+        }
+        total++;
+        if (msg.command < 0 || msg.command >= WRITERS || msg.para0 != next[msg.command]
+            || msg.para1 != (msg.para0 ^ 0x5555))
+        {
+            if (bad++ < 5)
+            {
+                printf("writer %d message %d, expected %d\n", msg.command, msg.para0,
+                       msg.command >= 0 && msg.command < WRITERS ? next[msg.command] : -1);
+            }
+        }
+        else
+        {
+            next[msg.command]++;
+        }
+        if (msg.mpData)
+        {
+            if (*(int *)msg.mpData != msg.para0 || msg.mDataSize != sizeof(int))
+            {
+                bad++;
+            }
+            free(msg.mpData);
+        }
+        else if (msg.para0 % 8 == 3)
+        {
+            bad++;
+        }
+        /* fall behind now and then so the ring fills up */
+        if (check && total % 5000 == 0)
+        {
+            usleep(2000);
+        }
+    }
+    t = now_us() - t;
+    for (i = 0; i < WRITERS; i++)
+    {
+        pthread_join(w[i].tid, NULL);
+    }
+    if (check)
+    {
+        CHECK(bad == 0, "%d messages lost, wrong or out of order", bad);
+        CHECK(get_message(&q, &msg) == -1 && get_message_count(&q) == 0, "messages left over");
+        CHECK(q.mWaitMessageFlag == 0, "waiters %d", q.mWaitMessageFlag);
+    }
+    message_destroy(&q);
+    return t;
+}
+
+static void bench(void)
+{
+    message_queue_t q;
+    message_t msg;
+    long long t;
+    int i, n = 1000000;
+
+    message_create(&q);
+    memset(&msg, 0, sizeof(msg));
+    t = now_us();
+    for (i = 0; i < n; i++)
+    {
+        put_message(&q, &msg);
+        get_message(&q, &msg);
+    }
+    t = now_us() - t;
+    message_destroy(&q);
+    printf("put and get on one thread: %lld ns/message\n", t * 1000 / n);
+
+    t = run_writers(n, 0, 0);
+    printf("%d flooding writers, one reader: %lld ns/message, %.1f M messages/s, ring of %d\n",
+           WRITERS, t * 1000 / ((long long)WRITERS * n), (double)WRITERS * n / t, MESSAGE_RING_DEPTH);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    test_fifo();
+    test_data();
+    test_wait();
+    run_writers(quiet ? 50000 : 200000, 1, 0);
+    run_writers(quiet ? 20000 : 100000, 1, 1);
+    if (!quiet)
+    {
+        bench();
+    }
+
+    printf("tmessage_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,414 @@
+/*
+ * Host test and benchmark for the seek index of the ts parser,
+ * libcedarx/libcore/parser/ts/CdxTsSeekIndex.c.
+ *
+ *   ts_seek_index_test      run the checks and the seek/open benchmark
+ *   ts_seek_index_test -q   checks only
+ *
+ * The checks cover ordering, spacing and decimation of the entries, the
+ * position estimate, sidecar paths and the sidecar round trip. The
+ * benchmark models a variable bitrate ts file by the positions of its
+ * pes, and runs the search of SeekToTime on it with and without the
+ * index, counting the 12K probe reads per seek. Time to first frame on
+ * SD is modelled from the bytes read at open plus at the first seek.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <CdxTsSeekIndex.h>
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static unsigned int rnd_state = 1;
+
+static unsigned int rnd(unsigned int n)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state % n;
+}
+
+static void test_add(void)
+{
+    TsSeekIndex index;
+    int i, ok;
+
+    TsSeekIndexInit(&index);
+    CHECK(TsSeekIndexEstimatePos(&index, 1000, 1000) == -1, "empty index");
+
+    CHECK(TsSeekIndexAdd(&index, 90000 * 10, 10000) == 1, "add");
+    CHECK(TsSeekIndexAdd(&index, 90000 * 2, 2000) == 1, "add before");
+    CHECK(TsSeekIndexAdd(&index, 90000 * 6, 6000) == 1, "add between");
+    CHECK(index.num == 3 && index.entries[0].pts == 90000 * 2 && index.entries[2].pos == 10000, "sorted");
+    CHECK(TsSeekIndexAdd(&index, 90000 * 6 + 100, 6100) == 0, "too near");
+    CHECK(TsSeekIndexAdd(&index, 90000 * 8, 5000) == -1, "pos out of order");
+    CHECK(TsSeekIndexAdd(&index, 90000 * 4, 6000) == -1, "same pos");
+    CHECK(TsSeekIndexAdd(&index, -1, 0) == -1, "no pts");
+    CHECK(index.num == 3 && index.dirty, "nothing else added");
+
+    /* full: decimated, the first and the last entries kept */
+    TsSeekIndexClear(&index);
+    ok = 1;
+    for (i = 0; i < TS_SEEK_INDEX_MAX_NUM + 10; i++)
+    {
+        ok &= TsSeekIndexAdd(&index, (long long)i * 90000, (long long)i * 100000) == 1;
+    }
+    CHECK(ok, "all added");
+    CHECK(index.num <= TS_SEEK_INDEX_MAX_NUM && index.num > TS_SEEK_INDEX_MAX_NUM / 2, "decimated to %d", index.num);
+    CHECK(index.entries[0].pts == 0, "first kept");
+    CHECK(index.entries[index.num - 1].pts == (long long)(TS_SEEK_INDEX_MAX_NUM + 9) * 90000, "last kept");
+    ok = 1;
+    for (i = 1; i < index.num; i++)
+    {
+        ok &= index.entries[i].pts > index.entries[i - 1].pts && index.entries[i].pos > index.entries[i - 1].pos;
+    }
+    CHECK(ok, "still sorted");
+    TsSeekIndexDestroy(&index);
+}
+
+static void test_estimate(void)
+{
+    TsSeekIndex index;
+
+    TsSeekIndexInit(&index);
+    TsSeekIndexAdd(&index, 90000 * 10, 1000000);
+    TsSeekIndexAdd(&index, 90000 * 20, 3000000);
+
+    CHECK(TsSeekIndexEstimatePos(&index, 90000 * 15, 50000) == 2000000, "interpolated");
+    CHECK(TsSeekIndexEstimatePos(&index, 90000 * 20, 50000) == 3000000, "on an entry");
+    CHECK(TsSeekIndexEstimatePos(&index, 90000 * 22, 50000) == 3100000, "after the last");
+    CHECK(TsSeekIndexEstimatePos(&index, 90000 * 8, 50000) == 900000, "before the first");
+    CHECK(TsSeekIndexEstimatePos(&index, 0, 500000) == 0, "not before the file");
+    TsSeekIndexDestroy(&index);
+}
+
+static void test_path(void)
+{
+    char path[300], tmp[] = "/tmp/ts_seek_index_XXXXXX", uri[64];
+    int fd;
+
+    CHECK(TsSeekIndexSidecarPath("/mnt/SDCARD/a.ts", path, sizeof(path)) == 0
+        && !strcmp(path, "/mnt/SDCARD/a.ts" TS_SEEK_INDEX_SUFFIX), "path");
+    CHECK(TsSeekIndexSidecarPath("file:///mnt/b.ts", path, sizeof(path)) == 0
+        && !strcmp(path, "/mnt/b.ts" TS_SEEK_INDEX_SUFFIX), "file uri");
+    CHECK(TsSeekIndexSidecarPath("http://host/c.ts", path, sizeof(path)) < 0, "no sidecar of http");
+    CHECK(TsSeekIndexSidecarPath("/mnt/a.ts", path, 10) < 0, "too short");
+    CHECK(TsSeekIndexSidecarPath(NULL, path, sizeof(path)) < 0, "no uri");
+
+    fd = mkstemp(tmp);
+    sprintf(uri, "fd://%d?offset=0&length=100", fd);
+    CHECK(TsSeekIndexSidecarPath(uri, path, sizeof(path)) == 0
+        && !strncmp(path, tmp, strlen(tmp)) && strstr(path, TS_SEEK_INDEX_SUFFIX), "fd uri: %s", path);
+    sprintf(uri, "fd://%d?offset=4096&length=100", fd);
+    CHECK(TsSeekIndexSidecarPath(uri, path, sizeof(path)) < 0, "no sidecar of a part of a file");
+    close(fd);
+    unlink(tmp);
+}
+
+static void test_sidecar(void)
+{
+    const char *path = "/tmp/ts_seek_index_test" TS_SEEK_INDEX_SUFFIX;
+    TsSeekIndex index, loaded;
+    TsSeekIndexInfo info, info2;
+    FILE *fp;
+    int i;
+
+    TsSeekIndexInit(&index);
+    TsSeekIndexInit(&loaded);
+    for (i = 0; i < 100; i++)
+    {
+        TsSeekIndexAdd(&index, 90000LL * i, 200000LL * i + rnd(1000));
+    }
+    memset(&info, 0, sizeof(info));
+    info.fileSize = 20000000;
+    info.fileValidSize = 19999000;
+    info.rawPacketSize = 188;
+    info.firstPts = 12345;
+    info.byteRate = 200000;
+    info.durationMs = 100000;
+
+    CHECK(TsSeekIndexSave(&index, &info, path) == 0 && !index.dirty, "saved");
+    CHECK(access("/tmp/ts_seek_index_test" TS_SEEK_INDEX_SUFFIX ".tmp", F_OK) != 0, "no temporary left");
+    TsSeekIndexAdd(&loaded, 1, 1);
+    CHECK(TsSeekIndexLoad(&loaded, &info2, path) == 0, "loaded");
+    CHECK(!memcmp(&info, &info2, sizeof(info)), "info");
+    CHECK(loaded.num == index.num && !loaded.dirty
+        && !memcmp(loaded.entries, index.entries, index.num * sizeof(TsSeekIndexEntry)), "entries");
+    CHECK(TsSeekIndexAdd(&loaded, 90000LL * 200, 200000LL * 200) == 1 && loaded.dirty, "loaded index grows");
+
+    /* truncated and unsorted sidecars are refused, the index is kept */
+    fp = fopen(path, "r+b");
+    fseek(fp, -(long)sizeof(TsSeekIndexEntry) * 50, SEEK_END);
+    fwrite(&index.entries[0], sizeof(TsSeekIndexEntry), 1, fp);
+    fclose(fp);
+    CHECK(TsSeekIndexLoad(&loaded, &info2, path) < 0 && loaded.num == 101, "unsorted sidecar");
+    truncate(path, 100);
+    CHECK(TsSeekIndexLoad(&loaded, &info2, path) < 0, "truncated sidecar");
+    unlink(path);
+    CHECK(TsSeekIndexLoad(&loaded, &info2, path) < 0, "no sidecar");
+    CHECK(TsSeekIndexSave(&index, &info, "/nonexistent/dir/a.ts" TS_SEEK_INDEX_SUFFIX) < 0, "unwritable");
+
+    TsSeekIndexDestroy(&index);
+    TsSeekIndexDestroy(&loaded);
+}
+
+/* ---- benchmark: a 20 minute vbr file, one pes every 40ms ---- */
+
+#define PES_NUM         (20 * 60 * 25)
+#define PES_PTS         3600
+#define FIRST_PTS       900000
+#define READ_SIZE       (204 * 60)          /* read of each step of SeekToTime */
+#define PROBE_SIZE      (1536 * 1024)       /* read of each block of ProbeByteRate */
+#define PROBE_BLOCKS    10
+
+static long long pes_pos[PES_NUM];
+static long long file_size;
+static int reads;
+
+static void build_file(void)
+{
+    long long pos = 0;
+    int i, rate = 0;
+
+    for (i = 0; i < PES_NUM; i++)
+    {
+        /* 1 to 12 Mbps, changing every 5s, and bigger key frames */
+        if (i % 125 == 0)
+        {
+            rate = (1 + rnd(12)) * 1000000 / 8;
+        }
+        pes_pos[i] = pos;
+        pos += rate / 25 * (i % 25 == 0 ? 4 : 1);
+        pos -= pos % 188;
+    }
+    file_size = pos;
+}
+
+/* like FindNextPTS on a read at pos: the first pes starting after pos.
+ * Audio pes are interleaved every few K, so any read meets one; their pts
+ * are those of the video around them and are not modelled. */
+static long long probe(long long pos, long long *pts_pos)
+{
+    int lo = 0, hi = PES_NUM;
+
+    reads++;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (pes_pos[mid] < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == PES_NUM)
+    {
+        return -1;
+    }
+    *pts_pos = pes_pos[lo];
+    return FIRST_PTS + (long long)lo * PES_PTS;
+}
+
+/* ProbeByteRate: the pts of 10 blocks across the file */
+static long long probe_byte_rate(TsSeekIndex *index)
+{
+    long long block = file_size / PROBE_BLOCKS, pts, pos, first = -1, last = 0;
+    int i, last_i = 0;
+
+    for (i = 0; i < PROBE_BLOCKS; i++)
+    {
+        pts = probe(i * block, &pos);
+        if (pts < 0)
+            continue;
+        if (first < 0)
+            first = pts;
+        last = pts;
+        last_i = i;
+        if (index)
+            TsSeekIndexAdd(index, pts, i * block);
+    }
+    return block * last_i * 90000 / (last - first);
+}
+
+/* the loop of SeekToTime in forward mode; without index, the former one
+ * which stepped by whole seconds of byte rate */
+static int seek(TsSeekIndex *index, long long byte_rate, long long dst_pts)
+{
+    long long file_pos = -1, next_pos, read_pos, lo_pos = -1, hi_pos = -1;
+    long long pts, pts_pos, pts_diff;
+    int cnt = 0;
+
+    reads = 0;
+    if (index)
+        file_pos = TsSeekIndexEstimatePos(index, dst_pts, byte_rate);
+    if (file_pos < 0)
+        file_pos = byte_rate * (dst_pts - FIRST_PTS) / 90000;
+    file_pos -= file_pos % 188;
+    do
+    {
+        pts = probe(file_pos, &pts_pos);
+        if (pts < 0)
+            break;
+        read_pos = file_pos;
+        file_pos = pts_pos;
+        pts_diff = pts < dst_pts ? dst_pts - pts : pts - dst_pts;
+        if (!index)
+        {
+            if (pts > dst_pts + 90000)
+                file_pos = file_pos - byte_rate * (pts_diff / 90000);
+            else if (pts < dst_pts)
+                file_pos = file_pos + byte_rate * (pts_diff / 90000);
+            else
+                return reads;
+            if (file_pos < 0)
+                file_pos = 0;
+            if (file_pos > file_size)
+                break;
+            continue;
+        }
+
+        TsSeekIndexAdd(index, pts, file_pos);
+        next_pos = TsSeekIndexEstimatePos(index, dst_pts, byte_rate);
+        if (pts > dst_pts + 90000)
+        {
+            hi_pos = read_pos;
+            if (next_pos < 0 || next_pos >= read_pos)
+                next_pos = read_pos - byte_rate * (pts_diff + 90000) / 90000;
+        }
+        else if (pts < dst_pts)
+        {
+            lo_pos = file_pos;
+            if (next_pos < 0 || next_pos <= file_pos)
+                next_pos = file_pos + byte_rate * pts_diff / 90000;
+        }
+        else
+            return reads;
+        if (lo_pos >= 0 && hi_pos >= 0 && (next_pos <= lo_pos || next_pos >= hi_pos))
+            next_pos = lo_pos + (hi_pos - lo_pos) / 2;
+        if (next_pos > file_size)
+            break;
+        file_pos = next_pos > 0 ? next_pos : 0;
+    } while (++cnt < 10);
+    return -reads;      /* missed */
+}
+
+struct seek_stats
+{
+    int seeks, missed, total_reads, max_reads;
+};
+
+static void run_seeks(TsSeekIndex *index, long long byte_rate, int n, struct seek_stats *s)
+{
+    int i, r;
+
+    memset(s, 0, sizeof(*s));
+    for (i = 0; i < n; i++)
+    {
+        long long dst = FIRST_PTS + (long long)rnd(PES_NUM - 100) * PES_PTS;
+        r = seek(index, byte_rate, dst);
+        s->seeks++;
+        if (r < 0)
+        {
+            s->missed++;
+            r = -r;
+        }
+        s->total_reads += r;
+        if (r > s->max_reads)
+            s->max_reads = r;
+    }
+}
+
+/* SD card: 1ms per random access, 20MB/s */
+static double sd_ms(int accesses, long long bytes)
+{
+    return accesses * 1.0 + bytes / 20000.0;
+}
+
+static void bench(void)
+{
+    const char *path = "/tmp/ts_seek_index_bench" TS_SEEK_INDEX_SUFFIX;
+    TsSeekIndex index, warm;
+    TsSeekIndexInfo info;
+    struct seek_stats s;
+    long long byte_rate, dst;
+    int r, sidecar_bytes;
+    FILE *fp;
+
+    build_file();
+    byte_rate = probe_byte_rate(NULL);
+    printf("vbr file: %lld MB, %d s, probed byte rate %lld\n",
+        file_size >> 20, PES_NUM / 25, byte_rate);
+
+    run_seeks(NULL, byte_rate, 1000, &s);
+    printf("no index:         %.2f reads/seek, max %d, %d of %d seeks missed\n",
+        (double)s.total_reads / s.seeks, s.max_reads, s.missed, s.seeks);
+
+    TsSeekIndexInit(&index);
+    probe_byte_rate(&index);
+    run_seeks(&index, byte_rate, 1000, &s);
+    printf("index from probe: %.2f reads/seek, max %d, %d of %d seeks missed, %d entries after\n",
+        (double)s.total_reads / s.seeks, s.max_reads, s.missed, s.seeks, index.num);
+    run_seeks(&index, byte_rate, 1000, &s);
+    printf("warm index:       %.2f reads/seek, max %d, %d of %d seeks missed\n",
+        (double)s.total_reads / s.seeks, s.max_reads, s.missed, s.seeks);
+    CHECK(s.missed == 0, "warm index missed %d seeks", s.missed);
+
+    /* open and resume in the middle: probe + seek, or sidecar + seek */
+    memset(&info, 0, sizeof(info));
+    info.fileSize = file_size;
+    info.byteRate = byte_rate;
+    TsSeekIndexSave(&index, &info, path);
+    fp = fopen(path, "rb");
+    fseek(fp, 0, SEEK_END);
+    sidecar_bytes = ftell(fp);
+    fclose(fp);
+    TsSeekIndexInit(&warm);
+    TsSeekIndexLoad(&warm, &info, path);
+    unlink(path);
+
+    dst = FIRST_PTS + (long long)(PES_NUM / 2 + 37) * PES_PTS;
+    r = abs(seek(NULL, byte_rate, dst));
+    printf("open + resume, former:  %2d probe reads + %2d seek reads, %6.1f ms on SD\n",
+        PROBE_BLOCKS + 1, r, sd_ms(PROBE_BLOCKS + 1 + r, (PROBE_BLOCKS + 1LL) * PROBE_SIZE + (long long)r * READ_SIZE));
+    TsSeekIndexClear(&index);
+    probe_byte_rate(&index);
+    r = abs(seek(&index, byte_rate, dst));
+    printf("open + resume, first:   %2d probe reads + %2d seek reads, %6.1f ms on SD\n",
+        PROBE_BLOCKS + 1, r, sd_ms(PROBE_BLOCKS + 1 + r, (PROBE_BLOCKS + 1LL) * PROBE_SIZE + (long long)r * READ_SIZE));
+    r = abs(seek(&warm, byte_rate, dst));
+    printf("open + resume, sidecar: %2d sidecar read + %2d seek reads, %6.1f ms on SD (%dK sidecar)\n",
+        1, r, sd_ms(1 + r, sidecar_bytes + (long long)r * READ_SIZE), sidecar_bytes >> 10);
+
+    TsSeekIndexDestroy(&index);
+    TsSeekIndexDestroy(&warm);
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    test_add();
+    test_estimate();
+    test_path();
+    test_sidecar();
+    if (!quiet)
+    {
+        bench();
+    }
+
+    printf("ts_seek_index_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,9 @@
+/* host stub: ktime_get() in CLOCK_MONOTONIC nanoseconds, see rthost.c */
+#ifndef KTIMER_H
+#define KTIMER_H
+
+#include <stdint.h>
+
+int64_t ktime_get(void);
+
+#endif
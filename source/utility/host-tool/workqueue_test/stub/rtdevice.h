@@ -0,0 +1 @@
+/* host stub: nothing of rtdevice.h is used by core/rt-thread/workqueue.c */
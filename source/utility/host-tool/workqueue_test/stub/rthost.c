@@ -0,0 +1,334 @@
+/*
+ * host stand-ins for the rt-thread calls of core/rt-thread/workqueue.c:
+ * threads are pthreads, ticks are milliseconds, interrupts off is one
+ * recursive mutex and soft timers run in one timer thread, restarted or
+ * deactivated after their handler as rt_soft_timer_check() does. Threads
+ * really run in parallel here, which is harder on the locking than the
+ * one core.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <rtthread.h>
+#include <rthw.h>
+
+static pthread_mutex_t host_irq_lock;
+static pthread_once_t host_once = PTHREAD_ONCE_INIT;
+static __thread rt_thread_t host_self;
+
+static pthread_mutex_t host_timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t host_timer_cond = PTHREAD_COND_INITIALIZER;
+static struct rt_timer *host_timers;
+static pthread_t host_timer_tid;
+
+/* timer callbacks run, for the tests */
+volatile unsigned int host_timer_fires;
+
+static void *host_timer_main(void *arg);
+
+static void host_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&host_irq_lock, &attr);
+    pthread_create(&host_timer_tid, NULL, host_timer_main, NULL);
+    pthread_detach(host_timer_tid);
+}
+
+rt_base_t rt_hw_interrupt_disable(void)
+{
+    pthread_once(&host_once, host_init);
+    pthread_mutex_lock(&host_irq_lock);
+    return 0;
+}
+
+void rt_hw_interrupt_enable(rt_base_t level)
+{
+    pthread_mutex_unlock(&host_irq_lock);
+}
+
+/* only stops preemption on the target; nothing to do with real parallelism */
+void rt_enter_critical(void)
+{
+}
+
+void rt_exit_critical(void)
+{
+}
+
+rt_uint8_t rt_interrupt_get_nest(void)
+{
+    return 0;
+}
+
+int64_t ktime_get(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+rt_tick_t rt_tick_get(void)
+{
+    return (rt_tick_t)(ktime_get() / 1000000);
+}
+
+static void *host_thread_main(void *arg)
+{
+    rt_thread_t thread = arg;
+
+    host_self = thread;
+    thread->entry(thread->parameter);
+    return NULL;
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick)
+{
+    rt_thread_t thread = calloc(1, sizeof(*thread));
+
+    if (thread)
+    {
+        strncpy(thread->name, name, RT_NAME_MAX - 1);
+        thread->entry = entry;
+        thread->parameter = parameter;
+    }
+    return thread;
+}
+
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    pthread_once(&host_once, host_init);
+    thread->started = 1;
+    pthread_create(&thread->tid, NULL, host_thread_main, thread);
+    return RT_EOK;
+}
+
+rt_err_t rt_thread_delete(rt_thread_t thread)
+{
+    /* it leaves at its next rt_sem_take(), the semaphores are detached first */
+    if (thread->started)
+    {
+        thread->deleted = 1;
+        pthread_join(thread->tid, NULL);
+    }
+    free(thread);
+    return RT_EOK;
+}
+
+rt_thread_t rt_thread_self(void)
+{
+    return host_self;
+}
+
+rt_err_t rt_sem_init(struct rt_semaphore *sem, const char *name, rt_uint32_t value, rt_uint8_t flag)
+{
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->value = value;
+    sem->detached = 0;
+    return RT_EOK;
+}
+
+/* wakes the waiters with an error like rt_sem_detach(), the memory stays */
+rt_err_t rt_sem_detach(struct rt_semaphore *sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    sem->detached = 1;
+    pthread_cond_broadcast(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    return RT_EOK;
+}
+
+rt_err_t rt_sem_take(struct rt_semaphore *sem, rt_int32_t time)
+{
+    struct timespec ts;
+    rt_err_t ret = RT_EOK;
+
+    if (host_self && host_self->deleted)
+    {
+        pthread_exit(NULL);
+    }
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += time / 1000;
+    ts.tv_nsec += (time % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->value == 0 && !sem->detached && ret == RT_EOK)
+    {
+        if (time == RT_WAITING_FOREVER)
+        {
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        }
+        else if (time == 0 || pthread_cond_timedwait(&sem->cond, &sem->lock, &ts) == ETIMEDOUT)
+        {
+            ret = -RT_ETIMEOUT;
+        }
+    }
+    if (sem->detached)
+    {
+        ret = -RT_ERROR;
+    }
+    else if (ret == RT_EOK)
+    {
+        sem->value--;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+rt_err_t rt_sem_release(struct rt_semaphore *sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    sem->value++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    return RT_EOK;
+}
+
+/* unlink timer, leaving its active flag alone as _rt_timer_remove() does */
+static void host_timer_unlink(rt_timer_t timer)
+{
+    struct rt_timer **p;
+
+    for (p = &host_timers; *p; p = &(*p)->next)
+    {
+        if (*p == timer)
+        {
+            *p = timer->next;
+            break;
+        }
+    }
+}
+
+static void host_timer_remove(rt_timer_t timer)
+{
+    host_timer_unlink(timer);
+    timer->active = 0;
+}
+
+/* timer is in the timer list, for the tests */
+int host_timer_queued(rt_timer_t timer)
+{
+    struct rt_timer *t;
+    int queued = 0;
+
+    pthread_mutex_lock(&host_timer_lock);
+    for (t = host_timers; t; t = t->next)
+    {
+        queued |= t == timer;
+    }
+    pthread_mutex_unlock(&host_timer_lock);
+    return queued;
+}
+
+void rt_timer_init(rt_timer_t timer, const char *name, void (*timeout)(void *parameter),
+                   void *parameter, rt_tick_t time, rt_uint8_t flag)
+{
+    memset(timer, 0, sizeof(*timer));
+    timer->timeout_func = timeout;
+    timer->parameter = parameter;
+    timer->init_tick = time;
+    timer->flag = flag;
+}
+
+rt_err_t rt_timer_detach(rt_timer_t timer)
+{
+    pthread_mutex_lock(&host_timer_lock);
+    host_timer_remove(timer);
+    pthread_mutex_unlock(&host_timer_lock);
+    return RT_EOK;
+}
+
+rt_err_t rt_timer_start(rt_timer_t timer)
+{
+    pthread_mutex_lock(&host_timer_lock);
+    host_timer_remove(timer);
+    timer->timeout_tick = rt_tick_get() + timer->init_tick;
+    timer->active = 1;
+    timer->next = host_timers;
+    host_timers = timer;
+    pthread_cond_signal(&host_timer_cond);
+    pthread_mutex_unlock(&host_timer_lock);
+    return RT_EOK;
+}
+
+rt_err_t rt_timer_stop(rt_timer_t timer)
+{
+    if (!timer->active)
+    {
+        return -RT_ERROR;
+    }
+    pthread_mutex_lock(&host_timer_lock);
+    host_timer_remove(timer);
+    pthread_mutex_unlock(&host_timer_lock);
+    return RT_EOK;
+}
+
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg)
+{
+    if (cmd == RT_TIMER_CTRL_SET_TIME)
+    {
+        timer->init_tick = *(rt_tick_t *)arg;
+    }
+    return RT_EOK;
+}
+
+/* the soft timer thread, woken every millisecond or by a new timer */
+static void *host_timer_main(void *arg)
+{
+    struct rt_timer *t, *due;
+    struct timespec ts;
+
+    pthread_mutex_lock(&host_timer_lock);
+    while (1)
+    {
+        due = NULL;
+        for (t = host_timers; t; t = t->next)
+        {
+            if ((rt_int32_t)(rt_tick_get() - t->timeout_tick) >= 0)
+            {
+                due = t;
+                break;
+            }
+        }
+        if (due)
+        {
+            host_timer_unlink(due);
+            pthread_mutex_unlock(&host_timer_lock);
+            host_timer_fires++;
+            due->timeout_func(due->parameter);
+            if ((due->flag & RT_TIMER_FLAG_PERIODIC) && due->active)
+            {
+                rt_timer_start(due);
+            }
+            else
+            {
+                due->active = 0;
+            }
+            pthread_mutex_lock(&host_timer_lock);
+            continue;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 1000000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&host_timer_cond, &host_timer_lock, &ts);
+    }
+    return NULL;
+}
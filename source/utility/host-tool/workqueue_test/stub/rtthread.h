@@ -0,0 +1,124 @@
+/* host stub: what core/rt-thread/workqueue.c needs from rtthread.h, see rthost.c */
+#ifndef __RT_THREAD_H__
+#define __RT_THREAD_H__
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned char       rt_uint8_t;
+typedef unsigned short      rt_uint16_t;
+typedef unsigned int        rt_uint32_t;
+typedef unsigned long long  rt_uint64_t;
+typedef int                 rt_int32_t;
+typedef long long           rt_int64_t;
+typedef long                rt_base_t;
+typedef unsigned long       rt_ubase_t;
+typedef unsigned long       rt_size_t;
+typedef unsigned int        rt_tick_t;
+typedef long                rt_err_t;
+
+#define rt_inline               static inline
+
+#define RT_NULL                 ((void *)0)
+#define RT_EOK                  0
+#define RT_ERROR                1
+#define RT_ETIMEOUT             2
+#define RT_EBUSY                7
+#define RT_EINVAL               10
+#define RT_NAME_MAX             32
+#define RT_TICK_MAX             0xffffffffu
+#define RT_WAITING_FOREVER      -1
+#define RT_IPC_FLAG_FIFO        0x00
+#define RT_TIMER_FLAG_ONE_SHOT  0x0
+#define RT_TIMER_FLAG_PERIODIC  0x2
+#define RT_TIMER_FLAG_SOFT_TIMER 0x4
+#define RT_TIMER_CTRL_SET_TIME  0x0
+
+#define RT_USING_HEAP
+#define RT_USING_SYSTEM_WORKQUEUE
+#define RT_SYSTEM_WORKQUEUE_PRIORITY    23
+#define RT_SYSTEM_WORKQUEUE_STACKSIZE   2048
+
+struct rt_list_node
+{
+    struct rt_list_node *next;
+    struct rt_list_node *prev;
+};
+typedef struct rt_list_node rt_list_t;
+
+struct rt_slist_node
+{
+    struct rt_slist_node *next;
+};
+typedef struct rt_slist_node rt_slist_t;
+
+#include <rtservice.h>
+
+struct rt_thread
+{
+    char name[RT_NAME_MAX];
+    pthread_t tid;
+    int started;
+    volatile int deleted;
+    void (*entry)(void *parameter);
+    void *parameter;
+};
+typedef struct rt_thread *rt_thread_t;
+
+struct rt_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned int value;
+    int detached;
+};
+
+struct rt_timer
+{
+    void (*timeout_func)(void *parameter);
+    void *parameter;
+    rt_tick_t init_tick;
+    rt_tick_t timeout_tick;
+    rt_uint8_t flag;
+    int active;
+    struct rt_timer *next;
+};
+typedef struct rt_timer *rt_timer_t;
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_startup(rt_thread_t thread);
+rt_err_t rt_thread_delete(rt_thread_t thread);
+rt_thread_t rt_thread_self(void);
+rt_uint8_t rt_interrupt_get_nest(void);
+void rt_enter_critical(void);
+void rt_exit_critical(void);
+rt_tick_t rt_tick_get(void);
+
+rt_err_t rt_sem_init(struct rt_semaphore *sem, const char *name, rt_uint32_t value, rt_uint8_t flag);
+rt_err_t rt_sem_detach(struct rt_semaphore *sem);
+rt_err_t rt_sem_take(struct rt_semaphore *sem, rt_int32_t time);
+rt_err_t rt_sem_release(struct rt_semaphore *sem);
+
+void rt_timer_init(rt_timer_t timer, const char *name, void (*timeout)(void *parameter),
+                   void *parameter, rt_tick_t time, rt_uint8_t flag);
+rt_err_t rt_timer_detach(rt_timer_t timer);
+rt_err_t rt_timer_start(rt_timer_t timer);
+rt_err_t rt_timer_stop(rt_timer_t timer);
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg);
+
+#define RT_KERNEL_MALLOC        malloc
+#define RT_KERNEL_FREE          free
+#define RT_ASSERT               assert
+#define rt_memset               memset
+#define rt_memcpy               memcpy
+#define rt_strncpy              strncpy
+#define rt_snprintf             snprintf
+#define rt_kprintf              printf
+
+#define INIT_DEVICE_EXPORT(fn)
+
+#endif
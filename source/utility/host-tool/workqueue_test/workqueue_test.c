@@ -0,0 +1,463 @@
+/*
+ * Host test and benchmark for the workqueues of ekernel/core/rt-thread/
+ * workqueue.c, with pthreads for the rt-thread calls (stub/rthost.c).
+ *
+ *   workqueue_test           run the checks and the latency benchmark
+ *   workqueue_test -q        checks only
+ *
+ * Checks submission order on one thread, that short works get past a slow
+ * one in a pool and that idle workers steal, that one work never runs
+ * twice at once, that delayed works run on time from a single timer that
+ * stays active between them and stops after the last, that they can be
+ * cancelled and moved, cancel_work_sync() and the per-function
+ * times.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rtthread.h>
+#include <workqueue.h>
+#include <ktimer.h>
+
+#define SLOW_MS         60
+#define SHORT_WORKS     20
+#define DELAYED_WORKS   200
+
+extern volatile unsigned int host_timer_fires;
+int host_timer_queued(rt_timer_t timer);
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+struct item
+{
+    struct rt_work work;
+    int id;
+    int sleep_ms;
+    volatile int runs;
+    volatile rt_tick_t due;
+    volatile rt_tick_t ran;
+    volatile int64_t done_ns;
+};
+
+static int order[4096];
+static volatile int order_len;
+static pthread_mutex_t order_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void item_func(struct rt_work *work, void *work_data)
+{
+    struct item *item = work_data;
+
+    if (item->sleep_ms)
+    {
+        usleep(item->sleep_ms * 1000);
+    }
+    item->ran = rt_tick_get();
+    pthread_mutex_lock(&order_lock);
+    order[order_len++] = item->id;
+    pthread_mutex_unlock(&order_lock);
+    item->done_ns = ktime_get();
+    __atomic_add_fetch(&item->runs, 1, __ATOMIC_SEQ_CST);
+}
+
+static void slow_func(struct rt_work *work, void *work_data)
+{
+    item_func(work, work_data);
+}
+
+static void items_init(struct item *items, int n, void (*func)(struct rt_work *, void *))
+{
+    int i;
+
+    memset(items, 0, n * sizeof(*items));
+    for (i = 0; i < n; i++)
+    {
+        items[i].id = i;
+        rt_work_init(&items[i].work, func, &items[i]);
+    }
+    order_len = 0;
+}
+
+static int wait_runs(struct item *items, int n, int ms)
+{
+    int i, done;
+
+    while (ms-- > 0)
+    {
+        for (i = 0, done = 0; i < n; i++)
+        {
+            done += items[i].runs > 0;
+        }
+        if (done == n)
+        {
+            return 1;
+        }
+        usleep(1000);
+    }
+    return 0;
+}
+
+static void check_fifo(void)
+{
+    static struct item items[1000];
+    struct rt_workqueue *queue = rt_workqueue_create("wq_fifo", 2048, 20);
+    int i;
+
+    items_init(items, 1000, item_func);
+    for (i = 0; i < 1000; i++)
+    {
+        CHECK(rt_workqueue_dowork(queue, &items[i].work) == RT_EOK, "dowork %d", i);
+    }
+    CHECK(rt_workqueue_dowork(queue, &items[999].work) == -RT_EBUSY || items[999].runs,
+          "pending work queued twice");
+    CHECK(wait_runs(items, 1000, 2000), "fifo: works missing");
+    for (i = 0; i < 1000; i++)
+    {
+        CHECK(items[i].runs == 1, "fifo: work %d ran %d times", i, items[i].runs);
+        CHECK(order[i] == i, "fifo: %d at %d", order[i], i);
+        if (order[i] != i)
+        {
+            break;
+        }
+    }
+    rt_workqueue_destroy(queue);
+}
+
+/* one slow work, then short ones: how long until the last short one ran */
+static double short_behind_slow(int threads, int *steals)
+{
+    static struct item slow, shorts[SHORT_WORKS];
+    struct rt_workqueue *queue = rt_workqueue_create_pool("wq_pool", 2048, 20, threads);
+    int64_t t0, last = 0;
+    int i;
+
+    items_init(shorts, SHORT_WORKS, item_func);
+    items_init(&slow, 1, slow_func);
+    slow.id = 1000;
+    slow.sleep_ms = SLOW_MS;
+
+    t0 = ktime_get();
+    rt_workqueue_dowork(queue, &slow.work);
+    usleep(2000);
+    for (i = 0; i < SHORT_WORKS; i++)
+    {
+        rt_workqueue_dowork(queue, &shorts[i].work);
+    }
+    CHECK(wait_runs(shorts, SHORT_WORKS, 1000) && wait_runs(&slow, 1, 1000), "pool: works missing");
+    for (i = 0; i < SHORT_WORKS; i++)
+    {
+        CHECK(shorts[i].runs == 1, "pool: work %d ran %d times", i, shorts[i].runs);
+        if (shorts[i].done_ns > last)
+        {
+            last = shorts[i].done_ns;
+        }
+    }
+
+    *steals = 0;
+    for (i = 0; i < threads; i++)
+    {
+        *steals += queue->worker[i].steal_count;
+    }
+    rt_workqueue_destroy(queue);
+    return (last - t0) / 1e6;
+}
+
+static void check_pool(void)
+{
+    int steals;
+    double ms;
+
+    ms = short_behind_slow(1, &steals);
+    CHECK(ms >= SLOW_MS, "one thread: short works done after %.1f ms", ms);
+    ms = short_behind_slow(3, &steals);
+    CHECK(ms < SLOW_MS / 2, "pool: short works done only after %.1f ms", ms);
+}
+
+/* two slow works keep both workers busy, the shorts queue on both lists */
+static void check_steal(void)
+{
+    static struct item slow[2], shorts[SHORT_WORKS];
+    struct rt_workqueue *queue = rt_workqueue_create_pool("wq_steal", 2048, 20, 2);
+    int i, steals;
+
+    items_init(shorts, SHORT_WORKS, item_func);
+    items_init(slow, 2, slow_func);
+    slow[0].sleep_ms = 10;
+    slow[1].sleep_ms = SLOW_MS;
+
+    rt_workqueue_dowork(queue, &slow[0].work);
+    rt_workqueue_dowork(queue, &slow[1].work);
+    usleep(2000);
+    for (i = 0; i < SHORT_WORKS; i++)
+    {
+        rt_workqueue_dowork(queue, &shorts[i].work);
+    }
+    CHECK(wait_runs(shorts, SHORT_WORKS, 1000), "steal: works missing");
+    CHECK(slow[1].runs == 0, "steal: shorts waited for the slow work");
+    CHECK(wait_runs(slow, 2, 1000), "steal: slow works missing");
+
+    steals = queue->worker[0].steal_count + queue->worker[1].steal_count;
+    CHECK(steals > 0, "steal: nothing stolen");
+    rt_workqueue_destroy(queue);
+}
+
+static volatile int in_flight, max_in_flight, exclusive_runs;
+
+static void exclusive_func(struct rt_work *work, void *work_data)
+{
+    int n = __atomic_add_fetch(&in_flight, 1, __ATOMIC_SEQ_CST);
+
+    if (n > max_in_flight)
+    {
+        max_in_flight = n;
+    }
+    usleep(100);
+    exclusive_runs++;
+    __atomic_sub_fetch(&in_flight, 1, __ATOMIC_SEQ_CST);
+}
+
+static void check_exclusive(void)
+{
+    struct rt_workqueue *queue = rt_workqueue_create_pool("wq_excl", 2048, 20, 4);
+    struct rt_work work;
+    int i, queued = 0;
+
+    rt_work_init(&work, exclusive_func, RT_NULL);
+    for (i = 0; i < 20000; i++)
+    {
+        queued += rt_workqueue_dowork(queue, &work) == RT_EOK;
+        if ((i & 63) == 0)
+        {
+            usleep(50);
+        }
+    }
+    for (i = 0; i < 1000 && exclusive_runs < queued; i++)
+    {
+        usleep(1000);
+    }
+    rt_workqueue_cancel_work_sync(queue, &work);
+    CHECK(max_in_flight == 1, "one work ran %d times at once", max_in_flight);
+    CHECK(exclusive_runs == queued, "%d runs for %d submits", exclusive_runs, queued);
+    rt_workqueue_destroy(queue);
+}
+
+static void check_delayed(int threads)
+{
+    static struct item items[DELAYED_WORKS];
+    struct rt_workqueue *queue = rt_workqueue_create_pool("wq_delay", 2048, 20, threads);
+    unsigned int fires0 = host_timer_fires, fires;
+    int i, late, latest = 0, distinct = 0, seen[64] = { 0 };
+
+    items_init(items, DELAYED_WORKS, item_func);
+    srand(threads);
+    for (i = 0; i < DELAYED_WORKS; i++)
+    {
+        int ms = 5 + rand() % 40;
+
+        items[i].due = rt_tick_get() + ms;
+        CHECK(rt_workqueue_submit_work(queue, &items[i].work, ms) == RT_EOK, "delayed %d", i);
+        distinct += !seen[ms]++;
+    }
+    CHECK(queue->worker[0].run_count == 0, "delayed works ran at once");
+    CHECK(wait_runs(items, DELAYED_WORKS, 2000), "delayed works missing");
+    fires = host_timer_fires - fires0;
+
+    for (i = 0; i < DELAYED_WORKS; i++)
+    {
+        late = (rt_int32_t)(items[i].ran - items[i].due);
+        CHECK(items[i].runs == 1, "delayed %d ran %d times", i, items[i].runs);
+        CHECK(late >= 0, "delayed %d ran %d ms early", i, -late);
+        if (late > latest)
+        {
+            latest = late;
+        }
+    }
+    CHECK(latest < 20, "a delayed work ran %d ms late", latest);
+    /* one timer for the queue: at most one expiry per distinct due tick */
+    CHECK(fires <= (unsigned int)distinct + 1, "%u timer expiries for %d due ticks", fires, distinct);
+
+    if (threads == 1)
+    {
+        for (i = 1; i < DELAYED_WORKS; i++)
+        {
+            CHECK((rt_int32_t)(items[order[i]].due - items[order[i - 1]].due) >= -1,
+                  "delayed works out of order at %d", i);
+        }
+    }
+
+    /* the timer stopped with the last work, out of the list and inactive */
+    usleep(5000);
+    CHECK(!queue->timer.active && !host_timer_queued(&queue->timer),
+          "timer left active %d queued %d", queue->timer.active, host_timer_queued(&queue->timer));
+    rt_workqueue_destroy(queue);
+}
+
+/* the timer stays active while it waits for the next delayed work */
+static void check_timer_rearm(void)
+{
+    static struct item items[2];
+    struct rt_workqueue *queue = rt_workqueue_create("wq_rearm", 2048, 20);
+
+    items_init(items, 2, item_func);
+    CHECK(rt_workqueue_submit_work(queue, &items[0].work, 5) == RT_EOK, "rearm first");
+    CHECK(rt_workqueue_submit_work(queue, &items[1].work, 500) == RT_EOK, "rearm second");
+    CHECK(wait_runs(items, 1, 1000), "first delayed work missing");
+    usleep(5000);
+    CHECK(queue->timer.active && host_timer_queued(&queue->timer),
+          "timer for the second work active %d queued %d", queue->timer.active,
+          host_timer_queued(&queue->timer));
+    CHECK(rt_workqueue_cancel_work(queue, &items[1].work) == RT_EOK, "rearm cancel");
+    rt_workqueue_destroy(queue);
+}
+
+static void check_cancel(void)
+{
+    static struct item items[50], slow;
+    struct rt_workqueue *queue = rt_workqueue_create_pool("wq_cancel", 2048, 20, 2);
+    int i, ran = 0;
+    int64_t t0;
+
+    items_init(items, 50, item_func);
+    for (i = 0; i < 50; i++)
+    {
+        rt_workqueue_submit_work(queue, &items[i].work, 20);
+    }
+    for (i = 0; i < 50; i += 2)
+    {
+        CHECK(rt_workqueue_cancel_work(queue, &items[i].work) == RT_EOK, "cancel %d", i);
+    }
+    /* moving a delayed work: it runs once, at the new time */
+    items[1].due = rt_tick_get() + 40;
+    rt_workqueue_submit_work(queue, &items[1].work, 40);
+    usleep(80 * 1000);
+    for (i = 0; i < 50; i++)
+    {
+        ran += items[i].runs;
+        CHECK(items[i].runs == (i & 1), "cancel: work %d ran %d times", i, items[i].runs);
+    }
+    CHECK(ran == 25, "cancel: %d ran", ran);
+    CHECK((rt_int32_t)(items[1].ran - items[1].due) >= 0, "moved work ran at the old time");
+
+    /* cancel_work_sync() returns once the running work is done */
+    items_init(&slow, 1, slow_func);
+    slow.sleep_ms = 30;
+    rt_workqueue_dowork(queue, &slow.work);
+    usleep(5000);
+    t0 = ktime_get();
+    rt_workqueue_cancel_work_sync(queue, &slow.work);
+    CHECK(slow.runs == 1, "cancel_work_sync returned before the work was done");
+    CHECK(ktime_get() - t0 > 15 * 1000000, "cancel_work_sync did not wait");
+
+    /* and a pending one does not run */
+    slow.runs = 0;
+    slow.sleep_ms = 0;
+    rt_workqueue_submit_work(queue, &slow.work, 10);
+    rt_workqueue_cancel_work_sync(queue, &slow.work);
+    usleep(30 * 1000);
+    CHECK(slow.runs == 0, "cancelled delayed work ran");
+    rt_workqueue_destroy(queue);
+}
+
+static void check_stats(void)
+{
+    static struct item slow, shorts[10];
+    struct rt_workqueue *queue = rt_workqueue_create_pool("wq_stat", 2048, 20, 2);
+    struct rt_work_stat *stat;
+    int i, found = 0;
+
+    items_init(shorts, 10, item_func);
+    items_init(&slow, 1, slow_func);
+    slow.sleep_ms = 20;
+    rt_workqueue_dowork(queue, &slow.work);
+    for (i = 0; i < 10; i++)
+    {
+        rt_workqueue_dowork(queue, &shorts[i].work);
+    }
+    CHECK(wait_runs(shorts, 10, 1000) && wait_runs(&slow, 1, 1000), "stats: works missing");
+    usleep(5000);
+
+    for (i = 0; i < RT_WORKQUEUE_STAT_FUNCS; i++)
+    {
+        stat = &queue->stat[i];
+        if (stat->work_func == slow_func)
+        {
+            found |= 1;
+            CHECK(stat->run_count == 1, "slow_func run %u times", stat->run_count);
+            CHECK(stat->max_ns >= 20 * 1000000 && stat->max_ns < 200 * 1000000,
+                  "slow_func max %u ns", stat->max_ns);
+        }
+        else if (stat->work_func == item_func)
+        {
+            found |= 2;
+            CHECK(stat->run_count == 10, "item_func run %u times", stat->run_count);
+            CHECK(stat->max_ns < 10 * 1000000, "item_func max %u ns", stat->max_ns);
+        }
+    }
+    CHECK(found == 3, "work functions not accounted");
+    CHECK(queue->worker[0].run_count + queue->worker[1].run_count == 11, "worker run counts");
+    rt_workqueue_destroy(queue);
+}
+
+static void check_system(void)
+{
+    struct item items[8];
+    int i;
+
+    rt_work_sys_workqueue_init();
+    items_init(items, 8, item_func);
+    for (i = 0; i < 8; i++)
+    {
+        CHECK(rt_work_submit(&items[i].work, i & 1 ? 5 : 0) == RT_EOK, "rt_work_submit %d", i);
+    }
+    CHECK(rt_work_cancel(&items[7].work) == RT_EOK, "rt_work_cancel");
+    CHECK(wait_runs(items, 7, 1000), "system workqueue: works missing");
+    usleep(20 * 1000);
+    CHECK(items[7].runs == 0, "system workqueue: cancelled work ran");
+}
+
+static void bench(void)
+{
+    int threads, steals;
+    double ms;
+
+    for (threads = 1; threads <= 4; threads *= 2)
+    {
+        ms = short_behind_slow(threads, &steals);
+        printf("%d thread%s: %d short works behind a %d ms one done after %.1f ms, %d stolen\n",
+               threads, threads > 1 ? "s" : " ", SHORT_WORKS, SLOW_MS, ms, steals);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int quiet = argc > 1 && !strcmp(argv[1], "-q");
+
+    check_fifo();
+    check_pool();
+    check_steal();
+    check_exclusive();
+    check_delayed(1);
+    check_delayed(3);
+    check_timer_rearm();
+    check_cancel();
+    check_stats();
+    check_system();
+    if (!quiet)
+    {
+        bench();
+    }
+
+    printf("workqueue: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}